@@ -248,6 +248,30 @@ uGeofencePositionState_t uCellGeofencePosition(uDeviceHandle_t cellHandle,
                                                int32_t radiusMillimetres,
                                                int32_t altitudeUncertaintyMillimetres);
 
+/** Get the number of times that a position has been tested against
+ * the shapes of a geofence applied to the given cellular instance and
+ * the number of times that this was avoided because the position
+ * could not have been near the geofence, either because of the
+ * spatial index (see #U_GEOFENCE_INDEX_THRESHOLD_NUM_FENCES) or
+ * because the geofence could not have been reached at the maximum
+ * horizontal speed since it was last tested.  The counts start
+ * from zero when the first geofence is applied.
+ *
+ * @param cellHandle       the handle of the cellular instance.
+ * @param[out] pNumTested  a place to put the number of times a
+ *                         geofence has been tested; may be NULL.
+ * @param[out] pNumSkipped a place to put the number of times
+ *                         testing a geofence has been avoided;
+ *                         may be NULL.
+ * @param reset            if true the counts are set back to zero
+ *                         once they have been read.
+ * @return                 zero on success else negative error code.
+ */
+int32_t uCellGeofenceGetCounts(uDeviceHandle_t cellHandle,
+                               uint32_t *pNumTested,
+                               uint32_t *pNumSkipped,
+                               bool reset);
+
 #ifdef __cplusplus
 }
 #endif
@@ -296,4 +296,41 @@ uGeofencePositionState_t uCellGeofencePosition(uDeviceHandle_t cellHandle,
     return positionState;
 }
 
+// Get the number of geofence tests performed and avoided.
+int32_t uCellGeofenceGetCounts(uDeviceHandle_t cellHandle,
+                               uint32_t *pNumTested,
+                               uint32_t *pNumSkipped,
+                               bool reset)
+{
+    int32_t errorCode;
+
+#ifdef U_CFG_GEOFENCE
+    uCellPrivateInstance_t *pInstance;
+
+    errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    if (gUCellPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUCellPrivateMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUCellPrivateGetInstance(cellHandle);
+        if (pInstance != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            uGeofenceContextGetCounts((uGeofenceContext_t *) pInstance->pFenceContext,
+                                      pNumTested, pNumSkipped, reset);
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUCellPrivateMutex);
+    }
+#else
+    errorCode = (int32_t) U_ERROR_COMMON_NOT_COMPILED;
+    (void) cellHandle;
+    (void) pNumTested;
+    (void) pNumSkipped;
+    (void) reset;
+#endif
+
+    return errorCode;
+}
+
 // End of file
@@ -33,7 +33,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
-#include "string.h"    // memcpy()
+#include "string.h"    // memcpy(), memmove(), memchr()
 
 #include "u_compiler.h" // U_INLINE
 
@@ -212,6 +212,79 @@ U_INLINE static bool getByte(uParseHandle_t parseHandle,
     return success;
 }
 
+// Get up to length bytes in as few goes as possible, copying them to
+// pData if it is not NULL and, if pFcs is not NULL, running the FCS
+// over them: if parseHandle is NULL then the pContext buffer will be
+// used as the source and pContext->bufferIndex will be advanced, else
+// the ring-buffer will be used as the source.  pData may overlap the
+// pContext buffer, provided it is behind the data.
+static size_t getBytes(uParseHandle_t parseHandle,
+                       uCellMuxPrivateParserContext_t *pContext,
+                       char *pData, size_t length, uint8_t *pFcs)
+{
+    size_t total = 0;
+    size_t size = 1;
+    const char *pSource;
+
+    while ((total < length) && (size > 0)) {
+        if (parseHandle == NULL) {
+            pSource = pContext->pBuffer + pContext->bufferIndex;
+            size = pContext->bufferSize - pContext->bufferIndex;
+        } else {
+            size = uRingBufferGetSpanUnprotected(parseHandle, &pSource);
+        }
+        if (size > length - total) {
+            size = length - total;
+        }
+        if (pFcs != NULL) {
+            // Before the copy since the copy may overwrite the source
+            for (size_t x = 0; x < size; x++) {
+                *pFcs = gFcsTable[*pFcs ^ (uint8_t) *(pSource + x)];
+            }
+        }
+        if (pData != NULL) {
+            memmove(pData, pSource, size);
+            pData += size;
+        }
+        if (parseHandle == NULL) {
+            pContext->bufferIndex += size;
+        } else {
+            uRingBufferSkipUnprotected(parseHandle, size);
+        }
+        total += size;
+    }
+
+    return total;
+}
+
+// Find the next frame marker, returning the number of bytes before it
+// (which will be the number of bytes available if there is none):
+// if parseHandle is NULL then the pContext buffer will be searched and
+// pContext->bufferIndex will be advanced to the frame marker, else
+// the ring-buffer will be searched, which also tells
+// uRingBufferParseHandle() how far it may skip if there is no frame.
+static size_t findMarker(uParseHandle_t parseHandle,
+                         uCellMuxPrivateParserContext_t *pContext)
+{
+    size_t offset;
+    const char *pFound;
+
+    if (parseHandle == NULL) {
+        offset = pContext->bufferSize - pContext->bufferIndex;
+        pFound = (const char *) memchr(pContext->pBuffer + pContext->bufferIndex,
+                                       U_CELL_MUX_PRIVATE_FRAME_MARKER, offset);
+        if (pFound != NULL) {
+            offset = pFound - (pContext->pBuffer + pContext->bufferIndex);
+        }
+        pContext->bufferIndex += offset;
+    } else {
+        offset = uRingBufferFindByteUnprotected(parseHandle,
+                                                (char) U_CELL_MUX_PRIVATE_FRAME_MARKER);
+    }
+
+    return offset;
+}
+
 // Get the discard size: if parseHandle is non-NULL then the ring
 // buffer function will be called, else this will return 0 because
 // that is always the right answer for the linear buffer case.
@@ -305,7 +378,12 @@ int32_t uCellMuxPrivateParseCmux(uParseHandle_t parseHandle, void *pUserParam)
 {
     uCellMuxPrivateParserContext_t *pContextParser = (uCellMuxPrivateParserContext_t *) pUserParam;
     uint8_t x = 0;
+    size_t y;
 
+    // Get to the start of a frame in one go
+    if (findMarker(parseHandle, pContextParser) > 0) {
+        return U_ERROR_COMMON_NOT_FOUND;
+    }
     if (bytesAvailable(parseHandle, pContextParser) < U_CELL_MUX_PRIVATE_FRAME_MIN_LENGTH_BYTES) {
         return U_ERROR_COMMON_TIMEOUT;
     }
@@ -355,15 +433,19 @@ int32_t uCellMuxPrivateParseCmux(uParseHandle_t parseHandle, void *pUserParam)
     if (bytesAvailable(parseHandle, pContextParser) < (size_t) informationLengthBytes + 2) {
         return U_ERROR_COMMON_TIMEOUT;
     }
-    for (size_t y = 0; y < informationLengthBytes; y++) {
-        getByte(parseHandle, pContextParser, &x);
-        if ((pContextParser->pInformation != NULL) && (y < pContextParser->informationLengthBytes)) {
-            *(pContextParser->pInformation + y) = (char) x;
-        }
-        if (type != U_CELL_MUX_PRIVATE_FRAME_TYPE_UIH) {
-            fcs = gFcsTable[fcs ^ x];
+    // Copy out as much of the information field as there is room for,
+    // and skip the rest, running the FCS over it if this is not UIH
+    y = 0;
+    if (pContextParser->pInformation != NULL) {
+        y = informationLengthBytes;
+        if (y > pContextParser->informationLengthBytes) {
+            y = pContextParser->informationLengthBytes;
         }
+        getBytes(parseHandle, pContextParser, pContextParser->pInformation, y,
+                 type != U_CELL_MUX_PRIVATE_FRAME_TYPE_UIH ? &fcs : NULL);
     }
+    getBytes(parseHandle, pContextParser, NULL, informationLengthBytes - y,
+             type != U_CELL_MUX_PRIVATE_FRAME_TYPE_UIH ? &fcs : NULL);
     getByte(parseHandle, pContextParser, &x);
     // 0xCF is the reversed order of 11110011
     if (gFcsTable[fcs ^ x] != 0xCF) {
@@ -124,6 +124,20 @@
 #define U_ATOMIC_GET(pPtr) __atomic_load_n(pPtr, __ATOMIC_SEQ_CST)
 #endif
 
+/** U_ATOMIC_SET: set the value of a variable atomically and
+ * sequentially consistently, i.e. such that no memory access,
+ * including a later load, may be reordered either side of it.
+ */
+#ifdef _MSC_VER
+/** Microsoft Visual C++ definition; requires inclusion of windows.h.
+ */
+# define U_ATOMIC_SET(pPtr, value) ((void) (*(pPtr) = (value)), MemoryBarrier())
+#else
+/** Default (GCC) definition.
+ */
+#define U_ATOMIC_SET(pPtr, value) __atomic_store_n(pPtr, value, __ATOMIC_SEQ_CST)
+#endif
+
 /** U_ATOMIC_INCREMENT: increment a variable atomically and return
  * its new value.
  */
@@ -150,6 +164,54 @@
 #define U_ATOMIC_DECREMENT(pPtr) __atomic_fetch_sub(pPtr, 1, __ATOMIC_SEQ_CST)
 #endif
 
+/** U_ATOMIC_GET_ACQUIRE: return the value of a variable atomically,
+ * such that no memory access after it may be reordered before it;
+ * pairs with U_ATOMIC_SET_RELEASE.
+ */
+#ifdef _MSC_VER
+/** Microsoft Visual C++ definition; fetches of volatiles have
+ * acquire semantics on x86_64.
+ */
+# define U_ATOMIC_GET_ACQUIRE(pPtr) *pPtr
+#else
+/** Default (GCC) definition.
+ */
+#define U_ATOMIC_GET_ACQUIRE(pPtr) __atomic_load_n(pPtr, __ATOMIC_ACQUIRE)
+#endif
+
+/** U_ATOMIC_SET_RELEASE: set the value of a variable atomically,
+ * such that no memory access before it may be reordered after it;
+ * pairs with U_ATOMIC_GET_ACQUIRE.
+ */
+#ifdef _MSC_VER
+/** Microsoft Visual C++ definition; stores to volatiles have
+ * release semantics on x86_64.
+ */
+# define U_ATOMIC_SET_RELEASE(pPtr, value) (*pPtr = (value))
+#else
+/** Default (GCC) definition.
+ */
+#define U_ATOMIC_SET_RELEASE(pPtr, value) __atomic_store_n(pPtr, value, __ATOMIC_RELEASE)
+#endif
+
+/** U_ATOMIC_COMPARE_EXCHANGE: if the 32-bit variable at pPtr is equal
+ * to *pExpected, set it to desired and return true, else put its
+ * current value in *pExpected and return false.
+ */
+#ifdef _MSC_VER
+/** Microsoft Visual C++ definition; requires inclusion of windows.h.
+ */
+# define U_ATOMIC_COMPARE_EXCHANGE(pPtr, pExpected, desired)                    \
+    ((InterlockedCompareExchange((volatile long *) (pPtr), (long) (desired),     \
+                                 (long) *(pExpected)) == (long) *(pExpected)) || \
+     ((*(pExpected) = *(pPtr)), false))
+#else
+/** Default (GCC) definition.
+ */
+#define U_ATOMIC_COMPARE_EXCHANGE(pPtr, pExpected, desired) \
+    __atomic_compare_exchange_n(pPtr, pExpected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#endif
+
 /** @}*/
 
 #endif // _U_COMPILER_H_
@@ -427,6 +427,50 @@ extern "C" {
 # define U_AT_CLIENT_ACTIVITY_PIN_HYSTERESIS_INTERVAL_MS 10
 #endif
 
+#ifndef U_AT_CLIENT_COMMAND_ASYNC_LINE_MAX_LENGTH_BYTES
+/** The maximum length of command line, not including the
+ * terminator, that the AT client will build when concatenating
+ * commands submitted with uAtClientCommandAsync().  V.250 requires
+ * an AT server to accept a command line of at least 40 characters;
+ * u-blox modules accept considerably more.
+ */
+# define U_AT_CLIENT_COMMAND_ASYNC_LINE_MAX_LENGTH_BYTES 128
+#endif
+
+#ifndef U_AT_CLIENT_STATS_MAX_NUM_COMMANDS
+/** The maximum number of different AT commands for which
+ * statistics are kept when uAtClientStatsStart() has been called;
+ * any further AT commands are lumped together in the last entry,
+ * which is given the name "*".
+ */
+# define U_AT_CLIENT_STATS_MAX_NUM_COMMANDS 32
+#endif
+
+#ifndef U_AT_CLIENT_TRANSMIT_BUFFER_LENGTH_BYTES
+/** The size of the buffer in which an AT client assembles an
+ * outgoing AT command so that the command, its parameters and
+ * its terminator are written to the stream in one go rather than
+ * piecemeal; anything this long or longer (e.g. a large binary
+ * payload) is written to the stream directly, after whatever is
+ * already in the buffer.  Set this to 0 to switch the transmit
+ * buffer off.  The transmit buffer is not used while a transmit
+ * intercept function (see uAtClientStreamInterceptTx()) is in
+ * place since such a function will do its own buffering.
+ */
+# define U_AT_CLIENT_TRANSMIT_BUFFER_LENGTH_BYTES 128
+#endif
+
+/** The number of buckets in the latency histogram of
+ * #uAtClientStatsCommand_t.
+ */
+#define U_AT_CLIENT_STATS_HISTOGRAM_NUM_BUCKETS 16
+
+/** The storage required for the name of an AT command in
+ * #uAtClientStatsCommand_t, including room for a terminator;
+ * longer names are truncated.
+ */
+#define U_AT_CLIENT_STATS_COMMAND_MAX_LENGTH_BYTES 16
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -477,6 +521,113 @@ typedef struct {
     int32_t code;
 } uAtClientDeviceError_t;
 
+/** Statistics for one AT command, see uAtClientStatsCommandGet().
+ * The latency of an AT command is the time from the end of
+ * uAtClientCommandStop() to the end of the final response,
+ * i.e. to uAtClientResponseStop() or, if that is not called,
+ * uAtClientUnlock().
+ */
+typedef struct {
+    char command[U_AT_CLIENT_STATS_COMMAND_MAX_LENGTH_BYTES]; /**< the AT command,
+                                                                   up to but not
+                                                                   including any
+                                                                   '=' or '?', e.g.
+                                                                   "AT+CGDCONT". */
+    uint32_t count;            /**< the number of times the command was sent. */
+    uint32_t numTimeouts;      /**< the number of AT timeouts that occurred while
+                                    waiting for a response to the command. */
+    int32_t latencyMinMs;      /**< the shortest latency. */
+    int32_t latencyMaxMs;      /**< the longest latency. */
+    uint32_t latencyTotalMs;   /**< the sum of all of the latencies. */
+    /** the number of latencies that fell into each bucket of the
+     * histogram: bucket 0 counts latencies of 0 ms, bucket n counts
+     * latencies from 2^(n - 1) ms up to (2^n) - 1 ms, and the last
+     * bucket also counts everything longer.
+     */
+    uint32_t latencyHistogram[U_AT_CLIENT_STATS_HISTOGRAM_NUM_BUCKETS];
+    uint32_t bytesOut;         /**< the number of bytes sent for the command. */
+    uint32_t bytesIn;          /**< the number of bytes received in response
+                                    to the command, including those of any
+                                    URCs that arrived in the meantime. */
+} uAtClientStatsCommand_t;
+
+/** Statistics for the URCs of an AT client, see uAtClientStatsUrcGet().
+ */
+typedef struct {
+    uint32_t count;            /**< the number of URCs received. */
+    uint32_t timeMs;           /**< the total time spent in URC handlers. */
+} uAtClientStatsUrc_t;
+
+/** Transmit statistics for an AT client, see
+ * uAtClientTransmitStatsGet(); these are kept from the time the
+ * AT client is added.
+ */
+typedef struct {
+    uint32_t numWrites;        /**< the number of pieces of data written
+                                    by the AT client, e.g. a command, a
+                                    parameter or a delimiter. */
+    uint32_t numStreamWrites;  /**< the number of write calls actually
+                                    made to the stream (e.g. to
+                                    uPortUartWrite()); numWrites minus
+                                    this is the number of calls saved
+                                    by the transmit buffer. */
+    uint32_t bytes;            /**< the number of bytes written to the
+                                    stream. */
+} uAtClientTransmitStats_t;
+
+/** An AT command to be sent asynchronously with
+ * uAtClientCommandAsync().
+ */
+typedef struct {
+    const char *pCommand;        /**< the complete command, including the
+                                      "AT" but without the terminator, e.g.
+                                      "AT+CSQ"; cannot be NULL. */
+    const char *pResponsePrefix; /**< the prefix of the information response
+                                      to the command, e.g. "+CSQ:", NULL if
+                                      there is no prefix. */
+    /** the function that will read the parameters of a line of
+     * information response to the command, using uAtClientReadInt()
+     * etc.; it is called, on the AT callback task, with the AT client
+     * locked and in the same way as the code that would follow a
+     * successful uAtClientResponseStart() with pResponsePrefix.
+     * Note that it must NOT call uAtClientResponseStop() or
+     * uAtClientUnlock().  If the command has no information
+     * response, or its contents are of no interest, this may be
+     * NULL; if pResponsePrefix is NULL and pResponse is not NULL
+     * it is called for one line of information response, otherwise
+     * it is called for each line that begins with pResponsePrefix.
+     */
+    void (*pResponse) (uAtClientHandle_t, void *);
+    /** the function that will be called, on the AT callback task,
+     * when the command has completed; the second parameter is zero
+     * if the command succeeded, else negative error code, as would
+     * have been returned by uAtClientUnlock(), and the third
+     * parameter is pParam.  May be NULL.
+     */
+    void (*pComplete) (uAtClientHandle_t, int32_t, void *);
+    void *pParam;                /**< the parameter that is passed to
+                                      pResponse (as the second parameter)
+                                      and to pComplete (as the third
+                                      parameter). */
+    bool concatenate;            /**< set this to true to permit the command to
+                                      be sent on the same command line as
+                                      the asynchronous commands submitted
+                                      immediately before and after it, which
+                                      have also set concatenate, as in
+                                      "AT+CSQ;+CREG?;+CGSN": this saves a
+                                      round trip and an inter-command delay
+                                      per command.  Only set this if pCommand
+                                      begins with "AT+", the AT server supports
+                                      V.250 command concatenation and, should
+                                      pResponse or pResponsePrefix be non-NULL,
+                                      the command always returns exactly one
+                                      line of information response (otherwise
+                                      none); if any of the commands on a
+                                      command line fails then pComplete will
+                                      be called with the error for all of
+                                      them. */
+} uAtClientCommandAsync_t;
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: INITIALISATION AND CONFIGURATION
  * -------------------------------------------------------------- */
@@ -724,6 +875,35 @@ int32_t uAtClientReadRetryDelayGet(const uAtClientHandle_t atHandle);
 void uAtClientReadRetryDelaySet(uAtClientHandle_t atHandle,
                                 int32_t readRetryDelayMs);
 
+/** Get the size of the receive buffer of an AT client, including
+ * the #U_AT_CLIENT_BUFFER_OVERHEAD_BYTES used for management.
+ *
+ * @param atHandle  the handle of the AT client.
+ * @return          the size of the receive buffer in bytes.
+ */
+size_t uAtClientReceiveBufferSizeGet(const uAtClientHandle_t atHandle);
+
+/** Change the size of the receive buffer of an AT client, e.g. to
+ * grow it before a transfer of large binary payloads and shrink
+ * it again afterwards.  A new buffer is always allocated by the
+ * AT client, any data already received is moved into it and the
+ * old buffer is freed (if it was allocated by the AT client; if
+ * it was passed to uAtClientAddExt() it may be re-used by the
+ * caller once this function has returned successfully).  This
+ * function must not be called while the AT client is locked by
+ * the calling task.
+ *
+ * @param atHandle           the handle of the AT client.
+ * @param receiveBufferSize  the new size of the receive buffer in
+ *                           bytes, including the
+ *                           #U_AT_CLIENT_BUFFER_OVERHEAD_BYTES used
+ *                           for management; this must leave room
+ *                           for any data already received.
+ * @return                   zero on success else negative error code.
+ */
+int32_t uAtClientReceiveBufferSizeSet(uAtClientHandle_t atHandle,
+                                      size_t receiveBufferSize);
+
 /** Set a callback that will be called when there has been
  * one or more consecutive AT command timeouts.  The callback
  * is called internally by the AT client using
@@ -797,6 +977,45 @@ int32_t uAtClientDelayGet(const uAtClientHandle_t atHandle);
 void uAtClientDelaySet(uAtClientHandle_t atHandle,
                        int32_t delayMs);
 
+/** Make the delay between ending one AT command and starting the
+ * next adaptive: the AT client starts with a delay of minDelayMs,
+ * doubles it (up to the delay set with uAtClientDelaySet()) each
+ * time the AT server fails to respond within the AT timeout and
+ * reduces it by 1 millisecond each time
+ * #U_AT_CLIENT_DELAY_ADAPTIVE_DECREASE_COUNT AT commands in a row
+ * have succeeded, never going below minDelayMs.  In this way it
+ * learns the smallest delay that the AT server can cope with.
+ * Whether adaptive or not, the delay is measured from the end of
+ * the previous response, so only the remainder, if any, is waited.
+ * The adaptive delay is off by default.
+ *
+ * @param atHandle    the handle of the AT client.
+ * @param minDelayMs  the minimum delay in milliseconds; use a
+ *                    negative value to switch the adaptive delay
+ *                    off again.
+ */
+void uAtClientDelayAdaptiveSet(uAtClientHandle_t atHandle,
+                               int32_t minDelayMs);
+
+/** Get the current value of the adaptive delay between ending one
+ * AT command and starting the next; see uAtClientDelayAdaptiveSet().
+ *
+ * @param atHandle  the handle of the AT client.
+ * @return          the current adaptive delay in milliseconds or
+ *                  negative error code if the adaptive delay
+ *                  is off.
+ */
+int32_t uAtClientDelayAdaptiveGet(const uAtClientHandle_t atHandle);
+
+/** Get the total time that the AT client has spent waiting
+ * between ending one AT command and starting the next, a
+ * measure of how much the inter-command delay is costing.
+ *
+ * @param atHandle  the handle of the AT client.
+ * @return          the total delay in milliseconds.
+ */
+int64_t uAtClientDelayTotalGet(const uAtClientHandle_t atHandle);
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: SEND AN AT COMMAND
  * -------------------------------------------------------------- */
@@ -924,6 +1143,12 @@ void uAtClientWriteString(uAtClientHandle_t atHandle,
  *                     other parameters and hence a
  *                     delimiter should be inserted as
  *                     necessary by the AT client.
+ *                     A standalone write is always passed
+ *                     to the stream before this function
+ *                     returns, otherwise the bytes may
+ *                     be held in the transmit buffer until
+ *                     the AT command is complete (see
+ *                     #U_AT_CLIENT_TRANSMIT_BUFFER_LENGTH_BYTES).
  * @return             the number of bytes written.
  */
 size_t uAtClientWriteBytes(uAtClientHandle_t atHandle,
@@ -1130,6 +1355,30 @@ int32_t uAtClientReadBytes(uAtClientHandle_t atHandle,
                            char *pBuffer, size_t lengthBytes,
                            bool standalone);
 
+/** Read exactly the given number of bytes of binary data from
+ * the received AT response stream, e.g. the payload of a socket
+ * read, without looking for a stop tag or delimiter.  Whatever
+ * is already in the receive buffer is copied out in one go and
+ * the remainder is read straight from the stream into pBuffer,
+ * bypassing the receive buffer, so this is much quicker than
+ * uAtClientReadBytes() for large payloads; if there is a receive
+ * intercept function, or the stream is EDM, the remainder is
+ * instead copied a block at a time through the receive buffer.
+ * The AT timeout applies as usual.  Once the bytes have been
+ * read the response may be continued or stopped as normal.
+ *
+ * @param atHandle      the handle of the AT client.
+ * @param[out] pBuffer  a buffer of at least lengthBytes in which
+ *                      to place the bytes read.  May be set to
+ *                      NULL in which case the received bytes are
+ *                      thrown away.
+ * @param lengthBytes   the number of bytes to read.
+ * @return              the number of bytes read, which will be
+ *                      lengthBytes, or negative error code.
+ */
+int32_t uAtClientReadBytesDirect(uAtClientHandle_t atHandle,
+                                 char *pBuffer, size_t lengthBytes);
+
 /** Read binary data received as a hex string from from the
  *  AT response
  *
@@ -1229,6 +1478,48 @@ void uAtClientSkipBytes(uAtClientHandle_t atHandle,
 int32_t uAtClientWaitCharacter(uAtClientHandle_t atHandle,
                                char character);
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: SEND AN AT COMMAND ASYNCHRONOUSLY
+ * -------------------------------------------------------------- */
+
+/** Submit an AT command to be sent asynchronously: the command
+ * is added to a queue and this function returns immediately.  The
+ * queued commands are sent, in the order they were submitted, from
+ * the AT callback task (i.e. the task that runs callbacks
+ * triggered via uAtClientCallback()), one after the other and
+ * each within its own uAtClientLock()/uAtClientUnlock(), so
+ * they interleave safely with AT commands sent synchronously.
+ * Commands which set the concatenate field of
+ * #uAtClientCommandAsync_t and are queued together are sent on a
+ * single command line, up to
+ * #U_AT_CLIENT_COMMAND_ASYNC_LINE_MAX_LENGTH_BYTES long.
+ *
+ * The pResponse and pComplete callbacks are called on the AT
+ * callback task and so must obey the usual rules for callbacks:
+ * they must not block for long and, in particular, they must not
+ * wait for the completion of another asynchronous AT command.
+ * Commands still queued when the AT client is removed are
+ * discarded without pComplete being called.
+ *
+ * @param atHandle      the handle of the AT client.
+ * @param[in] pCommand  the AT command to send; cannot be NULL.
+ *                      The contents are copied, strings
+ *                      included, so they need not remain valid
+ *                      after this function has returned.
+ * @return              zero on success else negative error code.
+ */
+int32_t uAtClientCommandAsync(uAtClientHandle_t atHandle,
+                              const uAtClientCommandAsync_t *pCommand);
+
+/** Get the number of AT commands submitted with
+ * uAtClientCommandAsync() that have not yet completed.
+ *
+ * @param atHandle  the handle of the AT client.
+ * @return          the number of AT commands that have not
+ *                  yet completed.
+ */
+int32_t uAtClientCommandAsyncGetPending(uAtClientHandle_t atHandle);
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: HANDLE UNSOLICITED RESPONSES
  * -------------------------------------------------------------- */
@@ -1497,6 +1788,105 @@ int32_t uAtClientUrcDirect(uAtClientHandle_t atHandle,
                                              void *),
                            void *pHandlerParam);
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: STATISTICS
+ * -------------------------------------------------------------- */
+
+/** Start keeping statistics on the AT commands sent, and URCs
+ * received, by an AT client; if statistics are already being
+ * kept they are reset.  This allocates memory for
+ * #U_AT_CLIENT_STATS_MAX_NUM_COMMANDS instances of
+ * #uAtClientStatsCommand_t, which is released when
+ * uAtClientStatsStop() is called or the AT client is removed.
+ * Neither this function nor uAtClientStatsStop() may be called
+ * while the AT client is locked by the calling task.
+ *
+ * @param atHandle  the handle of the AT client.
+ * @return          zero on success else negative error code.
+ */
+int32_t uAtClientStatsStart(uAtClientHandle_t atHandle);
+
+/** Stop keeping statistics on an AT client, releasing
+ * the statistics memory.
+ *
+ * @param atHandle  the handle of the AT client.
+ */
+void uAtClientStatsStop(uAtClientHandle_t atHandle);
+
+/** Get the statistics for one of the AT commands sent by an AT
+ * client since uAtClientStatsStart() was called; the AT commands
+ * are indexed in the order they were first sent.
+ *
+ * @param atHandle     the handle of the AT client.
+ * @param index        the index of the AT command, starting at 0.
+ * @param[out] pStats  a place to put the statistics; cannot be NULL.
+ * @return             zero on success, #U_ERROR_COMMON_NOT_FOUND if
+ *                     there is no AT command at index, else negative
+ *                     error code.
+ */
+int32_t uAtClientStatsCommandGet(uAtClientHandle_t atHandle, size_t index,
+                                 uAtClientStatsCommand_t *pStats);
+
+/** Get the statistics for the URCs received by an AT client since
+ * uAtClientStatsStart() was called.
+ *
+ * @param atHandle     the handle of the AT client.
+ * @param[out] pStats  a place to put the statistics; cannot be NULL.
+ * @return             zero on success else negative error code.
+ */
+int32_t uAtClientStatsUrcGet(uAtClientHandle_t atHandle,
+                             uAtClientStatsUrc_t *pStats);
+
+/** Estimate a percentile of the latency of an AT command from its
+ * latency histogram: the estimate is the upper limit of the
+ * histogram bucket in which the percentile falls, capped at the
+ * longest latency seen.
+ *
+ * @param[in] pStats  the statistics for the AT command; cannot be NULL.
+ * @param percentile  the percentile, e.g. 99; must be from 1 to 100.
+ * @return            the estimated latency in milliseconds, else
+ *                    negative error code.
+ */
+int32_t uAtClientStatsLatencyPercentileMs(const uAtClientStatsCommand_t *pStats,
+                                          int32_t percentile);
+
+/** Write the statistics of an AT client as comma separated values,
+ * a header line followed by a line for each AT command (in the
+ * order they were first sent) and then a line, with the command
+ * "URC", for the URCs, each line terminated with "\n".  The columns
+ * are: command, count, timeouts, min_ms, avg_ms, p99_ms, max_ms,
+ * total_ms, bytes_out, bytes_in; for the URC line only count,
+ * avg_ms and total_ms (the time spent in URC handlers) are
+ * populated.  As with snprintf(), the output is truncated to
+ * fit bufferSize, always including a null terminator, and the
+ * length that the whole output would have is returned, so
+ * calling this with a NULL pBuffer and a bufferSize of zero
+ * will return the size of buffer required, less one for the
+ * terminator.
+ *
+ * @param atHandle     the handle of the AT client.
+ * @param[out] pBuffer a place to put the output; may be NULL
+ *                     if bufferSize is zero.
+ * @param bufferSize   the amount of storage at pBuffer.
+ * @return             the length of the whole output, not
+ *                     including the terminator, else negative
+ *                     error code.
+ */
+int32_t uAtClientStatsCsv(uAtClientHandle_t atHandle,
+                          char *pBuffer, size_t bufferSize);
+
+/** Get the transmit statistics of an AT client, which show
+ * how many stream writes the transmit buffer (see
+ * #U_AT_CLIENT_TRANSMIT_BUFFER_LENGTH_BYTES) has saved; unlike
+ * the statistics above these are always kept.
+ *
+ * @param atHandle     the handle of the AT client.
+ * @param[out] pStats  a place to put the statistics; cannot be NULL.
+ * @return             zero on success else negative error code.
+ */
+int32_t uAtClientTransmitStatsGet(uAtClientHandle_t atHandle,
+                                  uAtClientTransmitStats_t *pStats);
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: MISC
  * -------------------------------------------------------------- */
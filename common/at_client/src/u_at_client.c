@@ -36,6 +36,7 @@
 #include "stdbool.h"
 #include "string.h"    // memcpy(), strcmp(), strcspn(), strspm()
 #include "stdio.h"     // snprintf()
+#include "stdarg.h"    // va_list
 #include "ctype.h"     // isprint()
 #include "time.h"      // time_t and struct tm
 
@@ -183,6 +184,15 @@
 # define U_AT_CLIENT_CALLBACK_QUEUE_YIELD_MS 50
 #endif
 
+#ifndef U_AT_CLIENT_DELAY_ADAPTIVE_DECREASE_COUNT
+/** When the adaptive inter-command delay is in use (see
+ * uAtClientDelayAdaptiveSet()), the number of consecutive AT
+ * commands that must succeed before the delay is reduced by
+ * 1 millisecond.
+ */
+# define U_AT_CLIENT_DELAY_ADAPTIVE_DECREASE_COUNT 16
+#endif
+
 /** Guard for the URC task data receive loop to make
  * sure it can't be drowned by the incoming stream,
  * preventing control commands from getting in.
@@ -332,6 +342,40 @@ typedef struct uAtClientUrc_t {
     struct uAtClientUrc_t *pNext;
 } uAtClientUrc_t;
 
+/** A node in the trie of URC prefixes that is used to match
+ * incoming URCs: the trie is stored as an array of nodes where
+ * index 0 is the root and, since the root can never be a child
+ * or a sibling, an index of 0 means "none".
+ */
+typedef struct {
+    uAtClientUrc_t *pUrc; /** The URC whose prefix ends at this node, NULL if there is none. */
+    uint16_t child;       /** The index of the first child of this node. */
+    uint16_t sibling;     /** The index of the next sibling of this node. */
+    char character;       /** The character of the prefix that this node represents. */
+} uAtClientUrcTrieNode_t;
+
+/** An AT command in the queue of commands submitted with
+ * uAtClientCommandAsync().
+ * Note: the pCommand and pResponsePrefix strings are copied
+ * into the space following this structure.
+ */
+typedef struct uAtClientCommandAsyncEntry_t {
+    uAtClientCommandAsync_t command; /** The command. */
+    size_t commandLength;      /** The length of command.pCommand. */
+    struct uAtClientCommandAsyncEntry_t *pNext;
+} uAtClientCommandAsyncEntry_t;
+
+/** The statistics kept by an AT client, see uAtClientStatsStart().
+ */
+typedef struct {
+    uAtClientStatsCommand_t command[U_AT_CLIENT_STATS_MAX_NUM_COMMANDS];
+    size_t numCommands;        /** The number of entries used in command[]. */
+    uAtClientStatsUrc_t urc;   /** The URC statistics. */
+    int32_t current;           /** The index in command[] of the AT command in progress, -1 if none. */
+    bool currentStopped;       /** True if uAtClientCommandStop() has been called for current. */
+    int32_t currentStopTimeMs; /** The time at which uAtClientCommandStop() was called for current. */
+} uAtClientStats_t;
+
 /** The definition of a tag.
  */
 typedef struct {
@@ -439,12 +483,26 @@ typedef struct uAtClientInstance_t {
     void (*pConsecutiveTimeoutsCallback) (uAtClientHandle_t, int32_t *);
     char delimiter; /** The delimiter used between parameters. */
     int32_t delayMs; /** The delay from ending one AT command to starting the next. */
+    int32_t delayAdaptiveMinMs; /** The minimum adaptive delay, negative if adaptive delay is off. */
+    int32_t delayAdaptiveMs; /** The current adaptive delay. */
+    int32_t delayAdaptiveSuccessCount; /** Consecutive successful AT commands at delayAdaptiveMs. */
+    int64_t delayTotalMs; /** The total time spent in inter-command delays. */
+    uAtClientStats_t *pStats; /** Statistics, NULL if they are not being kept. */
+    char *pTransmitBuffer; /** Buffer in which outgoing AT commands are assembled, NULL if there is none. */
+    size_t transmitLength; /** The number of bytes waiting in pTransmitBuffer. */
+    bool transmitFlushing; /** True while pTransmitBuffer is being written to the stream. */
+    uAtClientTransmitStats_t transmitStats; /** Transmit statistics. */
     uErrorCode_t error; /** The current error status. */
     uAtClientDeviceError_t deviceError; /** The error reported by the AT server. */
     uAtClientScope_t scope; /** The scope, where we're at in the AT command. */
     uAtClientTag_t stopTag; /** The stop tag for the current scope. */
     uAtClientUrc_t *pUrcList; /** Linked-list anchor for URC handlers. */
     uAtClientUrc_t *pUrcRead;  /** Pointer used when reading the URC handlers. */
+    uAtClientUrcTrieNode_t *pUrcTrie; /** Trie of the prefixes in pUrcList, NULL if there is none. */
+    uAtClientCommandAsyncEntry_t *pCommandAsyncHead; /** Queue of asynchronous AT commands. */
+    uAtClientCommandAsyncEntry_t *pCommandAsyncTail; /** The last entry in pCommandAsyncHead. */
+    size_t commandAsyncPending; /** The number of asynchronous AT commands not yet completed. */
+    bool commandAsyncSendQueued; /** True if commandAsyncSendAll() is queued or running. */
     uTimeoutStart_t lastResponseStop; /** The time the last response ended in milliseconds. */
     int32_t lockTimeMs; /** The time when the stream was locked. */
     uTimeoutStart_t lastTxTime; /** The time when the last transmit activity was carried out. */
@@ -843,6 +901,7 @@ static void removeAtClientInstance(const uAtClientInstance_t *pClient)
 static void removeClient(uAtClientInstance_t *pClient)
 {
     uAtClientUrc_t *pUrc;
+    uAtClientCommandAsyncEntry_t *pCommandAsync;
     uDeviceSerial_t *pDeviceSerial;
 
     // Must not be in a wake-up handler
@@ -883,7 +942,25 @@ static void removeClient(uAtClientInstance_t *pClient)
             break;
     }
 
+    // Free any asynchronous AT commands that were queued
+    while (pClient->pCommandAsyncHead != NULL) {
+        pCommandAsync = pClient->pCommandAsyncHead;
+        pClient->pCommandAsyncHead = pCommandAsync->pNext;
+        uPortFree(pCommandAsync);
+    }
+    pClient->pCommandAsyncTail = NULL;
+
+    // Free any statistics
+    uPortFree(pClient->pStats);
+    pClient->pStats = NULL;
+
+    // Free the transmit buffer
+    uPortFree(pClient->pTransmitBuffer);
+    pClient->pTransmitBuffer = NULL;
+
     // Free any URC handlers it had.
+    uPortFree(pClient->pUrcTrie);
+    pClient->pUrcTrie = NULL;
     while (pClient->pUrcList != NULL) {
         pUrc = pClient->pUrcList;
         pClient->pUrcList = pUrc->pNext;
@@ -1225,6 +1302,109 @@ static void clearError(uAtClientInstance_t *pClient)
     setError(pClient, U_ERROR_COMMON_SUCCESS);
 }
 
+// Append printf()-style output to a buffer which already contains
+// length characters (or would, had it been big enough), in the
+// manner of snprintf(), returning the new length.
+static size_t statsPrint(char *pBuffer, size_t bufferSize, size_t length,
+                         const char *pFormat, ...)
+{
+    va_list args;
+    int32_t x;
+
+    va_start(args, pFormat);
+    if (length < bufferSize) {
+        x = vsnprintf(pBuffer + length, bufferSize - length, pFormat, args);
+    } else {
+        x = vsnprintf(NULL, 0, pFormat, args);
+    }
+    va_end(args);
+    if (x > 0) {
+        length += x;
+    }
+
+    return length;
+}
+
+// Finish the statistics for the AT command in progress, if any.
+static void statsCommandEnd(uAtClientInstance_t *pClient)
+{
+    uAtClientStats_t *pStats = pClient->pStats;
+    uAtClientStatsCommand_t *pCommand;
+    int32_t latencyMs;
+    uint32_t numLatencies = 0;
+    size_t bucket = 0;
+
+    if ((pStats != NULL) && (pStats->current >= 0)) {
+        if (pStats->currentStopped) {
+            pCommand = &(pStats->command[pStats->current]);
+            latencyMs = uPortGetTickTimeMs() - pStats->currentStopTimeMs;
+            if (latencyMs < 0) {
+                latencyMs = 0;
+            }
+            for (size_t x = 0; x < U_AT_CLIENT_STATS_HISTOGRAM_NUM_BUCKETS; x++) {
+                numLatencies += pCommand->latencyHistogram[x];
+            }
+            if ((numLatencies == 0) || (latencyMs < pCommand->latencyMinMs)) {
+                pCommand->latencyMinMs = latencyMs;
+            }
+            if (latencyMs > pCommand->latencyMaxMs) {
+                pCommand->latencyMaxMs = latencyMs;
+            }
+            pCommand->latencyTotalMs += (uint32_t) latencyMs;
+            // Bucket n is from 2^(n - 1) to (2^n) - 1
+            while ((latencyMs > 0) && (bucket < U_AT_CLIENT_STATS_HISTOGRAM_NUM_BUCKETS - 1)) {
+                latencyMs >>= 1;
+                bucket++;
+            }
+            pCommand->latencyHistogram[bucket]++;
+        }
+        pStats->current = -1;
+    }
+}
+
+// Start the statistics for an AT command.
+static void statsCommandBegin(uAtClientInstance_t *pClient,
+                              const char *pCommand)
+{
+    uAtClientStats_t *pStats = pClient->pStats;
+    char name[U_AT_CLIENT_STATS_COMMAND_MAX_LENGTH_BYTES];
+    size_t length;
+    size_t x = 0;
+
+    if ((pStats != NULL) && (pCommand != NULL)) {
+        // Finish off any previous command that has not been
+        // completed with uAtClientResponseStop()
+        statsCommandEnd(pClient);
+        // The name is everything up to any '=' or '?'
+        length = strcspn(pCommand, "=?");
+        if (length > sizeof(name) - 1) {
+            length = sizeof(name) - 1;
+        }
+        memcpy(name, pCommand, length);
+        name[length] = 0;
+        while ((x < pStats->numCommands) &&
+               (strcmp(pStats->command[x].command, name) != 0)) {
+            x++;
+        }
+        if (x >= pStats->numCommands) {
+            if (pStats->numCommands < U_AT_CLIENT_STATS_MAX_NUM_COMMANDS - 1) {
+                // New command
+                x = pStats->numCommands;
+                pStats->numCommands++;
+                memcpy(pStats->command[x].command, name, length + 1);
+            } else {
+                // No more room: use the last entry for everything else
+                x = U_AT_CLIENT_STATS_MAX_NUM_COMMANDS - 1;
+                pStats->numCommands = U_AT_CLIENT_STATS_MAX_NUM_COMMANDS;
+                strncpy(pStats->command[x].command, "*", sizeof(pStats->command[x].command));
+            }
+        }
+        pStats->command[x].count++;
+        pStats->current = (int32_t) x;
+        pStats->currentStopped = false;
+    }
+}
+
 // Increment the number of consecutive timeouts
 // and call the callback if there is one
 static void consecutiveTimeout(uAtClientInstance_t *pClient)
@@ -1234,6 +1414,18 @@ static void consecutiveTimeout(uAtClientInstance_t *pClient)
     U_PORT_MUTEX_LOCK(gMutexEventQueue);
 
     pClient->numConsecutiveAtTimeouts++;
+    if ((pClient->pStats != NULL) && (pClient->pStats->current >= 0)) {
+        pClient->pStats->command[pClient->pStats->current].numTimeouts++;
+    }
+    // If the inter-command delay is adaptive, the AT server
+    // may not have been ready: back off
+    if (pClient->delayAdaptiveMinMs >= 0) {
+        pClient->delayAdaptiveMs = pClient->delayAdaptiveMs * 2 + 1;
+        if (pClient->delayAdaptiveMs > pClient->delayMs) {
+            pClient->delayAdaptiveMs = pClient->delayMs;
+        }
+        pClient->delayAdaptiveSuccessCount = 0;
+    }
     if (pClient->pConsecutiveTimeoutsCallback != NULL) {
         // pConsecutiveTimeoutsCallback second parameter
         // is an int32_t pointer but of course the generic
@@ -1546,6 +1738,9 @@ static bool bufferFill(uAtClientInstance_t *pClient,
             // available in the buffer for the AT client as
             // there may be an intercept function in the way
             pReceiveBuffer->lengthBuffered += readLength;
+            if ((pClient->pStats != NULL) && (pClient->pStats->current >= 0)) {
+                pClient->pStats->command[pClient->pStats->current].bytesIn += (uint32_t) readLength;
+            }
             // length starts out as the amount of data that has not yet
             // been successfully processed by the intercept function
             length += readLength;
@@ -1896,52 +2091,169 @@ static void informationResponseStop(uAtClientInstance_t *pClient)
     }
 }
 
-// Iterate through URCs and check if one of them matches the current
-// contents of the receive buffer. If a URC is matched, set the
-// scope to information response and, after the URC's handler has
-// returned, finish off the information response scope by consuming
-// up to CR/LF.
+// Find the child of the given trie node that represents character,
+// returning its index or zero if there is no such child.
+static uint16_t urcTrieChildFind(const uAtClientUrcTrieNode_t *pTrie,
+                                 uint16_t node, char character)
+{
+    uint16_t child = pTrie[node].child;
+
+    while ((child != 0) && (pTrie[child].character != character)) {
+        child = pTrie[child].sibling;
+    }
+
+    return child;
+}
+
+// Rebuild the trie of URC prefixes from the URC list; this must be
+// called, with urcPermittedMutex locked, whenever the URC list is
+// changed.  Should there not be enough memory for the trie, or
+// should it be too large to index, then there will be no trie and
+// bufferMatchOneUrc() will fall back to a linear search of the list.
+static void urcTrieRebuild(uAtClientInstance_t *pClient)
+{
+    uAtClientUrcTrieNode_t *pTrie = NULL;
+    size_t numNodes = 1;
+    size_t commonLength;
+    size_t longestCommonLength;
+    uint16_t node;
+    uint16_t child;
+
+    // Work out how many nodes are needed: one for the root plus,
+    // for each prefix, the characters it does not share with the
+    // start of a prefix earlier in the list
+    for (uAtClientUrc_t *pUrc = pClient->pUrcList; pUrc != NULL; pUrc = pUrc->pNext) {
+        longestCommonLength = 0;
+        for (uAtClientUrc_t *pEarlier = pClient->pUrcList; pEarlier != pUrc;
+             pEarlier = pEarlier->pNext) {
+            commonLength = 0;
+            while ((commonLength < pUrc->prefixLength) &&
+                   (commonLength < pEarlier->prefixLength) &&
+                   (pUrc->pPrefix[commonLength] == pEarlier->pPrefix[commonLength])) {
+                commonLength++;
+            }
+            if (commonLength > longestCommonLength) {
+                longestCommonLength = commonLength;
+            }
+        }
+        numNodes += pUrc->prefixLength - longestCommonLength;
+    }
+
+    if ((pClient->pUrcList != NULL) && (numNodes <= UINT16_MAX)) {
+        pTrie = (uAtClientUrcTrieNode_t *) pUPortMalloc(numNodes * sizeof(*pTrie));
+    }
+    if (pTrie != NULL) {
+        memset(pTrie, 0, numNodes * sizeof(*pTrie));
+        numNodes = 1;
+        for (uAtClientUrc_t *pUrc = pClient->pUrcList; pUrc != NULL; pUrc = pUrc->pNext) {
+            node = 0;
+            for (size_t x = 0; x < pUrc->prefixLength; x++) {
+                child = urcTrieChildFind(pTrie, node, pUrc->pPrefix[x]);
+                if (child == 0) {
+                    child = (uint16_t) numNodes;
+                    numNodes++;
+                    pTrie[child].character = pUrc->pPrefix[x];
+                    pTrie[child].sibling = pTrie[node].child;
+                    pTrie[node].child = child;
+                }
+                node = child;
+            }
+            pTrie[node].pUrc = pUrc;
+        }
+    }
+
+    uPortFree(pClient->pUrcTrie);
+    pClient->pUrcTrie = pTrie;
+}
+
+// Find the URC with the longest prefix that matches the start of the
+// current receive buffer, ignoring any nulls at the start, without
+// consuming anything; *pNumNulls is set to the number of nulls.
+static uAtClientUrc_t *pUrcFind(const uAtClientInstance_t *pClient,
+                                size_t *pNumNulls)
+{
+    uAtClientReceiveBuffer_t *pReceiveBuffer = pClient->pReceiveBuffer;
+    const char *pData = U_AT_CLIENT_DATA_BUFFER_PTR(pReceiveBuffer) + pReceiveBuffer->readIndex;
+    size_t length = pReceiveBuffer->length - pReceiveBuffer->readIndex;
+    const uAtClientUrcTrieNode_t *pTrie = pClient->pUrcTrie;
+    uAtClientUrc_t *pFound = NULL;
+    size_t numNulls = 0;
+    uint16_t node = 0;
+
+    // Ignore nulls at the start in case a URC is emitted
+    // near power-on which can suffer from such nulls
+    while ((numNulls < length) && (pData[numNulls] == 0)) {
+        numNulls++;
+    }
+    pData += numNulls;
+    length -= numNulls;
+
+    if (pTrie != NULL) {
+        for (size_t x = 0; x < length; x++) {
+            node = urcTrieChildFind(pTrie, node, pData[x]);
+            if (node == 0) {
+                break;
+            }
+            if (pTrie[node].pUrc != NULL) {
+                pFound = pTrie[node].pUrc;
+            }
+        }
+    } else {
+        for (uAtClientUrc_t *pUrc = pClient->pUrcList; pUrc != NULL; pUrc = pUrc->pNext) {
+            if ((length >= pUrc->prefixLength) &&
+                ((pFound == NULL) || (pUrc->prefixLength > pFound->prefixLength)) &&
+                (memcmp(pData, pUrc->pPrefix, pUrc->prefixLength) == 0)) {
+                pFound = pUrc;
+            }
+        }
+    }
+
+    *pNumNulls = numNulls;
+
+    return pFound;
+}
+
+// Check if one of the URCs matches the current contents of the
+// receive buffer. If a URC is matched, set the scope to information
+// response and, after the URC's handler has returned, finish off the
+// information response scope by consuming up to CR/LF.
 static bool bufferMatchOneUrc(uAtClientInstance_t *pClient)
 {
-    size_t prefixLength = 0;
-    bool found = false;
+    uAtClientUrc_t *pUrc;
+    size_t numNulls;
     int32_t now;
     uErrorCode_t savedError;
 
     bufferRewind(pClient);
 
-    for (uAtClientUrc_t *pUrc = pClient->pUrcList;
-         !found && (pUrc != NULL);
-         pUrc = pUrc->pNext) {
-        prefixLength = pUrc->prefixLength;
-        if (pClient->pReceiveBuffer->length >= prefixLength) {
-            // Do the check ignoring nulls at the start in case
-            // a URC is emitted near power-on which can suffer from
-            // such nulls
-            if (bufferMatch(pClient, pUrc->pPrefix, prefixLength, true)) {
-                setScope(pClient, U_AT_CLIENT_SCOPE_INFORMATION);
-                now = uPortGetTickTimeMs();
-                // Before heading off into URCness, save
-                // the current error state and reset
-                // it so that the URC doesn't suffer the error
-                savedError = pClient->error;
-                pClient->error = U_ERROR_COMMON_SUCCESS;
-                if (processAsync(pClient->magicNumber) && pUrc->pHandler) {
-                    pUrc->pHandler(pClient, pUrc->pHandlerParam);
-                }
-                informationResponseStop(pClient);
-                // Put the error state back again
-                pClient->error = savedError;
-                // Put the error state back again
-                // Add the amount of time spent in the URC
-                // world to the start time
-                pClient->lockTimeMs += uPortGetTickTimeMs() - now;
-                found = true;
-            }
+    pUrc = pUrcFind(pClient, &numNulls);
+    if (pUrc != NULL) {
+        // Consume the nulls and the prefix
+        pClient->pReceiveBuffer->readIndex += numNulls + pUrc->prefixLength;
+        setScope(pClient, U_AT_CLIENT_SCOPE_INFORMATION);
+        now = uPortGetTickTimeMs();
+        // Before heading off into URCness, save
+        // the current error state and reset
+        // it so that the URC doesn't suffer the error
+        savedError = pClient->error;
+        pClient->error = U_ERROR_COMMON_SUCCESS;
+        if (processAsync(pClient->magicNumber) && pUrc->pHandler) {
+            pUrc->pHandler(pClient, pUrc->pHandlerParam);
+        }
+        informationResponseStop(pClient);
+        // Put the error state back again
+        pClient->error = savedError;
+        // Add the amount of time spent in the URC
+        // world to the start time
+        now = uPortGetTickTimeMs() - now;
+        pClient->lockTimeMs += now;
+        if (pClient->pStats != NULL) {
+            pClient->pStats->urc.count++;
+            pClient->pStats->urc.timeMs += (uint32_t) now;
         }
     }
 
-    return found;
+    return (pUrc != NULL);
 }
 
 // Read a string parameter.
@@ -2236,9 +2548,9 @@ static bool processResponse(uAtClientInstance_t *pClient,
 // not match then it _also_ blocks on inWakeUpHandlerMutex
 // before proceeding, hence holding off processing until
 // the wake-up process has completed.
-static size_t write(uAtClientInstance_t *pClient,
-                    const char *pData, size_t length,
-                    bool andFlush)
+static size_t streamWrite(uAtClientInstance_t *pClient,
+                          const char *pData, size_t length,
+                          bool andFlush)
 {
     int32_t thisLengthWritten = 0;
     size_t lengthToWrite;
@@ -2258,6 +2570,9 @@ static size_t write(uAtClientInstance_t *pClient,
     uAtClientTag_t savedStopTag;
     bool savedDelimiterRequired;
     uAtClientDeviceError_t savedDeviceError;
+    int32_t savedStatsCurrent = -1;
+    bool savedStatsCurrentStopped = false;
+    int32_t savedStatsCurrentStopTimeMs = 0;
     uDeviceSerial_t *pDeviceSerial;
 
     while (((pData < pDataEnd) || andFlush) &&
@@ -2290,6 +2605,12 @@ static size_t write(uAtClientInstance_t *pClient,
             savedStopTag = pClient->stopTag;
             savedDelimiterRequired = pClient->delimiterRequired;
             savedDeviceError = pClient->deviceError;
+            if (pClient->pStats != NULL) {
+                savedStatsCurrent = pClient->pStats->current;
+                savedStatsCurrentStopped = pClient->pStats->currentStopped;
+                savedStatsCurrentStopTimeMs = pClient->pStats->currentStopTimeMs;
+                pClient->pStats->current = -1;
+            }
             // Reset the scope, stopTag and delimiterRequired
             pClient->scope = U_AT_CLIENT_SCOPE_NONE;
             pClient->stopTag.pTagDef = &gNoStopTag;
@@ -2314,6 +2635,11 @@ static size_t write(uAtClientInstance_t *pClient,
             pClient->stopTag = savedStopTag;
             pClient->delimiterRequired = savedDelimiterRequired;
             pClient->deviceError = savedDeviceError;
+            if (pClient->pStats != NULL) {
+                pClient->pStats->current = savedStatsCurrent;
+                pClient->pStats->currentStopped = savedStatsCurrentStopped;
+                pClient->pStats->currentStopTimeMs = savedStatsCurrentStopTimeMs;
+            }
             // Set the adjusted lock time, allowing for potential
             // wrap in uPortGetTickTimeMs()
             wakeUpDurationMs = uPortGetTickTimeMs() - wakeUpDurationMs;
@@ -2370,9 +2696,13 @@ static size_t write(uAtClientInstance_t *pClient,
                     default:
                         break;
                 }
+                if (pClient->stream.type != U_AT_CLIENT_STREAM_TYPE_EDM) {
+                    pClient->transmitStats.numStreamWrites++;
+                }
                 if (thisLengthWritten > 0) {
                     pDataToWrite += thisLengthWritten;
                     lengthToWrite -= thisLengthWritten;
+                    pClient->transmitStats.bytes += (uint32_t) thisLengthWritten;
                     pClient->lastTxTime = uTimeoutStart();
                 } else {
                     setError(pClient, U_ERROR_COMMON_DEVICE_ERROR);
@@ -2381,14 +2711,70 @@ static size_t write(uAtClientInstance_t *pClient,
         }
     }
 
+    if (pClient->error != U_ERROR_COMMON_SUCCESS) {
+        length = 0;
+    }
+
+    return length;
+}
+
+// Write whatever is in the transmit buffer to the stream.
+static void transmitFlush(uAtClientInstance_t *pClient)
+{
+    size_t length = pClient->transmitLength;
+
+    // Nothing is done if we are already flushing: that
+    // means we have recursed via the wake-up handler, the
+    // writes of which go straight to the stream
+    if ((length > 0) && !pClient->transmitFlushing) {
+        pClient->transmitLength = 0;
+        pClient->transmitFlushing = true;
+        streamWrite(pClient, pClient->pTransmitBuffer, length, false);
+        pClient->transmitFlushing = false;
+    }
+}
+
+// Write data, assembling it in the transmit buffer if there is one;
+// if andFlush is true the transmit buffer is written to the stream
+// before returning.
+static size_t write(uAtClientInstance_t *pClient,
+                    const char *pData, size_t length,
+                    bool andFlush)
+{
+    pClient->transmitStats.numWrites++;
+    if ((pClient->pTransmitBuffer == NULL) || (pClient->pInterceptTx != NULL) ||
+        pClient->transmitFlushing) {
+        length = streamWrite(pClient, pData, length, andFlush);
+    } else if (pClient->error == U_ERROR_COMMON_SUCCESS) {
+        if (pClient->transmitLength + length > U_AT_CLIENT_TRANSMIT_BUFFER_LENGTH_BYTES) {
+            transmitFlush(pClient);
+        }
+        if (length >= U_AT_CLIENT_TRANSMIT_BUFFER_LENGTH_BYTES) {
+            // Too big to be worth copying: the buffer has been
+            // emptied above so this can go straight after it
+            length = streamWrite(pClient, pData, length, false);
+        } else if ((length > 0) && (pClient->error == U_ERROR_COMMON_SUCCESS)) {
+            memcpy(pClient->pTransmitBuffer + pClient->transmitLength, pData, length);
+            pClient->transmitLength += length;
+        }
+        if (andFlush) {
+            transmitFlush(pClient);
+        }
+    }
+
     // If there is an intercept function it may be that
     // the length written is longer or shorter than
     // passed in so it is not easily possible to printAt()
     // exactly what was written, we can only check
     // if *everything* was written
     if (pClient->error == U_ERROR_COMMON_SUCCESS) {
-        printAt(pClient, pDataStart, length, true);
+        printAt(pClient, pData, length, true);
+        if ((pClient->pStats != NULL) && (pClient->pStats->current >= 0)) {
+            pClient->pStats->command[pClient->pStats->current].bytesOut += (uint32_t) length;
+        }
     } else {
+        // Anything waiting in the transmit buffer is now of no use
+        pClient->transmitLength = 0;
         length = 0;
     }
 
@@ -2752,6 +3138,124 @@ static void urcCallbackDeviceSerial(uDeviceSerial_t *pDeviceSerial, uint32_t eve
     urcCallback(&stream, eventBitmask, pParameters);
 }
 
+// Send a batch of asynchronous AT commands, linked through pNext,
+// on a single command line and read the responses, returning the
+// result of uAtClientUnlock(); the AT client must be locked
+// with uAtClientLock() before this is called.
+static int32_t commandAsyncSend(uAtClientInstance_t *pClient,
+                                const uAtClientCommandAsyncEntry_t *pBatch)
+{
+    uAtClientHandle_t atHandle = (uAtClientHandle_t) pClient;
+    const uAtClientCommandAsync_t *pCommand = &(pBatch->command);
+
+    uAtClientCommandStart(atHandle, pCommand->pCommand);
+    for (const uAtClientCommandAsyncEntry_t *pEntry = pBatch->pNext;
+         pEntry != NULL; pEntry = pEntry->pNext) {
+        // Concatenated commands are separated by a semicolon
+        // and lose their "AT"
+        uAtClientWritePartialString(atHandle, false, ";");
+        uAtClientWritePartialString(atHandle, false, pEntry->command.pCommand + 2);
+    }
+    uAtClientCommandStop(atHandle);
+
+    if (pBatch->pNext == NULL) {
+        // On its own, a command may have any number of lines
+        // of information response
+        if (pCommand->pResponsePrefix != NULL) {
+            while (uAtClientResponseStart(atHandle, pCommand->pResponsePrefix) == 0) {
+                if (pCommand->pResponse != NULL) {
+                    pCommand->pResponse(atHandle, pCommand->pParam);
+                }
+            }
+        } else if ((uAtClientResponseStart(atHandle, NULL) == 0) &&
+                   (pCommand->pResponse != NULL)) {
+            pCommand->pResponse(atHandle, pCommand->pParam);
+        }
+    } else {
+        // Concatenated commands have at most one line
+        // of information response each, in order
+        for (const uAtClientCommandAsyncEntry_t *pEntry = pBatch;
+             pEntry != NULL; pEntry = pEntry->pNext) {
+            pCommand = &(pEntry->command);
+            if (((pCommand->pResponsePrefix != NULL) || (pCommand->pResponse != NULL)) &&
+                (uAtClientResponseStart(atHandle, pCommand->pResponsePrefix) == 0) &&
+                (pCommand->pResponse != NULL)) {
+                pCommand->pResponse(atHandle, pCommand->pParam);
+            }
+        }
+    }
+    uAtClientResponseStop(atHandle);
+
+    return uAtClientUnlock(atHandle);
+}
+
+// Callback, run via the event queue, that sends the queued
+// asynchronous AT commands until there are none left.
+static void commandAsyncSendAll(uAtClientHandle_t atHandle, void *pParam)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    uAtClientCommandAsyncEntry_t *pBatch;
+    uAtClientCommandAsyncEntry_t *pLast;
+    size_t lineLength;
+    int32_t errorCode;
+    bool sendQueued;
+
+    (void) pParam;
+
+    do {
+        // Lock the AT client before taking commands off the queue
+        // so that any which are submitted while the AT client is
+        // busy with something else can go in the same batch
+        uAtClientLock(atHandle);
+
+        U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+        // Take the command at the head of the queue plus as many
+        // of those after it as may be concatenated with it
+        pBatch = pClient->pCommandAsyncHead;
+        if (pBatch != NULL) {
+            pLast = pBatch;
+            if (pBatch->command.concatenate) {
+                lineLength = pBatch->commandLength;
+                while ((pLast->pNext != NULL) && pLast->pNext->command.concatenate &&
+                       // +1 for the semicolon, -2 for the "AT"
+                       (lineLength + pLast->pNext->commandLength - 1 <=
+                        U_AT_CLIENT_COMMAND_ASYNC_LINE_MAX_LENGTH_BYTES)) {
+                    pLast = pLast->pNext;
+                    lineLength += pLast->commandLength - 1;
+                }
+            }
+            pClient->pCommandAsyncHead = pLast->pNext;
+            if (pClient->pCommandAsyncHead == NULL) {
+                pClient->pCommandAsyncTail = NULL;
+            }
+            pLast->pNext = NULL;
+        } else {
+            pClient->commandAsyncSendQueued = false;
+        }
+        sendQueued = pClient->commandAsyncSendQueued;
+
+        U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+
+        if (pBatch != NULL) {
+            errorCode = commandAsyncSend(pClient, pBatch);
+            while (pBatch != NULL) {
+                pLast = pBatch;
+                pBatch = pBatch->pNext;
+                if (pLast->command.pComplete != NULL) {
+                    pLast->command.pComplete(atHandle, errorCode, pLast->command.pParam);
+                }
+                U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+                pClient->commandAsyncPending--;
+                U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+                uPortFree(pLast);
+            }
+        } else {
+            uAtClientUnlock(atHandle);
+        }
+    } while (sendQueued);
+}
+
 // Callback for the event queue.
 static void eventQueueCallback(void *pParameters, size_t paramLength)
 {
@@ -2816,6 +3320,12 @@ static uAtClientHandle_t clientAdd(const uAtClientStreamHandle_t *pStream,
                         pClient->delimiter = U_AT_CLIENT_DEFAULT_DELIMITER;
                         mutexStackInit(&(pClient->lockedStreamMutexStack));
                         pClient->delayMs = U_AT_CLIENT_DEFAULT_DELAY_MS;
+                        pClient->delayAdaptiveMinMs = -1;
+#if U_AT_CLIENT_TRANSMIT_BUFFER_LENGTH_BYTES > 0
+                        // No transmit buffer is not fatal, writes
+                        // just go straight to the stream
+                        pClient->pTransmitBuffer = (char *) pUPortMalloc(U_AT_CLIENT_TRANSMIT_BUFFER_LENGTH_BYTES);
+#endif
                         clearError(pClient);
                         // This will also set stopTag
                         setScope(pClient, U_AT_CLIENT_SCOPE_NONE);
@@ -2879,6 +3389,7 @@ static uAtClientHandle_t clientAdd(const uAtClientStreamHandle_t *pStream,
                     if (receiveBufferIsMalloced) {
                         uPortFree(pClient->pReceiveBuffer);
                     }
+                    uPortFree(pClient->pTransmitBuffer);
                     uPortFree(pClient);
                     pClient = NULL;
                 }
@@ -3190,6 +3701,61 @@ void uAtClientReadRetryDelaySet(uAtClientHandle_t atHandle,
     }
 }
 
+// Get the size of the receive buffer.
+size_t uAtClientReceiveBufferSizeGet(const uAtClientHandle_t atHandle)
+{
+    return ((const uAtClientInstance_t *) atHandle)->pReceiveBuffer->dataBufferSize +
+           U_AT_CLIENT_BUFFER_OVERHEAD_BYTES;
+}
+
+// Change the size of the receive buffer.
+int32_t uAtClientReceiveBufferSizeSet(uAtClientHandle_t atHandle,
+                                      size_t receiveBufferSize)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uAtClientReceiveBuffer_t *pReceiveBuffer;
+
+    // Lock the stream also, since URC processing uses
+    // the receive buffer
+    U_PORT_MUTEX_LOCK(pClient->streamMutex);
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    // Throw away what has already been read so that only
+    // unread data need fit into the new buffer
+    bufferRewind(pClient);
+    if ((receiveBufferSize > U_AT_CLIENT_BUFFER_OVERHEAD_BYTES) &&
+        (receiveBufferSize - U_AT_CLIENT_BUFFER_OVERHEAD_BYTES >=
+         pClient->pReceiveBuffer->lengthBuffered)) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        pReceiveBuffer = (uAtClientReceiveBuffer_t *) pUPortMalloc(receiveBufferSize);
+        if (pReceiveBuffer != NULL) {
+            // Copy the management structure, which includes the
+            // opening marker, and any received data, then fix up
+            // the size and the closing marker
+            memcpy(pReceiveBuffer, pClient->pReceiveBuffer,
+                   sizeof(uAtClientReceiveBuffer_t) +
+                   pClient->pReceiveBuffer->lengthBuffered);
+            pReceiveBuffer->isMalloced = 1;
+            pReceiveBuffer->dataBufferSize = receiveBufferSize -
+                                             U_AT_CLIENT_BUFFER_OVERHEAD_BYTES;
+            memcpy(U_AT_CLIENT_DATA_BUFFER_PTR(pReceiveBuffer) +
+                   pReceiveBuffer->dataBufferSize,
+                   U_AT_CLIENT_MARKER, U_AT_CLIENT_MARKER_SIZE);
+            if (pClient->pReceiveBuffer->isMalloced) {
+                uPortFree(pClient->pReceiveBuffer);
+            }
+            pClient->pReceiveBuffer = pReceiveBuffer;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+    U_PORT_MUTEX_UNLOCK(pClient->streamMutex);
+
+    return errorCode;
+}
+
 // Set a callback to be called on consecutive AT timeouts.
 void uAtClientTimeoutCallbackSet(uAtClientHandle_t atHandle,
                                  void (*pCallback) (uAtClientHandle_t,
@@ -3245,6 +3811,44 @@ void uAtClientDelaySet(uAtClientHandle_t atHandle,
     }
 }
 
+// Set the adaptive delay between AT commands.
+void uAtClientDelayAdaptiveSet(uAtClientHandle_t atHandle,
+                               int32_t minDelayMs)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    pClient->delayAdaptiveMinMs = minDelayMs;
+    if (minDelayMs > pClient->delayMs) {
+        pClient->delayAdaptiveMinMs = pClient->delayMs;
+    }
+    // Start optimistic, at the minimum
+    pClient->delayAdaptiveMs = pClient->delayAdaptiveMinMs;
+    pClient->delayAdaptiveSuccessCount = 0;
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+}
+
+// Get the adaptive delay between AT commands.
+int32_t uAtClientDelayAdaptiveGet(const uAtClientHandle_t atHandle)
+{
+    const uAtClientInstance_t *pClient = (const uAtClientInstance_t *) atHandle;
+    int32_t errorCodeOrDelayMs = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+
+    if (pClient->delayAdaptiveMinMs >= 0) {
+        errorCodeOrDelayMs = pClient->delayAdaptiveMs;
+    }
+
+    return errorCodeOrDelayMs;
+}
+
+// Get the total time spent in delays between AT commands.
+int64_t uAtClientDelayTotalGet(const uAtClientHandle_t atHandle)
+{
+    return ((const uAtClientInstance_t *) atHandle)->delayTotalMs;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: SEND AN AT COMMAND
  * -------------------------------------------------------------- */
@@ -3275,6 +3879,9 @@ void uAtClientLock(uAtClientHandle_t atHandle)
             }
         }
         clearError(pClient);
+        // Anything left in the transmit buffer belongs to
+        // a failed AT command
+        pClient->transmitLength = 0;
         pClient->lockTimeMs = uPortGetTickTimeMs();
     }
 }
@@ -3317,6 +3924,9 @@ int32_t uAtClientUnlock(uAtClientHandle_t atHandle)
 
     U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
 
+    // Anything not yet sent goes now, before the stream is unlocked
+    transmitFlush(pClient);
+    statsCommandEnd(pClient);
     streamMutex = mutexStackPop(&(pClient->lockedStreamMutexStack));
     if (streamMutex != NULL) {
         unlockNoDataCheck(pClient, streamMutex);
@@ -3387,18 +3997,27 @@ void uAtClientCommandStart(uAtClientHandle_t atHandle,
                            const char *pCommand)
 {
     uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    int32_t delayMs;
+    int32_t startTimeMs;
 
     U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
 
     if (pClient->error == U_ERROR_COMMON_SUCCESS) {
-        // Wait for delay period if required
-        if (pClient->delayMs > 0) {
-            while (!uTimeoutExpiredMs(pClient->lastResponseStop,
-                                      pClient->delayMs)) {
-                uPortTaskBlock(10);
+        // Wait for whatever remains of the delay period
+        delayMs = pClient->delayMs;
+        if (pClient->delayAdaptiveMinMs >= 0) {
+            delayMs = pClient->delayAdaptiveMs;
+        }
+        if (delayMs > 0) {
+            startTimeMs = uPortGetTickTimeMs();
+            while (!uTimeoutExpiredMs(pClient->lastResponseStop, delayMs)) {
+                uPortTaskBlock(delayMs - (int32_t) uTimeoutElapsedMs(pClient->lastResponseStop));
             }
+            pClient->delayTotalMs += uPortGetTickTimeMs() - startTimeMs;
         }
 
+        statsCommandBegin(pClient, pCommand);
+
         // Send the command, no delimiter at first
         pClient->delimiterRequired = false;
         // Note: allow pCommand to be NULL here only
@@ -3547,6 +4166,10 @@ void uAtClientCommandStop(uAtClientHandle_t atHandle)
         write(pClient, U_AT_CLIENT_COMMAND_DELIMITER,
               U_AT_CLIENT_COMMAND_DELIMITER_LENGTH_BYTES,
               true);
+        if ((pClient->pStats != NULL) && (pClient->pStats->current >= 0)) {
+            pClient->pStats->currentStopped = true;
+            pClient->pStats->currentStopTimeMs = uPortGetTickTimeMs();
+        }
     }
 
     U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
@@ -3572,6 +4195,12 @@ int32_t uAtClientResponseStart(uAtClientHandle_t atHandle,
     // checks for URCs and may end up calling a URC
     // handler which will also need the lock.
 
+    // Make sure that the command has gone
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+    transmitFlush(pClient);
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+    returnCode = (int32_t) pClient->error;
+
     if (pClient->error == U_ERROR_COMMON_SUCCESS) {
         // Stop any previous information response
         if (pClient->scope == U_AT_CLIENT_SCOPE_INFORMATION) {
@@ -3668,15 +4297,34 @@ int32_t uAtClientReadBytes(uAtClientHandle_t atHandle,
 {
     uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
     uAtClientTag_t *pStopTag = &(pClient->stopTag);
+    uAtClientReceiveBuffer_t *pReceiveBuffer;
     int32_t lengthRead = 0;
     int32_t matchPos = 0;
     int32_t c;
+    size_t x;
 
     U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
 
     while ((lengthRead < ((int32_t) lengthBytes + matchPos)) &&
            (pClient->error == U_ERROR_COMMON_SUCCESS) &&
            !pStopTag->found) {
+        pReceiveBuffer = pClient->pReceiveBuffer;
+        if ((pStopTag->pTagDef->length == 0) &&
+            (pReceiveBuffer->readIndex < pReceiveBuffer->length)) {
+            // No stop tag to look for so copy out whatever
+            // is in the receive buffer in one go
+            x = pReceiveBuffer->length - pReceiveBuffer->readIndex;
+            if (x > lengthBytes - lengthRead) {
+                x = lengthBytes - lengthRead;
+            }
+            if (pBuffer != NULL) {
+                memcpy(pBuffer + lengthRead, U_AT_CLIENT_DATA_BUFFER_PTR(pReceiveBuffer) +
+                       pReceiveBuffer->readIndex, x);
+            }
+            pReceiveBuffer->readIndex += x;
+            lengthRead += (int32_t) x;
+            continue;
+        }
         c = bufferReadChar(pClient);
         if (c == -1) {
             // Error
@@ -3755,6 +4403,98 @@ int32_t uAtClientReadBytes(uAtClientHandle_t atHandle,
     return lengthRead;
 }
 
+// Read binary bytes, straight from the stream where possible.
+int32_t uAtClientReadBytesDirect(uAtClientHandle_t atHandle,
+                                 char *pBuffer, size_t lengthBytes)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    uAtClientReceiveBuffer_t *pReceiveBuffer;
+    int32_t lengthRead = 0;
+    int32_t readLength;
+    int32_t c;
+    size_t x;
+    uDeviceSerial_t *pDeviceSerial;
+    bool direct;
+#if U_CFG_ENABLE_LOGGING
+    char timestampBuffer[U_AT_CLIENT_PRINT_TIMESTAMP_BUFFER_SIZE_BYTES];
+#endif
+
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    transmitFlush(pClient);
+    pReceiveBuffer = pClient->pReceiveBuffer;
+    // The stream can only be read directly into pBuffer if
+    // nothing needs to process the data on the way
+    direct = (pBuffer != NULL) && (pClient->pInterceptRx == NULL) &&
+             ((pClient->stream.type == U_AT_CLIENT_STREAM_TYPE_UART) ||
+              (pClient->stream.type == U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL));
+    while ((lengthRead < (int32_t) lengthBytes) &&
+           (pClient->error == U_ERROR_COMMON_SUCCESS)) {
+        if (pReceiveBuffer->readIndex < pReceiveBuffer->length) {
+            // Copy out what has already been received
+            x = pReceiveBuffer->length - pReceiveBuffer->readIndex;
+            if (x > lengthBytes - lengthRead) {
+                x = lengthBytes - lengthRead;
+            }
+            if (pBuffer != NULL) {
+                memcpy(pBuffer + lengthRead, U_AT_CLIENT_DATA_BUFFER_PTR(pReceiveBuffer) +
+                       pReceiveBuffer->readIndex, x);
+            }
+            pReceiveBuffer->readIndex += x;
+            lengthRead += (int32_t) x;
+        } else if (direct) {
+            // The receive buffer is empty, read the rest straight in
+            bufferReset(pClient, false);
+            readLength = 0;
+            if (pClient->stream.type == U_AT_CLIENT_STREAM_TYPE_UART) {
+                readLength = uPortUartRead(pClient->stream.handle.int32,
+                                           pBuffer + lengthRead,
+                                           lengthBytes - lengthRead);
+            } else {
+                pDeviceSerial = pClient->stream.handle.pDeviceSerial;
+                readLength = pDeviceSerial->read(pDeviceSerial, pBuffer + lengthRead,
+                                                 lengthBytes - lengthRead);
+            }
+            if (readLength > 0) {
+                printAt(pClient, pBuffer + lengthRead, readLength, false);
+                if ((pClient->pStats != NULL) && (pClient->pStats->current >= 0)) {
+                    pClient->pStats->command[pClient->pStats->current].bytesIn += (uint32_t) readLength;
+                }
+                lengthRead += readLength;
+                pClient->numConsecutiveAtTimeouts = 0;
+            } else if (pollTimeRemaining(pClient->atTimeoutMs, pClient->lockTimeMs) > 0) {
+                uPortTaskBlock(pClient->atStreamReadRetryDelayMs);
+            } else {
+                if (pClient->debugOn) {
+                    uPortLog("U_AT_CLIENT_%d-%d%s: timeout.\n",
+                             pClient->stream.type, U_AT_CLIENT_HANDLE_FOR_PRINT(pClient),
+                             pPrintTimestamp(" ", NULL, timestampBuffer, sizeof(timestampBuffer)));
+                }
+                setError(pClient, U_ERROR_COMMON_DEVICE_ERROR);
+                consecutiveTimeout(pClient);
+            }
+        } else {
+            // Let bufferReadChar() refill the receive buffer (and
+            // deal with any timeout), then copy out in blocks again
+            c = bufferReadChar(pClient);
+            if (c >= 0) {
+                if (pBuffer != NULL) {
+                    *(pBuffer + lengthRead) = (char) c;
+                }
+                lengthRead++;
+            }
+        }
+    }
+
+    if (pClient->error != U_ERROR_COMMON_SUCCESS) {
+        lengthRead = -1;
+    }
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+
+    return lengthRead;
+}
+
 int32_t uAtClientReadHexData(uAtClientHandle_t atHandle,
                              uint8_t *pData,
                              uint8_t lengthBytes)
@@ -3794,6 +4534,20 @@ void uAtClientResponseStop(uAtClientHandle_t atHandle)
     }
 
     pClient->lastResponseStop = uTimeoutStart();
+    statsCommandEnd(pClient);
+
+    // If the inter-command delay is adaptive and the AT server
+    // is keeping up, see if it can keep up with less
+    if ((pClient->delayAdaptiveMinMs >= 0) &&
+        (pClient->error == U_ERROR_COMMON_SUCCESS)) {
+        pClient->delayAdaptiveSuccessCount++;
+        if (pClient->delayAdaptiveSuccessCount >= U_AT_CLIENT_DELAY_ADAPTIVE_DECREASE_COUNT) {
+            pClient->delayAdaptiveSuccessCount = 0;
+            if (pClient->delayAdaptiveMs > pClient->delayAdaptiveMinMs) {
+                pClient->delayAdaptiveMs--;
+            }
+        }
+    }
 
     U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
 }
@@ -3918,6 +4672,11 @@ int32_t uAtClientWaitCharacter(uAtClientHandle_t atHandle,
     // URC handler which itself will need to be able
     // to perform a lock.
 
+    // Make sure that whatever we are waiting on a response to has gone
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+    transmitFlush(pClient);
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+
     // Can't allow CR or LF since we remove them from the
     // stream as part of looking for URCs
     if ((character != 0x0d) && (character != 0x0a)) {
@@ -3984,6 +4743,88 @@ int32_t uAtClientWaitCharacter(uAtClientHandle_t atHandle,
     return (int32_t) errorCode;
 }
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: SEND AN AT COMMAND ASYNCHRONOUSLY
+ * -------------------------------------------------------------- */
+
+// Submit an AT command to be sent asynchronously.
+int32_t uAtClientCommandAsync(uAtClientHandle_t atHandle,
+                              const uAtClientCommandAsync_t *pCommand)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uAtClientCommandAsyncEntry_t *pEntry;
+    size_t commandLength;
+    size_t prefixLength = 0;
+    char *pDest;
+
+    if ((pCommand != NULL) && (pCommand->pCommand != NULL) &&
+        (!pCommand->concatenate || (strncmp(pCommand->pCommand, "AT+", 3) == 0))) {
+        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+        commandLength = strlen(pCommand->pCommand);
+        if (pCommand->pResponsePrefix != NULL) {
+            prefixLength = strlen(pCommand->pResponsePrefix) + 1;
+        }
+        pEntry = (uAtClientCommandAsyncEntry_t *) pUPortMalloc(sizeof(uAtClientCommandAsyncEntry_t) +
+                                                               commandLength + 1 + prefixLength);
+        if (pEntry != NULL) {
+            // Copy the strings into the space following the structure
+            pEntry->command = *pCommand;
+            pDest = ((char *) pEntry) + sizeof(uAtClientCommandAsyncEntry_t);
+            memcpy(pDest, pCommand->pCommand, commandLength + 1);
+            pEntry->command.pCommand = pDest;
+            if (pCommand->pResponsePrefix != NULL) {
+                pDest += commandLength + 1;
+                memcpy(pDest, pCommand->pResponsePrefix, prefixLength);
+                pEntry->command.pResponsePrefix = pDest;
+            }
+            pEntry->commandLength = commandLength;
+            pEntry->pNext = NULL;
+
+            U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            if (!pClient->commandAsyncSendQueued) {
+                // Nothing is sending the queue, get that going
+                errorCode = uAtClientCallback(atHandle, commandAsyncSendAll, NULL);
+                if (errorCode == 0) {
+                    pClient->commandAsyncSendQueued = true;
+                }
+            }
+            if (errorCode == 0) {
+                if (pClient->pCommandAsyncTail != NULL) {
+                    pClient->pCommandAsyncTail->pNext = pEntry;
+                } else {
+                    pClient->pCommandAsyncHead = pEntry;
+                }
+                pClient->pCommandAsyncTail = pEntry;
+                pClient->commandAsyncPending++;
+            } else {
+                uPortFree(pEntry);
+            }
+
+            U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+        }
+    }
+
+    return errorCode;
+}
+
+// Get the number of asynchronous AT commands not yet completed.
+int32_t uAtClientCommandAsyncGetPending(uAtClientHandle_t atHandle)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    int32_t pending;
+
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    pending = (int32_t) pClient->commandAsyncPending;
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+
+    return pending;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: HANDLE UNSOLICITED RESPONSES
  * -------------------------------------------------------------- */
@@ -4055,6 +4896,7 @@ int32_t uAtClientSetUrcHandler(uAtClientHandle_t atHandle,
 
         pUrc->pNext = pClient->pUrcList;
         pClient->pUrcList = pUrc;
+        urcTrieRebuild(pClient);
 
         U_PORT_MUTEX_UNLOCK(pClient->urcPermittedMutex);
     }
@@ -4086,6 +4928,7 @@ void uAtClientRemoveUrcHandler(uAtClientHandle_t atHandle,
             } else {
                 pClient->pUrcList = pCurrent->pNext;
             }
+            urcTrieRebuild(pClient);
 
             U_PORT_MUTEX_UNLOCK(pClient->urcPermittedMutex);
 
@@ -4284,6 +5127,203 @@ int32_t uAtClientUrcDirect(uAtClientHandle_t atHandle,
     return errorCode;
 }
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: STATISTICS
+ * -------------------------------------------------------------- */
+
+// Start keeping statistics.
+int32_t uAtClientStatsStart(uAtClientHandle_t atHandle)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+
+    // Lock the stream also, since the statistics are
+    // updated by URC processing
+    U_PORT_MUTEX_LOCK(pClient->streamMutex);
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    if (pClient->pStats == NULL) {
+        pClient->pStats = (uAtClientStats_t *) pUPortMalloc(sizeof(uAtClientStats_t));
+    }
+    if (pClient->pStats != NULL) {
+        memset(pClient->pStats, 0, sizeof(*(pClient->pStats)));
+        pClient->pStats->current = -1;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+    U_PORT_MUTEX_UNLOCK(pClient->streamMutex);
+
+    return errorCode;
+}
+
+// Stop keeping statistics.
+void uAtClientStatsStop(uAtClientHandle_t atHandle)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+
+    U_PORT_MUTEX_LOCK(pClient->streamMutex);
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    uPortFree(pClient->pStats);
+    pClient->pStats = NULL;
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+    U_PORT_MUTEX_UNLOCK(pClient->streamMutex);
+}
+
+// Get the statistics for an AT command.
+int32_t uAtClientStatsCommandGet(uAtClientHandle_t atHandle, size_t index,
+                                 uAtClientStatsCommand_t *pStats)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    if (pStats != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
+        if ((pClient->pStats != NULL) && (index < pClient->pStats->numCommands)) {
+            *pStats = pClient->pStats->command[index];
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+
+    return errorCode;
+}
+
+// Get the statistics for URCs.
+int32_t uAtClientStatsUrcGet(uAtClientHandle_t atHandle,
+                             uAtClientStatsUrc_t *pStats)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    if (pStats != NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+        if (pClient->pStats != NULL) {
+            *pStats = pClient->pStats->urc;
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+    }
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+
+    return errorCode;
+}
+
+// Estimate a latency percentile from the histogram.
+int32_t uAtClientStatsLatencyPercentileMs(const uAtClientStatsCommand_t *pStats,
+                                          int32_t percentile)
+{
+    int32_t errorCodeOrLatencyMs = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uint32_t numLatencies = 0;
+    uint32_t target;
+    uint32_t total = 0;
+    size_t bucket = 0;
+
+    if ((pStats != NULL) && (percentile > 0) && (percentile <= 100)) {
+        for (size_t x = 0; x < U_AT_CLIENT_STATS_HISTOGRAM_NUM_BUCKETS; x++) {
+            numLatencies += pStats->latencyHistogram[x];
+        }
+        errorCodeOrLatencyMs = 0;
+        if (numLatencies > 0) {
+            // The number of latencies at or below the percentile,
+            // rounded up
+            target = (uint32_t) ((((uint64_t) numLatencies) * percentile + 99) / 100);
+            total = pStats->latencyHistogram[0];
+            while ((total < target) && (bucket < U_AT_CLIENT_STATS_HISTOGRAM_NUM_BUCKETS - 1)) {
+                bucket++;
+                total += pStats->latencyHistogram[bucket];
+            }
+            // The upper limit of bucket n is (2^n) - 1
+            errorCodeOrLatencyMs = (int32_t) ((1UL << bucket) - 1);
+            if ((errorCodeOrLatencyMs > pStats->latencyMaxMs) ||
+                (bucket == U_AT_CLIENT_STATS_HISTOGRAM_NUM_BUCKETS - 1)) {
+                errorCodeOrLatencyMs = pStats->latencyMaxMs;
+            }
+        }
+    }
+
+    return errorCodeOrLatencyMs;
+}
+
+// Write the statistics as CSV.
+int32_t uAtClientStatsCsv(uAtClientHandle_t atHandle,
+                          char *pBuffer, size_t bufferSize)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const uAtClientStatsCommand_t *pCommand;
+    uint32_t numLatencies;
+    size_t length = 0;
+
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    if ((pBuffer != NULL) || (bufferSize == 0)) {
+        errorCodeOrLength = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+        if (pClient->pStats != NULL) {
+            length = statsPrint(pBuffer, bufferSize, length,
+                                "command,count,timeouts,min_ms,avg_ms,p99_ms,max_ms,"
+                                "total_ms,bytes_out,bytes_in\n");
+            for (size_t x = 0; x < pClient->pStats->numCommands; x++) {
+                pCommand = &(pClient->pStats->command[x]);
+                numLatencies = 0;
+                for (size_t y = 0; y < U_AT_CLIENT_STATS_HISTOGRAM_NUM_BUCKETS; y++) {
+                    numLatencies += pCommand->latencyHistogram[y];
+                }
+                length = statsPrint(pBuffer, bufferSize, length,
+                                    "%s,%u,%u,%d,%u,%d,%d,%u,%u,%u\n",
+                                    pCommand->command, (unsigned) pCommand->count,
+                                    (unsigned) pCommand->numTimeouts,
+                                    (int) pCommand->latencyMinMs,
+                                    (unsigned) ((numLatencies > 0) ?
+                                                pCommand->latencyTotalMs / numLatencies : 0),
+                                    (int) uAtClientStatsLatencyPercentileMs(pCommand, 99),
+                                    (int) pCommand->latencyMaxMs,
+                                    (unsigned) pCommand->latencyTotalMs,
+                                    (unsigned) pCommand->bytesOut,
+                                    (unsigned) pCommand->bytesIn);
+            }
+            length = statsPrint(pBuffer, bufferSize, length,
+                                "URC,%u,,,%u,,,%u,,\n",
+                                (unsigned) pClient->pStats->urc.count,
+                                (unsigned) ((pClient->pStats->urc.count > 0) ?
+                                            pClient->pStats->urc.timeMs /
+                                            pClient->pStats->urc.count : 0),
+                                (unsigned) pClient->pStats->urc.timeMs);
+            errorCodeOrLength = (int32_t) length;
+        }
+    }
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+
+    return errorCodeOrLength;
+}
+
+// Get the transmit statistics.
+int32_t uAtClientTransmitStatsGet(uAtClientHandle_t atHandle,
+                                  uAtClientTransmitStats_t *pStats)
+{
+    uAtClientInstance_t *pClient = (uAtClientInstance_t *) atHandle;
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
+
+    if (pStats != NULL) {
+        *pStats = pClient->transmitStats;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    U_AT_CLIENT_UNLOCK_CLIENT_MUTEX(pClient);
+
+    return errorCode;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: MISC
  * -------------------------------------------------------------- */
@@ -4393,6 +5433,9 @@ void uAtClientStreamInterceptTx(uAtClientHandle_t atHandle,
 
     U_AT_CLIENT_LOCK_CLIENT_MUTEX(pClient);
 
+    // The transmit buffer is not used with an intercept
+    // function so empty it first
+    transmitFlush(pClient);
     pClient->pInterceptTx = pCallback;
     pClient->pInterceptTxContext = pContext;
 
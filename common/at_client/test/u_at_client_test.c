@@ -58,6 +58,8 @@
 #include "u_test_util_resource_check.h"
 
 #include "u_timeout.h"
+#include "u_interface.h"
+#include "u_device_serial.h"
 #include "u_at_client.h"
 #include "u_at_client_test.h"
 #include "u_at_client_test_data.h"
@@ -137,6 +139,52 @@
  * we need room for initial and trailing line endings. */
 #define U_AT_CLIENT_TEST_AT_BUFFER_LENGTH_BYTES (256 + 4 + U_AT_CLIENT_BUFFER_OVERHEAD_BYTES)
 
+#ifndef U_AT_CLIENT_TEST_URC_STORM_NUM_HANDLERS
+/** The number of URC handlers to register for the URC storm test;
+ * of the order of what a cellular module registers.
+ */
+# define U_AT_CLIENT_TEST_URC_STORM_NUM_HANDLERS 32
+#endif
+
+#ifndef U_AT_CLIENT_TEST_URC_STORM_NUM_URCS
+/** The number of URCs to send in the URC storm test.
+ */
+# define U_AT_CLIENT_TEST_URC_STORM_NUM_URCS 2000
+#endif
+
+/** The prefix format used for the URCs of the URC storm test,
+ * the parameter being the handler index.
+ */
+#define U_AT_CLIENT_TEST_URC_STORM_PREFIX_FORMAT "+UTEST%02d:"
+
+/** The number of AT commands to send in each part of the
+ * asynchronous AT command test.
+ */
+#define U_AT_CLIENT_TEST_COMMAND_ASYNC_NUM_COMMANDS 4
+
+/** Guard time waiting for asynchronous AT commands to complete.
+ */
+#define U_AT_CLIENT_TEST_COMMAND_ASYNC_GUARD_TIME_MS 5000
+
+/** The fixed inter-command delay to use in the delay test.
+ */
+#define U_AT_CLIENT_TEST_DELAY_MS 20
+
+/** The number of AT commands to send in the delay test.
+ */
+#define U_AT_CLIENT_TEST_DELAY_NUM_COMMANDS 5
+
+/** The length of the binary payload the minimal AT server of
+ * the asynchronous AT command test returns for "AT+BIN".
+ */
+#define U_AT_CLIENT_TEST_BINARY_LENGTH_BYTES 1024
+
+/** The URC timeout to use in the URC storm test: short so that
+ * the wait for more data at the end of the storm does not
+ * swamp the timing.
+ */
+#define U_AT_CLIENT_TEST_URC_STORM_TIMEOUT_MS 10
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -153,6 +201,45 @@ typedef struct {
     int32_t responseLastError;
 } uAtClientTestCheckCommandResponse_t;
 
+/** Context for the virtual serial device used by the URC storm
+ * test: it generates the URCs of the storm as they are read.
+ */
+typedef struct {
+    size_t numUrcs; /** The number of URCs generated so far. */
+    char line[32];  /** The URC currently being read. */
+    size_t lineLength; /** The length of the URC in line. */
+    size_t lineOffset; /** The amount of line that has been read. */
+    bool inCallback; /** True while the event callback is being called. */
+    void (*pEventCallback)(struct uDeviceSerial_t *, uint32_t, void *);
+    void *pEventCallbackParam;
+} uAtClientTestUrcStormContext_t;
+
+/** Context for the virtual serial device used by the asynchronous
+ * AT command test: a minimal AT server which responds to each
+ * command "+X", concatenated or not, with "+X: n", where n counts
+ * the commands received, except that "+FAIL" gets "ERROR",
+ * "+SILENT" gets nothing at all and "+BIN" gets "+BIN: n,"
+ * followed by n bytes of binary, n being
+ * U_AT_CLIENT_TEST_BINARY_LENGTH_BYTES.
+ */
+typedef struct {
+    char command[U_AT_CLIENT_COMMAND_ASYNC_LINE_MAX_LENGTH_BYTES + 2];
+    size_t commandLength; /** The length of the command line so far. */
+    char response[U_AT_CLIENT_TEST_SERVER_RESPONSE_LENGTH];
+    size_t responseLength; /** The length of the response in response. */
+    size_t responseOffset; /** The amount of response that has been read. */
+    int32_t numCommands; /** The number of commands received. */
+    int32_t numLines; /** The number of command lines received. */
+} uAtClientTestCommandAsyncContext_t;
+
+/** Storage for the outcome of an asynchronous AT command.
+ */
+typedef struct {
+    int32_t value; /** The integer read from the response. */
+    int32_t errorCode; /** The error code passed to the completion callback. */
+    bool complete; /** True when the completion callback has been called. */
+} uAtClientTestCommandAsyncResult_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -184,10 +271,425 @@ static const char *gpInterceptTxDataLast = NULL;
 # endif
 #endif
 
+/** The number of times each handler was called in the URC storm test.
+ */
+static int32_t gUrcStormCount[U_AT_CLIENT_TEST_URC_STORM_NUM_HANDLERS];
+
+/** The number of URCs in the URC storm test which arrived at a
+ * handler with the wrong parameter.
+ */
+static int32_t gUrcStormBadParameterCount;
+
+/** The outcomes of the asynchronous AT commands.
+ */
+static uAtClientTestCommandAsyncResult_t gCommandAsyncResult[U_AT_CLIENT_TEST_COMMAND_ASYNC_NUM_COMMANDS];
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Get the number of bytes waiting in the URC storm serial device.
+static int32_t urcStormGetReceiveSize(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uAtClientTestUrcStormContext_t *pContext = (uAtClientTestUrcStormContext_t *)
+                                               pUInterfaceContext(pDeviceSerial);
+    int32_t receiveSize = (int32_t) (pContext->lineLength - pContext->lineOffset);
+
+    if ((receiveSize == 0) &&
+        (pContext->numUrcs < U_AT_CLIENT_TEST_URC_STORM_NUM_URCS)) {
+        // There is always another URC until the storm is over
+        receiveSize = 1;
+    }
+
+    return receiveSize;
+}
+
+// Read from the URC storm serial device, generating URCs as we go;
+// each URC carries as its parameter the index of its handler.
+static int32_t urcStormRead(struct uDeviceSerial_t *pDeviceSerial,
+                            void *pBuffer, size_t sizeBytes)
+{
+    uAtClientTestUrcStormContext_t *pContext = (uAtClientTestUrcStormContext_t *)
+                                               pUInterfaceContext(pDeviceSerial);
+    char *pData = (char *) pBuffer;
+    size_t readLength = 0;
+    size_t length;
+    int32_t handlerIndex;
+
+    while (readLength < sizeBytes) {
+        if (pContext->lineOffset >= pContext->lineLength) {
+            if (pContext->numUrcs >= U_AT_CLIENT_TEST_URC_STORM_NUM_URCS) {
+                break;
+            }
+            // Spread the URCs across the handlers, not in order
+            handlerIndex = (int32_t) ((pContext->numUrcs * 7) %
+                                      U_AT_CLIENT_TEST_URC_STORM_NUM_HANDLERS);
+            pContext->lineLength = snprintf(pContext->line, sizeof(pContext->line),
+                                            "\r\n" U_AT_CLIENT_TEST_URC_STORM_PREFIX_FORMAT
+                                            " %d\r\n", (int) handlerIndex, (int) handlerIndex);
+            pContext->lineOffset = 0;
+            pContext->numUrcs++;
+        }
+        length = pContext->lineLength - pContext->lineOffset;
+        if (length > sizeBytes - readLength) {
+            length = sizeBytes - readLength;
+        }
+        memcpy(pData + readLength, pContext->line + pContext->lineOffset, length);
+        pContext->lineOffset += length;
+        readLength += length;
+    }
+
+    return (int32_t) readLength;
+}
+
+// Write to the URC storm serial device: nothing is listening.
+static int32_t urcStormWrite(struct uDeviceSerial_t *pDeviceSerial,
+                             const void *pBuffer, size_t sizeBytes)
+{
+    (void) pDeviceSerial;
+    (void) pBuffer;
+    return (int32_t) sizeBytes;
+}
+
+// Set the event callback of the URC storm serial device; the
+// callback is not called asynchronously, the test calls it.
+static int32_t urcStormEventCallbackSet(struct uDeviceSerial_t *pDeviceSerial,
+                                        uint32_t filter,
+                                        void (*pFunction)(struct uDeviceSerial_t *,
+                                                          uint32_t,
+                                                          void *),
+                                        void *pParam,
+                                        size_t stackSizeBytes,
+                                        int32_t priority)
+{
+    uAtClientTestUrcStormContext_t *pContext = (uAtClientTestUrcStormContext_t *)
+                                               pUInterfaceContext(pDeviceSerial);
+    (void) filter;
+    (void) stackSizeBytes;
+    (void) priority;
+
+    pContext->pEventCallback = pFunction;
+    pContext->pEventCallbackParam = pParam;
+
+    return 0;
+}
+
+// Remove the event callback of the URC storm serial device.
+static void urcStormEventCallbackRemove(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uAtClientTestUrcStormContext_t *pContext = (uAtClientTestUrcStormContext_t *)
+                                               pUInterfaceContext(pDeviceSerial);
+
+    pContext->pEventCallback = NULL;
+    pContext->pEventCallbackParam = NULL;
+}
+
+// Sending events is not supported by the URC storm serial device.
+static int32_t urcStormEventSend(struct uDeviceSerial_t *pDeviceSerial,
+                                 uint32_t eventBitMap)
+{
+    (void) pDeviceSerial;
+    (void) eventBitMap;
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+// Sending events is not supported by the URC storm serial device.
+static int32_t urcStormEventTrySend(struct uDeviceSerial_t *pDeviceSerial,
+                                    uint32_t eventBitMap, int32_t delayMs)
+{
+    (void) pDeviceSerial;
+    (void) eventBitMap;
+    (void) delayMs;
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+// Determine whether we are in the event callback of the URC
+// storm serial device.
+static bool urcStormEventIsCallback(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uAtClientTestUrcStormContext_t *pContext = (uAtClientTestUrcStormContext_t *)
+                                               pUInterfaceContext(pDeviceSerial);
+
+    return pContext->inCallback;
+}
+
+// There is no event task for the URC storm serial device.
+static int32_t urcStormEventStackMinFree(struct uDeviceSerial_t *pDeviceSerial)
+{
+    (void) pDeviceSerial;
+    return (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+}
+
+// Populate the vector table of the URC storm serial device.
+static void urcStormSerialInit(struct uDeviceSerial_t *pDeviceSerial)
+{
+    pDeviceSerial->getReceiveSize = urcStormGetReceiveSize;
+    pDeviceSerial->read = urcStormRead;
+    pDeviceSerial->write = urcStormWrite;
+    pDeviceSerial->eventCallbackSet = urcStormEventCallbackSet;
+    pDeviceSerial->eventCallbackRemove = urcStormEventCallbackRemove;
+    pDeviceSerial->eventSend = urcStormEventSend;
+    pDeviceSerial->eventTrySend = urcStormEventTrySend;
+    pDeviceSerial->eventIsCallback = urcStormEventIsCallback;
+    pDeviceSerial->eventStackMinFree = urcStormEventStackMinFree;
+}
+
+// Get the number of bytes of response waiting in the asynchronous
+// AT command test serial device.
+static int32_t commandAsyncGetReceiveSize(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uAtClientTestCommandAsyncContext_t *pContext = (uAtClientTestCommandAsyncContext_t *)
+                                                   pUInterfaceContext(pDeviceSerial);
+
+    return (int32_t) (pContext->responseLength - pContext->responseOffset);
+}
+
+// Read a response from the asynchronous AT command test serial device.
+static int32_t commandAsyncRead(struct uDeviceSerial_t *pDeviceSerial,
+                                void *pBuffer, size_t sizeBytes)
+{
+    uAtClientTestCommandAsyncContext_t *pContext = (uAtClientTestCommandAsyncContext_t *)
+                                                   pUInterfaceContext(pDeviceSerial);
+    size_t length = pContext->responseLength - pContext->responseOffset;
+
+    if (length > sizeBytes) {
+        length = sizeBytes;
+    }
+    memcpy(pBuffer, pContext->response + pContext->responseOffset, length);
+    pContext->responseOffset += length;
+
+    return (int32_t) length;
+}
+
+// Return byte n of the binary payload of the asynchronous AT
+// command test serial device.
+static uint8_t binaryByte(size_t n)
+{
+    static const char okString[] = "\r\nOK\r\n";
+
+    if ((n % 256) < sizeof(okString) - 1) {
+        return (uint8_t) okString[n % 256];
+    }
+
+    return (uint8_t) n;
+}
+
+// Write to the asynchronous AT command test serial device, responding
+// when a whole command line has been received.
+static int32_t commandAsyncWrite(struct uDeviceSerial_t *pDeviceSerial,
+                                 const void *pBuffer, size_t sizeBytes)
+{
+    uAtClientTestCommandAsyncContext_t *pContext = (uAtClientTestCommandAsyncContext_t *)
+                                                   pUInterfaceContext(pDeviceSerial);
+    const char *pData = (const char *) pBuffer;
+    char *pCommand;
+    char *pNext;
+    size_t length;
+    bool failed = false;
+
+    for (size_t x = 0; x < sizeBytes; x++) {
+        if (pData[x] != '\r') {
+            if (pContext->commandLength < sizeof(pContext->command) - 1) {
+                pContext->command[pContext->commandLength] = pData[x];
+                pContext->commandLength++;
+            }
+        } else {
+            pContext->command[pContext->commandLength] = 0;
+            pContext->commandLength = 0;
+            pContext->numLines++;
+            // Responses are always read completely before the next
+            // command is sent so we can start at the beginning
+            pContext->responseLength = 0;
+            pContext->responseOffset = 0;
+            // Skip the "AT" and respond to each command
+            pCommand = pContext->command + 2;
+            while ((pCommand != NULL) && !failed) {
+                pNext = strchr(pCommand, ';');
+                if (pNext != NULL) {
+                    *pNext = 0;
+                    pNext++;
+                }
+                length = sizeof(pContext->response) - pContext->responseLength;
+                if (strcmp(pCommand, "+SILENT") == 0) {
+                    // Pretend we weren't listening
+                    failed = true;
+                } else if (strcmp(pCommand, "+BIN") == 0) {
+                    pContext->responseLength += snprintf(pContext->response +
+                                                         pContext->responseLength,
+                                                         length, "\r\n+BIN: %d,",
+                                                         U_AT_CLIENT_TEST_BINARY_LENGTH_BYTES);
+                    // Binary with the odd "\r\nOK\r\n" in it for good measure
+                    for (size_t y = 0; (y < U_AT_CLIENT_TEST_BINARY_LENGTH_BYTES) &&
+                         (pContext->responseLength < sizeof(pContext->response)); y++) {
+                        pContext->response[pContext->responseLength] = (char) binaryByte(y);
+                        pContext->responseLength++;
+                    }
+                    pContext->responseLength += snprintf(pContext->response +
+                                                         pContext->responseLength,
+                                                         sizeof(pContext->response) -
+                                                         pContext->responseLength, "\r\n");
+                } else if (strcmp(pCommand, "+FAIL") == 0) {
+                    pContext->responseLength += snprintf(pContext->response +
+                                                         pContext->responseLength,
+                                                         length, "\r\nERROR\r\n");
+                    failed = true;
+                } else {
+                    pContext->responseLength += snprintf(pContext->response +
+                                                         pContext->responseLength,
+                                                         length, "\r\n%s: %d\r\n",
+                                                         pCommand, (int) pContext->numCommands);
+                }
+                pContext->numCommands++;
+                pCommand = pNext;
+            }
+            if (!failed) {
+                // "OK" ends the response
+                pContext->responseLength += snprintf(pContext->response +
+                                                     pContext->responseLength,
+                                                     sizeof(pContext->response) -
+                                                     pContext->responseLength,
+                                                     "\r\nOK\r\n");
+            }
+        }
+    }
+
+    return (int32_t) sizeBytes;
+}
+
+// The asynchronous AT command test serial device never calls
+// an event callback.
+static int32_t commandAsyncEventCallbackSet(struct uDeviceSerial_t *pDeviceSerial,
+                                            uint32_t filter,
+                                            void (*pFunction)(struct uDeviceSerial_t *,
+                                                              uint32_t,
+                                                              void *),
+                                            void *pParam,
+                                            size_t stackSizeBytes,
+                                            int32_t priority)
+{
+    (void) pDeviceSerial;
+    (void) filter;
+    (void) pFunction;
+    (void) pParam;
+    (void) stackSizeBytes;
+    (void) priority;
+    return 0;
+}
+
+// The asynchronous AT command test serial device never calls
+// an event callback.
+static void commandAsyncEventCallbackRemove(struct uDeviceSerial_t *pDeviceSerial)
+{
+    (void) pDeviceSerial;
+}
+
+// The asynchronous AT command test serial device never calls
+// an event callback.
+static bool commandAsyncEventIsCallback(struct uDeviceSerial_t *pDeviceSerial)
+{
+    (void) pDeviceSerial;
+    return false;
+}
+
+// Populate the vector table of the asynchronous AT command test
+// serial device.
+static void commandAsyncSerialInit(struct uDeviceSerial_t *pDeviceSerial)
+{
+    pDeviceSerial->getReceiveSize = commandAsyncGetReceiveSize;
+    pDeviceSerial->read = commandAsyncRead;
+    pDeviceSerial->write = commandAsyncWrite;
+    pDeviceSerial->eventCallbackSet = commandAsyncEventCallbackSet;
+    pDeviceSerial->eventCallbackRemove = commandAsyncEventCallbackRemove;
+    pDeviceSerial->eventSend = urcStormEventSend;
+    pDeviceSerial->eventTrySend = urcStormEventTrySend;
+    pDeviceSerial->eventIsCallback = commandAsyncEventIsCallback;
+    pDeviceSerial->eventStackMinFree = urcStormEventStackMinFree;
+}
+
+// Send a command synchronously, reading a "+TEST:" response if
+// there is one, and return the error code.
+static int32_t commandSend(uAtClientHandle_t atClientHandle, const char *pCommand)
+{
+    uAtClientLock(atClientHandle);
+    uAtClientCommandStart(atClientHandle, pCommand);
+    uAtClientCommandStop(atClientHandle);
+    uAtClientResponseStart(atClientHandle, "+TEST:");
+    uAtClientReadInt(atClientHandle);
+    uAtClientResponseStop(atClientHandle);
+    return uAtClientUnlock(atClientHandle);
+}
+
+// Response callback for the asynchronous AT command test.
+static void commandAsyncResponse(uAtClientHandle_t atClientHandle, void *pParam)
+{
+    ((uAtClientTestCommandAsyncResult_t *) pParam)->value = uAtClientReadInt(atClientHandle);
+}
+
+// Completion callback for the asynchronous AT command test.
+static void commandAsyncComplete(uAtClientHandle_t atClientHandle,
+                                 int32_t errorCode, void *pParam)
+{
+    uAtClientTestCommandAsyncResult_t *pResult = (uAtClientTestCommandAsyncResult_t *) pParam;
+
+    (void) atClientHandle;
+
+    pResult->errorCode = errorCode;
+    pResult->complete = true;
+}
+
+// Submit U_AT_CLIENT_TEST_COMMAND_ASYNC_NUM_COMMANDS asynchronous AT
+// commands, the one at failIndex (if in range) being "AT+FAIL",
+// with the AT client locked so that they are queued together,
+// and wait for them to complete; returns the number completed.
+static int32_t commandAsyncRun(uAtClientHandle_t atClientHandle,
+                               bool concatenate, size_t failIndex)
+{
+    uAtClientCommandAsync_t command = {0};
+    int32_t numComplete = 0;
+    int32_t startTimeMs;
+
+    memset(gCommandAsyncResult, 0, sizeof(gCommandAsyncResult));
+    command.pResponsePrefix = "+TEST:";
+    command.pResponse = commandAsyncResponse;
+    command.pComplete = commandAsyncComplete;
+    command.concatenate = concatenate;
+    uAtClientLock(atClientHandle);
+    for (size_t x = 0; x < U_AT_CLIENT_TEST_COMMAND_ASYNC_NUM_COMMANDS; x++) {
+        command.pCommand = (x == failIndex) ? "AT+FAIL" : "AT+TEST";
+        command.pParam = &(gCommandAsyncResult[x]);
+        gCommandAsyncResult[x].value = -1;
+        U_PORT_TEST_ASSERT(uAtClientCommandAsync(atClientHandle, &command) == 0);
+    }
+    U_PORT_TEST_ASSERT(uAtClientCommandAsyncGetPending(atClientHandle) ==
+                       U_AT_CLIENT_TEST_COMMAND_ASYNC_NUM_COMMANDS);
+    uAtClientUnlock(atClientHandle);
+
+    startTimeMs = uPortGetTickTimeMs();
+    while ((uAtClientCommandAsyncGetPending(atClientHandle) > 0) &&
+           (uPortGetTickTimeMs() - startTimeMs < U_AT_CLIENT_TEST_COMMAND_ASYNC_GUARD_TIME_MS)) {
+        uPortTaskBlock(10);
+    }
+    for (size_t x = 0; x < U_AT_CLIENT_TEST_COMMAND_ASYNC_NUM_COMMANDS; x++) {
+        if (gCommandAsyncResult[x].complete) {
+            numComplete++;
+        }
+    }
+
+    return numComplete;
+}
+
+// URC handler for the URC storm test: the parameter of the URC
+// should be the index of the handler.
+static void urcStormHandler(uAtClientHandle_t atClientHandle, void *pParameters)
+{
+    int32_t *pCount = (int32_t *) pParameters;
+
+    if (uAtClientReadInt(atClientHandle) != (int32_t) (pCount - gUrcStormCount)) {
+        gUrcStormBadParameterCount++;
+    }
+    (*pCount)++;
+}
+
 #if (U_CFG_TEST_UART_A >= 0)
 
 // AT consecutive timeout callback, used by some of the tests below
@@ -1729,6 +2231,601 @@ U_PORT_TEST_FUNCTION("[atClient]", "atClientCommandSet2")
 # endif
 #endif
 
+/** Register a realistic number of URC handlers on an AT client
+ * and throw a storm of URCs at it, using a virtual serial device
+ * which needs no UART; the time taken is printed for information,
+ * only the correctness of the dispatch is checked.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientUrcStorm")
+{
+    int32_t resourceCount;
+    uDeviceSerial_t *pDeviceSerial;
+    uAtClientTestUrcStormContext_t *pContext;
+    uAtClientStreamHandle_t stream = U_AT_CLIENT_STREAM_HANDLE_DEFAULTS;
+    uAtClientHandle_t atClientHandle;
+    char prefix[16];
+    int32_t startTimeMs;
+    int32_t durationMs;
+    int32_t total = 0;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    memset(gUrcStormCount, 0, sizeof(gUrcStormCount));
+    gUrcStormBadParameterCount = 0;
+
+    pDeviceSerial = pUDeviceSerialCreate(urcStormSerialInit,
+                                         sizeof(uAtClientTestUrcStormContext_t));
+    U_PORT_TEST_ASSERT(pDeviceSerial != NULL);
+    pContext = (uAtClientTestUrcStormContext_t *) pUInterfaceContext(pDeviceSerial);
+
+    stream.type = U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL;
+    stream.handle.pDeviceSerial = pDeviceSerial;
+    atClientHandle = uAtClientAddExt(&stream, NULL, U_AT_CLIENT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    U_PORT_TEST_ASSERT(pContext->pEventCallback != NULL);
+    // No need to wait for more data to turn up: it is always there
+    uAtClientReadRetryDelaySet(atClientHandle, 0);
+    uAtClientTimeoutUrcSet(atClientHandle, U_AT_CLIENT_TEST_URC_STORM_TIMEOUT_MS);
+
+    for (size_t x = 0; x < U_AT_CLIENT_TEST_URC_STORM_NUM_HANDLERS; x++) {
+        snprintf(prefix, sizeof(prefix), U_AT_CLIENT_TEST_URC_STORM_PREFIX_FORMAT, (int) x);
+        U_PORT_TEST_ASSERT(uAtClientSetUrcHandler(atClientHandle, prefix,
+                                                  urcStormHandler,
+                                                  &(gUrcStormCount[x])) == 0);
+    }
+
+    U_TEST_PRINT_LINE("sending %d URCs to %d URC handlers...",
+                      U_AT_CLIENT_TEST_URC_STORM_NUM_URCS,
+                      U_AT_CLIENT_TEST_URC_STORM_NUM_HANDLERS);
+    startTimeMs = uPortGetTickTimeMs();
+    // Call the event callback, as the serial device would if it
+    // were real, until the storm has been consumed
+    for (size_t x = 0; (x < U_AT_CLIENT_TEST_URC_STORM_NUM_URCS) &&
+         (urcStormGetReceiveSize(pDeviceSerial) > 0); x++) {
+        pContext->inCallback = true;
+        pContext->pEventCallback(pDeviceSerial,
+                                 U_DEVICE_SERIAL_EVENT_BITMASK_DATA_RECEIVED,
+                                 pContext->pEventCallbackParam);
+        pContext->inCallback = false;
+    }
+    durationMs = uPortGetTickTimeMs() - startTimeMs;
+
+    for (size_t x = 0; x < U_AT_CLIENT_TEST_URC_STORM_NUM_HANDLERS; x++) {
+        total += gUrcStormCount[x];
+    }
+    U_TEST_PRINT_LINE("%d URC(s) handled in %d ms, %d with a bad parameter.",
+                      total, durationMs, gUrcStormBadParameterCount);
+    U_PORT_TEST_ASSERT(total == U_AT_CLIENT_TEST_URC_STORM_NUM_URCS);
+    U_PORT_TEST_ASSERT(gUrcStormBadParameterCount == 0);
+    for (size_t x = 0; x < U_AT_CLIENT_TEST_URC_STORM_NUM_HANDLERS; x++) {
+        U_PORT_TEST_ASSERT(gUrcStormCount[x] > 0);
+    }
+
+    // Remove half of the handlers, which rebuilds the URC index, and
+    // check that the remaining ones are still found
+    for (size_t x = 0; x < U_AT_CLIENT_TEST_URC_STORM_NUM_HANDLERS; x += 2) {
+        snprintf(prefix, sizeof(prefix), U_AT_CLIENT_TEST_URC_STORM_PREFIX_FORMAT, (int) x);
+        uAtClientRemoveUrcHandler(atClientHandle, prefix);
+    }
+    memset(gUrcStormCount, 0, sizeof(gUrcStormCount));
+    memset(pContext->line, 0, sizeof(pContext->line));
+    pContext->lineLength = 0;
+    pContext->lineOffset = 0;
+    pContext->numUrcs = 0;
+    for (size_t x = 0; (x < U_AT_CLIENT_TEST_URC_STORM_NUM_URCS) &&
+         (urcStormGetReceiveSize(pDeviceSerial) > 0); x++) {
+        pContext->inCallback = true;
+        pContext->pEventCallback(pDeviceSerial,
+                                 U_DEVICE_SERIAL_EVENT_BITMASK_DATA_RECEIVED,
+                                 pContext->pEventCallbackParam);
+        pContext->inCallback = false;
+    }
+    U_PORT_TEST_ASSERT(gUrcStormBadParameterCount == 0);
+    for (size_t x = 0; x < U_AT_CLIENT_TEST_URC_STORM_NUM_HANDLERS; x++) {
+        if ((x & 1) == 0) {
+            U_PORT_TEST_ASSERT(gUrcStormCount[x] == 0);
+        } else {
+            U_PORT_TEST_ASSERT(gUrcStormCount[x] > 0);
+        }
+    }
+
+    uAtClientRemove(atClientHandle);
+    uDeviceSerialDelete(pDeviceSerial);
+    uAtClientDeinit();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Send AT commands asynchronously, singly and concatenated, to a
+ * minimal AT server on a virtual serial device which needs no UART.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientCommandAsync")
+{
+    int32_t resourceCount;
+    uDeviceSerial_t *pDeviceSerial;
+    uAtClientTestCommandAsyncContext_t *pContext;
+    uAtClientStreamHandle_t stream = U_AT_CLIENT_STREAM_HANDLE_DEFAULTS;
+    uAtClientHandle_t atClientHandle;
+    uAtClientCommandAsync_t command = {0};
+    int32_t numLines;
+    int32_t numCommands;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    pDeviceSerial = pUDeviceSerialCreate(commandAsyncSerialInit,
+                                         sizeof(uAtClientTestCommandAsyncContext_t));
+    U_PORT_TEST_ASSERT(pDeviceSerial != NULL);
+    pContext = (uAtClientTestCommandAsyncContext_t *) pUInterfaceContext(pDeviceSerial);
+
+    stream.type = U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL;
+    stream.handle.pDeviceSerial = pDeviceSerial;
+    atClientHandle = uAtClientAddExt(&stream, NULL, U_AT_CLIENT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    uAtClientTimeoutSet(atClientHandle, U_AT_CLIENT_TEST_AT_TIMEOUT_MS);
+
+    // Bad parameters
+    U_PORT_TEST_ASSERT(uAtClientCommandAsync(atClientHandle, NULL) < 0);
+    U_PORT_TEST_ASSERT(uAtClientCommandAsync(atClientHandle, &command) < 0);
+    command.pCommand = "ATI";
+    command.concatenate = true;
+    U_PORT_TEST_ASSERT(uAtClientCommandAsync(atClientHandle, &command) < 0);
+    U_PORT_TEST_ASSERT(uAtClientCommandAsyncGetPending(atClientHandle) == 0);
+
+    U_TEST_PRINT_LINE("sending %d AT commands asynchronously, one at a time...",
+                      U_AT_CLIENT_TEST_COMMAND_ASYNC_NUM_COMMANDS);
+    U_PORT_TEST_ASSERT(commandAsyncRun(atClientHandle, false, SIZE_MAX) ==
+                       U_AT_CLIENT_TEST_COMMAND_ASYNC_NUM_COMMANDS);
+    U_PORT_TEST_ASSERT(pContext->numLines == U_AT_CLIENT_TEST_COMMAND_ASYNC_NUM_COMMANDS);
+    for (size_t x = 0; x < U_AT_CLIENT_TEST_COMMAND_ASYNC_NUM_COMMANDS; x++) {
+        U_PORT_TEST_ASSERT(gCommandAsyncResult[x].errorCode == 0);
+        U_PORT_TEST_ASSERT(gCommandAsyncResult[x].value == (int32_t) x);
+    }
+
+    U_TEST_PRINT_LINE("sending %d AT commands asynchronously, concatenated...",
+                      U_AT_CLIENT_TEST_COMMAND_ASYNC_NUM_COMMANDS);
+    numLines = pContext->numLines;
+    numCommands = pContext->numCommands;
+    U_PORT_TEST_ASSERT(commandAsyncRun(atClientHandle, true, SIZE_MAX) ==
+                       U_AT_CLIENT_TEST_COMMAND_ASYNC_NUM_COMMANDS);
+    U_PORT_TEST_ASSERT(pContext->numLines == numLines + 1);
+    for (size_t x = 0; x < U_AT_CLIENT_TEST_COMMAND_ASYNC_NUM_COMMANDS; x++) {
+        U_PORT_TEST_ASSERT(gCommandAsyncResult[x].errorCode == 0);
+        U_PORT_TEST_ASSERT(gCommandAsyncResult[x].value == numCommands + (int32_t) x);
+    }
+
+    U_TEST_PRINT_LINE("sending %d AT commands asynchronously, concatenated, one failing...",
+                      U_AT_CLIENT_TEST_COMMAND_ASYNC_NUM_COMMANDS);
+    numLines = pContext->numLines;
+    U_PORT_TEST_ASSERT(commandAsyncRun(atClientHandle, true, 1) ==
+                       U_AT_CLIENT_TEST_COMMAND_ASYNC_NUM_COMMANDS);
+    U_PORT_TEST_ASSERT(pContext->numLines == numLines + 1);
+    for (size_t x = 0; x < U_AT_CLIENT_TEST_COMMAND_ASYNC_NUM_COMMANDS; x++) {
+        U_PORT_TEST_ASSERT(gCommandAsyncResult[x].errorCode < 0);
+    }
+
+    // The AT client must still be usable synchronously
+    U_PORT_TEST_ASSERT(commandSend(atClientHandle, "AT+TEST") == 0);
+
+    uAtClientRemove(atClientHandle);
+    uDeviceSerialDelete(pDeviceSerial);
+    uAtClientDeinit();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Check the inter-command delay, fixed and adaptive, using the
+ * same minimal AT server as the asynchronous AT command test.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientDelay")
+{
+    int32_t resourceCount;
+    uDeviceSerial_t *pDeviceSerial;
+    uAtClientStreamHandle_t stream = U_AT_CLIENT_STREAM_HANDLE_DEFAULTS;
+    uAtClientHandle_t atClientHandle;
+    int64_t delayTotalMs;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    pDeviceSerial = pUDeviceSerialCreate(commandAsyncSerialInit,
+                                         sizeof(uAtClientTestCommandAsyncContext_t));
+    U_PORT_TEST_ASSERT(pDeviceSerial != NULL);
+    stream.type = U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL;
+    stream.handle.pDeviceSerial = pDeviceSerial;
+    atClientHandle = uAtClientAddExt(&stream, NULL, U_AT_CLIENT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    uAtClientTimeoutSet(atClientHandle, U_AT_CLIENT_TEST_AT_TIMEOUT_TOLERANCE_MS);
+    uAtClientReadRetryDelaySet(atClientHandle, 0);
+
+    // Fixed delay: each command after the first must wait for it
+    U_PORT_TEST_ASSERT(uAtClientDelayAdaptiveGet(atClientHandle) < 0);
+    uAtClientDelaySet(atClientHandle, U_AT_CLIENT_TEST_DELAY_MS);
+    U_PORT_TEST_ASSERT(commandSend(atClientHandle, "AT+TEST") == 0);
+    delayTotalMs = uAtClientDelayTotalGet(atClientHandle);
+    for (size_t x = 0; x < U_AT_CLIENT_TEST_DELAY_NUM_COMMANDS; x++) {
+        U_PORT_TEST_ASSERT(commandSend(atClientHandle, "AT+TEST") == 0);
+    }
+    delayTotalMs = uAtClientDelayTotalGet(atClientHandle) - delayTotalMs;
+    U_TEST_PRINT_LINE("%d command(s) with a fixed delay of %d ms spent %d ms in delays.",
+                      U_AT_CLIENT_TEST_DELAY_NUM_COMMANDS, U_AT_CLIENT_TEST_DELAY_MS,
+                      (int32_t) delayTotalMs);
+    U_PORT_TEST_ASSERT(delayTotalMs >= (U_AT_CLIENT_TEST_DELAY_MS - 1) *
+                       U_AT_CLIENT_TEST_DELAY_NUM_COMMANDS);
+    U_PORT_TEST_ASSERT(delayTotalMs <= (U_AT_CLIENT_TEST_DELAY_MS *
+                                        U_AT_CLIENT_TEST_DELAY_NUM_COMMANDS) +
+                       U_AT_CLIENT_TEST_AT_TIMEOUT_TOLERANCE_MS);
+
+    // Adaptive delay: starts at the minimum, backs off on
+    // a timeout and recovers when all is well again
+    uAtClientDelayAdaptiveSet(atClientHandle, 0);
+    U_PORT_TEST_ASSERT(uAtClientDelayAdaptiveGet(atClientHandle) == 0);
+    U_PORT_TEST_ASSERT(commandSend(atClientHandle, "AT+TEST") == 0);
+    U_PORT_TEST_ASSERT(uAtClientDelayAdaptiveGet(atClientHandle) == 0);
+    U_PORT_TEST_ASSERT(commandSend(atClientHandle, "AT+SILENT") < 0);
+    U_TEST_PRINT_LINE("adaptive delay after a timeout is %d ms.",
+                      uAtClientDelayAdaptiveGet(atClientHandle));
+    U_PORT_TEST_ASSERT(uAtClientDelayAdaptiveGet(atClientHandle) > 0);
+    U_PORT_TEST_ASSERT(uAtClientDelayAdaptiveGet(atClientHandle) <= U_AT_CLIENT_TEST_DELAY_MS);
+    for (size_t x = 0; (x < U_AT_CLIENT_TEST_DELAY_NUM_COMMANDS * 100) &&
+         (uAtClientDelayAdaptiveGet(atClientHandle) > 0); x++) {
+        U_PORT_TEST_ASSERT(commandSend(atClientHandle, "AT+TEST") == 0);
+    }
+    U_PORT_TEST_ASSERT(uAtClientDelayAdaptiveGet(atClientHandle) == 0);
+    uAtClientDelayAdaptiveSet(atClientHandle, -1);
+    U_PORT_TEST_ASSERT(uAtClientDelayAdaptiveGet(atClientHandle) < 0);
+
+    uAtClientRemove(atClientHandle);
+    uDeviceSerialDelete(pDeviceSerial);
+    uAtClientDeinit();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Check the per-command statistics, using the same minimal AT
+ * server as the asynchronous AT command test.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientStats")
+{
+    int32_t resourceCount;
+    uDeviceSerial_t *pDeviceSerial;
+    uAtClientStreamHandle_t stream = U_AT_CLIENT_STREAM_HANDLE_DEFAULTS;
+    uAtClientHandle_t atClientHandle;
+    uAtClientStatsCommand_t statsCommand;
+    uAtClientStatsUrc_t statsUrc;
+    int32_t percentileMs;
+    int32_t length;
+    char *pBuffer;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    pDeviceSerial = pUDeviceSerialCreate(commandAsyncSerialInit,
+                                         sizeof(uAtClientTestCommandAsyncContext_t));
+    U_PORT_TEST_ASSERT(pDeviceSerial != NULL);
+    stream.type = U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL;
+    stream.handle.pDeviceSerial = pDeviceSerial;
+    atClientHandle = uAtClientAddExt(&stream, NULL, U_AT_CLIENT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    uAtClientTimeoutSet(atClientHandle, U_AT_CLIENT_TEST_AT_TIMEOUT_TOLERANCE_MS);
+    uAtClientReadRetryDelaySet(atClientHandle, 0);
+
+    // Nothing is available until statistics are started
+    U_PORT_TEST_ASSERT(uAtClientStatsCommandGet(atClientHandle, 0, &statsCommand) < 0);
+    U_PORT_TEST_ASSERT(uAtClientStatsUrcGet(atClientHandle, &statsUrc) < 0);
+    U_PORT_TEST_ASSERT(uAtClientStatsStart(atClientHandle) == 0);
+
+    for (size_t x = 0; x < U_AT_CLIENT_TEST_DELAY_NUM_COMMANDS; x++) {
+        U_PORT_TEST_ASSERT(commandSend(atClientHandle, "AT+TEST") == 0);
+    }
+    // The response to this has no "+TEST:" prefix so the outcome
+    // doesn't matter, only that it is counted separately
+    commandSend(atClientHandle, "AT+OTHER=1");
+    U_PORT_TEST_ASSERT(commandSend(atClientHandle, "AT+SILENT") < 0);
+
+    // Commands are listed in the order they were first sent
+    U_PORT_TEST_ASSERT(uAtClientStatsCommandGet(atClientHandle, 0, &statsCommand) == 0);
+    U_TEST_PRINT_LINE("\"%s\": %d command(s), latency %d to %d ms, %d byte(s) out,"
+                      " %d byte(s) in.", statsCommand.command, (int32_t) statsCommand.count,
+                      statsCommand.latencyMinMs, statsCommand.latencyMaxMs,
+                      (int32_t) statsCommand.bytesOut, (int32_t) statsCommand.bytesIn);
+    U_PORT_TEST_ASSERT(strcmp(statsCommand.command, "AT+TEST") == 0);
+    U_PORT_TEST_ASSERT(statsCommand.count == U_AT_CLIENT_TEST_DELAY_NUM_COMMANDS);
+    U_PORT_TEST_ASSERT(statsCommand.numTimeouts == 0);
+    U_PORT_TEST_ASSERT(statsCommand.latencyMinMs >= 0);
+    U_PORT_TEST_ASSERT(statsCommand.latencyMaxMs >= statsCommand.latencyMinMs);
+    U_PORT_TEST_ASSERT(statsCommand.bytesOut >= U_AT_CLIENT_TEST_DELAY_NUM_COMMANDS *
+                       (sizeof("AT+TEST\r") - 1));
+    U_PORT_TEST_ASSERT(statsCommand.bytesIn > 0);
+    percentileMs = uAtClientStatsLatencyPercentileMs(&statsCommand, 99);
+    U_PORT_TEST_ASSERT(percentileMs >= 0);
+    U_PORT_TEST_ASSERT(percentileMs <= statsCommand.latencyMaxMs);
+    U_PORT_TEST_ASSERT(uAtClientStatsCommandGet(atClientHandle, 1, &statsCommand) == 0);
+    U_PORT_TEST_ASSERT(strcmp(statsCommand.command, "AT+OTHER") == 0);
+    U_PORT_TEST_ASSERT(statsCommand.count == 1);
+    U_PORT_TEST_ASSERT(uAtClientStatsCommandGet(atClientHandle, 2, &statsCommand) == 0);
+    U_PORT_TEST_ASSERT(strcmp(statsCommand.command, "AT+SILENT") == 0);
+    U_PORT_TEST_ASSERT(statsCommand.count == 1);
+    U_PORT_TEST_ASSERT(statsCommand.numTimeouts == 1);
+    U_PORT_TEST_ASSERT(uAtClientStatsCommandGet(atClientHandle, 3,
+                                                &statsCommand) == (int32_t) U_ERROR_COMMON_NOT_FOUND);
+    U_PORT_TEST_ASSERT(uAtClientStatsUrcGet(atClientHandle, &statsUrc) == 0);
+    U_PORT_TEST_ASSERT(statsUrc.count == 0);
+
+    // Size the CSV output, then print it
+    length = uAtClientStatsCsv(atClientHandle, NULL, 0);
+    U_PORT_TEST_ASSERT(length > 0);
+    pBuffer = (char *) pUPortMalloc(length + 1);
+    U_PORT_TEST_ASSERT(pBuffer != NULL);
+    U_PORT_TEST_ASSERT(uAtClientStatsCsv(atClientHandle, pBuffer, length + 1) == length);
+    U_PORT_TEST_ASSERT((int32_t) strlen(pBuffer) == length);
+    U_PORT_TEST_ASSERT(strncmp(pBuffer, "command,", 8) == 0);
+    uPortLog("%s", pBuffer);
+    // A short buffer must be truncated but still terminated
+    U_PORT_TEST_ASSERT(uAtClientStatsCsv(atClientHandle, pBuffer, 10) == length);
+    U_PORT_TEST_ASSERT(strlen(pBuffer) == 9);
+    uPortFree(pBuffer);
+
+    uAtClientStatsStop(atClientHandle);
+    U_PORT_TEST_ASSERT(uAtClientStatsCommandGet(atClientHandle, 0, &statsCommand) < 0);
+
+    uAtClientRemove(atClientHandle);
+    uDeviceSerialDelete(pDeviceSerial);
+    uAtClientDeinit();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Check binary reads, both through the receive buffer and
+ * directly from the stream, and changing the size of the receive
+ * buffer, using the same minimal AT server as the asynchronous AT
+ * command test.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientReadBytes")
+{
+    int32_t resourceCount;
+    uDeviceSerial_t *pDeviceSerial;
+    uAtClientStreamHandle_t stream = U_AT_CLIENT_STREAM_HANDLE_DEFAULTS;
+    uAtClientHandle_t atClientHandle;
+    char *pBuffer;
+    int32_t length;
+    int32_t startTimeMs;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    pDeviceSerial = pUDeviceSerialCreate(commandAsyncSerialInit,
+                                         sizeof(uAtClientTestCommandAsyncContext_t));
+    U_PORT_TEST_ASSERT(pDeviceSerial != NULL);
+    stream.type = U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL;
+    stream.handle.pDeviceSerial = pDeviceSerial;
+    atClientHandle = uAtClientAddExt(&stream, NULL, U_AT_CLIENT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    U_PORT_TEST_ASSERT(uAtClientReceiveBufferSizeGet(atClientHandle) ==
+                       U_AT_CLIENT_BUFFER_LENGTH_BYTES);
+    uAtClientReadRetryDelaySet(atClientHandle, 0);
+    uAtClientDelaySet(atClientHandle, 0);
+    pBuffer = (char *) pUPortMalloc(U_AT_CLIENT_TEST_BINARY_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(pBuffer != NULL);
+
+    // Do it four ways: through the receive buffer and directly,
+    // each with the small receive buffer and then a large one
+    for (size_t x = 0; x < 4; x++) {
+        if (x == 2) {
+            U_PORT_TEST_ASSERT(uAtClientReceiveBufferSizeSet(atClientHandle,
+                                                             U_AT_CLIENT_BUFFER_OVERHEAD_BYTES +
+                                                             U_AT_CLIENT_TEST_BINARY_LENGTH_BYTES * 2) == 0);
+            U_PORT_TEST_ASSERT(uAtClientReceiveBufferSizeGet(atClientHandle) ==
+                               U_AT_CLIENT_BUFFER_OVERHEAD_BYTES +
+                               U_AT_CLIENT_TEST_BINARY_LENGTH_BYTES * 2);
+        }
+        memset(pBuffer, 0, U_AT_CLIENT_TEST_BINARY_LENGTH_BYTES);
+        startTimeMs = uPortGetTickTimeMs();
+        uAtClientLock(atClientHandle);
+        uAtClientCommandStart(atClientHandle, "AT+BIN");
+        uAtClientCommandStop(atClientHandle);
+        uAtClientResponseStart(atClientHandle, "+BIN:");
+        U_PORT_TEST_ASSERT(uAtClientReadInt(atClientHandle) == U_AT_CLIENT_TEST_BINARY_LENGTH_BYTES);
+        uAtClientIgnoreStopTag(atClientHandle);
+        if ((x % 2) == 0) {
+            length = uAtClientReadBytes(atClientHandle, pBuffer,
+                                        U_AT_CLIENT_TEST_BINARY_LENGTH_BYTES, true);
+        } else {
+            length = uAtClientReadBytesDirect(atClientHandle, pBuffer,
+                                              U_AT_CLIENT_TEST_BINARY_LENGTH_BYTES);
+        }
+        uAtClientRestoreStopTag(atClientHandle);
+        uAtClientResponseStop(atClientHandle);
+        U_PORT_TEST_ASSERT(uAtClientUnlock(atClientHandle) == 0);
+        U_TEST_PRINT_LINE("%s read of %d byte(s) with a %d byte receive buffer took %d ms.",
+                          ((x % 2) == 0) ? "buffered" : "direct", length,
+                          (int32_t) uAtClientReceiveBufferSizeGet(atClientHandle),
+                          uPortGetTickTimeMs() - startTimeMs);
+        U_PORT_TEST_ASSERT(length == U_AT_CLIENT_TEST_BINARY_LENGTH_BYTES);
+        for (size_t y = 0; y < U_AT_CLIENT_TEST_BINARY_LENGTH_BYTES; y++) {
+            U_PORT_TEST_ASSERT((uint8_t) pBuffer[y] == binaryByte(y));
+        }
+    }
+
+    // Shrink the buffer back down again and check that the
+    // AT client still works; a buffer with no room for data
+    // is not allowed
+    U_PORT_TEST_ASSERT(uAtClientReceiveBufferSizeSet(atClientHandle,
+                                                     U_AT_CLIENT_BUFFER_OVERHEAD_BYTES) < 0);
+    U_PORT_TEST_ASSERT(uAtClientReceiveBufferSizeSet(atClientHandle,
+                                                     U_AT_CLIENT_BUFFER_LENGTH_BYTES) == 0);
+    U_PORT_TEST_ASSERT(uAtClientReceiveBufferSizeGet(atClientHandle) ==
+                       U_AT_CLIENT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(commandSend(atClientHandle, "AT+TEST") == 0);
+
+    uPortFree(pBuffer);
+    uAtClientRemove(atClientHandle);
+    uDeviceSerialDelete(pDeviceSerial);
+    uAtClientDeinit();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Check that the transmit buffer turns an AT command and
+ * its parameters into a single stream write, using the same
+ * minimal AT server as the asynchronous AT command test.
+ */
+U_PORT_TEST_FUNCTION("[atClient]", "atClientTransmit")
+{
+    int32_t resourceCount;
+    uDeviceSerial_t *pDeviceSerial;
+    uAtClientTestCommandAsyncContext_t *pContext;
+    uAtClientStreamHandle_t stream = U_AT_CLIENT_STREAM_HANDLE_DEFAULTS;
+    uAtClientHandle_t atClientHandle;
+    uAtClientTransmitStats_t statsBefore;
+    uAtClientTransmitStats_t statsAfter;
+    char payload[(U_AT_CLIENT_TRANSMIT_BUFFER_LENGTH_BYTES * 2) + 1];
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uAtClientInit() == 0);
+
+    pDeviceSerial = pUDeviceSerialCreate(commandAsyncSerialInit,
+                                         sizeof(uAtClientTestCommandAsyncContext_t));
+    U_PORT_TEST_ASSERT(pDeviceSerial != NULL);
+    pContext = (uAtClientTestCommandAsyncContext_t *) pUInterfaceContext(pDeviceSerial);
+    stream.type = U_AT_CLIENT_STREAM_TYPE_VIRTUAL_SERIAL;
+    stream.handle.pDeviceSerial = pDeviceSerial;
+    atClientHandle = uAtClientAddExt(&stream, NULL, U_AT_CLIENT_BUFFER_LENGTH_BYTES);
+    U_PORT_TEST_ASSERT(atClientHandle != NULL);
+    uAtClientReadRetryDelaySet(atClientHandle, 0);
+    uAtClientDelaySet(atClientHandle, 0);
+    U_PORT_TEST_ASSERT(uAtClientTransmitStatsGet(atClientHandle, NULL) < 0);
+
+    // A command with a few parameters
+    U_PORT_TEST_ASSERT(uAtClientTransmitStatsGet(atClientHandle, &statsBefore) == 0);
+    uAtClientLock(atClientHandle);
+    uAtClientCommandStart(atClientHandle, "AT+TEST=");
+    uAtClientWriteInt(atClientHandle, 1);
+    uAtClientWriteString(atClientHandle, "two", true);
+    uAtClientWriteUint64(atClientHandle, 3);
+    uAtClientCommandStop(atClientHandle);
+    uAtClientResponseStart(atClientHandle, NULL);
+    uAtClientResponseStop(atClientHandle);
+    U_PORT_TEST_ASSERT(uAtClientUnlock(atClientHandle) == 0);
+    U_PORT_TEST_ASSERT(uAtClientTransmitStatsGet(atClientHandle, &statsAfter) == 0);
+    U_TEST_PRINT_LINE("%d write(s) became %d stream write(s).",
+                      (int32_t) (statsAfter.numWrites - statsBefore.numWrites),
+                      (int32_t) (statsAfter.numStreamWrites - statsBefore.numStreamWrites));
+    U_PORT_TEST_ASSERT(pContext->numLines == 1);
+    U_PORT_TEST_ASSERT(statsAfter.bytes - statsBefore.bytes == sizeof("AT+TEST=1,\"two\",3\r") - 1);
+    U_PORT_TEST_ASSERT(statsAfter.numWrites - statsBefore.numWrites > 1);
+#if U_AT_CLIENT_TRANSMIT_BUFFER_LENGTH_BYTES > 0
+    U_PORT_TEST_ASSERT(statsAfter.numStreamWrites - statsBefore.numStreamWrites == 1);
+#endif
+
+    // A command with a payload too large for the transmit buffer,
+    // which should be written directly after the start of the
+    // command (the AT server will just truncate it)
+    memset(payload, 'x', sizeof(payload) - 1);
+    payload[sizeof(payload) - 1] = 0;
+    U_PORT_TEST_ASSERT(uAtClientTransmitStatsGet(atClientHandle, &statsBefore) == 0);
+    uAtClientLock(atClientHandle);
+    uAtClientCommandStart(atClientHandle, "AT+TEST=");
+    U_PORT_TEST_ASSERT(uAtClientWriteBytes(atClientHandle, payload, strlen(payload),
+                                           false) == strlen(payload));
+    uAtClientCommandStop(atClientHandle);
+    uAtClientResponseStart(atClientHandle, NULL);
+    uAtClientResponseStop(atClientHandle);
+    U_PORT_TEST_ASSERT(uAtClientUnlock(atClientHandle) == 0);
+    U_PORT_TEST_ASSERT(uAtClientTransmitStatsGet(atClientHandle, &statsAfter) == 0);
+    U_PORT_TEST_ASSERT(pContext->numLines == 2);
+    U_PORT_TEST_ASSERT(statsAfter.bytes - statsBefore.bytes == strlen("AT+TEST=") +
+                       strlen(payload) + 1);
+#if U_AT_CLIENT_TRANSMIT_BUFFER_LENGTH_BYTES > 0
+    U_PORT_TEST_ASSERT(statsAfter.numStreamWrites - statsBefore.numStreamWrites <= 3);
+#endif
+
+    // A standalone write must go out immediately
+    U_PORT_TEST_ASSERT(uAtClientTransmitStatsGet(atClientHandle, &statsBefore) == 0);
+    uAtClientLock(atClientHandle);
+    U_PORT_TEST_ASSERT(uAtClientWriteBytes(atClientHandle, "AT", 2, true) == 2);
+    U_PORT_TEST_ASSERT(uAtClientTransmitStatsGet(atClientHandle, &statsAfter) == 0);
+    U_PORT_TEST_ASSERT(statsAfter.bytes - statsBefore.bytes == 2);
+    U_PORT_TEST_ASSERT(uAtClientWriteBytes(atClientHandle, "\r", 1, true) == 1);
+    uAtClientResponseStart(atClientHandle, NULL);
+    uAtClientResponseStop(atClientHandle);
+    U_PORT_TEST_ASSERT(uAtClientUnlock(atClientHandle) == 0);
+    U_PORT_TEST_ASSERT(pContext->numLines == 3);
+
+    uAtClientRemove(atClientHandle);
+    uDeviceSerialDelete(pDeviceSerial);
+    uAtClientDeinit();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
@@ -137,6 +137,50 @@ extern "C" {
 # define U_GEOFENCE_HORIZONTAL_SPEED_MILLIMETRES_PER_SECOND_MAX 500000LL
 #endif
 
+#ifndef U_GEOFENCE_INDEX_THRESHOLD_NUM_FENCES
+/** When at least this many geofences are applied to a device a
+ * spatial index of the fences is built (from the square extents
+ * of their shapes, see
+ * #U_GEOFENCE_SQUARE_EXTENT_CHECK_UNCERTAINTY_METRES) so that, when
+ * a position arrives, only the fences near it need to be tested;
+ * the index costs a few bytes of heap per fence.  Below this
+ * number, or if there is not enough memory for the index, every
+ * fence is tested.
+ */
+# define U_GEOFENCE_INDEX_THRESHOLD_NUM_FENCES 16
+#endif
+
+#ifndef U_GEOFENCE_TEST_MANY_TASK_STACK_SIZE_BYTES
+# ifndef U_CFG_GEOFENCE_USE_GEODESIC
+/** The stack size of each of the worker tasks started by
+ * uGeofenceTestManyTasks().
+ */
+#  define U_GEOFENCE_TEST_MANY_TASK_STACK_SIZE_BYTES 2304
+# else
+/** If geodesic position, using GeographicLib, is to be used, then
+ * the worker tasks started by uGeofenceTestManyTasks() need the necessary
+ * slack (see common/geofence/api/u_geofence_geodesic.h for more
+ * information).
+ */
+#  define U_GEOFENCE_TEST_MANY_TASK_STACK_SIZE_BYTES (2304 + (1024 * 5))
+# endif
+#endif
+
+#ifndef U_GEOFENCE_TEST_MANY_TASK_PRIORITY
+/** The priority of the worker tasks started by
+ * uGeofenceTestManyTasks().
+ */
+# define U_GEOFENCE_TEST_MANY_TASK_PRIORITY U_CFG_OS_APP_TASK_PRIORITY
+#endif
+
+#ifndef U_GEOFENCE_TEST_MANY_MAX_NUM_WORKERS
+/** The maximum number of worker tasks that uGeofenceTestManyTasks()
+ * will start; the positions may be shared between this many tasks
+ * plus the calling task.
+ */
+# define U_GEOFENCE_TEST_MANY_MAX_NUM_WORKERS 3
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -203,6 +247,18 @@ typedef enum {
     U_GEOFENCE_POSITION_STATE_OUTSIDE
 } uGeofencePositionState_t;
 
+/** A position, as passed to uGeofenceTestMany(); the fields
+ * have the same meaning as the parameters of the same name
+ * passed to uGeofenceTest().
+ */
+typedef struct {
+    int64_t latitudeX1e9;
+    int64_t longitudeX1e9;
+    int32_t altitudeMillimetres; /**< INT_MIN for a 2D position. */
+    int32_t radiusMillimetres; /**< -1 if not known. */
+    int32_t altitudeUncertaintyMillimetres; /**< -1 if not known. */
+} uGeofencePosition_t;
+
 /** Callback that may be called if a position is inside/outside/transiting
  * a geofence.
  *
@@ -250,7 +306,16 @@ typedef enum {
  *                                       without calculating the distance
  *                                       this will be LLONG_MIN, which should
  *                                       be interpreted as meaning "not
- *                                       calculated".
+ *                                       calculated".  In particular it is
+ *                                       always LLONG_MIN for a fence that
+ *                                       was not tested because the position
+ *                                       is nowhere near it (see
+ *                                       #U_GEOFENCE_INDEX_THRESHOLD_NUM_FENCES)
+ *                                       or because it could not have been
+ *                                       reached at the maximum horizontal
+ *                                       speed since it was last tested; in
+ *                                       both cases positionState will be
+ *                                       #U_GEOFENCE_POSITION_STATE_OUTSIDE.
  * @param[in,out] pCallbackParam         the pCallbackParam pointer that
  *                                       was passed to uGnssFenceSetCallback(),
  *                                       uCellFenceSetCallback() or
@@ -560,11 +625,122 @@ bool uGeofenceTest(uGeofence_t *pFence, uGeofenceTestType_t testType,
                    int32_t radiusMillimetres,
                    int32_t altitudeUncertaintyMillimetres);
 
+/** Test many positions, e.g. a recorded track, against a set of
+ * geofences in one go.  Each position is tested on its own: the
+ * outcome for a position against a fence is exactly that which
+ * uGeofenceTest() would give were the fence fresh, i.e. had it
+ * not been tested before, and the fences are not modified.  The
+ * outcome for a position against the set is
+ * #U_GEOFENCE_POSITION_STATE_INSIDE if it is inside any of the
+ * fences, else #U_GEOFENCE_POSITION_STATE_OUTSIDE if it is
+ * outside any of them, else #U_GEOFENCE_POSITION_STATE_NONE.
+ * Since each position is tested on its own, a transit test is
+ * never met: to find transits, look for changes in the outcomes
+ * from one position to the next.
+ *
+ * @param[in] ppFences              an array of pointers to the
+ *                                  geofences to test against; may
+ *                                  only be NULL if numFences is zero.
+ * @param numFences                 the number of entries in ppFences.
+ * @param testType                  the type of test to perform.
+ * @param pessimisticNotOptimistic  if true then the test is pessimistic
+ *                                  with respect to the radius of position
+ *                                  and the altitude uncertainty, else it
+ *                                  is optimistic; see uGeofenceTest().
+ * @param[in] pPositions            an array of the positions to test; may
+ *                                  only be NULL if numPositions is zero.
+ * @param numPositions              the number of entries in pPositions.
+ * @param[out] pPositionStates      a place to put the outcome for each
+ *                                  position, room for numPositions
+ *                                  entries is required; may only be NULL
+ *                                  if numPositions is zero.
+ * @param[out] pDistanceMillimetres a place to put, for each position,
+ *                                  the shortest horizontal distance to the
+ *                                  edge of any of the fences, in
+ *                                  millimetres, with the same meaning as
+ *                                  the distanceMillimetres parameter of
+ *                                  #uGeofenceCallback_t; room for
+ *                                  numPositions entries is required.
+ *                                  May be NULL.
+ * @return                          on success the number of positions for
+ *                                  which the test is met, else negative
+ *                                  error code.
+ */
+int32_t uGeofenceTestMany(uGeofence_t *const *ppFences, size_t numFences,
+                          uGeofenceTestType_t testType,
+                          bool pessimisticNotOptimistic,
+                          const uGeofencePosition_t *pPositions,
+                          size_t numPositions,
+                          uGeofencePositionState_t *pPositionStates,
+                          int64_t *pDistanceMillimetres);
+
+/** As uGeofenceTestMany() but with the positions shared out between
+ * a number of tasks, for when there are very many positions to
+ * test, e.g. when replaying stored tracks on a multi-core machine.
+ * The calling task takes one share; the others are given to worker
+ * tasks, of stack size #U_GEOFENCE_TEST_MANY_TASK_STACK_SIZE_BYTES
+ * and priority #U_GEOFENCE_TEST_MANY_TASK_PRIORITY, up to
+ * #U_GEOFENCE_TEST_MANY_MAX_NUM_WORKERS of them.  The worker tasks
+ * are started when first needed and then remain, waiting for more
+ * work, until uGeofenceCleanUp() is called.  Should it not be
+ * possible to start a worker task, its share is done by the calling
+ * task.  The outcomes are exactly those of uGeofenceTestMany(),
+ * whatever the number of tasks.
+ *
+ * While the test is carried out the fences are in use, in the
+ * same way as when they are applied to a GNSS, cellular or
+ * Wi-Fi instance: they cannot be changed or free'd.  Other
+ * functions of this API, including another call to this
+ * function, are not held up by it.
+ *
+ * @param[in] ppFences              an array of pointers to the
+ *                                  geofences to test against; may
+ *                                  only be NULL if numFences is zero.
+ * @param numFences                 the number of entries in ppFences.
+ * @param testType                  the type of test to perform.
+ * @param pessimisticNotOptimistic  if true then the test is pessimistic
+ *                                  with respect to the radius of position
+ *                                  and the altitude uncertainty, else it
+ *                                  is optimistic; see uGeofenceTest().
+ * @param[in] pPositions            an array of the positions to test; may
+ *                                  only be NULL if numPositions is zero.
+ * @param numPositions              the number of entries in pPositions.
+ * @param[out] pPositionStates      a place to put the outcome for each
+ *                                  position, room for numPositions
+ *                                  entries is required; may only be NULL
+ *                                  if numPositions is zero.
+ * @param[out] pDistanceMillimetres a place to put, for each position,
+ *                                  the shortest horizontal distance to the
+ *                                  edge of any of the fences; see
+ *                                  uGeofenceTestMany().  May be NULL.
+ * @param numTasks                  the number of tasks to share the
+ *                                  positions between, including the
+ *                                  calling task; must be at least 1,
+ *                                  1 being the same as calling
+ *                                  uGeofenceTestMany().  Usually there is
+ *                                  no point in this being more than the
+ *                                  number of cores available; no more
+ *                                  than #U_GEOFENCE_TEST_MANY_MAX_NUM_WORKERS
+ *                                  plus one will be used.
+ * @return                          on success the number of positions for
+ *                                  which the test is met, else negative
+ *                                  error code.
+ */
+int32_t uGeofenceTestManyTasks(uGeofence_t *const *ppFences, size_t numFences,
+                               uGeofenceTestType_t testType,
+                               bool pessimisticNotOptimistic,
+                               const uGeofencePosition_t *pPositions,
+                               size_t numPositions,
+                               uGeofencePositionState_t *pPositionStates,
+                               int64_t *pDistanceMillimetres,
+                               size_t numTasks);
+
 /** When any function of the Geofence API is called it will ensure that
  * a mutex, used for thread-safety, has been created.  This mutex is
  * not intended to be free'd, ever.  However, if you are quite
  * finished with the Geofence API, no fence is in use etc. you may
- * call this function to free the mutex and get that memory back.
+ * call this function to free the mutex and get that memory back;
+ * this also stops any worker tasks started by uGeofenceTestManyTasks().
  * There is no harm in calling a Geofence API function again after
  * this, it will simply recreate the mutex.
  */
@@ -114,6 +114,14 @@
  * pDynamic parameter, along with the timestamp and the maximum
  * speed.
  *
+ * Within a geofence context, where the maximum speed is known, the
+ * distance that the position was outside each fence when it was last
+ * tested is also kept: if that distance, less the distance that could
+ * have been travelled since, is still more than the radius of position
+ * then the position cannot have reached the fence and testing its
+ * shapes is skipped; only fences that the position may be close to are
+ * tested.
+ *
  * Summarizing:
  * - if radius of position > 100 m and previous distance/speed
  *   from geofence is known, see if the whole geofence can be
@@ -142,6 +150,8 @@
 # include "math.h"     // sqrt(), cos(), etc.
 #endif
 
+#include "u_cfg_os_platform_specific.h"
+
 #include "u_compiler.h"    // For U_WEAK, U_INLINE
 
 #include "u_error_common.h"
@@ -191,6 +201,34 @@
  */
 #define U_GEOFENCE_MAX_SQUARE_EXTENT_HALF_DIAGONAL_METRES 10000000LL
 
+#ifndef U_GEOFENCE_POLYGON_MIN_MAX_NUM_VERTICES
+/** The number of vertices that room is made for when a polygon
+ * is first created; the room is doubled each time it is used up
+ * and any spare is given back when the fence is applied.
+ */
+# define U_GEOFENCE_POLYGON_MIN_MAX_NUM_VERTICES 8
+#endif
+
+/** The number of arrays of doubles in a uGeofencePolygon_t.
+ */
+#define U_GEOFENCE_POLYGON_NUM_ARRAYS 4
+
+#ifndef U_GEOFENCE_POLYGON_BLOCK_NUM_SIDES
+/** The number of sides of a polygon that testPolygonXY() works on
+ * at a time; this sets the size of two arrays on the stack, one
+ * of doubles and one of bools.
+ */
+# define U_GEOFENCE_POLYGON_BLOCK_NUM_SIDES 16
+#endif
+
+#ifndef U_GEOFENCE_INDEX_FENCE_CELLS_MAX
+/** The maximum number of cells of the spatial index of a context
+ * that a fence may cover; a fence that is bigger than this is not
+ * put in the grid but tested against every position instead.
+ */
+# define U_GEOFENCE_INDEX_FENCE_CELLS_MAX 16
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -225,18 +263,97 @@ typedef struct {
     double radiusMetres;
 } uGeofenceCircle_t;
 
+/** Structure to hold a polygon: the vertices are stored as arrays
+ * of latitude and longitude, rather than as a list, so that testing
+ * a position against a polygon runs through contiguous memory, and
+ * alongside them are the things about each side that testPolygon()
+ * would otherwise work out afresh for each position.  Side n
+ * is the one that ends at vertex n, hence side zero is the one that
+ * closes the polygon, from the last vertex back to the first.
+ * Allocated by polygonResize(), which puts the structure and all
+ * of the arrays in one block.
+ */
+typedef struct {
+    size_t numVertices;
+    size_t maxNumVertices; /**< the number of vertices there is room for. */
+    double *pLatitude;
+    double *pLongitude;
+    double *pSideLatitudeMax; /**< the greater latitude of the two ends of each side. */
+    double *pSideSlope; /**< the change in latitude per degree of longitude
+                             along each side, for flat X/Y maths. */
+} uGeofencePolygon_t;
+
 /** Structure to hold a shape.
  */
 typedef struct {
     uGeofenceShapeType_t type;
     union {
         uGeofenceCircle_t *pCircle;
-        uLinkedList_t *pPolygon; /**< a linked list containing uGeofenceCoordinates_t. */
+        uGeofencePolygon_t *pPolygon;
     } u;
     uGeofenceSquare_t squareExtent; /**< the square extent of the shape. */
     bool wgs84Required; /**< true if the shape is so big as to require WGS84 handling. */
 } uGeofenceShape_t;
 
+/** A spatial index of the fences of a context: a uniform grid
+ * of cells in latitude/longitude, each cell listing, in order,
+ * the positions in the list of fences of the context of those
+ * fences which have a square extent that overlaps the cell, plus
+ * a list of the fences that cannot be put in the grid and so
+ * must always be tested.  Populated by pIndexCreate(), which
+ * allocates the structure and all of the arrays in one go.
+ */
+typedef struct {
+    uGeofenceSquare_t grid; /**< the square extent of the whole grid. */
+    double cellHeightDegrees;
+    double cellWidthDegrees;
+    size_t numRows;
+    size_t numColumns;
+    size_t numAlways;
+    size_t *pAlways; /**< the positions of the fences that must always be tested. */
+    size_t *pCellStart; /**< for each cell, the start of its entries in
+                             pCellFence, plus one on the end. */
+    size_t *pCellFence; /**< the positions of the fences in each cell. */
+} uGeofenceIndex_t;
+
+/** Used to walk the fences that the spatial index says must be
+ * tested against a position: the always-tested list and the
+ * list for the cell that the position is in.
+ */
+typedef struct {
+    const size_t *pNext[2];
+    const size_t *pEnd[2];
+} uGeofenceIndexCursor_t;
+
+/** A share of the work of uGeofenceTestManyTasks(): the pointers
+ * to the positions and outcomes are those of the start of the
+ * share.
+ */
+typedef struct {
+    uGeofence_t *const *ppFences;
+    size_t numFences;
+    uGeofenceTestType_t testType;
+    bool pessimisticNotOptimistic;
+    const uGeofencePosition_t *pPositions;
+    size_t numPositions;
+    uGeofencePositionState_t *pPositionStates;
+    int64_t *pDistanceMillimetres;
+    uPortSemaphoreHandle_t doneSemaphore; /**< given by a worker task
+                                               when it has done its
+                                               share. */
+} uGeofenceTestManyShare_t;
+
+/** A semaphore that uGeofenceTestManyTasks() waits on for the worker
+ * tasks to do their shares; these are kept in a list and re-used,
+ * only being deleted by uGeofenceCleanUp(), after the worker tasks
+ * have exited, so that a semaphore can never be deleted while a
+ * worker task is giving it.
+ */
+typedef struct {
+    uPortSemaphoreHandle_t semaphoreHandle;
+    bool inUse;
+} uGeofenceTestManySemaphore_t;
+
 #endif // U_CFG_GEOFENCE
 
 /* ----------------------------------------------------------------
@@ -249,6 +366,29 @@ typedef struct {
  */
 static uPortMutexHandle_t gMutex = NULL;
 
+/** Queue of pointers to uGeofenceTestManyShare_t, read by the
+ * worker tasks of uGeofenceTestManyTasks(); a NULL pointer tells
+ * a worker task to exit.
+ */
+static uPortQueueHandle_t gTestManyQueue = NULL;
+
+/** The number of worker tasks reading gTestManyQueue.
+ */
+static size_t gTestManyNumWorkers = 0;
+
+/** The number of tasks that the last call to uGeofenceTestManyTasks()
+ * shared its work between, for uGeofenceTestManyTasksGetNumTasks().
+ */
+static size_t gTestManyNumTasksLast = 0;
+
+/** Given by each worker task of uGeofenceTestManyTasks() as it exits.
+ */
+static uPortSemaphoreHandle_t gTestManyExitSemaphore = NULL;
+
+/** List of uGeofenceTestManySemaphore_t.
+ */
+static uLinkedList_t *gpTestManySemaphoreList = NULL;
+
 #endif // U_CFG_GEOFENCE
 
 /* ----------------------------------------------------------------
@@ -288,25 +428,6 @@ static int32_t fenceNotInUse(uGeofence_t *pFence)
     return errorCode;
 }
 
-// Clear the map data contained in a polygon.
-static void fenceClearMapDataPolygon(uLinkedList_t **ppPolygon)
-{
-    uLinkedList_t *pList;
-    uLinkedList_t *pListNext;
-    void *pVertex;
-
-    if (ppPolygon != NULL) {
-        pList = *ppPolygon;
-        while (pList != NULL) {
-            pVertex = pList->p;
-            pListNext = pList->pNext;
-            uLinkedListRemove(ppPolygon, pVertex);
-            uPortFree(pVertex);
-            pList = pListNext;
-        }
-    }
-}
-
 // Clear the map data contained in a fence.
 static void fenceClearMapData(uGeofence_t *pFence)
 {
@@ -325,7 +446,7 @@ static void fenceClearMapData(uGeofence_t *pFence)
                         uPortFree(pShape->u.pCircle);
                         break;
                     case U_GEOFENCE_SHAPE_TYPE_POLYGON:
-                        fenceClearMapDataPolygon(&(pShape->u.pPolygon));
+                        uPortFree(pShape->u.pPolygon);
                         break;
                     default:
                         break;
@@ -842,6 +963,50 @@ static bool latitudeOfIntersection(const uGeofenceCoordinates_t *pA,
     return success;
 }
 
+// The shortest distance from a point to a line segment in metres,
+// assuming that the earth is flat.
+static U_INLINE double distanceToSegmentXY(double aLatitude, double aLongitude,
+                                           double bLatitude, double bLongitude,
+                                           double pointLatitude, double pointLongitude,
+                                           double metresPerDegreeLongitude)
+{
+    // Note: there is an implementation of this, using pure X/Y,
+    // over in u_geofence_geodesic.cpp in
+    // uGeofenceWgs84DistanceToSegment()
+    double xDeltaPoint =  longitudeSubtract(pointLongitude,
+                                            aLongitude) * metresPerDegreeLongitude;
+    double yDeltaPoint = (pointLatitude - aLatitude) * U_GEOFENCE_METRES_PER_DEGREE_LATITUDE;
+    double xDeltaLine = longitudeSubtract(bLongitude, aLongitude) * metresPerDegreeLongitude;
+    double yDeltaLine = (bLatitude - aLatitude) * U_GEOFENCE_METRES_PER_DEGREE_LATITUDE;
+    // dot represents the proportion of the distance along the line
+    // that the "normal" projection of our point lands
+    double dot = (xDeltaPoint * xDeltaLine) + (yDeltaPoint * yDeltaLine);
+    double lineLengthSquared = (xDeltaLine * xDeltaLine) + (yDeltaLine * yDeltaLine);
+    // param is a normalised version of dot, range 0 to 1
+    double param = dot / lineLengthSquared;
+
+    double longitude;
+    double latitude;
+    if (param < 0) {
+        // Param is out of range, with A beyond our point, so use A
+        longitude = aLongitude;
+        latitude = aLatitude;
+    } else if (param > 1) {
+        // Param is out of range, with B beyond our point, so use B
+        longitude = bLongitude;
+        latitude = bLatitude;
+    } else {
+        // In range, just grab the coordinates of where the normal
+        // from the line is
+        longitude = aLongitude + (param * xDeltaLine / metresPerDegreeLongitude);
+        latitude = aLatitude + (param * yDeltaLine / U_GEOFENCE_METRES_PER_DEGREE_LATITUDE);
+    }
+    double xDelta = longitudeSubtract(pointLongitude, longitude) * metresPerDegreeLongitude;
+    double yDelta = (pointLatitude - latitude) * U_GEOFENCE_METRES_PER_DEGREE_LATITUDE;
+
+    return sqrt((xDelta * xDelta) + (yDelta * yDelta));
+}
+
 // The shortest distance from a point to a line segment in metres;
 // WGS84, spherical or XY, calling the above as appropriate.
 static double distanceToSegment(const uGeofenceCoordinates_t *pA,
@@ -866,40 +1031,10 @@ static double distanceToSegment(const uGeofenceCoordinates_t *pA,
             distanceMetres = distanceToSegmentSpherical(pA, pB, pPoint);
         }
     } else {
-        // Note: there is an implementation of this, using pure X/Y,
-        // over in u_geofence_geodesic.cpp in
-        // uGeofenceWgs84DistanceToSegment()
-        double xDeltaPoint =  longitudeSubtract(pPoint->longitude,
-                                                pA->longitude) * metresPerDegreeLongitude;
-        double yDeltaPoint = (pPoint->latitude - pA->latitude) * U_GEOFENCE_METRES_PER_DEGREE_LATITUDE;
-        double xDeltaLine = longitudeSubtract(pB->longitude, pA->longitude) * metresPerDegreeLongitude;
-        double yDeltaLine = (pB->latitude - pA->latitude) * U_GEOFENCE_METRES_PER_DEGREE_LATITUDE;
-        // dot represents the proportion of the distance along the line
-        // that the "normal" projection of our point lands
-        double dot = (xDeltaPoint * xDeltaLine) + (yDeltaPoint * yDeltaLine);
-        double lineLengthSquared = (xDeltaLine * xDeltaLine) + (yDeltaLine * yDeltaLine);
-        // param is a normalised version of dot, range 0 to 1
-        double param = dot / lineLengthSquared;
-
-        double longitude;
-        double latitude;
-        if (param < 0) {
-            // Param is out of range, with A beyond our point, so use A
-            longitude = pA->longitude;
-            latitude = pA->latitude;
-        } else if (param > 1) {
-            // Param is out of range, with B beyond our point, so use B
-            longitude = pB->longitude;
-            latitude = pB->latitude;
-        } else {
-            // In range, just grab the coordinates of where the normal
-            // from the line is
-            longitude = pA->longitude + (param * xDeltaLine / metresPerDegreeLongitude);
-            latitude = pA->latitude + (param * yDeltaLine / U_GEOFENCE_METRES_PER_DEGREE_LATITUDE);
-        }
-        double xDelta = longitudeSubtract(pPoint->longitude, longitude) * metresPerDegreeLongitude;
-        double yDelta = (pPoint->latitude - latitude) * U_GEOFENCE_METRES_PER_DEGREE_LATITUDE;
-        distanceMetres = sqrt((xDelta * xDelta) + (yDelta * yDelta));
+        distanceMetres = distanceToSegmentXY(pA->latitude, pA->longitude,
+                                             pB->latitude, pB->longitude,
+                                             pPoint->latitude, pPoint->longitude,
+                                             metresPerDegreeLongitude);
     }
 
     return distanceMetres;
@@ -913,6 +1048,153 @@ static double distanceToSegment(const uGeofenceCoordinates_t *pA,
 
 #ifdef U_CFG_GEOFENCE
 
+// Move a polygon, which may be NULL, into a new block with room for
+// the given number of vertices, returning false if there is not
+// enough memory, in which case the polygon is left as it was.
+static bool polygonResize(uGeofencePolygon_t **ppPolygon,
+                          size_t maxNumVertices)
+{
+    uGeofencePolygon_t *pPolygon = *ppPolygon;
+    uGeofencePolygon_t *pResized;
+    size_t numVertices = 0;
+
+    pResized = (uGeofencePolygon_t *) pUPortMalloc(sizeof(*pResized) +
+                                                   (maxNumVertices * sizeof(double) *
+                                                    U_GEOFENCE_POLYGON_NUM_ARRAYS));
+    if (pResized != NULL) {
+        pResized->maxNumVertices = maxNumVertices;
+        pResized->pLatitude = (double *) (pResized + 1);
+        pResized->pLongitude = pResized->pLatitude + maxNumVertices;
+        pResized->pSideLatitudeMax = pResized->pLongitude + maxNumVertices;
+        pResized->pSideSlope = pResized->pSideLatitudeMax + maxNumVertices;
+        if (pPolygon != NULL) {
+            numVertices = pPolygon->numVertices;
+            memcpy(pResized->pLatitude, pPolygon->pLatitude,
+                   numVertices * sizeof(double));
+            memcpy(pResized->pLongitude, pPolygon->pLongitude,
+                   numVertices * sizeof(double));
+            memcpy(pResized->pSideLatitudeMax, pPolygon->pSideLatitudeMax,
+                   numVertices * sizeof(double));
+            memcpy(pResized->pSideSlope, pPolygon->pSideSlope,
+                   numVertices * sizeof(double));
+            uPortFree(pPolygon);
+        }
+        pResized->numVertices = numVertices;
+        *ppPolygon = pResized;
+    }
+
+    return (pResized != NULL);
+}
+
+// Work out the things that are stored for a side of a polygon.
+static void polygonSideSet(uGeofencePolygon_t *pPolygon, size_t side)
+{
+    size_t start = pPolygon->numVertices - 1;
+    double *pLatitude = pPolygon->pLatitude;
+    double *pLongitude = pPolygon->pLongitude;
+
+    if (side > 0) {
+        start = side - 1;
+    }
+    pPolygon->pSideLatitudeMax[side] = pLatitude[start];
+    if (pLatitude[side] > pLatitude[start]) {
+        pPolygon->pSideLatitudeMax[side] = pLatitude[side];
+    }
+    // This must be calculated in exactly the same way as
+    // latitudeOfIntersection() calculates it
+    pPolygon->pSideSlope[side] = (pLatitude[side] - pLatitude[start]) /
+                                 longitudeSubtract(pLongitude[side], pLongitude[start]);
+}
+
+// Add a vertex to a polygon, which may be NULL, making room for
+// it if required; returns false if there is not enough memory,
+// in which case the polygon is left as it was.
+static bool polygonAddVertex(uGeofencePolygon_t **ppPolygon,
+                             double latitude, double longitude)
+{
+    bool success = true;
+    uGeofencePolygon_t *pPolygon = *ppPolygon;
+    size_t maxNumVertices = U_GEOFENCE_POLYGON_MIN_MAX_NUM_VERTICES;
+
+    if ((pPolygon == NULL) || (pPolygon->numVertices >= pPolygon->maxNumVertices)) {
+        if ((pPolygon != NULL) && (pPolygon->maxNumVertices * 2 > maxNumVertices)) {
+            maxNumVertices = pPolygon->maxNumVertices * 2;
+        }
+        success = polygonResize(ppPolygon, maxNumVertices);
+        pPolygon = *ppPolygon;
+    }
+    if (success) {
+        pPolygon->pLatitude[pPolygon->numVertices] = latitude;
+        pPolygon->pLongitude[pPolygon->numVertices] = longitude;
+        pPolygon->numVertices++;
+        // The new vertex ends the side from the previous vertex
+        // and starts the side that closes the polygon
+        polygonSideSet(pPolygon, pPolygon->numVertices - 1);
+        polygonSideSet(pPolygon, 0);
+    }
+
+    return success;
+}
+
+// Give back any spare room in the polygons of a fence; nothing
+// more can be added to a fence while it is applied to a context
+// so this is done by fenceReferenceAdd() when the fence is first
+// applied.  Out of memory is not an error: the polygon simply
+// stays as it is.  gMutex must be locked before this is called.
+static void fenceCompact(uGeofence_t *pFence)
+{
+    uLinkedList_t *pList = pFence->pShapes;
+    uGeofenceShape_t *pShape;
+
+    while (pList != NULL) {
+        pShape = (uGeofenceShape_t *) pList->p;
+        if ((pShape != NULL) && (pShape->type == U_GEOFENCE_SHAPE_TYPE_POLYGON) &&
+            (pShape->u.pPolygon->numVertices < pShape->u.pPolygon->maxNumVertices)) {
+            polygonResize(&(pShape->u.pPolygon), pShape->u.pPolygon->numVertices);
+        }
+        pList = pList->pNext;
+    }
+}
+
+// Add a reference to a fence, compacting it if it is the first.
+// This locks gMutex since uGeofenceApply() is called with only
+// the mutex of the GNSS/cellular/Wi-Fi API locked, while
+// uGeofenceTest() and uGeofenceTestManyTasks() may be using the
+// same fence under gMutex.
+static void fenceReferenceAdd(uGeofence_t *pFence)
+{
+    // Make sure that we are initialised
+    init();
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        if (pFence->referenceCount == 0) {
+            fenceCompact(pFence);
+        }
+        pFence->referenceCount++;
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+}
+
+// Remove a reference to a fence; locks gMutex for the same
+// reason as fenceReferenceAdd().
+static void fenceReferenceRemove(uGeofence_t *pFence)
+{
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        if (pFence->referenceCount > 0) {
+            pFence->referenceCount--;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+}
+
 // Return true if the latitude of a vertex puts it close enough to
 // the pole that we cannot use X/Y maths.
 static bool atAPole(double latitude, double radiusMetres)
@@ -1004,7 +1286,7 @@ static void updateSquareExtentAndWgs84(uGeofenceShape_t *pShape)
             }
             break;
             case U_GEOFENCE_SHAPE_TYPE_POLYGON: {
-                uLinkedList_t *pList = pShape->u.pPolygon;
+                uGeofencePolygon_t *pPolygon = pShape->u.pPolygon;
                 // Note: on the face of it, we could only work with the
                 // last vertex here, since all of the other vertices could
                 // already have been taken into account. However we need
@@ -1015,24 +1297,23 @@ static void updateSquareExtentAndWgs84(uGeofenceShape_t *pShape)
                 // is added.  It is not a huge overhead to do this when
                 // first adding a shape, much better than doing it on
                 // each position calculation
-                if (pList != NULL) {
-                    uGeofenceCoordinates_t *pVertex = (uGeofenceCoordinates_t *) pList->p;
-                    squareExtent.max = *pVertex;
-                    squareExtent.min = *pVertex;
-                    pList = pList->pNext;
-                    while (pList != NULL) {
-                        pVertex = (uGeofenceCoordinates_t *) pList->p;
-                        if (pVertex->latitude > squareExtent.max.latitude) {
-                            squareExtent.max.latitude = pVertex->latitude;
-                        } else if (pVertex->latitude < squareExtent.min.latitude) {
-                            squareExtent.min.latitude = pVertex->latitude;
+                if ((pPolygon != NULL) && (pPolygon->numVertices > 0)) {
+                    squareExtent.max.latitude = pPolygon->pLatitude[0];
+                    squareExtent.max.longitude = pPolygon->pLongitude[0];
+                    squareExtent.min = squareExtent.max;
+                    for (size_t x = 1; x < pPolygon->numVertices; x++) {
+                        double latitude = pPolygon->pLatitude[x];
+                        double longitude = pPolygon->pLongitude[x];
+                        if (latitude > squareExtent.max.latitude) {
+                            squareExtent.max.latitude = latitude;
+                        } else if (latitude < squareExtent.min.latitude) {
+                            squareExtent.min.latitude = latitude;
                         }
-                        if (longitudeSubtract(pVertex->longitude, squareExtent.max.longitude) > 0) {
-                            squareExtent.max.longitude = pVertex->longitude;
-                        } else if (longitudeSubtract(squareExtent.min.longitude, pVertex->longitude) > 0) {
-                            squareExtent.min.longitude = pVertex->longitude;
+                        if (longitudeSubtract(longitude, squareExtent.max.longitude) > 0) {
+                            squareExtent.max.longitude = longitude;
+                        } else if (longitudeSubtract(squareExtent.min.longitude, longitude) > 0) {
+                            squareExtent.min.longitude = longitude;
                         }
-                        pList = pList->pNext;
                     }
                 }
                 // Having done all that, work out the diagonal and decide if it is big enough
@@ -1278,6 +1559,29 @@ static uGeofencePositionState_t testSpeed(const uGeofenceDynamic_t *pPreviousDis
     return positionState;
 }
 
+// Return true if the position cannot have reached a fence since it
+// was last tested, i.e. the distance that it was outside the fence
+// then, less the distance that could have been travelled at maximum
+// speed since, is still greater than the radius of position.
+static bool testSpeedSkip(const uGeofenceDynamicStatus_t *pLastStatus,
+                          int32_t maxHorizontalSpeedMillimetresPerSecond,
+                          int32_t radiusMillimetres)
+{
+    bool skip = false;
+    int64_t distanceTravelledMillimetres;
+
+    if ((pLastStatus->distanceMillimetres > 0) &&
+        (maxHorizontalSpeedMillimetresPerSecond >= 0) &&
+        (radiusMillimetres >= 0)) {
+        // Divide by 1000 below to get per second
+        distanceTravelledMillimetres = ((int64_t) uTimeoutElapsedMs(pLastStatus->timeoutStart)) *
+                                       maxHorizontalSpeedMillimetresPerSecond / 1000;
+        skip = (pLastStatus->distanceMillimetres - distanceTravelledMillimetres > radiusMillimetres);
+    }
+
+    return skip;
+}
+
 // Test the state of a position with respect to a circle.
 static uGeofencePositionState_t testCircle(const uGeofenceCircle_t *pCircle,
                                            bool wgs84Required,
@@ -1315,6 +1619,130 @@ static uGeofencePositionState_t testCircle(const uGeofenceCircle_t *pCircle,
     return positionState;
 }
 
+// The flat X/Y version of testPolygon(), below, giving exactly the
+// same answers.  So that the compiler is free to vectorise the bulk of
+// the work the sides are taken a block at a time: the crossing test
+// (checks 3.0 to 3.3 of testPolygon()) and, if there is an
+// uncertainty, the distance to each side in the block are worked out
+// in loops with no early exit, then the outcomes are folded in, side
+// by side, applying checks 2 and 3.4 in the order that testPolygon()
+// does.
+static uGeofencePositionState_t testPolygonXY(const uGeofencePolygon_t *pPolygon,
+                                              double metresPerDegreeLongitude,
+                                              const uGeofenceCoordinates_t *pCoordinates,
+                                              int32_t uncertaintyMillimetres,
+                                              double *pDistanceMetres,
+                                              bool *pUncertain)
+{
+    uGeofencePositionState_t positionState = U_GEOFENCE_POSITION_STATE_NONE;
+    size_t numVertices = pPolygon->numVertices;
+    const double *pLatitude = pPolygon->pLatitude;
+    const double *pLongitude = pPolygon->pLongitude;
+    const double *pSideLatitudeMax = pPolygon->pSideLatitudeMax;
+    const double *pSideSlope = pPolygon->pSideSlope;
+    double latitude = pCoordinates->latitude;
+    double longitude = pCoordinates->longitude;
+    bool isInside = false;
+    bool atVertex = false;
+    bool exitNow = false;
+    bool calculationFailure = false;
+    bool flip[U_GEOFENCE_POLYGON_BLOCK_NUM_SIDES];
+    double distanceMetres[U_GEOFENCE_POLYGON_BLOCK_NUM_SIDES];
+    double distanceMinMetres = NAN;
+    size_t numSides = 0;
+
+    *pDistanceMetres = NAN;
+    *pUncertain = false;
+
+    if (numVertices >= 3) {
+        // Check 2 for the first vertex
+        atVertex = (pLatitude[0] == latitude) && (pLongitude[0] == longitude);
+        exitNow = atVertex;
+        // Side x runs from vertex x - 1 to vertex x, the last one,
+        // where x is numVertices, being back to vertex zero
+        for (size_t x = 1; (x <= numVertices) && !exitNow; x += numSides) {
+            numSides = numVertices + 1 - x;
+            if (numSides > U_GEOFENCE_POLYGON_BLOCK_NUM_SIDES) {
+                numSides = U_GEOFENCE_POLYGON_BLOCK_NUM_SIDES;
+            }
+            for (size_t y = 0; y < numSides; y++) {
+                size_t start = x + y - 1;
+                size_t end = (x + y < numVertices) ? x + y : 0;
+                double longitude1Delta = longitudeSubtract(longitude, pLongitude[start]);
+                double longitude0Delta = longitudeSubtract(longitude, pLongitude[end]);
+                bool vertex1Intersection = (pLongitude[start] == longitude) &&
+                                           (pLatitude[start] >= latitude);
+                bool vertex0Intersection = (pLongitude[end] == longitude) &&
+                                           (pLatitude[end] >= latitude);
+                double cutLatitude = pLatitude[start] + (longitude1Delta * pSideSlope[end]);
+                // Check 3.0: not both below, not both to one side
+                flip[y] = (pSideLatitudeMax[end] >= latitude) &&
+                          !(((longitude1Delta > 0) && (longitude0Delta > 0)) ||
+                            ((longitude1Delta < 0) && (longitude0Delta < 0))) &&
+                          ((vertex1Intersection || vertex0Intersection) ?
+                           // Check 3.1
+                           ((vertex1Intersection && (longitude0Delta > 0)) ||
+                            (vertex0Intersection && (longitude1Delta > 0))) :
+                           // Checks 3.2 and 3.3
+                           ((fabs(longitude1Delta) + fabs(longitude0Delta) <= 180) &&
+                            (cutLatitude >= latitude)));
+            }
+            if (uncertaintyMillimetres > 0) {
+                for (size_t y = 0; y < numSides; y++) {
+                    size_t start = x + y - 1;
+                    size_t end = (x + y < numVertices) ? x + y : 0;
+                    distanceMetres[y] = distanceToSegmentXY(pLatitude[start], pLongitude[start],
+                                                            pLatitude[end], pLongitude[end],
+                                                            latitude, longitude,
+                                                            metresPerDegreeLongitude);
+                }
+            }
+            for (size_t y = 0; (y < numSides) && !exitNow; y++) {
+                size_t end = (x + y < numVertices) ? x + y : 0;
+                // Check 2 for the vertex at the end of this side
+                atVertex = (pLatitude[end] == latitude) && (pLongitude[end] == longitude);
+                exitNow = atVertex;
+                if (!atVertex) {
+                    if (flip[y]) {
+                        isInside = !isInside;
+                    }
+                    // Check 3.4
+                    if (!*pUncertain && (uncertaintyMillimetres > 0)) {
+                        calculationFailure = (distanceMetres[y] != distanceMetres[y]);  // NAN test
+                        if (calculationFailure) {
+                            exitNow = true;
+                        } else {
+                            if ((distanceMinMetres != distanceMinMetres) || // NAN test
+                                (distanceMetres[y] < distanceMinMetres)) {
+                                distanceMinMetres = distanceMetres[y];
+                            }
+                            *pUncertain = (uncertaintyMillimetres > distanceMetres[y] * 1000);
+                        }
+                    }
+                }
+            }
+        }
+
+        if (atVertex) {
+            // Check 2 has been met, we're in
+            isInside = true;
+            if (uncertaintyMillimetres > 0) {
+                // ...uncertainly
+                *pUncertain = true;
+            }
+        }
+        if (!calculationFailure) {
+            *pDistanceMetres = distanceMinMetres;
+            positionState = U_GEOFENCE_POSITION_STATE_OUTSIDE;
+            if (isInside) {
+                positionState = U_GEOFENCE_POSITION_STATE_INSIDE;
+            }
+        }
+    }
+
+    return positionState;
+}
+
 // Test the state of a position with respect to a polygon.
 //
 // The solution here is the "point in polygon" ray-casting
@@ -1398,7 +1826,7 @@ static uGeofencePositionState_t testCircle(const uGeofenceCircle_t *pCircle,
 // 4: When all segments have been tested or skipped the states of
 //    "IS INSIDE" and "IS UNCERTAIN" are correct.
 //
-static uGeofencePositionState_t testPolygon(const uLinkedList_t *pPolygon,
+static uGeofencePositionState_t testPolygon(const uGeofencePolygon_t *pPolygon,
                                             bool wgs84Required,
                                             double metresPerDegreeLongitude,
                                             const uGeofenceCoordinates_t *pCoordinates,
@@ -1407,12 +1835,15 @@ static uGeofencePositionState_t testPolygon(const uLinkedList_t *pPolygon,
                                             bool *pUncertain)
 {
     uGeofencePositionState_t positionState = U_GEOFENCE_POSITION_STATE_NONE;
-    int32_t vertexCount = 0;
+    size_t numVertices = pPolygon->numVertices;
+    const double *pLatitude = pPolygon->pLatitude;
+    const double *pLongitude = pPolygon->pLongitude;
     bool isInside = false;
     bool exitNow = false;
     bool calculationFailure = false;
-    const uLinkedList_t *pTmp = pPolygon;
-    uGeofenceCoordinates_t *pSide[2] = {0};
+    // The side being checked starts at side[1] and ends at side[0]
+    uGeofenceCoordinates_t side[2];
+    size_t vertex;
     double cutLatitude = NAN;
     double distanceMetres;
     double distanceMinMetres = NAN;
@@ -1420,106 +1851,100 @@ static uGeofencePositionState_t testPolygon(const uLinkedList_t *pPolygon,
     *pDistanceMetres = NAN;
     *pUncertain = false;
 
-    // First count the number of vertices
-    while ((pTmp != NULL) && (pTmp->p != NULL)) {
-        vertexCount++;
-        pTmp = pTmp->pNext;
-    }
-    if (vertexCount >= 3) {
+    if (!wgs84Required) {
+        positionState = testPolygonXY(pPolygon, metresPerDegreeLongitude,
+                                      pCoordinates, uncertaintyMillimetres,
+                                      pDistanceMetres, pUncertain);
+    } else if (numVertices >= 3) {
         // Check all sides making sure to check the final
-        // side which links back to the first vertex
-        while ((vertexCount >= 0) && !exitNow) {
-            if (pTmp == NULL) {
-                // This sets us up at the beginning and also
-                // at the end, to pick up the first vertexCount
-                // that ends the last side
-                pTmp = pPolygon;
+        // side which links back to the first vertex, side zero
+        for (size_t x = 0; (x <= numVertices) && !exitNow; x++) {
+            vertex = x;
+            if (vertex == numVertices) {
+                vertex = 0;
             }
-            pSide[0] = (uGeofenceCoordinates_t *) pTmp->p;
-            if (pSide[0] != NULL) {
-                // Now have a side which starts at pSide[1] and ends at pSide[0]
-                if ((pSide[0]->latitude == pCoordinates->latitude) &&
-                    (pSide[0]->longitude == pCoordinates->longitude)) {
-                    // Check 2 has been met, we're in
-                    isInside = true;
-                    if (uncertaintyMillimetres > 0) {
-                        // ...uncertainly
-                        *pUncertain = true;
-                    }
-                    exitNow = true;
-                } else {
-                    if (pSide[1] != NULL) {
-                        // These things are used multiple times below so set them out here
-                        double longitude1Delta = longitudeSubtract(pCoordinates->longitude, pSide[1]->longitude);
-                        double longitude0Delta = longitudeSubtract(pCoordinates->longitude, pSide[0]->longitude);
-                        bool sideIsBelow = (pSide[1]->latitude < pCoordinates->latitude) &&
-                                           (pSide[0]->latitude < pCoordinates->latitude);
-                        // Check 3.0
-                        if ((((longitude1Delta > 0) && (longitude0Delta > 0)) ||
-                             ((longitude1Delta < 0) && (longitude0Delta < 0))) || sideIsBelow) {
-                            // No intersection
+            if ((pLatitude[vertex] == pCoordinates->latitude) &&
+                (pLongitude[vertex] == pCoordinates->longitude)) {
+                // Check 2 has been met, we're in
+                isInside = true;
+                if (uncertaintyMillimetres > 0) {
+                    // ...uncertainly
+                    *pUncertain = true;
+                }
+                exitNow = true;
+            } else if (x > 0) {
+                side[1].latitude = pLatitude[x - 1];
+                side[1].longitude = pLongitude[x - 1];
+                side[0].latitude = pLatitude[vertex];
+                side[0].longitude = pLongitude[vertex];
+                // Check 3.0, first part: if both ends of the side are
+                // below us there is no intersection
+                if (pPolygon->pSideLatitudeMax[vertex] >= pCoordinates->latitude) {
+                    // These things are used multiple times below so set them out here
+                    double longitude1Delta = longitudeSubtract(pCoordinates->longitude, side[1].longitude);
+                    double longitude0Delta = longitudeSubtract(pCoordinates->longitude, side[0].longitude);
+                    // Check 3.0, second part
+                    if (((longitude1Delta > 0) && (longitude0Delta > 0)) ||
+                        ((longitude1Delta < 0) && (longitude0Delta < 0))) {
+                        // No intersection
+                    } else {
+                        // Check 3.1
+                        bool vertex1Intersection = (side[1].longitude == pCoordinates->longitude) &&
+                                                   (side[1].latitude >= pCoordinates->latitude);
+                        bool vertex0Intersection = (side[0].longitude == pCoordinates->longitude) &&
+                                                   (side[0].latitude >= pCoordinates->latitude);
+                        if (vertex1Intersection || vertex0Intersection) {
+                            if ((vertex1Intersection && (longitude0Delta > 0)) ||
+                                (vertex0Intersection && (longitude1Delta > 0))) {
+                                // Flip
+                                isInside = !isInside;
+                            }
                         } else {
-                            // Check 3.1
-                            bool vertex1Intersection = (pSide[1]->longitude == pCoordinates->longitude) &&
-                                                       (pSide[1]->latitude >= pCoordinates->latitude);
-                            bool vertex0Intersection = (pSide[0]->longitude == pCoordinates->longitude) &&
-                                                       (pSide[0]->latitude >= pCoordinates->latitude);
-                            if (vertex1Intersection || vertex0Intersection) {
-                                if ((vertex1Intersection && (longitude0Delta > 0)) ||
-                                    (vertex0Intersection && (longitude1Delta > 0))) {
-                                    // Flip
-                                    isInside = !isInside;
-                                }
-                            } else {
-                                // Check 3.2
-                                double longitude1DeltaAbs = longitude1Delta;
-                                if (longitude1DeltaAbs < 0) {
-                                    longitude1DeltaAbs = -longitude1DeltaAbs;
-                                }
-                                double longitude0DeltaAbs = longitude0Delta;
-                                if (longitude0DeltaAbs < 0) {
-                                    longitude0DeltaAbs = -longitude0DeltaAbs;
-                                }
-                                if ((longitude1DeltaAbs + longitude0DeltaAbs <= 180)) {
-                                    // Check 3.3: need to do some calculations
-                                    calculationFailure = !latitudeOfIntersection(pSide[1], pSide[0],
-                                                                                 pCoordinates->longitude,
-                                                                                 wgs84Required,
-                                                                                 &cutLatitude);
-                                    if (calculationFailure) {
-                                        exitNow = true;
-                                    } else {
-                                        if (cutLatitude >= pCoordinates->latitude) {
-                                            // Flip
-                                            isInside = !isInside;
-                                        }
+                            // Check 3.2
+                            double longitude1DeltaAbs = longitude1Delta;
+                            if (longitude1DeltaAbs < 0) {
+                                longitude1DeltaAbs = -longitude1DeltaAbs;
+                            }
+                            double longitude0DeltaAbs = longitude0Delta;
+                            if (longitude0DeltaAbs < 0) {
+                                longitude0DeltaAbs = -longitude0DeltaAbs;
+                            }
+                            if ((longitude1DeltaAbs + longitude0DeltaAbs <= 180)) {
+                                // Check 3.3: need to do some calculations
+                                calculationFailure = !latitudeOfIntersection(&(side[1]), &(side[0]),
+                                                                             pCoordinates->longitude,
+                                                                             wgs84Required,
+                                                                             &cutLatitude);
+                                if (calculationFailure) {
+                                    exitNow = true;
+                                } else {
+                                    if (cutLatitude >= pCoordinates->latitude) {
+                                        // Flip
+                                        isInside = !isInside;
                                     }
                                 }
                             }
                         }
-                        // Check 3.4
-                        if (!*pUncertain && (uncertaintyMillimetres > 0)) {
-                            // Check if the shortest distance between the side
-                            // and our point is less than the uncertainty
-                            distanceMetres = distanceToSegment(pSide[1], pSide[0], pCoordinates,
-                                                               metresPerDegreeLongitude, wgs84Required);
-                            calculationFailure = (distanceMetres != distanceMetres);  // NAN test
-                            if (calculationFailure) {
-                                exitNow = true;
-                            } else {
-                                if ((distanceMinMetres != distanceMinMetres) || // NAN test
-                                    (distanceMetres < distanceMinMetres)) {
-                                    distanceMinMetres = distanceMetres;
-                                }
-                                *pUncertain = (uncertaintyMillimetres > distanceMetres * 1000);
-                            }
+                    }
+                }
+                // Check 3.4
+                if (!*pUncertain && (uncertaintyMillimetres > 0)) {
+                    // Check if the shortest distance between the side
+                    // and our point is less than the uncertainty
+                    distanceMetres = distanceToSegment(&(side[1]), &(side[0]), pCoordinates,
+                                                       metresPerDegreeLongitude, wgs84Required);
+                    calculationFailure = (distanceMetres != distanceMetres);  // NAN test
+                    if (calculationFailure) {
+                        exitNow = true;
+                    } else {
+                        if ((distanceMinMetres != distanceMinMetres) || // NAN test
+                            (distanceMetres < distanceMinMetres)) {
+                            distanceMinMetres = distanceMetres;
                         }
+                        *pUncertain = (uncertaintyMillimetres > distanceMetres * 1000);
                     }
-                    pSide[1] = pSide[0];
                 }
             }
-            vertexCount--;
-            pTmp = pTmp->pNext;
         }
 
         if (!calculationFailure) {
@@ -1541,7 +1966,12 @@ static bool testKeepGoing(uGeofencePositionState_t positionState)
     return !(positionState == U_GEOFENCE_POSITION_STATE_INSIDE);
 }
 
-// Test a single position against a fence.
+// Test a single position against a fence; if pDistanceOutsideMillimetres
+// is not NULL it is populated with a distance that the position is
+// known to be at least outside the fence, zero if it is inside the
+// fence or LLONG_MIN if not known.  This is not the same as the distance
+// in pDynamic, which only includes the shapes that it was necessary to
+// measure.
 bool testPosition(const uGeofence_t *pFence,
                   uGeofenceTestType_t testType,
                   bool pessimisticNotOptimistic,
@@ -1551,7 +1981,8 @@ bool testPosition(const uGeofence_t *pFence,
                   int64_t longitudeX1e9,
                   int32_t altitudeMillimetres,
                   int32_t radiusMillimetres,
-                  int32_t altitudeUncertaintyMillimetres)
+                  int32_t altitudeUncertaintyMillimetres,
+                  int64_t *pDistanceOutsideMillimetres)
 {
     bool testIsMet = false;
     uGeofencePositionState_t positionState;
@@ -1564,7 +1995,12 @@ bool testPosition(const uGeofence_t *pFence,
     double metresPerDegreeLongitude;
     double distanceMetres;
     double distanceMinMetres = NAN;
+    // Positive infinity
+    double distanceOutsideMetres = HUGE_VAL;
 
+    if (pDistanceOutsideMillimetres != NULL) {
+        *pDistanceOutsideMillimetres = LLONG_MIN;
+    }
     if ((pFence != NULL) && (latitudeX1e9 < U_GEOFENCE_LIMIT_LATITUDE_DEGREES_X1E9) &&
         (latitudeX1e9 > -U_GEOFENCE_LIMIT_LATITUDE_DEGREES_X1E9) &&
         (longitudeX1e9 < U_GEOFENCE_LIMIT_LONGITUDE_DEGREES_X1E9) &&
@@ -1599,9 +2035,20 @@ bool testPosition(const uGeofence_t *pFence,
                     // we can eliminate it based on square extent or speed
                     if (radiusMillimetres < U_GEOFENCE_SQUARE_EXTENT_CHECK_UNCERTAINTY_METRES * 1000) {
                         positionState = testSquareExtent(&(pShape->squareExtent), &coordinates);
+                        if ((positionState == U_GEOFENCE_POSITION_STATE_OUTSIDE) &&
+                            (distanceOutsideMetres > U_GEOFENCE_SQUARE_EXTENT_CHECK_UNCERTAINTY_METRES / 2)) {
+                            // The square extent has a margin of
+                            // U_GEOFENCE_SQUARE_EXTENT_CHECK_UNCERTAINTY_METRES
+                            // around the shape: be cautious and only count half
+                            distanceOutsideMetres = U_GEOFENCE_SQUARE_EXTENT_CHECK_UNCERTAINTY_METRES / 2;
+                        }
                     }
                     if ((positionState != U_GEOFENCE_POSITION_STATE_OUTSIDE) && (pDynamic != NULL)) {
                         positionState = testSpeed(pDynamic);
+                        if (positionState == U_GEOFENCE_POSITION_STATE_OUTSIDE) {
+                            // Don't know how far away the shape is
+                            distanceOutsideMetres = NAN;
+                        }
                     }
                     if (positionState != U_GEOFENCE_POSITION_STATE_OUTSIDE) {
                         uncertain = false;
@@ -1636,6 +2083,18 @@ bool testPosition(const uGeofence_t *pFence,
                                 distanceMinMetres = 0;
                             }
                         }
+                        if (uncertain) {
+                            // Once the outcome for a shape is uncertain
+                            // testCircle()/testPolygon() stop looking for
+                            // the shortest distance, so what they return
+                            // may be more than the true distance: it
+                            // cannot be used as a bound
+                            distanceOutsideMetres = NAN;
+                        } else if ((distanceMetres != distanceMetres) || // NAN test
+                                   (distanceMetres < distanceOutsideMetres)) {
+                            // Note: this also passes on a NAN
+                            distanceOutsideMetres = distanceMetres;
+                        }
                         if (uncertain) {
                             // Take account of any uncertainty in the outcome
                             positionState = testAccountForUncertainty(testType,
@@ -1658,6 +2117,15 @@ bool testPosition(const uGeofence_t *pFence,
                     }
                 }
             }
+            if (pDistanceOutsideMillimetres != NULL) {
+                if (positionState == U_GEOFENCE_POSITION_STATE_INSIDE) {
+                    *pDistanceOutsideMillimetres = 0;
+                } else if ((positionState == U_GEOFENCE_POSITION_STATE_OUTSIDE) &&
+                           (distanceOutsideMetres == distanceOutsideMetres) && // NAN test
+                           (distanceOutsideMetres != HUGE_VAL)) {
+                    *pDistanceOutsideMillimetres = (int64_t) (distanceOutsideMetres * 1000);
+                }
+            }
         }
         testIsMet = ((testType == U_GEOFENCE_TEST_TYPE_INSIDE) &&
                      (positionState == U_GEOFENCE_POSITION_STATE_INSIDE)) ||
@@ -1677,6 +2145,513 @@ bool testPosition(const uGeofence_t *pFence,
 
 #endif // U_CFG_GEOFENCE
 
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: SPATIAL INDEX
+ * -------------------------------------------------------------- */
+
+#ifdef U_CFG_GEOFENCE
+
+// Get the square extent of a whole fence, the union of the square
+// extents of its shapes, returning false if the fence can't be
+// described in that way: it has no shapes, one of its shapes is
+// too big to have a square extent or crosses the 180 degree line,
+// or the union is so wide that longitudeSubtract() would wrap.
+static bool fenceSquareExtent(const uGeofence_t *pFence,
+                              uGeofenceSquare_t *pSquareExtent)
+{
+    bool success = true;
+    bool found = false;
+    const uLinkedList_t *pList = pFence->pShapes;
+    const uGeofenceShape_t *pShape;
+    const uGeofenceSquare_t *pShapeSquareExtent;
+
+    while (success && (pList != NULL)) {
+        pShape = (const uGeofenceShape_t *) pList->p;
+        if (pShape != NULL) {
+            pShapeSquareExtent = &(pShape->squareExtent);
+            // NAN checks and a check for a wrap
+            success = (pShapeSquareExtent->max.latitude == pShapeSquareExtent->max.latitude) &&
+                      (pShapeSquareExtent->min.latitude == pShapeSquareExtent->min.latitude) &&
+                      (pShapeSquareExtent->max.longitude == pShapeSquareExtent->max.longitude) &&
+                      (pShapeSquareExtent->min.longitude == pShapeSquareExtent->min.longitude) &&
+                      (pShapeSquareExtent->min.longitude <= pShapeSquareExtent->max.longitude);
+            if (success) {
+                if (!found) {
+                    *pSquareExtent = *pShapeSquareExtent;
+                    found = true;
+                } else {
+                    if (pShapeSquareExtent->max.latitude > pSquareExtent->max.latitude) {
+                        pSquareExtent->max.latitude = pShapeSquareExtent->max.latitude;
+                    }
+                    if (pShapeSquareExtent->min.latitude < pSquareExtent->min.latitude) {
+                        pSquareExtent->min.latitude = pShapeSquareExtent->min.latitude;
+                    }
+                    if (pShapeSquareExtent->max.longitude > pSquareExtent->max.longitude) {
+                        pSquareExtent->max.longitude = pShapeSquareExtent->max.longitude;
+                    }
+                    if (pShapeSquareExtent->min.longitude < pSquareExtent->min.longitude) {
+                        pSquareExtent->min.longitude = pShapeSquareExtent->min.longitude;
+                    }
+                }
+            }
+        }
+        pList = pList->pNext;
+    }
+
+    return success && found &&
+           (pSquareExtent->max.longitude - pSquareExtent->min.longitude < 180);
+}
+
+// Return the row (or column) of the spatial index grid that a
+// latitude (or longitude) is in, clamped to the grid.
+static size_t indexCell(double degrees, double minDegrees,
+                        double cellDegrees, size_t numCells)
+{
+    size_t cell = 0;
+    double position = (degrees - minDegrees) / cellDegrees;
+
+    if (position >= (double) numCells) {
+        cell = numCells - 1;
+    } else if (position > 0) {
+        cell = (size_t) position;
+    }
+
+    return cell;
+}
+
+// Work out the rows and columns of the spatial index grid that
+// a fence covers, returning false if the fence should not be put
+// in the grid at all but should always be tested instead.
+static bool indexSpan(const uGeofenceIndex_t *pIndex,
+                      const uGeofence_t *pFence,
+                      size_t *pRows, size_t *pColumns)
+{
+    uGeofenceSquare_t squareExtent;
+    bool inGrid = (pFence != NULL) && fenceSquareExtent(pFence, &squareExtent);
+
+    if (inGrid) {
+        pRows[0] = indexCell(squareExtent.min.latitude, pIndex->grid.min.latitude,
+                             pIndex->cellHeightDegrees, pIndex->numRows);
+        pRows[1] = indexCell(squareExtent.max.latitude, pIndex->grid.min.latitude,
+                             pIndex->cellHeightDegrees, pIndex->numRows);
+        pColumns[0] = indexCell(squareExtent.min.longitude, pIndex->grid.min.longitude,
+                                pIndex->cellWidthDegrees, pIndex->numColumns);
+        pColumns[1] = indexCell(squareExtent.max.longitude, pIndex->grid.min.longitude,
+                                pIndex->cellWidthDegrees, pIndex->numColumns);
+        inGrid = ((pRows[1] - pRows[0] + 1) * (pColumns[1] - pColumns[0] + 1) <=
+                  U_GEOFENCE_INDEX_FENCE_CELLS_MAX);
+    }
+
+    return inGrid;
+}
+
+// Create a spatial index of a list of fences; returns NULL if there
+// are too few fences to bother or if there is not enough memory, in
+// which case all of the fences are simply tested.
+static uGeofenceIndex_t *pIndexCreate(const uLinkedList_t *pFences)
+{
+    uGeofenceIndex_t *pIndex = NULL;
+    uGeofenceIndex_t index = {0};
+    uGeofenceSquare_t squareExtent;
+    const uLinkedList_t *pList;
+    size_t numFences = 0;
+    size_t numInGrid = 0;
+    size_t numEntries = 0;
+    size_t numCells;
+    size_t rows[2];
+    size_t columns[2];
+    size_t fence;
+    size_t cell;
+    double heightDegrees;
+    double widthDegrees;
+    double cellDegrees;
+
+    // Find the square extent of the grid
+    for (pList = pFences; pList != NULL; pList = pList->pNext) {
+        if ((pList->p != NULL) &&
+            fenceSquareExtent((const uGeofence_t *) pList->p, &squareExtent)) {
+            if (numInGrid == 0) {
+                index.grid = squareExtent;
+            } else {
+                if (squareExtent.max.latitude > index.grid.max.latitude) {
+                    index.grid.max.latitude = squareExtent.max.latitude;
+                }
+                if (squareExtent.min.latitude < index.grid.min.latitude) {
+                    index.grid.min.latitude = squareExtent.min.latitude;
+                }
+                if (squareExtent.max.longitude > index.grid.max.longitude) {
+                    index.grid.max.longitude = squareExtent.max.longitude;
+                }
+                if (squareExtent.min.longitude < index.grid.min.longitude) {
+                    index.grid.min.longitude = squareExtent.min.longitude;
+                }
+            }
+            numInGrid++;
+        }
+        numFences++;
+    }
+
+    if ((numFences >= U_GEOFENCE_INDEX_THRESHOLD_NUM_FENCES) && (numInGrid > 0)) {
+        // Size the grid for around one roughly square cell per fence
+        heightDegrees = index.grid.max.latitude - index.grid.min.latitude;
+        widthDegrees = index.grid.max.longitude - index.grid.min.longitude;
+        index.numRows = 1;
+        index.numColumns = 1;
+        if ((heightDegrees > 0) && (widthDegrees > 0)) {
+            cellDegrees = sqrt(heightDegrees * widthDegrees / (double) numInGrid);
+            index.numRows = (size_t) (heightDegrees / cellDegrees) + 1;
+            index.numColumns = (size_t) (widthDegrees / cellDegrees) + 1;
+        } else if (heightDegrees > 0) {
+            index.numRows = numInGrid;
+        } else if (widthDegrees > 0) {
+            index.numColumns = numInGrid;
+        }
+        if (index.numRows > numInGrid) {
+            index.numRows = numInGrid;
+        }
+        if (index.numColumns > numInGrid) {
+            index.numColumns = numInGrid;
+        }
+        index.cellHeightDegrees = 1;
+        if (heightDegrees > 0) {
+            index.cellHeightDegrees = heightDegrees / (double) index.numRows;
+        }
+        index.cellWidthDegrees = 1;
+        if (widthDegrees > 0) {
+            index.cellWidthDegrees = widthDegrees / (double) index.numColumns;
+        }
+        numCells = index.numRows * index.numColumns;
+
+        // Count the entries in the grid, and those that
+        // are not, to know how much memory is needed
+        for (pList = pFences; pList != NULL; pList = pList->pNext) {
+            if (indexSpan(&index, (const uGeofence_t *) pList->p, rows, columns)) {
+                numEntries += (rows[1] - rows[0] + 1) * (columns[1] - columns[0] + 1);
+            } else {
+                index.numAlways++;
+            }
+        }
+
+        pIndex = (uGeofenceIndex_t *) pUPortMalloc(sizeof(*pIndex) +
+                                                   ((index.numAlways + numCells + 1 + numEntries) *
+                                                    sizeof(size_t)));
+        if (pIndex != NULL) {
+            *pIndex = index;
+            pIndex->pAlways = (size_t *) (pIndex + 1);
+            pIndex->pCellStart = pIndex->pAlways + pIndex->numAlways;
+            pIndex->pCellFence = pIndex->pCellStart + numCells + 1;
+            memset(pIndex->pCellStart, 0, (numCells + 1) * sizeof(size_t));
+            // Count the entries in each cell into the slot of
+            // the following cell and populate the always list
+            index.numAlways = 0;
+            fence = 0;
+            for (pList = pFences; pList != NULL; pList = pList->pNext) {
+                if (indexSpan(pIndex, (const uGeofence_t *) pList->p, rows, columns)) {
+                    for (size_t y = rows[0]; y <= rows[1]; y++) {
+                        for (size_t x = columns[0]; x <= columns[1]; x++) {
+                            pIndex->pCellStart[(y * pIndex->numColumns) + x + 1]++;
+                        }
+                    }
+                } else {
+                    pIndex->pAlways[index.numAlways] = fence;
+                    index.numAlways++;
+                }
+                fence++;
+            }
+            // Add them up to give the start of each cell
+            for (cell = 1; cell <= numCells; cell++) {
+                pIndex->pCellStart[cell] += pIndex->pCellStart[cell - 1];
+            }
+            // Fill the cells in, which moves the start of each
+            // cell on to the start of the next one...
+            fence = 0;
+            for (pList = pFences; pList != NULL; pList = pList->pNext) {
+                if (indexSpan(pIndex, (const uGeofence_t *) pList->p, rows, columns)) {
+                    for (size_t y = rows[0]; y <= rows[1]; y++) {
+                        for (size_t x = columns[0]; x <= columns[1]; x++) {
+                            cell = (y * pIndex->numColumns) + x;
+                            pIndex->pCellFence[pIndex->pCellStart[cell]] = fence;
+                            pIndex->pCellStart[cell]++;
+                        }
+                    }
+                }
+                fence++;
+            }
+            // ...so move them back again
+            for (cell = numCells; cell > 0; cell--) {
+                pIndex->pCellStart[cell] = pIndex->pCellStart[cell - 1];
+            }
+            pIndex->pCellStart[0] = 0;
+        }
+    }
+
+    return pIndex;
+}
+
+// Start walking the fences that must be tested against a position.
+static void indexCursorStart(const uGeofenceIndex_t *pIndex,
+                             const uGeofenceCoordinates_t *pCoordinates,
+                             uGeofenceIndexCursor_t *pCursor)
+{
+    size_t cell;
+
+    pCursor->pNext[0] = pIndex->pAlways;
+    pCursor->pEnd[0] = pIndex->pAlways + pIndex->numAlways;
+    pCursor->pNext[1] = NULL;
+    pCursor->pEnd[1] = NULL;
+    if ((pCoordinates->latitude <= pIndex->grid.max.latitude) &&
+        (pCoordinates->latitude >= pIndex->grid.min.latitude) &&
+        (pCoordinates->longitude <= pIndex->grid.max.longitude) &&
+        (pCoordinates->longitude >= pIndex->grid.min.longitude)) {
+        cell = (indexCell(pCoordinates->latitude, pIndex->grid.min.latitude,
+                          pIndex->cellHeightDegrees, pIndex->numRows) * pIndex->numColumns) +
+               indexCell(pCoordinates->longitude, pIndex->grid.min.longitude,
+                         pIndex->cellWidthDegrees, pIndex->numColumns);
+        pCursor->pNext[1] = pIndex->pCellFence + pIndex->pCellStart[cell];
+        pCursor->pEnd[1] = pIndex->pCellFence + pIndex->pCellStart[cell + 1];
+    }
+}
+
+// Return true if the fence at the given position in the list of
+// fences must be tested; must be called for every position in the
+// list, in order.
+static bool indexCursorNext(uGeofenceIndexCursor_t *pCursor, size_t fence)
+{
+    bool mustTest = false;
+
+    for (size_t x = 0; x < sizeof(pCursor->pNext) / sizeof(pCursor->pNext[0]); x++) {
+        if ((pCursor->pNext[x] != pCursor->pEnd[x]) && (*(pCursor->pNext[x]) == fence)) {
+            mustTest = true;
+            pCursor->pNext[x]++;
+        }
+    }
+
+    return mustTest;
+}
+
+// Throw away everything a context holds about its fences, since
+// the fences have changed: the spatial index will be rebuilt by the
+// next uGeofenceContextTest() and the distances start again.
+static void contextFencesChanged(uGeofenceContext_t *pFenceContext)
+{
+    uPortFree(pFenceContext->pIndex);
+    pFenceContext->pIndex = NULL;
+    pFenceContext->indexStale = true;
+    uPortFree(pFenceContext->pFenceStatus);
+    pFenceContext->pFenceStatus = NULL;
+}
+
+// Create the array of distances for the fences of a context, all
+// not known.
+static uGeofenceDynamicStatus_t *pContextFenceStatusCreate(const uLinkedList_t *pFences)
+{
+    uGeofenceDynamicStatus_t *pFenceStatus;
+    size_t numFences = 0;
+
+    while (pFences != NULL) {
+        numFences++;
+        pFences = pFences->pNext;
+    }
+    pFenceStatus = (uGeofenceDynamicStatus_t *) pUPortMalloc(numFences * sizeof(*pFenceStatus));
+    for (size_t x = 0; (pFenceStatus != NULL) && (x < numFences); x++) {
+        pFenceStatus[x].distanceMillimetres = LLONG_MIN;
+        pFenceStatus[x].timeoutStart = uTimeoutStart();
+    }
+
+    return pFenceStatus;
+}
+
+// Test a share of the positions passed to uGeofenceTestManyTasks().
+// The fences must have been pinned, by incrementing their reference
+// count, so that they cannot be changed while this runs.
+static void testManyShare(const uGeofenceTestManyShare_t *pShare)
+{
+    uGeofencePositionState_t positionState;
+    uGeofenceDynamic_t dynamic;
+    const uGeofencePosition_t *pPosition;
+    int64_t distanceMillimetres;
+
+    for (size_t x = 0; x < pShare->numPositions; x++) {
+        pShare->pPositionStates[x] = U_GEOFENCE_POSITION_STATE_NONE;
+        if (pShare->pDistanceMillimetres != NULL) {
+            pShare->pDistanceMillimetres[x] = LLONG_MIN;
+        }
+    }
+    // Fence by fence, so that the shapes of a fence stay
+    // in cache while all of the positions are tested
+    for (size_t y = 0; y < pShare->numFences; y++) {
+        for (size_t x = 0; (x < pShare->numPositions) && (pShare->ppFences[y] != NULL); x++) {
+            pPosition = &(pShare->pPositions[x]);
+            // Each position is tested on its own, with no history
+            positionState = U_GEOFENCE_POSITION_STATE_NONE;
+            dynamic.lastStatus.distanceMillimetres = LLONG_MIN;
+            dynamic.maxHorizontalSpeedMillimetresPerSecond = -1;
+            testPosition(pShare->ppFences[y], pShare->testType,
+                         pShare->pessimisticNotOptimistic,
+                         &positionState,
+                         &dynamic,
+                         pPosition->latitudeX1e9,
+                         pPosition->longitudeX1e9,
+                         pPosition->altitudeMillimetres,
+                         pPosition->radiusMillimetres,
+                         pPosition->altitudeUncertaintyMillimetres,
+                         NULL);
+            // As for a geofence context, "inside" is sticky
+            if ((pShare->pPositionStates[x] == U_GEOFENCE_POSITION_STATE_NONE) ||
+                (positionState == U_GEOFENCE_POSITION_STATE_INSIDE)) {
+                pShare->pPositionStates[x] = positionState;
+            }
+            if (pShare->pDistanceMillimetres != NULL) {
+                distanceMillimetres = dynamic.lastStatus.distanceMillimetres;
+                if ((distanceMillimetres != LLONG_MIN) &&
+                    ((pShare->pDistanceMillimetres[x] == LLONG_MIN) ||
+                     (distanceMillimetres < pShare->pDistanceMillimetres[x]))) {
+                    pShare->pDistanceMillimetres[x] = distanceMillimetres;
+                }
+            }
+        }
+    }
+}
+
+// Worker task of uGeofenceTestManyTasks(): tests each share of
+// positions that arrives on the queue passed in until it is sent
+// a NULL pointer.
+static void testManyTask(void *pParam)
+{
+    uPortQueueHandle_t queueHandle = (uPortQueueHandle_t) pParam;
+    uGeofenceTestManyShare_t *pShare;
+    uPortSemaphoreHandle_t doneSemaphore;
+    bool keepGoing = true;
+
+    // Continue until we're told to exit
+    while (keepGoing) {
+        pShare = NULL;
+        if (uPortQueueReceive(queueHandle, &pShare) == 0) {
+            if (pShare != NULL) {
+                // Once the semaphore is given the share belongs
+                // to the calling task again, so don't touch it
+                // after that
+                doneSemaphore = pShare->doneSemaphore;
+                testManyShare(pShare);
+                uPortSemaphoreGive(doneSemaphore);
+            } else {
+                keepGoing = false;
+            }
+        }
+    }
+
+    uPortSemaphoreGive(gTestManyExitSemaphore);
+
+    // Delete ourself
+    uPortTaskDelete(NULL);
+}
+
+// Make sure that there are as many as numWorkers worker tasks for
+// uGeofenceTestManyTasks(), up to U_GEOFENCE_TEST_MANY_MAX_NUM_WORKERS,
+// returning the number there are; gMutex must be locked.
+static size_t testManyWorkersEnsure(size_t numWorkers)
+{
+    uPortTaskHandle_t taskHandle;
+
+    if (numWorkers > U_GEOFENCE_TEST_MANY_MAX_NUM_WORKERS) {
+        numWorkers = U_GEOFENCE_TEST_MANY_MAX_NUM_WORKERS;
+    }
+    if ((numWorkers > 0) && (gTestManyQueue == NULL)) {
+        if (uPortQueueCreate(U_GEOFENCE_TEST_MANY_MAX_NUM_WORKERS,
+                             sizeof(uGeofenceTestManyShare_t *),
+                             &gTestManyQueue) == 0) {
+            if (uPortSemaphoreCreate(&gTestManyExitSemaphore, 0,
+                                     U_GEOFENCE_TEST_MANY_MAX_NUM_WORKERS) != 0) {
+                uPortQueueDelete(gTestManyQueue);
+                gTestManyQueue = NULL;
+                gTestManyExitSemaphore = NULL;
+            }
+        } else {
+            gTestManyQueue = NULL;
+        }
+    }
+    while ((gTestManyQueue != NULL) && (gTestManyNumWorkers < numWorkers) &&
+           (uPortTaskCreate(testManyTask, "geofenceTestMany",
+                            U_GEOFENCE_TEST_MANY_TASK_STACK_SIZE_BYTES,
+                            (void *) gTestManyQueue,
+                            U_GEOFENCE_TEST_MANY_TASK_PRIORITY,
+                            &taskHandle) == 0)) {
+        gTestManyNumWorkers++;
+    }
+
+    return gTestManyNumWorkers;
+}
+
+// Stop the worker tasks of uGeofenceTestManyTasks() and free the
+// semaphores it used; gMutex must be locked.
+static void testManyWorkersStop()
+{
+    uGeofenceTestManyShare_t *pShare = NULL;
+    uGeofenceTestManySemaphore_t *pSemaphore;
+
+    if (gTestManyQueue != NULL) {
+        for (size_t x = 0; x < gTestManyNumWorkers; x++) {
+            uPortQueueSend(gTestManyQueue, &pShare);
+        }
+        for (size_t x = 0; x < gTestManyNumWorkers; x++) {
+            uPortSemaphoreTake(gTestManyExitSemaphore);
+        }
+        gTestManyNumWorkers = 0;
+        // Let the tasks actually exit before what
+        // they were using is deleted
+        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+        uPortSemaphoreDelete(gTestManyExitSemaphore);
+        gTestManyExitSemaphore = NULL;
+        uPortQueueDelete(gTestManyQueue);
+        gTestManyQueue = NULL;
+    }
+    while (gpTestManySemaphoreList != NULL) {
+        pSemaphore = (uGeofenceTestManySemaphore_t *) gpTestManySemaphoreList->p;
+        uLinkedListRemove(&gpTestManySemaphoreList, pSemaphore);
+        uPortSemaphoreDelete(pSemaphore->semaphoreHandle);
+        uPortFree(pSemaphore);
+    }
+}
+
+// Get a semaphore, not in use, for uGeofenceTestManyTasks() to
+// wait on, creating one if necessary; gMutex must be locked.
+static uGeofenceTestManySemaphore_t *pTestManySemaphoreGet()
+{
+    uGeofenceTestManySemaphore_t *pSemaphore = NULL;
+    uLinkedList_t *pList = gpTestManySemaphoreList;
+
+    while ((pList != NULL) && (pSemaphore == NULL)) {
+        if (!((uGeofenceTestManySemaphore_t *) pList->p)->inUse) {
+            pSemaphore = (uGeofenceTestManySemaphore_t *) pList->p;
+        }
+        pList = pList->pNext;
+    }
+    if (pSemaphore == NULL) {
+        pSemaphore = (uGeofenceTestManySemaphore_t *) pUPortMalloc(sizeof(*pSemaphore));
+        if (pSemaphore != NULL) {
+            if (uPortSemaphoreCreate(&(pSemaphore->semaphoreHandle), 0,
+                                     U_GEOFENCE_TEST_MANY_MAX_NUM_WORKERS) == 0) {
+                if (!uLinkedListAdd(&gpTestManySemaphoreList, pSemaphore)) {
+                    // Nothing can have used it yet so this is safe
+                    uPortSemaphoreDelete(pSemaphore->semaphoreHandle);
+                    uPortFree(pSemaphore);
+                    pSemaphore = NULL;
+                }
+            } else {
+                uPortFree(pSemaphore);
+                pSemaphore = NULL;
+            }
+        }
+    }
+    if (pSemaphore != NULL) {
+        pSemaphore->inUse = true;
+    }
+
+    return pSemaphore;
+}
+
+#endif // U_CFG_GEOFENCE
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS THAT ARE SHARED ONLY WITHIN UBXLIB, REQUIRED IFDEF U_CFG_GEOFENCE
  * -------------------------------------------------------------- */
@@ -1716,10 +2691,13 @@ int32_t uGeofenceApply(uGeofenceContext_t **ppFenceContext,
         errorCode = uGeofenceContextEnsure(ppFenceContext);
         if ((*ppFenceContext != NULL) &&
             uLinkedListAdd(&((*ppFenceContext)->pFences), (void *) pFence)) {
-            pFence->referenceCount++;
+            fenceReferenceAdd(pFence);
+            contextFencesChanged(*ppFenceContext);
             errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
-        } else {
+        } else if (*ppFenceContext != NULL) {
             // Clean up on error
+            uPortFree((*ppFenceContext)->pIndex);
+            uPortFree((*ppFenceContext)->pFenceStatus);
             uPortFree(*ppFenceContext);
         }
     }
@@ -1743,9 +2721,7 @@ int32_t uGeofenceRemove(uGeofenceContext_t **ppFenceContext,
                 pList = (*ppFenceContext)->pFences;
                 while (pList != NULL) {
                     pFence = (uGeofence_t *) pList->p;
-                    if (pFence->referenceCount > 0) {
-                        pFence->referenceCount--;
-                    }
+                    fenceReferenceRemove(pFence);
                     pListNext = pList->pNext;
                     uLinkedListRemove(&((*ppFenceContext)->pFences), pList->p);
                     pList = pListNext;
@@ -1753,10 +2729,9 @@ int32_t uGeofenceRemove(uGeofenceContext_t **ppFenceContext,
             } else {
                 // Just the one
                 uLinkedListRemove(&((*ppFenceContext)->pFences), (void *) pFence);
-                if (pFence->referenceCount > 0) {
-                    pFence->referenceCount--;
-                }
+                fenceReferenceRemove(pFence);
             }
+            contextFencesChanged(*ppFenceContext);
         }
     }
 
@@ -1811,6 +2786,23 @@ uGeofencePositionState_t uGeofenceTestGetPositionState(const uGeofence_t *pFence
     return positionState;
 }
 
+// Get the number of tasks the last uGeofenceTestManyTasks() used.
+size_t uGeofenceTestManyTasksGetNumTasks()
+{
+    size_t numTasks = 0;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        numTasks = gTestManyNumTasksLast;
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return numTasks;
+}
+
 // Get the last distance calculated by testPosition().
 int64_t uGeofenceTestGetDistanceMin(const uGeofence_t *pFence)
 {
@@ -1823,6 +2815,31 @@ int64_t uGeofenceTestGetDistanceMin(const uGeofence_t *pFence)
     return distanceMinMillimetres;
 }
 
+// Get the counts of fences tested and skipped.
+void uGeofenceContextGetCounts(uGeofenceContext_t *pFenceContext,
+                               uint32_t *pNumTested,
+                               uint32_t *pNumSkipped,
+                               bool reset)
+{
+    uint32_t numTested = 0;
+    uint32_t numSkipped = 0;
+
+    if (pFenceContext != NULL) {
+        numTested = pFenceContext->numFencesTested;
+        numSkipped = pFenceContext->numFencesSkipped;
+        if (reset) {
+            pFenceContext->numFencesTested = 0;
+            pFenceContext->numFencesSkipped = 0;
+        }
+    }
+    if (pNumTested != NULL) {
+        *pNumTested = numTested;
+    }
+    if (pNumSkipped != NULL) {
+        *pNumSkipped = numSkipped;
+    }
+}
+
 #endif   // #ifdef U_CFG_GEOFENCE
 
 /* ----------------------------------------------------------------
@@ -1850,9 +2867,40 @@ uGeofencePositionState_t uGeofenceContextTest(uDeviceHandle_t devHandle,
     uGeofenceDynamic_t dynamicsMinDistance;
     uGeofenceTestType_t _testType;
     bool _pessimisticNotOptimistic;
+    uGeofenceCoordinates_t coordinates;
+    uGeofenceIndexCursor_t cursor;
+    bool useIndex = false;
+    bool mustTest = true;
+    size_t fence = 0;
+    uGeofenceDynamicStatus_t *pFenceStatus = NULL;
+    int64_t distanceOutsideMillimetres;
 
     if ((pFenceContext != NULL) && (pFenceContext->pFences != NULL)) {
         pList = pFenceContext->pFences;
+        if (pFenceContext->indexStale) {
+            pFenceContext->indexStale = false;
+            pFenceContext->pIndex = pIndexCreate(pFenceContext->pFences);
+        }
+        if ((pFenceContext->pFenceStatus == NULL) &&
+            (pFenceContext->dynamic.maxHorizontalSpeedMillimetresPerSecond >= 0)) {
+            // Not a problem if this fails, we just can't skip fences
+            pFenceContext->pFenceStatus = pContextFenceStatusCreate(pFenceContext->pFences);
+        }
+        // The index is made of square extents so it can only
+        // be used where testPosition() would use them
+        if ((pFenceContext->pIndex != NULL) &&
+            (latitudeX1e9 < U_GEOFENCE_LIMIT_LATITUDE_DEGREES_X1E9) &&
+            (latitudeX1e9 > -U_GEOFENCE_LIMIT_LATITUDE_DEGREES_X1E9) &&
+            (longitudeX1e9 < U_GEOFENCE_LIMIT_LONGITUDE_DEGREES_X1E9) &&
+            (longitudeX1e9 >  -U_GEOFENCE_LIMIT_LONGITUDE_DEGREES_X1E9) &&
+            (radiusMillimetres >= 0) &&
+            (radiusMillimetres < U_GEOFENCE_SQUARE_EXTENT_CHECK_UNCERTAINTY_METRES * 1000)) {
+            useIndex = true;
+            coordinates.latitude = ((double) latitudeX1e9) / 1000000000ULL;
+            coordinates.longitude = ((double) longitudeX1e9) / 1000000000ULL;
+            indexCursorStart((const uGeofenceIndex_t *) pFenceContext->pIndex,
+                             &coordinates, &cursor);
+        }
         _testType = pFenceContext->testType;
         _pessimisticNotOptimistic = pFenceContext->pessimisticNotOptimistic;
         if (testType != U_GEOFENCE_TEST_TYPE_NONE) {
@@ -1866,16 +2914,47 @@ uGeofencePositionState_t uGeofenceContextTest(uDeviceHandle_t devHandle,
             // position has met the test against each fence
             pFence = (const uGeofence_t *) pList->p;
             fencePositionState = pFenceContext->positionState;
+            if (useIndex) {
+                mustTest = indexCursorNext(&cursor, fence);
+            }
             if (pFence != NULL) {
                 dynamic = dynamicsMinDistance;
-                testPosition(pFence, _testType,
-                             _pessimisticNotOptimistic,
-                             &fencePositionState,
-                             &dynamic,
-                             latitudeX1e9, longitudeX1e9,
-                             altitudeMillimetres,
-                             radiusMillimetres,
-                             altitudeUncertaintyMillimetres);
+                if (pFenceContext->pFenceStatus != NULL) {
+                    pFenceStatus = &(pFenceContext->pFenceStatus[fence]);
+                    // The distance to each fence is being kept, which
+                    // does a better job than testSpeed() with the
+                    // nearest distance to any fence, so switch that off
+                    dynamic.maxHorizontalSpeedMillimetresPerSecond = -1;
+                }
+                if (mustTest && ((pFenceStatus == NULL) ||
+                                 !testSpeedSkip(pFenceStatus,
+                                                pFenceContext->dynamic.maxHorizontalSpeedMillimetresPerSecond,
+                                                radiusMillimetres))) {
+                    testPosition(pFence, _testType,
+                                 _pessimisticNotOptimistic,
+                                 &fencePositionState,
+                                 &dynamic,
+                                 latitudeX1e9, longitudeX1e9,
+                                 altitudeMillimetres,
+                                 radiusMillimetres,
+                                 altitudeUncertaintyMillimetres,
+                                 &distanceOutsideMillimetres);
+                    if (pFenceStatus != NULL) {
+                        pFenceStatus->distanceMillimetres = distanceOutsideMillimetres;
+                        pFenceStatus->timeoutStart = uTimeoutStart();
+                    }
+                    pFenceContext->numFencesTested++;
+                } else {
+                    // Either the position is outside the square extent
+                    // of every shape in the fence or it cannot have
+                    // reached the fence since the fence was last tested:
+                    // this is the outcome testPosition() would arrive at,
+                    // without the cost; the distance to the fence has
+                    // not been calculated
+                    dynamic.lastStatus.distanceMillimetres = LLONG_MIN;
+                    fencePositionState = U_GEOFENCE_POSITION_STATE_OUTSIDE;
+                    pFenceContext->numFencesSkipped++;
+                }
                 if (pFenceContext->positionState == U_GEOFENCE_POSITION_STATE_NONE) {
                     // If we've never updated the instance position state, do it now
                     pFenceContext->positionState = fencePositionState;
@@ -1916,6 +2995,7 @@ uGeofencePositionState_t uGeofenceContextTest(uDeviceHandle_t devHandle,
                 }
             }
             pList = pList->pNext;
+            fence++;
         }
         // Set the new over all position state of the instance
         // and the dynamic
@@ -1952,6 +3032,8 @@ void uGeofenceContextFree(uGeofenceContext_t **ppFenceContext)
             uLinkedListRemove(&((*ppFenceContext)->pFences), pList->p);
             pList = pListNext;
         }
+        uPortFree((*ppFenceContext)->pIndex);
+        uPortFree((*ppFenceContext)->pFenceStatus);
         uPortFree(*ppFenceContext);
         *ppFenceContext = NULL;
     }
@@ -2112,8 +3194,7 @@ int32_t uGeofenceAddVertex(uGeofence_t *pFence,
 #ifdef U_CFG_GEOFENCE
     uLinkedList_t *pList;
     uGeofenceShape_t *pShape = NULL;
-    uGeofenceCoordinates_t *pVertex = NULL;
-    uLinkedList_t **ppPolygon = NULL;
+    uGeofencePolygon_t **ppPolygon = NULL;
 
     errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
 
@@ -2154,30 +3235,19 @@ int32_t uGeofenceAddVertex(uGeofence_t *pFence,
                     }
                 }
                 if (ppPolygon != NULL) {
-                    // Allocate and populate the vertex
-                    pVertex = pUPortMalloc(sizeof(uGeofenceCoordinates_t));
-                    if (pVertex != NULL) {
-                        pVertex->latitude = ((double) latitudeX1e9) / 1000000000ULL;
-                        pVertex->longitude = ((double) longitudeX1e9) / 1000000000ULL;
-                        // Add it to the list
-                        if (uLinkedListAdd(ppPolygon, pVertex)) {
-                            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
-                            // Update the square extent and set wgs84Required
-                            updateSquareExtentAndWgs84(pShape);
-                            if (newPolygon) {
-                                // If this is a new shape, add it to the list
-                                if (!uLinkedListAdd(&(pFence->pShapes), pShape)) {
-                                    errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-                                    // Clean up on error
-                                    uLinkedListRemove(ppPolygon, pVertex);
-                                    uPortFree(pVertex);
-                                    uPortFree(pShape);
-                                }
-                            }
-                        } else {
-                            // Clean up on error
-                            uPortFree(pVertex);
-                            if (newPolygon) {
+                    // Add the vertex to the polygon
+                    if (polygonAddVertex(ppPolygon,
+                                         ((double) latitudeX1e9) / 1000000000ULL,
+                                         ((double) longitudeX1e9) / 1000000000ULL)) {
+                        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                        // Update the square extent and set wgs84Required
+                        updateSquareExtentAndWgs84(pShape);
+                        if (newPolygon) {
+                            // If this is a new shape, add it to the list
+                            if (!uLinkedListAdd(&(pFence->pShapes), pShape)) {
+                                errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                                // Clean up on error
+                                uPortFree(*ppPolygon);
                                 uPortFree(pShape);
                             }
                         }
@@ -2329,7 +3399,8 @@ bool uGeofenceTest(uGeofence_t *pFence, uGeofenceTestType_t testType,
                                  latitudeX1e9, longitudeX1e9,
                                  altitudeMillimetres,
                                  radiusMillimetres,
-                                 altitudeUncertaintyMillimetres);
+                                 altitudeUncertaintyMillimetres,
+                                 NULL);
         if (positionState != U_GEOFENCE_POSITION_STATE_NONE) {
             pFence->positionState = positionState;
             pFence->distanceMinMillimetres = dynamic.lastStatus.distanceMillimetres;
@@ -2351,11 +3422,193 @@ bool uGeofenceTest(uGeofence_t *pFence, uGeofenceTestType_t testType,
     return testIsMet;
 }
 
-// Free gMutex.
+// Test many positions against a set of geofences.
+int32_t uGeofenceTestMany(uGeofence_t *const *ppFences, size_t numFences,
+                          uGeofenceTestType_t testType,
+                          bool pessimisticNotOptimistic,
+                          const uGeofencePosition_t *pPositions,
+                          size_t numPositions,
+                          uGeofencePositionState_t *pPositionStates,
+                          int64_t *pDistanceMillimetres)
+{
+    return uGeofenceTestManyTasks(ppFences, numFences, testType,
+                                  pessimisticNotOptimistic,
+                                  pPositions, numPositions,
+                                  pPositionStates, pDistanceMillimetres, 1);
+}
+
+// Test many positions against a set of geofences, sharing the work
+// out between tasks.
+int32_t uGeofenceTestManyTasks(uGeofence_t *const *ppFences, size_t numFences,
+                               uGeofenceTestType_t testType,
+                               bool pessimisticNotOptimistic,
+                               const uGeofencePosition_t *pPositions,
+                               size_t numPositions,
+                               uGeofencePositionState_t *pPositionStates,
+                               int64_t *pDistanceMillimetres,
+                               size_t numTasks)
+{
+    int32_t errorCodeOrCount;
+
+#ifdef U_CFG_GEOFENCE
+    uGeofenceTestManyShare_t share;
+    uGeofenceTestManyShare_t *pShares = NULL;
+    uGeofenceTestManyShare_t *pShare;
+    uGeofenceTestManySemaphore_t *pDoneSemaphore = NULL;
+    uPortQueueHandle_t queueHandle = NULL;
+    size_t numSharesSent = 0;
+    size_t numWorkers;
+    size_t startPosition;
+    size_t endPosition;
+
+    errorCodeOrCount = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+
+    // Make sure that we are initialised
+    init();
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (((ppFences != NULL) || (numFences == 0)) &&
+            (((pPositions != NULL) && (pPositionStates != NULL)) || (numPositions == 0)) &&
+            (numTasks > 0)) {
+            errorCodeOrCount = (int32_t) U_ERROR_COMMON_SUCCESS;
+            // Pin the fences, exactly as uGeofenceApply() does, so
+            // that they cannot be changed or free'd while gMutex is
+            // released to do the work
+            for (size_t y = 0; y < numFences; y++) {
+                if (ppFences[y] != NULL) {
+                    ppFences[y]->referenceCount++;
+                }
+            }
+            if (numTasks > numPositions) {
+                numTasks = numPositions;
+            }
+            if (numTasks > 1) {
+                // If the worker tasks, or the memory for the other
+                // shares, aren't available the calling task will
+                // do as much as it can itself
+                // There may be more workers than this call asked for,
+                // started by an earlier call: use no more than asked for
+                numWorkers = testManyWorkersEnsure(numTasks - 1);
+                if (numWorkers < numTasks - 1) {
+                    numTasks = numWorkers + 1;
+                }
+                if (numTasks > 1) {
+                    queueHandle = gTestManyQueue;
+                    pDoneSemaphore = pTestManySemaphoreGet();
+                    if (pDoneSemaphore != NULL) {
+                        pShares = (uGeofenceTestManyShare_t *) pUPortMalloc((numTasks - 1) * sizeof(*pShares));
+                        if (pShares == NULL) {
+                            pDoneSemaphore->inUse = false;
+                            pDoneSemaphore = NULL;
+                        }
+                    }
+                }
+            }
+            if (pShares == NULL) {
+                numTasks = 1;
+            }
+            gTestManyNumTasksLast = numTasks;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+
+        if (errorCodeOrCount == 0) {
+            share.ppFences = ppFences;
+            share.numFences = numFences;
+            share.testType = testType;
+            share.pessimisticNotOptimistic = pessimisticNotOptimistic;
+            share.doneSemaphore = NULL;
+            if (pDoneSemaphore != NULL) {
+                share.doneSemaphore = pDoneSemaphore->semaphoreHandle;
+            }
+            // Share the positions out, the calling task taking the
+            // first share; since each position is tested on its own
+            // the outcome does not depend on how they are shared out
+            for (size_t x = 1; x < numTasks; x++) {
+                startPosition = (numPositions * x) / numTasks;
+                endPosition = (numPositions * (x + 1)) / numTasks;
+                pShare = &(pShares[x - 1]);
+                *pShare = share;
+                pShare->pPositions = pPositions + startPosition;
+                pShare->numPositions = endPosition - startPosition;
+                pShare->pPositionStates = pPositionStates + startPosition;
+                pShare->pDistanceMillimetres = NULL;
+                if (pDistanceMillimetres != NULL) {
+                    pShare->pDistanceMillimetres = pDistanceMillimetres + startPosition;
+                }
+                if (uPortQueueSend(queueHandle, &pShare) == 0) {
+                    numSharesSent++;
+                } else {
+                    // Do it ourselves
+                    testManyShare(pShare);
+                }
+            }
+            share.pPositions = pPositions;
+            share.numPositions = numPositions / numTasks;
+            share.pPositionStates = pPositionStates;
+            share.pDistanceMillimetres = pDistanceMillimetres;
+            testManyShare(&share);
+            // Wait for the worker tasks to do their shares
+            for (size_t x = 0; x < numSharesSent; x++) {
+                uPortSemaphoreTake(share.doneSemaphore);
+            }
+            uPortFree(pShares);
+            for (size_t x = 0; x < numPositions; x++) {
+                if (((testType == U_GEOFENCE_TEST_TYPE_INSIDE) &&
+                     (pPositionStates[x] == U_GEOFENCE_POSITION_STATE_INSIDE)) ||
+                    ((testType == U_GEOFENCE_TEST_TYPE_OUTSIDE) &&
+                     (pPositionStates[x] == U_GEOFENCE_POSITION_STATE_OUTSIDE))) {
+                    errorCodeOrCount++;
+                }
+            }
+
+            U_PORT_MUTEX_LOCK(gMutex);
+
+            // Unpin the fences and put the semaphore back
+            for (size_t y = 0; y < numFences; y++) {
+                if ((ppFences[y] != NULL) && (ppFences[y]->referenceCount > 0)) {
+                    ppFences[y]->referenceCount--;
+                }
+            }
+            if (pDoneSemaphore != NULL) {
+                pDoneSemaphore->inUse = false;
+            }
+
+            U_PORT_MUTEX_UNLOCK(gMutex);
+        }
+    }
+#else
+    errorCodeOrCount = (int32_t) U_ERROR_COMMON_NOT_COMPILED;
+    (void) ppFences;
+    (void) numFences;
+    (void) testType;
+    (void) pessimisticNotOptimistic;
+    (void) pPositions;
+    (void) numPositions;
+    (void) pPositionStates;
+    (void) pDistanceMillimetres;
+    (void) numTasks;
+#endif
+
+    return errorCodeOrCount;
+}
+
+// Stop the worker tasks and free gMutex.
 void uGeofenceCleanUp()
 {
 #ifdef U_CFG_GEOFENCE
     if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        testManyWorkersStop();
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+
         uPortMutexDelete(gMutex);
         gMutex = NULL;
     }
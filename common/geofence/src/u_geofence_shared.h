@@ -65,6 +65,25 @@ typedef struct {
     uGeofenceTestType_t testType;
     bool pessimisticNotOptimistic;
     uGeofenceDynamic_t dynamic;
+    void *pIndex; /**< a spatial index of pFences, private to u_geofence.c,
+                       NULL if there are too few fences to need one. */
+    bool indexStale; /**< set when pFences has changed, pIndex will be
+                          rebuilt by the next uGeofenceContextTest(). */
+    uGeofenceDynamicStatus_t *pFenceStatus; /**< for each entry in pFences, in
+                                                 order, the distance the position
+                                                 was known to be outside the fence
+                                                 when it was last tested; private
+                                                 to u_geofence.c, only present
+                                                 if the maximum speed in dynamic
+                                                 is known. */
+    uint32_t numFencesTested; /**< the number of times that a position has been
+                                   tested against the shapes of a fence. */
+    uint32_t numFencesSkipped; /**< the number of times that testing a position
+                                    against the shapes of a fence was avoided,
+                                    either because of pIndex or because the
+                                    fence cannot have been reached since it
+                                    was last tested; read with
+                                    uGeofenceContextGetCounts(). */
 } uGeofenceContext_t;
 
 /* ----------------------------------------------------------------
@@ -191,6 +210,28 @@ int32_t uGeofenceSetCallback(uGeofenceContext_t **ppFenceContext,
                              uGeofenceCallback_t *pCallback,
                              void *pCallbackParam);
 
+/** Get the counts of fences tested and fences skipped by
+ * uGeofenceContextTest() for a geofence context; may be called by
+ * the uXxxGeofence APIs.
+ *
+ * Note: the relevant API mutex, e.g. gMutex if called from within
+ * the Geofence API, gUGnssPrivateMutex if called from within the
+ * GNSS API, etc., must be locked before this is called.
+ *
+ * @param[in] pFenceContext  a pointer to the geofence context; may be
+ *                           NULL, in which case the counts are zero.
+ * @param[out] pNumTested    a place to put the value of numFencesTested;
+ *                           may be NULL.
+ * @param[out] pNumSkipped   a place to put the value of numFencesSkipped;
+ *                           may be NULL.
+ * @param reset              if true then both counts are set back to
+ *                           zero once they have been read.
+ */
+void uGeofenceContextGetCounts(uGeofenceContext_t *pFenceContext,
+                               uint32_t *pNumTested,
+                               uint32_t *pNumSkipped,
+                               bool reset);
+
 /** Test a position against the geofences of a context; may be called by
  * the uXxxGeofence APIs.
  *
@@ -288,6 +329,15 @@ uGeofencePositionState_t uGeofenceTestGetPositionState(const uGeofence_t *pFence
  */
 int64_t uGeofenceTestGetDistanceMin(const uGeofence_t *pFence);
 
+/** Used only when testing: get the number of tasks, including the
+ * calling task, that the last call to uGeofenceTestManyTasks()
+ * shared its work between.
+ *
+ * @return  the number of tasks, zero if uGeofenceTestManyTasks()
+ *          has not been called.
+ */
+size_t uGeofenceTestManyTasksGetNumTasks();
+
 #ifdef __cplusplus
 }
 #endif
@@ -118,6 +118,94 @@
 # define U_GEOFENCE_TEST_STAR_POINTS_PER_RAY 16
 #endif
 
+#ifndef U_GEOFENCE_TEST_POLYGON_VERTICES_PER_SIDE
+/** The number of vertices to put on each side of the square
+ * polygon used when testing a polygon with many vertices.
+ */
+# define U_GEOFENCE_TEST_POLYGON_VERTICES_PER_SIDE 64
+#endif
+
+/** The length of the side of the square polygon used when testing
+ * a polygon with many vertices, in degrees times ten to the power
+ * nine; about 550 metres north-south, small enough that flat X/Y
+ * maths is used.
+ */
+#define U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 5000000LL
+
+#ifndef U_GEOFENCE_TEST_MANY_NUM_POSITIONS
+/** The number of positions to pass to uGeofenceTestMany().
+ */
+# define U_GEOFENCE_TEST_MANY_NUM_POSITIONS 1000
+#endif
+
+#ifndef U_GEOFENCE_TEST_MANY_MAX_NUM_TASKS
+/** The maximum number of tasks to share the positions between
+ * when testing uGeofenceTestManyTasks().
+ */
+# define U_GEOFENCE_TEST_MANY_MAX_NUM_TASKS 4
+#endif
+
+#ifndef U_GEOFENCE_TEST_MANY_NUM_RUNS
+/** The number of times to call uGeofenceTestManyTasks() with
+ * each number of tasks when timing it.
+ */
+# define U_GEOFENCE_TEST_MANY_NUM_RUNS 10
+#endif
+
+#ifndef U_GEOFENCE_TEST_MANY_CALLER_TASK_STACK_SIZE_BYTES
+/** The stack size of each of the tasks that call
+ * uGeofenceTestManyTasks() at the same time.
+ */
+# define U_GEOFENCE_TEST_MANY_CALLER_TASK_STACK_SIZE_BYTES (U_GEOFENCE_TEST_MANY_TASK_STACK_SIZE_BYTES + 1024)
+#endif
+
+#ifndef U_GEOFENCE_TEST_MANY_CALLER_TIMEOUT_MS
+/** How long to wait for the tasks that call uGeofenceTestManyTasks()
+ * at the same time to finish before deciding that they never will.
+ */
+# define U_GEOFENCE_TEST_MANY_CALLER_TIMEOUT_MS 60000
+#endif
+
+#ifndef U_GEOFENCE_TEST_INDEX_NUM_FENCES
+/** The number of fences to put into a geofence context when
+ * testing the spatial index; should be a square number.
+ */
+# if defined(_WIN32) || defined(__linux__)
+#  define U_GEOFENCE_TEST_INDEX_NUM_FENCES 10000
+# else
+#  define U_GEOFENCE_TEST_INDEX_NUM_FENCES 100
+# endif
+#endif
+
+#ifndef U_GEOFENCE_TEST_INDEX_NUM_POINTS
+/** The number of points to test against the geofence context
+ * when testing the spatial index.
+ */
+# define U_GEOFENCE_TEST_INDEX_NUM_POINTS 100
+#endif
+
+/** The latitude of the south-west corner of the grid of fences used
+ * when testing the spatial index.
+ */
+#define U_GEOFENCE_TEST_INDEX_LATITUDE_X1E9 52000000000LL
+
+/** The longitude of the south-west corner of the grid of fences used
+ * when testing the spatial index.
+ */
+#define U_GEOFENCE_TEST_INDEX_LONGITUDE_X1E9 1000000000LL
+
+/** The distance between the south-west corners of adjacent fences
+ * in the grid used when testing the spatial index, in degrees times
+ * ten to the power nine; about 1 km.
+ */
+#define U_GEOFENCE_TEST_INDEX_SPACING_X1E9 10000000LL
+
+/** The length of the side of each (square) fence in the grid used
+ * when testing the spatial index, in degrees times ten to the power
+ * nine; about 200 metres.
+ */
+#define U_GEOFENCE_TEST_INDEX_SIZE_X1E9 2000000LL
+
 #ifdef _WIN32
 /** The radius of a spherical earth in metres.
  */
@@ -158,6 +246,44 @@ typedef struct {
 } uGeofenceTestKmlStarSet_t;
 #endif
 
+/** Structure passed to indexCallback() so that it can check the
+ * outcome of a geofence context test, fence by fence.
+ */
+typedef struct {
+    uGeofence_t **ppFence; /**< the fences, in the order they were applied. */
+    size_t numFences;
+    size_t numCalls;
+    size_t numInside;
+    size_t numErrors;
+} uGeofenceTestIndexCheck_t;
+
+/** Structure passed to testManyCallerTask(), one for each task
+ * calling uGeofenceTestManyTasks() at the same time.
+ */
+typedef struct {
+    const uGeofencePosition_t *pPositions;
+    const uGeofencePositionState_t *pExpectedPositionStates;
+    const int64_t *pExpectedDistanceMillimetres;
+    int32_t expectedNumMet;
+    size_t numTasks; /**< the numTasks parameter to pass to
+                          uGeofenceTestManyTasks(). */
+    uGeofencePositionState_t *pPositionStates;
+    int64_t *pDistanceMillimetres;
+    size_t numErrors;
+    uPortSemaphoreHandle_t doneSemaphore; /**< given when the task has
+                                               finished. */
+} uGeofenceTestManyCaller_t;
+
+/** Structure passed to speedSkipCallback() so that it can record
+ * what is reported for one fence.
+ */
+typedef struct {
+    const uGeofence_t *pFence; /**< the fence to record. */
+    size_t numCalls;
+    uGeofencePositionState_t positionState;
+    int64_t distanceMillimetres;
+} uGeofenceTestSpeedSkipCheck_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -166,6 +292,18 @@ typedef struct {
  */
 static uGeofence_t *gpFence = NULL;
 
+/** The fences used when testing the spatial index.
+ */
+static uGeofence_t **gpIndexFence = NULL;
+
+/** The number of entries in gpIndexFence.
+ */
+static size_t gIndexNumFences = 0;
+
+/** The geofence context used when testing the spatial index.
+ */
+static uGeofenceContext_t *gpIndexFenceContext = NULL;
+
 /** String to print for each test type.
  */
 static const char *gpTestTypeString[] = {"none", "in", "out", "transit"};
@@ -394,6 +532,171 @@ static void printTestPoint(const char *pPrefix,
              pTestPoint->outcomeBitMap & (1U << gTestParameters[parametersIndex]) ? "true" : "false");
 }
 
+// Callback for the spatial index test: checks that the outcome
+// reported by uGeofenceContextTest() for each fence is exactly that
+// of testing the fence on its own with uGeofenceTest().
+static void indexCallback(uDeviceHandle_t devHandle,
+                          const void *pFence,
+                          const char *pNameStr,
+                          uGeofencePositionState_t positionState,
+                          int64_t latitudeX1e9,
+                          int64_t longitudeX1e9,
+                          int32_t altitudeMillimetres,
+                          int32_t radiusMillimetres,
+                          int32_t altitudeUncertaintyMillimetres,
+                          int64_t distanceMillimetres,
+                          void *pCallbackParam)
+{
+    uGeofenceTestIndexCheck_t *pCheck = (uGeofenceTestIndexCheck_t *) pCallbackParam;
+    uGeofence_t *pExpected = NULL;
+
+    (void) devHandle;
+    (void) pNameStr;
+
+    if (pCheck->numCalls < pCheck->numFences) {
+        pExpected = pCheck->ppFence[pCheck->numCalls];
+    }
+    if ((pExpected == NULL) || (pFence != pExpected)) {
+        pCheck->numErrors++;
+    } else {
+        uGeofenceTest(pExpected, U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                      latitudeX1e9, longitudeX1e9, altitudeMillimetres,
+                      radiusMillimetres, altitudeUncertaintyMillimetres);
+        if ((positionState != uGeofenceTestGetPositionState(pExpected)) ||
+            (distanceMillimetres != uGeofenceTestGetDistanceMin(pExpected))) {
+            U_TEST_PRINT_LINE("fence %d: context test gave %s, %d mm but fence test"
+                              " gave %s, %d mm.", pCheck->numCalls,
+                              gpPositionStateString[positionState],
+                              (int32_t) distanceMillimetres,
+                              gpPositionStateString[uGeofenceTestGetPositionState(pExpected)],
+                              (int32_t) uGeofenceTestGetDistanceMin(pExpected));
+            pCheck->numErrors++;
+        }
+    }
+    if (positionState == U_GEOFENCE_POSITION_STATE_INSIDE) {
+        pCheck->numInside++;
+    }
+    pCheck->numCalls++;
+}
+
+// Callback for the speed skip test: records the outcome reported
+// by uGeofenceContextTest() for one fence.
+static void speedSkipCallback(uDeviceHandle_t devHandle,
+                              const void *pFence,
+                              const char *pNameStr,
+                              uGeofencePositionState_t positionState,
+                              int64_t latitudeX1e9,
+                              int64_t longitudeX1e9,
+                              int32_t altitudeMillimetres,
+                              int32_t radiusMillimetres,
+                              int32_t altitudeUncertaintyMillimetres,
+                              int64_t distanceMillimetres,
+                              void *pCallbackParam)
+{
+    uGeofenceTestSpeedSkipCheck_t *pCheck = (uGeofenceTestSpeedSkipCheck_t *) pCallbackParam;
+
+    (void) devHandle;
+    (void) pNameStr;
+    (void) latitudeX1e9;
+    (void) longitudeX1e9;
+    (void) altitudeMillimetres;
+    (void) radiusMillimetres;
+    (void) altitudeUncertaintyMillimetres;
+
+    if (pFence == pCheck->pFence) {
+        pCheck->positionState = positionState;
+        pCheck->distanceMillimetres = distanceMillimetres;
+        pCheck->numCalls++;
+    }
+}
+
+// Task that calls uGeofenceTestManyTasks() a number of times,
+// at the same time as another task does the same, checking the
+// outcomes each time.
+static void testManyCallerTask(void *pParam)
+{
+    uGeofenceTestManyCaller_t *pCaller = (uGeofenceTestManyCaller_t *) pParam;
+
+    for (size_t x = 0; x < U_GEOFENCE_TEST_MANY_NUM_RUNS; x++) {
+        memset(pCaller->pPositionStates, 0xff, U_GEOFENCE_TEST_MANY_NUM_POSITIONS *
+               sizeof(uGeofencePositionState_t));
+        memset(pCaller->pDistanceMillimetres, 0xff, U_GEOFENCE_TEST_MANY_NUM_POSITIONS *
+               sizeof(int64_t));
+        if ((uGeofenceTestManyTasks(gpIndexFence, gIndexNumFences,
+                                    U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                                    pCaller->pPositions, U_GEOFENCE_TEST_MANY_NUM_POSITIONS,
+                                    pCaller->pPositionStates,
+                                    pCaller->pDistanceMillimetres,
+                                    pCaller->numTasks) != pCaller->expectedNumMet) ||
+            (memcmp(pCaller->pPositionStates, pCaller->pExpectedPositionStates,
+                    U_GEOFENCE_TEST_MANY_NUM_POSITIONS * sizeof(uGeofencePositionState_t)) != 0) ||
+            (memcmp(pCaller->pDistanceMillimetres, pCaller->pExpectedDistanceMillimetres,
+                    U_GEOFENCE_TEST_MANY_NUM_POSITIONS * sizeof(int64_t)) != 0)) {
+            pCaller->numErrors++;
+        }
+    }
+
+    uPortSemaphoreGive(pCaller->doneSemaphore);
+
+    // Delete ourself
+    uPortTaskDelete(NULL);
+}
+
+// Work out a test point for the spatial index test, returning the
+// radius of position in millimetres; the points visit the centre of
+// a fence, just beyond the edge of a fence, the gap between fences
+// and, with a radius of position too large for the index to be used,
+// the centre of a fence again; point zero is outside the grid entirely.
+static int32_t indexTestPoint(size_t point, size_t gridSide,
+                              int64_t *pLatitudeX1e9, int64_t *pLongitudeX1e9)
+{
+    int32_t radiusMillimetres = 5000;
+    size_t fence = (point * 7919) % (gridSide * gridSide);
+    int64_t offsetX1e9 = U_GEOFENCE_TEST_INDEX_SIZE_X1E9 / 2;
+
+    switch (point % 4) {
+        case 1:
+            offsetX1e9 = (U_GEOFENCE_TEST_INDEX_SIZE_X1E9 * 5) / 4;
+            break;
+        case 2:
+            offsetX1e9 = U_GEOFENCE_TEST_INDEX_SPACING_X1E9 / 2;
+            break;
+        case 3:
+            radiusMillimetres = 100001;
+            break;
+        default:
+            break;
+    }
+    *pLatitudeX1e9 = U_GEOFENCE_TEST_INDEX_LATITUDE_X1E9 +
+                     ((int64_t) (fence / gridSide) * U_GEOFENCE_TEST_INDEX_SPACING_X1E9) +
+                     offsetX1e9;
+    *pLongitudeX1e9 = U_GEOFENCE_TEST_INDEX_LONGITUDE_X1E9 +
+                      ((int64_t) (fence % gridSide) * U_GEOFENCE_TEST_INDEX_SPACING_X1E9) +
+                      offsetX1e9;
+    if (point == 0) {
+        *pLatitudeX1e9 = -*pLatitudeX1e9;
+    }
+
+    return radiusMillimetres;
+}
+
+// Free everything used by the spatial index test.
+static void indexCleanUp()
+{
+    if (gpIndexFenceContext != NULL) {
+        uGeofenceRemove(&gpIndexFenceContext, NULL);
+        uGeofenceContextFree(&gpIndexFenceContext);
+    }
+    if (gpIndexFence != NULL) {
+        for (size_t x = 0; x < gIndexNumFences; x++) {
+            uGeofenceFree(gpIndexFence[x]);
+        }
+        uPortFree(gpIndexFence);
+        gpIndexFence = NULL;
+    }
+    gIndexNumFences = 0;
+}
+
 #ifdef _WIN32
 
 // Write the given position into the given buffer.
@@ -1145,6 +1448,690 @@ U_PORT_TEST_FUNCTION("[geofence]", "geofenceStars")
 
 #endif // #ifdef _WIN32
 
+/** Test a polygon with many vertices: a square with
+ * U_GEOFENCE_TEST_POLYGON_VERTICES_PER_SIDE vertices on each side
+ * should give the same outcome as the same square with four vertices,
+ * both as it is built and once it has been compacted by being applied
+ * to a geofence context.
+ */
+U_PORT_TEST_FUNCTION("[geofence]", "geofencePolygonMany")
+{
+    int32_t resourceCount;
+    uGeofence_t *pSquare;
+    uGeofenceContext_t *pFenceContext = NULL;
+    int64_t corner[5][2] = {{U_GEOFENCE_TEST_INDEX_LATITUDE_X1E9, U_GEOFENCE_TEST_INDEX_LONGITUDE_X1E9},
+        {U_GEOFENCE_TEST_INDEX_LATITUDE_X1E9 + U_GEOFENCE_TEST_POLYGON_SIZE_X1E9, U_GEOFENCE_TEST_INDEX_LONGITUDE_X1E9},
+        {U_GEOFENCE_TEST_INDEX_LATITUDE_X1E9 + U_GEOFENCE_TEST_POLYGON_SIZE_X1E9, U_GEOFENCE_TEST_INDEX_LONGITUDE_X1E9 + U_GEOFENCE_TEST_POLYGON_SIZE_X1E9},
+        {U_GEOFENCE_TEST_INDEX_LATITUDE_X1E9, U_GEOFENCE_TEST_INDEX_LONGITUDE_X1E9 + U_GEOFENCE_TEST_POLYGON_SIZE_X1E9},
+        {U_GEOFENCE_TEST_INDEX_LATITUDE_X1E9, U_GEOFENCE_TEST_INDEX_LONGITUDE_X1E9}
+    };
+    const int32_t radiusMillimetres[] = {0, 5000, 50000};
+    int64_t latitudeX1e9;
+    int64_t longitudeX1e9;
+    int64_t distanceDifference;
+    bool isInside;
+    size_t numInside = 0;
+    size_t numTests = 0;
+
+    uPortDeinit();
+
+    // Get the initial resource count
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    // Need to initialise only the port
+    uPortInit();
+
+    pSquare = pUGeofenceCreate(U_GEOFENCE_TEST_FENCE_NAME);
+    U_PORT_TEST_ASSERT(pSquare != NULL);
+    gpFence = pUGeofenceCreate(U_GEOFENCE_TEST_FENCE_NAME);
+    U_PORT_TEST_ASSERT(gpFence != NULL);
+    for (size_t x = 0; x < 4; x++) {
+        U_PORT_TEST_ASSERT(uGeofenceAddVertex(pSquare, corner[x][0], corner[x][1], false) == 0);
+        for (int64_t y = 0; y < U_GEOFENCE_TEST_POLYGON_VERTICES_PER_SIDE; y++) {
+            latitudeX1e9 = corner[x][0] + (((corner[x + 1][0] - corner[x][0]) * y) /
+                                           U_GEOFENCE_TEST_POLYGON_VERTICES_PER_SIDE);
+            longitudeX1e9 = corner[x][1] + (((corner[x + 1][1] - corner[x][1]) * y) /
+                                            U_GEOFENCE_TEST_POLYGON_VERTICES_PER_SIDE);
+            U_PORT_TEST_ASSERT(uGeofenceAddVertex(gpFence, latitudeX1e9, longitudeX1e9, false) == 0);
+        }
+    }
+    U_TEST_PRINT_LINE("testing a square of %d vertices against one of 4.",
+                      U_GEOFENCE_TEST_POLYGON_VERTICES_PER_SIDE * 4);
+
+    // Twice: the second time with the fence applied to a context
+    for (size_t pass = 0; pass < 2; pass++) {
+        if (pass > 0) {
+            U_PORT_TEST_ASSERT(uGeofenceApply(&pFenceContext, gpFence) == 0);
+        }
+        // A grid of points from outside one side of the square to outside
+        // the other, offset so as not to line up with any vertex
+        for (int64_t x = -2; x < 11; x++) {
+            latitudeX1e9 = corner[0][0] + ((U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 * x) / 8) + 12345;
+            for (int64_t y = -2; y < 11; y++) {
+                longitudeX1e9 = corner[0][1] + ((U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 * y) / 8) + 23456;
+                for (size_t z = 0; z < sizeof(radiusMillimetres) / sizeof(radiusMillimetres[0]); z++) {
+                    isInside = uGeofenceTest(pSquare, U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                                             latitudeX1e9, longitudeX1e9, INT_MIN,
+                                             radiusMillimetres[z], -1);
+                    U_PORT_TEST_ASSERT(uGeofenceTest(gpFence, U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                                                     latitudeX1e9, longitudeX1e9, INT_MIN,
+                                                     radiusMillimetres[z], -1) == isInside);
+                    U_PORT_TEST_ASSERT(uGeofenceTestGetPositionState(gpFence) ==
+                                       uGeofenceTestGetPositionState(pSquare));
+                    // Splitting a side up may make a rounding difference to the distance
+                    distanceDifference = uGeofenceTestGetDistanceMin(gpFence) -
+                                         uGeofenceTestGetDistanceMin(pSquare);
+                    U_PORT_TEST_ASSERT((distanceDifference >= -1) && (distanceDifference <= 1));
+                    if (isInside) {
+                        numInside++;
+                    }
+                    numTests++;
+                }
+            }
+        }
+    }
+    U_TEST_PRINT_LINE("%d test(s), %d inside.", numTests, numInside);
+    U_PORT_TEST_ASSERT(numInside > 0);
+    U_PORT_TEST_ASSERT(numInside < numTests);
+
+    U_PORT_TEST_ASSERT(uGeofenceRemove(&pFenceContext, NULL) == 0);
+    uGeofenceContextFree(&pFenceContext);
+    U_PORT_TEST_ASSERT(uGeofenceFree(gpFence) == 0);
+    gpFence = NULL;
+    U_PORT_TEST_ASSERT(uGeofenceFree(pSquare) == 0);
+
+    // Free the mutex so that our memory sums add up
+    uGeofenceCleanUp();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Test uGeofenceTestMany() with a track of positions that passes
+ * through a set of fences, checking that the outcome for each
+ * position is the same as that of testing it against each fence
+ * with uGeofenceTest(), and printing how long each takes; then
+ * check that uGeofenceTestManyTasks() gives exactly the same
+ * outcomes with from 1 to U_GEOFENCE_TEST_MANY_MAX_NUM_TASKS tasks,
+ * printing how long it takes with each, and when called from two
+ * tasks at the same time.
+ */
+U_PORT_TEST_FUNCTION("[geofence]", "geofenceTestMany")
+{
+    int32_t resourceCount;
+    uGeofencePosition_t *pPositions;
+    uGeofencePositionState_t *pPositionStates;
+    int64_t *pDistanceMillimetres;
+    uGeofencePositionState_t positionState;
+    int64_t distanceMillimetres;
+    uGeofencePositionState_t fencePositionState;
+    int64_t fenceDistanceMillimetres;
+    int32_t numMet = 0;
+    int32_t numInside = 0;
+    uTimeoutStart_t timeoutStart;
+    int32_t manyMs;
+    int32_t singleMs;
+    uGeofencePositionState_t *pTasksPositionStates;
+    int64_t *pTasksDistanceMillimetres;
+    int32_t tasksMs[U_GEOFENCE_TEST_MANY_MAX_NUM_TASKS];
+    uGeofenceTestManyCaller_t caller[2] = {0};
+    uPortSemaphoreHandle_t doneSemaphore;
+    uPortTaskHandle_t taskHandle;
+
+    uPortDeinit();
+
+    // Get the initial resource count
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    // Need to initialise only the port
+    uPortInit();
+
+    pPositions = (uGeofencePosition_t *) pUPortMalloc(U_GEOFENCE_TEST_MANY_NUM_POSITIONS *
+                                                      sizeof(uGeofencePosition_t));
+    U_PORT_TEST_ASSERT(pPositions != NULL);
+    pPositionStates = (uGeofencePositionState_t *) pUPortMalloc(U_GEOFENCE_TEST_MANY_NUM_POSITIONS *
+                                                                sizeof(uGeofencePositionState_t));
+    U_PORT_TEST_ASSERT(pPositionStates != NULL);
+    pDistanceMillimetres = (int64_t *) pUPortMalloc(U_GEOFENCE_TEST_MANY_NUM_POSITIONS *
+                                                    sizeof(int64_t));
+    U_PORT_TEST_ASSERT(pDistanceMillimetres != NULL);
+
+    // Three fences: a small square with many vertices, a circle
+    // and a square big enough to need more than flat X/Y maths
+    gpIndexFence = (uGeofence_t **) pUPortMalloc(3 * sizeof(uGeofence_t *));
+    U_PORT_TEST_ASSERT(gpIndexFence != NULL);
+    for (size_t x = 0; x < 3; x++) {
+        gpIndexFence[x] = pUGeofenceCreate(U_GEOFENCE_TEST_FENCE_NAME);
+        U_PORT_TEST_ASSERT(gpIndexFence[x] != NULL);
+        gIndexNumFences++;
+    }
+    for (int64_t x = 0; x < U_GEOFENCE_TEST_POLYGON_VERTICES_PER_SIDE * 4; x++) {
+        int64_t side = x / U_GEOFENCE_TEST_POLYGON_VERTICES_PER_SIDE;
+        int64_t step = (x % U_GEOFENCE_TEST_POLYGON_VERTICES_PER_SIDE) * U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 /
+                       U_GEOFENCE_TEST_POLYGON_VERTICES_PER_SIDE;
+        int64_t latitudeX1e9 = U_GEOFENCE_TEST_INDEX_LATITUDE_X1E9;
+        int64_t longitudeX1e9 = U_GEOFENCE_TEST_INDEX_LONGITUDE_X1E9;
+        switch (side) {
+            case 0:
+                latitudeX1e9 += step;
+                break;
+            case 1:
+                latitudeX1e9 += U_GEOFENCE_TEST_POLYGON_SIZE_X1E9;
+                longitudeX1e9 += step;
+                break;
+            case 2:
+                latitudeX1e9 += U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 - step;
+                longitudeX1e9 += U_GEOFENCE_TEST_POLYGON_SIZE_X1E9;
+                break;
+            default:
+                longitudeX1e9 += U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 - step;
+                break;
+        }
+        U_PORT_TEST_ASSERT(uGeofenceAddVertex(gpIndexFence[0], latitudeX1e9, longitudeX1e9,
+                                              false) == 0);
+    }
+    U_PORT_TEST_ASSERT(uGeofenceAddCircle(gpIndexFence[1],
+                                          U_GEOFENCE_TEST_INDEX_LATITUDE_X1E9 + (U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 * 3),
+                                          U_GEOFENCE_TEST_INDEX_LONGITUDE_X1E9 + (U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 * 3),
+                                          300000) == 0);
+    U_PORT_TEST_ASSERT(uGeofenceAddVertex(gpIndexFence[2],
+                                          U_GEOFENCE_TEST_INDEX_LATITUDE_X1E9 + (U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 * 4),
+                                          U_GEOFENCE_TEST_INDEX_LONGITUDE_X1E9 + (U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 * 4),
+                                          false) == 0);
+    U_PORT_TEST_ASSERT(uGeofenceAddVertex(gpIndexFence[2],
+                                          U_GEOFENCE_TEST_INDEX_LATITUDE_X1E9 + (U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 * 8),
+                                          U_GEOFENCE_TEST_INDEX_LONGITUDE_X1E9 + (U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 * 4),
+                                          false) == 0);
+    U_PORT_TEST_ASSERT(uGeofenceAddVertex(gpIndexFence[2],
+                                          U_GEOFENCE_TEST_INDEX_LATITUDE_X1E9 + (U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 * 8),
+                                          U_GEOFENCE_TEST_INDEX_LONGITUDE_X1E9 + (U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 * 8),
+                                          false) == 0);
+    U_PORT_TEST_ASSERT(uGeofenceAddVertex(gpIndexFence[2],
+                                          U_GEOFENCE_TEST_INDEX_LATITUDE_X1E9 + (U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 * 4),
+                                          U_GEOFENCE_TEST_INDEX_LONGITUDE_X1E9 + (U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 * 8),
+                                          false) == 0);
+
+    // A track that runs diagonally from outside the first fence
+    // to outside the last, with a mix of radius of position,
+    // including unknown
+    for (int64_t x = 0; x < U_GEOFENCE_TEST_MANY_NUM_POSITIONS; x++) {
+        pPositions[x].latitudeX1e9 = U_GEOFENCE_TEST_INDEX_LATITUDE_X1E9 - U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 +
+                                     ((U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 * 10 * x) /
+                                      U_GEOFENCE_TEST_MANY_NUM_POSITIONS) + 12345;
+        pPositions[x].longitudeX1e9 = U_GEOFENCE_TEST_INDEX_LONGITUDE_X1E9 - U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 +
+                                      ((U_GEOFENCE_TEST_POLYGON_SIZE_X1E9 * 10 * x) /
+                                       U_GEOFENCE_TEST_MANY_NUM_POSITIONS) + 23456;
+        pPositions[x].altitudeMillimetres = INT_MIN;
+        pPositions[x].radiusMillimetres = (int32_t) (x % 3) * 20000;
+        if (x % 10 == 9) {
+            pPositions[x].radiusMillimetres = -1;
+        }
+        pPositions[x].altitudeUncertaintyMillimetres = -1;
+    }
+
+    U_PORT_TEST_ASSERT(uGeofenceTestMany(NULL, 1, U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                                         pPositions, U_GEOFENCE_TEST_MANY_NUM_POSITIONS,
+                                         pPositionStates, NULL) < 0);
+    U_PORT_TEST_ASSERT(uGeofenceTestMany(gpIndexFence, gIndexNumFences, U_GEOFENCE_TEST_TYPE_INSIDE,
+                                         false, pPositions, U_GEOFENCE_TEST_MANY_NUM_POSITIONS,
+                                         NULL, NULL) < 0);
+    timeoutStart = uTimeoutStart();
+    numMet = uGeofenceTestMany(gpIndexFence, gIndexNumFences, U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                               pPositions, U_GEOFENCE_TEST_MANY_NUM_POSITIONS,
+                               pPositionStates, pDistanceMillimetres);
+    manyMs = uTimeoutElapsedMs(timeoutStart);
+    U_PORT_TEST_ASSERT(numMet >= 0);
+
+    // Check the outcomes against those from testing each position
+    // against each fence
+    timeoutStart = uTimeoutStart();
+    for (size_t x = 0; x < U_GEOFENCE_TEST_MANY_NUM_POSITIONS; x++) {
+        positionState = U_GEOFENCE_POSITION_STATE_NONE;
+        distanceMillimetres = LLONG_MIN;
+        for (size_t y = 0; y < gIndexNumFences; y++) {
+            uGeofenceTestResetMemory(gpIndexFence[y]);
+            uGeofenceTest(gpIndexFence[y], U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                          pPositions[x].latitudeX1e9, pPositions[x].longitudeX1e9,
+                          pPositions[x].altitudeMillimetres,
+                          pPositions[x].radiusMillimetres,
+                          pPositions[x].altitudeUncertaintyMillimetres);
+            fencePositionState = uGeofenceTestGetPositionState(gpIndexFence[y]);
+            fenceDistanceMillimetres = LLONG_MIN;
+            if (fencePositionState != U_GEOFENCE_POSITION_STATE_NONE) {
+                fenceDistanceMillimetres = uGeofenceTestGetDistanceMin(gpIndexFence[y]);
+            }
+            if ((positionState == U_GEOFENCE_POSITION_STATE_NONE) ||
+                (fencePositionState == U_GEOFENCE_POSITION_STATE_INSIDE)) {
+                positionState = fencePositionState;
+            }
+            if ((fenceDistanceMillimetres != LLONG_MIN) &&
+                ((distanceMillimetres == LLONG_MIN) ||
+                 (fenceDistanceMillimetres < distanceMillimetres))) {
+                distanceMillimetres = fenceDistanceMillimetres;
+            }
+        }
+        if (positionState == U_GEOFENCE_POSITION_STATE_INSIDE) {
+            numInside++;
+        }
+        if ((pPositionStates[x] != positionState) ||
+            (pDistanceMillimetres[x] != distanceMillimetres)) {
+            U_TEST_PRINT_LINE("position %d: uGeofenceTestMany() gave %s, %d mm, expected %s, %d mm.",
+                              x, gpPositionStateString[pPositionStates[x]],
+                              (int32_t) pDistanceMillimetres[x],
+                              gpPositionStateString[positionState], (int32_t) distanceMillimetres);
+            U_PORT_TEST_ASSERT(false);
+        }
+    }
+    singleMs = uTimeoutElapsedMs(timeoutStart);
+    U_TEST_PRINT_LINE("%d position(s) against %d fence(s), %d inside, took %d ms with"
+                      " uGeofenceTestMany(), %d ms testing each one.",
+                      U_GEOFENCE_TEST_MANY_NUM_POSITIONS, gIndexNumFences, numMet,
+                      manyMs, singleMs);
+    U_PORT_TEST_ASSERT(numMet == numInside);
+    U_PORT_TEST_ASSERT(numInside > 0);
+    U_PORT_TEST_ASSERT(numInside < U_GEOFENCE_TEST_MANY_NUM_POSITIONS);
+
+    // Now share the work between tasks: the outcomes must be identical
+    pTasksPositionStates = (uGeofencePositionState_t *) pUPortMalloc(U_GEOFENCE_TEST_MANY_NUM_POSITIONS *
+                                                                     sizeof(uGeofencePositionState_t));
+    U_PORT_TEST_ASSERT(pTasksPositionStates != NULL);
+    pTasksDistanceMillimetres = (int64_t *) pUPortMalloc(U_GEOFENCE_TEST_MANY_NUM_POSITIONS *
+                                                         sizeof(int64_t));
+    U_PORT_TEST_ASSERT(pTasksDistanceMillimetres != NULL);
+    U_PORT_TEST_ASSERT(uGeofenceTestManyTasks(gpIndexFence, gIndexNumFences,
+                                              U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                                              pPositions, U_GEOFENCE_TEST_MANY_NUM_POSITIONS,
+                                              pTasksPositionStates, NULL, 0) < 0);
+    for (size_t x = 0; x < U_GEOFENCE_TEST_MANY_MAX_NUM_TASKS; x++) {
+        timeoutStart = uTimeoutStart();
+        for (size_t y = 0; y < U_GEOFENCE_TEST_MANY_NUM_RUNS; y++) {
+            memset(pTasksPositionStates, 0xff, U_GEOFENCE_TEST_MANY_NUM_POSITIONS *
+                   sizeof(uGeofencePositionState_t));
+            memset(pTasksDistanceMillimetres, 0xff, U_GEOFENCE_TEST_MANY_NUM_POSITIONS *
+                   sizeof(int64_t));
+            U_PORT_TEST_ASSERT(uGeofenceTestManyTasks(gpIndexFence, gIndexNumFences,
+                                                      U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                                                      pPositions, U_GEOFENCE_TEST_MANY_NUM_POSITIONS,
+                                                      pTasksPositionStates,
+                                                      pTasksDistanceMillimetres,
+                                                      x + 1) == numMet);
+            U_PORT_TEST_ASSERT(memcmp(pTasksPositionStates, pPositionStates,
+                                      U_GEOFENCE_TEST_MANY_NUM_POSITIONS *
+                                      sizeof(uGeofencePositionState_t)) == 0);
+            U_PORT_TEST_ASSERT(memcmp(pTasksDistanceMillimetres, pDistanceMillimetres,
+                                      U_GEOFENCE_TEST_MANY_NUM_POSITIONS * sizeof(int64_t)) == 0);
+        }
+        tasksMs[x] = uTimeoutElapsedMs(timeoutStart);
+    }
+    U_TEST_PRINT_LINE("%d run(s) of uGeofenceTestManyTasks() with %d position(s):",
+                      U_GEOFENCE_TEST_MANY_NUM_RUNS, U_GEOFENCE_TEST_MANY_NUM_POSITIONS);
+    for (size_t x = 0; x < U_GEOFENCE_TEST_MANY_MAX_NUM_TASKS; x++) {
+        U_TEST_PRINT_LINE("  %d task(s) took %d ms.", (int) (x + 1), tasksMs[x]);
+    }
+
+    // Now that all of the worker tasks are running, going back down
+    // from the largest number of tasks must use exactly the number asked for
+    for (size_t x = U_GEOFENCE_TEST_MANY_MAX_NUM_TASKS; x > 0; x--) {
+        memset(pTasksPositionStates, 0xff, U_GEOFENCE_TEST_MANY_NUM_POSITIONS *
+               sizeof(uGeofencePositionState_t));
+        U_PORT_TEST_ASSERT(uGeofenceTestManyTasks(gpIndexFence, gIndexNumFences,
+                                                  U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                                                  pPositions, U_GEOFENCE_TEST_MANY_NUM_POSITIONS,
+                                                  pTasksPositionStates, NULL, x) == numMet);
+        U_PORT_TEST_ASSERT(memcmp(pTasksPositionStates, pPositionStates,
+                                  U_GEOFENCE_TEST_MANY_NUM_POSITIONS *
+                                  sizeof(uGeofencePositionState_t)) == 0);
+        U_PORT_TEST_ASSERT(uGeofenceTestManyTasksGetNumTasks() == x);
+    }
+    uPortFree(pTasksDistanceMillimetres);
+    uPortFree(pTasksPositionStates);
+
+    // Call uGeofenceTestManyTasks() from two tasks at the same time,
+    // sharing the worker tasks between them: the outcomes must still
+    // be identical and neither must get stuck
+    U_PORT_TEST_ASSERT(uPortSemaphoreCreate(&doneSemaphore, 0, 2) == 0);
+    for (size_t x = 0; x < sizeof(caller) / sizeof(caller[0]); x++) {
+        caller[x].pPositions = pPositions;
+        caller[x].pExpectedPositionStates = pPositionStates;
+        caller[x].pExpectedDistanceMillimetres = pDistanceMillimetres;
+        caller[x].expectedNumMet = numMet;
+        caller[x].numTasks = (x * (U_GEOFENCE_TEST_MANY_MAX_NUM_TASKS - 2)) + 2;
+        caller[x].pPositionStates = (uGeofencePositionState_t *) pUPortMalloc(U_GEOFENCE_TEST_MANY_NUM_POSITIONS *
+                                                                              sizeof(uGeofencePositionState_t));
+        U_PORT_TEST_ASSERT(caller[x].pPositionStates != NULL);
+        caller[x].pDistanceMillimetres = (int64_t *) pUPortMalloc(U_GEOFENCE_TEST_MANY_NUM_POSITIONS *
+                                                                  sizeof(int64_t));
+        U_PORT_TEST_ASSERT(caller[x].pDistanceMillimetres != NULL);
+        caller[x].doneSemaphore = doneSemaphore;
+    }
+    timeoutStart = uTimeoutStart();
+    for (size_t x = 0; x < sizeof(caller) / sizeof(caller[0]); x++) {
+        U_PORT_TEST_ASSERT(uPortTaskCreate(testManyCallerTask, "geofenceTestCaller",
+                                           U_GEOFENCE_TEST_MANY_CALLER_TASK_STACK_SIZE_BYTES,
+                                           (void *) &(caller[x]),
+                                           U_CFG_OS_APP_TASK_PRIORITY,
+                                           &taskHandle) == 0);
+    }
+    for (size_t x = 0; x < sizeof(caller) / sizeof(caller[0]); x++) {
+        U_PORT_TEST_ASSERT(uPortSemaphoreTryTake(doneSemaphore,
+                                                 U_GEOFENCE_TEST_MANY_CALLER_TIMEOUT_MS) == 0);
+    }
+    U_TEST_PRINT_LINE("two tasks each calling uGeofenceTestManyTasks() %d time(s), with"
+                      " %d and %d task(s), took %d ms.", U_GEOFENCE_TEST_MANY_NUM_RUNS,
+                      (int) caller[0].numTasks, (int) caller[1].numTasks,
+                      uTimeoutElapsedMs(timeoutStart));
+    // Let the tasks actually exit before the semaphore
+    // they used is deleted
+    uPortTaskBlock(U_CFG_OS_YIELD_MS);
+    uPortSemaphoreDelete(doneSemaphore);
+    for (size_t x = 0; x < sizeof(caller) / sizeof(caller[0]); x++) {
+        U_PORT_TEST_ASSERT(caller[x].numErrors == 0);
+        uPortFree(caller[x].pDistanceMillimetres);
+        uPortFree(caller[x].pPositionStates);
+    }
+    // The fences must no longer be in use
+    for (size_t x = 0; x < gIndexNumFences; x++) {
+        U_PORT_TEST_ASSERT(uGeofenceSetAltitudeMax(gpIndexFence[x], INT_MAX) == 0);
+    }
+
+    indexCleanUp();
+    uPortFree(pDistanceMillimetres);
+    uPortFree(pPositionStates);
+    uPortFree(pPositions);
+
+    // Free the mutex so that our memory sums add up
+    uGeofenceCleanUp();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Test a geofence context containing many fences, checking that the
+ * outcome for every fence is the same as testing that fence on its
+ * own and printing how long the context test takes, which, with
+ * the spatial index, should be far less than testing each fence.
+ */
+U_PORT_TEST_FUNCTION("[geofence]", "geofenceIndex")
+{
+    int32_t resourceCount;
+    uGeofenceTestIndexCheck_t check = {0};
+    size_t gridSide = 1;
+    int64_t latitudeX1e9;
+    int64_t longitudeX1e9;
+    int32_t radiusMillimetres;
+    uTimeoutStart_t timeoutStart;
+    int32_t contextTestMs;
+    int32_t fenceTestMs;
+
+    uPortDeinit();
+
+    // Get the initial resource count
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    // Need to initialise only the port
+    uPortInit();
+
+    while ((gridSide + 1) * (gridSide + 1) <= U_GEOFENCE_TEST_INDEX_NUM_FENCES) {
+        gridSide++;
+    }
+    U_TEST_PRINT_LINE("creating a %d x %d grid of fences.", gridSide, gridSide);
+    gpIndexFence = (uGeofence_t **) pUPortMalloc(gridSide * gridSide * sizeof(uGeofence_t *));
+    U_PORT_TEST_ASSERT(gpIndexFence != NULL);
+    timeoutStart = uTimeoutStart();
+    for (size_t x = 0; x < gridSide * gridSide; x++) {
+        latitudeX1e9 = U_GEOFENCE_TEST_INDEX_LATITUDE_X1E9 +
+                       ((int64_t) (x / gridSide) * U_GEOFENCE_TEST_INDEX_SPACING_X1E9);
+        longitudeX1e9 = U_GEOFENCE_TEST_INDEX_LONGITUDE_X1E9 +
+                        ((int64_t) (x % gridSide) * U_GEOFENCE_TEST_INDEX_SPACING_X1E9);
+        gpIndexFence[x] = pUGeofenceCreate(U_GEOFENCE_TEST_FENCE_NAME);
+        U_PORT_TEST_ASSERT(gpIndexFence[x] != NULL);
+        gIndexNumFences++;
+        U_PORT_TEST_ASSERT(uGeofenceAddVertex(gpIndexFence[x], latitudeX1e9,
+                                              longitudeX1e9, false) == 0);
+        U_PORT_TEST_ASSERT(uGeofenceAddVertex(gpIndexFence[x],
+                                              latitudeX1e9 + U_GEOFENCE_TEST_INDEX_SIZE_X1E9,
+                                              longitudeX1e9, false) == 0);
+        U_PORT_TEST_ASSERT(uGeofenceAddVertex(gpIndexFence[x],
+                                              latitudeX1e9 + U_GEOFENCE_TEST_INDEX_SIZE_X1E9,
+                                              longitudeX1e9 + U_GEOFENCE_TEST_INDEX_SIZE_X1E9,
+                                              false) == 0);
+        U_PORT_TEST_ASSERT(uGeofenceAddVertex(gpIndexFence[x], latitudeX1e9,
+                                              longitudeX1e9 + U_GEOFENCE_TEST_INDEX_SIZE_X1E9,
+                                              false) == 0);
+        U_PORT_TEST_ASSERT(uGeofenceApply(&gpIndexFenceContext, gpIndexFence[x]) == 0);
+    }
+    U_TEST_PRINT_LINE("creating and applying %d fences took %d ms.", gIndexNumFences,
+                      uTimeoutElapsedMs(timeoutStart));
+
+    // Check that the outcome for every fence is correct
+    check.ppFence = gpIndexFence;
+    check.numFences = gIndexNumFences;
+    U_PORT_TEST_ASSERT(uGeofenceSetCallback(&gpIndexFenceContext, U_GEOFENCE_TEST_TYPE_INSIDE,
+                                            false, indexCallback, &check) == 0);
+    for (size_t x = 0; x < U_GEOFENCE_TEST_INDEX_NUM_POINTS; x++) {
+        radiusMillimetres = indexTestPoint(x, gridSide, &latitudeX1e9, &longitudeX1e9);
+        check.numCalls = 0;
+        uGeofenceContextTest((uDeviceHandle_t) &check, gpIndexFenceContext,
+                             U_GEOFENCE_TEST_TYPE_NONE, false,
+                             latitudeX1e9, longitudeX1e9, INT_MIN,
+                             radiusMillimetres, -1);
+        U_PORT_TEST_ASSERT(check.numCalls == gIndexNumFences);
+    }
+    U_TEST_PRINT_LINE("%d point(s) tested, %d fence(s) found to be inside, %d error(s).",
+                      U_GEOFENCE_TEST_INDEX_NUM_POINTS, check.numInside, check.numErrors);
+    U_PORT_TEST_ASSERT(check.numErrors == 0);
+    U_PORT_TEST_ASSERT(check.numInside > 0);
+
+    // Now time the context test, without the callback, against
+    // testing each fence in turn
+    U_PORT_TEST_ASSERT(uGeofenceSetCallback(&gpIndexFenceContext, U_GEOFENCE_TEST_TYPE_NONE,
+                                            false, NULL, NULL) == 0);
+    timeoutStart = uTimeoutStart();
+    for (size_t x = 0; x < U_GEOFENCE_TEST_INDEX_NUM_POINTS; x++) {
+        radiusMillimetres = indexTestPoint(x, gridSide, &latitudeX1e9, &longitudeX1e9);
+        uGeofenceContextTest(NULL, gpIndexFenceContext, U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                             latitudeX1e9, longitudeX1e9, INT_MIN, radiusMillimetres, -1);
+    }
+    contextTestMs = uTimeoutElapsedMs(timeoutStart);
+    timeoutStart = uTimeoutStart();
+    for (size_t x = 0; x < U_GEOFENCE_TEST_INDEX_NUM_POINTS; x++) {
+        radiusMillimetres = indexTestPoint(x, gridSide, &latitudeX1e9, &longitudeX1e9);
+        for (size_t y = 0; y < gIndexNumFences; y++) {
+            uGeofenceTest(gpIndexFence[y], U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                          latitudeX1e9, longitudeX1e9, INT_MIN, radiusMillimetres, -1);
+        }
+    }
+    fenceTestMs = uTimeoutElapsedMs(timeoutStart);
+    U_TEST_PRINT_LINE("%d point(s) against %d fences took %d ms with a geofence context,"
+                      " %d ms testing each fence.", U_GEOFENCE_TEST_INDEX_NUM_POINTS,
+                      gIndexNumFences, contextTestMs, fenceTestMs);
+
+    indexCleanUp();
+
+    // Free the mutex so that our memory sums add up
+    uGeofenceCleanUp();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Test that, where the maximum speed is known, a geofence context
+ * skips testing fences that a position cannot have reached since
+ * they were last tested, and that it stops doing so when the
+ * fences change.
+ */
+U_PORT_TEST_FUNCTION("[geofence]", "geofenceSpeedSkip")
+{
+    int32_t resourceCount;
+    int64_t latitudeX1e9 = U_GEOFENCE_TEST_INDEX_LATITUDE_X1E9;
+    int64_t longitudeX1e9 = U_GEOFENCE_TEST_INDEX_LONGITUDE_X1E9;
+    uint32_t numTested;
+    uint32_t numSkipped;
+    uGeofenceTestSpeedSkipCheck_t check = {0};
+
+    uPortDeinit();
+
+    // Get the initial resource count
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    // Need to initialise only the port
+    uPortInit();
+
+    // Three fences, 100 metre radius circles, the first around the
+    // position and the others about 10 km and 20 km north of it;
+    // only the first two are applied to begin with
+    gpIndexFence = (uGeofence_t **) pUPortMalloc(4 * sizeof(uGeofence_t *));
+    U_PORT_TEST_ASSERT(gpIndexFence != NULL);
+    for (size_t x = 0; x < 4; x++) {
+        gpIndexFence[x] = pUGeofenceCreate(U_GEOFENCE_TEST_FENCE_NAME);
+        U_PORT_TEST_ASSERT(gpIndexFence[x] != NULL);
+        gIndexNumFences++;
+    }
+    for (size_t x = 0; x < 3; x++) {
+        U_PORT_TEST_ASSERT(uGeofenceAddCircle(gpIndexFence[x],
+                                              latitudeX1e9 + ((int64_t) x * 90000000LL),
+                                              longitudeX1e9, 100000) == 0);
+    }
+    // ...and a fourth, a square about 110 metres on a side with
+    // its south-west corner at the position, used at the end
+    U_PORT_TEST_ASSERT(uGeofenceAddVertex(gpIndexFence[3], latitudeX1e9,
+                                          longitudeX1e9, false) == 0);
+    U_PORT_TEST_ASSERT(uGeofenceAddVertex(gpIndexFence[3], latitudeX1e9 + 1000000LL,
+                                          longitudeX1e9, false) == 0);
+    U_PORT_TEST_ASSERT(uGeofenceAddVertex(gpIndexFence[3], latitudeX1e9 + 1000000LL,
+                                          longitudeX1e9 + 1000000LL, false) == 0);
+    U_PORT_TEST_ASSERT(uGeofenceAddVertex(gpIndexFence[3], latitudeX1e9,
+                                          longitudeX1e9 + 1000000LL, false) == 0);
+    for (size_t x = 0; x < 2; x++) {
+        U_PORT_TEST_ASSERT(uGeofenceApply(&gpIndexFenceContext, gpIndexFence[x]) == 0);
+    }
+
+    // With no maximum speed, every fence is tested every time
+    for (size_t x = 0; x < 2; x++) {
+        U_PORT_TEST_ASSERT(uGeofenceContextTest(NULL, gpIndexFenceContext,
+                                                U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                                                latitudeX1e9, longitudeX1e9, INT_MIN,
+                                                5000, -1) == U_GEOFENCE_POSITION_STATE_INSIDE);
+    }
+    uGeofenceContextGetCounts(gpIndexFenceContext, &numTested, &numSkipped, true);
+    U_TEST_PRINT_LINE("no maximum speed: %u fence(s) tested, %u skipped.",
+                      (unsigned) numTested, (unsigned) numSkipped);
+    U_PORT_TEST_ASSERT(numTested == 4);
+    U_PORT_TEST_ASSERT(numSkipped == 0);
+
+    // Set a maximum speed of 1 metre per second: the first test
+    // finds out how far away each fence is, the second should
+    // then skip the far fence, which it cannot have reached, and
+    // report it to the callback as outside with the distance not
+    // calculated
+    gpIndexFenceContext->dynamic.maxHorizontalSpeedMillimetresPerSecond = 1000;
+    check.pFence = gpIndexFence[1];
+    U_PORT_TEST_ASSERT(uGeofenceSetCallback(&gpIndexFenceContext, U_GEOFENCE_TEST_TYPE_INSIDE,
+                                            false, speedSkipCallback, &check) == 0);
+    for (size_t x = 0; x < 2; x++) {
+        U_PORT_TEST_ASSERT(uGeofenceContextTest((uDeviceHandle_t) &check, gpIndexFenceContext,
+                                                U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                                                latitudeX1e9, longitudeX1e9, INT_MIN,
+                                                5000, -1) == U_GEOFENCE_POSITION_STATE_INSIDE);
+    }
+    U_PORT_TEST_ASSERT(uGeofenceSetCallback(&gpIndexFenceContext, U_GEOFENCE_TEST_TYPE_NONE,
+                                            false, NULL, NULL) == 0);
+    uGeofenceContextGetCounts(gpIndexFenceContext, &numTested, &numSkipped, true);
+    U_TEST_PRINT_LINE("1 metre per second: %u fence(s) tested, %u skipped.",
+                      (unsigned) numTested, (unsigned) numSkipped);
+    U_PORT_TEST_ASSERT(numTested == 3);
+    U_PORT_TEST_ASSERT(numSkipped == 1);
+    U_PORT_TEST_ASSERT(check.numCalls == 2);
+    U_PORT_TEST_ASSERT(check.positionState == U_GEOFENCE_POSITION_STATE_OUTSIDE);
+    U_PORT_TEST_ASSERT(check.distanceMillimetres == LLONG_MIN);
+
+    // A position well outside both fences, with a large radius
+    // so that the far fence is not ruled out by its square
+    // extent, must still be found to be outside
+    U_PORT_TEST_ASSERT(uGeofenceContextTest(NULL, gpIndexFenceContext,
+                                            U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                                            latitudeX1e9 - 90000000LL, longitudeX1e9, INT_MIN,
+                                            200000, -1) == U_GEOFENCE_POSITION_STATE_OUTSIDE);
+
+    // At a speed which could cover the distance, nothing is skipped
+    gpIndexFenceContext->dynamic.maxHorizontalSpeedMillimetresPerSecond = INT_MAX;
+    uGeofenceContextGetCounts(gpIndexFenceContext, NULL, NULL, true);
+    uPortTaskBlock(100);
+    U_PORT_TEST_ASSERT(uGeofenceContextTest(NULL, gpIndexFenceContext,
+                                            U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                                            latitudeX1e9, longitudeX1e9, INT_MIN,
+                                            5000, -1) == U_GEOFENCE_POSITION_STATE_INSIDE);
+    uGeofenceContextGetCounts(gpIndexFenceContext, &numTested, &numSkipped, true);
+    U_PORT_TEST_ASSERT(numTested == 2);
+    U_PORT_TEST_ASSERT(numSkipped == 0);
+
+    // Back to 1 metre per second, skipping the far fence again, then
+    // apply another fence: everything must be tested afresh
+    gpIndexFenceContext->dynamic.maxHorizontalSpeedMillimetresPerSecond = 1000;
+    U_PORT_TEST_ASSERT(uGeofenceContextTest(NULL, gpIndexFenceContext,
+                                            U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                                            latitudeX1e9, longitudeX1e9, INT_MIN,
+                                            5000, -1) == U_GEOFENCE_POSITION_STATE_INSIDE);
+    uGeofenceContextGetCounts(gpIndexFenceContext, &numTested, &numSkipped, true);
+    U_PORT_TEST_ASSERT(numSkipped == 1);
+    U_PORT_TEST_ASSERT(uGeofenceApply(&gpIndexFenceContext, gpIndexFence[2]) == 0);
+    uGeofenceContextGetCounts(gpIndexFenceContext, NULL, NULL, true);
+    U_PORT_TEST_ASSERT(uGeofenceContextTest(NULL, gpIndexFenceContext,
+                                            U_GEOFENCE_TEST_TYPE_INSIDE, false,
+                                            latitudeX1e9, longitudeX1e9, INT_MIN,
+                                            5000, -1) == U_GEOFENCE_POSITION_STATE_INSIDE);
+    uGeofenceContextGetCounts(gpIndexFenceContext, &numTested, &numSkipped, true);
+    U_TEST_PRINT_LINE("after applying another fence: %u fence(s) tested, %u skipped.",
+                      (unsigned) numTested, (unsigned) numSkipped);
+    U_PORT_TEST_ASSERT(numTested == 3);
+    U_PORT_TEST_ASSERT(numSkipped == 0);
+
+    // Now just the square: a position inside it, about 40 metres
+    // from its west side and 10 metres from its south side, with a
+    // radius of 45 metres is uncertain, so the pessimist says it is
+    // outside; the same position with a radius of 5 metres is
+    // certainly inside and must not be skipped on the strength of
+    // what was found with the uncertain position
+    U_PORT_TEST_ASSERT(uGeofenceRemove(&gpIndexFenceContext, NULL) == 0);
+    U_PORT_TEST_ASSERT(uGeofenceApply(&gpIndexFenceContext, gpIndexFence[3]) == 0);
+    uGeofenceContextGetCounts(gpIndexFenceContext, NULL, NULL, true);
+    U_PORT_TEST_ASSERT(uGeofenceContextTest(NULL, gpIndexFenceContext,
+                                            U_GEOFENCE_TEST_TYPE_INSIDE, true,
+                                            latitudeX1e9 + 90000LL, longitudeX1e9 + 584000LL,
+                                            INT_MIN, 45000, -1) == U_GEOFENCE_POSITION_STATE_OUTSIDE);
+    U_PORT_TEST_ASSERT(uGeofenceContextTest(NULL, gpIndexFenceContext,
+                                            U_GEOFENCE_TEST_TYPE_INSIDE, true,
+                                            latitudeX1e9 + 90000LL, longitudeX1e9 + 584000LL,
+                                            INT_MIN, 5000, -1) == U_GEOFENCE_POSITION_STATE_INSIDE);
+    uGeofenceContextGetCounts(gpIndexFenceContext, &numTested, &numSkipped, true);
+    U_PORT_TEST_ASSERT(numTested == 2);
+    U_PORT_TEST_ASSERT(numSkipped == 0);
+
+    indexCleanUp();
+
+    // Free the mutex so that our memory sums add up
+    uGeofenceCleanUp();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
@@ -1153,6 +2140,7 @@ U_PORT_TEST_FUNCTION("[geofence]", "geofenceCleanUp")
 {
     // In case a fence was left hanging
     uGeofenceFree(gpFence);
+    indexCleanUp();
     uGeofenceCleanUp();
 
 #ifdef _WIN32
@@ -56,10 +56,67 @@ extern "C" {
  */
 #define U_SPARTN_MESSAGE_LENGTH_MAX_BYTES (4 + 8 + 1024 + 64 + 4)
 
+/** The number of SPARTN message types, i.e. the range of the
+ * 7-bit message type field (TF002).
+ */
+#define U_SPARTN_MESSAGE_TYPE_MAX_NUM 128
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Callback for a complete, validated, SPARTN message, as emitted
+ * by uSpartnReassemblerAdd().
+ *
+ * @param[in] pMessage       a pointer to the entire message, TF001
+ *                           to TF018; this points either into the
+ *                           data passed to uSpartnReassemblerAdd()
+ *                           or into the buffer of the reassembler
+ *                           and is only valid for the duration of
+ *                           the callback.
+ * @param size               the number of bytes at pMessage.
+ * @param[in] pCallbackParam the pCallbackParam that was passed to
+ *                           uSpartnReassemblerInit().
+ */
+typedef void (*uSpartnReassemblerCallback_t)(const char *pMessage,
+                                             size_t size,
+                                             void *pCallbackParam);
+
+/** Statistics kept by a SPARTN reassembler.
+ */
+typedef struct {
+    uint32_t messageCount[U_SPARTN_MESSAGE_TYPE_MAX_NUM]; /**< the number of
+                                                               valid messages
+                                                               emitted, indexed
+                                                               by message type
+                                                               (TF002). */
+    uint32_t crcFailureCount;  /**< the number of messages which had a
+                                    valid header but failed the message
+                                    CRC check. */
+    uint32_t discardedBytes;   /**< the number of bytes thrown away as
+                                    not being part of a valid message. */
+} uSpartnReassemblerStats_t;
+
+/** A SPARTN reassembler: this accepts a stream of data in chunks
+ * of any size, e.g. as read from an L-band receiver or from MQTT,
+ * and calls back with each complete, validated, SPARTN message in
+ * that stream.  Where a message is entirely contained in one chunk
+ * of data, the callback is given a pointer into that chunk; only a
+ * message split across chunks is copied, into the buffer of the
+ * reassembler.  The structure is owned by the caller, no heap is
+ * used; it should be initialised with uSpartnReassemblerInit() and
+ * the fields should be treated as private.
+ */
+typedef struct {
+    uSpartnReassemblerCallback_t pCallback;
+    void *pCallbackParam;
+    size_t bufferLength; /**< the number of bytes in buffer. */
+    uSpartnReassemblerStats_t stats;
+    char buffer[U_SPARTN_MESSAGE_LENGTH_MAX_BYTES]; /**< always begins with
+                                                         the start of a
+                                                         potential message. */
+} uSpartnReassembler_t;
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -145,6 +202,60 @@ int32_t uSpartnDetect(const char *pBuffer, size_t bufferLengthBytes,
 int32_t uSpartnValidate(const char *pBuffer, size_t bufferLengthBytes,
                         const char **ppMessage);
 
+/** Initialise a SPARTN reassembler, see #uSpartnReassembler_t; this
+ * may also be called to reset a reassembler that is in use.
+ *
+ * @param[out] pReassembler  a pointer to the reassembler to initialise;
+ *                           cannot be NULL.
+ * @param[in] pCallback      the callback to be called with each
+ *                           complete, validated, SPARTN message;
+ *                           cannot be NULL.
+ * @param[in] pCallbackParam a parameter that will be passed to
+ *                           pCallback; may be NULL.
+ * @return                   zero on success else negative error code.
+ */
+int32_t uSpartnReassemblerInit(uSpartnReassembler_t *pReassembler,
+                               uSpartnReassemblerCallback_t pCallback,
+                               void *pCallbackParam);
+
+/** Add a chunk of data to a SPARTN reassembler: any complete and
+ * valid SPARTN messages that result will be passed to the callback
+ * of the reassembler before this function returns, in the order in
+ * which they appear in the stream.  Data which is not part of a
+ * valid message is thrown away, as is a message that fails the
+ * message CRC check, in which case the search for a message
+ * resumes at the byte after its start.  Any partial message at the
+ * end of the data is retained for the next call.
+ *
+ * @param[in] pReassembler a pointer to the reassembler, which must
+ *                         have been initialised with
+ *                         uSpartnReassemblerInit(); cannot be NULL.
+ * @param[in] pData        the data to add; may be NULL if size is 0.
+ * @param size             the number of bytes at pData.
+ * @return                 the number of messages passed to the
+ *                         callback, else negative error code.
+ */
+int32_t uSpartnReassemblerAdd(uSpartnReassembler_t *pReassembler,
+                              const char *pData, size_t size);
+
+/** Throw away any partial message held by a SPARTN reassembler, e.g.
+ * because there has been a break in the stream; the statistics
+ * are not affected.
+ *
+ * @param[in] pReassembler a pointer to the reassembler; cannot be NULL.
+ */
+void uSpartnReassemblerReset(uSpartnReassembler_t *pReassembler);
+
+/** Get the statistics of a SPARTN reassembler.
+ *
+ * @param[in] pReassembler a pointer to the reassembler; cannot be NULL.
+ * @param[out] pStats      a pointer to a place to put the statistics;
+ *                         cannot be NULL.
+ * @return                 zero on success else negative error code.
+ */
+int32_t uSpartnReassemblerGetStats(const uSpartnReassembler_t *pReassembler,
+                                   uSpartnReassemblerStats_t *pStats);
+
 #ifdef __cplusplus
 }
 #endif
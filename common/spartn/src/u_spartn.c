@@ -93,7 +93,7 @@
 #include "stddef.h"    // NULL, size_t etc.
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
-#include "string.h"    // memcpy()
+#include "string.h"    // memcpy(), memmove(), memset()
 
 #include "u_error_common.h"
 
@@ -123,7 +123,9 @@
  * -------------------------------------------------------------- */
 
 // Look for a SPARTN message header in a buffer and supply its position,
-// plus the message CRC position and type.
+// plus the message CRC position and type; the position is also supplied
+// if U_ERROR_COMMON_TIMEOUT is returned, i.e. the start of a potential
+// header has been found but more data is needed.
 static int32_t decodeHeader(const char *pBuffer, size_t bufferLengthBytes,
                             const char **ppMessage,
                             const char **ppMessageCrcStart,
@@ -265,13 +267,135 @@ static int32_t decodeHeader(const char *pBuffer, size_t bufferLengthBytes,
         }
     }
 
-    if ((sizeOrErrorCode >= 0) && (ppMessage != NULL)) {
+    if (((sizeOrErrorCode >= 0) || (sizeOrErrorCode == (int32_t) U_ERROR_COMMON_TIMEOUT)) &&
+        (ppMessage != NULL)) {
         *ppMessage = (const char *) pMessage;
     }
 
     return sizeOrErrorCode;
 }
 
+// Check the message CRC of a SPARTN message whose header has been
+// decoded by decodeHeader().
+static bool crcCheck(const char *pMessage, const char *pMessageCrcStart,
+                     uSpartnCrcType_t messageCrcType)
+{
+    bool crcGood = false;
+    const uint8_t *pCrc = (const uint8_t *) pMessageCrcStart;
+    size_t crcLength;
+    uint32_t crcFromMessage;
+
+    // The message CRC is over the whole message, except
+    // the first byte, up to the start of the CRC and the
+    // CRC value is MSB first like all the others
+    crcLength = pMessageCrcStart - pMessage - 1;
+    switch (messageCrcType) {
+        case U_SPARTN_CRC_TYPE_8:
+            crcFromMessage = *pCrc;
+            crcGood = (uSpartnCrc8(pMessage + 1, crcLength) == crcFromMessage);
+            break;
+        case U_SPARTN_CRC_TYPE_16:
+            crcFromMessage = (((uint32_t) * pCrc) << 8) +
+                             (uint32_t) * (pCrc + 1);
+            crcGood = (uSpartnCrc16(pMessage + 1, crcLength) == crcFromMessage);
+            break;
+        case U_SPARTN_CRC_TYPE_24:
+            crcFromMessage = (((uint32_t) * pCrc) << 16) +
+                             ((uint32_t) * (pCrc + 1) << 8) +
+                             (uint32_t) * (pCrc + 2);
+            crcGood = (uSpartnCrc24(pMessage + 1, crcLength) == crcFromMessage);
+            break;
+        case U_SPARTN_CRC_TYPE_32:
+            crcFromMessage = (((uint32_t) * pCrc) << 24) +
+                             ((uint32_t) * (pCrc + 1) << 16) +
+                             ((uint32_t) * (pCrc + 2) << 8) +
+                             (uint32_t) * (pCrc + 3);
+            crcGood = (uSpartnCrc32(pMessage + 1, crcLength) == crcFromMessage);
+            break;
+        default:
+            break;
+    }
+
+    return crcGood;
+}
+
+// Work through a linear block of data on behalf of a reassembler,
+// calling back with the valid messages in it and counting them
+// into *pCount; returns the number of bytes used, the remainder
+// being the start of a potential message which is not yet complete.
+static size_t reassemble(uSpartnReassembler_t *pReassembler,
+                         const char *pData, size_t size, int32_t *pCount)
+{
+    size_t used = 0;
+    int32_t messageLength;
+    const char *pMessage = NULL;
+    const char *pMessageCrcStart = NULL;
+    uSpartnCrcType_t messageCrcType = U_SPARTN_CRC_TYPE_NONE;
+    size_t x;
+    bool partial = false;
+
+    while ((used < size) && !partial) {
+        messageLength = decodeHeader(pData + used, size - used, &pMessage,
+                                     &pMessageCrcStart, &messageCrcType);
+        if (messageLength == (int32_t) U_ERROR_COMMON_NOT_FOUND) {
+            // Nothing that looks like a message at all
+            pReassembler->stats.discardedBytes += (uint32_t) (size - used);
+            used = size;
+        } else {
+            // Skip to the start of the potential message
+            x = pMessage - (pData + used);
+            pReassembler->stats.discardedBytes += (uint32_t) x;
+            used += x;
+            if ((messageLength < 0) || ((size_t) messageLength > size - used)) {
+                // Not enough data yet to know
+                partial = true;
+            } else if (crcCheck(pMessage, pMessageCrcStart, messageCrcType)) {
+                // The message type is the upper seven bits of the
+                // byte after the preamble
+                pReassembler->stats.messageCount[((uint8_t) pMessage[1]) >> 1]++;
+                (*pCount)++;
+                pReassembler->pCallback(pMessage, (size_t) messageLength,
+                                        pReassembler->pCallbackParam);
+                used += messageLength;
+            } else {
+                // Not a message after all, look again from the
+                // byte after what we thought was its start
+                pReassembler->stats.crcFailureCount++;
+                pReassembler->stats.discardedBytes++;
+                used++;
+            }
+        }
+    }
+
+    return used;
+}
+
+// Return the number of bytes that the partial message in the buffer of
+// a reassembler needs in order to be complete or, if the length of the
+// message is not yet known, in order for that to be determined.
+static size_t reassemblerBytesNeeded(const uSpartnReassembler_t *pReassembler)
+{
+    size_t needed;
+    int32_t messageLength;
+
+    messageLength = decodeHeader(pReassembler->buffer, pReassembler->bufferLength,
+                                 NULL, NULL, NULL);
+    if (messageLength > 0) {
+        needed = messageLength;
+    } else if (pReassembler->bufferLength < U_SPARTN_HEADER_LENGTH_MIN_BYTES) {
+        needed = U_SPARTN_HEADER_LENGTH_MIN_BYTES;
+    } else {
+        // Must be an encrypted message, the ENCRYPT/AUTH fields
+        // follow a 16 or 32-bit GNSS time tag (TF009)
+        needed = U_SPARTN_HEADER_LENGTH_MIN_BYTES + 2;
+        if (pReassembler->buffer[4] & 0x08) {
+            needed += 2;
+        }
+    }
+
+    return needed - pReassembler->bufferLength;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -280,7 +404,15 @@ static int32_t decodeHeader(const char *pBuffer, size_t bufferLengthBytes,
 int32_t uSpartnDetect(const char *pBuffer, size_t bufferLengthBytes,
                       const char **ppMessage)
 {
-    return decodeHeader(pBuffer, bufferLengthBytes, ppMessage, NULL, NULL);
+    int32_t sizeOrErrorCode;
+    const char *pMessage = NULL;
+
+    sizeOrErrorCode = decodeHeader(pBuffer, bufferLengthBytes, &pMessage, NULL, NULL);
+    if ((sizeOrErrorCode >= 0) && (ppMessage != NULL)) {
+        *ppMessage = pMessage;
+    }
+
+    return sizeOrErrorCode;
 }
 
 // Validate a SPARTN message.
@@ -290,13 +422,11 @@ int32_t uSpartnValidate(const char *pBuffer, size_t bufferLengthBytes,
     int32_t sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
     int32_t messageLength;
     const char *pMessage = NULL;
-    const uint8_t *pMessageCrcStart = NULL;
+    const char *pMessageCrcStart = NULL;
     uSpartnCrcType_t messageCrcType = U_SPARTN_CRC_TYPE_NONE;
-    size_t crcLength;
-    uint32_t crcFromMessage;
 
     messageLength = decodeHeader(pBuffer, bufferLengthBytes, &pMessage,
-                                 (const char **) &pMessageCrcStart, &messageCrcType);
+                                 &pMessageCrcStart, &messageCrcType);
     if (messageLength > 0) {
         sizeOrErrorCode = (int32_t) U_ERROR_COMMON_TIMEOUT;
         if (((int32_t) bufferLengthBytes - (pMessage - pBuffer) >= messageLength) &&
@@ -304,43 +434,8 @@ int32_t uSpartnValidate(const char *pBuffer, size_t bufferLengthBytes,
             sizeOrErrorCode = (int32_t) U_ERROR_COMMON_NOT_FOUND;
             // Got a header and enough room for the whole body
             // to be contained, let's see if the body is valid
-            // The message CRC is over the whole message, except
-            // the first byte, up to the start of the CRC and the
-            // CRC value is MSB first like all the others
-            crcLength = ((const char *) pMessageCrcStart) - pMessage - 1;
-            switch (messageCrcType) {
-                case U_SPARTN_CRC_TYPE_8:
-                    crcFromMessage = *pMessageCrcStart;
-                    if (uSpartnCrc8(pMessage + 1, crcLength) == crcFromMessage) {
-                        sizeOrErrorCode = messageLength;
-                    }
-                    break;
-                case U_SPARTN_CRC_TYPE_16:
-                    crcFromMessage = (((uint32_t) * pMessageCrcStart) << 8) +
-                                     (uint32_t) * (pMessageCrcStart + 1);
-                    if (uSpartnCrc16(pMessage + 1, crcLength) == crcFromMessage) {
-                        sizeOrErrorCode = messageLength;
-                    }
-                    break;
-                case U_SPARTN_CRC_TYPE_24:
-                    crcFromMessage = (((uint32_t) * pMessageCrcStart) << 16) +
-                                     ((uint32_t) * (pMessageCrcStart + 1) << 8) +
-                                     (uint32_t) * (pMessageCrcStart + 2);
-                    if (uSpartnCrc24(pMessage + 1, crcLength) == crcFromMessage) {
-                        sizeOrErrorCode = messageLength;
-                    }
-                    break;
-                case U_SPARTN_CRC_TYPE_32:
-                    crcFromMessage = (((uint32_t) * pMessageCrcStart) << 24) +
-                                     ((uint32_t) * (pMessageCrcStart + 1) << 16) +
-                                     ((uint32_t) * (pMessageCrcStart + 2) << 8) +
-                                     (uint32_t) * (pMessageCrcStart + 3);
-                    if (uSpartnCrc32(pMessage + 1, crcLength) == crcFromMessage) {
-                        sizeOrErrorCode = messageLength;
-                    }
-                    break;
-                default:
-                    break;
+            if (crcCheck(pMessage, pMessageCrcStart, messageCrcType)) {
+                sizeOrErrorCode = messageLength;
             }
         }
     }
@@ -352,4 +447,89 @@ int32_t uSpartnValidate(const char *pBuffer, size_t bufferLengthBytes,
     return sizeOrErrorCode;
 }
 
+// Initialise a SPARTN reassembler.
+int32_t uSpartnReassemblerInit(uSpartnReassembler_t *pReassembler,
+                               uSpartnReassemblerCallback_t pCallback,
+                               void *pCallbackParam)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pReassembler != NULL) && (pCallback != NULL)) {
+        memset(pReassembler, 0, sizeof(*pReassembler));
+        pReassembler->pCallback = pCallback;
+        pReassembler->pCallbackParam = pCallbackParam;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+// Add a chunk of data to a SPARTN reassembler.
+int32_t uSpartnReassemblerAdd(uSpartnReassembler_t *pReassembler,
+                              const char *pData, size_t size)
+{
+    int32_t errorCodeOrCount = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    size_t used;
+    size_t x;
+
+    if ((pReassembler != NULL) && (pReassembler->pCallback != NULL) &&
+        ((pData != NULL) || (size == 0))) {
+        errorCodeOrCount = 0;
+        while (size > 0) {
+            if (pReassembler->bufferLength == 0) {
+                // Nothing held over from last time: work directly on
+                // the caller's data, so that whole messages needn't
+                // be copied, and keep whatever partial message is left
+                used = reassemble(pReassembler, pData, size, &errorCodeOrCount);
+                pReassembler->bufferLength = size - used;
+                memcpy(pReassembler->buffer, pData + used, pReassembler->bufferLength);
+                size = 0;
+            } else {
+                // Top up the partial message in the buffer with only
+                // as much as it needs, so that the buffer empties,
+                // and we're back to working on the caller's data,
+                // as soon as possible
+                x = reassemblerBytesNeeded(pReassembler);
+                if (x > size) {
+                    x = size;
+                }
+                memcpy(pReassembler->buffer + pReassembler->bufferLength, pData, x);
+                pReassembler->bufferLength += x;
+                pData += x;
+                size -= x;
+                used = reassemble(pReassembler, pReassembler->buffer,
+                                  pReassembler->bufferLength, &errorCodeOrCount);
+                pReassembler->bufferLength -= used;
+                memmove(pReassembler->buffer, pReassembler->buffer + used,
+                        pReassembler->bufferLength);
+            }
+        }
+    }
+
+    return errorCodeOrCount;
+}
+
+// Reset a SPARTN reassembler.
+void uSpartnReassemblerReset(uSpartnReassembler_t *pReassembler)
+{
+    if (pReassembler != NULL) {
+        pReassembler->stats.discardedBytes += (uint32_t) pReassembler->bufferLength;
+        pReassembler->bufferLength = 0;
+    }
+}
+
+// Get the statistics of a SPARTN reassembler.
+int32_t uSpartnReassemblerGetStats(const uSpartnReassembler_t *pReassembler,
+                                   uSpartnReassemblerStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pReassembler != NULL) && (pStats != NULL)) {
+        *pStats = pReassembler->stats;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
 // End of file
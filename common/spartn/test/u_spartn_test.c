@@ -55,6 +55,8 @@
 #include "u_spartn_crc.h"
 #include "u_spartn_test_data.h"
 
+#include "u_crc.h"
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
@@ -82,6 +84,13 @@
 # define U_SPARTN_TEST_BUFFER_SIZE_BYTES (U_SPARTN_MESSAGE_LENGTH_MAX_BYTES + U_SPARTN_TEST_BUFFER_EXTRA_SIZE_BYTES)
 #endif
 
+#ifndef U_SPARTN_TEST_CRC_BENCHMARK_ITERATIONS
+/** The number of times to pass over #gUSpartnTestData when
+ * benchmarking the CRC functions.
+ */
+# define U_SPARTN_TEST_CRC_BENCHMARK_ITERATIONS 1000
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -103,6 +112,17 @@ typedef struct {
     uint32_t result;
 } uSpartnTest_t;
 
+/** Struct to track the messages passed to reassemblerCallback().
+ */
+typedef struct {
+    size_t messageCount;
+    size_t zeroCopyCount;   /**< messages pointing into the input data. */
+    const char *pInput;     /**< the data being passed to the reassembler. */
+    size_t inputSize;
+    size_t offset;          /**< where the next message should be in pInput. */
+    size_t mismatchCount;
+} uSpartnTestReassembler_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -249,6 +269,58 @@ static crc24 crc_octets(unsigned char *octets, size_t len)
     return crc & 0xFFFFFFL;
 }
 
+// Populate a byte-wise table for an MSB-first CRC with the
+// given polynomial, left-aligned in 32 bits: the way CRCs were
+// computed before they were moved to u_crc.c, used as the
+// baseline for the benchmark.
+static void crcTableMake(uint32_t polynomial, uint32_t *pTable)
+{
+    uint32_t value;
+
+    for (size_t x = 0; x < 256; x++) {
+        value = ((uint32_t) x) << 24;
+        for (size_t y = 0; y < 8; y++) {
+            if (value & 0x80000000U) {
+                value = (value << 1) ^ polynomial;
+            } else {
+                value <<= 1;
+            }
+        }
+        pTable[x] = value;
+    }
+}
+
+// Compute a left-aligned CRC a byte at a time using a table
+// from crcTableMake().
+static uint32_t crcBytewise(const uint32_t *pTable, uint32_t crc,
+                            const char *pData, size_t size)
+{
+    for (size_t x = 0; x < size; x++) {
+        crc = (crc << 8) ^ pTable[(crc >> 24) ^ (uint8_t) pData[x]];
+    }
+
+    return crc;
+}
+
+// Callback for the SPARTN reassembler: the test data is back-to-back
+// SPARTN messages, so each message should follow on from the last.
+static void reassemblerCallback(const char *pMessage, size_t size,
+                                void *pCallbackParam)
+{
+    uSpartnTestReassembler_t *pContext = (uSpartnTestReassembler_t *) pCallbackParam;
+
+    pContext->messageCount++;
+    if ((pMessage >= pContext->pInput) &&
+        (pMessage < pContext->pInput + pContext->inputSize)) {
+        pContext->zeroCopyCount++;
+    }
+    if ((pContext->offset + size > pContext->inputSize) ||
+        (memcmp(pMessage, pContext->pInput + pContext->offset, size) != 0)) {
+        pContext->mismatchCount++;
+    }
+    pContext->offset += size;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: TESTS
  * -------------------------------------------------------------- */
@@ -454,6 +526,236 @@ U_PORT_TEST_FUNCTION("[spartn]", "spartnMessage")
 
 #endif // __ZEPHYR__
 
+/** Test the SPARTN reassembler by passing it the SPARTN test data in
+ * chunks of varying size; a linear congruential generator is used
+ * for the sizes, rather than rand(), so that this can run on all
+ * platforms.
+ */
+U_PORT_TEST_FUNCTION("[spartn]", "spartnReassembler")
+{
+    int32_t resourceCount;
+    uSpartnReassembler_t *pReassembler;
+    uSpartnReassemblerStats_t stats;
+    uSpartnTestReassembler_t context;
+    char *pBuffer;
+    const char *pMessage;
+    int32_t messageLength;
+    int32_t messageCount;
+    uint32_t random = 0x5A5A5A5A;
+    size_t offset;
+    size_t x;
+    size_t y;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_TEST_PRINT_LINE("testing SPARTN reassembly.");
+
+    pReassembler = (uSpartnReassembler_t *) pUPortMalloc(sizeof(*pReassembler));
+    U_PORT_TEST_ASSERT(pReassembler != NULL);
+    U_PORT_TEST_ASSERT(uSpartnReassemblerInit(NULL, reassemblerCallback,
+                                              &context) < 0);
+    U_PORT_TEST_ASSERT(uSpartnReassemblerInit(pReassembler, NULL, &context) < 0);
+
+    // First a byte at a time, so that every message has to be
+    // reassembled, then in chunks of up to 300 bytes, where
+    // most messages should be passed on without a copy
+    for (size_t pass = 0; pass < 2; pass++) {
+        memset(&context, 0, sizeof(context));
+        context.pInput = gUSpartnTestData;
+        context.inputSize = gUSpartnTestDataSize;
+        U_PORT_TEST_ASSERT(uSpartnReassemblerInit(pReassembler, reassemblerCallback,
+                                                  &context) == 0);
+        messageCount = 0;
+        offset = 0;
+        while (offset < gUSpartnTestDataSize) {
+            x = 1;
+            if (pass > 0) {
+                random = (random * 1103515245U) + 12345U;
+                x = ((random >> 16) % 300) + 1;
+            }
+            if (x > gUSpartnTestDataSize - offset) {
+                x = gUSpartnTestDataSize - offset;
+            }
+            messageLength = uSpartnReassemblerAdd(pReassembler,
+                                                  gUSpartnTestData + offset, x);
+            U_PORT_TEST_ASSERT(messageLength >= 0);
+            messageCount += messageLength;
+            offset += x;
+        }
+        U_TEST_PRINT_LINE("pass %d: %d message(s) out of %d, %d without a copy.",
+                          (int) pass + 1, (int) context.messageCount,
+                          (int) gUSpartnTestDataNumMessages, (int) context.zeroCopyCount);
+        U_PORT_TEST_ASSERT(context.messageCount == gUSpartnTestDataNumMessages);
+        U_PORT_TEST_ASSERT(messageCount == (int32_t) gUSpartnTestDataNumMessages);
+        U_PORT_TEST_ASSERT(context.mismatchCount == 0);
+        U_PORT_TEST_ASSERT(context.offset == gUSpartnTestDataSize);
+        if (pass == 0) {
+            U_PORT_TEST_ASSERT(context.zeroCopyCount == 0);
+        } else {
+            U_PORT_TEST_ASSERT(context.zeroCopyCount > 0);
+        }
+        U_PORT_TEST_ASSERT(uSpartnReassemblerGetStats(pReassembler, &stats) == 0);
+        y = 0;
+        for (x = 0; x < U_SPARTN_MESSAGE_TYPE_MAX_NUM; x++) {
+            y += stats.messageCount[x];
+        }
+        U_PORT_TEST_ASSERT(y == gUSpartnTestDataNumMessages);
+        U_PORT_TEST_ASSERT(stats.crcFailureCount == 0);
+        U_PORT_TEST_ASSERT(stats.discardedBytes == 0);
+    }
+
+    // Now corrupt the body of the first message in a copy of the
+    // test data, preceded by some rubbish: the message should fail
+    // its CRC check and all of the others should still be found
+    messageLength = uSpartnValidate(gUSpartnTestData, gUSpartnTestDataSize, &pMessage);
+    U_PORT_TEST_ASSERT(messageLength > 0);
+    U_PORT_TEST_ASSERT(pMessage == gUSpartnTestData);
+    pBuffer = (char *) pUPortMalloc(gUSpartnTestDataSize + 3);
+    U_PORT_TEST_ASSERT(pBuffer != NULL);
+    memcpy(pBuffer, "abc", 3);
+    memcpy(pBuffer + 3, gUSpartnTestData, gUSpartnTestDataSize);
+    *(pBuffer + 3 + (messageLength / 2)) ^= 0x01;
+    memset(&context, 0, sizeof(context));
+    context.pInput = pBuffer;
+    context.inputSize = gUSpartnTestDataSize + 3;
+    context.offset = messageLength + 3;
+    U_PORT_TEST_ASSERT(uSpartnReassemblerInit(pReassembler, reassemblerCallback,
+                                              &context) == 0);
+    U_PORT_TEST_ASSERT(uSpartnReassemblerAdd(pReassembler, pBuffer,
+                                             gUSpartnTestDataSize + 3) ==
+                       (int32_t) gUSpartnTestDataNumMessages - 1);
+    U_PORT_TEST_ASSERT(context.messageCount == gUSpartnTestDataNumMessages - 1);
+    U_PORT_TEST_ASSERT(context.mismatchCount == 0);
+    U_PORT_TEST_ASSERT(uSpartnReassemblerGetStats(pReassembler, &stats) == 0);
+    U_TEST_PRINT_LINE("with a corrupt message: %d CRC failure(s), %d byte(s) discarded.",
+                      (int) stats.crcFailureCount, (int) stats.discardedBytes);
+    U_PORT_TEST_ASSERT(stats.crcFailureCount > 0);
+    U_PORT_TEST_ASSERT(stats.discardedBytes >= (uint32_t) messageLength + 3);
+
+    // Leave a partial message in the reassembler, reset it and
+    // check that it has been thrown away
+    x = stats.discardedBytes;
+    U_PORT_TEST_ASSERT(uSpartnReassemblerAdd(pReassembler, gUSpartnTestData, 10) == 0);
+    uSpartnReassemblerReset(pReassembler);
+    U_PORT_TEST_ASSERT(uSpartnReassemblerGetStats(pReassembler, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.discardedBytes == x + 10);
+
+    // Free memory
+    uPortFree(pBuffer);
+    uPortFree(pReassembler);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Benchmark the CRC engine over the SPARTN test data: CRC-24 and
+ * CRC-32 against a byte-wise table lookup, plus the time taken to
+ * validate all of the messages in the test data; the results are
+ * printed, only correctness is asserted.
+ */
+U_PORT_TEST_FUNCTION("[spartn]", "spartnCrcBenchmark")
+{
+    int32_t resourceCount;
+    uint32_t *pTable;
+    uint32_t crcBytewise24 = 0;
+    uint32_t crcBytewise32 = 0;
+    uint32_t crc24 = 0;
+    uint32_t crc32 = 0;
+    int32_t timesMs[5];
+    int32_t startTimeMs;
+    const char *pData;
+    const char *pMessage;
+    int32_t messageLength;
+    size_t messageCount = 0;
+    int32_t kbytes;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    pTable = (uint32_t *) pUPortMalloc(256 * sizeof(uint32_t));
+    U_PORT_TEST_ASSERT(pTable != NULL);
+
+    // Each pass carries the CRC on from the last so that
+    // none of the work can be optimised away
+    crcTableMake(0x864CFB00U, pTable);
+    startTimeMs = uPortGetTickTimeMs();
+    for (size_t x = 0; x < U_SPARTN_TEST_CRC_BENCHMARK_ITERATIONS; x++) {
+        crcBytewise24 = crcBytewise(pTable, crcBytewise24, gUSpartnTestData,
+                                    gUSpartnTestDataSize);
+    }
+    timesMs[0] = uPortGetTickTimeMs() - startTimeMs;
+    startTimeMs = uPortGetTickTimeMs();
+    for (size_t x = 0; x < U_SPARTN_TEST_CRC_BENCHMARK_ITERATIONS; x++) {
+        crc24 = uCrc24q(crc24, gUSpartnTestData, gUSpartnTestDataSize);
+    }
+    timesMs[1] = uPortGetTickTimeMs() - startTimeMs;
+    U_PORT_TEST_ASSERT(crc24 == crcBytewise24 >> 8);
+
+    crcTableMake(0x04C11DB7U, pTable);
+    startTimeMs = uPortGetTickTimeMs();
+    for (size_t x = 0; x < U_SPARTN_TEST_CRC_BENCHMARK_ITERATIONS; x++) {
+        crcBytewise32 = crcBytewise(pTable, crcBytewise32, gUSpartnTestData,
+                                    gUSpartnTestDataSize);
+    }
+    timesMs[2] = uPortGetTickTimeMs() - startTimeMs;
+    startTimeMs = uPortGetTickTimeMs();
+    for (size_t x = 0; x < U_SPARTN_TEST_CRC_BENCHMARK_ITERATIONS; x++) {
+        crc32 = uCrc32(crc32, gUSpartnTestData, gUSpartnTestDataSize);
+    }
+    timesMs[3] = uPortGetTickTimeMs() - startTimeMs;
+    U_PORT_TEST_ASSERT(crc32 == crcBytewise32);
+
+    uPortFree(pTable);
+
+    // Validate every message in the test data, which is
+    // back-to-back SPARTN messages
+    startTimeMs = uPortGetTickTimeMs();
+    for (size_t x = 0; x < U_SPARTN_TEST_CRC_BENCHMARK_ITERATIONS; x++) {
+        pData = gUSpartnTestData;
+        do {
+            messageLength = uSpartnValidate(pData, gUSpartnTestDataSize -
+                                            (pData - gUSpartnTestData), &pMessage);
+            if (messageLength > 0) {
+                pData = pMessage + messageLength;
+                messageCount++;
+            }
+        } while (messageLength > 0);
+    }
+    timesMs[4] = uPortGetTickTimeMs() - startTimeMs;
+    U_PORT_TEST_ASSERT(messageCount == gUSpartnTestDataNumMessages *
+                       U_SPARTN_TEST_CRC_BENCHMARK_ITERATIONS);
+
+    kbytes = (int32_t) ((gUSpartnTestDataSize * U_SPARTN_TEST_CRC_BENCHMARK_ITERATIONS) / 1024);
+    U_TEST_PRINT_LINE("%d kbyte(s) of SPARTN test data, \"%s\" implementation:",
+                      kbytes, uCrcImplementation());
+    U_TEST_PRINT_LINE("  CRC-24 byte-wise %d ms, uCrc24q() %d ms.",
+                      timesMs[0], timesMs[1]);
+    U_TEST_PRINT_LINE("  CRC-32 byte-wise %d ms, uCrc32() %d ms.",
+                      timesMs[2], timesMs[3]);
+    U_TEST_PRINT_LINE("  uSpartnValidate() %d message(s) in %d ms.",
+                      (int) messageCount, timesMs[4]);
+
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
@@ -35,6 +35,8 @@
 
 #include "u_error_common.h"
 
+#include "u_checksum.h"
+
 #include "u_ubx_protocol.h"
 
 /* ----------------------------------------------------------------
@@ -170,8 +172,7 @@ int32_t uUbxProtocolEncode(int32_t messageClass, int32_t messageId,
     int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
     // Use a uint8_t pointer for maths, more certain of its behaviour than char
     uint8_t *pWrite = (uint8_t *) pBuffer;
-    int32_t ca = 0;
-    int32_t cb = 0;
+    uint16_t checksum;
 
     if (((messageBodyLengthBytes == 0) || (pMessage != NULL)) &&
         (pBuffer != NULL)) {
@@ -192,16 +193,11 @@ int32_t uUbxProtocolEncode(int32_t messageClass, int32_t messageId,
 
         // Work out the CRC over the variable elements of the
         // header and the body
-        pBuffer += 2;
-        for (size_t x = 0; x < messageBodyLengthBytes + 4; x++) {
-            ca += (uint8_t) *pBuffer; // *NOPAD*
-            cb += ca;
-            pBuffer++;
-        }
+        checksum = uChecksumFletcher8(0, pBuffer + 2, messageBodyLengthBytes + 4);
 
         // Write in the CRC
-        *pWrite++ = (uint8_t) (ca & (uint8_t) 0xff);
-        *pWrite = (uint8_t) (cb & (uint8_t) 0xff);
+        *pWrite++ = (uint8_t) (checksum & 0xff);
+        *pWrite = (uint8_t) (checksum >> 8);
 
         errorCodeOrLength = (int32_t) (U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES + messageBodyLengthBytes);
     }
@@ -222,6 +218,9 @@ int32_t uUbxProtocolDecode(const char *pBufferIn, size_t bufferLengthBytes,
     bool updateCrc = false;
     size_t expectedMessageByteCount = 0;
     size_t messageByteCount = 0;
+    size_t runLength;
+    size_t copyLength;
+    uint16_t checksum;
     int32_t ca = 0;
     int32_t cb = 0;
 
@@ -283,13 +282,30 @@ int32_t uUbxProtocolDecode(const char *pBufferIn, size_t bufferLengthBytes,
                 break;
             case 6:
                 if (messageByteCount < expectedMessageByteCount) {
-                    // Store the next byte of the message and
-                    // update CRC
+                    // Take as much of the message body as there is
+                    // in the buffer in one go: store what fits and
+                    // update the CRC over all of it
+                    runLength = expectedMessageByteCount - messageByteCount;
+                    if (runLength > bufferLengthBytes - x) {
+                        runLength = bufferLengthBytes - x;
+                    }
                     if ((pMessage != NULL) && (messageByteCount < maxMessageLengthBytes)) {
-                        *pMessage++ = (char) *pInput; // *NOPAD*
+                        copyLength = maxMessageLengthBytes - messageByteCount;
+                        if (copyLength > runLength) {
+                            copyLength = runLength;
+                        }
+                        memcpy(pMessage, pInput, copyLength);
+                        pMessage += copyLength;
                     }
-                    updateCrc = true;
-                    messageByteCount++;
+                    checksum = uChecksumFletcher8((uint16_t) (((cb & 0xff) << 8) | (ca & 0xff)),
+                                                  (const char *) pInput, runLength);
+                    ca = checksum & 0xff;
+                    cb = checksum >> 8;
+                    messageByteCount += runLength;
+                    // Leave pInput and x on the last byte of the run,
+                    // the loop will move them on
+                    pInput += runLength - 1;
+                    x += runLength - 1;
                 } else {
                     // First byte of CRC, check it
                     ca &= 0xff;
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_CHECKSUM_H_
+#define _U_CHECKSUM_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup __utils __Utilities
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the checksum functions used by
+ * the UBX and NMEA protocol code: the 8-bit Fletcher checksum of
+ * UBX and the 8-bit XOR checksum of NMEA.
+ *
+ * Where the compiler and target allow, these are implemented with
+ * SIMD instructions (SSE2 or AVX2 on x86, NEON on ARM), the AVX2
+ * version being chosen at run-time if the CPU supports it, with a
+ * scalar implementation used otherwise; define
+ * U_CFG_CHECKSUM_NO_SIMD to force the scalar implementation.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Add a block of data to an 8-bit Fletcher checksum, as used
+ * by the UBX protocol.
+ *
+ * @param checksum the checksum so far, CK_A in the least significant
+ *                 byte and CK_B in the most significant byte; use
+ *                 0 to start a new checksum.
+ * @param pData    the data to add; may be NULL if size is 0.
+ * @param size     the number of bytes at pData.
+ * @return         the updated checksum, CK_A in the least
+ *                 significant byte and CK_B in the most significant
+ *                 byte.
+ */
+uint16_t uChecksumFletcher8(uint16_t checksum, const char *pData,
+                            size_t size);
+
+/** Add a block of data to an 8-bit XOR checksum, as used by
+ * the NMEA protocol.
+ *
+ * @param checksum the checksum so far; use 0 to start a new
+ *                 checksum.
+ * @param pData    the data to add; may be NULL if size is 0.
+ * @param size     the number of bytes at pData.
+ * @return         the updated checksum.
+ */
+uint8_t uChecksumXor8(uint8_t checksum, const char *pData, size_t size);
+
+/** Get the name of the checksum implementation in use, e.g.
+ * "scalar", "sse2", "avx2" or "neon"; intended for debug and
+ * test purposes.
+ *
+ * @return the name of the implementation in use.
+ */
+const char *uChecksumImplementation();
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_CHECKSUM_H_
+
+// End of file
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_CRC_H_
+#define _U_CRC_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup __utils __Utilities
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the CRC functions shared by the
+ * SPARTN and RTCM code.  All of the CRCs are MSB-first (not
+ * reflected) and none apply an output XOR: where a protocol
+ * requires one (e.g. SPARTN CRC-32), the caller does it.
+ *
+ * By default the CRCs are computed a byte at a time from a 1 kbyte
+ * table per polynomial, held in flash.  On 64-bit platforms, or if
+ * U_CFG_CRC_SLICE_BY_8 is defined, the CRCs are computed 8 bytes at
+ * a time, which requires a further 7 kbytes of RAM per polynomial,
+ * populated on first use of that polynomial; define
+ * U_CFG_CRC_NO_SLICE_BY_8 to prevent this.  In addition, on x86-64
+ * with GCC or Clang, if the CPU supports the PCLMULQDQ instruction
+ * it is used for blocks of 64 bytes or more; define
+ * U_CFG_CRC_NO_SIMD to prevent this.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Add a block of data to a CRC-8 with polynomial 0x07, as used
+ * by SPARTN.
+ *
+ * @param crc    the CRC so far; use the initial value of the CRC
+ *               (0 for SPARTN) to start a new CRC.
+ * @param pData  the data to add; may be NULL if size is 0.
+ * @param size   the number of bytes at pData.
+ * @return       the updated CRC.
+ */
+uint8_t uCrc8(uint8_t crc, const char *pData, size_t size);
+
+/** Add a block of data to a CRC-16 with polynomial 0x1021 (CCITT),
+ * as used by SPARTN.
+ *
+ * @param crc    the CRC so far; use the initial value of the CRC
+ *               (0 for SPARTN) to start a new CRC.
+ * @param pData  the data to add; may be NULL if size is 0.
+ * @param size   the number of bytes at pData.
+ * @return       the updated CRC.
+ */
+uint16_t uCrc16(uint16_t crc, const char *pData, size_t size);
+
+/** Add a block of data to a CRC-24Q, polynomial 0x864CFB, as used
+ * by RTCM and SPARTN.
+ *
+ * @param crc    the CRC so far, in the least significant 24 bits;
+ *               use 0 to start a new CRC.
+ * @param pData  the data to add; may be NULL if size is 0.
+ * @param size   the number of bytes at pData.
+ * @return       the updated CRC, in the least significant 24 bits.
+ */
+uint32_t uCrc24q(uint32_t crc, const char *pData, size_t size);
+
+/** Add a block of data to a CRC-32 with polynomial 0x04C11DB7,
+ * not reflected; for the CRC-32 of SPARTN (a.k.a. CRC-32/BZIP2)
+ * start with 0xFFFFFFFF and invert the final result.
+ *
+ * @param crc    the CRC so far; use the initial value of the CRC
+ *               to start a new CRC.
+ * @param pData  the data to add; may be NULL if size is 0.
+ * @param size   the number of bytes at pData.
+ * @return       the updated CRC.
+ */
+uint32_t uCrc32(uint32_t crc, const char *pData, size_t size);
+
+/** Get the name of the CRC implementation in use for large blocks
+ * of data, e.g. "byte-wise", "slice-by-8" or "pclmul"; intended
+ * for debug and test purposes.
+ *
+ * @return the name of the implementation in use.
+ */
+const char *uCrcImplementation();
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_CRC_H_
+
+// End of file
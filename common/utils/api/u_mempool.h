@@ -31,6 +31,18 @@
  * API for efficient EDM transport.  The API functions are thread-safe except for the
  * uMemPoolInit() and uMemPoolDeinit() APIs, which should not be called while any
  * of the other API calls are in progress.
+ *
+ * There is also a general purpose size-class pool, the uMemPoolClassXxx() functions,
+ * which pUPortMalloc() uses for small allocations if U_CFG_HEAP_POOL is defined.
+ * It has #U_MEMPOOL_CLASS_NUM classes of block, the smallest being
+ * #U_MEMPOOL_CLASS_MIN_BLOCK_SIZE bytes and each class twice the size of the one
+ * before.  Each class is split into #U_MEMPOOL_CLASS_NUM_SHARDS shards of
+ * #U_MEMPOOL_CLASS_BLOCK_COUNT blocks, the shard a task allocates from first being
+ * chosen by its task handle, so that tasks running at the same time tend not to
+ * contend.  The free list of each shard is lock-free.  The memory for all of the
+ * blocks, U_MEMPOOL_CLASS_BLOCK_COUNT * U_MEMPOOL_CLASS_NUM_SHARDS *
+ * U_MEMPOOL_CLASS_MIN_BLOCK_SIZE * ((2 ^ U_MEMPOOL_CLASS_NUM) - 1) bytes, is
+ * taken from the C library heap on first use and is never returned.
  */
 #ifdef __cplusplus
 extern "C" {
@@ -40,10 +52,51 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+#ifndef U_MEMPOOL_CLASS_NUM
+/** The number of size classes in the size-class pool.
+ */
+# define U_MEMPOOL_CLASS_NUM 5
+#endif
+
+#ifndef U_MEMPOOL_CLASS_MIN_BLOCK_SIZE
+/** The block size of the smallest class in the size-class pool;
+ * must be a power of two and at least 8 so that blocks are aligned.
+ */
+# define U_MEMPOOL_CLASS_MIN_BLOCK_SIZE 16
+#endif
+
+#ifndef U_MEMPOOL_CLASS_BLOCK_COUNT
+/** The number of blocks in each shard of each class of the
+ * size-class pool; at most 65535.
+ */
+# define U_MEMPOOL_CLASS_BLOCK_COUNT 32
+#endif
+
+#ifndef U_MEMPOOL_CLASS_NUM_SHARDS
+/** The number of shards each class of the size-class pool is
+ * split into.
+ */
+# define U_MEMPOOL_CLASS_NUM_SHARDS 2
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Statistics for a class of the size-class pool.
+ */
+typedef struct {
+    size_t blockSize;      /**< the size of each block in this class. */
+    int32_t numBlocks;     /**< the number of blocks in this class, over
+                                all shards. */
+    int32_t numUsed;       /**< the number of blocks currently allocated. */
+    int32_t highWaterMark; /**< the most blocks there have ever been
+                                allocated at once. */
+    int32_t numFailed;     /**< the number of allocations of this class
+                                that failed because all of its blocks
+                                were in use. */
+} uMemPoolClassStats_t;
+
 typedef struct {
     uint32_t blockSize; /**< the size of each block. */
     int32_t usedBlockCount; /**< the number of currently used blocks. */
@@ -98,6 +151,39 @@ void uMemPoolFreeMem(uMemPoolDesc_t *pMemPool, void *ptr);
  */
 void uMemPoolFreeAllMem(uMemPoolDesc_t *pMemPool);
 
+/** Allocate memory from the size-class pool: the block comes from
+ * the smallest class that will hold sizeBytes.  This function is
+ * thread-safe, lock-free, and may be called before uPortInit().
+ *
+ * @param sizeBytes  the number of bytes required.
+ * @return           a pointer to the block or NULL if sizeBytes is
+ *                   zero or too big for any class, or all of the
+ *                   blocks of the class are in use, or the pool
+ *                   memory could not be allocated; the caller would
+ *                   then normally fall back to the C library heap.
+ */
+void *uMemPoolClassAllocMem(size_t sizeBytes);
+
+/** Free memory if it came from the size-class pool.  This function
+ * is thread-safe and lock-free.
+ *
+ * @param pMem  a pointer to the memory to free, may be NULL.
+ * @return      true if pMem was a block from the size-class pool
+ *              and has been freed, else false, in which case
+ *              pMem did not come from uMemPoolClassAllocMem().
+ */
+bool uMemPoolClassFreeMem(void *pMem);
+
+/** Get the statistics of a class of the size-class pool.
+ *
+ * @param sizeClass    the class, 0 being the class with the smallest
+ *                     blocks and #U_MEMPOOL_CLASS_NUM - 1 the class
+ *                     with the largest.
+ * @param[out] pStats  a place to put the statistics, cannot be NULL.
+ * @return             zero on success else negative error code.
+ */
+int32_t uMemPoolClassStatsGet(int32_t sizeClass, uMemPoolClassStats_t *pStats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,7 +29,9 @@
 /** @file
  * @brief Ring buffer wrapper API for linear buffer.
  * All functions except uRingBufferCreate() and uRingBufferDelete()
- * are thread-safe.
+ * are thread-safe.  The uRingBufferSpsc*() functions are an exception:
+ * they operate on a separate, lock-free, ring buffer type that is safe
+ * for exactly one producer task and one consumer task.
  */
 
 #ifdef __cplusplus
@@ -40,6 +42,12 @@ extern "C" {
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** The number of spans that uRingBufferPeekSpans() and
+ * uRingBufferPeekSpansHandle() may return: the data up to the end
+ * of the linear buffer and then any that wraps around to the start.
+ */
+#define U_RING_BUFFER_NUM_SPANS 2
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -113,6 +121,56 @@ typedef void *uParseHandle_t; //!< Parser handle.
  */
 typedef int32_t (*U_RING_BUFFER_PARSER_f)(uParseHandle_t parseHandle, void *pUserParam);
 
+/** Scanner function prototype, used with uRingBufferScanHandle().
+ *
+ * @param[in] pData       a pointer to a contiguous span of data in
+ *                        the ring buffer that has not yet been scanned.
+ * @param size            the number of bytes at pData, always at least 1.
+ * @param[in] pUserParam  a user parameter, passed in via uRingBufferScanHandle().
+ * @return                the number of bytes at pData that the scanner
+ *                        has dealt with; if this is less than size the
+ *                        scan stops.
+ */
+typedef size_t (*U_RING_BUFFER_SCANNER_f)(const char *pData, size_t size,
+                                          void *pUserParam);
+
+/** The position of a scan, for use with uRingBufferScanHandle(); the
+ * owner of the scan should set pRead to NULL and offset to zero
+ * before the first scan and otherwise leave this alone, except that
+ * offset may be reduced in order to have data scanned again.
+ */
+typedef struct {
+    const char *pRead; /**< the read pointer at the time of the last scan. */
+    size_t offset;     /**< the number of bytes beyond the read pointer
+                            that have already been scanned. */
+} uRingBufferScanPosition_t;
+
+/** A contiguous span of data inside a ring buffer, as returned by
+ * uRingBufferPeekSpans() and uRingBufferPeekSpansHandle().
+ */
+typedef struct {
+    const char *pData; /**< a pointer to the data, NULL if size is zero. */
+    size_t size;       /**< the number of bytes at pData. */
+} uRingBufferSpan_t;
+
+/** Structure that defines a lock-free single-producer, single-consumer
+ * ring buffer, see uRingBufferSpscCreate(); as for #uRingBuffer_t,
+ * the contents of this structure are internal, please use the access
+ * functions of this API.
+ */
+typedef struct {
+    char *pBuffer;
+    size_t mask;              /**< the size of pBuffer minus one, the size
+                                   being a power of two. */
+    volatile size_t write;    /**< free-running write index, written
+                                   only by the producer. */
+    volatile size_t read;     /**< free-running read index, written
+                                   only by the consumer. */
+    size_t statAddLossBytes;  /**< number of bytes lost due to the
+                                   producer finding the ring buffer
+                                   full, written only by the producer. */
+} uRingBufferSpsc_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -455,6 +513,211 @@ void uRingBufferFlushHandle(uRingBuffer_t *pRingBuffer, int32_t handle);
 size_t uRingBufferStatReadLossHandle(uRingBuffer_t *pRingBuffer,
                                      int32_t handle);
 
+/* ----------------------------------------------------------------
+ * FUNCTIONS: ZERO-COPY ACCESS
+ * -------------------------------------------------------------- */
+
+/** Like uRingBufferPeek() except that, rather than copying the data
+ * out, pointers to it are returned, in place in the ring buffer, as
+ * up to #U_RING_BUFFER_NUM_SPANS contiguous spans (more than one only
+ * if the data wraps around the end of the linear buffer); any span
+ * that is not required is returned with a NULL pData and a size of
+ * zero.  Once done with the data, move the read pointer on with
+ * uRingBufferConsume().
+ *
+ * IMPORTANT: the spans point into the ring buffer and so remain
+ * valid only while the data cannot be overwritten, i.e. until it
+ * is consumed AND provided that uRingBufferForceAdd(),
+ * uRingBufferFlush() or uRingBufferReset() are not called in the
+ * meantime.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param[out] pSpans     a pointer to an array of #U_RING_BUFFER_NUM_SPANS
+ *                        spans, cannot be NULL.
+ * @param length          the maximum amount of data to return.
+ * @param offset          the offset from the read pointer at which
+ *                        the spans should begin.
+ * @return                the total number of bytes in the spans.
+ */
+size_t uRingBufferPeekSpans(uRingBuffer_t *pRingBuffer,
+                            uRingBufferSpan_t *pSpans,
+                            size_t length, size_t offset);
+
+/** Move the read pointer of a ring buffer on, discarding data; the
+ * "commit" to go with uRingBufferPeekSpans(), the same as calling
+ * uRingBufferRead() with a NULL pData.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param length          the amount of data to consume.
+ * @return                the number of bytes consumed.
+ */
+size_t uRingBufferConsume(uRingBuffer_t *pRingBuffer, size_t length);
+
+/** Like uRingBufferPeekSpans() but for use by an entity that has
+ * previously obtained a read handle by calling uRingBufferTakeReadHandle().
+ * Lock the read handle with uRingBufferLockReadHandle() before
+ * calling this function if the ring buffer may be written with
+ * uRingBufferForceAdd(), otherwise the data the spans point to may
+ * be overwritten under your feet.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param handle          a read handle, as originally returned by
+ *                        uRingBufferTakeReadHandle().
+ * @param[out] pSpans     a pointer to an array of #U_RING_BUFFER_NUM_SPANS
+ *                        spans, cannot be NULL.
+ * @param length          the maximum amount of data to return.
+ * @param offset          the offset from the read pointer at which
+ *                        the spans should begin.
+ * @return                the total number of bytes in the spans.
+ */
+size_t uRingBufferPeekSpansHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                  uRingBufferSpan_t *pSpans,
+                                  size_t length, size_t offset);
+
+/** Like uRingBufferConsume() but for use with a read handle: the
+ * "commit" to go with uRingBufferPeekSpansHandle(), the same as
+ * calling uRingBufferReadHandle() with a NULL pData.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param handle          a read handle, as originally returned by
+ *                        uRingBufferTakeReadHandle().
+ * @param length          the amount of data to consume.
+ * @return                the number of bytes consumed.
+ */
+size_t uRingBufferConsumeHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                size_t length);
+
+/* ----------------------------------------------------------------
+ * FUNCTIONS: SINGLE PRODUCER, SINGLE CONSUMER
+ * -------------------------------------------------------------- */
+
+/** Create a lock-free ring buffer from a linear buffer, for the common
+ * case where exactly one task adds data and exactly one task reads it
+ * (e.g. a transport receive task feeding a decoder).  No mutex is
+ * involved: the producer and the consumer each own an index, which the
+ * other only reads, so neither ever waits on the other.  The price is
+ * that there is no multiple-read-handle API, no forced add and the
+ * size of the linear buffer must be a power of two; if you need any
+ * of those, use uRingBufferCreate() or uRingBufferCreateWithReadHandle().
+ *
+ * Of the functions below, uRingBufferSpscAdd() and
+ * uRingBufferSpscStatAddLoss() may only be called by the producer,
+ * uRingBufferSpscRead(), uRingBufferSpscPeek(), uRingBufferSpscPeekSpans(),
+ * uRingBufferSpscConsume() and uRingBufferSpscFlush() may only be called
+ * by the consumer, uRingBufferSpscDataSize() and
+ * uRingBufferSpscAvailableSize() may be called by either.
+ * uRingBufferSpscCreate() and uRingBufferSpscDelete() must not be called
+ * while either is active.
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ * @param[in] pLinearBuffer a pointer to the linear buffer, cannot be NULL.
+ * @param size              the size of the linear buffer in bytes, which
+ *                          must be a power of two; all of it may be
+ *                          filled.
+ * @return                  zero on success else negative error code.
+ */
+int32_t uRingBufferSpscCreate(uRingBufferSpsc_t *pRingBuffer,
+                              char *pLinearBuffer, size_t size);
+
+/** Delete a lock-free ring buffer; the linear buffer is not free'd.
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ */
+void uRingBufferSpscDelete(uRingBufferSpsc_t *pRingBuffer);
+
+/** Add data to a lock-free ring buffer; producer only.
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ * @param[in] pData         pointer to the data.
+ * @param length            the length of the data.
+ * @return                  true if the data was added, false if the data
+ *                          was not added, which will be the case if there
+ *                          is not room enough.
+ */
+bool uRingBufferSpscAdd(uRingBufferSpsc_t *pRingBuffer, const char *pData,
+                        size_t length);
+
+/** Read data from a lock-free ring buffer; consumer only.
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ * @param[out] pData        where to put the data; may be NULL to throw the
+ *                          data away.
+ * @param length            the maximum amount of data to read.
+ * @return                  the number of bytes read.
+ */
+size_t uRingBufferSpscRead(uRingBufferSpsc_t *pRingBuffer, char *pData,
+                           size_t length);
+
+/** Like uRingBufferSpscRead() but doesn't move the read index on;
+ * consumer only.
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ * @param[out] pData        where to put the data.
+ * @param length            the maximum amount of data to be peeked.
+ * @param offset            the offset from the read index at which to
+ *                          begin the peek.
+ * @return                  the number of bytes peeked.
+ */
+size_t uRingBufferSpscPeek(uRingBufferSpsc_t *pRingBuffer, char *pData,
+                           size_t length, size_t offset);
+
+/** Like uRingBufferPeekSpans() but for a lock-free ring buffer;
+ * consumer only.  The spans remain valid until the data is consumed
+ * with uRingBufferSpscConsume() or uRingBufferSpscRead(): the producer
+ * cannot overwrite it before then.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param[out] pSpans     a pointer to an array of #U_RING_BUFFER_NUM_SPANS
+ *                        spans, cannot be NULL.
+ * @param length          the maximum amount of data to return.
+ * @param offset          the offset from the read index at which
+ *                        the spans should begin.
+ * @return                the total number of bytes in the spans.
+ */
+size_t uRingBufferSpscPeekSpans(uRingBufferSpsc_t *pRingBuffer,
+                                uRingBufferSpan_t *pSpans,
+                                size_t length, size_t offset);
+
+/** Move the read index of a lock-free ring buffer on, discarding
+ * data; consumer only.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @param length          the amount of data to consume.
+ * @return                the number of bytes consumed.
+ */
+size_t uRingBufferSpscConsume(uRingBufferSpsc_t *pRingBuffer, size_t length);
+
+/** Get the amount of data available in a lock-free ring buffer;
+ * either side may call this, the answer can only go up if called
+ * by the consumer and only go down if called by the producer.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @return                the number of bytes available for reading.
+ */
+size_t uRingBufferSpscDataSize(const uRingBufferSpsc_t *pRingBuffer);
+
+/** Get the free space available in a lock-free ring buffer; either
+ * side may call this.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @return                the number of bytes available for storing.
+ */
+size_t uRingBufferSpscAvailableSize(const uRingBufferSpsc_t *pRingBuffer);
+
+/** Flush the data from a lock-free ring buffer; consumer only.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ */
+void uRingBufferSpscFlush(uRingBufferSpsc_t *pRingBuffer);
+
+/** Get the number of bytes lost due to uRingBufferSpscAdd() being
+ * unable to write data into a lock-free ring buffer; producer only.
+ *
+ * @param[in] pRingBuffer a pointer to the ring buffer, cannot be NULL.
+ * @return                the number of bytes lost.
+ */
+size_t uRingBufferSpscStatAddLoss(uRingBufferSpsc_t *pRingBuffer);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: PARSER
  * -------------------------------------------------------------- */
@@ -510,6 +773,96 @@ size_t uRingBufferBytesAvailableUnprotected(uParseHandle_t parseHandle);
  */
 size_t uRingBufferBytesDiscardUnprotected(uParseHandle_t parseHandle);
 
+/** Get a pointer to the data in the ring buffer at the current position
+ * while in a parser function, in place, and the number of contiguous
+ * bytes there, allowing a parser to look at (e.g. checksum or memcpy())
+ * a whole run of bytes at once rather than calling
+ * uRingBufferGetByteUnprotected() for each one; the position is not
+ * moved on, use uRingBufferSkipUnprotected() for that.  Since the data
+ * may wrap around the end of the ring buffer, fewer bytes than
+ * uRingBufferBytesAvailableUnprotected() may be returned: skip over
+ * them and call this function again to get the rest.
+ *
+ * IMPORTANT: unlike all of the other ring-buffer functions, this function
+ * is NOT thread-safe, it is ONLY intended to be used from within a
+ * U_RING_BUFFER_PARSER_f function that will be called by uRingBufferParseHandle()
+ * (which adds thread-safety).
+ *
+ * @param parseHandle     the parser handle used to access the ring buffer.
+ * @param[out] ppData     a place to put the pointer to the data, cannot
+ *                        be NULL.
+ * @return                the number of contiguous bytes at *ppData.
+ */
+size_t uRingBufferGetSpanUnprotected(uParseHandle_t parseHandle, const char **ppData);
+
+/** Move the current position in the ring buffer on while in a parser
+ * function, as if uRingBufferGetByteUnprotected() had been called
+ * length times.
+ *
+ * IMPORTANT: unlike all of the other ring-buffer functions, this function
+ * is NOT thread-safe, it is ONLY intended to be used from within a
+ * U_RING_BUFFER_PARSER_f function that will be called by uRingBufferParseHandle()
+ * (which adds thread-safety).
+ *
+ * @param parseHandle     the parser handle used to access the ring buffer.
+ * @param length          the number of bytes to move on by.
+ * @return                the number of bytes moved on by, which will
+ *                        be less than length if there is less data.
+ */
+size_t uRingBufferSkipUnprotected(uParseHandle_t parseHandle, size_t length);
+
+/** Find a byte in the ring buffer, searching from the current position
+ * while in a parser function, using memchr(); the position is not moved
+ * on.  This is intended for a parser to look for the byte that must
+ * begin any message of its protocol: should the parser then return
+ * #U_ERROR_COMMON_NOT_FOUND, uRingBufferParseHandle() will, rather than
+ * trying again one byte further on, move on to the byte that was found
+ * (or past all of the data if it was not found), provided every other
+ * parser in the list agrees (i.e. the smallest such amount is used).
+ * Hence call this only before the parser has done anything that it would
+ * not repeat on the next byte along.
+ *
+ * IMPORTANT: unlike all of the other ring-buffer functions, this function
+ * is NOT thread-safe, it is ONLY intended to be used from within a
+ * U_RING_BUFFER_PARSER_f function that will be called by uRingBufferParseHandle()
+ * (which adds thread-safety).
+ *
+ * @param parseHandle     the parser handle used to access the ring buffer.
+ * @param value           the byte to find.
+ * @return                the offset of the byte from the current
+ *                        position, uRingBufferBytesAvailableUnprotected()
+ *                        if it was not found.
+ */
+size_t uRingBufferFindByteUnprotected(uParseHandle_t parseHandle, char value);
+
+/** Scan the data at a read handle in place, i.e. without copying it and
+ * without moving the read pointer on: pScanner is called with the data
+ * that has not yet been scanned as (at most two) contiguous spans, under
+ * the protection of the ring buffer mutex.  The position of the scan is
+ * kept in pPosition so that, when called again after more data has
+ * arrived, only the new data is passed to pScanner, allowing a scanner
+ * that keeps its own state to carry on from where it left off.  Should
+ * the read pointer have been moved on since the last scan, by no more
+ * than the amount of data that had already been scanned, the position
+ * is adjusted to match; should it have moved further (e.g. the data was
+ * pushed out by uRingBufferForceAdd() or read past the scanned data) the
+ * scan begins again at the read pointer.
+ *
+ * @param[in] pRingBuffer   a pointer to the ring buffer, cannot be NULL.
+ * @param handle            a read handle, as originally returned by
+ *                          uRingBufferTakeReadHandle().
+ * @param[in,out] pPosition the position of the scan, cannot be NULL.
+ * @param[in] pScanner      the scanner function, cannot be NULL.
+ * @param[in] pUserParam    a user parameter to pass to pScanner.
+ * @return                  on success the number of bytes that
+ *                          pScanner dealt with on this call, else
+ *                          negative error code.
+ */
+int32_t uRingBufferScanHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
+                              uRingBufferScanPosition_t *pPosition,
+                              U_RING_BUFFER_SCANNER_f pScanner,
+                              void *pUserParam);
+
 #ifdef __cplusplus
 }
 #endif
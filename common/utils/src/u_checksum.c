@@ -0,0 +1,449 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.  The exception is the SIMD intrinsics headers below,
+ * which are provided by the compiler, not the platform.
+ */
+
+/** @file
+ * @brief Implementation of the UBX (8-bit Fletcher) and NMEA
+ * (8-bit XOR) checksums, with SIMD versions where available.
+ *
+ * The SIMD Fletcher implementations rely on the fact that, for a
+ * block of n bytes b[0] to b[n - 1] added to a checksum (A, B):
+ *
+ * A' = A + sum(b[i])
+ * B' = B + n * A + sum((n - i) * b[i])
+ *
+ * ...so each block of 16 or 32 bytes can be reduced to a plain sum
+ * and a weighted sum, with the running A of each block accumulated
+ * separately.  All arithmetic is done modulo 2^32, which gives the
+ * correct answer modulo 256, hence no intermediate reduction is
+ * required however long the data.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+
+#include "u_checksum.h"
+
+#ifndef U_CFG_CHECKSUM_NO_SIMD
+# if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#  define U_CHECKSUM_SSE2
+#  include "emmintrin.h"
+#  if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+// AVX2 is compiled in with a function attribute and only used
+// if the CPU says it is supported
+#   define U_CHECKSUM_AVX2
+#   include "immintrin.h"
+#  endif
+# elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  define U_CHECKSUM_NEON
+#  include "arm_neon.h"
+# endif
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** A checksum implementation.
+ */
+typedef struct {
+    const char *pName;
+    uint16_t (*pFletcher8)(uint16_t checksum, const uint8_t *pData, size_t size);
+    uint8_t (*pXor8)(uint8_t checksum, const uint8_t *pData, size_t size);
+} uChecksumImplementation_t;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: SCALAR
+ * -------------------------------------------------------------- */
+
+// 8-bit Fletcher checksum, one byte at a time.
+static uint16_t fletcher8Scalar(uint16_t checksum, const uint8_t *pData,
+                                size_t size)
+{
+    uint32_t a = checksum & 0xff;
+    uint32_t b = checksum >> 8;
+
+    while (size > 0) {
+        a += *pData;
+        b += a;
+        pData++;
+        size--;
+    }
+
+    return (uint16_t) (((b & 0xff) << 8) | (a & 0xff));
+}
+
+// 8-bit XOR checksum, one byte at a time.
+static uint8_t xor8Scalar(uint8_t checksum, const uint8_t *pData,
+                          size_t size)
+{
+    while (size > 0) {
+        checksum ^= *pData;
+        pData++;
+        size--;
+    }
+
+    return checksum;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: SSE2
+ * -------------------------------------------------------------- */
+
+#ifdef U_CHECKSUM_SSE2
+
+// Add up the four 32-bit lanes of an SSE register.
+static uint32_t sumSse2(__m128i v)
+{
+    v = _mm_add_epi32(v, _mm_srli_si128(v, 8));
+    v = _mm_add_epi32(v, _mm_srli_si128(v, 4));
+
+    return (uint32_t) _mm_cvtsi128_si32(v);
+}
+
+// XOR together the 16 bytes of an SSE register.
+static uint8_t xorFoldSse2(__m128i v)
+{
+    v = _mm_xor_si128(v, _mm_srli_si128(v, 8));
+    v = _mm_xor_si128(v, _mm_srli_si128(v, 4));
+    v = _mm_xor_si128(v, _mm_srli_si128(v, 2));
+    v = _mm_xor_si128(v, _mm_srli_si128(v, 1));
+
+    return (uint8_t) _mm_cvtsi128_si32(v);
+}
+
+// 8-bit Fletcher checksum, 16 bytes at a time.
+static uint16_t fletcher8Sse2(uint16_t checksum, const uint8_t *pData,
+                              size_t size)
+{
+    size_t blocks = size >> 4;
+    uint32_t a = checksum & 0xff;
+    uint32_t b = checksum >> 8;
+    const __m128i zero = _mm_setzero_si128();
+    // Weights 16 down to 9 for bytes 0 to 7 and 8 down
+    // to 1 for bytes 8 to 15
+    const __m128i weightsLo = _mm_set_epi16(9, 10, 11, 12, 13, 14, 15, 16);
+    const __m128i weightsHi = _mm_set_epi16(1, 2, 3, 4, 5, 6, 7, 8);
+    __m128i vSum = zero;
+    __m128i vPrefix = zero;
+    __m128i vWeighted = zero;
+    __m128i v;
+
+    if (blocks > 0) {
+        b += (uint32_t) (blocks << 4) * a;
+        for (size_t x = 0; x < blocks; x++) {
+            v = _mm_loadu_si128((const __m128i *) pData);
+            // The sum of all of the blocks before this one
+            vPrefix = _mm_add_epi32(vPrefix, vSum);
+            // _mm_sad_epu8() leaves each half-sum in the bottom
+            // 16 bits of a 64-bit lane, so adding 32-bit lanes
+            // is fine and keeps the odd lanes at zero
+            vSum = _mm_add_epi32(vSum, _mm_sad_epu8(v, zero));
+            vWeighted = _mm_add_epi32(vWeighted,
+                                      _mm_madd_epi16(_mm_unpacklo_epi8(v, zero),
+                                                     weightsLo));
+            vWeighted = _mm_add_epi32(vWeighted,
+                                      _mm_madd_epi16(_mm_unpackhi_epi8(v, zero),
+                                                     weightsHi));
+            pData += 16;
+        }
+        a += sumSse2(vSum);
+        b += (sumSse2(vPrefix) << 4) + sumSse2(vWeighted);
+    }
+
+    return fletcher8Scalar((uint16_t) (((b & 0xff) << 8) | (a & 0xff)),
+                           pData, size & 0x0f);
+}
+
+// 8-bit XOR checksum, 16 bytes at a time.
+static uint8_t xor8Sse2(uint8_t checksum, const uint8_t *pData,
+                        size_t size)
+{
+    size_t blocks = size >> 4;
+    __m128i v = _mm_setzero_si128();
+
+    if (blocks > 0) {
+        for (size_t x = 0; x < blocks; x++) {
+            v = _mm_xor_si128(v, _mm_loadu_si128((const __m128i *) pData));
+            pData += 16;
+        }
+        checksum ^= xorFoldSse2(v);
+    }
+
+    return xor8Scalar(checksum, pData, size & 0x0f);
+}
+
+#endif // #ifdef U_CHECKSUM_SSE2
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: AVX2
+ * -------------------------------------------------------------- */
+
+#ifdef U_CHECKSUM_AVX2
+
+// Add up the eight 32-bit lanes of an AVX register.
+__attribute__((target("avx2")))
+static uint32_t sumAvx2(__m256i v)
+{
+    return sumSse2(_mm_add_epi32(_mm256_castsi256_si128(v),
+                                 _mm256_extracti128_si256(v, 1)));
+}
+
+// 8-bit Fletcher checksum, 32 bytes at a time.
+__attribute__((target("avx2")))
+static uint16_t fletcher8Avx2(uint16_t checksum, const uint8_t *pData,
+                              size_t size)
+{
+    size_t blocks = size >> 5;
+    uint32_t a = checksum & 0xff;
+    uint32_t b = checksum >> 8;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    // Weights 32 down to 1 for bytes 0 to 31; the largest pair
+    // sum from _mm256_maddubs_epi16(), (32 + 31) * 255, fits
+    // comfortably in its signed 16-bit result
+    const __m256i weights = _mm256_set_epi8(1, 2, 3, 4, 5, 6, 7, 8,
+                                            9, 10, 11, 12, 13, 14, 15, 16,
+                                            17, 18, 19, 20, 21, 22, 23, 24,
+                                            25, 26, 27, 28, 29, 30, 31, 32);
+    __m256i vSum = zero;
+    __m256i vPrefix = zero;
+    __m256i vWeighted = zero;
+    __m256i v;
+
+    if (blocks > 0) {
+        b += (uint32_t) (blocks << 5) * a;
+        for (size_t x = 0; x < blocks; x++) {
+            v = _mm256_loadu_si256((const __m256i *) pData);
+            vPrefix = _mm256_add_epi32(vPrefix, vSum);
+            vSum = _mm256_add_epi32(vSum, _mm256_sad_epu8(v, zero));
+            vWeighted = _mm256_add_epi32(vWeighted,
+                                         _mm256_madd_epi16(_mm256_maddubs_epi16(v, weights),
+                                                           ones));
+            pData += 32;
+        }
+        a += sumAvx2(vSum);
+        b += (sumAvx2(vPrefix) << 5) + sumAvx2(vWeighted);
+    }
+
+    return fletcher8Sse2((uint16_t) (((b & 0xff) << 8) | (a & 0xff)),
+                         pData, size & 0x1f);
+}
+
+// 8-bit XOR checksum, 32 bytes at a time.
+__attribute__((target("avx2")))
+static uint8_t xor8Avx2(uint8_t checksum, const uint8_t *pData,
+                        size_t size)
+{
+    size_t blocks = size >> 5;
+    __m256i v = _mm256_setzero_si256();
+
+    if (blocks > 0) {
+        for (size_t x = 0; x < blocks; x++) {
+            v = _mm256_xor_si256(v, _mm256_loadu_si256((const __m256i *) pData));
+            pData += 32;
+        }
+        checksum ^= xorFoldSse2(_mm_xor_si128(_mm256_castsi256_si128(v),
+                                              _mm256_extracti128_si256(v, 1)));
+    }
+
+    return xor8Sse2(checksum, pData, size & 0x1f);
+}
+
+#endif // #ifdef U_CHECKSUM_AVX2
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: NEON
+ * -------------------------------------------------------------- */
+
+#ifdef U_CHECKSUM_NEON
+
+// Add up the four 32-bit lanes of a NEON register; done the
+// long way so as to work on 32-bit ARM as well as 64-bit ARM.
+static uint32_t sumNeon(uint32x4_t v)
+{
+    uint32_t lanes[4];
+
+    vst1q_u32(lanes, v);
+
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+// 8-bit Fletcher checksum, 16 bytes at a time.
+static uint16_t fletcher8Neon(uint16_t checksum, const uint8_t *pData,
+                              size_t size)
+{
+    static const uint8_t weights[16] = {16, 15, 14, 13, 12, 11, 10, 9,
+                                        8, 7, 6, 5, 4, 3, 2, 1
+                                       };
+    size_t blocks = size >> 4;
+    uint32_t a = checksum & 0xff;
+    uint32_t b = checksum >> 8;
+    const uint8x8_t weightsLo = vld1_u8(weights);
+    const uint8x8_t weightsHi = vld1_u8(weights + 8);
+    uint32x4_t vSum = vdupq_n_u32(0);
+    uint32x4_t vPrefix = vdupq_n_u32(0);
+    uint32x4_t vWeighted = vdupq_n_u32(0);
+    uint16x8_t w;
+    uint8x16_t v;
+
+    if (blocks > 0) {
+        b += (uint32_t) (blocks << 4) * a;
+        for (size_t x = 0; x < blocks; x++) {
+            v = vld1q_u8(pData);
+            vPrefix = vaddq_u32(vPrefix, vSum);
+            vSum = vpadalq_u16(vSum, vpaddlq_u8(v));
+            // Largest product sum is (16 + 8) * 255, fits in 16 bits
+            w = vmull_u8(vget_low_u8(v), weightsLo);
+            w = vmlal_u8(w, vget_high_u8(v), weightsHi);
+            vWeighted = vpadalq_u16(vWeighted, w);
+            pData += 16;
+        }
+        a += sumNeon(vSum);
+        b += (sumNeon(vPrefix) << 4) + sumNeon(vWeighted);
+    }
+
+    return fletcher8Scalar((uint16_t) (((b & 0xff) << 8) | (a & 0xff)),
+                           pData, size & 0x0f);
+}
+
+// 8-bit XOR checksum, 16 bytes at a time.
+static uint8_t xor8Neon(uint8_t checksum, const uint8_t *pData,
+                        size_t size)
+{
+    size_t blocks = size >> 4;
+    uint8x16_t v = vdupq_n_u8(0);
+    uint8_t lanes[16];
+
+    if (blocks > 0) {
+        for (size_t x = 0; x < blocks; x++) {
+            v = veorq_u8(v, vld1q_u8(pData));
+            pData += 16;
+        }
+        vst1q_u8(lanes, v);
+        checksum = xor8Scalar(checksum, lanes, sizeof(lanes));
+    }
+
+    return xor8Scalar(checksum, pData, size & 0x0f);
+}
+
+#endif // #ifdef U_CHECKSUM_NEON
+
+/* ----------------------------------------------------------------
+ * STATIC VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The implementation chosen at compile-time.
+ */
+static const uChecksumImplementation_t gImplementationBuild = {
+#if defined(U_CHECKSUM_SSE2)
+    "sse2", fletcher8Sse2, xor8Sse2
+#elif defined(U_CHECKSUM_NEON)
+    "neon", fletcher8Neon, xor8Neon
+#else
+    "scalar", fletcher8Scalar, xor8Scalar
+#endif
+};
+
+#ifdef U_CHECKSUM_AVX2
+/** The AVX2 implementation, chosen at run-time if the CPU
+ * supports it.
+ */
+static const uChecksumImplementation_t gImplementationAvx2 = {
+    "avx2", fletcher8Avx2, xor8Avx2
+};
+#endif
+
+/** The implementation in use, NULL until the first call; no need
+ * for a mutex since a race can only result in the same pointer
+ * being written twice.
+ */
+static const uChecksumImplementation_t *gpImplementation = NULL;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: MISC
+ * -------------------------------------------------------------- */
+
+// Get the implementation to use, choosing it if required.
+static const uChecksumImplementation_t *pImplementation()
+{
+    const uChecksumImplementation_t *pImpl = gpImplementation;
+
+    if (pImpl == NULL) {
+        pImpl = &gImplementationBuild;
+#ifdef U_CHECKSUM_AVX2
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            pImpl = &gImplementationAvx2;
+        }
+#endif
+        gpImplementation = pImpl;
+    }
+
+    return pImpl;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Add a block of data to an 8-bit Fletcher checksum.
+uint16_t uChecksumFletcher8(uint16_t checksum, const char *pData,
+                            size_t size)
+{
+    if ((pData != NULL) && (size > 0)) {
+        checksum = pImplementation()->pFletcher8(checksum,
+                                                 (const uint8_t *) pData,
+                                                 size);
+    }
+
+    return checksum;
+}
+
+// Add a block of data to an 8-bit XOR checksum.
+uint8_t uChecksumXor8(uint8_t checksum, const char *pData, size_t size)
+{
+    if ((pData != NULL) && (size > 0)) {
+        checksum = pImplementation()->pXor8(checksum,
+                                            (const uint8_t *) pData,
+                                            size);
+    }
+
+    return checksum;
+}
+
+// Get the name of the checksum implementation in use.
+const char *uChecksumImplementation()
+{
+    return pImplementation()->pName;
+}
+
+// End of file
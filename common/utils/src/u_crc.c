@@ -0,0 +1,509 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.  The exception is the SIMD intrinsics headers below,
+ * which are provided by the compiler, not the platform.
+ */
+
+/** @file
+ * @brief Implementation of the CRC functions shared by the SPARTN
+ * and RTCM code.
+ *
+ * All of the CRCs are MSB-first and so are computed by the same
+ * engine in a 32-bit register: a CRC of width w with polynomial P
+ * is computed as a 32-bit CRC with polynomial P * x^(32 - w), i.e.
+ * "left-aligned", the result being shifted down at the end.
+ *
+ * Three methods are used, depending on configuration and CPU:
+ *
+ * - byte-wise: the usual 256-entry table lookup per byte,
+ * - slice-by-8: eight 256-entry tables, derived from the byte-wise
+ *   table on first use, give the contribution of each of eight
+ *   bytes to the CRC, so that eight bytes are consumed per step,
+ * - PCLMULQDQ: the data is "folded" 64 bytes at a time with
+ *   carry-less multiplies by x^n mod P, where n is the distance
+ *   folded across; the 128 bits that remain are congruent to the
+ *   message so far, modulo P, and hence can be fed through the
+ *   table-based code to obtain the CRC.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+
+#include "u_compiler.h" // U_ATOMIC_XXX() macros
+
+#include "u_crc.h"
+
+#if !defined(U_CFG_CRC_NO_SLICE_BY_8) && (defined(U_CFG_CRC_SLICE_BY_8) || (SIZE_MAX > 0xFFFFFFFFU))
+# define U_CRC_SLICE_BY_8
+#endif
+
+#if !defined(U_CFG_CRC_NO_SIMD) && defined(__GNUC__) && defined(__x86_64__)
+// PCLMULQDQ is compiled in with a function attribute and only
+// used if the CPU says it is supported
+# define U_CRC_PCLMUL
+# include "immintrin.h"
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The minimum block size for which PCLMULQDQ is used.
+ */
+#define U_CRC_PCLMUL_MIN_SIZE_BYTES 64
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** The working data for a CRC polynomial.
+ */
+typedef struct {
+    const uint32_t *pTable; /**< the byte-wise table, left-aligned. */
+#ifdef U_CRC_SLICE_BY_8
+    uint32_t slice[7][256]; /**< the tables for a byte followed by
+                                 1 to 7 zero bytes. */
+#endif
+#ifdef U_CRC_PCLMUL
+    uint64_t fold128[2];    /**< x^128 and x^192 mod P. */
+    uint64_t fold512[2];    /**< x^512 and x^576 mod P. */
+#endif
+    volatile bool ready;    /**< true once the above are populated; set
+                                 with U_ATOMIC_SET_RELEASE() and read with
+                                 U_ATOMIC_GET_ACQUIRE() so that a task which
+                                 sees it true also sees the tables. */
+} uCrcEngine_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Byte-wise table for CRC-8, polynomial 0x07, left-aligned.
+ */
+static const uint32_t gCrc8Table[256] = {
+    0x00000000U, 0x07000000U, 0x0E000000U, 0x09000000U, 0x1C000000U, 0x1B000000U, 0x12000000U, 0x15000000U,
+    0x38000000U, 0x3F000000U, 0x36000000U, 0x31000000U, 0x24000000U, 0x23000000U, 0x2A000000U, 0x2D000000U,
+    0x70000000U, 0x77000000U, 0x7E000000U, 0x79000000U, 0x6C000000U, 0x6B000000U, 0x62000000U, 0x65000000U,
+    0x48000000U, 0x4F000000U, 0x46000000U, 0x41000000U, 0x54000000U, 0x53000000U, 0x5A000000U, 0x5D000000U,
+    0xE0000000U, 0xE7000000U, 0xEE000000U, 0xE9000000U, 0xFC000000U, 0xFB000000U, 0xF2000000U, 0xF5000000U,
+    0xD8000000U, 0xDF000000U, 0xD6000000U, 0xD1000000U, 0xC4000000U, 0xC3000000U, 0xCA000000U, 0xCD000000U,
+    0x90000000U, 0x97000000U, 0x9E000000U, 0x99000000U, 0x8C000000U, 0x8B000000U, 0x82000000U, 0x85000000U,
+    0xA8000000U, 0xAF000000U, 0xA6000000U, 0xA1000000U, 0xB4000000U, 0xB3000000U, 0xBA000000U, 0xBD000000U,
+    0xC7000000U, 0xC0000000U, 0xC9000000U, 0xCE000000U, 0xDB000000U, 0xDC000000U, 0xD5000000U, 0xD2000000U,
+    0xFF000000U, 0xF8000000U, 0xF1000000U, 0xF6000000U, 0xE3000000U, 0xE4000000U, 0xED000000U, 0xEA000000U,
+    0xB7000000U, 0xB0000000U, 0xB9000000U, 0xBE000000U, 0xAB000000U, 0xAC000000U, 0xA5000000U, 0xA2000000U,
+    0x8F000000U, 0x88000000U, 0x81000000U, 0x86000000U, 0x93000000U, 0x94000000U, 0x9D000000U, 0x9A000000U,
+    0x27000000U, 0x20000000U, 0x29000000U, 0x2E000000U, 0x3B000000U, 0x3C000000U, 0x35000000U, 0x32000000U,
+    0x1F000000U, 0x18000000U, 0x11000000U, 0x16000000U, 0x03000000U, 0x04000000U, 0x0D000000U, 0x0A000000U,
+    0x57000000U, 0x50000000U, 0x59000000U, 0x5E000000U, 0x4B000000U, 0x4C000000U, 0x45000000U, 0x42000000U,
+    0x6F000000U, 0x68000000U, 0x61000000U, 0x66000000U, 0x73000000U, 0x74000000U, 0x7D000000U, 0x7A000000U,
+    0x89000000U, 0x8E000000U, 0x87000000U, 0x80000000U, 0x95000000U, 0x92000000U, 0x9B000000U, 0x9C000000U,
+    0xB1000000U, 0xB6000000U, 0xBF000000U, 0xB8000000U, 0xAD000000U, 0xAA000000U, 0xA3000000U, 0xA4000000U,
+    0xF9000000U, 0xFE000000U, 0xF7000000U, 0xF0000000U, 0xE5000000U, 0xE2000000U, 0xEB000000U, 0xEC000000U,
+    0xC1000000U, 0xC6000000U, 0xCF000000U, 0xC8000000U, 0xDD000000U, 0xDA000000U, 0xD3000000U, 0xD4000000U,
+    0x69000000U, 0x6E000000U, 0x67000000U, 0x60000000U, 0x75000000U, 0x72000000U, 0x7B000000U, 0x7C000000U,
+    0x51000000U, 0x56000000U, 0x5F000000U, 0x58000000U, 0x4D000000U, 0x4A000000U, 0x43000000U, 0x44000000U,
+    0x19000000U, 0x1E000000U, 0x17000000U, 0x10000000U, 0x05000000U, 0x02000000U, 0x0B000000U, 0x0C000000U,
+    0x21000000U, 0x26000000U, 0x2F000000U, 0x28000000U, 0x3D000000U, 0x3A000000U, 0x33000000U, 0x34000000U,
+    0x4E000000U, 0x49000000U, 0x40000000U, 0x47000000U, 0x52000000U, 0x55000000U, 0x5C000000U, 0x5B000000U,
+    0x76000000U, 0x71000000U, 0x78000000U, 0x7F000000U, 0x6A000000U, 0x6D000000U, 0x64000000U, 0x63000000U,
+    0x3E000000U, 0x39000000U, 0x30000000U, 0x37000000U, 0x22000000U, 0x25000000U, 0x2C000000U, 0x2B000000U,
+    0x06000000U, 0x01000000U, 0x08000000U, 0x0F000000U, 0x1A000000U, 0x1D000000U, 0x14000000U, 0x13000000U,
+    0xAE000000U, 0xA9000000U, 0xA0000000U, 0xA7000000U, 0xB2000000U, 0xB5000000U, 0xBC000000U, 0xBB000000U,
+    0x96000000U, 0x91000000U, 0x98000000U, 0x9F000000U, 0x8A000000U, 0x8D000000U, 0x84000000U, 0x83000000U,
+    0xDE000000U, 0xD9000000U, 0xD0000000U, 0xD7000000U, 0xC2000000U, 0xC5000000U, 0xCC000000U, 0xCB000000U,
+    0xE6000000U, 0xE1000000U, 0xE8000000U, 0xEF000000U, 0xFA000000U, 0xFD000000U, 0xF4000000U, 0xF3000000U
+};
+
+/** Byte-wise table for CRC-16, polynomial 0x1021, left-aligned.
+ */
+static const uint32_t gCrc16Table[256] = {
+    0x00000000U, 0x10210000U, 0x20420000U, 0x30630000U, 0x40840000U, 0x50A50000U, 0x60C60000U, 0x70E70000U,
+    0x81080000U, 0x91290000U, 0xA14A0000U, 0xB16B0000U, 0xC18C0000U, 0xD1AD0000U, 0xE1CE0000U, 0xF1EF0000U,
+    0x12310000U, 0x02100000U, 0x32730000U, 0x22520000U, 0x52B50000U, 0x42940000U, 0x72F70000U, 0x62D60000U,
+    0x93390000U, 0x83180000U, 0xB37B0000U, 0xA35A0000U, 0xD3BD0000U, 0xC39C0000U, 0xF3FF0000U, 0xE3DE0000U,
+    0x24620000U, 0x34430000U, 0x04200000U, 0x14010000U, 0x64E60000U, 0x74C70000U, 0x44A40000U, 0x54850000U,
+    0xA56A0000U, 0xB54B0000U, 0x85280000U, 0x95090000U, 0xE5EE0000U, 0xF5CF0000U, 0xC5AC0000U, 0xD58D0000U,
+    0x36530000U, 0x26720000U, 0x16110000U, 0x06300000U, 0x76D70000U, 0x66F60000U, 0x56950000U, 0x46B40000U,
+    0xB75B0000U, 0xA77A0000U, 0x97190000U, 0x87380000U, 0xF7DF0000U, 0xE7FE0000U, 0xD79D0000U, 0xC7BC0000U,
+    0x48C40000U, 0x58E50000U, 0x68860000U, 0x78A70000U, 0x08400000U, 0x18610000U, 0x28020000U, 0x38230000U,
+    0xC9CC0000U, 0xD9ED0000U, 0xE98E0000U, 0xF9AF0000U, 0x89480000U, 0x99690000U, 0xA90A0000U, 0xB92B0000U,
+    0x5AF50000U, 0x4AD40000U, 0x7AB70000U, 0x6A960000U, 0x1A710000U, 0x0A500000U, 0x3A330000U, 0x2A120000U,
+    0xDBFD0000U, 0xCBDC0000U, 0xFBBF0000U, 0xEB9E0000U, 0x9B790000U, 0x8B580000U, 0xBB3B0000U, 0xAB1A0000U,
+    0x6CA60000U, 0x7C870000U, 0x4CE40000U, 0x5CC50000U, 0x2C220000U, 0x3C030000U, 0x0C600000U, 0x1C410000U,
+    0xEDAE0000U, 0xFD8F0000U, 0xCDEC0000U, 0xDDCD0000U, 0xAD2A0000U, 0xBD0B0000U, 0x8D680000U, 0x9D490000U,
+    0x7E970000U, 0x6EB60000U, 0x5ED50000U, 0x4EF40000U, 0x3E130000U, 0x2E320000U, 0x1E510000U, 0x0E700000U,
+    0xFF9F0000U, 0xEFBE0000U, 0xDFDD0000U, 0xCFFC0000U, 0xBF1B0000U, 0xAF3A0000U, 0x9F590000U, 0x8F780000U,
+    0x91880000U, 0x81A90000U, 0xB1CA0000U, 0xA1EB0000U, 0xD10C0000U, 0xC12D0000U, 0xF14E0000U, 0xE16F0000U,
+    0x10800000U, 0x00A10000U, 0x30C20000U, 0x20E30000U, 0x50040000U, 0x40250000U, 0x70460000U, 0x60670000U,
+    0x83B90000U, 0x93980000U, 0xA3FB0000U, 0xB3DA0000U, 0xC33D0000U, 0xD31C0000U, 0xE37F0000U, 0xF35E0000U,
+    0x02B10000U, 0x12900000U, 0x22F30000U, 0x32D20000U, 0x42350000U, 0x52140000U, 0x62770000U, 0x72560000U,
+    0xB5EA0000U, 0xA5CB0000U, 0x95A80000U, 0x85890000U, 0xF56E0000U, 0xE54F0000U, 0xD52C0000U, 0xC50D0000U,
+    0x34E20000U, 0x24C30000U, 0x14A00000U, 0x04810000U, 0x74660000U, 0x64470000U, 0x54240000U, 0x44050000U,
+    0xA7DB0000U, 0xB7FA0000U, 0x87990000U, 0x97B80000U, 0xE75F0000U, 0xF77E0000U, 0xC71D0000U, 0xD73C0000U,
+    0x26D30000U, 0x36F20000U, 0x06910000U, 0x16B00000U, 0x66570000U, 0x76760000U, 0x46150000U, 0x56340000U,
+    0xD94C0000U, 0xC96D0000U, 0xF90E0000U, 0xE92F0000U, 0x99C80000U, 0x89E90000U, 0xB98A0000U, 0xA9AB0000U,
+    0x58440000U, 0x48650000U, 0x78060000U, 0x68270000U, 0x18C00000U, 0x08E10000U, 0x38820000U, 0x28A30000U,
+    0xCB7D0000U, 0xDB5C0000U, 0xEB3F0000U, 0xFB1E0000U, 0x8BF90000U, 0x9BD80000U, 0xABBB0000U, 0xBB9A0000U,
+    0x4A750000U, 0x5A540000U, 0x6A370000U, 0x7A160000U, 0x0AF10000U, 0x1AD00000U, 0x2AB30000U, 0x3A920000U,
+    0xFD2E0000U, 0xED0F0000U, 0xDD6C0000U, 0xCD4D0000U, 0xBDAA0000U, 0xAD8B0000U, 0x9DE80000U, 0x8DC90000U,
+    0x7C260000U, 0x6C070000U, 0x5C640000U, 0x4C450000U, 0x3CA20000U, 0x2C830000U, 0x1CE00000U, 0x0CC10000U,
+    0xEF1F0000U, 0xFF3E0000U, 0xCF5D0000U, 0xDF7C0000U, 0xAF9B0000U, 0xBFBA0000U, 0x8FD90000U, 0x9FF80000U,
+    0x6E170000U, 0x7E360000U, 0x4E550000U, 0x5E740000U, 0x2E930000U, 0x3EB20000U, 0x0ED10000U, 0x1EF00000U
+};
+
+/** Byte-wise table for CRC-24Q, polynomial 0x864CFB, left-aligned.
+ */
+static const uint32_t gCrc24qTable[256] = {
+    0x00000000U, 0x864CFB00U, 0x8AD50D00U, 0x0C99F600U, 0x93E6E100U, 0x15AA1A00U, 0x1933EC00U, 0x9F7F1700U,
+    0xA1813900U, 0x27CDC200U, 0x2B543400U, 0xAD18CF00U, 0x3267D800U, 0xB42B2300U, 0xB8B2D500U, 0x3EFE2E00U,
+    0xC54E8900U, 0x43027200U, 0x4F9B8400U, 0xC9D77F00U, 0x56A86800U, 0xD0E49300U, 0xDC7D6500U, 0x5A319E00U,
+    0x64CFB000U, 0xE2834B00U, 0xEE1ABD00U, 0x68564600U, 0xF7295100U, 0x7165AA00U, 0x7DFC5C00U, 0xFBB0A700U,
+    0x0CD1E900U, 0x8A9D1200U, 0x8604E400U, 0x00481F00U, 0x9F370800U, 0x197BF300U, 0x15E20500U, 0x93AEFE00U,
+    0xAD50D000U, 0x2B1C2B00U, 0x2785DD00U, 0xA1C92600U, 0x3EB63100U, 0xB8FACA00U, 0xB4633C00U, 0x322FC700U,
+    0xC99F6000U, 0x4FD39B00U, 0x434A6D00U, 0xC5069600U, 0x5A798100U, 0xDC357A00U, 0xD0AC8C00U, 0x56E07700U,
+    0x681E5900U, 0xEE52A200U, 0xE2CB5400U, 0x6487AF00U, 0xFBF8B800U, 0x7DB44300U, 0x712DB500U, 0xF7614E00U,
+    0x19A3D200U, 0x9FEF2900U, 0x9376DF00U, 0x153A2400U, 0x8A453300U, 0x0C09C800U, 0x00903E00U, 0x86DCC500U,
+    0xB822EB00U, 0x3E6E1000U, 0x32F7E600U, 0xB4BB1D00U, 0x2BC40A00U, 0xAD88F100U, 0xA1110700U, 0x275DFC00U,
+    0xDCED5B00U, 0x5AA1A000U, 0x56385600U, 0xD074AD00U, 0x4F0BBA00U, 0xC9474100U, 0xC5DEB700U, 0x43924C00U,
+    0x7D6C6200U, 0xFB209900U, 0xF7B96F00U, 0x71F59400U, 0xEE8A8300U, 0x68C67800U, 0x645F8E00U, 0xE2137500U,
+    0x15723B00U, 0x933EC000U, 0x9FA73600U, 0x19EBCD00U, 0x8694DA00U, 0x00D82100U, 0x0C41D700U, 0x8A0D2C00U,
+    0xB4F30200U, 0x32BFF900U, 0x3E260F00U, 0xB86AF400U, 0x2715E300U, 0xA1591800U, 0xADC0EE00U, 0x2B8C1500U,
+    0xD03CB200U, 0x56704900U, 0x5AE9BF00U, 0xDCA54400U, 0x43DA5300U, 0xC596A800U, 0xC90F5E00U, 0x4F43A500U,
+    0x71BD8B00U, 0xF7F17000U, 0xFB688600U, 0x7D247D00U, 0xE25B6A00U, 0x64179100U, 0x688E6700U, 0xEEC29C00U,
+    0x3347A400U, 0xB50B5F00U, 0xB992A900U, 0x3FDE5200U, 0xA0A14500U, 0x26EDBE00U, 0x2A744800U, 0xAC38B300U,
+    0x92C69D00U, 0x148A6600U, 0x18139000U, 0x9E5F6B00U, 0x01207C00U, 0x876C8700U, 0x8BF57100U, 0x0DB98A00U,
+    0xF6092D00U, 0x7045D600U, 0x7CDC2000U, 0xFA90DB00U, 0x65EFCC00U, 0xE3A33700U, 0xEF3AC100U, 0x69763A00U,
+    0x57881400U, 0xD1C4EF00U, 0xDD5D1900U, 0x5B11E200U, 0xC46EF500U, 0x42220E00U, 0x4EBBF800U, 0xC8F70300U,
+    0x3F964D00U, 0xB9DAB600U, 0xB5434000U, 0x330FBB00U, 0xAC70AC00U, 0x2A3C5700U, 0x26A5A100U, 0xA0E95A00U,
+    0x9E177400U, 0x185B8F00U, 0x14C27900U, 0x928E8200U, 0x0DF19500U, 0x8BBD6E00U, 0x87249800U, 0x01686300U,
+    0xFAD8C400U, 0x7C943F00U, 0x700DC900U, 0xF6413200U, 0x693E2500U, 0xEF72DE00U, 0xE3EB2800U, 0x65A7D300U,
+    0x5B59FD00U, 0xDD150600U, 0xD18CF000U, 0x57C00B00U, 0xC8BF1C00U, 0x4EF3E700U, 0x426A1100U, 0xC426EA00U,
+    0x2AE47600U, 0xACA88D00U, 0xA0317B00U, 0x267D8000U, 0xB9029700U, 0x3F4E6C00U, 0x33D79A00U, 0xB59B6100U,
+    0x8B654F00U, 0x0D29B400U, 0x01B04200U, 0x87FCB900U, 0x1883AE00U, 0x9ECF5500U, 0x9256A300U, 0x141A5800U,
+    0xEFAAFF00U, 0x69E60400U, 0x657FF200U, 0xE3330900U, 0x7C4C1E00U, 0xFA00E500U, 0xF6991300U, 0x70D5E800U,
+    0x4E2BC600U, 0xC8673D00U, 0xC4FECB00U, 0x42B23000U, 0xDDCD2700U, 0x5B81DC00U, 0x57182A00U, 0xD154D100U,
+    0x26359F00U, 0xA0796400U, 0xACE09200U, 0x2AAC6900U, 0xB5D37E00U, 0x339F8500U, 0x3F067300U, 0xB94A8800U,
+    0x87B4A600U, 0x01F85D00U, 0x0D61AB00U, 0x8B2D5000U, 0x14524700U, 0x921EBC00U, 0x9E874A00U, 0x18CBB100U,
+    0xE37B1600U, 0x6537ED00U, 0x69AE1B00U, 0xEFE2E000U, 0x709DF700U, 0xF6D10C00U, 0xFA48FA00U, 0x7C040100U,
+    0x42FA2F00U, 0xC4B6D400U, 0xC82F2200U, 0x4E63D900U, 0xD11CCE00U, 0x57503500U, 0x5BC9C300U, 0xDD853800U
+};
+
+/** Byte-wise table for CRC-32, polynomial 0x04C11DB7, left-aligned.
+ */
+static const uint32_t gCrc32Table[256] = {
+    0x00000000U, 0x04C11DB7U, 0x09823B6EU, 0x0D4326D9U, 0x130476DCU, 0x17C56B6BU, 0x1A864DB2U, 0x1E475005U,
+    0x2608EDB8U, 0x22C9F00FU, 0x2F8AD6D6U, 0x2B4BCB61U, 0x350C9B64U, 0x31CD86D3U, 0x3C8EA00AU, 0x384FBDBDU,
+    0x4C11DB70U, 0x48D0C6C7U, 0x4593E01EU, 0x4152FDA9U, 0x5F15ADACU, 0x5BD4B01BU, 0x569796C2U, 0x52568B75U,
+    0x6A1936C8U, 0x6ED82B7FU, 0x639B0DA6U, 0x675A1011U, 0x791D4014U, 0x7DDC5DA3U, 0x709F7B7AU, 0x745E66CDU,
+    0x9823B6E0U, 0x9CE2AB57U, 0x91A18D8EU, 0x95609039U, 0x8B27C03CU, 0x8FE6DD8BU, 0x82A5FB52U, 0x8664E6E5U,
+    0xBE2B5B58U, 0xBAEA46EFU, 0xB7A96036U, 0xB3687D81U, 0xAD2F2D84U, 0xA9EE3033U, 0xA4AD16EAU, 0xA06C0B5DU,
+    0xD4326D90U, 0xD0F37027U, 0xDDB056FEU, 0xD9714B49U, 0xC7361B4CU, 0xC3F706FBU, 0xCEB42022U, 0xCA753D95U,
+    0xF23A8028U, 0xF6FB9D9FU, 0xFBB8BB46U, 0xFF79A6F1U, 0xE13EF6F4U, 0xE5FFEB43U, 0xE8BCCD9AU, 0xEC7DD02DU,
+    0x34867077U, 0x30476DC0U, 0x3D044B19U, 0x39C556AEU, 0x278206ABU, 0x23431B1CU, 0x2E003DC5U, 0x2AC12072U,
+    0x128E9DCFU, 0x164F8078U, 0x1B0CA6A1U, 0x1FCDBB16U, 0x018AEB13U, 0x054BF6A4U, 0x0808D07DU, 0x0CC9CDCAU,
+    0x7897AB07U, 0x7C56B6B0U, 0x71159069U, 0x75D48DDEU, 0x6B93DDDBU, 0x6F52C06CU, 0x6211E6B5U, 0x66D0FB02U,
+    0x5E9F46BFU, 0x5A5E5B08U, 0x571D7DD1U, 0x53DC6066U, 0x4D9B3063U, 0x495A2DD4U, 0x44190B0DU, 0x40D816BAU,
+    0xACA5C697U, 0xA864DB20U, 0xA527FDF9U, 0xA1E6E04EU, 0xBFA1B04BU, 0xBB60ADFCU, 0xB6238B25U, 0xB2E29692U,
+    0x8AAD2B2FU, 0x8E6C3698U, 0x832F1041U, 0x87EE0DF6U, 0x99A95DF3U, 0x9D684044U, 0x902B669DU, 0x94EA7B2AU,
+    0xE0B41DE7U, 0xE4750050U, 0xE9362689U, 0xEDF73B3EU, 0xF3B06B3BU, 0xF771768CU, 0xFA325055U, 0xFEF34DE2U,
+    0xC6BCF05FU, 0xC27DEDE8U, 0xCF3ECB31U, 0xCBFFD686U, 0xD5B88683U, 0xD1799B34U, 0xDC3ABDEDU, 0xD8FBA05AU,
+    0x690CE0EEU, 0x6DCDFD59U, 0x608EDB80U, 0x644FC637U, 0x7A089632U, 0x7EC98B85U, 0x738AAD5CU, 0x774BB0EBU,
+    0x4F040D56U, 0x4BC510E1U, 0x46863638U, 0x42472B8FU, 0x5C007B8AU, 0x58C1663DU, 0x558240E4U, 0x51435D53U,
+    0x251D3B9EU, 0x21DC2629U, 0x2C9F00F0U, 0x285E1D47U, 0x36194D42U, 0x32D850F5U, 0x3F9B762CU, 0x3B5A6B9BU,
+    0x0315D626U, 0x07D4CB91U, 0x0A97ED48U, 0x0E56F0FFU, 0x1011A0FAU, 0x14D0BD4DU, 0x19939B94U, 0x1D528623U,
+    0xF12F560EU, 0xF5EE4BB9U, 0xF8AD6D60U, 0xFC6C70D7U, 0xE22B20D2U, 0xE6EA3D65U, 0xEBA91BBCU, 0xEF68060BU,
+    0xD727BBB6U, 0xD3E6A601U, 0xDEA580D8U, 0xDA649D6FU, 0xC423CD6AU, 0xC0E2D0DDU, 0xCDA1F604U, 0xC960EBB3U,
+    0xBD3E8D7EU, 0xB9FF90C9U, 0xB4BCB610U, 0xB07DABA7U, 0xAE3AFBA2U, 0xAAFBE615U, 0xA7B8C0CCU, 0xA379DD7BU,
+    0x9B3660C6U, 0x9FF77D71U, 0x92B45BA8U, 0x9675461FU, 0x8832161AU, 0x8CF30BADU, 0x81B02D74U, 0x857130C3U,
+    0x5D8A9099U, 0x594B8D2EU, 0x5408ABF7U, 0x50C9B640U, 0x4E8EE645U, 0x4A4FFBF2U, 0x470CDD2BU, 0x43CDC09CU,
+    0x7B827D21U, 0x7F436096U, 0x7200464FU, 0x76C15BF8U, 0x68860BFDU, 0x6C47164AU, 0x61043093U, 0x65C52D24U,
+    0x119B4BE9U, 0x155A565EU, 0x18197087U, 0x1CD86D30U, 0x029F3D35U, 0x065E2082U, 0x0B1D065BU, 0x0FDC1BECU,
+    0x3793A651U, 0x3352BBE6U, 0x3E119D3FU, 0x3AD08088U, 0x2497D08DU, 0x2056CD3AU, 0x2D15EBE3U, 0x29D4F654U,
+    0xC5A92679U, 0xC1683BCEU, 0xCC2B1D17U, 0xC8EA00A0U, 0xD6AD50A5U, 0xD26C4D12U, 0xDF2F6BCBU, 0xDBEE767CU,
+    0xE3A1CBC1U, 0xE760D676U, 0xEA23F0AFU, 0xEEE2ED18U, 0xF0A5BD1DU, 0xF464A0AAU, 0xF9278673U, 0xFDE69BC4U,
+    0x89B8FD09U, 0x8D79E0BEU, 0x803AC667U, 0x84FBDBD0U, 0x9ABC8BD5U, 0x9E7D9662U, 0x933EB0BBU, 0x97FFAD0CU,
+    0xAFB010B1U, 0xAB710D06U, 0xA6322BDFU, 0xA2F33668U, 0xBCB4666DU, 0xB8757BDAU, 0xB5365D03U, 0xB1F740B4U
+};
+
+/** The engines for each polynomial, populated on first use.
+ */
+static uCrcEngine_t gEngineCrc8 = {.pTable = gCrc8Table};
+static uCrcEngine_t gEngineCrc16 = {.pTable = gCrc16Table};
+static uCrcEngine_t gEngineCrc24q = {.pTable = gCrc24qTable};
+static uCrcEngine_t gEngineCrc32 = {.pTable = gCrc32Table};
+
+/** The name of the implementation in use for large blocks,
+ * NULL until determined; set with U_ATOMIC_SET_RELEASE() once
+ * gPclmul has been set and read with U_ATOMIC_GET_ACQUIRE().
+ */
+static const char *volatile gpImplementation = NULL;
+
+#ifdef U_CRC_PCLMUL
+/** True if the CPU supports PCLMULQDQ (and SSSE3, used for
+ * byte-swapping).
+ */
+static bool gPclmul = false;
+#endif
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Determine the implementation to use for large blocks.
+static const char *pImplementation()
+{
+    const char *pName = U_ATOMIC_GET_ACQUIRE(&gpImplementation);
+
+    if (pName == NULL) {
+        pName = "byte-wise";
+#ifdef U_CRC_SLICE_BY_8
+        pName = "slice-by-8";
+#endif
+#ifdef U_CRC_PCLMUL
+        __builtin_cpu_init();
+        gPclmul = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+        if (gPclmul) {
+            pName = "pclmul";
+        }
+#endif
+        U_ATOMIC_SET_RELEASE(&gpImplementation, pName);
+    }
+
+    return pName;
+}
+
+#ifdef U_CRC_PCLMUL
+// Compute x^n mod P, where polynomial is P without its x^32 term.
+static uint32_t xPowerModP(uint32_t polynomial, size_t n)
+{
+    uint32_t remainder = 1;
+
+    for (size_t x = 0; x < n; x++) {
+        if (remainder & 0x80000000U) {
+            remainder = (remainder << 1) ^ polynomial;
+        } else {
+            remainder <<= 1;
+        }
+    }
+
+    return remainder;
+}
+#endif
+
+// Populate whatever an engine needs beyond its byte-wise table.
+static void engineInit(uCrcEngine_t *pEngine)
+{
+#ifdef U_CRC_SLICE_BY_8
+    const uint32_t *pPrevious = pEngine->pTable;
+    uint32_t value;
+
+    for (size_t x = 0; x < 7; x++) {
+        for (size_t y = 0; y < 256; y++) {
+            value = pPrevious[y];
+            pEngine->slice[x][y] = (value << 8) ^ pEngine->pTable[value >> 24];
+        }
+        pPrevious = pEngine->slice[x];
+    }
+#endif
+#ifdef U_CRC_PCLMUL
+    // The byte-wise table entry for 1 is x^32 mod P, which is
+    // P without its x^32 term
+    pEngine->fold128[0] = xPowerModP(pEngine->pTable[1], 128);
+    pEngine->fold128[1] = xPowerModP(pEngine->pTable[1], 192);
+    pEngine->fold512[0] = xPowerModP(pEngine->pTable[1], 512);
+    pEngine->fold512[1] = xPowerModP(pEngine->pTable[1], 576);
+#endif
+    U_ATOMIC_SET_RELEASE(&(pEngine->ready), true);
+}
+
+// Add a block of data to a left-aligned CRC using the tables.
+static uint32_t crcTable(const uCrcEngine_t *pEngine, uint32_t crc,
+                         const uint8_t *pData, size_t size)
+{
+    const uint32_t *pTable = pEngine->pTable;
+
+#ifdef U_CRC_SLICE_BY_8
+    while (size >= 8) {
+        crc ^= ((uint32_t) pData[0] << 24) | ((uint32_t) pData[1] << 16) |
+               ((uint32_t) pData[2] << 8) | pData[3];
+        crc = pEngine->slice[6][crc >> 24] ^
+              pEngine->slice[5][(crc >> 16) & 0xff] ^
+              pEngine->slice[4][(crc >> 8) & 0xff] ^
+              pEngine->slice[3][crc & 0xff] ^
+              pEngine->slice[2][pData[4]] ^
+              pEngine->slice[1][pData[5]] ^
+              pEngine->slice[0][pData[6]] ^
+              pTable[pData[7]];
+        pData += 8;
+        size -= 8;
+    }
+#endif
+
+    while (size > 0) {
+        crc = (crc << 8) ^ pTable[(crc >> 24) ^ *pData];
+        pData++;
+        size--;
+    }
+
+    return crc;
+}
+
+#ifdef U_CRC_PCLMUL
+
+// Fold a 128-bit value forward across the distance for which
+// constants is x^distance mod P (low 64 bits) and
+// x^(distance + 64) mod P (high 64 bits).
+__attribute__((target("pclmul,ssse3")))
+static __m128i fold(__m128i value, __m128i constants)
+{
+    return _mm_xor_si128(_mm_clmulepi64_si128(value, constants, 0x11),
+                         _mm_clmulepi64_si128(value, constants, 0x00));
+}
+
+// Add a block of data, a multiple of 16 bytes long and at least
+// U_CRC_PCLMUL_MIN_SIZE_BYTES, to a left-aligned CRC with PCLMULQDQ.
+__attribute__((target("pclmul,ssse3")))
+static uint32_t crcPclmul(const uCrcEngine_t *pEngine, uint32_t crc,
+                          const uint8_t *pData, size_t size)
+{
+    // Reverse the bytes so that the first byte, which carries the
+    // most significant coefficients, is at the top of the register
+    const __m128i swap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+                                      8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i fold128 = _mm_set_epi64x((int64_t) pEngine->fold128[1],
+                                           (int64_t) pEngine->fold128[0]);
+    const __m128i fold512 = _mm_set_epi64x((int64_t) pEngine->fold512[1],
+                                           (int64_t) pEngine->fold512[0]);
+    __m128i x0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) pData), swap);
+    __m128i x1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (pData + 16)), swap);
+    __m128i x2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (pData + 32)), swap);
+    __m128i x3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (pData + 48)), swap);
+    uint8_t remainder[16];
+
+    // The CRC so far is added to the first 32 bits of the message
+    x0 = _mm_xor_si128(x0, _mm_set_epi32((int32_t) crc, 0, 0, 0));
+    pData += 64;
+    size -= 64;
+
+    // Fold four lots of 16 bytes at a time
+    while (size >= 64) {
+        x0 = _mm_xor_si128(fold(x0, fold512),
+                           _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) pData), swap));
+        x1 = _mm_xor_si128(fold(x1, fold512),
+                           _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (pData + 16)), swap));
+        x2 = _mm_xor_si128(fold(x2, fold512),
+                           _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (pData + 32)), swap));
+        x3 = _mm_xor_si128(fold(x3, fold512),
+                           _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (pData + 48)), swap));
+        pData += 64;
+        size -= 64;
+    }
+
+    // Fold the four down to one
+    x1 = _mm_xor_si128(x1, fold(x0, fold128));
+    x2 = _mm_xor_si128(x2, fold(x1, fold128));
+    x3 = _mm_xor_si128(x3, fold(x2, fold128));
+
+    // Fold in any remaining 16 byte blocks
+    while (size >= 16) {
+        x3 = _mm_xor_si128(fold(x3, fold128),
+                           _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) pData), swap));
+        pData += 16;
+        size -= 16;
+    }
+
+    // What remains is congruent to the message so far, so its
+    // CRC is the CRC of the message so far
+    _mm_storeu_si128((__m128i *) remainder, _mm_shuffle_epi8(x3, swap));
+
+    return crcTable(pEngine, 0, remainder, sizeof(remainder));
+}
+
+#endif // #ifdef U_CRC_PCLMUL
+
+// Add a block of data to a left-aligned CRC.
+static uint32_t crcAdd(uCrcEngine_t *pEngine, uint32_t crc,
+                       const char *pData, size_t size)
+{
+    const uint8_t *pBytes = (const uint8_t *) pData;
+#ifdef U_CRC_PCLMUL
+    size_t length;
+#endif
+
+    if ((pData != NULL) && (size > 0)) {
+        if (!U_ATOMIC_GET_ACQUIRE(&(pEngine->ready))) {
+            pImplementation();
+            engineInit(pEngine);
+        }
+#ifdef U_CRC_PCLMUL
+        if (gPclmul && (size >= U_CRC_PCLMUL_MIN_SIZE_BYTES)) {
+            length = size & ~((size_t) 0x0f);
+            crc = crcPclmul(pEngine, crc, pBytes, length);
+            pBytes += length;
+            size -= length;
+        }
+#endif
+        crc = crcTable(pEngine, crc, pBytes, size);
+    }
+
+    return crc;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Add a block of data to a CRC-8.
+uint8_t uCrc8(uint8_t crc, const char *pData, size_t size)
+{
+    return (uint8_t) (crcAdd(&gEngineCrc8, ((uint32_t) crc) << 24, pData, size) >> 24);
+}
+
+// Add a block of data to a CRC-16.
+uint16_t uCrc16(uint16_t crc, const char *pData, size_t size)
+{
+    return (uint16_t) (crcAdd(&gEngineCrc16, ((uint32_t) crc) << 16, pData, size) >> 16);
+}
+
+// Add a block of data to a CRC-24Q.
+uint32_t uCrc24q(uint32_t crc, const char *pData, size_t size)
+{
+    return crcAdd(&gEngineCrc24q, crc << 8, pData, size) >> 8;
+}
+
+// Add a block of data to a CRC-32.
+uint32_t uCrc32(uint32_t crc, const char *pData, size_t size)
+{
+    return crcAdd(&gEngineCrc32, crc, pData, size);
+}
+
+// Get the name of the CRC implementation in use.
+const char *uCrcImplementation()
+{
+    return pImplementation();
+}
+
+// End of file
@@ -28,11 +28,13 @@
 # include "u_cfg_override.h" // For a customer's configuration override
 #endif
 
+#include "stdlib.h"    // malloc()
 #include "string.h"
 #include "stdint.h"    // int32_t etc.
 #include "stdbool.h"
 
 #include "u_cfg_sw.h"
+#include "u_compiler.h" // U_ATOMIC_XXX() macros
 #include "u_assert.h"
 #include "u_port.h"
 #include "u_port_os.h"
@@ -64,6 +66,33 @@
 
 #define U_FENCE_MAGIC 0xBEEF
 
+/** The block size of the given class of the size-class pool.
+ */
+#define U_MEMPOOL_CLASS_BLOCK_SIZE(sizeClass) \
+    (((size_t) U_MEMPOOL_CLASS_MIN_BLOCK_SIZE) << (sizeClass))
+
+/** The number of bytes occupied by one shard of the given class
+ * of the size-class pool.
+ */
+#define U_MEMPOOL_CLASS_SHARD_SIZE(sizeClass) \
+    (U_MEMPOOL_CLASS_BLOCK_SIZE(sizeClass) * U_MEMPOOL_CLASS_BLOCK_COUNT)
+
+/** The head of a shard free list holds the index of the first free
+ * block plus one, zero meaning empty, in the bottom 16 bits and a
+ * tag, incremented on every change, in the top 16 bits so that a
+ * compare-and-exchange can't be fooled by the head having been
+ * popped and pushed back again in the meantime.
+ */
+#define U_MEMPOOL_CLASS_HEAD(tag, indexPlusOne) \
+    ((((tag) + 0x10000UL) & 0xFFFF0000UL) | (indexPlusOne))
+
+/** State of the size-class pool, see gClassState.
+ */
+#define U_MEMPOOL_CLASS_STATE_NONE  0
+#define U_MEMPOOL_CLASS_STATE_BUSY  1
+#define U_MEMPOOL_CLASS_STATE_READY 2
+#define U_MEMPOOL_CLASS_STATE_FAILED 3
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -72,6 +101,16 @@ typedef struct uMemPoolFree {
     struct uMemPoolFree *pNext;
 } uMemPoolFreeList_t;
 
+/** A class of the size-class pool.
+ */
+typedef struct {
+    uint8_t *pBlocks; /**< The first block of the first shard. */
+    uint32_t head[U_MEMPOOL_CLASS_NUM_SHARDS]; /**< Free list heads. */
+    int32_t numUsed;
+    int32_t highWaterMark;
+    int32_t numFailed;
+} uMemPoolClass_t;
+
 /* ----------------------------------------------------------------
  * PROTOTYPES
  * -------------------------------------------------------------- */
@@ -80,6 +119,23 @@ typedef struct uMemPoolFree {
  * STATIC VARIABLES
  * -------------------------------------------------------------- */
 
+/** The classes of the size-class pool.
+ */
+static uMemPoolClass_t gClass[U_MEMPOOL_CLASS_NUM];
+
+/** The memory of the size-class pool, all classes, one after
+ * the other.
+ */
+static uint8_t *gpClassMemory = NULL;
+
+/** The size of gpClassMemory.
+ */
+static size_t gClassMemorySize = 0;
+
+/** The state of the size-class pool, U_MEMPOOL_CLASS_STATE_xxx.
+ */
+static int32_t gClassState = U_MEMPOOL_CLASS_STATE_NONE;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -101,6 +157,106 @@ static void initFreeList(uMemPoolDesc_t *pMemPool)
     pMemPool->usedBlockCount = 0;
 }
 
+// Set up the size-class pool if it has not been already, returning
+// true if it is ready.  Whoever gets there first does the work: anyone
+// arriving meanwhile is told it is not ready and goes elsewhere.
+static bool classInit()
+{
+    int32_t state = U_ATOMIC_GET_ACQUIRE(&gClassState);
+    size_t offset = 0;
+    uint8_t *pBlock;
+    uint16_t indexPlusOne;
+
+    if ((state == U_MEMPOOL_CLASS_STATE_NONE) &&
+        U_ATOMIC_COMPARE_EXCHANGE(&gClassState, &state, U_MEMPOOL_CLASS_STATE_BUSY)) {
+        // Straight from the C library, the pool is below pUPortMalloc()
+        state = U_MEMPOOL_CLASS_STATE_FAILED;
+        for (size_t x = 0; x < U_MEMPOOL_CLASS_NUM; x++) {
+            gClassMemorySize += U_MEMPOOL_CLASS_SHARD_SIZE(x) * U_MEMPOOL_CLASS_NUM_SHARDS;
+        }
+        gpClassMemory = (uint8_t *) malloc(gClassMemorySize);
+        if (gpClassMemory != NULL) {
+            for (size_t x = 0; x < U_MEMPOOL_CLASS_NUM; x++) {
+                gClass[x].pBlocks = gpClassMemory + offset;
+                offset += U_MEMPOOL_CLASS_SHARD_SIZE(x) * U_MEMPOOL_CLASS_NUM_SHARDS;
+                for (size_t y = 0; y < U_MEMPOOL_CLASS_NUM_SHARDS; y++) {
+                    // Chain the blocks of the shard together, each free
+                    // block holding the index plus one of the next
+                    pBlock = gClass[x].pBlocks + (y * U_MEMPOOL_CLASS_SHARD_SIZE(x));
+                    for (size_t z = 0; z < U_MEMPOOL_CLASS_BLOCK_COUNT; z++) {
+                        indexPlusOne = (z + 1 < U_MEMPOOL_CLASS_BLOCK_COUNT) ? (uint16_t) (z + 2) : 0;
+                        memcpy(pBlock, &indexPlusOne, sizeof(indexPlusOne));
+                        pBlock += U_MEMPOOL_CLASS_BLOCK_SIZE(x);
+                    }
+                    gClass[x].head[y] = 1;
+                }
+            }
+            state = U_MEMPOOL_CLASS_STATE_READY;
+        }
+        U_ATOMIC_SET_RELEASE(&gClassState, state);
+    }
+
+    return (state == U_MEMPOOL_CLASS_STATE_READY);
+}
+
+// Pick the shard that the current task should allocate from first.
+static size_t classShardGet()
+{
+    uPortTaskHandle_t taskHandle = NULL;
+    uint32_t hash = 0;
+
+    if (uPortTaskGetHandle(&taskHandle) == 0) {
+        // Task handles are often aligned pointers, so mix the bits
+        hash = (uint32_t) (uintptr_t) taskHandle;
+        hash ^= (uint32_t) (((uint64_t) (uintptr_t) taskHandle) >> 32);
+        hash ^= hash >> 16;
+        hash *= 0x45D9F3BUL;
+        hash ^= hash >> 16;
+    }
+
+    return hash % U_MEMPOOL_CLASS_NUM_SHARDS;
+}
+
+// Pop a block off the free list of a shard of a class.
+static void *classPop(uMemPoolClass_t *pClass, size_t sizeClass, size_t shard)
+{
+    uint8_t *pBlock = NULL;
+    uint8_t *pShard = pClass->pBlocks + (shard * U_MEMPOOL_CLASS_SHARD_SIZE(sizeClass));
+    uint32_t head = U_ATOMIC_GET_ACQUIRE(&(pClass->head[shard]));
+    uint16_t nextPlusOne;
+
+    while ((pBlock == NULL) && ((head & 0xFFFF) != 0)) {
+        pBlock = pShard + (((head & 0xFFFF) - 1) * U_MEMPOOL_CLASS_BLOCK_SIZE(sizeClass));
+        // If another task gets in first this may read what is by
+        // then user data but the tag means that the exchange
+        // below will fail and we go around again
+        memcpy(&nextPlusOne, pBlock, sizeof(nextPlusOne));
+        if (!U_ATOMIC_COMPARE_EXCHANGE(&(pClass->head[shard]), &head,
+                                       U_MEMPOOL_CLASS_HEAD(head, nextPlusOne))) {
+            pBlock = NULL;
+        }
+    }
+
+    return (void *) pBlock;
+}
+
+// Push a block back onto the free list of the shard it came from.
+static void classPush(uMemPoolClass_t *pClass, size_t sizeClass, uint8_t *pBlock)
+{
+    size_t offset = (size_t) (pBlock - pClass->pBlocks);
+    size_t shard = offset / U_MEMPOOL_CLASS_SHARD_SIZE(sizeClass);
+    uint32_t indexPlusOne = ((offset % U_MEMPOOL_CLASS_SHARD_SIZE(sizeClass)) /
+                             U_MEMPOOL_CLASS_BLOCK_SIZE(sizeClass)) + 1;
+    uint32_t head = U_ATOMIC_GET_ACQUIRE(&(pClass->head[shard]));
+    uint16_t nextPlusOne;
+
+    do {
+        nextPlusOne = (uint16_t) (head & 0xFFFF);
+        memcpy(pBlock, &nextPlusOne, sizeof(nextPlusOne));
+    } while (!U_ATOMIC_COMPARE_EXCHANGE(&(pClass->head[shard]), &head,
+                                        U_MEMPOOL_CLASS_HEAD(head, indexPlusOne)));
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -215,4 +371,79 @@ void uMemPoolFreeAllMem(uMemPoolDesc_t *pMemPool)
     }
 }
 
+void *uMemPoolClassAllocMem(size_t sizeBytes)
+{
+    void *pAllocMem = NULL;
+    size_t sizeClass = 0;
+    size_t shard;
+    uMemPoolClass_t *pClass;
+    int32_t numUsed;
+    int32_t highWaterMark;
+
+    while ((sizeClass < U_MEMPOOL_CLASS_NUM) &&
+           (sizeBytes > U_MEMPOOL_CLASS_BLOCK_SIZE(sizeClass))) {
+        sizeClass++;
+    }
+    if ((sizeBytes > 0) && (sizeClass < U_MEMPOOL_CLASS_NUM) && classInit()) {
+        pClass = &(gClass[sizeClass]);
+        // Try our own shard first, then the others
+        shard = classShardGet();
+        for (size_t x = 0; (pAllocMem == NULL) && (x < U_MEMPOOL_CLASS_NUM_SHARDS); x++) {
+            pAllocMem = classPop(pClass, sizeClass, (shard + x) % U_MEMPOOL_CLASS_NUM_SHARDS);
+        }
+        if (pAllocMem != NULL) {
+            numUsed = U_ATOMIC_GET(&(pClass->numUsed));
+            while (!U_ATOMIC_COMPARE_EXCHANGE(&(pClass->numUsed), &numUsed, numUsed + 1)) {}
+            numUsed++;
+            highWaterMark = U_ATOMIC_GET(&(pClass->highWaterMark));
+            while ((numUsed > highWaterMark) &&
+                   !U_ATOMIC_COMPARE_EXCHANGE(&(pClass->highWaterMark), &highWaterMark, numUsed)) {}
+        } else {
+            U_ATOMIC_INCREMENT(&(pClass->numFailed));
+        }
+    }
+
+    return pAllocMem;
+}
+
+bool uMemPoolClassFreeMem(void *pMem)
+{
+    bool isPoolMem = false;
+    uint8_t *pBlock = (uint8_t *) pMem;
+    size_t sizeClass = 0;
+
+    if ((pBlock != NULL) &&
+        (U_ATOMIC_GET_ACQUIRE(&gClassState) == U_MEMPOOL_CLASS_STATE_READY) &&
+        (pBlock >= gpClassMemory) && (pBlock < gpClassMemory + gClassMemorySize)) {
+        isPoolMem = true;
+        while ((sizeClass + 1 < U_MEMPOOL_CLASS_NUM) &&
+               (pBlock >= gClass[sizeClass + 1].pBlocks)) {
+            sizeClass++;
+        }
+        // Make sure this is the start of a block
+        U_ASSERT(((size_t) (pBlock - gClass[sizeClass].pBlocks) %
+                  U_MEMPOOL_CLASS_BLOCK_SIZE(sizeClass)) == 0);
+        classPush(&(gClass[sizeClass]), sizeClass, pBlock);
+        U_ATOMIC_DECREMENT(&(gClass[sizeClass].numUsed));
+    }
+
+    return isPoolMem;
+}
+
+int32_t uMemPoolClassStatsGet(int32_t sizeClass, uMemPoolClassStats_t *pStats)
+{
+    int32_t err = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((sizeClass >= 0) && (sizeClass < U_MEMPOOL_CLASS_NUM) && (pStats != NULL)) {
+        pStats->blockSize = U_MEMPOOL_CLASS_BLOCK_SIZE(sizeClass);
+        pStats->numBlocks = U_MEMPOOL_CLASS_BLOCK_COUNT * U_MEMPOOL_CLASS_NUM_SHARDS;
+        pStats->numUsed = U_ATOMIC_GET(&(gClass[sizeClass].numUsed));
+        pStats->highWaterMark = U_ATOMIC_GET(&(gClass[sizeClass].highWaterMark));
+        pStats->numFailed = U_ATOMIC_GET(&(gClass[sizeClass].numFailed));
+        err = (int32_t)U_ERROR_COMMON_SUCCESS;
+    }
+
+    return err;
+}
+
 // End of file
@@ -68,6 +68,7 @@ typedef struct {
     size_t bytesAvailable;
     size_t bytesParsed;
     size_t bytesDiscard;
+    size_t bytesSkip; /**< set by uRingBufferFindByteUnprotected(). */
 } uRingBufferParseContext_t;
 
 /* ----------------------------------------------------------------
@@ -143,35 +144,103 @@ static int32_t createCommon(uRingBuffer_t *pRingBuffer, char *pLinearBuffer, siz
     return uPortMutexCreate((uPortMutexHandle_t *) &pRingBuffer->mutex);
 }
 
+// Get the data at a read pointer as up to U_RING_BUFFER_NUM_SPANS
+// contiguous spans, returning the total length of the spans.
 // The ring buffer's mutex should be locked before this is called
-static size_t read(uRingBuffer_t *pRingBuffer, int32_t handle, char *pData,
-                   size_t length, size_t offset, bool destructive)
+static size_t spans(uRingBuffer_t *pRingBuffer, int32_t handle,
+                    uRingBufferSpan_t *pSpans, size_t length, size_t offset)
 {
-    size_t bytesRead = 0;
+    size_t total = 0;
     size_t available;
+    size_t size;
     const char *pSource;
 
+    memset(pSpans, 0, sizeof(*pSpans) * U_RING_BUFFER_NUM_SPANS);
     if ((handle >= 0) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
         (pRingBuffer->pDataRead[handle] != NULL)) {
+        available = ptrDiff(pRingBuffer->pDataRead[handle], pRingBuffer->pDataWrite,
+                            pRingBuffer->size);
+        if (offset < available) {
+            available -= offset;
+            if (length > available) {
+                length = available;
+            }
+            pSource = pPtrOffset(pRingBuffer->pDataRead[handle], offset,
+                                 pRingBuffer->pBuffer, pRingBuffer->size);
+            for (size_t x = 0; (x < U_RING_BUFFER_NUM_SPANS) && (total < length); x++) {
+                size = (pRingBuffer->pBuffer + pRingBuffer->size) - pSource;
+                if (size > length - total) {
+                    size = length - total;
+                }
+                pSpans[x].pData = pSource;
+                pSpans[x].size = size;
+                total += size;
+                pSource = pPtrOffset(pSource, size, pRingBuffer->pBuffer,
+                                     pRingBuffer->size);
+            }
+        }
+    }
+
+    return total;
+}
 
-        pSource = pPtrOffset(pRingBuffer->pDataRead[handle], offset,
-                             pRingBuffer->pBuffer, pRingBuffer->size);
-        available = ptrDiff(pSource, pRingBuffer->pDataWrite, pRingBuffer->size);
+// Get the data at an offset from the read index of a lock-free ring
+// buffer as up to U_RING_BUFFER_NUM_SPANS contiguous spans, returning
+// the total length of the spans; consumer only.
+static size_t spscSpans(uRingBufferSpsc_t *pRingBuffer, uRingBufferSpan_t *pSpans,
+                        size_t length, size_t offset)
+{
+    size_t total = 0;
+    size_t readIndex = pRingBuffer->read;
+    // Acquire: the data the producer has written up to its write index
+    // must be visible before we look at it
+    size_t available = U_ATOMIC_GET_ACQUIRE(&(pRingBuffer->write)) - readIndex;
+    size_t start;
+    size_t size;
+
+    memset(pSpans, 0, sizeof(*pSpans) * U_RING_BUFFER_NUM_SPANS);
+    if (offset < available) {
+        available -= offset;
         if (length > available) {
             length = available;
         }
-
-        while (bytesRead < length) {
-            if (pData != NULL) {
-                *pData = *pSource;
-                pData++;
-            }
-            pSource = pPtrInc(pSource, pRingBuffer->pBuffer, pRingBuffer->size);
-            bytesRead++;
+        start = (readIndex + offset) & pRingBuffer->mask;
+        size = pRingBuffer->mask + 1 - start;
+        if (size > length) {
+            size = length;
         }
-        if (destructive) {
-            pRingBuffer->pDataRead[handle] = pSource;
+        pSpans[0].pData = pRingBuffer->pBuffer + start;
+        pSpans[0].size = size;
+        if (size < length) {
+            pSpans[1].pData = pRingBuffer->pBuffer;
+            pSpans[1].size = length - size;
         }
+        total = length;
+    }
+
+    return total;
+}
+
+// The ring buffer's mutex should be locked before this is called
+static size_t read(uRingBuffer_t *pRingBuffer, int32_t handle, char *pData,
+                   size_t length, size_t offset, bool destructive)
+{
+    size_t bytesRead;
+    uRingBufferSpan_t span[U_RING_BUFFER_NUM_SPANS];
+
+    bytesRead = spans(pRingBuffer, handle, span, length, offset);
+    if (pData != NULL) {
+        // Copy out a span at a time rather than a byte at a time
+        for (size_t x = 0; (x < U_RING_BUFFER_NUM_SPANS) && (span[x].size > 0); x++) {
+            memcpy(pData, span[x].pData, span[x].size);
+            pData += span[x].size;
+        }
+    }
+    if (destructive && (bytesRead > 0)) {
+        pRingBuffer->pDataRead[handle] = pPtrOffset(pRingBuffer->pDataRead[handle],
+                                                    offset + bytesRead,
+                                                    pRingBuffer->pBuffer,
+                                                    pRingBuffer->size);
     }
 
     return bytesRead;
@@ -827,18 +896,22 @@ size_t uRingBufferParseHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
                                              pRingBuffer->size);
             size_t bytesAvailable = ptrDiff(pOffset, pRingBuffer->pDataWrite, pRingBuffer->size);
             size_t bytesDiscard  = 0;
+            size_t bytesSkip;
             errorCodeOrLength = U_ERROR_COMMON_TIMEOUT;
             while (bytesAvailable) {
                 U_RING_BUFFER_PARSER_f *pParser = pParserList;
                 // find the right protocol
                 errorCodeOrLength = U_ERROR_COMMON_NOT_FOUND;
+                // If every parser says so, we can skip more than one byte
+                bytesSkip = bytesAvailable;
                 while (*pParser) {
                     uRingBufferParseContext_t ctx = {
                         .pRingBuffer    = pRingBuffer,
                         .pSource        = pOffset,
                         .bytesAvailable = bytesAvailable,
                         .bytesParsed    = 0,
-                        .bytesDiscard   = bytesDiscard
+                        .bytesDiscard   = bytesDiscard,
+                        .bytesSkip      = 0
                     };
                     errorCodeOrLength = (*pParser)(&ctx, pUserParam);
                     pParser ++;
@@ -848,13 +921,19 @@ size_t uRingBufferParseHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
                     if (errorCodeOrLength != U_ERROR_COMMON_NOT_FOUND) {
                         break;
                     }
+                    if (ctx.bytesSkip == 0) {
+                        ctx.bytesSkip = 1;
+                    }
+                    if (ctx.bytesSkip < bytesSkip) {
+                        bytesSkip = ctx.bytesSkip;
+                    }
                 }
                 if (errorCodeOrLength != U_ERROR_COMMON_NOT_FOUND) {
                     break;
                 }
-                pOffset = pPtrInc(pOffset, pRingBuffer->pBuffer, pRingBuffer->size);
-                bytesDiscard ++;
-                bytesAvailable --;
+                pOffset = pPtrOffset(pOffset, bytesSkip, pRingBuffer->pBuffer, pRingBuffer->size);
+                bytesDiscard += bytesSkip;
+                bytesAvailable -= bytesSkip;
             }
             if (bytesDiscard > 0) {
                 errorCodeOrLength = bytesDiscard;
@@ -893,4 +972,317 @@ size_t uRingBufferBytesDiscardUnprotected(uParseHandle_t parseHandle)
     return pCtx->bytesDiscard;
 }
 
+size_t uRingBufferGetSpanUnprotected(uParseHandle_t parseHandle, const char **ppData)
+{
+    uRingBufferParseContext_t *pCtx = (uRingBufferParseContext_t *)parseHandle;
+    size_t size = (pCtx->pRingBuffer->pBuffer + pCtx->pRingBuffer->size) - pCtx->pSource;
+    if (size > pCtx->bytesAvailable) {
+        size = pCtx->bytesAvailable;
+    }
+    *ppData = pCtx->pSource;
+    return size;
+}
+
+size_t uRingBufferSkipUnprotected(uParseHandle_t parseHandle, size_t length)
+{
+    uRingBufferParseContext_t *pCtx = (uRingBufferParseContext_t *)parseHandle;
+    if (length > pCtx->bytesAvailable) {
+        length = pCtx->bytesAvailable;
+    }
+    pCtx->pSource = pPtrOffset(pCtx->pSource, length, pCtx->pRingBuffer->pBuffer,
+                               pCtx->pRingBuffer->size);
+    pCtx->bytesParsed += length;
+    pCtx->bytesAvailable -= length;
+    return length;
+}
+
+size_t uRingBufferFindByteUnprotected(uParseHandle_t parseHandle, char value)
+{
+    uRingBufferParseContext_t *pCtx = (uRingBufferParseContext_t *)parseHandle;
+    const char *pBufferEnd = pCtx->pRingBuffer->pBuffer + pCtx->pRingBuffer->size;
+    size_t offset = pCtx->bytesAvailable;
+    size_t size = pBufferEnd - pCtx->pSource;
+    const char *pFound;
+    if (size > pCtx->bytesAvailable) {
+        size = pCtx->bytesAvailable;
+    }
+    // Search up to the end of the linear buffer and then,
+    // if the data wraps, from the start of it
+    pFound = (const char *) memchr(pCtx->pSource, value, size);
+    if (pFound != NULL) {
+        offset = pFound - pCtx->pSource;
+    } else if (size < pCtx->bytesAvailable) {
+        pFound = (const char *) memchr(pCtx->pRingBuffer->pBuffer, value,
+                                       pCtx->bytesAvailable - size);
+        if (pFound != NULL) {
+            offset = size + (pFound - pCtx->pRingBuffer->pBuffer);
+        }
+    }
+    pCtx->bytesSkip = pCtx->bytesParsed + offset;
+    return offset;
+}
+
+int32_t uRingBufferScanHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
+                              uRingBufferScanPosition_t *pPosition,
+                              U_RING_BUFFER_SCANNER_f pScanner,
+                              void *pUserParam)
+{
+    int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    const char *pRead;
+    const char *pSource;
+    size_t moved;
+    size_t available;
+    size_t span;
+    size_t scanned;
+
+    if ((pRingBuffer->pBuffer != NULL) && (pPosition != NULL) && (pScanner != NULL)) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        if ((handle >= 0) && (handle < (int32_t) pRingBuffer->maxNumReadPointers) &&
+            (pRingBuffer->pDataRead[handle] != NULL)) {
+            errorCodeOrLength = 0;
+            pRead = pRingBuffer->pDataRead[handle];
+            available = ptrDiff(pRead, pRingBuffer->pDataWrite, pRingBuffer->size);
+            // Work out where we were relative to the current read pointer
+            if (pPosition->pRead == NULL) {
+                pPosition->offset = 0;
+            } else if (pPosition->pRead != pRead) {
+                if (pRead >= pPosition->pRead) {
+                    moved = pRead - pPosition->pRead;
+                } else {
+                    moved = pRingBuffer->size - (pPosition->pRead - pRead);
+                }
+                if (moved <= pPosition->offset) {
+                    pPosition->offset -= moved;
+                } else {
+                    pPosition->offset = 0;
+                }
+            }
+            if (pPosition->offset > available) {
+                pPosition->offset = 0;
+            }
+            pPosition->pRead = pRead;
+            // Hand the unscanned data to the scanner in contiguous spans
+            pSource = pPtrOffset(pRead, pPosition->offset, pRingBuffer->pBuffer,
+                                 pRingBuffer->size);
+            available -= pPosition->offset;
+            while (available > 0) {
+                span = (pRingBuffer->pBuffer + pRingBuffer->size) - pSource;
+                if (span > available) {
+                    span = available;
+                }
+                scanned = pScanner(pSource, span, pUserParam);
+                if (scanned > span) {
+                    scanned = span;
+                }
+                pPosition->offset += scanned;
+                errorCodeOrLength += (int32_t) scanned;
+                available -= scanned;
+                if (scanned < span) {
+                    break;
+                }
+                pSource = pPtrOffset(pSource, scanned, pRingBuffer->pBuffer,
+                                     pRingBuffer->size);
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return errorCodeOrLength;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: ZERO-COPY ACCESS
+ * -------------------------------------------------------------- */
+
+size_t uRingBufferPeekSpans(uRingBuffer_t *pRingBuffer,
+                            uRingBufferSpan_t *pSpans,
+                            size_t length, size_t offset)
+{
+    size_t total = 0;
+
+    if ((pRingBuffer->pBuffer != NULL) && (pSpans != NULL)) {
+        memset(pSpans, 0, sizeof(*pSpans) * U_RING_BUFFER_NUM_SPANS);
+        if (!pRingBuffer->readHandleRequired) {
+
+            U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+            total = spans(pRingBuffer, 0, pSpans, length, offset);
+
+            U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+        }
+    }
+
+    return total;
+}
+
+size_t uRingBufferConsume(uRingBuffer_t *pRingBuffer, size_t length)
+{
+    return uRingBufferRead(pRingBuffer, NULL, length);
+}
+
+size_t uRingBufferPeekSpansHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                  uRingBufferSpan_t *pSpans,
+                                  size_t length, size_t offset)
+{
+    size_t total = 0;
+
+    if ((pRingBuffer->pBuffer != NULL) && (pSpans != NULL)) {
+
+        U_PORT_MUTEX_LOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+
+        total = spans(pRingBuffer, handle, pSpans, length, offset);
+
+        U_PORT_MUTEX_UNLOCK((uPortMutexHandle_t) pRingBuffer->mutex);
+    }
+
+    return total;
+}
+
+size_t uRingBufferConsumeHandle(uRingBuffer_t *pRingBuffer, int32_t handle,
+                                size_t length)
+{
+    return uRingBufferReadHandle(pRingBuffer, handle, NULL, length);
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS: SINGLE PRODUCER, SINGLE CONSUMER
+ * -------------------------------------------------------------- */
+
+int32_t uRingBufferSpscCreate(uRingBufferSpsc_t *pRingBuffer,
+                              char *pLinearBuffer, size_t size)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pRingBuffer != NULL) && (pLinearBuffer != NULL) &&
+        (size > 0) && ((size & (size - 1)) == 0)) {
+        memset(pRingBuffer, 0, sizeof(*pRingBuffer));
+        pRingBuffer->pBuffer = pLinearBuffer;
+        pRingBuffer->mask = size - 1;
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    }
+
+    return errorCode;
+}
+
+void uRingBufferSpscDelete(uRingBufferSpsc_t *pRingBuffer)
+{
+    memset(pRingBuffer, 0, sizeof(*pRingBuffer));
+}
+
+bool uRingBufferSpscAdd(uRingBufferSpsc_t *pRingBuffer, const char *pData,
+                        size_t length)
+{
+    bool dataFitsInBuffer = false;
+    size_t writeIndex = pRingBuffer->write;
+    size_t start;
+    size_t size;
+
+    if (pRingBuffer->pBuffer != NULL) {
+        // Acquire: the consumer must have finished with the space
+        // up to its read index before we write over it
+        if (length <= pRingBuffer->mask + 1 -
+            (writeIndex - U_ATOMIC_GET_ACQUIRE(&(pRingBuffer->read)))) {
+            start = writeIndex & pRingBuffer->mask;
+            size = pRingBuffer->mask + 1 - start;
+            if (size > length) {
+                size = length;
+            }
+            memcpy(pRingBuffer->pBuffer + start, pData, size);
+            memcpy(pRingBuffer->pBuffer, pData + size, length - size);
+            // Release: the data must be in place before the
+            // consumer can see the new write index
+            U_ATOMIC_SET_RELEASE(&(pRingBuffer->write), writeIndex + length);
+            dataFitsInBuffer = true;
+        } else {
+            pRingBuffer->statAddLossBytes += length;
+        }
+    }
+
+    return dataFitsInBuffer;
+}
+
+size_t uRingBufferSpscRead(uRingBufferSpsc_t *pRingBuffer, char *pData,
+                           size_t length)
+{
+    size_t bytesRead;
+
+    bytesRead = uRingBufferSpscPeek(pRingBuffer, pData, length, 0);
+    if (bytesRead > 0) {
+        // Release: we must be done with the data before the
+        // producer can see that it may write over it
+        U_ATOMIC_SET_RELEASE(&(pRingBuffer->read), pRingBuffer->read + bytesRead);
+    }
+
+    return bytesRead;
+}
+
+size_t uRingBufferSpscPeek(uRingBufferSpsc_t *pRingBuffer, char *pData,
+                           size_t length, size_t offset)
+{
+    size_t bytesRead = 0;
+    uRingBufferSpan_t span[U_RING_BUFFER_NUM_SPANS];
+
+    if (pRingBuffer->pBuffer != NULL) {
+        bytesRead = spscSpans(pRingBuffer, span, length, offset);
+        if (pData != NULL) {
+            for (size_t x = 0; (x < U_RING_BUFFER_NUM_SPANS) && (span[x].size > 0); x++) {
+                memcpy(pData, span[x].pData, span[x].size);
+                pData += span[x].size;
+            }
+        }
+    }
+
+    return bytesRead;
+}
+
+size_t uRingBufferSpscPeekSpans(uRingBufferSpsc_t *pRingBuffer,
+                                uRingBufferSpan_t *pSpans,
+                                size_t length, size_t offset)
+{
+    size_t total = 0;
+
+    if ((pRingBuffer->pBuffer != NULL) && (pSpans != NULL)) {
+        total = spscSpans(pRingBuffer, pSpans, length, offset);
+    }
+
+    return total;
+}
+
+size_t uRingBufferSpscConsume(uRingBufferSpsc_t *pRingBuffer, size_t length)
+{
+    return uRingBufferSpscRead(pRingBuffer, NULL, length);
+}
+
+size_t uRingBufferSpscDataSize(const uRingBufferSpsc_t *pRingBuffer)
+{
+    size_t readIndex = U_ATOMIC_GET_ACQUIRE(&(pRingBuffer->read));
+
+    return U_ATOMIC_GET_ACQUIRE(&(pRingBuffer->write)) - readIndex;
+}
+
+size_t uRingBufferSpscAvailableSize(const uRingBufferSpsc_t *pRingBuffer)
+{
+    size_t size = 0;
+
+    if (pRingBuffer->pBuffer != NULL) {
+        size = pRingBuffer->mask + 1 - uRingBufferSpscDataSize(pRingBuffer);
+    }
+
+    return size;
+}
+
+void uRingBufferSpscFlush(uRingBufferSpsc_t *pRingBuffer)
+{
+    U_ATOMIC_SET_RELEASE(&(pRingBuffer->read),
+                         U_ATOMIC_GET_ACQUIRE(&(pRingBuffer->write)));
+}
+
+size_t uRingBufferSpscStatAddLoss(uRingBufferSpsc_t *pRingBuffer)
+{
+    return pRingBuffer->statAddLossBytes;
+}
+
 // End of file
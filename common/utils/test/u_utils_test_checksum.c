@@ -0,0 +1,295 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Tests for the checksum API.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset(), strlen()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_os.h"
+#include "u_port_heap.h"
+
+#include "u_test_util_resource_check.h"
+
+#include "u_checksum.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_CHECKSUM_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+#ifndef U_TEST_UTILS_CHECKSUM_MAX_LENGTH
+/** The longest block of data to compare against the
+ * reference checksums.
+ */
+# define U_TEST_UTILS_CHECKSUM_MAX_LENGTH 300
+#endif
+
+#ifndef U_TEST_UTILS_CHECKSUM_BENCHMARK_SIZE
+/** The size of block to checksum in the benchmark, roughly that
+ * of a large UBX-RXM-RAWX message.
+ */
+# define U_TEST_UTILS_CHECKSUM_BENCHMARK_SIZE 4096
+#endif
+
+#ifndef U_TEST_UTILS_CHECKSUM_BENCHMARK_ITERATIONS
+/** The number of times to checksum the block in the benchmark.
+ */
+# define U_TEST_UTILS_CHECKSUM_BENCHMARK_ITERATIONS 4096
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Test data, filled with a pseudo-random sequence, with room
+ * for an offset of up to 32 bytes to test alignment.
+ */
+static char gData[U_TEST_UTILS_CHECKSUM_MAX_LENGTH + 32];
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Reference 8-bit Fletcher checksum, byte by byte the way it
+// has always been done in the UBX code.
+static uint16_t fletcher8Reference(uint16_t checksum, const char *pData,
+                                   size_t size)
+{
+    uint8_t ckA = (uint8_t) checksum;
+    uint8_t ckB = (uint8_t) (checksum >> 8);
+
+    for (size_t x = 0; x < size; x++) {
+        ckA += (uint8_t) *pData;
+        ckB += ckA;
+        pData++;
+    }
+
+    return (uint16_t) (((uint16_t) ckB << 8) | ckA);
+}
+
+// Reference 8-bit XOR checksum.
+static uint8_t xor8Reference(uint8_t checksum, const char *pData,
+                             size_t size)
+{
+    for (size_t x = 0; x < size; x++) {
+        checksum ^= (uint8_t) *pData;
+        pData++;
+    }
+
+    return checksum;
+}
+
+// Fill a buffer with a pseudo-random sequence, biased toward
+// 0xFF so as to exercise the largest intermediate values.
+static void fill(char *pBuffer, size_t size)
+{
+    uint32_t seed = 0x12345678;
+
+    for (size_t x = 0; x < size; x++) {
+        seed = (seed * 1103515245) + 12345;
+        pBuffer[x] = (char) ((seed & 0x80000000) ? 0xFF : (seed >> 16));
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Check the checksums against known values and against a reference
+ * implementation for many lengths, alignments and split points.
+ */
+U_PORT_TEST_FUNCTION("[checksum]", "checksumBasic")
+{
+    int32_t resourceCount;
+    // The variable part of a UBX-MON-VER poll, which has
+    // a checksum of 0x0E, 0x34
+    const char ubx[] = {0x0a, 0x04, 0x00, 0x00};
+    // The part of an NMEA sentence covered by the checksum,
+    // which should be 0x1D
+    const char *pNmea = "GPGLL,4916.45,N,12311.12,W,225444,A,";
+    const char *pData;
+    uint16_t fletcher;
+    uint8_t xor8;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_TEST_PRINT_LINE("using the \"%s\" implementation.", uChecksumImplementation());
+
+    // Known values and the degenerate cases
+    U_PORT_TEST_ASSERT(uChecksumFletcher8(0, ubx, sizeof(ubx)) == 0x340e);
+    U_PORT_TEST_ASSERT(uChecksumXor8(0, pNmea, strlen(pNmea)) == 0x1d);
+    U_PORT_TEST_ASSERT(uChecksumFletcher8(0x1234, NULL, 10) == 0x1234);
+    U_PORT_TEST_ASSERT(uChecksumFletcher8(0x1234, ubx, 0) == 0x1234);
+    U_PORT_TEST_ASSERT(uChecksumXor8(0x12, NULL, 10) == 0x12);
+    U_PORT_TEST_ASSERT(uChecksumXor8(0x12, pNmea, 0) == 0x12);
+
+    // Every length at every alignment, from a non-zero start
+    fill(gData, sizeof(gData));
+    for (size_t offset = 0; offset < 32; offset++) {
+        pData = gData + offset;
+        for (size_t length = 0; length <= U_TEST_UTILS_CHECKSUM_MAX_LENGTH; length++) {
+            fletcher = fletcher8Reference(0xa55a, pData, length);
+            if (uChecksumFletcher8(0xa55a, pData, length) != fletcher) {
+                U_TEST_PRINT_LINE("Fletcher-8 mismatch, offset %d, length %d.",
+                                  (int) offset, (int) length);
+                U_PORT_TEST_ASSERT(false);
+            }
+            xor8 = xor8Reference(0x5a, pData, length);
+            if (uChecksumXor8(0x5a, pData, length) != xor8) {
+                U_TEST_PRINT_LINE("XOR-8 mismatch, offset %d, length %d.",
+                                  (int) offset, (int) length);
+                U_PORT_TEST_ASSERT(false);
+            }
+        }
+    }
+
+    // Split into two pieces at every point, as happens when
+    // a message wraps in a ring buffer
+    for (size_t split = 0; split <= U_TEST_UTILS_CHECKSUM_MAX_LENGTH; split++) {
+        fletcher = uChecksumFletcher8(0, gData, split);
+        fletcher = uChecksumFletcher8(fletcher, gData + split,
+                                      U_TEST_UTILS_CHECKSUM_MAX_LENGTH - split);
+        U_PORT_TEST_ASSERT(fletcher == fletcher8Reference(0, gData,
+                                                          U_TEST_UTILS_CHECKSUM_MAX_LENGTH));
+        xor8 = uChecksumXor8(0, gData, split);
+        xor8 = uChecksumXor8(xor8, gData + split, U_TEST_UTILS_CHECKSUM_MAX_LENGTH - split);
+        U_PORT_TEST_ASSERT(xor8 == xor8Reference(0, gData, U_TEST_UTILS_CHECKSUM_MAX_LENGTH));
+    }
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Compare the throughput of the checksum functions with that of
+ * the byte-by-byte reference implementations; the results are
+ * printed, only correctness is asserted.
+ */
+U_PORT_TEST_FUNCTION("[checksum]", "checksumBenchmark")
+{
+    int32_t resourceCount;
+    char *pBuffer;
+    uint16_t fletcherReference = 0;
+    uint16_t fletcher = 0;
+    uint8_t xorReference = 0;
+    uint8_t xor8 = 0;
+    int32_t timesMs[4];
+    int32_t startTimeMs;
+    int32_t megabytes;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    pBuffer = (char *) pUPortMalloc(U_TEST_UTILS_CHECKSUM_BENCHMARK_SIZE);
+    U_PORT_TEST_ASSERT(pBuffer != NULL);
+    fill(pBuffer, U_TEST_UTILS_CHECKSUM_BENCHMARK_SIZE);
+
+    // Each pass carries the checksum on from the last so that
+    // none of the work can be optimised away
+    startTimeMs = uPortGetTickTimeMs();
+    for (size_t x = 0; x < U_TEST_UTILS_CHECKSUM_BENCHMARK_ITERATIONS; x++) {
+        fletcherReference = fletcher8Reference(fletcherReference, pBuffer,
+                                               U_TEST_UTILS_CHECKSUM_BENCHMARK_SIZE);
+    }
+    timesMs[0] = uPortGetTickTimeMs() - startTimeMs;
+    startTimeMs = uPortGetTickTimeMs();
+    for (size_t x = 0; x < U_TEST_UTILS_CHECKSUM_BENCHMARK_ITERATIONS; x++) {
+        fletcher = uChecksumFletcher8(fletcher, pBuffer,
+                                      U_TEST_UTILS_CHECKSUM_BENCHMARK_SIZE);
+    }
+    timesMs[1] = uPortGetTickTimeMs() - startTimeMs;
+    startTimeMs = uPortGetTickTimeMs();
+    for (size_t x = 0; x < U_TEST_UTILS_CHECKSUM_BENCHMARK_ITERATIONS; x++) {
+        xorReference = xor8Reference(xorReference, pBuffer,
+                                     U_TEST_UTILS_CHECKSUM_BENCHMARK_SIZE);
+    }
+    timesMs[2] = uPortGetTickTimeMs() - startTimeMs;
+    startTimeMs = uPortGetTickTimeMs();
+    for (size_t x = 0; x < U_TEST_UTILS_CHECKSUM_BENCHMARK_ITERATIONS; x++) {
+        xor8 = uChecksumXor8(xor8, pBuffer, U_TEST_UTILS_CHECKSUM_BENCHMARK_SIZE);
+    }
+    timesMs[3] = uPortGetTickTimeMs() - startTimeMs;
+
+    uPortFree(pBuffer);
+
+    megabytes = (int32_t) (((int64_t) U_TEST_UTILS_CHECKSUM_BENCHMARK_SIZE *
+                            U_TEST_UTILS_CHECKSUM_BENCHMARK_ITERATIONS) / (1024 * 1024));
+    U_TEST_PRINT_LINE("%d Mbyte(s) in %d byte blocks, \"%s\" implementation:",
+                      megabytes, U_TEST_UTILS_CHECKSUM_BENCHMARK_SIZE,
+                      uChecksumImplementation());
+    U_TEST_PRINT_LINE("  Fletcher-8 byte-by-byte %d ms, uChecksumFletcher8() %d ms.",
+                      timesMs[0], timesMs[1]);
+    U_TEST_PRINT_LINE("  XOR-8 byte-by-byte %d ms, uChecksumXor8() %d ms.",
+                      timesMs[2], timesMs[3]);
+    U_PORT_TEST_ASSERT(fletcher == fletcherReference);
+    U_PORT_TEST_ASSERT(xor8 == xorReference);
+
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+// End of file
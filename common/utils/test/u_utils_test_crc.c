@@ -0,0 +1,206 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Only #includes of u_* and the C standard library are allowed here,
+ * no platform stuff and no OS stuff.  Anything required from
+ * the platform/OS must be brought in through u_port* to maintain
+ * portability.
+ */
+
+/** @file
+ * @brief Tests for the CRC API.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // strlen()
+
+#include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_debug.h"
+#include "u_port_os.h"
+
+#include "u_test_util_resource_check.h"
+
+#include "u_crc.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_CRC_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+#ifndef U_TEST_UTILS_CRC_MAX_LENGTH
+/** The longest block of data to compare against the reference
+ * CRCs: long enough to exercise all of the paths.
+ */
+# define U_TEST_UTILS_CRC_MAX_LENGTH 300
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** Test data, filled with a pseudo-random sequence, with room
+ * for an offset of up to 16 bytes to test alignment.
+ */
+static char gData[U_TEST_UTILS_CRC_MAX_LENGTH + 16];
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Reference MSB-first CRC, a bit at a time, with the CRC
+// and polynomial in the least significant width bits.
+static uint32_t crcReference(uint32_t polynomial, size_t width, uint32_t crc,
+                             const char *pData, size_t size)
+{
+    uint32_t topBit = 1UL << (width - 1);
+    uint32_t mask = (topBit << 1) - 1;
+
+    for (size_t x = 0; x < size; x++) {
+        crc ^= ((uint32_t) (uint8_t) pData[x]) << (width - 8);
+        for (size_t y = 0; y < 8; y++) {
+            if (crc & topBit) {
+                crc = (crc << 1) ^ polynomial;
+            } else {
+                crc <<= 1;
+            }
+        }
+        crc &= mask;
+    }
+
+    return crc;
+}
+
+// Compute a CRC with uCrcXxx() for the given width.
+static uint32_t crcUnderTest(size_t width, uint32_t crc,
+                             const char *pData, size_t size)
+{
+    switch (width) {
+        case 8:
+            crc = uCrc8((uint8_t) crc, pData, size);
+            break;
+        case 16:
+            crc = uCrc16((uint16_t) crc, pData, size);
+            break;
+        case 24:
+            crc = uCrc24q(crc, pData, size);
+            break;
+        default:
+            crc = uCrc32(crc, pData, size);
+            break;
+    }
+
+    return crc;
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Check the CRCs against known values and against a bit-wise
+ * reference implementation for many lengths, alignments and
+ * split points.
+ */
+U_PORT_TEST_FUNCTION("[crc]", "crcBasic")
+{
+    int32_t resourceCount;
+    const uint32_t polynomials[] = {0x07, 0x1021, 0x864CFB, 0x04C11DB7};
+    const size_t widths[] = {8, 16, 24, 32};
+    const uint32_t starts[] = {0x5a, 0xa55a, 0x5aa55a, 0xa55aa55a};
+    const char *pCheck = "123456789";
+    const char *pData;
+    uint32_t seed = 0x12345678;
+    uint32_t expected;
+    uint32_t crc;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_TEST_PRINT_LINE("using the \"%s\" implementation.", uCrcImplementation());
+
+    // The standard check values
+    U_PORT_TEST_ASSERT(uCrc8(0, pCheck, strlen(pCheck)) == 0xf4);
+    U_PORT_TEST_ASSERT(uCrc16(0, pCheck, strlen(pCheck)) == 0x31c3);
+    U_PORT_TEST_ASSERT(uCrc24q(0, pCheck, strlen(pCheck)) == 0xcde703);
+    U_PORT_TEST_ASSERT(~uCrc32(0xffffffff, pCheck, strlen(pCheck)) == 0xfc891918);
+    U_PORT_TEST_ASSERT(uCrc24q(0x123456, NULL, 10) == 0x123456);
+    U_PORT_TEST_ASSERT(uCrc24q(0x123456, pCheck, 0) == 0x123456);
+
+    for (size_t x = 0; x < sizeof(gData); x++) {
+        seed = (seed * 1103515245) + 12345;
+        gData[x] = (char) (seed >> 16);
+    }
+
+    for (size_t p = 0; p < sizeof(widths) / sizeof(widths[0]); p++) {
+        // Every length at every alignment, from a non-zero start
+        for (size_t offset = 0; offset < 16; offset++) {
+            pData = gData + offset;
+            for (size_t length = 0; length <= U_TEST_UTILS_CRC_MAX_LENGTH; length++) {
+                expected = crcReference(polynomials[p], widths[p], starts[p], pData, length);
+                crc = crcUnderTest(widths[p], starts[p], pData, length);
+                if (crc != expected) {
+                    U_TEST_PRINT_LINE("CRC-%d mismatch, offset %d, length %d:"
+                                      " 0x%08x, expected 0x%08x.", (int) widths[p],
+                                      (int) offset, (int) length, crc, expected);
+                    U_PORT_TEST_ASSERT(false);
+                }
+            }
+        }
+        // Split into two pieces at every point
+        expected = crcReference(polynomials[p], widths[p], 0, gData,
+                                U_TEST_UTILS_CRC_MAX_LENGTH);
+        for (size_t split = 0; split <= U_TEST_UTILS_CRC_MAX_LENGTH; split++) {
+            crc = crcUnderTest(widths[p], 0, gData, split);
+            crc = crcUnderTest(widths[p], crc, gData + split,
+                               U_TEST_UTILS_CRC_MAX_LENGTH - split);
+            U_PORT_TEST_ASSERT(crc == expected);
+        }
+    }
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+// End of file
@@ -66,6 +66,10 @@
 #define TEST_BLOCK_COUNT 8
 #define TEST_BLOCK_SIZE  64
 
+/** The number of blocks in each class of the size-class pool.
+ */
+#define TEST_CLASS_BLOCK_COUNT (U_MEMPOOL_CLASS_BLOCK_COUNT * U_MEMPOOL_CLASS_NUM_SHARDS)
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -223,4 +227,93 @@ U_PORT_TEST_FUNCTION("[mempool]", "mempoolFreeAllMem")
     U_PORT_TEST_ASSERT(resourceCount <= 0);
 }
 
+U_PORT_TEST_FUNCTION("[mempool]", "mempoolClass")
+{
+    uMemPoolClassStats_t stats;
+    uMemPoolClassStats_t statsBefore;
+    uint8_t *pBuf[TEST_CLASS_BLOCK_COUNT + 1];
+    uint8_t *pBuf1;
+    uint8_t *pBuf2;
+    uint8_t notPoolMem;
+    int32_t sizeClass = U_MEMPOOL_CLASS_NUM - 1;
+    size_t blockSize = ((size_t) U_MEMPOOL_CLASS_MIN_BLOCK_SIZE) << sizeClass;
+    int32_t count = 0;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_PORT_TEST_ASSERT(uMemPoolClassStatsGet(-1, &stats) < 0);
+    U_PORT_TEST_ASSERT(uMemPoolClassStatsGet(U_MEMPOOL_CLASS_NUM, &stats) < 0);
+    U_PORT_TEST_ASSERT(uMemPoolClassStatsGet(0, NULL) < 0);
+    U_PORT_TEST_ASSERT(uMemPoolClassAllocMem(0) == NULL);
+    U_PORT_TEST_ASSERT(uMemPoolClassAllocMem(blockSize + 1) == NULL);
+    U_PORT_TEST_ASSERT(!uMemPoolClassFreeMem(NULL));
+    U_PORT_TEST_ASSERT(!uMemPoolClassFreeMem(&notPoolMem));
+
+    // Allocations should come from the smallest class that fits
+    U_PORT_TEST_ASSERT(uMemPoolClassStatsGet(0, &statsBefore) == 0);
+    pBuf1 = (uint8_t *) uMemPoolClassAllocMem(1);
+    U_PORT_TEST_ASSERT(pBuf1 != NULL);
+    U_PORT_TEST_ASSERT(uMemPoolClassStatsGet(0, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.blockSize == U_MEMPOOL_CLASS_MIN_BLOCK_SIZE);
+    U_PORT_TEST_ASSERT(stats.numBlocks == TEST_CLASS_BLOCK_COUNT);
+    U_PORT_TEST_ASSERT(stats.numUsed >= 1);
+    U_PORT_TEST_ASSERT(stats.highWaterMark >= stats.numUsed);
+    pBuf2 = (uint8_t *) uMemPoolClassAllocMem(U_MEMPOOL_CLASS_MIN_BLOCK_SIZE + 1);
+    U_PORT_TEST_ASSERT(pBuf2 != NULL);
+    U_PORT_TEST_ASSERT(uMemPoolClassStatsGet(1, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.blockSize == U_MEMPOOL_CLASS_MIN_BLOCK_SIZE * 2);
+    U_PORT_TEST_ASSERT(stats.numUsed >= 1);
+
+    // Check that no bytes "leak" over to the other buffer
+    memset(pBuf1, 0xFF, U_MEMPOOL_CLASS_MIN_BLOCK_SIZE);
+    memset(pBuf2, 0xEE, U_MEMPOOL_CLASS_MIN_BLOCK_SIZE * 2);
+    U_PORT_TEST_ASSERT(isAllBytes(pBuf1, U_MEMPOOL_CLASS_MIN_BLOCK_SIZE, 0xFF));
+    U_PORT_TEST_ASSERT(isAllBytes(pBuf2, U_MEMPOOL_CLASS_MIN_BLOCK_SIZE * 2, 0xEE));
+    U_PORT_TEST_ASSERT(uMemPoolClassFreeMem(pBuf1));
+    U_PORT_TEST_ASSERT(uMemPoolClassFreeMem(pBuf2));
+
+    // Use up all of the largest class: anything else running may
+    // have some of its blocks, hence the loop rather than a count
+    U_PORT_TEST_ASSERT(uMemPoolClassStatsGet(sizeClass, &statsBefore) == 0);
+    pBuf1 = (uint8_t *) uMemPoolClassAllocMem(blockSize);
+    while ((pBuf1 != NULL) && (count <= TEST_CLASS_BLOCK_COUNT)) {
+        memset(pBuf1, count, blockSize);
+        pBuf[count] = pBuf1;
+        count++;
+        pBuf1 = (uint8_t *) uMemPoolClassAllocMem(blockSize);
+    }
+    U_PORT_TEST_ASSERT(pBuf1 == NULL);
+    U_TEST_PRINT_LINE("allocated %d block(s) of %d byte(s).", count, (int) blockSize);
+    U_PORT_TEST_ASSERT(count > 0);
+    U_PORT_TEST_ASSERT(count <= TEST_CLASS_BLOCK_COUNT);
+    U_PORT_TEST_ASSERT(uMemPoolClassStatsGet(sizeClass, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.numFailed == statsBefore.numFailed + 1);
+    U_PORT_TEST_ASSERT(stats.highWaterMark >= count);
+    for (int32_t x = 0; x < count; x++) {
+        U_PORT_TEST_ASSERT(isAllBytes(pBuf[x], blockSize, (uint8_t) x));
+    }
+
+    // Free one and make sure that we can allocate it again
+    U_PORT_TEST_ASSERT(uMemPoolClassFreeMem(pBuf[0]));
+    pBuf[0] = (uint8_t *) uMemPoolClassAllocMem(blockSize);
+    U_PORT_TEST_ASSERT(pBuf[0] != NULL);
+
+    for (int32_t x = 0; x < count; x++) {
+        U_PORT_TEST_ASSERT(uMemPoolClassFreeMem(pBuf[x]));
+    }
+    U_PORT_TEST_ASSERT(uMemPoolClassStatsGet(sizeClass, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.numUsed == statsBefore.numUsed);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
 // End of file
\ No newline at end of file
@@ -34,6 +34,7 @@
 #include "string.h"    // strncpy(), strcmp(), memcpy(), memset()
 
 #include "u_cfg_sw.h"
+#include "u_cfg_os_platform_specific.h"
 #include "u_cfg_app_platform_specific.h"
 #include "u_cfg_test_platform_specific.h"
 
@@ -42,6 +43,7 @@
 #include "u_port.h"
 #include "u_port_debug.h"
 #include "u_port_os.h"
+#include "u_port_heap.h"
 
 #include "u_test_util_resource_check.h"
 
@@ -76,10 +78,73 @@
 # define U_TEST_UTILS_RINGBUFFER_FILL_CHAR 0x5a
 #endif
 
+#ifndef U_TEST_UTILS_RINGBUFFER_BENCHMARK_SIZE
+/** The size of ring buffer to use in the benchmark; must be a power
+ * of two.
+ */
+# define U_TEST_UTILS_RINGBUFFER_BENCHMARK_SIZE 1024
+#endif
+
+#ifndef U_TEST_UTILS_RINGBUFFER_BENCHMARK_NUM_RECORDS
+/** The number of records to pass through the ring buffer in each
+ * part of the benchmark.
+ */
+# define U_TEST_UTILS_RINGBUFFER_BENCHMARK_NUM_RECORDS 20000
+#endif
+
+#ifndef U_TEST_UTILS_RINGBUFFER_BENCHMARK_LATENCY_MAX_MS
+/** The largest latency, in milliseconds, that the benchmark
+ * histogram can record; anything longer goes in the last bucket.
+ */
+# define U_TEST_UTILS_RINGBUFFER_BENCHMARK_LATENCY_MAX_MS 100
+#endif
+
+#ifndef U_TEST_UTILS_RINGBUFFER_BENCHMARK_SPIN_COUNT
+/** The number of times the benchmark producer/consumer retry
+ * when the ring buffer is full/empty before yielding.
+ */
+# define U_TEST_UTILS_RINGBUFFER_BENCHMARK_SPIN_COUNT 10000
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Context for the scanner callback used by ringbufferScan.
+ */
+typedef struct {
+    char buffer[U_TEST_UTILS_RINGBUFFER_SIZE * 4];
+    size_t length;     /**< the number of bytes in buffer. */
+    size_t calls;      /**< the number of times the scanner was called. */
+    size_t stopAfter;  /**< stop when length reaches this. */
+} uTestUtilsRingBufferScan_t;
+
+/** Context for the parsers used by ringbufferParse.
+ */
+typedef struct {
+    char frame[U_TEST_UTILS_RINGBUFFER_SIZE * 2];
+    size_t frameLength;  /**< the number of bytes in frame. */
+    size_t calls;        /**< the number of times a parser was called. */
+} uTestUtilsRingBufferParse_t;
+
+/** A record passed through the ring buffer by the benchmark.
+ */
+typedef struct {
+    uint32_t sequence;
+    int32_t timeMs;   /**< the tick time at which the record was added. */
+    char fill[8];
+} uTestUtilsRingBufferRecord_t;
+
+/** Context for the benchmark, shared between the producer task and
+ * the consumer.
+ */
+typedef struct {
+    uRingBuffer_t *pRingBuffer;         /**< set for the locked case. */
+    uRingBufferSpsc_t *pRingBufferSpsc; /**< set for the lock-free case. */
+    volatile bool producerDone;
+    size_t histogram[U_TEST_UTILS_RINGBUFFER_BENCHMARK_LATENCY_MAX_MS + 1];
+} uTestUtilsRingBufferBenchmark_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -108,6 +173,214 @@ static void printBuffer(const char *pTitle, const char *pStr, size_t length)
     uPortTaskBlock(10);
 }
 
+// Scanner callback for uRingBufferScanHandle(): copies what it is
+// given into the context buffer, stopping at stopAfter bytes.
+static size_t scanner(const char *pData, size_t size, void *pUserParam)
+{
+    uTestUtilsRingBufferScan_t *pScan = (uTestUtilsRingBufferScan_t *) pUserParam;
+    size_t x = 0;
+
+    pScan->calls++;
+    while ((x < size) && (pScan->length < pScan->stopAfter) &&
+           (pScan->length < sizeof(pScan->buffer))) {
+        pScan->buffer[pScan->length] = *pData;
+        pScan->length++;
+        pData++;
+        x++;
+    }
+
+    return x;
+}
+
+// Parser for uRingBufferParseHandle() which finds frames of the form
+// "<...>", looking at the data a span at a time.
+static int32_t frameParser(uParseHandle_t parseHandle, void *pUserParam)
+{
+    uTestUtilsRingBufferParse_t *pParse = (uTestUtilsRingBufferParse_t *) pUserParam;
+    const char *pData;
+    const char *pFound = NULL;
+    size_t size;
+
+    pParse->calls++;
+    if (uRingBufferFindByteUnprotected(parseHandle, '<') > 0) {
+        return (int32_t) U_ERROR_COMMON_NOT_FOUND;
+    }
+    pParse->frameLength = 0;
+    while ((pFound == NULL) &&
+           ((size = uRingBufferGetSpanUnprotected(parseHandle, &pData)) > 0)) {
+        pFound = (const char *) memchr(pData, '>', size);
+        if (pFound != NULL) {
+            size = pFound - pData + 1;
+        }
+        if (pParse->frameLength + size <= sizeof(pParse->frame)) {
+            memcpy(pParse->frame + pParse->frameLength, pData, size);
+        }
+        pParse->frameLength += size;
+        uRingBufferSkipUnprotected(parseHandle, size);
+    }
+
+    return (pFound != NULL) ? (int32_t) U_ERROR_COMMON_SUCCESS : (int32_t) U_ERROR_COMMON_TIMEOUT;
+}
+
+// Parser for uRingBufferParseHandle() which never finds anything
+// and doesn't say how far may be skipped.
+static int32_t nothingParser(uParseHandle_t parseHandle, void *pUserParam)
+{
+    uTestUtilsRingBufferParse_t *pParse = (uTestUtilsRingBufferParse_t *) pUserParam;
+    char c;
+
+    pParse->calls++;
+    uRingBufferGetByteUnprotected(parseHandle, &c);
+
+    return (int32_t) U_ERROR_COMMON_NOT_FOUND;
+}
+
+// Add a record to the ring buffer under test in the benchmark.
+static bool benchmarkAdd(uTestUtilsRingBufferBenchmark_t *pBenchmark,
+                         const uTestUtilsRingBufferRecord_t *pRecord)
+{
+    if (pBenchmark->pRingBufferSpsc != NULL) {
+        return uRingBufferSpscAdd(pBenchmark->pRingBufferSpsc, (const char *) pRecord,
+                                  sizeof(*pRecord));
+    }
+    return uRingBufferAdd(pBenchmark->pRingBuffer, (const char *) pRecord,
+                          sizeof(*pRecord));
+}
+
+// Read a record from the ring buffer under test in the benchmark.
+static bool benchmarkRead(uTestUtilsRingBufferBenchmark_t *pBenchmark,
+                          uTestUtilsRingBufferRecord_t *pRecord)
+{
+    if (pBenchmark->pRingBufferSpsc != NULL) {
+        return (uRingBufferSpscDataSize(pBenchmark->pRingBufferSpsc) >= sizeof(*pRecord)) &&
+               (uRingBufferSpscRead(pBenchmark->pRingBufferSpsc, (char *) pRecord,
+                                    sizeof(*pRecord)) == sizeof(*pRecord));
+    }
+    return (uRingBufferDataSize(pBenchmark->pRingBuffer) >= sizeof(*pRecord)) &&
+           (uRingBufferRead(pBenchmark->pRingBuffer, (char *) pRecord,
+                            sizeof(*pRecord)) == sizeof(*pRecord));
+}
+
+// Producer task for the benchmark: adds records as fast as the
+// consumer will take them.
+static void benchmarkProducerTask(void *pParam)
+{
+    uTestUtilsRingBufferBenchmark_t *pBenchmark = (uTestUtilsRingBufferBenchmark_t *) pParam;
+    uTestUtilsRingBufferRecord_t record = {0};
+    size_t spins;
+
+    for (size_t x = 0; x < U_TEST_UTILS_RINGBUFFER_BENCHMARK_NUM_RECORDS; x++) {
+        record.sequence = (uint32_t) x;
+        record.timeMs = uPortGetTickTimeMs();
+        spins = 0;
+        while (!benchmarkAdd(pBenchmark, &record)) {
+            spins++;
+            if (spins >= U_TEST_UTILS_RINGBUFFER_BENCHMARK_SPIN_COUNT) {
+                uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                spins = 0;
+            }
+        }
+    }
+    pBenchmark->producerDone = true;
+
+    uPortTaskDelete(NULL);
+}
+
+// Run one case of the benchmark, printing the results and returning
+// true if every record arrived in order.
+static bool benchmark(uTestUtilsRingBufferBenchmark_t *pBenchmark, const char *pName)
+{
+    bool success = true;
+    uTestUtilsRingBufferRecord_t record = {0};
+    uPortTaskHandle_t taskHandle = NULL;
+    int32_t startTimeMs;
+    int32_t durationMs;
+    int32_t latencyMs;
+    size_t count;
+    size_t spins = 0;
+    size_t percentile99 = 0;
+    size_t max = 0;
+
+    // First, a single task adding and reading: the raw cost
+    // of the calls, no contention
+    startTimeMs = uPortGetTickTimeMs();
+    for (size_t x = 0; (x < U_TEST_UTILS_RINGBUFFER_BENCHMARK_NUM_RECORDS) && success; x++) {
+        record.sequence = (uint32_t) x;
+        success = benchmarkAdd(pBenchmark, &record) && benchmarkRead(pBenchmark, &record) &&
+                  (record.sequence == x);
+    }
+    durationMs = uPortGetTickTimeMs() - startTimeMs;
+    if (durationMs <= 0) {
+        durationMs = 1;
+    }
+    U_TEST_PRINT_LINE("%s, one task: %d add/read pair(s) of %d byte(s) in %d ms,"
+                      " %d kbytes/s.", pName, U_TEST_UTILS_RINGBUFFER_BENCHMARK_NUM_RECORDS,
+                      sizeof(record), durationMs,
+                      (int32_t) ((U_TEST_UTILS_RINGBUFFER_BENCHMARK_NUM_RECORDS *
+                                  sizeof(record)) / durationMs));
+
+    // Then a producer task and us as the consumer
+    memset(pBenchmark->histogram, 0, sizeof(pBenchmark->histogram));
+    pBenchmark->producerDone = false;
+    startTimeMs = uPortGetTickTimeMs();
+    success = success && (uPortTaskCreate(benchmarkProducerTask, "benchmark",
+                                          U_CFG_TEST_OS_TASK_STACK_SIZE_BYTES,
+                                          (void *) pBenchmark,
+                                          U_CFG_TEST_OS_TASK_PRIORITY,
+                                          &taskHandle) == 0);
+    for (size_t x = 0; (x < U_TEST_UTILS_RINGBUFFER_BENCHMARK_NUM_RECORDS) && success;) {
+        if (benchmarkRead(pBenchmark, &record)) {
+            success = (record.sequence == x);
+            latencyMs = uPortGetTickTimeMs() - record.timeMs;
+            if (latencyMs > U_TEST_UTILS_RINGBUFFER_BENCHMARK_LATENCY_MAX_MS) {
+                latencyMs = U_TEST_UTILS_RINGBUFFER_BENCHMARK_LATENCY_MAX_MS;
+            }
+            if (latencyMs >= 0) {
+                pBenchmark->histogram[latencyMs]++;
+            }
+            x++;
+            spins = 0;
+        } else {
+            spins++;
+            if (spins >= U_TEST_UTILS_RINGBUFFER_BENCHMARK_SPIN_COUNT) {
+                uPortTaskBlock(U_CFG_OS_YIELD_MS);
+                spins = 0;
+            }
+        }
+    }
+    durationMs = uPortGetTickTimeMs() - startTimeMs;
+    if (durationMs <= 0) {
+        durationMs = 1;
+    }
+    if (taskHandle != NULL) {
+        // Make sure the producer has gone before we return
+        while (!pBenchmark->producerDone) {
+            uPortTaskBlock(U_CFG_OS_YIELD_MS);
+        }
+        uPortTaskBlock(100);
+    }
+    count = 0;
+    for (size_t x = 0; x < sizeof(pBenchmark->histogram) / sizeof(pBenchmark->histogram[0]); x++) {
+        count += pBenchmark->histogram[x];
+        if ((count * 100 < U_TEST_UTILS_RINGBUFFER_BENCHMARK_NUM_RECORDS * 99) ||
+            (percentile99 == 0)) {
+            percentile99 = x;
+        }
+        if (pBenchmark->histogram[x] > 0) {
+            max = x;
+        }
+    }
+    U_TEST_PRINT_LINE("%s, two tasks: %d record(s) of %d byte(s) in %d ms, %d kbytes/s,"
+                      " latency 99th percentile %d ms, max %d ms%s.", pName,
+                      U_TEST_UTILS_RINGBUFFER_BENCHMARK_NUM_RECORDS, sizeof(record),
+                      durationMs, (int32_t) ((U_TEST_UTILS_RINGBUFFER_BENCHMARK_NUM_RECORDS *
+                                              sizeof(record)) / durationMs),
+                      percentile99, max,
+                      max == U_TEST_UTILS_RINGBUFFER_BENCHMARK_LATENCY_MAX_MS ? " or more" : "");
+
+    return success;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: TESTS
  * -------------------------------------------------------------- */
@@ -882,4 +1155,409 @@ U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferBasic")
     U_PORT_TEST_ASSERT(resourceCount <= 0);
 }
 
-// End of file
\ No newline at end of file
+/** Test uRingBufferScanHandle().
+ */
+U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferScan")
+{
+    int32_t resourceCount;
+    uRingBuffer_t ringBuffer = {0};
+    char linearBuffer[U_TEST_UTILS_RINGBUFFER_SIZE];
+    char bufferIn[U_TEST_UTILS_RINGBUFFER_SIZE * 2];
+    uRingBufferScanPosition_t position = {0};
+    uTestUtilsRingBufferScan_t scan = {0};
+    int32_t handle;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_TEST_PRINT_LINE("testing ring buffer scan.");
+    for (size_t x = 0; x < sizeof(bufferIn); x++) {
+        bufferIn[x] = (char) x;
+    }
+    U_PORT_TEST_ASSERT(uRingBufferCreateWithReadHandle(&ringBuffer, linearBuffer,
+                                                       sizeof(linearBuffer), 1) == 0);
+    uRingBufferSetReadRequiresHandle(&ringBuffer, true);
+    handle = uRingBufferTakeReadHandle(&ringBuffer);
+    U_PORT_TEST_ASSERT(handle >= 0);
+    scan.stopAfter = sizeof(scan.buffer);
+
+    // Nothing in the buffer: nothing scanned
+    U_PORT_TEST_ASSERT(uRingBufferScanHandle(&ringBuffer, handle, &position, scanner, &scan) == 0);
+    U_PORT_TEST_ASSERT(scan.calls == 0);
+
+    // Move the pointers along so that the data wraps
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, bufferIn, 6));
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handle, NULL, 6) == 6);
+    U_PORT_TEST_ASSERT(uRingBufferScanHandle(&ringBuffer, handle, &position, scanner, &scan) == 0);
+    U_PORT_TEST_ASSERT(position.offset == 0);
+
+    // Add 3 bytes and scan them: one span
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, bufferIn, 3));
+    U_PORT_TEST_ASSERT(uRingBufferScanHandle(&ringBuffer, handle, &position, scanner, &scan) == 3);
+    U_PORT_TEST_ASSERT(scan.calls == 1);
+    U_PORT_TEST_ASSERT(position.offset == 3);
+    // Add 4 more, which wrap: only the new ones are scanned, in two spans
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, bufferIn + 3, 4));
+    U_PORT_TEST_ASSERT(uRingBufferScanHandle(&ringBuffer, handle, &position, scanner, &scan) == 4);
+    U_PORT_TEST_ASSERT(scan.calls == 3);
+    U_PORT_TEST_ASSERT(position.offset == 7);
+    U_PORT_TEST_ASSERT(scan.length == 7);
+    U_PORT_TEST_ASSERT(memcmp(scan.buffer, bufferIn, 7) == 0);
+    // Scanning did not move the read pointer
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handle) == 7);
+
+    // Read some of the scanned data: the position should follow
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handle, NULL, 2) == 2);
+    U_PORT_TEST_ASSERT(uRingBufferScanHandle(&ringBuffer, handle, &position, scanner, &scan) == 0);
+    U_PORT_TEST_ASSERT(position.offset == 5);
+
+    // Have the scanner stop part way through new data
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, bufferIn + 7, 4));
+    scan.stopAfter = 9;
+    U_PORT_TEST_ASSERT(uRingBufferScanHandle(&ringBuffer, handle, &position, scanner, &scan) == 2);
+    U_PORT_TEST_ASSERT(position.offset == 7);
+    scan.stopAfter = sizeof(scan.buffer);
+    U_PORT_TEST_ASSERT(uRingBufferScanHandle(&ringBuffer, handle, &position, scanner, &scan) == 2);
+    U_PORT_TEST_ASSERT(position.offset == 9);
+    U_PORT_TEST_ASSERT(scan.length == 11);
+    U_PORT_TEST_ASSERT(memcmp(scan.buffer, bufferIn, 11) == 0);
+
+    // Reduce the offset to have data scanned again
+    position.offset -= 3;
+    scan.length = 0;
+    U_PORT_TEST_ASSERT(uRingBufferScanHandle(&ringBuffer, handle, &position, scanner, &scan) == 3);
+    U_PORT_TEST_ASSERT(memcmp(scan.buffer, bufferIn + 8, 3) == 0);
+
+    // Read past the scanned data: the scan should begin again at
+    // the read pointer
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handle, NULL, 9) == 9);
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, bufferIn + 11, 3));
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handle, NULL, 1) == 1);
+    scan.length = 0;
+    U_PORT_TEST_ASSERT(uRingBufferScanHandle(&ringBuffer, handle, &position, scanner, &scan) == 2);
+    U_PORT_TEST_ASSERT(position.offset == 2);
+    U_PORT_TEST_ASSERT(memcmp(scan.buffer, bufferIn + 12, 2) == 0);
+
+    // Bad parameters
+    U_PORT_TEST_ASSERT(uRingBufferScanHandle(&ringBuffer, handle, NULL, scanner, &scan) < 0);
+    U_PORT_TEST_ASSERT(uRingBufferScanHandle(&ringBuffer, handle, &position, NULL, &scan) < 0);
+    U_PORT_TEST_ASSERT(uRingBufferScanHandle(&ringBuffer, handle + 1, &position, scanner, &scan) < 0);
+
+    U_TEST_PRINT_LINE("deleting ring buffer...");
+    uRingBufferDelete(&ringBuffer);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Test uRingBufferPeekSpans() and friends.
+ */
+U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferSpans")
+{
+    int32_t resourceCount;
+    uRingBuffer_t ringBuffer = {0};
+    char linearBuffer[U_TEST_UTILS_RINGBUFFER_SIZE];
+    char bufferIn[U_TEST_UTILS_RINGBUFFER_SIZE * 2];
+    uRingBufferSpan_t spans[U_RING_BUFFER_NUM_SPANS];
+    int32_t handle;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_TEST_PRINT_LINE("testing ring buffer spans without a read handle.");
+    for (size_t x = 0; x < sizeof(bufferIn); x++) {
+        bufferIn[x] = (char) x;
+    }
+    U_PORT_TEST_ASSERT(uRingBufferCreate(&ringBuffer, linearBuffer,
+                                         sizeof(linearBuffer)) == 0);
+    // Empty: no spans
+    U_PORT_TEST_ASSERT(uRingBufferPeekSpans(&ringBuffer, spans, 10, 0) == 0);
+    U_PORT_TEST_ASSERT((spans[0].pData == NULL) && (spans[0].size == 0));
+    U_PORT_TEST_ASSERT((spans[1].pData == NULL) && (spans[1].size == 0));
+    // Contiguous data: one span, pointing into the linear buffer
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, bufferIn, 6));
+    U_PORT_TEST_ASSERT(uRingBufferPeekSpans(&ringBuffer, spans, 10, 0) == 6);
+    U_PORT_TEST_ASSERT((spans[0].pData == linearBuffer) && (spans[0].size == 6));
+    U_PORT_TEST_ASSERT(spans[1].size == 0);
+    U_PORT_TEST_ASSERT(uRingBufferPeekSpans(&ringBuffer, spans, 2, 3) == 2);
+    U_PORT_TEST_ASSERT((spans[0].pData == linearBuffer + 3) && (spans[0].size == 2));
+    U_PORT_TEST_ASSERT(uRingBufferPeekSpans(&ringBuffer, spans, 2, 6) == 0);
+    // Consume some, add more so that it wraps: two spans
+    U_PORT_TEST_ASSERT(uRingBufferConsume(&ringBuffer, 5) == 5);
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, bufferIn + 6, 7));
+    U_PORT_TEST_ASSERT(uRingBufferPeekSpans(&ringBuffer, spans, 10, 0) == 8);
+    U_PORT_TEST_ASSERT((spans[0].pData == linearBuffer + 5) &&
+                       (spans[0].size == sizeof(linearBuffer) - 5));
+    U_PORT_TEST_ASSERT((spans[1].pData == linearBuffer) &&
+                       (spans[1].size == 8 - spans[0].size));
+    U_PORT_TEST_ASSERT(memcmp(spans[0].pData, bufferIn + 5, spans[0].size) == 0);
+    U_PORT_TEST_ASSERT(memcmp(spans[1].pData, bufferIn + 5 + spans[0].size,
+                              spans[1].size) == 0);
+    // Consuming did not copy: a read gets the rest, across the wrap
+    U_PORT_TEST_ASSERT(uRingBufferConsume(&ringBuffer, 1) == 1);
+    memset(bufferIn, 0xff, sizeof(bufferIn));
+    U_PORT_TEST_ASSERT(uRingBufferRead(&ringBuffer, bufferIn, sizeof(bufferIn)) == 7);
+    for (size_t x = 0; x < 7; x++) {
+        U_PORT_TEST_ASSERT(bufferIn[x] == (char) (x + 6));
+    }
+    U_PORT_TEST_ASSERT(uRingBufferConsume(&ringBuffer, 1) == 0);
+    uRingBufferDelete(&ringBuffer);
+
+    U_TEST_PRINT_LINE("testing ring buffer spans with a read handle.");
+    for (size_t x = 0; x < sizeof(bufferIn); x++) {
+        bufferIn[x] = (char) x;
+    }
+    U_PORT_TEST_ASSERT(uRingBufferCreateWithReadHandle(&ringBuffer, linearBuffer,
+                                                       sizeof(linearBuffer), 1) == 0);
+    uRingBufferSetReadRequiresHandle(&ringBuffer, true);
+    handle = uRingBufferTakeReadHandle(&ringBuffer);
+    U_PORT_TEST_ASSERT(handle >= 0);
+    // Without a handle there is nothing to be had
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, bufferIn, 8));
+    U_PORT_TEST_ASSERT(uRingBufferPeekSpans(&ringBuffer, spans, 10, 0) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferConsumeHandle(&ringBuffer, handle, 7) == 7);
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, bufferIn + 8, 6));
+    U_PORT_TEST_ASSERT(uRingBufferPeekSpansHandle(&ringBuffer, handle, spans, 10, 0) == 7);
+    U_PORT_TEST_ASSERT((spans[0].pData == linearBuffer + 7) &&
+                       (spans[0].size == sizeof(linearBuffer) - 7));
+    U_PORT_TEST_ASSERT((spans[1].pData == linearBuffer) &&
+                       (spans[1].size == 7 - spans[0].size));
+    // An offset into the second span leaves just the one
+    U_PORT_TEST_ASSERT(uRingBufferPeekSpansHandle(&ringBuffer, handle, spans, 10,
+                                                  sizeof(linearBuffer) - 7) == 4);
+    U_PORT_TEST_ASSERT((spans[0].pData == linearBuffer) && (spans[0].size == 4));
+    U_PORT_TEST_ASSERT(spans[1].size == 0);
+    for (size_t x = 0; x < spans[0].size; x++) {
+        U_PORT_TEST_ASSERT(*(spans[0].pData + x) == bufferIn[x + 10]);
+    }
+    U_PORT_TEST_ASSERT(uRingBufferConsumeHandle(&ringBuffer, handle, 10) == 7);
+    U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&ringBuffer, handle) == 0);
+    // Bad handle
+    U_PORT_TEST_ASSERT(uRingBufferPeekSpansHandle(&ringBuffer, handle + 1, spans, 10, 0) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferConsumeHandle(&ringBuffer, handle + 1, 10) == 0);
+
+    U_TEST_PRINT_LINE("deleting ring buffer...");
+    uRingBufferDelete(&ringBuffer);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Test uRingBufferParseHandle() with parsers that use the bulk
+ * access functions.
+ */
+U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferParse")
+{
+    int32_t resourceCount;
+    uRingBuffer_t ringBuffer = {0};
+    char linearBuffer[U_TEST_UTILS_RINGBUFFER_SIZE];
+    uTestUtilsRingBufferParse_t parse = {0};
+    U_RING_BUFFER_PARSER_f parserList[] = {frameParser, NULL};
+    U_RING_BUFFER_PARSER_f parserListTwo[] = {nothingParser, frameParser, NULL};
+    int32_t handle;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_TEST_PRINT_LINE("testing ring buffer parse.");
+    U_PORT_TEST_ASSERT(uRingBufferCreateWithReadHandle(&ringBuffer, linearBuffer,
+                                                       sizeof(linearBuffer), 1) == 0);
+    uRingBufferSetReadRequiresHandle(&ringBuffer, true);
+    handle = uRingBufferTakeReadHandle(&ringBuffer);
+    U_PORT_TEST_ASSERT(handle >= 0);
+
+    // Nothing there
+    U_PORT_TEST_ASSERT((int32_t) uRingBufferParseHandle(&ringBuffer, handle, parserList,
+                                                        &parse) == (int32_t) U_ERROR_COMMON_TIMEOUT);
+
+    // Rubbish then the start of a frame: the rubbish is skipped
+    // in one go and returned as a discard
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, "abcd<1", 6));
+    U_PORT_TEST_ASSERT(uRingBufferParseHandle(&ringBuffer, handle, parserList, &parse) == 4);
+    U_PORT_TEST_ASSERT(parse.calls == 2);
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handle, NULL, 4) == 4);
+    // Part of a frame
+    parse.calls = 0;
+    U_PORT_TEST_ASSERT((int32_t) uRingBufferParseHandle(&ringBuffer, handle, parserList,
+                                                        &parse) == (int32_t) U_ERROR_COMMON_TIMEOUT);
+    U_PORT_TEST_ASSERT(parse.calls == 1);
+    // The rest of it
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, "23>", 3));
+    U_PORT_TEST_ASSERT(uRingBufferParseHandle(&ringBuffer, handle, parserList, &parse) == 5);
+    U_PORT_TEST_ASSERT(parse.frameLength == 5);
+    U_PORT_TEST_ASSERT(memcmp(parse.frame, "<123>", 5) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handle, NULL, 5) == 5);
+
+    // With a parser that doesn't know how far to skip in the list
+    // the rubbish is skipped a byte at a time, as before; this
+    // also wraps around the end of the linear buffer
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, "xyz<4>", 6));
+    parse.calls = 0;
+    U_PORT_TEST_ASSERT(uRingBufferParseHandle(&ringBuffer, handle, parserListTwo, &parse) == 3);
+    U_PORT_TEST_ASSERT(parse.calls == 3 * 2 + 2);
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handle, NULL, 3) == 3);
+    U_PORT_TEST_ASSERT(uRingBufferParseHandle(&ringBuffer, handle, parserListTwo, &parse) == 3);
+    U_PORT_TEST_ASSERT(memcmp(parse.frame, "<4>", 3) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferReadHandle(&ringBuffer, handle, NULL, 3) == 3);
+
+    // Nothing but rubbish: all of it is discarded in one go
+    U_PORT_TEST_ASSERT(uRingBufferAdd(&ringBuffer, "rubbish", 7));
+    parse.calls = 0;
+    U_PORT_TEST_ASSERT(uRingBufferParseHandle(&ringBuffer, handle, parserList, &parse) == 7);
+    U_PORT_TEST_ASSERT(parse.calls == 1);
+
+    U_TEST_PRINT_LINE("deleting ring buffer...");
+    uRingBufferDelete(&ringBuffer);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Test the lock-free single-producer, single-consumer ring buffer.
+ */
+U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferSpsc")
+{
+    int32_t resourceCount;
+    uRingBufferSpsc_t ringBuffer = {0};
+    char linearBuffer[8];
+    char bufferIn[sizeof(linearBuffer) * 2];
+    char bufferOut[sizeof(linearBuffer) * 2];
+    uRingBufferSpan_t spans[U_RING_BUFFER_NUM_SPANS];
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_TEST_PRINT_LINE("testing lock-free ring buffer.");
+    for (size_t x = 0; x < sizeof(bufferIn); x++) {
+        bufferIn[x] = (char) x;
+    }
+    // Only a power of two will do
+    U_PORT_TEST_ASSERT(uRingBufferSpscCreate(&ringBuffer, linearBuffer,
+                                             sizeof(linearBuffer) - 1) < 0);
+    U_PORT_TEST_ASSERT(uRingBufferSpscCreate(&ringBuffer, linearBuffer, 0) < 0);
+    U_PORT_TEST_ASSERT(uRingBufferSpscCreate(&ringBuffer, NULL,
+                                             sizeof(linearBuffer)) < 0);
+    U_PORT_TEST_ASSERT(uRingBufferSpscCreate(&ringBuffer, linearBuffer,
+                                             sizeof(linearBuffer)) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferSpscDataSize(&ringBuffer) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferSpscAvailableSize(&ringBuffer) == sizeof(linearBuffer));
+    U_PORT_TEST_ASSERT(uRingBufferSpscRead(&ringBuffer, bufferOut, sizeof(bufferOut)) == 0);
+
+    // The whole buffer can be filled, no more
+    U_PORT_TEST_ASSERT(uRingBufferSpscAdd(&ringBuffer, bufferIn, 5));
+    U_PORT_TEST_ASSERT(!uRingBufferSpscAdd(&ringBuffer, bufferIn + 5, 4));
+    U_PORT_TEST_ASSERT(uRingBufferSpscStatAddLoss(&ringBuffer) == 4);
+    U_PORT_TEST_ASSERT(uRingBufferSpscAdd(&ringBuffer, bufferIn + 5, 3));
+    U_PORT_TEST_ASSERT(uRingBufferSpscDataSize(&ringBuffer) == sizeof(linearBuffer));
+    U_PORT_TEST_ASSERT(uRingBufferSpscAvailableSize(&ringBuffer) == 0);
+    memset(bufferOut, 0xff, sizeof(bufferOut));
+    U_PORT_TEST_ASSERT(uRingBufferSpscPeek(&ringBuffer, bufferOut, 3, 2) == 3);
+    U_PORT_TEST_ASSERT(memcmp(bufferOut, bufferIn + 2, 3) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferSpscRead(&ringBuffer, bufferOut, 6) == 6);
+    U_PORT_TEST_ASSERT(memcmp(bufferOut, bufferIn, 6) == 0);
+
+    // Wrap around: the data comes back in order and as two spans
+    U_PORT_TEST_ASSERT(uRingBufferSpscAdd(&ringBuffer, bufferIn + 8, 5));
+    U_PORT_TEST_ASSERT(uRingBufferSpscDataSize(&ringBuffer) == 7);
+    U_PORT_TEST_ASSERT(uRingBufferSpscPeekSpans(&ringBuffer, spans, 10, 0) == 7);
+    U_PORT_TEST_ASSERT((spans[0].pData == linearBuffer + 6) && (spans[0].size == 2));
+    U_PORT_TEST_ASSERT((spans[1].pData == linearBuffer) && (spans[1].size == 5));
+    U_PORT_TEST_ASSERT(uRingBufferSpscPeekSpans(&ringBuffer, spans, 2, 3) == 2);
+    U_PORT_TEST_ASSERT((spans[0].pData == linearBuffer + 1) && (spans[0].size == 2));
+    U_PORT_TEST_ASSERT(spans[1].size == 0);
+    U_PORT_TEST_ASSERT(uRingBufferSpscConsume(&ringBuffer, 1) == 1);
+    memset(bufferOut, 0xff, sizeof(bufferOut));
+    U_PORT_TEST_ASSERT(uRingBufferSpscRead(&ringBuffer, bufferOut, sizeof(bufferOut)) == 6);
+    U_PORT_TEST_ASSERT(memcmp(bufferOut, bufferIn + 7, 6) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferSpscDataSize(&ringBuffer) == 0);
+
+    // Flush
+    U_PORT_TEST_ASSERT(uRingBufferSpscAdd(&ringBuffer, bufferIn, 4));
+    uRingBufferSpscFlush(&ringBuffer);
+    U_PORT_TEST_ASSERT(uRingBufferSpscDataSize(&ringBuffer) == 0);
+    U_PORT_TEST_ASSERT(uRingBufferSpscAvailableSize(&ringBuffer) == sizeof(linearBuffer));
+
+    uRingBufferSpscDelete(&ringBuffer);
+    U_PORT_TEST_ASSERT(!uRingBufferSpscAdd(&ringBuffer, bufferIn, 1));
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Compare the throughput and latency of the locked ring buffer with
+ * that of the lock-free single-producer, single-consumer one; the
+ * results are printed, only correctness is asserted.
+ */
+U_PORT_TEST_FUNCTION("[ringbuffer]", "ringbufferSpscBenchmark")
+{
+    int32_t resourceCount;
+    uTestUtilsRingBufferBenchmark_t *pBenchmark;
+    uRingBuffer_t ringBuffer = {0};
+    uRingBufferSpsc_t ringBufferSpsc = {0};
+    char *pLinearBuffer;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    pBenchmark = (uTestUtilsRingBufferBenchmark_t *) pUPortMalloc(sizeof(*pBenchmark));
+    U_PORT_TEST_ASSERT(pBenchmark != NULL);
+    memset(pBenchmark, 0, sizeof(*pBenchmark));
+    pLinearBuffer = (char *) pUPortMalloc(U_TEST_UTILS_RINGBUFFER_BENCHMARK_SIZE);
+    U_PORT_TEST_ASSERT(pLinearBuffer != NULL);
+
+    U_PORT_TEST_ASSERT(uRingBufferCreate(&ringBuffer, pLinearBuffer,
+                                         U_TEST_UTILS_RINGBUFFER_BENCHMARK_SIZE) == 0);
+    pBenchmark->pRingBuffer = &ringBuffer;
+    U_PORT_TEST_ASSERT(benchmark(pBenchmark, "locked"));
+    pBenchmark->pRingBuffer = NULL;
+    uRingBufferDelete(&ringBuffer);
+
+    U_PORT_TEST_ASSERT(uRingBufferSpscCreate(&ringBufferSpsc, pLinearBuffer,
+                                             U_TEST_UTILS_RINGBUFFER_BENCHMARK_SIZE) == 0);
+    pBenchmark->pRingBufferSpsc = &ringBufferSpsc;
+    U_PORT_TEST_ASSERT(benchmark(pBenchmark, "lock-free"));
+    U_PORT_TEST_ASSERT(uRingBufferSpscDataSize(&ringBufferSpsc) == 0);
+    uRingBufferSpscDelete(&ringBufferSpsc);
+
+    uPortFree(pLinearBuffer);
+    uPortFree(pBenchmark);
+
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+// End of file
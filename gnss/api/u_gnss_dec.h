@@ -24,6 +24,12 @@
 
 #include "u_gnss_dec_ubx_nav_pvt.h"
 #include "u_gnss_dec_ubx_nav_hpposllh.h"
+#include "u_gnss_dec_ubx_nav_sat.h"
+#include "u_gnss_dec_ubx_nav_sig.h"
+#include "u_gnss_dec_ubx_nav_cov.h"
+#include "u_gnss_dec_ubx_rxm_rawx.h"
+#include "u_gnss_dec_ubx_esf_meas.h"
+#include "u_gnss_dec_ubx_tim_tp.h"
 
 /** \addtogroup _GNSS
  *  @{
@@ -37,6 +43,12 @@
  * to obtain high precision position from a HPG GNSS device
  * by requesting it to emit the UBX-NAV-HPPOSLLH message.
  *
+ * Where messages are being decoded at a high rate, uGnssDecDecode()
+ * may be used instead of pUGnssDecAlloc() to decode into storage
+ * provided by the caller, without any heap allocation; UBX messages
+ * may also be decoded directly into the structure for the message
+ * type with uGnssDecUbxToStruct().
+ *
  * The functions are thread-safe with the exception of
  * uGnssDecSetCallback().
  */
@@ -58,6 +70,12 @@ extern "C" {
 typedef union {
     uGnssDecUbxNavPvt_t           ubxNavPvt;      /**< UBX-NAV-PVT. */
     uGnssDecUbxNavHpposllh_t      ubxNavHpposllh; /**< UBX-NAV-HPPOSLLH. */
+    uGnssDecUbxNavSat_t           ubxNavSat;      /**< UBX-NAV-SAT. */
+    uGnssDecUbxNavSig_t           ubxNavSig;      /**< UBX-NAV-SIG. */
+    uGnssDecUbxNavCov_t           ubxNavCov;      /**< UBX-NAV-COV. */
+    uGnssDecUbxRxmRawx_t          ubxRxmRawx;     /**< UBX-RXM-RAWX. */
+    uGnssDecUbxEsfMeas_t          ubxEsfMeas;     /**< UBX-ESF-MEAS. */
+    uGnssDecUbxTimTp_t            ubxTimTp;       /**< UBX-TIM-TP. */
 } uGnssDecUnion_t;
 
 /** The result of attempting to decode a message, returned by
@@ -155,10 +173,12 @@ typedef int32_t (uGnssDecFunction_t) (uGnssMessageId_t *pId,
  * and must include all headers; no checking of checksums etc. on the
  * end of a known message is performed, hence they may be omitted.
  *
- * Currently only a very limited set of messages (actually just
- * UBX-NAV-PVT and UBX-NAV-HPPOSLLH, the latter useful if you wish
- * to use a high precision GNSS (HPG) device to its full extent) are
- * supported; see the top of the file u_gnss_dec.c for instructions
+ * Currently only a limited set of messages (UBX-NAV-PVT,
+ * UBX-NAV-HPPOSLLH, the latter useful if you wish to use a high
+ * precision GNSS (HPG) device to its full extent, UBX-NAV-SAT,
+ * UBX-NAV-SIG, UBX-NAV-COV, UBX-RXM-RAWX, UBX-ESF-MEAS and
+ * UBX-TIM-TP) are supported; see the top of the file u_gnss_dec.c
+ * for instructions
  * on how to add more decoders, or use uGnssDecSetCallback() to
  * hook-in your own decoders at run-time.
  *
@@ -186,6 +206,92 @@ typedef int32_t (uGnssDecFunction_t) (uGnssMessageId_t *pId,
  */
 uGnssDec_t *pUGnssDecAlloc(const char *pBuffer, size_t size);
 
+/** As pUGnssDecAlloc() but the result is written to storage provided
+ * by the caller, hence no memory is allocated and uGnssDecFree()
+ * must NOT be called; useful where messages are being decoded at
+ * a high rate.  The storage may be re-used for each message, e.g.:
+ *
+ * ```
+ * uGnssDec_t dec;
+ * uGnssDecUnion_t body;
+ * ...
+ * if (uGnssDecDecode(pBuffer, size, &dec, &body, sizeof(body)) == 0) {
+ *     if (dec.id.type == U_GNSS_PROTOCOL_UBX) {
+ *         ...dec.pBody
+ * ```
+ *
+ * If storage is only required for a given message type then pBody
+ * may point to the structure for that type, e.g. a
+ * #uGnssDecUbxNavPvt_t, and bodySize be set to its size.
+ *
+ * Since a callback set with uGnssDecSetCallback() allocates the body
+ * of the messages it decodes, it is NOT called by this function.
+ *
+ * @param[in] pBuffer  the buffer containing the message to be
+ *                     decoded; cannot be NULL.
+ * @param size         the amount of data at pBuffer.
+ * @param[out] pDec    a place to put the result of the decode, which
+ *                     will be populated exactly as for the structure
+ *                     returned by pUGnssDecAlloc(), except that the
+ *                     pBody field, when not NULL, will point to pBody;
+ *                     cannot be NULL.
+ * @param[out] pBody   storage for the decoded message body; cannot be
+ *                     NULL.
+ * @param bodySize     the amount of storage at pBody; if this is too
+ *                     small for the decoded message body the errorCode
+ *                     field of pDec will be set to
+ *                     #U_ERROR_COMMON_NO_MEMORY.
+ * @return             the errorCode field of pDec, or
+ *                     #U_ERROR_COMMON_INVALID_PARAMETER if pDec or pBody
+ *                     is NULL.
+ */
+int32_t uGnssDecDecode(const char *pBuffer, size_t size, uGnssDec_t *pDec,
+                       void *pBody, size_t bodySize);
+
+/** Decode a UBX message received from a GNSS device directly into
+ * a structure provided by the caller; no memory is allocated and
+ * uGnssDecSetCallback() has no effect on this function.  The same
+ * message types as pUGnssDecAlloc() are supported and, as for
+ * pUGnssDecAlloc(), the message must begin at the start of pBuffer
+ * and must include the UBX header, the checksum bytes may be omitted
+ * and they are not checked.
+ *
+ * For example, to decode a UBX-NAV-SAT message:
+ *
+ * ```
+ * uGnssDecUbxNavSat_t navSat;
+ * if (uGnssDecUbxToStruct(pBuffer, size, &navSat, sizeof(navSat)) >= 0) {
+ *     for (size_t x = 0; x < navSat.numSvs; x++) {
+ *         ...navSat.sv[x].cno
+ * ```
+ *
+ * Alternatively, if the message type is not known in advance,
+ * pStruct may point to a #uGnssDecUnion_t and the return value
+ * used to determine which member of the union has been populated.
+ *
+ * @param[in] pBuffer  the buffer containing the UBX message to be
+ *                     decoded; cannot be NULL.
+ * @param size         the amount of data at pBuffer.
+ * @param[out] pStruct a pointer to the structure for the message
+ *                     type, e.g. a #uGnssDecUbxNavSat_t for
+ *                     UBX-NAV-SAT; cannot be NULL.
+ * @param structSize   the amount of storage at pStruct, which must
+ *                     be at least the size of the structure for
+ *                     the message type.
+ * @return             on success the message class and ID, the
+ *                     class in the most significant byte, as
+ *                     U_GNSS_UBX_MESSAGE() would form it, else
+ *                     negative error code: #U_ERROR_COMMON_UNKNOWN
+ *                     if the buffer does not contain a UBX message,
+ *                     #U_ERROR_COMMON_NOT_SUPPORTED if there is no
+ *                     decoder for the message,
+ *                     #U_ERROR_COMMON_TRUNCATED if the message is
+ *                     incomplete or #U_ERROR_COMMON_INVALID_PARAMETER
+ *                     if structSize is too small.
+ */
+int32_t uGnssDecUbxToStruct(const char *pBuffer, size_t size,
+                            void *pStruct, size_t structSize);
+
 /** Free the memory returned by pUGnssDecAlloc().
  *
  * @param[in] pDec the pointer returned by pUGnssDecAlloc(); may
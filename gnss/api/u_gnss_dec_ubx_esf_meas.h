@@ -0,0 +1,203 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GNSS_DEC_UBX_ESF_MEAS_H_
+#define _U_GNSS_DEC_UBX_ESF_MEAS_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup _GNSS
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the types of a UBX-ESF-MEAS
+ * message.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The message class of a UBX-ESF-MEAS message.
+ */
+#define U_GNSS_DEC_UBX_ESF_MEAS_MESSAGE_CLASS 0x10
+
+/** The message ID of a UBX-ESF-MEAS message.
+ */
+#define U_GNSS_DEC_UBX_ESF_MEAS_MESSAGE_ID 0x02
+
+/** The minimum length of the body of a UBX-ESF-MEAS message.
+ */
+#define U_GNSS_DEC_UBX_ESF_MEAS_BODY_MIN_LENGTH 8
+
+#ifndef U_GNSS_DEC_UBX_ESF_MEAS_MAX_NUM_MEAS
+/** The maximum number of measurements that will be decoded from
+ * a UBX-ESF-MEAS message; any beyond this are ignored.  The
+ * message itself can carry no more than 31.
+ */
+# define U_GNSS_DEC_UBX_ESF_MEAS_MAX_NUM_MEAS 31
+#endif
+
+/** Bit mask for the #U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_TIME_MARK_SENT
+ * field of #uGnssDecUbxEsfMeasFlags_t.
+ */
+#define U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_TIME_MARK_SENT_MASK (0x03 << U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_TIME_MARK_SENT)
+
+/** Bit mask for the #U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_NUM_MEAS field
+ * of #uGnssDecUbxEsfMeasFlags_t.
+ */
+#define U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_NUM_MEAS_MASK (0x1f << U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_NUM_MEAS)
+
+/** Bit mask for the data field of an entry in the data[] array
+ * of #uGnssDecUbxEsfMeas_t; the field is signed for all data types
+ * except the wheel ticks and single tick, see the interface manual.
+ */
+#define U_GNSS_DEC_UBX_ESF_MEAS_DATA_FIELD_MASK 0x00ffffffUL
+
+/** Bit mask for the data type of an entry in the data[] array of
+ * #uGnssDecUbxEsfMeas_t; shift down by
+ * #U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_SHIFT after masking to obtain
+ * a #uGnssDecUbxEsfMeasDataType_t.
+ */
+#define U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_MASK 0x3f000000UL
+
+/** The number of bits to shift the data type of an entry in the
+ * data[] array of #uGnssDecUbxEsfMeas_t down by.
+ */
+#define U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_SHIFT 24
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Bit fields of the "flags" field of #uGnssDecUbxEsfMeas_t; use
+ * these to mask specific bits, e.g.
+ *
+ * `if (flags & (1 << U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_CALIB_TTAG_VALID)) {`
+ *
+ * ...would determine if the calibTtag field is valid.  Note that the
+ * fields #U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_TIME_MARK_SENT and
+ * #U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_NUM_MEAS are wider than a single bit.
+ */
+typedef enum {
+    U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_TIME_MARK_SENT = 0,   /**< not a single bit,
+                                                             the start of a 2-bit
+                                                             field, 0 for none,
+                                                             1 on Ext0, 2 on
+                                                             Ext1; use
+                                                             #U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_TIME_MARK_SENT_MASK
+                                                             to mask it. */
+    U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_TIME_MARK_EDGE = 2,   /**< set if the time mark
+                                                             was on a falling
+                                                             edge. */
+    U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_CALIB_TTAG_VALID = 3, /**< the calibTtag field
+                                                             is valid. */
+    U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_NUM_MEAS = 11         /**< not a single bit,
+                                                             the start of a 5-bit
+                                                             field giving the number
+                                                             of measurements; use
+                                                             #U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_NUM_MEAS_MASK
+                                                             to mask it, though
+                                                             the numMeas field of
+                                                             #uGnssDecUbxEsfMeas_t
+                                                             is more useful. */
+} uGnssDecUbxEsfMeasFlags_t;
+
+/** The data types that may be found in the data[] array of
+ * #uGnssDecUbxEsfMeas_t.
+ */
+typedef enum {
+    U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_NONE = 0,        /**< no data. */
+    U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_GYRO_Z = 5,      /**< z-axis gyroscope
+                                                            angular rate in
+                                                            degrees/second
+                                                            times 2 ^ 12. */
+    U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_WT_FL = 6,       /**< front-left wheel
+                                                            ticks. */
+    U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_WT_FR = 7,       /**< front-right wheel
+                                                            ticks. */
+    U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_WT_RL = 8,       /**< rear-left wheel
+                                                            ticks. */
+    U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_WT_RR = 9,       /**< rear-right wheel
+                                                            ticks. */
+    U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_SINGLE_TICK = 10, /**< single tick. */
+    U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_SPEED = 11,      /**< speed in metres/second
+                                                            times 1e3. */
+    U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_GYRO_TEMP = 12,  /**< gyroscope temperature
+                                                            in Celsius times 100. */
+    U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_GYRO_Y = 13,     /**< y-axis gyroscope
+                                                            angular rate in
+                                                            degrees/second
+                                                            times 2 ^ 12. */
+    U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_GYRO_X = 14,     /**< x-axis gyroscope
+                                                            angular rate in
+                                                            degrees/second
+                                                            times 2 ^ 12. */
+    U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_ACC_X = 16,      /**< x-axis accelerometer
+                                                            specific force in
+                                                            metres/second^2
+                                                            times 2 ^ 10. */
+    U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_ACC_Y = 17,      /**< y-axis accelerometer
+                                                            specific force in
+                                                            metres/second^2
+                                                            times 2 ^ 10. */
+    U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_ACC_Z = 18       /**< z-axis accelerometer
+                                                            specific force in
+                                                            metres/second^2
+                                                            times 2 ^ 10. */
+} uGnssDecUbxEsfMeasDataType_t;
+
+/** UBX-ESF-MEAS message structure; the naming and type of each
+ * element follows that of the interface manual.
+ */
+typedef struct {
+    uint32_t timeTag;   /**< time tag of the measurements. */
+    uint16_t flags;     /**< see #uGnssDecUbxEsfMeasFlags_t. */
+    uint16_t id;        /**< identification number of the data
+                             provider. */
+    uint8_t numMeas;    /**< the number of entries in data[], which
+                             will be at most
+                             #U_GNSS_DEC_UBX_ESF_MEAS_MAX_NUM_MEAS;
+                             not a field of the message as such,
+                             derived from the flags field. */
+    uint32_t data[U_GNSS_DEC_UBX_ESF_MEAS_MAX_NUM_MEAS]; /**< the measurements,
+                                                              see
+                                                              #U_GNSS_DEC_UBX_ESF_MEAS_DATA_FIELD_MASK
+                                                              and
+                                                              #U_GNSS_DEC_UBX_ESF_MEAS_DATA_TYPE_MASK. */
+    uint32_t calibTtag; /**< receiver local time calibrated, in
+                             milliseconds; only populated if the
+                             #U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_CALIB_TTAG_VALID
+                             bit of the flags field is set. */
+} uGnssDecUbxEsfMeas_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_GNSS_DEC_UBX_ESF_MEAS_H_
+
+// End of file
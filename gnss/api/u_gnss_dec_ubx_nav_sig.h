@@ -0,0 +1,154 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GNSS_DEC_UBX_NAV_SIG_H_
+#define _U_GNSS_DEC_UBX_NAV_SIG_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup _GNSS
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the types of a UBX-NAV-SIG
+ * message.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The message class of a UBX-NAV-SIG message.
+ */
+#define U_GNSS_DEC_UBX_NAV_SIG_MESSAGE_CLASS 0x01
+
+/** The message ID of a UBX-NAV-SIG message.
+ */
+#define U_GNSS_DEC_UBX_NAV_SIG_MESSAGE_ID 0x43
+
+/** The minimum length of the body of a UBX-NAV-SIG message.
+ */
+#define U_GNSS_DEC_UBX_NAV_SIG_BODY_MIN_LENGTH 8
+
+#ifndef U_GNSS_DEC_UBX_NAV_SIG_MAX_NUM_SIGS
+/** The maximum number of signals that will be decoded from
+ * a UBX-NAV-SIG message; any beyond this are ignored.
+ */
+# define U_GNSS_DEC_UBX_NAV_SIG_MAX_NUM_SIGS 64
+#endif
+
+/** Bit mask for the #U_GNSS_DEC_UBX_NAV_SIG_SIG_FLAGS_HEALTH field
+ * of #uGnssDecUbxNavSigSigFlags_t.
+ */
+#define U_GNSS_DEC_UBX_NAV_SIG_SIG_FLAGS_HEALTH_MASK (0x03 << U_GNSS_DEC_UBX_NAV_SIG_SIG_FLAGS_HEALTH)
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Bit fields of the "sigFlags" field of #uGnssDecUbxNavSigSig_t; use
+ * these to mask specific bits, e.g.
+ *
+ * `if (sigFlags & (1 << U_GNSS_DEC_UBX_NAV_SIG_SIG_FLAGS_PR_USED)) {`
+ *
+ * ...would determine if the pseudorange of the signal is being used
+ * for navigation.  Note that the field
+ * #U_GNSS_DEC_UBX_NAV_SIG_SIG_FLAGS_HEALTH is wider than a single bit.
+ */
+typedef enum {
+    U_GNSS_DEC_UBX_NAV_SIG_SIG_FLAGS_HEALTH = 0,       /**< not a single bit,
+                                                            the start of a 2-bit
+                                                            field, 0 for unknown,
+                                                            1 for healthy, 2 for
+                                                            unhealthy; use
+                                                            #U_GNSS_DEC_UBX_NAV_SIG_SIG_FLAGS_HEALTH_MASK
+                                                            to mask it. */
+    U_GNSS_DEC_UBX_NAV_SIG_SIG_FLAGS_PR_SMOOTHED = 2,  /**< the pseudorange
+                                                            has been smoothed. */
+    U_GNSS_DEC_UBX_NAV_SIG_SIG_FLAGS_PR_USED = 3,      /**< the pseudorange has
+                                                            been used. */
+    U_GNSS_DEC_UBX_NAV_SIG_SIG_FLAGS_CR_USED = 4,      /**< the carrier range
+                                                            has been used. */
+    U_GNSS_DEC_UBX_NAV_SIG_SIG_FLAGS_DO_USED = 5,      /**< the range rate
+                                                            (Doppler) has been
+                                                            used. */
+    U_GNSS_DEC_UBX_NAV_SIG_SIG_FLAGS_PR_CORR_USED = 6, /**< pseudorange
+                                                            corrections have
+                                                            been used. */
+    U_GNSS_DEC_UBX_NAV_SIG_SIG_FLAGS_CR_CORR_USED = 7, /**< carrier range
+                                                            corrections have
+                                                            been used. */
+    U_GNSS_DEC_UBX_NAV_SIG_SIG_FLAGS_DO_CORR_USED = 8  /**< range rate (Doppler)
+                                                            corrections have
+                                                            been used. */
+} uGnssDecUbxNavSigSigFlags_t;
+
+/** The per-signal part of a UBX-NAV-SIG message; the naming and
+ * type of each element follows that of the interface manual.
+ */
+typedef struct {
+    uint8_t gnssId;     /**< GNSS identifier. */
+    uint8_t svId;       /**< satellite identifier. */
+    uint8_t sigId;      /**< signal identifier. */
+    uint8_t freqId;     /**< GLONASS frequency slot plus 7, range
+                             0 to 13. */
+    int16_t prRes;      /**< pseudorange residual in metres times 10. */
+    uint8_t cno;        /**< carrier to noise ratio (signal strength)
+                             in dBHz. */
+    uint8_t qualityInd; /**< signal quality indicator, 0 for no
+                             signal up to 7 for code and carrier
+                             locked. */
+    uint8_t corrSource; /**< correction source, 0 for none, 1 for
+                             SBAS, 2 for BeiDou, 3 for RTCM2, 4 for
+                             RTCM3 OSR, 5 for RTCM3 SSR, 6 for QZSS
+                             SLAS, 7 for SPARTN, 8 for CLAS. */
+    uint8_t ionoModel;  /**< ionospheric model, 0 for none, 1 for
+                             Klobuchar GPS, 2 for SBAS, 3 for
+                             Klobuchar BeiDou, 8 for dual frequency
+                             delay. */
+    uint16_t sigFlags;  /**< see #uGnssDecUbxNavSigSigFlags_t. */
+} uGnssDecUbxNavSigSig_t;
+
+/** UBX-NAV-SIG message structure; the naming and type of each
+ * element follows that of the interface manual.
+ */
+typedef struct {
+    uint32_t iTOW;   /**< GPS time of week of the navigation epoch
+                          in milliseconds. */
+    uint8_t version; /**< message version. */
+    uint8_t numSigs; /**< the number of signals in sig[], which will
+                          be at most #U_GNSS_DEC_UBX_NAV_SIG_MAX_NUM_SIGS. */
+    uGnssDecUbxNavSigSig_t sig[U_GNSS_DEC_UBX_NAV_SIG_MAX_NUM_SIGS]; /**< the
+                                                                           signals. */
+} uGnssDecUbxNavSig_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_GNSS_DEC_UBX_NAV_SIG_H_
+
+// End of file
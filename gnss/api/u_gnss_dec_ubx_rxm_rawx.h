@@ -0,0 +1,158 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GNSS_DEC_UBX_RXM_RAWX_H_
+#define _U_GNSS_DEC_UBX_RXM_RAWX_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup _GNSS
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the types of a UBX-RXM-RAWX
+ * message.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The message class of a UBX-RXM-RAWX message.
+ */
+#define U_GNSS_DEC_UBX_RXM_RAWX_MESSAGE_CLASS 0x02
+
+/** The message ID of a UBX-RXM-RAWX message.
+ */
+#define U_GNSS_DEC_UBX_RXM_RAWX_MESSAGE_ID 0x15
+
+/** The minimum length of the body of a UBX-RXM-RAWX message.
+ */
+#define U_GNSS_DEC_UBX_RXM_RAWX_BODY_MIN_LENGTH 16
+
+#ifndef U_GNSS_DEC_UBX_RXM_RAWX_MAX_NUM_MEAS
+/** The maximum number of measurements that will be decoded from
+ * a UBX-RXM-RAWX message; any beyond this are ignored.
+ */
+# define U_GNSS_DEC_UBX_RXM_RAWX_MAX_NUM_MEAS 64
+#endif
+
+/** Bit mask for the standard deviation in the prStdev, cpStdev and
+ * doStdev fields of #uGnssDecUbxRxmRawxMeas_t.
+ */
+#define U_GNSS_DEC_UBX_RXM_RAWX_STDEV_MASK 0x0f
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Bit fields of the "recStat" field of #uGnssDecUbxRxmRawx_t; use
+ * these to mask specific bits, e.g.
+ *
+ * `if (recStat & (1 << U_GNSS_DEC_UBX_RXM_RAWX_REC_STAT_LEAP_SEC)) {`
+ *
+ * ...would determine if the leap seconds are known.
+ */
+typedef enum {
+    U_GNSS_DEC_UBX_RXM_RAWX_REC_STAT_LEAP_SEC = 0, /**< leap seconds have
+                                                        been determined. */
+    U_GNSS_DEC_UBX_RXM_RAWX_REC_STAT_CLK_RESET = 1 /**< clock reset applied. */
+} uGnssDecUbxRxmRawxRecStat_t;
+
+/** Bit fields of the "trkStat" field of #uGnssDecUbxRxmRawxMeas_t;
+ * use these to mask specific bits, e.g.
+ *
+ * `if (trkStat & (1 << U_GNSS_DEC_UBX_RXM_RAWX_TRK_STAT_PR_VALID)) {`
+ *
+ * ...would determine if the pseudorange is valid.
+ */
+typedef enum {
+    U_GNSS_DEC_UBX_RXM_RAWX_TRK_STAT_PR_VALID = 0,     /**< pseudorange
+                                                            is valid. */
+    U_GNSS_DEC_UBX_RXM_RAWX_TRK_STAT_CP_VALID = 1,     /**< carrier phase
+                                                            is valid. */
+    U_GNSS_DEC_UBX_RXM_RAWX_TRK_STAT_HALF_CYC = 2,     /**< half cycle
+                                                            is valid. */
+    U_GNSS_DEC_UBX_RXM_RAWX_TRK_STAT_SUB_HALF_CYC = 3  /**< half cycle has
+                                                            been subtracted
+                                                            from the phase. */
+} uGnssDecUbxRxmRawxTrkStat_t;
+
+/** The per-measurement part of a UBX-RXM-RAWX message; the naming
+ * and type of each element follows that of the interface manual.
+ */
+typedef struct {
+    double prMes;      /**< pseudorange measurement in metres. */
+    double cpMes;      /**< carrier phase measurement in cycles. */
+    float doMes;       /**< Doppler measurement in Hz, positive
+                            sign for approaching satellites. */
+    uint8_t gnssId;    /**< GNSS identifier. */
+    uint8_t svId;      /**< satellite identifier. */
+    uint8_t sigId;     /**< signal identifier. */
+    uint8_t freqId;    /**< GLONASS frequency slot plus 7, range
+                            0 to 13. */
+    uint16_t locktime; /**< carrier phase locktime counter in
+                            milliseconds, maximum 64500. */
+    uint8_t cno;       /**< carrier to noise ratio (signal strength)
+                            in dBHz. */
+    uint8_t prStdev;   /**< estimated pseudorange measurement standard
+                            deviation, 0.01 * 2 ^ n metres where n is
+                            the value masked with
+                            #U_GNSS_DEC_UBX_RXM_RAWX_STDEV_MASK. */
+    uint8_t cpStdev;   /**< estimated carrier phase measurement standard
+                            deviation, 0.004 cycles times the value
+                            masked with #U_GNSS_DEC_UBX_RXM_RAWX_STDEV_MASK. */
+    uint8_t doStdev;   /**< estimated Doppler measurement standard
+                            deviation, 0.002 * 2 ^ n Hz where n is the
+                            value masked with
+                            #U_GNSS_DEC_UBX_RXM_RAWX_STDEV_MASK. */
+    uint8_t trkStat;   /**< see #uGnssDecUbxRxmRawxTrkStat_t. */
+} uGnssDecUbxRxmRawxMeas_t;
+
+/** UBX-RXM-RAWX message structure; the naming and type of each
+ * element follows that of the interface manual.
+ */
+typedef struct {
+    double rcvTow;   /**< measurement time of week in receiver local
+                          time, in seconds. */
+    uint16_t week;   /**< GPS week number in receiver local time. */
+    int8_t leapS;    /**< GPS leap seconds (GPS-UTC). */
+    uint8_t numMeas; /**< the number of measurements in meas[], which
+                          will be at most
+                          #U_GNSS_DEC_UBX_RXM_RAWX_MAX_NUM_MEAS. */
+    uint8_t recStat; /**< see #uGnssDecUbxRxmRawxRecStat_t. */
+    uint8_t version; /**< message version. */
+    uGnssDecUbxRxmRawxMeas_t meas[U_GNSS_DEC_UBX_RXM_RAWX_MAX_NUM_MEAS]; /**< the
+                                                                              measurements. */
+} uGnssDecUbxRxmRawx_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_GNSS_DEC_UBX_RXM_RAWX_H_
+
+// End of file
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _U_GNSS_DEC_UBX_TIM_TP_H_
+#define _U_GNSS_DEC_UBX_TIM_TP_H_
+
+/* Only header files representing a direct and unavoidable
+ * dependency between the API of this module and the API
+ * of another module should be included here; otherwise
+ * please keep #includes to your .c files. */
+
+/** \addtogroup _GNSS
+ *  @{
+ */
+
+/** @file
+ * @brief This header file defines the types of a UBX-TIM-TP
+ * message.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The message class of a UBX-TIM-TP message.
+ */
+#define U_GNSS_DEC_UBX_TIM_TP_MESSAGE_CLASS 0x0d
+
+/** The message ID of a UBX-TIM-TP message.
+ */
+#define U_GNSS_DEC_UBX_TIM_TP_MESSAGE_ID 0x01
+
+/** The minimum length of the body of a UBX-TIM-TP message.
+ */
+#define U_GNSS_DEC_UBX_TIM_TP_BODY_MIN_LENGTH 16
+
+/** Bit mask for the #U_GNSS_DEC_UBX_TIM_TP_FLAGS_RAIM field
+ * of #uGnssDecUbxTimTpFlags_t.
+ */
+#define U_GNSS_DEC_UBX_TIM_TP_FLAGS_RAIM_MASK (0x03 << U_GNSS_DEC_UBX_TIM_TP_FLAGS_RAIM)
+
+/** Bit mask for the time reference GNSS in the "refInfo" field of
+ * #uGnssDecUbxTimTp_t: 0 for GPS, 1 for GLONASS, 2 for BeiDou,
+ * 3 for Galileo, 4 for NavIC, 15 for unknown.
+ */
+#define U_GNSS_DEC_UBX_TIM_TP_REF_INFO_TIME_REF_GNSS_MASK 0x0f
+
+/** Bit mask for the UTC standard in the "refInfo" field of
+ * #uGnssDecUbxTimTp_t; shift down by four bits after masking.
+ */
+#define U_GNSS_DEC_UBX_TIM_TP_REF_INFO_UTC_STANDARD_MASK 0xf0
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Bit fields of the "flags" field of #uGnssDecUbxTimTp_t; use
+ * these to mask specific bits, e.g.
+ *
+ * `if (flags & (1 << U_GNSS_DEC_UBX_TIM_TP_FLAGS_UTC)) {`
+ *
+ * ...would determine if UTC is available.  Note that the field
+ * #U_GNSS_DEC_UBX_TIM_TP_FLAGS_RAIM is wider than a single bit.
+ */
+typedef enum {
+    U_GNSS_DEC_UBX_TIM_TP_FLAGS_TIME_BASE = 0,     /**< if set the time
+                                                        base is UTC, else
+                                                        it is GNSS. */
+    U_GNSS_DEC_UBX_TIM_TP_FLAGS_UTC = 1,           /**< UTC is available. */
+    U_GNSS_DEC_UBX_TIM_TP_FLAGS_RAIM = 2,          /**< not a single bit,
+                                                        the start of a 2-bit
+                                                        RAIM state field, 0
+                                                        for not available, 1
+                                                        for not active, 2 for
+                                                        active; use
+                                                        #U_GNSS_DEC_UBX_TIM_TP_FLAGS_RAIM_MASK
+                                                        to mask it. */
+    U_GNSS_DEC_UBX_TIM_TP_FLAGS_Q_ERR_INVALID = 4  /**< the quantization
+                                                        error, qErr, is
+                                                        invalid. */
+} uGnssDecUbxTimTpFlags_t;
+
+/** UBX-TIM-TP message structure, describing the next time pulse;
+ * the naming and type of each element follows that of the
+ * interface manual.
+ */
+typedef struct {
+    uint32_t towMS;    /**< time pulse time of week in milliseconds. */
+    uint32_t towSubMS; /**< sub-millisecond part of towMS in
+                            milliseconds times 2 ^ -32. */
+    int32_t qErr;      /**< quantization error of the time pulse
+                            in picoseconds. */
+    uint16_t week;     /**< time pulse week number. */
+    uint8_t flags;     /**< see #uGnssDecUbxTimTpFlags_t. */
+    uint8_t refInfo;   /**< time reference information, see
+                            #U_GNSS_DEC_UBX_TIM_TP_REF_INFO_TIME_REF_GNSS_MASK
+                            and #U_GNSS_DEC_UBX_TIM_TP_REF_INFO_UTC_STANDARD_MASK. */
+} uGnssDecUbxTimTp_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @}*/
+
+#endif // _U_GNSS_DEC_UBX_TIM_TP_H_
+
+// End of file
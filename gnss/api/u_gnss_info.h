@@ -78,9 +78,14 @@ typedef struct {
                                                          received by the GNSS
                                                          chip for each protocol
                                                          type, indexed by
-                                                         uGnssProtocol_t; any
-                                                         that are not reported
-                                                         will contain -1. */
+                                                         uGnssProtocol_t
+                                                         (including
+                                                         #U_GNSS_PROTOCOL_SPARTN,
+                                                         hence one entry larger
+                                                         than it used to be);
+                                                         any that are not
+                                                         reported will contain
+                                                         -1. */
     size_t rxSkippedBytes;        /**< the number of receive bytes skipped. */
 } uGnssCommunicationStats_t;
 
@@ -95,10 +95,60 @@ extern "C" {
 # define U_GNSS_MSG_RECEIVE_TASK_QUEUE_ITEM_SIZE_BYTES 1
 #endif
 
+#ifndef U_GNSS_MSG_RECEIVE_EVENT_COALESCE_MS
+/** The default coalescing window for an event-driven message
+ * receive task (see uGnssMsgReceiveSetEventDriven()): how long
+ * to wait after the first data event before pulling data from
+ * the transport, allowing a few more bytes to arrive so that
+ * they are processed in one go.
+ */
+# define U_GNSS_MSG_RECEIVE_EVENT_COALESCE_MS 2
+#endif
+
+#ifndef U_GNSS_MSG_RECEIVE_EVENT_GUARD_TIME_MS
+/** The longest an event-driven message receive task will wait
+ * for a data event from the transport before checking anyway,
+ * a guard against a lost event.
+ */
+# define U_GNSS_MSG_RECEIVE_EVENT_GUARD_TIME_MS 1000
+#endif
+
+#ifndef U_GNSS_MSG_RECEIVE_EVENT_TASK_STACK_SIZE_BYTES
+/** The stack size of the task in which the transport calls
+ * the data event callback of an event-driven message receive
+ * task; all that callback does is give a semaphore, hence this
+ * is only a little larger than the minimum permitted.
+ */
+# define U_GNSS_MSG_RECEIVE_EVENT_TASK_STACK_SIZE_BYTES 1536
+#endif
+
+#ifndef U_GNSS_MSG_RECEIVE_EVENT_TASK_PRIORITY
+/** The priority of the task in which the transport calls the
+ * data event callback of an event-driven message receive task.
+ */
+# define U_GNSS_MSG_RECEIVE_EVENT_TASK_PRIORITY (U_CFG_OS_PRIORITY_MAX - 5)
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Latency statistics for the non-blocking message receive task,
+ * see uGnssMsgReceiveStatLatency().
+ */
+typedef struct {
+    bool eventDriven; /**< true if the message receive task is waiting
+                           on data events from the transport, false
+                           if it is polling. */
+    size_t count;     /**< the number of messages passed to callbacks. */
+    int32_t minMs;    /**< the smallest time from data arriving to a
+                           callback being called in milliseconds. */
+    int32_t maxMs;    /**< the largest time from data arriving to a
+                           callback being called in milliseconds. */
+    int32_t averageMs; /**< the average time from data arriving to
+                            a callback being called in milliseconds. */
+} uGnssMsgReceiveLatency_t;
+
 /** A callback which will be called by uGnssMsgReceiveStart()
  * when a matching message has been received from the GNSS chip.
  * This callback should be executed as quickly as possible to
@@ -154,6 +204,65 @@ typedef void (*uGnssMsgReceiveCallback_t)(uDeviceHandle_t gnssHandle,
                                           int32_t errorCodeOrLength,
                                           void *pCallbackParam);
 
+/** A callback which will be called by uGnssMsgReceiveStartSpans()
+ * when a matching message has been received from the GNSS chip; like
+ * #uGnssMsgReceiveCallback_t except that the message is passed to
+ * the callback in place, as pointers into the internal ring buffer,
+ * so that there is no need to copy it out with
+ * uGnssMsgReceiveCallbackRead().  Since the message may wrap around
+ * the end of the ring buffer it is given as up to
+ * #U_RING_BUFFER_NUM_SPANS contiguous spans: pSpans[0] holds the start
+ * of the message and, if pSpans[1].size is non-zero, pSpans[1] holds
+ * the remainder.  For instance, to pass a message on to a socket:
+ *
+ * ```
+ * void myCallback(uDeviceHandle_t gnssHandle,
+ *                 const uGnssMessageId_t *pMessageId,
+ *                 int32_t errorCodeOrLength,
+ *                 const uRingBufferSpan_t *pSpans,
+ *                 void *pCallbackParam)
+ * {
+ *     (void) gnssHandle;
+ *     (void) pMessageId;
+ *     if (errorCodeOrLength > 0) {
+ *         for (size_t x = 0; x < U_RING_BUFFER_NUM_SPANS; x++) {
+ *             if (pSpans[x].size > 0) {
+ *                 uSockWrite(*(int32_t *) pCallbackParam,
+ *                            pSpans[x].pData, pSpans[x].size);
+ *             }
+ *         }
+ *     }
+ * }
+ * ```
+ *
+ * The same rules apply as for #uGnssMsgReceiveCallback_t; in
+ * addition the data pointed to by pSpans is ONLY valid for the
+ * duration of the callback: if you need it afterwards, copy it.
+ *
+ * @param gnssHandle             the handle of the GNSS instance.
+ * @param[out] pMessageId        a pointer to the message ID that was
+ *                               detected.
+ * @param errorCodeOrLength      the size of the message, including
+ *                               headers and checksums etc., which will
+ *                               be the sum of the sizes of the spans,
+ *                               or #U_GNSS_ERROR_NACK, see
+ *                               #uGnssMsgReceiveCallback_t.
+ * @param[in] pSpans             an array of #U_RING_BUFFER_NUM_SPANS
+ *                               spans containing the message; all spans
+ *                               will have zero size if errorCodeOrLength
+ *                               is negative or the message has been
+ *                               removed by uGnssMsgReceiveCallbackExtract()
+ *                               in a callback that was called before this
+ *                               one.
+ * @param[in,out] pCallbackParam the callback parameter that was originally
+ *                               given to uGnssMsgReceiveStartSpans().
+ */
+typedef void (*uGnssMsgReceiveSpanCallback_t)(uDeviceHandle_t gnssHandle,
+                                              const uGnssMessageId_t *pMessageId,
+                                              int32_t errorCodeOrLength,
+                                              const uRingBufferSpan_t *pSpans,
+                                              void *pCallbackParam);
+
 /* ----------------------------------------------------------------
  * FUNCTIONS: MISC
  * -------------------------------------------------------------- */
@@ -388,6 +497,29 @@ int32_t uGnssMsgReceiveStart(uDeviceHandle_t gnssHandle,
                              uGnssMsgReceiveCallback_t pCallback,
                              void *pCallbackParam);
 
+/** Like uGnssMsgReceiveStart() except that pCallback is given the
+ * message in place, without it being copied; see
+ * #uGnssMsgReceiveSpanCallback_t.  Use this where a large volume
+ * of message data (e.g. RTCM) is to be passed on elsewhere, to avoid
+ * making an intermediate copy of every byte.  Stop it, as usual,
+ * with uGnssMsgReceiveStop() or uGnssMsgReceiveStopAll().
+ *
+ * @param gnssHandle             the handle of the GNSS instance.
+ * @param[in] pMessageId         the message ID to capture; see
+ *                               uGnssMsgReceiveStart().
+ * @param[in] pCallback          the callback to be called when a
+ *                               matching message arrives; cannot
+ *                               be NULL.
+ * @param[in] pCallbackParam     will be passed to pCallback as its last
+ *                               parameter.
+ * @return                       a handle for this asynchronous reader on
+ *                               success, else negative error code.
+ */
+int32_t uGnssMsgReceiveStartSpans(uDeviceHandle_t gnssHandle,
+                                  const uGnssMessageId_t *pMessageId,
+                                  uGnssMsgReceiveSpanCallback_t pCallback,
+                                  void *pCallbackParam);
+
 /** To be called from the pCallback of uGnssMsgReceiveStart() to take
  * a peek at the message data from the internal ring buffer, copying it
  * (including any headers and checksums) into your buffer but NOT REMOVING
@@ -464,6 +596,64 @@ int32_t uGnssMsgReceiveStopAll(uDeviceHandle_t gnssHandle);
  */
 int32_t uGnssMsgReceiveStackMinFree(uDeviceHandle_t gnssHandle);
 
+/** By default the task that serves uGnssMsgReceiveStart() polls the
+ * streaming transport, waking every U_GNSS_MSG_TASK_STACK_YIELD_TIME_MS
+ * (or twice that when idle), which adds latency and costs processor
+ * time when there is nothing to do.  Call this function with onNotOff
+ * set to true and the task will instead block until the transport
+ * reports that data has arrived, then wait coalesceMs for more
+ * data to turn up before processing the lot.  This is only possible
+ * with a UART or virtual serial transport and only if no one else
+ * has set an event callback on that transport: where it is not
+ * possible the task will poll as usual, uGnssMsgReceiveStatLatency()
+ * will tell you which happened.
+ *
+ * The setting takes effect when the message receive task is started,
+ * i.e. on the first call to uGnssMsgReceiveStart(), hence this must be
+ * called while no message receivers are active.
+ *
+ * @param gnssHandle the handle of the GNSS instance.
+ * @param onNotOff   true to wait on data events, false to poll
+ *                   (the default).
+ * @param coalesceMs the time to wait after a data event before
+ *                   reading from the transport, in milliseconds;
+ *                   use -1 for #U_GNSS_MSG_RECEIVE_EVENT_COALESCE_MS,
+ *                   0 for lowest latency.
+ * @return           zero on success, #U_ERROR_COMMON_BUSY if a
+ *                   message receiver is active, else negative error
+ *                   code.
+ */
+int32_t uGnssMsgReceiveSetEventDriven(uDeviceHandle_t gnssHandle,
+                                      bool onNotOff, int32_t coalesceMs);
+
+/** Get whether the message receive task is set to be event-driven.
+ *
+ * @param gnssHandle        the handle of the GNSS instance.
+ * @param[out] pCoalesceMs  a place to put the coalescing window in
+ *                          milliseconds; may be NULL.
+ * @return                  true if event-driven operation has been
+ *                          requested, else false.
+ */
+bool uGnssMsgReceiveGetEventDriven(uDeviceHandle_t gnssHandle,
+                                   int32_t *pCoalesceMs);
+
+/** Get the latency of the non-blocking message receive task: the
+ * time from data arriving at the transport to the message that data
+ * completes being passed to a uGnssMsgReceiveStart() callback.  Where
+ * the task is polling the arrival time is not known and so the time
+ * is measured from the point at which the data was read from the
+ * transport.  The statistics are reset when the message receive
+ * task is started.
+ *
+ * @param gnssHandle     the handle of the GNSS instance.
+ * @param[out] pLatency  a place to put the latency statistics;
+ *                       cannot be NULL.
+ * @return               zero on success, else negative error code
+ *                       (e.g. if no message receiver is active).
+ */
+int32_t uGnssMsgReceiveStatLatency(uDeviceHandle_t gnssHandle,
+                                   uGnssMsgReceiveLatency_t *pLatency);
+
 /** Check if any message data bytes from a streaming source (for
  * example I2C or UART or SPI) have been lost to the non-blocking message
  * receive handler as a result of it not keeping up with the data flow
@@ -134,6 +134,27 @@
 # define U_GNSS_RTCM_MESSAGE_ID_ALL 0xFFFF
 #endif
 
+#ifndef U_GNSS_SPARTN_MESSAGE_TYPE_ALL
+/** Value used in the most significant byte of the .spartn field of
+ * uGnssMessageId_t to indicate "all SPARTN message types".
+ */
+# define U_GNSS_SPARTN_MESSAGE_TYPE_ALL 0xFF
+#endif
+
+#ifndef U_GNSS_SPARTN_MESSAGE_SUB_TYPE_ALL
+/** Value used in the least significant byte of the .spartn field of
+ * uGnssMessageId_t to indicate "all SPARTN message sub-types".
+ */
+# define U_GNSS_SPARTN_MESSAGE_SUB_TYPE_ALL 0xFF
+#endif
+
+#ifndef U_GNSS_SPARTN_MESSAGE_ALL
+/** Value that can be used in the .spartn field of uGnssMessageId_t
+ * to indicate "all SPARTN messages".
+ */
+# define U_GNSS_SPARTN_MESSAGE_ALL 0xFFFF
+#endif
+
 #ifndef U_GNSS_NMEA_MESSAGE_MATCH_LENGTH_CHARACTERS
 /** The maximum number of characters of an NMEA message header
  * (i.e. talker/sentence) to include when performing a match
@@ -224,13 +245,23 @@ typedef enum {
 } uGnssPort_t;
 
 /** The protocol types for exchanges with a GNSS chip.
+ *
+ * Note: the addition of #U_GNSS_PROTOCOL_SPARTN moved
+ * #U_GNSS_PROTOCOL_MAX_NUM from 4 to 5, and hence #U_GNSS_PROTOCOL_NONE,
+ * #U_GNSS_PROTOCOL_ALL and #U_GNSS_PROTOCOL_ANY up by one also;
+ * anything sized by #U_GNSS_PROTOCOL_MAX_NUM (e.g. the rxNumMessages
+ * array of #uGnssCommunicationStats_t) has grown by one entry and code
+ * built against an earlier version of this header must be rebuilt.
  */
 typedef enum {
     U_GNSS_PROTOCOL_UBX = 0,     // Value chosen to match encoded version for the GNSS chip
     U_GNSS_PROTOCOL_NMEA = 1,    // Value chosen to match encoded version for the GNSS chip
     U_GNSS_PROTOCOL_RTCM = 2,
     U_GNSS_PROTOCOL_UNKNOWN = 3, // Must have this value as it is used to mark
-    U_GNSS_PROTOCOL_MAX_NUM,     // the end of the known output protocols
+                                 // the end of the known output protocols
+    U_GNSS_PROTOCOL_SPARTN = 4,  // Not output by a GNSS chip but may be in the
+                                 // stream from, for instance, an L-band receiver
+    U_GNSS_PROTOCOL_MAX_NUM,
     U_GNSS_PROTOCOL_NONE,
     U_GNSS_PROTOCOL_ALL,
     U_GNSS_PROTOCOL_ANY
@@ -262,6 +293,16 @@ typedef struct {
                            character at that position, so for instance "G?GSV"
                            would match "GPGSV", "GLGSV", "GAGSV", etc. */
         uint16_t rtcm;
+        uint16_t spartn; /**< formed of the message type (TF002) in the most
+                              significant byte and the message sub-type (TF007)
+                              in the least significant byte; where this is
+                              employed for matching you may use
+                              #U_GNSS_SPARTN_MESSAGE_TYPE_ALL in the most
+                              significant byte for all types,
+                              #U_GNSS_SPARTN_MESSAGE_SUB_TYPE_ALL in the
+                              least significant byte for all sub-types, or just
+                              #U_GNSS_SPARTN_MESSAGE_ALL for all SPARTN
+                              messages. */
     } id;
 } uGnssMessageId_t;
 
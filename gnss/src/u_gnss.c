@@ -349,6 +349,8 @@ int32_t uGnssAdd(uGnssModuleType_t moduleType,
                         pInstance->timeoutMs = U_GNSS_DEFAULT_TIMEOUT_MS;
                         pInstance->spiFillThreshold = U_GNSS_DEFAULT_SPI_FILL_THRESHOLD;
                         pInstance->printUbxMessages = false;
+                        pInstance->msgReceiveEventDriven = false;
+                        pInstance->msgReceiveCoalesceMs = U_GNSS_MSG_RECEIVE_EVENT_COALESCE_MS;
                         pInstance->pinGnssEnablePower = pinGnssEnablePower;
                         pInstance->atModulePinPwr = -1;
                         pInstance->atModulePinDataReady = -1;
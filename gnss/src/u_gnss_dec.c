@@ -47,14 +47,22 @@
  * ubxlib.h and add the new message struct to the #uGnssDecUnion_t
  * in this file.
  *
- * 3. Create the static decode function for the message here,
- * following the naming pattern, e.g. for UBX-XXX-YYY the function
- * would be named ubxXxxYyyAlloc(); the function  must have the
- * function signature of #uGnssDecKnownFunction_t.
+ * 3. Create a table of field descriptors for the message here,
+ * following the naming pattern, e.g. for UBX-XXX-YYY the table
+ * would be named gUbxXxxYyyField[], with one entry per field of
+ * the structure, in order of offset in the message body, formed
+ * using U_GNSS_DEC_UBX_FIELD() (or U_GNSS_DEC_UBX_FIELD_WIDEN()
+ * if the member of the structure is wider than the field in the
+ * message, e.g. an enum).  If the message contains a repeated
+ * block, create a second table for the fields of the block and a
+ * #uGnssDecUbxBlock_t that describes where the block is and how
+ * many times it is repeated.  Anything the tables cannot express
+ * may be dealt with by a function of type
+ * #uGnssDecUbxPostDecodeFunction_t.
  *
- * 4. Add the static function to the gpFunctionList array and add
- * its message ID to the gIdList array, making sure to put it in the
- * same position in both.
+ * 4. Add a #uGnssDecUbxMessage_t that refers to the tables to the
+ * gMessageList array and add its message ID to the gIdList array,
+ * making sure to put it in the same position in both.
  *
  * 5. If in step (1) you chose to include helper functions, add a
  * .c file in this src directory, of the same name as the .h file,
@@ -67,9 +75,15 @@
  * function if there are any (again, see the handling of UBX-NAV-PVT
  * for an example).
  *
- * Obviously it would be possible to add NMEA messages, or RTCM messages,
- * in the same way, just replacing "ubx" with "nmea" or "rtcm", but note
- * that this code does not use NMEA or RTCM messages and we want to avoid
+ * The fields are read from the message body in little-endian order;
+ * on a little-endian MCU, runs of fields that are laid out identically
+ * in the message body and in the structure are simply memcpy()'ed
+ * across.  No heap is required to decode a message, hence
+ * uGnssDecUbxToStruct() can decode into a structure provided by the
+ * caller.
+ *
+ * NMEA and RTCM messages are not handled by the descriptor tables:
+ * this code does not use NMEA or RTCM messages and we want to avoid
  * code bloat, hence the uGnssDecSetCallback() hook to allow a customer
  * to add their own decoders at run-time.
  */
@@ -104,35 +118,101 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
+/** The size of a member of a structure.
+ */
+#define U_GNSS_DEC_MEMBER_SIZE(type, member) sizeof(((type *) 0)->member)
+
+/** Form a #uGnssDecUbxField_t for a member of a message structure
+ * that is the same size as the field in the message body.
+ */
+#define U_GNSS_DEC_UBX_FIELD(type, member, wireOffset)    \
+    {wireOffset, offsetof(type, member),                  \
+     U_GNSS_DEC_MEMBER_SIZE(type, member),                \
+     U_GNSS_DEC_MEMBER_SIZE(type, member), false}
+
+/** Form a #uGnssDecUbxField_t for a member of a message structure
+ * that is wider than the field in the message body, e.g. an enum.
+ */
+#define U_GNSS_DEC_UBX_FIELD_WIDEN(type, member, wireOffset, wireSize, isSigned) \
+    {wireOffset, offsetof(type, member), wireSize,                              \
+     U_GNSS_DEC_MEMBER_SIZE(type, member), isSigned}
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
-/** Private version of function that can be hooked into
- * pUGnssDecAlloc() by uGnssDecSetCallback() to decode message types
- * that _are_ known to this code.
+/** Description of a field of a UBX message: where it is in the
+ * message body and where it goes in the message structure.  All
+ * fields are little-endian in the message body.
+ */
+typedef struct {
+    uint16_t wireOffset;   /**< offset of the field in the message
+                                body, or in the repeated block. */
+    uint16_t structOffset; /**< offset of the member in the message
+                                structure, or in the repeated block
+                                structure. */
+    uint8_t wireSize;      /**< size of the field in the message body. */
+    uint8_t structSize;    /**< size of the member in the structure,
+                                at least wireSize. */
+    bool isSigned;         /**< true if the field should be sign-extended
+                                where structSize is larger than wireSize. */
+} uGnssDecUbxField_t;
+
+/** Description of a block that is repeated in the body of a
+ * UBX message, e.g. the per-satellite information of UBX-NAV-SAT.
+ */
+typedef struct {
+    const uGnssDecUbxField_t *pField; /**< the fields of the block. */
+    size_t numFields;          /**< the number of elements at pField. */
+    uint16_t wireOffset;       /**< offset of the first block in the
+                                    message body. */
+    uint16_t wireLength;       /**< length of a block in the message
+                                    body. */
+    uint16_t structOffset;     /**< offset of the array of blocks in the
+                                    message structure. */
+    uint16_t structLength;     /**< size of an element of the array of
+                                    blocks in the message structure. */
+    uint16_t maxNum;           /**< the number of elements in the array
+                                    of blocks in the message structure. */
+    uint16_t countWireOffset;  /**< offset of the field of the message
+                                    body that gives the number of blocks. */
+    uint8_t countWireSize;     /**< size of that field, 1 or 2. */
+    uint8_t countShift;        /**< the number of bits to shift that field
+                                    down by to obtain the number of blocks. */
+    uint16_t countMask;        /**< the mask to apply after shifting. */
+    uint16_t countStructOffset; /**< offset of the uint8_t member of the
+                                     message structure which is set to the
+                                     number of blocks decoded. */
+} uGnssDecUbxBlock_t;
+
+/** Function to do anything the descriptor tables cannot express,
+ * called after the fields of a message have been decoded.
  *
- * @param[in] pBuffer             the buffer pointer that was passed to
- *                                pUGnssDecAlloc().
- * @param size                    the number of bytes at pBuffer;
- *                                for a known protocol it _might_
- *                                be that any FCS/check-sum bytes
- *                                on the end have been removed
- *                                by the caller, hence the function
- *                                should not _require_ them to be
- *                                present in the count.
- * @param[out] ppBody             a pointer to a place to put the
- *                                decoded message body, which the
- *                                callback should allocate using
- *                                pUPortMalloc(); will never be NULL.
- * @return                        zero on a successful decode, else
- *                                negative error code, preferably
- *                                from the set suggested for the
- *                                errorCode field of #uGnssDec_t.
+ * @param[in] pBody     the message body.
+ * @param bodyLength    the length of the message body.
+ * @param[out] pStruct  the message structure.
+ */
+typedef void (uGnssDecUbxPostDecodeFunction_t) (const char *pBody,
+                                                size_t bodyLength,
+                                                void *pStruct);
+
+/** Description of a UBX message.
  */
-typedef int32_t (uGnssDecKnownFunction_t) (const char *pBuffer,
-                                           size_t size,
-                                           uGnssDecUnion_t **ppBody);
+typedef struct {
+    size_t bodyMinLength;             /**< the minimum length of the
+                                           message body. */
+    size_t structSize;                /**< the size of the message
+                                           structure. */
+    const uGnssDecUbxField_t *pField; /**< the fields of the message
+                                           outside any repeated block. */
+    size_t numFields;                 /**< the number of elements at
+                                           pField. */
+    const uGnssDecUbxBlock_t *pBlock; /**< the repeated block, NULL if
+                                           there isn't one. */
+    uGnssDecUbxPostDecodeFunction_t *pPostDecode; /**< post-decode
+                                                       function, NULL
+                                                       if not required. */
+} uGnssDecUbxMessage_t;
 
 /* ----------------------------------------------------------------
  * STATIC VARIABLES: MISC
@@ -147,7 +227,7 @@ static uGnssDecFunction_t *gpCallback = NULL;
 static void *gpCallbackParam = NULL;
 
 /** The list of known message IDs; order is important,
- * MUST be in the same order as gpFunctionList (see further
+ * MUST be in the same order as gMessageList (see further
  * down in this file) and both lists must contain the same number
  * of elements.
  */
@@ -159,242 +239,682 @@ static const uGnssMessageId_t gIdList[] = {
     {
         .type = U_GNSS_PROTOCOL_UBX,
         .id.ubx = U_GNSS_UBX_MESSAGE(U_GNSS_DEC_UBX_NAV_HPPOSLLH_MESSAGE_CLASS, U_GNSS_DEC_UBX_NAV_HPPOSLLH_MESSAGE_ID)
+    },
+    {
+        .type = U_GNSS_PROTOCOL_UBX,
+        .id.ubx = U_GNSS_UBX_MESSAGE(U_GNSS_DEC_UBX_NAV_SAT_MESSAGE_CLASS, U_GNSS_DEC_UBX_NAV_SAT_MESSAGE_ID)
+    },
+    {
+        .type = U_GNSS_PROTOCOL_UBX,
+        .id.ubx = U_GNSS_UBX_MESSAGE(U_GNSS_DEC_UBX_NAV_SIG_MESSAGE_CLASS, U_GNSS_DEC_UBX_NAV_SIG_MESSAGE_ID)
+    },
+    {
+        .type = U_GNSS_PROTOCOL_UBX,
+        .id.ubx = U_GNSS_UBX_MESSAGE(U_GNSS_DEC_UBX_NAV_COV_MESSAGE_CLASS, U_GNSS_DEC_UBX_NAV_COV_MESSAGE_ID)
+    },
+    {
+        .type = U_GNSS_PROTOCOL_UBX,
+        .id.ubx = U_GNSS_UBX_MESSAGE(U_GNSS_DEC_UBX_RXM_RAWX_MESSAGE_CLASS, U_GNSS_DEC_UBX_RXM_RAWX_MESSAGE_ID)
+    },
+    {
+        .type = U_GNSS_PROTOCOL_UBX,
+        .id.ubx = U_GNSS_UBX_MESSAGE(U_GNSS_DEC_UBX_ESF_MEAS_MESSAGE_CLASS, U_GNSS_DEC_UBX_ESF_MEAS_MESSAGE_ID)
+    },
+    {
+        .type = U_GNSS_PROTOCOL_UBX,
+        .id.ubx = U_GNSS_UBX_MESSAGE(U_GNSS_DEC_UBX_TIM_TP_MESSAGE_CLASS, U_GNSS_DEC_UBX_TIM_TP_MESSAGE_ID)
     }
 };
 
-// MORE STATIC VARIABLES after the message decoders...
-
 /* ----------------------------------------------------------------
- * STATIC FUNCTIONS: MESSAGE DECODERS
+ * STATIC VARIABLES: MESSAGE DESCRIPTORS
  * -------------------------------------------------------------- */
 
-// Decode a UBX-NAV-PVT message.
-static int32_t ubxNavPvtAlloc(const char *pBuffer, size_t size,
-                              uGnssDecUnion_t **ppBody)
-{
-    int32_t errorCode = (int32_t) U_ERROR_COMMON_TRUNCATED;
-    uGnssDecUbxNavPvt_t *pBody;
-
-    // No need to check pBuffer or ppBody for NULLity,
-    // we will never give this function NULL for those.
-    if (size >= U_UBX_PROTOCOL_HEADER_LENGTH_BYTES + U_GNSS_DEC_UBX_NAV_PVT_BODY_MIN_LENGTH) {
-        // Move past the header so that we can use payload offsets
-        // throughout, matching the offsets in the interface manual
-        pBuffer += U_UBX_PROTOCOL_HEADER_LENGTH_BYTES;
-        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-        pBody = (uGnssDecUbxNavPvt_t *) pUPortMalloc(sizeof(uGnssDecUbxNavPvt_t));
-        if (pBody != NULL) {
-            memset(pBody, 0, sizeof(*pBody));
-            // All good now, unless we hit a field we can't decode,
-            // in which case we _could_ set U_ERROR_COMMON_BAD_DATA,
-            // but, since this message will have been checked for
-            // integrity before it gets here, it is better to trust
-            // that the module emitted stuff correctly: it knows
-            // more about this than we do
-            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
-            pBody->iTOW = (int32_t) uUbxProtocolUint32Decode(pBuffer + 0);
-            pBody->year = uUbxProtocolUint16Decode(pBuffer + 4);
-            pBody->month = (uint8_t) *(pBuffer + 6); // *NOPAD* stop AStyle making * look like a multiply
-            pBody->day = (uint8_t) *(pBuffer + 7); // *NOPAD*
-            pBody->hour = (uint8_t) *(pBuffer + 8); // *NOPAD*
-            pBody->min = (uint8_t) *(pBuffer + 9); // *NOPAD*
-            pBody->sec = (uint8_t) *(pBuffer + 10); // *NOPAD*
-            pBody->valid = (uint8_t) *(pBuffer + 11); // *NOPAD*
-            pBody->tAcc = uUbxProtocolUint32Decode(pBuffer + 12);
-            pBody->nano = (int32_t) uUbxProtocolUint32Decode(pBuffer + 16);
-            pBody->fixType = (uGnssDecUbxNavPvtFixType_t) *(pBuffer + 20); // *NOPAD*
-            pBody->flags = (uint8_t) *(pBuffer + 21); // *NOPAD*
-            pBody->flags2 = (uint8_t) *(pBuffer + 22); // *NOPAD*
-            pBody->numSV = (uint8_t) *(pBuffer + 23); // *NOPAD*
-            pBody->lon = (int32_t) uUbxProtocolUint32Decode(pBuffer + 24);
-            pBody->lat = (int32_t) uUbxProtocolUint32Decode(pBuffer + 28);
-            pBody->height = (int32_t) uUbxProtocolUint32Decode(pBuffer + 32);
-            pBody->hMSL = (int32_t) uUbxProtocolUint32Decode(pBuffer + 36);
-            pBody->hAcc = uUbxProtocolUint32Decode(pBuffer + 40);
-            pBody->vAcc = uUbxProtocolUint32Decode(pBuffer + 44);
-            pBody->velN = (int32_t) uUbxProtocolUint32Decode(pBuffer + 48);
-            pBody->velE = (int32_t) uUbxProtocolUint32Decode(pBuffer + 52);
-            pBody->velD = (int32_t) uUbxProtocolUint32Decode(pBuffer + 56);
-            pBody->gSpeed = (int32_t) uUbxProtocolUint32Decode(pBuffer + 60);
-            pBody->headMot = (int32_t) uUbxProtocolUint32Decode(pBuffer + 64);
-            pBody->sAcc = uUbxProtocolUint32Decode(pBuffer + 68);
-            pBody->headAcc = uUbxProtocolUint32Decode(pBuffer + 72);
-            pBody->pDOP = uUbxProtocolUint16Decode(pBuffer + 76);
-            pBody->flags3 = uUbxProtocolUint16Decode(pBuffer + 78);
-            // 4 reserved bytes here
-            pBody->headVeh = (int32_t) uUbxProtocolUint32Decode(pBuffer + 84);
-            pBody->magDec = (int16_t) uUbxProtocolUint16Decode(pBuffer + 88);
-            pBody->magAcc = (int16_t) uUbxProtocolUint16Decode(pBuffer + 90);
-
-            // Populate the pointer that was passed in
-            *ppBody = (uGnssDecUnion_t *) pBody;
-        }
-    }
+/** The fields of UBX-NAV-PVT.
+ */
+static const uGnssDecUbxField_t gUbxNavPvtField[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, iTOW, 0),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, year, 4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, month, 6),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, day, 7),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, hour, 8),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, min, 9),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, sec, 10),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, valid, 11),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, tAcc, 12),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, nano, 16),
+    U_GNSS_DEC_UBX_FIELD_WIDEN(uGnssDecUbxNavPvt_t, fixType, 20, 1, false),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, flags, 21),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, flags2, 22),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, numSV, 23),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, lon, 24),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, lat, 28),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, height, 32),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, hMSL, 36),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, hAcc, 40),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, vAcc, 44),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, velN, 48),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, velE, 52),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, velD, 56),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, gSpeed, 60),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, headMot, 64),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, sAcc, 68),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, headAcc, 72),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, pDOP, 76),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, flags3, 78),
+    // 4 reserved bytes here
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, headVeh, 84),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, magDec, 88),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavPvt_t, magAcc, 90)
+};
 
-    return errorCode;
-}
+/** The fields of UBX-NAV-HPPOSLLH.
+ */
+static const uGnssDecUbxField_t gUbxNavHpposllhField[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, version, 0),
+    // 2 reserved bytes here
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, flags, 3),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, iTOW, 4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, lon, 8),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, lat, 12),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, height, 16),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, hMSL, 20),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, lonHp, 24),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, latHp, 25),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, heightHp, 26),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, hMSLHp, 27),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, hAcc, 28),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavHpposllh_t, vAcc, 32)
+};
+
+/** The fields of UBX-NAV-SAT, outside the repeated block.
+ */
+static const uGnssDecUbxField_t gUbxNavSatField[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSat_t, iTOW, 0),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSat_t, version, 4)
+    // numSvs at offset 5 is set from gUbxNavSatBlock
+};
+
+/** The fields of the repeated block of UBX-NAV-SAT.
+ */
+static const uGnssDecUbxField_t gUbxNavSatSvField[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSatSv_t, gnssId, 0),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSatSv_t, svId, 1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSatSv_t, cno, 2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSatSv_t, elev, 3),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSatSv_t, azim, 4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSatSv_t, prRes, 6),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSatSv_t, flags, 8)
+};
+
+/** The repeated block of UBX-NAV-SAT.
+ */
+static const uGnssDecUbxBlock_t gUbxNavSatBlock = {
+    gUbxNavSatSvField, sizeof(gUbxNavSatSvField) / sizeof(gUbxNavSatSvField[0]),
+    8, 12, offsetof(uGnssDecUbxNavSat_t, sv), sizeof(uGnssDecUbxNavSatSv_t),
+    U_GNSS_DEC_UBX_NAV_SAT_MAX_NUM_SVS,
+    5, 1, 0, 0xff, offsetof(uGnssDecUbxNavSat_t, numSvs)
+};
 
-// Decode a UBX-NAV-HPPOSLLH message.
-static int32_t ubxNavHpposllhAlloc(const char *pBuffer, size_t size,
-                                   uGnssDecUnion_t **ppBody)
+/** The fields of UBX-NAV-SIG, outside the repeated block.
+ */
+static const uGnssDecUbxField_t gUbxNavSigField[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSig_t, iTOW, 0),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSig_t, version, 4)
+    // numSigs at offset 5 is set from gUbxNavSigBlock
+};
+
+/** The fields of the repeated block of UBX-NAV-SIG.
+ */
+static const uGnssDecUbxField_t gUbxNavSigSigField[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, gnssId, 0),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, svId, 1),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, sigId, 2),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, freqId, 3),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, prRes, 4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, cno, 6),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, qualityInd, 7),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, corrSource, 8),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, ionoModel, 9),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavSigSig_t, sigFlags, 10)
+    // 4 reserved bytes here
+};
+
+/** The repeated block of UBX-NAV-SIG.
+ */
+static const uGnssDecUbxBlock_t gUbxNavSigBlock = {
+    gUbxNavSigSigField, sizeof(gUbxNavSigSigField) / sizeof(gUbxNavSigSigField[0]),
+    8, 16, offsetof(uGnssDecUbxNavSig_t, sig), sizeof(uGnssDecUbxNavSigSig_t),
+    U_GNSS_DEC_UBX_NAV_SIG_MAX_NUM_SIGS,
+    5, 1, 0, 0xff, offsetof(uGnssDecUbxNavSig_t, numSigs)
+};
+
+/** The fields of UBX-NAV-COV.
+ */
+static const uGnssDecUbxField_t gUbxNavCovField[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavCov_t, iTOW, 0),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavCov_t, version, 4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavCov_t, posCovValid, 5),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavCov_t, velCovValid, 6),
+    // 9 reserved bytes here
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavCov_t, posCovNN, 16),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavCov_t, posCovNE, 20),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavCov_t, posCovND, 24),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavCov_t, posCovEE, 28),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavCov_t, posCovED, 32),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavCov_t, posCovDD, 36),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavCov_t, velCovNN, 40),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavCov_t, velCovNE, 44),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavCov_t, velCovND, 48),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavCov_t, velCovEE, 52),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavCov_t, velCovED, 56),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxNavCov_t, velCovDD, 60)
+};
+
+/** The fields of UBX-RXM-RAWX, outside the repeated block.
+ */
+static const uGnssDecUbxField_t gUbxRxmRawxField[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawx_t, rcvTow, 0),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawx_t, week, 8),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawx_t, leapS, 10),
+    // numMeas at offset 11 is set from gUbxRxmRawxBlock
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawx_t, recStat, 12),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawx_t, version, 13)
+    // 2 reserved bytes here
+};
+
+/** The fields of the repeated block of UBX-RXM-RAWX.
+ */
+static const uGnssDecUbxField_t gUbxRxmRawxMeasField[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, prMes, 0),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, cpMes, 8),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, doMes, 16),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, gnssId, 20),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, svId, 21),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, sigId, 22),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, freqId, 23),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, locktime, 24),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, cno, 26),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, prStdev, 27),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, cpStdev, 28),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, doStdev, 29),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxRxmRawxMeas_t, trkStat, 30)
+    // 1 reserved byte here
+};
+
+/** The repeated block of UBX-RXM-RAWX.
+ */
+static const uGnssDecUbxBlock_t gUbxRxmRawxBlock = {
+    gUbxRxmRawxMeasField, sizeof(gUbxRxmRawxMeasField) / sizeof(gUbxRxmRawxMeasField[0]),
+    16, 32, offsetof(uGnssDecUbxRxmRawx_t, meas), sizeof(uGnssDecUbxRxmRawxMeas_t),
+    U_GNSS_DEC_UBX_RXM_RAWX_MAX_NUM_MEAS,
+    11, 1, 0, 0xff, offsetof(uGnssDecUbxRxmRawx_t, numMeas)
+};
+
+/** The fields of UBX-ESF-MEAS, outside the repeated block.
+ */
+static const uGnssDecUbxField_t gUbxEsfMeasField[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxEsfMeas_t, timeTag, 0),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxEsfMeas_t, flags, 4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxEsfMeas_t, id, 6)
+    // calibTtag is dealt with by ubxEsfMeasPostDecode()
+};
+
+/** The fields of the repeated block of UBX-ESF-MEAS.
+ */
+static const uGnssDecUbxField_t gUbxEsfMeasDataField[] = {
+    {0, 0, sizeof(uint32_t), sizeof(uint32_t), false}
+};
+
+/** The repeated block of UBX-ESF-MEAS: the number of blocks is
+ * in bits 11 to 15 of the flags field.
+ */
+static const uGnssDecUbxBlock_t gUbxEsfMeasBlock = {
+    gUbxEsfMeasDataField, sizeof(gUbxEsfMeasDataField) / sizeof(gUbxEsfMeasDataField[0]),
+    8, 4, offsetof(uGnssDecUbxEsfMeas_t, data), sizeof(uint32_t),
+    U_GNSS_DEC_UBX_ESF_MEAS_MAX_NUM_MEAS,
+    4, 2, U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_NUM_MEAS, 0x1f,
+    offsetof(uGnssDecUbxEsfMeas_t, numMeas)
+};
+
+/** The fields of UBX-TIM-TP.
+ */
+static const uGnssDecUbxField_t gUbxTimTpField[] = {
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxTimTp_t, towMS, 0),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxTimTp_t, towSubMS, 4),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxTimTp_t, qErr, 8),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxTimTp_t, week, 12),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxTimTp_t, flags, 14),
+    U_GNSS_DEC_UBX_FIELD(uGnssDecUbxTimTp_t, refInfo, 15)
+};
+
+// MORE STATIC VARIABLES after the post-decode functions...
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: POST-DECODE
+ * -------------------------------------------------------------- */
+
+// Post-decode for UBX-ESF-MEAS: calibTtag follows the data, if present.
+static void ubxEsfMeasPostDecode(const char *pBody, size_t bodyLength,
+                                 void *pStruct)
 {
-    int32_t errorCode = (int32_t) U_ERROR_COMMON_TRUNCATED;
-    uGnssDecUbxNavHpposllh_t *pBody;
-
-    // No need to check pBuffer or ppBody for NULLity,
-    // we will never give this function NULL for those.
-    if (size >= U_UBX_PROTOCOL_HEADER_LENGTH_BYTES + U_GNSS_DEC_UBX_NAV_HPPOSLLH_BODY_MIN_LENGTH) {
-        // Move past the header so that we can use payload offsets
-        // throughout, matching the offsets in the interface manual
-        pBuffer += U_UBX_PROTOCOL_HEADER_LENGTH_BYTES;
-        errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
-        pBody = (uGnssDecUbxNavHpposllh_t *) pUPortMalloc(sizeof(uGnssDecUbxNavHpposllh_t));
-        if (pBody != NULL) {
-            memset(pBody, 0, sizeof(*pBody));
-            // All good now, unless we hit a field we can't decode,
-            // in which case we _could_ set U_ERROR_COMMON_BAD_DATA,
-            // but, since this message will have been checked for
-            // integrity before it gets here, it is better to trust
-            // that the module emitted stuff correctly: it knows
-            // more about this than we do
-            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
-            pBody->version = (uint8_t) *(pBuffer + 0); // *NOPAD* stop AStyle making * look like a multiply
-            // 2 reserved bytes here
-            pBody->flags = (uint8_t) *(pBuffer + 3); // *NOPAD*
-            pBody->iTOW = (int32_t) uUbxProtocolUint32Decode(pBuffer + 4);
-            pBody->lon = (int32_t) uUbxProtocolUint32Decode(pBuffer + 8);
-            pBody->lat = (int32_t) uUbxProtocolUint32Decode(pBuffer + 12);
-            pBody->height = (int32_t) uUbxProtocolUint32Decode(pBuffer + 16);
-            pBody->hMSL = (int32_t) uUbxProtocolUint32Decode(pBuffer + 20);
-            pBody->lonHp = (int8_t) *(pBuffer + 24); // *NOPAD*
-            pBody->latHp = (int8_t) *(pBuffer + 25); // *NOPAD*
-            pBody->heightHp = (int8_t) *(pBuffer + 26); // *NOPAD*
-            pBody->hMSLHp = (int8_t) *(pBuffer + 27); // *NOPAD*
-            pBody->hAcc = uUbxProtocolUint32Decode(pBuffer + 28);
-            pBody->vAcc = uUbxProtocolUint32Decode(pBuffer + 32);
-
-            // Populate the pointer that was passed in
-            *ppBody = (uGnssDecUnion_t *) pBody;
+    uGnssDecUbxEsfMeas_t *pEsfMeas = (uGnssDecUbxEsfMeas_t *) pStruct;
+    size_t offset;
+
+    if (pEsfMeas->flags & (1 << U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_CALIB_TTAG_VALID)) {
+        // Must use the number of measurements in the message,
+        // not the number decoded, to find calibTtag
+        offset = 8 + (((pEsfMeas->flags & U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_NUM_MEAS_MASK) >>
+                       U_GNSS_DEC_UBX_ESF_MEAS_FLAGS_NUM_MEAS) * 4);
+        if (bodyLength >= offset + 4) {
+            pEsfMeas->calibTtag = uUbxProtocolUint32Decode(pBody + offset);
         }
     }
-
-    return errorCode;
 }
 
 /* ----------------------------------------------------------------
- * STATIC VARIABLES: MESSAGE DECODER LIST
+ * STATIC VARIABLES: MESSAGE DESCRIPTOR LIST
  * -------------------------------------------------------------- */
 
-/** A list of message decode functions; order is important,
+/** A list of message descriptors; order is important,
  * MUST be in the same order as gIdList and both lists
  * must contain the same number of elements.
  */
-static uGnssDecKnownFunction_t *gpFunctionList[] = {
-    ubxNavPvtAlloc,
-    ubxNavHpposllhAlloc
+static const uGnssDecUbxMessage_t gMessageList[] = {
+    {
+        U_GNSS_DEC_UBX_NAV_PVT_BODY_MIN_LENGTH, sizeof(uGnssDecUbxNavPvt_t),
+        gUbxNavPvtField, sizeof(gUbxNavPvtField) / sizeof(gUbxNavPvtField[0]),
+        NULL, NULL
+    },
+    {
+        U_GNSS_DEC_UBX_NAV_HPPOSLLH_BODY_MIN_LENGTH, sizeof(uGnssDecUbxNavHpposllh_t),
+        gUbxNavHpposllhField, sizeof(gUbxNavHpposllhField) / sizeof(gUbxNavHpposllhField[0]),
+        NULL, NULL
+    },
+    {
+        U_GNSS_DEC_UBX_NAV_SAT_BODY_MIN_LENGTH, sizeof(uGnssDecUbxNavSat_t),
+        gUbxNavSatField, sizeof(gUbxNavSatField) / sizeof(gUbxNavSatField[0]),
+        &gUbxNavSatBlock, NULL
+    },
+    {
+        U_GNSS_DEC_UBX_NAV_SIG_BODY_MIN_LENGTH, sizeof(uGnssDecUbxNavSig_t),
+        gUbxNavSigField, sizeof(gUbxNavSigField) / sizeof(gUbxNavSigField[0]),
+        &gUbxNavSigBlock, NULL
+    },
+    {
+        U_GNSS_DEC_UBX_NAV_COV_BODY_MIN_LENGTH, sizeof(uGnssDecUbxNavCov_t),
+        gUbxNavCovField, sizeof(gUbxNavCovField) / sizeof(gUbxNavCovField[0]),
+        NULL, NULL
+    },
+    {
+        U_GNSS_DEC_UBX_RXM_RAWX_BODY_MIN_LENGTH, sizeof(uGnssDecUbxRxmRawx_t),
+        gUbxRxmRawxField, sizeof(gUbxRxmRawxField) / sizeof(gUbxRxmRawxField[0]),
+        &gUbxRxmRawxBlock, NULL
+    },
+    {
+        U_GNSS_DEC_UBX_ESF_MEAS_BODY_MIN_LENGTH, sizeof(uGnssDecUbxEsfMeas_t),
+        gUbxEsfMeasField, sizeof(gUbxEsfMeasField) / sizeof(gUbxEsfMeasField[0]),
+        &gUbxEsfMeasBlock, ubxEsfMeasPostDecode
+    },
+    {
+        U_GNSS_DEC_UBX_TIM_TP_BODY_MIN_LENGTH, sizeof(uGnssDecUbxTimTp_t),
+        gUbxTimTpField, sizeof(gUbxTimTpField) / sizeof(gUbxTimTpField[0]),
+        NULL, NULL
+    }
 };
 
 /* ----------------------------------------------------------------
- * PUBLIC FUNCTIONS
+ * STATIC FUNCTIONS: DECODE ENGINE
  * -------------------------------------------------------------- */
 
-// Decode a message buffer received from a GNSS device.
-uGnssDec_t *pUGnssDecAlloc(const char *pBuffer, size_t size)
+// Return true if the given fields are laid out identically in the
+// message body and the structure and completely fill length bytes
+// of both, i.e. if a block of them can be copied verbatim.
+static bool fieldsAreVerbatim(const uGnssDecUbxField_t *pField,
+                              size_t numFields, size_t length)
+{
+    size_t offset = 0;
+
+    for (size_t x = 0; x < numFields; x++, pField++) {
+        if ((pField->wireOffset != offset) || (pField->structOffset != offset) ||
+            (pField->wireSize != pField->structSize)) {
+            return false;
+        }
+        offset += pField->wireSize;
+    }
+
+    return offset == length;
+}
+
+// Decode a set of fields from pWire into pStruct, ignoring any
+// that extend beyond wireLength; the fields must be in order of
+// wireOffset.
+static void fieldsDecode(const uGnssDecUbxField_t *pField,
+                         size_t numFields, bool littleEndian,
+                         const char *pWire, size_t wireLength,
+                         char *pStruct)
+{
+    size_t x = 0;
+    size_t y;
+    size_t length;
+    uint64_t value;
+    uint8_t value8;
+    uint16_t value16;
+    uint32_t value32;
+
+    while ((x < numFields) &&
+           ((size_t) pField[x].wireOffset + pField[x].wireSize <= wireLength)) {
+        if (littleEndian && (pField[x].wireSize == pField[x].structSize)) {
+            // Find the run of fields that follow on from this one
+            // both in the message body and in the structure and
+            // copy them all in one go
+            length = pField[x].wireSize;
+            for (y = x + 1; (y < numFields) &&
+                 (pField[y].wireSize == pField[y].structSize) &&
+                 (pField[y].wireOffset == pField[x].wireOffset + length) &&
+                 (pField[y].structOffset == pField[x].structOffset + length) &&
+                 ((size_t) pField[y].wireOffset + pField[y].wireSize <= wireLength); y++) {
+                length += pField[y].wireSize;
+            }
+            memcpy(pStruct + pField[x].structOffset, pWire + pField[x].wireOffset, length);
+            x = y;
+        } else {
+            // Assemble the value a byte at a time, least significant
+            // first, extend it and store it at the structure size;
+            // this works for floating point types also since they
+            // have the same byte order as integers
+            value = 0;
+            for (y = 0; y < pField[x].wireSize; y++) {
+                value |= ((uint64_t) (uint8_t) pWire[pField[x].wireOffset + y]) << (y * 8);
+            }
+            if (pField[x].isSigned && (pField[x].wireSize < sizeof(value)) &&
+                (value & (1ULL << ((pField[x].wireSize * 8) - 1)))) {
+                value |= UINT64_MAX << (pField[x].wireSize * 8);
+            }
+            switch (pField[x].structSize) {
+                case sizeof(value8):
+                    value8 = (uint8_t) value;
+                    memcpy(pStruct + pField[x].structOffset, &value8, sizeof(value8));
+                    break;
+                case sizeof(value16):
+                    value16 = (uint16_t) value;
+                    memcpy(pStruct + pField[x].structOffset, &value16, sizeof(value16));
+                    break;
+                case sizeof(value32):
+                    value32 = (uint32_t) value;
+                    memcpy(pStruct + pField[x].structOffset, &value32, sizeof(value32));
+                    break;
+                default:
+                    memcpy(pStruct + pField[x].structOffset, &value, sizeof(value));
+                    break;
+            }
+            x++;
+        }
+    }
+}
+
+// Decode the body of a UBX message into pStruct, which must be
+// at least pMessage->structSize bytes in size.
+static int32_t ubxDecode(const uGnssDecUbxMessage_t *pMessage,
+                         const char *pBody, size_t bodyLength,
+                         void *pStruct)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_TRUNCATED;
+    const uGnssDecUbxBlock_t *pBlock = pMessage->pBlock;
+    bool littleEndian = uUbxProtocolIsLittleEndian();
+    char *pStructChar = (char *) pStruct;
+    size_t count;
+
+    if (bodyLength >= pMessage->bodyMinLength) {
+        // All good now, unless we hit a field we can't decode,
+        // in which case we _could_ set U_ERROR_COMMON_BAD_DATA,
+        // but, since this message will have been checked for
+        // integrity before it gets here, it is better to trust
+        // that the module emitted stuff correctly: it knows
+        // more about this than we do
+        errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        memset(pStruct, 0, pMessage->structSize);
+        fieldsDecode(pMessage->pField, pMessage->numFields, littleEndian,
+                     pBody, bodyLength, pStructChar);
+        if (pBlock != NULL) {
+            count = (uint8_t) pBody[pBlock->countWireOffset];
+            if (pBlock->countWireSize > 1) {
+                count = uUbxProtocolUint16Decode(pBody + pBlock->countWireOffset);
+            }
+            count = (count >> pBlock->countShift) & pBlock->countMask;
+            if (bodyLength < pBlock->wireOffset + (count * pBlock->wireLength)) {
+                errorCode = (int32_t) U_ERROR_COMMON_TRUNCATED;
+            } else {
+                if (count > pBlock->maxNum) {
+                    count = pBlock->maxNum;
+                }
+                *(pStructChar + pBlock->countStructOffset) = (char) count; // *NOPAD*
+                if (littleEndian && (pBlock->wireLength == pBlock->structLength) &&
+                    fieldsAreVerbatim(pBlock->pField, pBlock->numFields, pBlock->wireLength)) {
+                    // The whole lot can be copied in one go
+                    memcpy(pStructChar + pBlock->structOffset,
+                           pBody + pBlock->wireOffset, count * pBlock->wireLength);
+                } else {
+                    for (size_t x = 0; x < count; x++) {
+                        fieldsDecode(pBlock->pField, pBlock->numFields, littleEndian,
+                                     pBody + pBlock->wireOffset + (x * pBlock->wireLength),
+                                     pBlock->wireLength,
+                                     pStructChar + pBlock->structOffset + (x * pBlock->structLength));
+                    }
+                }
+            }
+        }
+        if ((errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) &&
+            (pMessage->pPostDecode != NULL)) {
+            pMessage->pPostDecode(pBody, bodyLength, pStruct);
+        }
+    }
+
+    return errorCode;
+}
+
+// Find the descriptor for a message ID, NULL if there isn't one.
+static const uGnssDecUbxMessage_t *pMessageFind(const uGnssMessageId_t *pId)
+{
+    const uGnssDecUbxMessage_t *pMessage = NULL;
+
+    for (size_t x = 0; (pMessage == NULL) && (x < sizeof(gIdList) / sizeof(gIdList[0])); x++) {
+        if (uGnssMsgIdIsWanted((uGnssMessageId_t *) pId, (uGnssMessageId_t *) & (gIdList[x]))) {
+            pMessage = &(gMessageList[x]);
+        }
+    }
+
+    return pMessage;
+}
+
+// Check that a buffer contains the header of a UBX message and
+// that the body is all there, returning the message ID and
+// body length.
+static int32_t ubxHeaderCheck(const char *pBuffer, size_t size,
+                              uGnssMessageId_t *pId, size_t *pBodyLength)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_UNKNOWN;
+    const uint8_t *pBufferUint8 = (const uint8_t *) pBuffer; // To avoid problems with signed char compares
+
+    if ((size >= 2) && (*pBufferUint8 == 0xB5) && (*(pBufferUint8 + 1) == 0x62)) {
+        // Likely a UBX message
+        pBufferUint8 += 2;
+        pId->type = U_GNSS_PROTOCOL_UBX;
+        errorCode = (int32_t) U_ERROR_COMMON_TRUNCATED;
+        if (size >= U_UBX_PROTOCOL_HEADER_LENGTH_BYTES) {
+            // Grab the message class and message ID, check the length,
+            // allowing the checksum bytes to be omitted
+            pId->id.ubx = U_GNSS_UBX_MESSAGE(*pBufferUint8, *(pBufferUint8 + 1));
+            pBufferUint8 += 2;
+            *pBodyLength = *pBufferUint8 + ((uint16_t) *(pBufferUint8 + 1) << 8); // *NOPAD*
+            if (size >= *pBodyLength + U_UBX_PROTOCOL_HEADER_LENGTH_BYTES) {
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+    }
+
+    return errorCode;
+}
+
+// Decode a message buffer received from a GNSS device into pDec,
+// allocating memory for the body if pBody is NULL, else using
+// the bodySize bytes at pBody; the user callback is NOT called.
+static void decode(const char *pBuffer, size_t size, uGnssDec_t *pDec,
+                   void *pBody, size_t bodySize)
 {
-    uGnssDec_t *pDec = NULL;
     uint8_t *pBufferUint8 = (uint8_t *) pBuffer; // To avoid problems with signed char compares
-    uGnssDecKnownFunction_t *pFunction = NULL;
+    const uGnssDecUbxMessage_t *pMessage = NULL;
+    size_t bodyLength = 0;
     size_t x;
     size_t y;
 
-    pDec = (uGnssDec_t *) pUPortMalloc(sizeof(uGnssDec_t));
-    if (pDec != NULL) {
-        memset(pDec, 0, sizeof(*pDec));
-        pDec->errorCode = (int32_t) U_ERROR_COMMON_EMPTY;
-        pDec->id.type = U_GNSS_PROTOCOL_UNKNOWN;
-        if ((pBufferUint8 != NULL) && (size > 0)) {
-            // Determine the protocol type/message ID and make
-            // sure the header is sound
-            pDec->errorCode = (int32_t) U_ERROR_COMMON_UNKNOWN;
-            if ((*pBufferUint8 == 0xB5) && (size >= 1) && (*(pBufferUint8 + 1) == 0x62)) {
-                // Likely a UBX message
+    memset(pDec, 0, sizeof(*pDec));
+    pDec->errorCode = (int32_t) U_ERROR_COMMON_EMPTY;
+    pDec->id.type = U_GNSS_PROTOCOL_UNKNOWN;
+    if ((pBufferUint8 != NULL) && (size > 0)) {
+        // Determine the protocol type/message ID and make
+        // sure the header is sound
+        pDec->errorCode = (int32_t) U_ERROR_COMMON_UNKNOWN;
+        if ((*pBufferUint8 == 0xB5) && (size > 1) && (*(pBufferUint8 + 1) == 0x62)) {
+            // Likely a UBX message
+            pDec->errorCode = ubxHeaderCheck(pBuffer, size, &(pDec->id), &bodyLength);
+        } else if (*pBufferUint8 == '$') {
+            // Likely an NMEA message
+            pBufferUint8++;
+            y = size - 1;
+            pDec->id.type = U_GNSS_PROTOCOL_NMEA;
+            pDec->errorCode = (int32_t) U_ERROR_COMMON_TRUNCATED;
+            for (x = 0; (((*pBufferUint8 >= 'A') && (*pBufferUint8 <= 'Z')) ||
+                         ((*pBufferUint8 >= '0') && (*pBufferUint8 <= '9'))) &&
+                 (x < y) && (x < sizeof(pDec->nmea) - 1); x++) {
+                // Looking for up to U_GNSS_NMEA_MESSAGE_MATCH_LENGTH_CHARACTERS
+                // characters in the range 0-9, A-Z, followed by a comma
+                pDec->nmea[x] = *pBufferUint8;
+                pBufferUint8++;
+            }
+            if ((x < y) && (*pBufferUint8 == ',')) {
+                pDec->id.id.pNmea = pDec->nmea;
+                pDec->errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+            // No need to add a terminator since we zeroed the structure to begin with
+        } else if (*pBufferUint8 == 0xD3) {
+            // Likely an RTCM message
+            pBufferUint8++;
+            pDec->id.type = U_GNSS_PROTOCOL_RTCM;
+            pDec->errorCode = (int32_t) U_ERROR_COMMON_TRUNCATED;
+            // Length is only in the first three bits of the first length byte,
+            // the rest must be zero
+            if ((size >= 1 /* D3 */ + 2 /* length */) &&
+                ((*pBufferUint8 & 0xFC) == 0)) {
+                y = ((uint16_t) (*pBufferUint8 & 0x03) << 8) + *(pBufferUint8 + 1);
                 pBufferUint8 += 2;
-                pDec->id.type = U_GNSS_PROTOCOL_UBX;
-                pDec->errorCode = (int32_t) U_ERROR_COMMON_TRUNCATED;
-                if (size >= U_UBX_PROTOCOL_HEADER_LENGTH_BYTES) {
-                    // Grab the message class and message ID, check the length,
-                    // allowing the checksum bytes to be omitted
-                    pDec->id.id.ubx = U_GNSS_UBX_MESSAGE(*pBufferUint8, *(pBufferUint8 + 1));
-                    pBufferUint8 += 2;
-                    y = *pBufferUint8 + ((uint16_t) *(pBufferUint8 + 1) << 8); // *NOPAD*
-                    if (size >= y + U_UBX_PROTOCOL_HEADER_LENGTH_BYTES) {
+                if (size >= 1 /* D3 */ + 2 /* length */ + 2 /* ID */) {
+                    // Grab the ID from the next two bytes
+                    pDec->id.id.rtcm = (*(pBufferUint8 + 1) >> 4) + (uint16_t) (((uint16_t) * pBufferUint8) <<
+                                                                                4); // *NOPAD*
+                    if (size >= 1 /* D3 */ + 2 /* length */ + y /* length includes the message ID */ ) {
+                        // Check the length, allowing the CRC bytes to be omitted
                         pDec->errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
                     }
                 }
-            } else if (*pBufferUint8 == '$') {
-                // Likely an NMEA message
-                pBufferUint8++;
-                y = size - 1;
-                pDec->id.type = U_GNSS_PROTOCOL_NMEA;
-                pDec->errorCode = (int32_t) U_ERROR_COMMON_TRUNCATED;
-                for (x = 0; (((*pBufferUint8 >= 'A') && (*pBufferUint8 <= 'Z')) ||
-                             ((*pBufferUint8 >= '0') && (*pBufferUint8 <= '9'))) &&
-                     (x < y) && (x < sizeof(pDec->nmea) - 1); x++) {
-                    // Looking for up to U_GNSS_NMEA_MESSAGE_MATCH_LENGTH_CHARACTERS
-                    // characters in the range 0-9, A-Z, followed by a comma
-                    pDec->nmea[x] = *pBufferUint8;
-                    pBufferUint8++;
-                }
-                if ((x < y) && (*pBufferUint8 == ',')) {
-                    pDec->id.id.pNmea = pDec->nmea;
-                    pDec->errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+        if (pDec->errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
+            // Got a known protocol, an ID and a valid length, see if we have
+            // a decoder for this message ID
+            pDec->errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            pMessage = pMessageFind(&(pDec->id));
+            if (pMessage != NULL) {
+                // Found a matching decoder, run it
+                pDec->errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+                if (pBody == NULL) {
+                    pDec->pBody = (uGnssDecUnion_t *) pUPortMalloc(pMessage->structSize);
+                } else if (bodySize >= pMessage->structSize) {
+                    pDec->pBody = (uGnssDecUnion_t *) pBody;
                 }
-                // No need to add a terminator since we zeroed the structure to begin with
-            } else if (*pBufferUint8 == 0xD3) {
-                // Likely an RTCM message
-                pBufferUint8++;
-                pDec->id.type = U_GNSS_PROTOCOL_RTCM;
-                pDec->errorCode = (int32_t) U_ERROR_COMMON_TRUNCATED;
-                // Length is only in the first three bits of the first length byte,
-                // the rest must be zero
-                if ((size >= 1 /* D3 */ + 2 /* length */) &&
-                    ((*pBufferUint8 & 0xFC) == 0)) {
-                    y = ((uint16_t) (*pBufferUint8 & 0x03) << 8) + *(pBufferUint8 + 1);
-                    pBufferUint8 += 2;
-                    if (size >= 1 /* D3 */ + 2 /* length */ + 2 /* ID */) {
-                        // Grab the ID from the next two bytes
-                        pDec->id.id.rtcm = (*(pBufferUint8 + 1) >> 4) + (uint16_t) (((uint16_t) * pBufferUint8) <<
-                                                                                    4); // *NOPAD*
-                        if (size >= 1 /* D3 */ + 2 /* length */ + y /* length includes the message ID */ ) {
-                            // Check the length, allowing the CRC bytes to be omitted
-                            pDec->errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                if (pDec->pBody != NULL) {
+                    pDec->errorCode = ubxDecode(pMessage,
+                                                pBuffer + U_UBX_PROTOCOL_HEADER_LENGTH_BYTES,
+                                                bodyLength, pDec->pBody);
+                    if (pDec->errorCode != (int32_t) U_ERROR_COMMON_SUCCESS) {
+                        if (pBody == NULL) {
+                            uPortFree(pDec->pBody);
                         }
+                        pDec->pBody = NULL;
                     }
                 }
             }
-            if (pDec->errorCode == (int32_t) U_ERROR_COMMON_SUCCESS) {
-                // Got a known protocol, an ID and a valid length, see if we have
-                // a decoder for this message ID
-                pDec->errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
-                for (x = 0; (pFunction == NULL) && (x < sizeof(gIdList) / sizeof(gIdList[0])); x++) {
-                    if (uGnssMsgIdIsWanted(&(pDec->id), (uGnssMessageId_t *) & (gIdList[x]))) {
-                        pFunction = gpFunctionList[x];
+        }
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// Decode a message buffer received from a GNSS device.
+uGnssDec_t *pUGnssDecAlloc(const char *pBuffer, size_t size)
+{
+    uGnssDec_t *pDec = NULL;
+
+    pDec = (uGnssDec_t *) pUPortMalloc(sizeof(uGnssDec_t));
+    if (pDec != NULL) {
+        decode(pBuffer, size, pDec, NULL, 0);
+        if ((pDec->errorCode != (int32_t) U_ERROR_COMMON_SUCCESS) &&
+            (pDec->errorCode != (int32_t) U_ERROR_COMMON_EMPTY) &&
+            (gpCallback != NULL)) {
+            // Couldn't decode the message: let the user callback try
+            pDec->errorCode = gpCallback(&(pDec->id), pBuffer, size, &(pDec->pBody), gpCallbackParam);
+        }
+    }
+
+    return pDec;
+}
+
+// Decode a message buffer received from a GNSS device into storage
+// provided by the caller.
+int32_t uGnssDecDecode(const char *pBuffer, size_t size, uGnssDec_t *pDec,
+                       void *pBody, size_t bodySize)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+
+    if ((pDec != NULL) && (pBody != NULL)) {
+        decode(pBuffer, size, pDec, pBody, bodySize);
+        errorCode = pDec->errorCode;
+    }
+
+    return errorCode;
+}
+
+// Decode a UBX message into a structure provided by the caller.
+int32_t uGnssDecUbxToStruct(const char *pBuffer, size_t size,
+                            void *pStruct, size_t structSize)
+{
+    int32_t errorCodeOrId = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssMessageId_t id = {.type = U_GNSS_PROTOCOL_UNKNOWN};
+    const uGnssDecUbxMessage_t *pMessage;
+    size_t bodyLength = 0;
+
+    if ((pBuffer != NULL) && (pStruct != NULL)) {
+        errorCodeOrId = ubxHeaderCheck(pBuffer, size, &id, &bodyLength);
+        if (errorCodeOrId == (int32_t) U_ERROR_COMMON_SUCCESS) {
+            errorCodeOrId = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+            pMessage = pMessageFind(&id);
+            if (pMessage != NULL) {
+                errorCodeOrId = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+                if (structSize >= pMessage->structSize) {
+                    errorCodeOrId = ubxDecode(pMessage,
+                                              pBuffer + U_UBX_PROTOCOL_HEADER_LENGTH_BYTES,
+                                              bodyLength, pStruct);
+                    if (errorCodeOrId == (int32_t) U_ERROR_COMMON_SUCCESS) {
+                        errorCodeOrId = id.id.ubx;
                     }
                 }
-                if (pFunction != NULL) {
-                    // Found a matching decoder, run it
-                    pDec->errorCode = pFunction(pBuffer, size, &(pDec->pBody));
-                }
-            }
-            if ((pDec->errorCode != (int32_t) U_ERROR_COMMON_SUCCESS) &&
-                (gpCallback != NULL)) {
-                // Couldn't decode the message: let the user callback try
-                pDec->errorCode = gpCallback(&(pDec->id), pBuffer, size, &(pDec->pBody), gpCallbackParam);
             }
         }
     }
 
-    return pDec;
+    return errorCodeOrId;
 }
 
 // Free the memory returned by pUGnssDecAlloc().
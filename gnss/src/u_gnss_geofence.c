@@ -523,4 +523,41 @@ uGeofencePositionState_t uGnssGeofencePosition(uDeviceHandle_t gnssHandle,
     return positionState;
 }
 
+// Get the number of geofence tests performed and avoided.
+int32_t uGnssGeofenceGetCounts(uDeviceHandle_t gnssHandle,
+                               uint32_t *pNumTested,
+                               uint32_t *pNumSkipped,
+                               bool reset)
+{
+    int32_t errorCode;
+
+#ifdef U_CFG_GEOFENCE
+    uGnssPrivateInstance_t *pInstance;
+
+    errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if (pInstance != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            uGeofenceContextGetCounts((uGeofenceContext_t *) pInstance->pFenceContext,
+                                      pNumTested, pNumSkipped, reset);
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+    }
+#else
+    errorCode = (int32_t) U_ERROR_COMMON_NOT_COMPILED;
+    (void) gnssHandle;
+    (void) pNumTested;
+    (void) pNumSkipped;
+    (void) reset;
+#endif
+
+    return errorCode;
+}
+
 // End of file
@@ -65,6 +65,11 @@
  */
 #define U_GNSS_INFO_MESSAGE_BODY_LENGTH_UBX_MON_COMMS (8 + (40 * U_GNSS_PORT_MAX_NUM))
 
+/** The protocol ID that UBX-MON-COMMS uses for SPARTN, which is not
+ * the same as #U_GNSS_PROTOCOL_SPARTN.
+ */
+#define U_GNSS_INFO_UBX_MON_COMMS_PROTOCOL_ID_SPARTN 6
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -380,6 +385,13 @@ int32_t uGnssInfoGetCommunicationStats(uDeviceHandle_t gnssHandle,
                                         }
                                         for (size_t x = 0; x < 4; x++) {
                                             protocolId = *(pMessage + 4 + x);
+                                            // rxNumMessages is indexed by uGnssProtocol_t,
+                                            // which has its own value for SPARTN
+                                            if (protocolId == U_GNSS_INFO_UBX_MON_COMMS_PROTOCOL_ID_SPARTN) {
+                                                protocolId = (int32_t) U_GNSS_PROTOCOL_SPARTN;
+                                            } else if (protocolId == (int32_t) U_GNSS_PROTOCOL_SPARTN) {
+                                                protocolId = -1;
+                                            }
                                             if ((protocolId >= 0) &&
                                                 (protocolId < sizeof(pStats->rxNumMessages) / sizeof(pStats->rxNumMessages[0]))) {
                                                 pStats->rxNumMessages[protocolId] = uUbxProtocolUint16Decode(pMessage + 28 + offset + (x * 2));
@@ -136,6 +136,40 @@
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Update the latency statistics of the message receive task.
+static void latencyUpdate(uGnssPrivateMsgReceive_t *pMsgReceive,
+                          int32_t arrivalTimeMs)
+{
+    int32_t latencyMs = uPortGetTickTimeMs() - arrivalTimeMs;
+
+    if (latencyMs < 0) {
+        latencyMs = 0;
+    }
+    if ((pMsgReceive->latencyCount == 0) ||
+        (latencyMs < pMsgReceive->latencyMinMs)) {
+        pMsgReceive->latencyMinMs = latencyMs;
+    }
+    if (latencyMs > pMsgReceive->latencyMaxMs) {
+        pMsgReceive->latencyMaxMs = latencyMs;
+    }
+    pMsgReceive->latencyTotalMs += latencyMs;
+    pMsgReceive->latencyCount++;
+}
+
+// Return true if any of the readers in the list has asked for
+// SPARTN messages.
+static bool readersWantSpartn(const uGnssPrivateMsgReader_t *pReader)
+{
+    bool spartn = false;
+
+    while ((pReader != NULL) && !spartn) {
+        spartn = (pReader->privateMessageId.type == U_GNSS_PROTOCOL_SPARTN);
+        pReader = pReader->pNext;
+    }
+
+    return spartn;
+}
+
 // Task that runs the non-blocking message receive.
 static void msgReceiveTask(void *pParam)
 {
@@ -146,10 +180,12 @@ static void msgReceiveTask(void *pParam)
     int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_UNKNOWN;
     int32_t receiveSize;
     int32_t yieldTimeMs;
+    int32_t arrivalTimeMs = -1;
     size_t discardSize = 0;
     uGnssMessageId_t messageId;
     uGnssPrivateMessageId_t privateMessageId;
     char nmeaId[U_GNSS_NMEA_MESSAGE_MATCH_LENGTH_CHARACTERS + 1];
+    uRingBufferSpan_t spans[U_RING_BUFFER_NUM_SPANS];
 
     U_PORT_MUTEX_LOCK(pMsgReceive->taskRunningMutexHandle);
 
@@ -164,8 +200,20 @@ static void msgReceiveTask(void *pParam)
         // Note that this does NOT lock gUGnssPrivateMutex: it doesn't need to,
         // provided this task is brought up and torn down in an organised way
 
+        // Take the arrival time of any data that the transport
+        // has told us about, unless we're still waiting on the
+        // remainder of a message that arrived earlier
+        if (arrivalTimeMs < 0) {
+            arrivalTimeMs = pMsgReceive->dataArrivalTimeMs;
+        }
+        pMsgReceive->dataArrivalTimeMs = -1;
         // Pull stuff into the ring buffer
         receiveSize = uGnssPrivateStreamFillRingBuffer(pInstance, 0, 0);
+        if ((receiveSize > 0) && (arrivalTimeMs < 0)) {
+            // No data event, we must be polling: the best we
+            // can do is the time the data was read
+            arrivalTimeMs = uPortGetTickTimeMs();
+        }
         // Deal with any discard from a previous run around this loop
         discardSize -= uRingBufferReadHandle(&(pInstance->ringBuffer),
                                              pMsgReceive->ringBufferReadHandle,
@@ -178,10 +226,12 @@ static void msgReceiveTask(void *pParam)
             // for as long as we're still finding messages in it
             while (errorCodeOrLength > 0) {
                 privateMessageId.type = U_GNSS_PROTOCOL_ALL;
+                pMsgReceive->scanner.spartn = pMsgReceive->spartn;
                 // Attempt to decode a message of any type from the ring buffer
                 errorCodeOrLength = uGnssPrivateStreamDecodeRingBuffer(&(pInstance->ringBuffer),
                                                                        pMsgReceive->ringBufferReadHandle,
-                                                                       &privateMessageId);
+                                                                       &privateMessageId,
+                                                                       &(pMsgReceive->scanner));
                 if ((errorCodeOrLength > 0) || (errorCodeOrLength == (int32_t) U_GNSS_ERROR_NACK)) {
                     // Remember how long the message is
                     pMsgReceive->msgBytesLeftToRead = 0;
@@ -195,15 +245,32 @@ static void msgReceiveTask(void *pParam)
 
                         U_PORT_MUTEX_LOCK(pMsgReceive->readerMutexHandle);
 
+                        if (arrivalTimeMs >= 0) {
+                            latencyUpdate(pMsgReceive, arrivalTimeMs);
+                        }
                         pReader = pMsgReceive->pReaderList;
                         while (pReader != NULL) {
                             if (uGnssPrivateMessageIdIsWanted(&privateMessageId,
                                                               &(pReader->privateMessageId))) {
                                 // This reader is interested, call the callback
-                                ((uGnssMsgReceiveCallback_t) pReader->pCallback)(pInstance->gnssHandle,
-                                                                                 &messageId,
-                                                                                 errorCodeOrLength,
-                                                                                 pReader->pCallbackParam);
+                                if (pReader->spansNotCopy) {
+                                    // Point the reader at what is left of the message
+                                    // in place; an earlier reader may have extracted it
+                                    uRingBufferPeekSpansHandle(&(pInstance->ringBuffer),
+                                                               pMsgReceive->ringBufferReadHandle,
+                                                               spans, pMsgReceive->msgBytesLeftToRead,
+                                                               0);
+                                    ((uGnssMsgReceiveSpanCallback_t) pReader->pCallback)(pInstance->gnssHandle,
+                                                                                         &messageId,
+                                                                                         errorCodeOrLength,
+                                                                                         spans,
+                                                                                         pReader->pCallbackParam);
+                                } else {
+                                    ((uGnssMsgReceiveCallback_t) pReader->pCallback)(pInstance->gnssHandle,
+                                                                                     &messageId,
+                                                                                     errorCodeOrLength,
+                                                                                     pReader->pCallbackParam);
+                                }
                             }
                             // Next!
                             pReader = pReader->pNext;
@@ -219,15 +286,37 @@ static void msgReceiveTask(void *pParam)
                 }
             }
         }
+        if ((errorCodeOrLength != (int32_t) U_ERROR_COMMON_TIMEOUT) ||
+            (uRingBufferDataSizeHandle(&(pInstance->ringBuffer),
+                                       pMsgReceive->ringBufferReadHandle) == 0)) {
+            // Not part-way through a message (a timeout from the
+            // decoder may just mean that the ring buffer is empty),
+            // so the next data to arrive starts the clock afresh
+            arrivalTimeMs = -1;
+        }
 
-        // Relax to let others in; relax for twice as long if we last
-        // received nothing and aren't desperately seeking more data,
-        // in order to allow some data to build up
-        yieldTimeMs = U_GNSS_MSG_TASK_STACK_YIELD_TIME_MS;
-        if ((receiveSize == 0) && (errorCodeOrLength != (int32_t) U_ERROR_COMMON_TIMEOUT))  {
-            yieldTimeMs *= 2;
+        if (pMsgReceive->dataEventSemaphoreHandle != NULL) {
+            // Event-driven: unless we've just filled the temporary
+            // buffer, in which case there is likely more to read,
+            // wait for the transport to tell us that data has arrived
+            // (a guard time ensures we can't wait for ever on a lost
+            // event) and then allow a little more to arrive
+            if ((receiveSize < U_GNSS_MSG_TEMPORARY_BUFFER_LENGTH_BYTES) &&
+                (uPortSemaphoreTryTake(pMsgReceive->dataEventSemaphoreHandle,
+                                       U_GNSS_MSG_RECEIVE_EVENT_GUARD_TIME_MS) == 0) &&
+                (pInstance->msgReceiveCoalesceMs > 0)) {
+                uPortTaskBlock(pInstance->msgReceiveCoalesceMs);
+            }
+        } else {
+            // Relax to let others in; relax for twice as long if we last
+            // received nothing and aren't desperately seeking more data,
+            // in order to allow some data to build up
+            yieldTimeMs = U_GNSS_MSG_TASK_STACK_YIELD_TIME_MS;
+            if ((receiveSize == 0) && (errorCodeOrLength != (int32_t) U_ERROR_COMMON_TIMEOUT))  {
+                yieldTimeMs *= 2;
+            }
+            uPortTaskBlock(yieldTimeMs);
         }
-        uPortTaskBlock(yieldTimeMs);
     }
 
     // Now we can unlock our ring buffer read handle.  Phew.
@@ -278,15 +367,13 @@ int32_t msgReceiveCallbackRead(uDeviceHandle_t gnssHandle,
     return errorCodeOrLength;
 }
 
-/* ----------------------------------------------------------------
- * PUBLIC FUNCTIONS THAT ARE PRIVATE TO GNSS
- * -------------------------------------------------------------- */
-
-// Start monitoring the output of the GNSS chip for a message.
-int32_t uGnssMsgPrivateReceiveStart(uGnssPrivateInstance_t *pInstance,
-                                    const uGnssPrivateMessageId_t *pPrivateMessageId,
-                                    uGnssMsgReceiveCallback_t pCallback,
-                                    void *pCallbackParam)
+// Start monitoring the output of the GNSS chip for a message,
+// pCallback being a uGnssMsgReceiveSpanCallback_t if spansNotCopy
+// is true, else a uGnssMsgReceiveCallback_t.
+static int32_t receiveStart(uGnssPrivateInstance_t *pInstance,
+                            const uGnssPrivateMessageId_t *pPrivateMessageId,
+                            void *pCallback, bool spansNotCopy,
+                            void *pCallbackParam)
 {
     int32_t errorCodeOrHandle = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
     uGnssPrivateMsgReceive_t *pMsgReceive;
@@ -325,6 +412,16 @@ int32_t uGnssMsgPrivateReceiveStart(uGnssPrivateInstance_t *pInstance,
                                     // Create the mutex for task running status
                                     errorCodeOrHandle = uPortMutexCreate(&(pMsgReceive->taskRunningMutexHandle));
                                     if (errorCodeOrHandle == 0) {
+                                        pMsgReceive->dataArrivalTimeMs = -1;
+                                        if (pInstance->msgReceiveEventDriven &&
+                                            (uPortSemaphoreCreate(&(pMsgReceive->dataEventSemaphoreHandle),
+                                                                  0, 1) == 0) &&
+                                            (uGnssPrivateStreamDataEventStart(pInstance) != 0)) {
+                                            // The transport can't tell us when data has
+                                            // arrived, the task will have to poll
+                                            uPortSemaphoreDelete(pMsgReceive->dataEventSemaphoreHandle);
+                                            pMsgReceive->dataEventSemaphoreHandle = NULL;
+                                        }
                                         //... and then the task
                                         errorCodeOrHandle = uPortTaskCreate(msgReceiveTask,
                                                                             pTaskName,
@@ -345,6 +442,10 @@ int32_t uGnssMsgPrivateReceiveStart(uGnssPrivateInstance_t *pInstance,
                         }
                         if (errorCodeOrHandle != 0) {
                             // Tidy up if we couldn't get OS resources
+                            if (pMsgReceive->dataEventSemaphoreHandle != NULL) {
+                                uGnssPrivateStreamDataEventStop(pInstance);
+                                uPortSemaphoreDelete(pMsgReceive->dataEventSemaphoreHandle);
+                            }
                             if (pMsgReceive->taskRunningMutexHandle != NULL) {
                                 uPortMutexDelete(pMsgReceive->taskRunningMutexHandle);
                             }
@@ -381,13 +482,17 @@ int32_t uGnssMsgPrivateReceiveStart(uGnssPrivateInstance_t *pInstance,
             pReader->handle = pInstance->pMsgReceive->nextHandle;
             pInstance->pMsgReceive->nextHandle++;
             pReader->privateMessageId = *pPrivateMessageId;
-            pReader->pCallback = (void *) pCallback;
+            pReader->pCallback = pCallback;
+            pReader->spansNotCopy = spansNotCopy;
             pReader->pCallbackParam = pCallbackParam;
             pReader->pNext = pInstance->pMsgReceive->pReaderList;
 
             U_PORT_MUTEX_LOCK(pInstance->pMsgReceive->readerMutexHandle);
 
             pInstance->pMsgReceive->pReaderList = pReader;
+            // The message receive task hunts for SPARTN messages
+            // only while a reader is asking for them
+            pInstance->pMsgReceive->spartn = readersWantSpartn(pReader);
 
             U_PORT_MUTEX_UNLOCK(pInstance->pMsgReceive->readerMutexHandle);
 
@@ -399,6 +504,20 @@ int32_t uGnssMsgPrivateReceiveStart(uGnssPrivateInstance_t *pInstance,
     return errorCodeOrHandle;
 }
 
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS THAT ARE PRIVATE TO GNSS
+ * -------------------------------------------------------------- */
+
+// Start monitoring the output of the GNSS chip for a message.
+int32_t uGnssMsgPrivateReceiveStart(uGnssPrivateInstance_t *pInstance,
+                                    const uGnssPrivateMessageId_t *pPrivateMessageId,
+                                    uGnssMsgReceiveCallback_t pCallback,
+                                    void *pCallbackParam)
+{
+    return receiveStart(pInstance, pPrivateMessageId, (void *) pCallback,
+                        false, pCallbackParam);
+}
+
 // Stop monitoring the output of the GNSS chip for a message.
 int32_t uGnssMsgPrivateReceiveStop(uGnssPrivateInstance_t *pInstance,
                                    int32_t asyncHandle)
@@ -433,6 +552,7 @@ int32_t uGnssMsgPrivateReceiveStop(uGnssPrivateInstance_t *pInstance,
                     pCurrent = pPrev->pNext;
                 }
             }
+            pMsgReceive->spartn = readersWantSpartn(pMsgReceive->pReaderList);
 
             U_PORT_MUTEX_UNLOCK(pMsgReceive->readerMutexHandle);
 
@@ -658,6 +778,36 @@ int32_t uGnssMsgReceiveStart(uDeviceHandle_t gnssHandle,
     return errorCodeOrHandle;
 }
 
+// Monitor the output of the GNSS chip for a message, async
+// version where the message is passed to the callback in place.
+int32_t uGnssMsgReceiveStartSpans(uDeviceHandle_t gnssHandle,
+                                  const uGnssMessageId_t *pMessageId,
+                                  uGnssMsgReceiveSpanCallback_t pCallback,
+                                  void *pCallbackParam)
+{
+    int32_t errorCodeOrHandle = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    uGnssPrivateMessageId_t privateMessageId;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        errorCodeOrHandle = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if ((pInstance != NULL) &&
+            (uGnssPrivateMessageIdToPrivate(pMessageId, &privateMessageId) == 0)) {
+            errorCodeOrHandle = receiveStart(pInstance, &privateMessageId,
+                                             (void *) pCallback, true,
+                                             pCallbackParam);
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+    }
+
+    return errorCodeOrHandle;
+}
+
 // Read a message from the ring buffer into a user's buffer.
 // This function does NOT lock gUGnssPrivateMutex in order
 // that it can be called from pCallback; this is fine since
@@ -748,6 +898,104 @@ int32_t uGnssMsgReceiveStackMinFree(uDeviceHandle_t gnssHandle)
     return errorCodeOrStackMinFree;
 }
 
+// Set whether the message receive task is event-driven.
+int32_t uGnssMsgReceiveSetEventDriven(uDeviceHandle_t gnssHandle,
+                                      bool onNotOff, int32_t coalesceMs)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if (pInstance != NULL) {
+            errorCode = (int32_t) U_ERROR_COMMON_BUSY;
+            if (pInstance->pMsgReceive == NULL) {
+                if (coalesceMs < 0) {
+                    coalesceMs = U_GNSS_MSG_RECEIVE_EVENT_COALESCE_MS;
+                }
+                pInstance->msgReceiveEventDriven = onNotOff;
+                pInstance->msgReceiveCoalesceMs = coalesceMs;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+    }
+
+    return errorCode;
+}
+
+// Get whether the message receive task is event-driven.
+bool uGnssMsgReceiveGetEventDriven(uDeviceHandle_t gnssHandle,
+                                   int32_t *pCoalesceMs)
+{
+    bool isEventDriven = false;
+    uGnssPrivateInstance_t *pInstance;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if (pInstance != NULL) {
+            isEventDriven = pInstance->msgReceiveEventDriven;
+            if (pCoalesceMs != NULL) {
+                *pCoalesceMs = pInstance->msgReceiveCoalesceMs;
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+    }
+
+    return isEventDriven;
+}
+
+// Get the latency statistics of the message receive task.
+int32_t uGnssMsgReceiveStatLatency(uDeviceHandle_t gnssHandle,
+                                   uGnssMsgReceiveLatency_t *pLatency)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uGnssPrivateInstance_t *pInstance;
+    uGnssPrivateMsgReceive_t *pMsgReceive;
+
+    if (gUGnssPrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUGnssPrivateMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pInstance = pUGnssPrivateGetInstance(gnssHandle);
+        if ((pInstance != NULL) && (pInstance->pMsgReceive != NULL) &&
+            (pLatency != NULL)) {
+            pMsgReceive = pInstance->pMsgReceive;
+
+            // Lock the reader mutex as the latency is updated under it
+            U_PORT_MUTEX_LOCK(pMsgReceive->readerMutexHandle);
+
+            memset(pLatency, 0, sizeof(*pLatency));
+            pLatency->eventDriven = (pMsgReceive->dataEventSemaphoreHandle != NULL);
+            pLatency->count = pMsgReceive->latencyCount;
+            if (pMsgReceive->latencyCount > 0) {
+                pLatency->minMs = pMsgReceive->latencyMinMs;
+                pLatency->maxMs = pMsgReceive->latencyMaxMs;
+                pLatency->averageMs = (int32_t) (pMsgReceive->latencyTotalMs /
+                                                 (int64_t) pMsgReceive->latencyCount);
+            }
+
+            U_PORT_MUTEX_UNLOCK(pMsgReceive->readerMutexHandle);
+
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUGnssPrivateMutex);
+    }
+
+    return errorCode;
+}
+
 // Count of bytes lost for the non-blocking message receive handler.
 size_t uGnssMsgReceiveStatReadLoss(uDeviceHandle_t gnssHandle)
 {
@@ -37,6 +37,7 @@
 #include "u_cfg_os_platform_specific.h"
 #include "u_cfg_sw.h"
 
+#include "u_compiler.h" // U_INLINE
 #include "u_error_common.h"
 
 #include "u_assert.h"
@@ -52,6 +53,10 @@
 #include "u_timeout.h"
 
 #include "u_hex_bin_convert.h"
+#include "u_checksum.h"
+#include "u_crc.h"
+
+#include "u_spartn.h"
 
 #include "u_at_client.h"
 
@@ -305,6 +310,19 @@ static bool rtcmIdMatch(uint16_t rtcmIdActual, uint16_t rtcmIdWanted)
     return (rtcmIdActual == rtcmIdWanted) || (rtcmIdWanted == U_GNSS_RTCM_MESSAGE_ID_ALL);
 }
 
+// Match a SPARTN ID with the wanted SPARTN ID, allowing ALL wildcards 0xFF.
+static bool spartnIdMatch(uint16_t spartnIdActual, uint16_t spartnIdWanted)
+{
+    if ((spartnIdWanted & U_GNSS_SPARTN_MESSAGE_SUB_TYPE_ALL) == U_GNSS_SPARTN_MESSAGE_SUB_TYPE_ALL) {
+        spartnIdActual |= U_GNSS_SPARTN_MESSAGE_SUB_TYPE_ALL;
+    }
+    if ((spartnIdWanted & (U_GNSS_SPARTN_MESSAGE_TYPE_ALL << 8)) ==
+        (U_GNSS_SPARTN_MESSAGE_TYPE_ALL << 8)) {
+        spartnIdActual |= (U_GNSS_SPARTN_MESSAGE_TYPE_ALL << 8);
+    }
+    return spartnIdActual == spartnIdWanted;
+}
+
 #ifdef U_GNSS_PRIVATE_DEBUG_PARSING
 // Print out a message ID, only used when debugging message parsing.
 static void printId(uGnssPrivateMessageId_t *pId)
@@ -315,6 +333,8 @@ static void printId(uGnssPrivateMessageId_t *pId)
         uPortLog("NMEA %s", pId->id.nmea);
     } else if (pId->type == U_GNSS_PROTOCOL_RTCM) {
         uPortLog("RTCM %d", pId->id.rtcm);
+    } else if (pId->type == U_GNSS_PROTOCOL_SPARTN) {
+        uPortLog("SPARTN %d/%d", pId->id.spartn >> 8, pId->id.spartn & 0xFF);
     } else if (pId->type == U_GNSS_PROTOCOL_UNKNOWN) {
         uPortLog("UNKNOWN");
     } else {
@@ -758,258 +778,488 @@ static int32_t sendReceiveUbxMessage(uGnssPrivateInstance_t *pInstance,
 }
 
 /* ----------------------------------------------------------------
- * STATIC FUNCTIONS: MESSAGE PARSERS
+ * STATIC FUNCTIONS: MESSAGE SCANNER
  * -------------------------------------------------------------- */
 
-/** UBX Parser function.
- *
- * @param parseHandle    the parse handle of the ring buffer to read from.
- * @param[in] pUserParam the user parameter passed to uRingBufferParseHandle().
- * @return               negative error or success code.
- */
-static int32_t parseUbx(uParseHandle_t parseHandle, void *pUserParam)
+// Add a byte to a CRC-24Q.
+static U_INLINE uint32_t crc24q(uint32_t crc, uint8_t by)
 {
-    uGnssPrivateMessageId_t *pMsgId = (uGnssPrivateMessageId_t *) pUserParam;
-    uint8_t by = 0;
-    if (!uRingBufferGetByteUnprotected(parseHandle, &by)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if (0xB5 != by) {
-        return U_ERROR_COMMON_NOT_FOUND;    // = µ, 0xB5
-    }
-    if (!uRingBufferGetByteUnprotected(parseHandle, &by)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if (0x62 != by) {
-        return U_ERROR_COMMON_NOT_FOUND;    // = b
-    }
-    if (4 > uRingBufferBytesAvailableUnprotected(parseHandle)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    uint8_t ckb = 0;
-    uint8_t cka = 0;
-    uint8_t cls, id;
-    uRingBufferGetByteUnprotected(parseHandle, &cls); // cls
-    cka += cls;
-    ckb += cka;
-    uRingBufferGetByteUnprotected(parseHandle, &id); // id
-    cka += id;
-    ckb += cka;
-    pMsgId->id.ubx = (uint16_t) ((((uint16_t) cls) << 8) + id);
-    uRingBufferGetByteUnprotected(parseHandle, &by); // len low
-    cka += by;
-    ckb += cka;
-    uint16_t l = by;
-    uRingBufferGetByteUnprotected(parseHandle, &by); // len high
-    cka += by;
-    ckb += cka;
-    l += (((uint16_t) by) << 8);
-    if (l > uRingBufferBytesAvailableUnprotected(parseHandle)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    while (l --) {
-        uRingBufferGetByteUnprotected(parseHandle, &by);
-        cka += by;
-        ckb += cka;
-    }
-    cka = cka & 0xFF;
-    ckb = ckb & 0xFF;
-    if (!uRingBufferGetByteUnprotected(parseHandle, &by)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if (by != cka) {
-        return U_ERROR_COMMON_NOT_FOUND;
-    }
-    if (!uRingBufferGetByteUnprotected(parseHandle, &by)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if (by != ckb) {
-        return U_ERROR_COMMON_NOT_FOUND;
-    }
-    // We can only claim this as a UBX-format message if
-    // there was nothing that needed discarding first.
-    if (uRingBufferBytesDiscardUnprotected(parseHandle) == 0) {
-        pMsgId->type = U_GNSS_PROTOCOL_UBX;
-    }
-    return U_ERROR_COMMON_SUCCESS;
+    return uCrc24q(crc, (const char *) &by, 1);
 }
 
-/** NMEA Parser function.
- *
- * @param parseHandle    the parse handle of the ring buffer to read from.
- * @param[in] pUserParam the user parameter passed to uRingBufferParseHandle().
- * @return               negative error or success code.
- */
-static int32_t parseNmea(uParseHandle_t parseHandle, void *pUserParam)
+// Add a byte to the running UBX checksum, which keeps CK_A in the
+// least significant byte and CK_B in the next byte up.
+static U_INLINE uint32_t ubxChecksum(uint32_t checksum, uint8_t by)
 {
-    uGnssPrivateMessageId_t *pMsgId = (uGnssPrivateMessageId_t *) pUserParam;
-    char ch = 0;
-    const char *hex = "0123456789ABCDEF";
-    if (!uRingBufferGetByteUnprotected(parseHandle, &ch)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if ('$' != ch) {
-        return U_ERROR_COMMON_NOT_FOUND;
-    }
-    char crc = 0;
-    int i = 0;
-    while (uRingBufferGetByteUnprotected(parseHandle, &ch)) {
-        crc ^= ch;
-        if (',' == ch) {
+    uint8_t ckA = (uint8_t) checksum;
+    uint8_t ckB = (uint8_t) (checksum >> 8);
+
+    ckA += by;
+    ckB += ckA;
+
+    return ((uint32_t) ckB << 8) | ckA;
+}
+
+// Add data to the message CRC of a SPARTN message, the type of
+// which is given by the message CRC type field (TF005) of the
+// header held by the scanner.
+static uint32_t spartnCrc(const uGnssPrivateScanner_t *pScanner,
+                          uint32_t crc, const char *pData, size_t size)
+{
+    switch ((((uint8_t) pScanner->spartnHeader[3]) >> 4) & 0x03) {
+        case 0:
+            crc = uCrc8((uint8_t) crc, pData, size);
+            break;
+        case 1:
+            crc = uCrc16((uint16_t) crc, pData, size);
+            break;
+        case 2:
+            crc = uCrc24q(crc, pData, size);
+            break;
+        default:
+            crc = uCrc32(crc, pData, size);
             break;
-        }
-        if (i >= U_GNSS_NMEA_MESSAGE_MATCH_LENGTH_CHARACTERS) {
-            return U_ERROR_COMMON_NOT_FOUND;
-        }
-        if (('0' > ch) || ('Z' < ch) || (('9' < ch) && ('A' > ch))) {
-            return U_ERROR_COMMON_NOT_FOUND;    // A-Z, 0-9
-        }
-        pMsgId->id.nmea[i++] = ch;
     }
-    pMsgId->id.nmea[i] = '\0';
-    while (uRingBufferGetByteUnprotected(parseHandle, &ch)) {
-        if ((' ' > ch) || ('~' < ch)) {
-            return U_ERROR_COMMON_NOT_FOUND;    // not in printable range 32 - 126
+
+    return crc;
+}
+
+// Start scanning what looks like the first byte of a message.
+static void scanStart(uGnssPrivateScanner_t *pScanner, uint8_t by,
+                      size_t position)
+{
+    memset(&(pScanner->messageId), 0, sizeof(pScanner->messageId));
+    pScanner->messageId.type = U_GNSS_PROTOCOL_UNKNOWN;
+    pScanner->messageStart = position;
+    pScanner->count = 0;
+    pScanner->checksum = 0;
+    pScanner->length = 0;
+    switch (by) {
+        case 0xB5: // = µ
+            pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_UBX_SYNC_2;
+            break;
+        case '$':
+            pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_NMEA_ID;
+            break;
+        case 0xD3:
+            // CRC is over the entire message, 0xD3 included
+            pScanner->checksum = crc24q(0, by);
+            pScanner->count = 2;
+            pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_RTCM_HEADER;
+            break;
+        case 0x73:
+            if (pScanner->spartn) {
+                pScanner->spartnHeader[0] = (char) by;
+                pScanner->count = 1;
+                pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_SPARTN_HEADER;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// The scanner function handed to uRingBufferScanHandle(): this runs
+// the UBX/NMEA/RTCM/SPARTN state machine over a span of ring buffer data,
+// checksumming whole runs of message body at a time.  It stops
+// when it has found a complete message or when what looked like a
+// message turns out not to be one and the place to start hunting
+// again is not in this span.
+static size_t scan(const char *pData, size_t size, void *pUserParam)
+{
+    uGnssPrivateScanner_t *pScanner = (uGnssPrivateScanner_t *) pUserParam;
+    const uint8_t *pStart = (const uint8_t *) pData;
+    const uint8_t *pEnd = pStart + size;
+    const uint8_t *p = pStart;
+    const uint8_t *pRun;
+    const char *pHex = "0123456789ABCDEF";
+    size_t position = pScanner->scanned;
+    const char *pMessage;
+    int32_t messageLength;
+    size_t x;
+    uint8_t by;
+
+    while ((p < pEnd) && (pScanner->state != U_GNSS_PRIVATE_SCAN_STATE_COMPLETE) &&
+           (pScanner->state != U_GNSS_PRIVATE_SCAN_STATE_FAILED)) {
+        by = *p;
+        switch (pScanner->state) {
+            case U_GNSS_PRIVATE_SCAN_STATE_HUNT:
+                while ((p < pEnd) && (*p != 0xB5) && (*p != '$') && (*p != 0xD3) &&
+                       ((*p != 0x73) || !pScanner->spartn)) {
+                    p++;
+                }
+                if (p < pEnd) {
+                    scanStart(pScanner, *p, position + (p - pStart));
+                    p++;
+                }
+                break;
+            case U_GNSS_PRIVATE_SCAN_STATE_UBX_SYNC_2:
+                if (by == 0x62) { // = b
+                    pScanner->count = 4;
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_UBX_HEADER;
+                    p++;
+                } else {
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_FAILED;
+                }
+                break;
+            case U_GNSS_PRIVATE_SCAN_STATE_UBX_HEADER:
+                pScanner->checksum = ubxChecksum(pScanner->checksum, by);
+                switch (pScanner->count) {
+                    case 4: // Class
+                        pScanner->messageId.id.ubx = (uint16_t) (((uint16_t) by) << 8);
+                        break;
+                    case 3: // ID
+                        pScanner->messageId.id.ubx |= by;
+                        break;
+                    case 2: // Length low
+                        pScanner->length = by;
+                        break;
+                    default: // Length high
+                        pScanner->length |= (uint16_t) (((uint16_t) by) << 8);
+                        break;
+                }
+                pScanner->count--;
+                p++;
+                if (pScanner->count == 0) {
+                    pScanner->count = pScanner->length;
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_UBX_BODY;
+                }
+                break;
+            case U_GNSS_PRIVATE_SCAN_STATE_UBX_BODY:
+                x = pEnd - p;
+                if (x > pScanner->count) {
+                    x = pScanner->count;
+                }
+                pScanner->count -= x;
+                pScanner->checksum = uChecksumFletcher8((uint16_t) pScanner->checksum,
+                                                        (const char *) p, x);
+                p += x;
+                if (pScanner->count == 0) {
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_UBX_CK_A;
+                }
+                break;
+            case U_GNSS_PRIVATE_SCAN_STATE_UBX_CK_A:
+                pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_FAILED;
+                if (by == (uint8_t) pScanner->checksum) {
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_UBX_CK_B;
+                    p++;
+                }
+                break;
+            case U_GNSS_PRIVATE_SCAN_STATE_UBX_CK_B:
+                pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_FAILED;
+                if (by == (uint8_t) (pScanner->checksum >> 8)) {
+                    pScanner->messageId.type = U_GNSS_PROTOCOL_UBX;
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_COMPLETE;
+                    p++;
+                }
+                break;
+            case U_GNSS_PRIVATE_SCAN_STATE_NMEA_ID:
+                pScanner->checksum ^= by;
+                if (by == ',') {
+                    pScanner->messageId.id.nmea[pScanner->count] = '\0';
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_NMEA_BODY;
+                    p++;
+                } else if ((pScanner->count >= U_GNSS_NMEA_MESSAGE_MATCH_LENGTH_CHARACTERS) ||
+                           ('0' > by) || ('Z' < by) || (('9' < by) && ('A' > by))) {
+                    // Too long or not A-Z, 0-9
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_FAILED;
+                } else {
+                    pScanner->messageId.id.nmea[pScanner->count] = (char) by;
+                    pScanner->count++;
+                    p++;
+                }
+                break;
+            case U_GNSS_PRIVATE_SCAN_STATE_NMEA_BODY:
+                pRun = p;
+                while ((p < pEnd) && (*p != '*') && (*p >= ' ') && (*p <= '~')) {
+                    p++;
+                }
+                pScanner->checksum = uChecksumXor8((uint8_t) pScanner->checksum,
+                                                   (const char *) pRun, p - pRun);
+                if (p < pEnd) {
+                    if (*p == '*') {
+                        pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_NMEA_CHECKSUM_1;
+                        p++;
+                    } else {
+                        // Not in printable range 32 - 126
+                        pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_FAILED;
+                    }
+                }
+                break;
+            case U_GNSS_PRIVATE_SCAN_STATE_NMEA_CHECKSUM_1:
+                pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_FAILED;
+                if (by == (uint8_t) pHex[(pScanner->checksum >> 4) & 0x0F]) {
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_NMEA_CHECKSUM_2;
+                    p++;
+                }
+                break;
+            case U_GNSS_PRIVATE_SCAN_STATE_NMEA_CHECKSUM_2:
+                pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_FAILED;
+                if (by == (uint8_t) pHex[pScanner->checksum & 0x0F]) {
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_NMEA_CR;
+                    p++;
+                }
+                break;
+            case U_GNSS_PRIVATE_SCAN_STATE_NMEA_CR:
+                pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_FAILED;
+                if (by == '\r') {
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_NMEA_LF;
+                    p++;
+                }
+                break;
+            case U_GNSS_PRIVATE_SCAN_STATE_NMEA_LF:
+                pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_FAILED;
+                if (by == '\n') {
+                    pScanner->messageId.type = U_GNSS_PROTOCOL_NMEA;
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_COMPLETE;
+                    p++;
+                }
+                break;
+            case U_GNSS_PRIVATE_SCAN_STATE_RTCM_HEADER:
+                if (pScanner->count == 2) {
+                    // Six bits of reserved, which must be zero, then
+                    // the upper two bits of the length
+                    if ((by & 0xFC) != 0) {
+                        pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_FAILED;
+                        break;
+                    }
+                    pScanner->length = (uint16_t) (((uint16_t) (by & 0x03)) << 8);
+                } else {
+                    // Length includes the two-byte message ID and the
+                    // message body, i.e. up to the start of the 3-byte CRC
+                    pScanner->length |= by;
+                }
+                pScanner->checksum = crc24q(pScanner->checksum, by);
+                pScanner->count--;
+                p++;
+                if (pScanner->count == 0) {
+                    pScanner->count = pScanner->length;
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_RTCM_BODY;
+                }
+                break;
+            case U_GNSS_PRIVATE_SCAN_STATE_RTCM_BODY:
+                // The message ID is the first 12 bits of the body
+                while ((p < pEnd) && (pScanner->count > 0) &&
+                       (pScanner->length - pScanner->count < 2)) {
+                    if (pScanner->length - pScanner->count == 0) {
+                        pScanner->messageId.id.rtcm = (uint16_t) (((uint16_t) *p) << 4);
+                    } else {
+                        pScanner->messageId.id.rtcm |= (uint16_t) (*p >> 4);
+                    }
+                    pScanner->checksum = crc24q(pScanner->checksum, *p);
+                    pScanner->count--;
+                    p++;
+                }
+                x = pEnd - p;
+                if (x > pScanner->count) {
+                    x = pScanner->count;
+                }
+                pScanner->count -= x;
+                pScanner->checksum = uCrc24q(pScanner->checksum, (const char *) p, x);
+                p += x;
+                if (pScanner->count == 0) {
+                    pScanner->count = 3;
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_RTCM_CRC;
+                }
+                break;
+            case U_GNSS_PRIVATE_SCAN_STATE_RTCM_CRC:
+                // Compare CRC, most significant byte first
+                if (by != (uint8_t) (pScanner->checksum >> (8 * (pScanner->count - 1)))) {
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_FAILED;
+                    break;
+                }
+                pScanner->count--;
+                p++;
+                if (pScanner->count == 0) {
+                    pScanner->messageId.type = U_GNSS_PROTOCOL_RTCM;
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_COMPLETE;
+                }
+                break;
+            case U_GNSS_PRIVATE_SCAN_STATE_SPARTN_HEADER:
+                // Collect the header until it is long enough for
+                // uSpartnDetect() to check it and give us the length
+                pScanner->spartnHeader[pScanner->count] = (char) by;
+                pScanner->count++;
+                p++;
+                pMessage = NULL;
+                messageLength = uSpartnDetect(pScanner->spartnHeader,
+                                              pScanner->count, &pMessage);
+                if ((messageLength > 0) && (pMessage == pScanner->spartnHeader)) {
+                    pScanner->length = (uint16_t) messageLength;
+                    // Message type (TF002) and sub-type (TF007)
+                    pScanner->messageId.id.spartn = (uint16_t) ((((uint16_t) (((uint8_t) pScanner->spartnHeader[1]) >> 1)) << 8) |
+                                                                (((uint8_t) pScanner->spartnHeader[4]) >> 4));
+                    // The message CRC is over everything but the preamble;
+                    // the CRC-32 of SPARTN starts with all ones
+                    x = ((((uint8_t) pScanner->spartnHeader[3]) >> 4) & 0x03) + 1;
+                    pScanner->checksum = 0;
+                    if (x == 4) {
+                        pScanner->checksum = 0xFFFFFFFF;
+                    }
+                    pScanner->checksum = spartnCrc(pScanner, pScanner->checksum,
+                                                   pScanner->spartnHeader + 1,
+                                                   pScanner->count - 1);
+                    pScanner->count = pScanner->length - pScanner->count - x;
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_SPARTN_BODY;
+                } else if ((messageLength != (int32_t) U_ERROR_COMMON_TIMEOUT) ||
+                           (pScanner->count >= sizeof(pScanner->spartnHeader))) {
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_FAILED;
+                }
+                break;
+            case U_GNSS_PRIVATE_SCAN_STATE_SPARTN_BODY:
+                x = pEnd - p;
+                if (x > pScanner->count) {
+                    x = pScanner->count;
+                }
+                pScanner->count -= x;
+                pScanner->checksum = spartnCrc(pScanner, pScanner->checksum,
+                                               (const char *) p, x);
+                p += x;
+                if (pScanner->count == 0) {
+                    pScanner->count = ((((uint8_t) pScanner->spartnHeader[3]) >> 4) & 0x03) + 1;
+                    if (pScanner->count == 4) {
+                        pScanner->checksum = ~pScanner->checksum;
+                    }
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_SPARTN_CRC;
+                }
+                break;
+            case U_GNSS_PRIVATE_SCAN_STATE_SPARTN_CRC:
+                // Compare CRC, most significant byte first
+                if (by != (uint8_t) (pScanner->checksum >> (8 * (pScanner->count - 1)))) {
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_FAILED;
+                    break;
+                }
+                pScanner->count--;
+                p++;
+                if (pScanner->count == 0) {
+                    pScanner->messageId.type = U_GNSS_PROTOCOL_SPARTN;
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_COMPLETE;
+                }
+                break;
+            default:
+                break;
         }
-        if ('*' == ch) {
-            break;    // *
+        if (pScanner->state == U_GNSS_PRIVATE_SCAN_STATE_FAILED) {
+            // Not a message after all: hunt again from the byte after
+            // the one we thought was the start of a message; if that is
+            // within this span it can be done here, otherwise the
+            // caller has to set the scan position back
+            x = pScanner->messageStart + 1 - position;
+            if (x <= (size_t) (p - pStart)) {
+                p = pStart + x;
+                pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_HUNT;
+            }
         }
-        crc ^= ch;
-    }
-    if (!uRingBufferGetByteUnprotected(parseHandle, &ch)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if (hex[(crc >> 4) & 0xF] != ch) {
-        return U_ERROR_COMMON_NOT_FOUND;
-    }
-    if (!uRingBufferGetByteUnprotected(parseHandle, &ch)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if (hex[crc & 0xF] != ch) {
-        return U_ERROR_COMMON_NOT_FOUND;
-    }
-    if (!uRingBufferGetByteUnprotected(parseHandle, &ch)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if ('\r' != ch) {
-        return U_ERROR_COMMON_NOT_FOUND;
-    }
-    if (!uRingBufferGetByteUnprotected(parseHandle, &ch)) {
-        return U_ERROR_COMMON_TIMEOUT;
     }
-    if ('\n' != ch) {
-        return U_ERROR_COMMON_NOT_FOUND;
-    }
-    // We can only claim this as an NMEA-format message if
-    // there was nothing that needed discarding first.
-    if (uRingBufferBytesDiscardUnprotected(parseHandle) == 0) {
-        pMsgId->type = U_GNSS_PROTOCOL_NMEA;
-    }
-    return U_ERROR_COMMON_SUCCESS;
+
+    pScanner->scanned = position + (p - pStart);
+
+    return p - pStart;
 }
 
-/** RTCM Parser function.
- *
- * @param parseHandle    the parse handle of the ring buffer to read from.
- * @param[in] pUserParam the user parameter passed to uRingBufferParseHandle().
- * @return               negative error or success code.
- */
-static int32_t parseRtcm(uParseHandle_t parseHandle, void *pUserParam)
+// Scan the ring buffer at the given read handle and return the
+// length of the message, or of the data that is not a message,
+// which begins at the read pointer, writing the ID of the message
+// to pMessageId (#U_GNSS_PROTOCOL_UNKNOWN for data that is not a
+// message); returns U_ERROR_COMMON_TIMEOUT if there is nothing or
+// the start of a message that is not yet complete.
+static int32_t scanRingBuffer(uRingBuffer_t *pRingBuffer, int32_t readHandle,
+                              uGnssPrivateScanner_t *pScanner,
+                              uGnssPrivateMessageId_t *pMessageId)
 {
-    uGnssPrivateMessageId_t *pMsgId = (uGnssPrivateMessageId_t *) pUserParam;
-    uint8_t by;
-    uint32_t crc = 0;
-    if (!uRingBufferGetByteUnprotected(parseHandle, &by)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if (0xD3 != by) {
-        return U_ERROR_COMMON_NOT_FOUND;
-    }
-    // CRC24Q check
-    const uint32_t _crc24qTable[] = {
-        /* 00 */ 0x000000, 0x864cfb, 0x8ad50d, 0x0c99f6, 0x93e6e1, 0x15aa1a, 0x1933ec, 0x9f7f17,
-        /* 08 */ 0xa18139, 0x27cdc2, 0x2b5434, 0xad18cf, 0x3267d8, 0xb42b23, 0xb8b2d5, 0x3efe2e,
-        /* 10 */ 0xc54e89, 0x430272, 0x4f9b84, 0xc9d77f, 0x56a868, 0xd0e493, 0xdc7d65, 0x5a319e,
-        /* 18 */ 0x64cfb0, 0xe2834b, 0xee1abd, 0x685646, 0xf72951, 0x7165aa, 0x7dfc5c, 0xfbb0a7,
-        /* 20 */ 0x0cd1e9, 0x8a9d12, 0x8604e4, 0x00481f, 0x9f3708, 0x197bf3, 0x15e205, 0x93aefe,
-        /* 28 */ 0xad50d0, 0x2b1c2b, 0x2785dd, 0xa1c926, 0x3eb631, 0xb8faca, 0xb4633c, 0x322fc7,
-        /* 30 */ 0xc99f60, 0x4fd39b, 0x434a6d, 0xc50696, 0x5a7981, 0xdc357a, 0xd0ac8c, 0x56e077,
-        /* 38 */ 0x681e59, 0xee52a2, 0xe2cb54, 0x6487af, 0xfbf8b8, 0x7db443, 0x712db5, 0xf7614e,
-        /* 40 */ 0x19a3d2, 0x9fef29, 0x9376df, 0x153a24, 0x8a4533, 0x0c09c8, 0x00903e, 0x86dcc5,
-        /* 48 */ 0xb822eb, 0x3e6e10, 0x32f7e6, 0xb4bb1d, 0x2bc40a, 0xad88f1, 0xa11107, 0x275dfc,
-        /* 50 */ 0xdced5b, 0x5aa1a0, 0x563856, 0xd074ad, 0x4f0bba, 0xc94741, 0xc5deb7, 0x43924c,
-        /* 58 */ 0x7d6c62, 0xfb2099, 0xf7b96f, 0x71f594, 0xee8a83, 0x68c678, 0x645f8e, 0xe21375,
-        /* 60 */ 0x15723b, 0x933ec0, 0x9fa736, 0x19ebcd, 0x8694da, 0x00d821, 0x0c41d7, 0x8a0d2c,
-        /* 68 */ 0xb4f302, 0x32bff9, 0x3e260f, 0xb86af4, 0x2715e3, 0xa15918, 0xadc0ee, 0x2b8c15,
-        /* 70 */ 0xd03cb2, 0x567049, 0x5ae9bf, 0xdca544, 0x43da53, 0xc596a8, 0xc90f5e, 0x4f43a5,
-        /* 78 */ 0x71bd8b, 0xf7f170, 0xfb6886, 0x7d247d, 0xe25b6a, 0x641791, 0x688e67, 0xeec29c,
-        /* 80 */ 0x3347a4, 0xb50b5f, 0xb992a9, 0x3fde52, 0xa0a145, 0x26edbe, 0x2a7448, 0xac38b3,
-        /* 88 */ 0x92c69d, 0x148a66, 0x181390, 0x9e5f6b, 0x01207c, 0x876c87, 0x8bf571, 0x0db98a,
-        /* 90 */ 0xf6092d, 0x7045d6, 0x7cdc20, 0xfa90db, 0x65efcc, 0xe3a337, 0xef3ac1, 0x69763a,
-        /* 98 */ 0x578814, 0xd1c4ef, 0xdd5d19, 0x5b11e2, 0xc46ef5, 0x42220e, 0x4ebbf8, 0xc8f703,
-        /* a0 */ 0x3f964d, 0xb9dab6, 0xb54340, 0x330fbb, 0xac70ac, 0x2a3c57, 0x26a5a1, 0xa0e95a,
-        /* a8 */ 0x9e1774, 0x185b8f, 0x14c279, 0x928e82, 0x0df195, 0x8bbd6e, 0x872498, 0x016863,
-        /* b0 */ 0xfad8c4, 0x7c943f, 0x700dc9, 0xf64132, 0x693e25, 0xef72de, 0xe3eb28, 0x65a7d3,
-        /* b8 */ 0x5b59fd, 0xdd1506, 0xd18cf0, 0x57c00b, 0xc8bf1c, 0x4ef3e7, 0x426a11, 0xc426ea,
-        /* c0 */ 0x2ae476, 0xaca88d, 0xa0317b, 0x267d80, 0xb90297, 0x3f4e6c, 0x33d79a, 0xb59b61,
-        /* c8 */ 0x8b654f, 0x0d29b4, 0x01b042, 0x87fcb9, 0x1883ae, 0x9ecf55, 0x9256a3, 0x141a58,
-        /* d0 */ 0xefaaff, 0x69e604, 0x657ff2, 0xe33309, 0x7c4c1e, 0xfa00e5, 0xf69913, 0x70d5e8,
-        /* d8 */ 0x4e2bc6, 0xc8673d, 0xc4fecb, 0x42b230, 0xddcd27, 0x5b81dc, 0x57182a, 0xd154d1,
-        /* e0 */ 0x26359f, 0xa07964, 0xace092, 0x2aac69, 0xb5d37e, 0x339f85, 0x3f0673, 0xb94a88,
-        /* e8 */ 0x87b4a6, 0x01f85d, 0x0d61ab, 0x8b2d50, 0x145247, 0x921ebc, 0x9e874a, 0x18cbb1,
-        /* f0 */ 0xe37b16, 0x6537ed, 0x69ae1b, 0xefe2e0, 0x709df7, 0xf6d10c, 0xfa48fa, 0x7c0401,
-        /* f8 */ 0x42fa2f, 0xc4b6d4, 0xc82f22, 0x4e63d9, 0xd11cce, 0x575035, 0x5bc9c3, 0xdd8538
-    };
-#define RTCM_CRC(crc, by) (crc << 8) ^ _crc24qTable[(by ^ (crc >> 16)) & 0xff]
-    // CRC is over the entire message, 0xD3 included
-    crc = RTCM_CRC(crc, by);
-    if (!uRingBufferGetByteUnprotected(parseHandle, &by)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    if ((0xFC & by) != 0) {
-        return U_ERROR_COMMON_NOT_FOUND;
-    }
-    uint16_t l = (uint16_t) ((by & 0x3) << 8);
-    crc = RTCM_CRC(crc, by);
-    if (!uRingBufferGetByteUnprotected(parseHandle, &by)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    l += by;
-    // Length includes the two-byte message ID and the message
-    // body, i.e. up to the start of the 3-byte CRC, i.e.
-    // the total message length - 6.
-    if (l > uRingBufferBytesAvailableUnprotected(parseHandle) + 3) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    crc = RTCM_CRC(crc, by);
-    uint8_t idLo, idHi;
-    if (!uRingBufferGetByteUnprotected(parseHandle, &idLo)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    l--;
-    crc = RTCM_CRC(crc, idLo);
-    if (!uRingBufferGetByteUnprotected(parseHandle, &idHi)) {
-        return U_ERROR_COMMON_TIMEOUT;
-    }
-    l--;
-    crc = RTCM_CRC(crc, idHi);
-    pMsgId->id.rtcm = (idHi >> 4) + (uint16_t) (idLo << 4);
-    while (l--) {
-        uRingBufferGetByteUnprotected(parseHandle, &by);
-        crc = RTCM_CRC(crc, by);
-    }
-    // Compare CRC
-    for (int32_t x = 2; (x >= 0) && uRingBufferGetByteUnprotected(parseHandle, &by); x--) {
-        if (by != (uint8_t) (crc >> (8 * x))) {
-            return U_ERROR_COMMON_TIMEOUT;
+    int32_t errorCodeOrLength;
+    size_t messageScanned;
+    size_t ahead;
+    bool again;
+    bool spartn;
+
+    memset(pMessageId, 0, sizeof(*pMessageId));
+    pMessageId->type = U_GNSS_PROTOCOL_UNKNOWN;
+
+    do {
+        again = false;
+        errorCodeOrLength = uRingBufferScanHandle(pRingBuffer, readHandle,
+                                                  &(pScanner->position),
+                                                  scan, pScanner);
+        if (errorCodeOrLength >= 0) {
+            errorCodeOrLength = (int32_t) U_ERROR_COMMON_TIMEOUT;
+            // The number of scanned bytes ahead of the read pointer
+            ahead = pScanner->position.offset;
+            messageScanned = pScanner->scanned - pScanner->messageStart;
+            if (pScanner->state == U_GNSS_PRIVATE_SCAN_STATE_HUNT) {
+                if (ahead > 0) {
+                    // Nothing that looks like a message
+                    errorCodeOrLength = (int32_t) ahead;
+                }
+            } else if (messageScanned > ahead) {
+                // The read pointer has moved into or past the message
+                if ((pScanner->state == U_GNSS_PRIVATE_SCAN_STATE_COMPLETE) && (ahead == 0)) {
+                    // The message has been read, carry on hunting
+                    pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_HUNT;
+                } else {
+                    // Lost track, start again at the read pointer,
+                    // keeping the SPARTN setting
+                    spartn = pScanner->spartn;
+                    memset(pScanner, 0, sizeof(*pScanner));
+                    pScanner->spartn = spartn;
+                }
+                again = true;
+            } else if (pScanner->state == U_GNSS_PRIVATE_SCAN_STATE_FAILED) {
+                // Hunt again from the byte after the failed message start
+                pScanner->position.offset -= messageScanned - 1;
+                pScanner->scanned = pScanner->messageStart + 1;
+                pScanner->state = U_GNSS_PRIVATE_SCAN_STATE_HUNT;
+                again = true;
+            } else if (messageScanned < ahead) {
+                // There is data which is not a message before the
+                // start of the message (which may not be complete yet)
+                errorCodeOrLength = (int32_t) (ahead - messageScanned);
+            } else if (pScanner->state == U_GNSS_PRIVATE_SCAN_STATE_COMPLETE) {
+                errorCodeOrLength = (int32_t) messageScanned;
+                *pMessageId = pScanner->messageId;
+            }
         }
+    } while (again);
+
+    return errorCodeOrLength;
+}
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS: DATA EVENTS
+ * -------------------------------------------------------------- */
+
+// Note a data event for the message receive task: this is called
+// from the event task of the transport and so must not lock any
+// mutexes.
+static void dataEvent(uGnssPrivateMsgReceive_t *pMsgReceive)
+{
+    if (pMsgReceive->dataArrivalTimeMs < 0) {
+        pMsgReceive->dataArrivalTimeMs = uPortGetTickTimeMs();
     }
-    // We can only claim this as an RTCM-format message if
-    // there was nothing that needed discarding first.
-    if (uRingBufferBytesDiscardUnprotected(parseHandle) == 0) {
-        pMsgId->type = U_GNSS_PROTOCOL_RTCM;
+    uPortSemaphoreGive(pMsgReceive->dataEventSemaphoreHandle);
+}
+
+// Data event callback for the UART transport.
+static void uartDataEventCallback(int32_t uartHandle, uint32_t eventBitMask,
+                                  void *pParameters)
+{
+    (void) uartHandle;
+
+    if (eventBitMask & U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED) {
+        dataEvent((uGnssPrivateMsgReceive_t *) pParameters);
+    }
+}
+
+// Data event callback for the virtual serial transport.
+static void deviceSerialDataEventCallback(struct uDeviceSerial_t *pDeviceSerial,
+                                          uint32_t eventBitMask,
+                                          void *pParameters)
+{
+    (void) pDeviceSerial;
+
+    if (eventBitMask & U_DEVICE_SERIAL_EVENT_BITMASK_DATA_RECEIVED) {
+        dataEvent((uGnssPrivateMsgReceive_t *) pParameters);
     }
-    return U_ERROR_COMMON_SUCCESS;
 }
 
 /* ----------------------------------------------------------------
@@ -1643,6 +1893,7 @@ int32_t uGnssPrivateSetProtocolOut(uGnssPrivateInstance_t *pInstance,
 
     if ((pInstance != NULL) &&
         (pInstance->transportType != U_GNSS_TRANSPORT_AT) &&
+        (protocol != U_GNSS_PROTOCOL_SPARTN) &&
         (onNotOff || ((protocol != U_GNSS_PROTOCOL_ALL) &&
                       (protocol != U_GNSS_PROTOCOL_UBX)))) {
         if (U_GNSS_PRIVATE_HAS(pInstance->pModule, U_GNSS_PRIVATE_FEATURE_OLD_CFG_API)) {
@@ -1784,8 +2035,16 @@ void uGnssPrivateStopMsgReceive(uGnssPrivateInstance_t *pInstance)
     if ((pInstance != NULL) && (pInstance->pMsgReceive != NULL)) {
         pMsgReceive = pInstance->pMsgReceive;
 
-        // Sending the task anything will cause it to exit
+        // Stop any data events first so that nothing is
+        // giving the semaphore while we're tidying up
+        uGnssPrivateStreamDataEventStop(pInstance);
+
+        // Sending the task anything will cause it to exit; if the
+        // task is event-driven it needs a kick to notice
         uPortQueueSend(pMsgReceive->taskExitQueueHandle, queueItem);
+        if (pMsgReceive->dataEventSemaphoreHandle != NULL) {
+            uPortSemaphoreGive(pMsgReceive->dataEventSemaphoreHandle);
+        }
         U_PORT_MUTEX_LOCK(pMsgReceive->taskRunningMutexHandle);
         U_PORT_MUTEX_UNLOCK(pMsgReceive->taskRunningMutexHandle);
         // Wait for the task to actually exit: the STM32F4 platform
@@ -1804,6 +2063,9 @@ void uGnssPrivateStopMsgReceive(uGnssPrivateInstance_t *pInstance)
         uPortMutexDelete(pMsgReceive->taskRunningMutexHandle);
         uPortQueueDelete(pMsgReceive->taskExitQueueHandle);
         uPortMutexDelete(pMsgReceive->readerMutexHandle);
+        if (pMsgReceive->dataEventSemaphoreHandle != NULL) {
+            uPortSemaphoreDelete(pMsgReceive->dataEventSemaphoreHandle);
+        }
 
         // Pause here to allow the deletions
         // to actually occur in the idle thread,
@@ -1852,6 +2114,10 @@ int32_t uGnssPrivateMessageIdToPrivate(const uGnssMessageId_t *pMessageId,
                 pPrivateMessageId->id.rtcm = pMessageId->id.rtcm;
                 errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
                 break;
+            case U_GNSS_PROTOCOL_SPARTN:
+                pPrivateMessageId->id.spartn = pMessageId->id.spartn;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                break;
             case U_GNSS_PROTOCOL_UNKNOWN:
             //fall-through
             case U_GNSS_PROTOCOL_ALL:
@@ -1893,6 +2159,10 @@ int32_t uGnssPrivateMessageIdToPublic(const uGnssPrivateMessageId_t *pPrivateMes
                 pMessageId->id.rtcm = pPrivateMessageId->id.rtcm;
                 errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
                 break;
+            case U_GNSS_PROTOCOL_SPARTN:
+                pMessageId->id.spartn = pPrivateMessageId->id.spartn;
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                break;
             case U_GNSS_PROTOCOL_UNKNOWN:
             //fall-through
             case U_GNSS_PROTOCOL_ALL:
@@ -1923,6 +2193,9 @@ bool uGnssPrivateMessageIdIsWanted(uGnssPrivateMessageId_t *pMessageId,
     } else if ((pMessageIdWanted->type == U_GNSS_PROTOCOL_RTCM) &&
                (pMessageId->type == U_GNSS_PROTOCOL_RTCM)) {
         isWanted = rtcmIdMatch(pMessageId->id.rtcm, pMessageIdWanted->id.rtcm);
+    } else if ((pMessageIdWanted->type == U_GNSS_PROTOCOL_SPARTN) &&
+               (pMessageId->type == U_GNSS_PROTOCOL_SPARTN)) {
+        isWanted = spartnIdMatch(pMessageId->id.spartn, pMessageIdWanted->id.spartn);
     } else if ((pMessageIdWanted->type == U_GNSS_PROTOCOL_NMEA) &&
                (pMessageId->type == U_GNSS_PROTOCOL_NMEA)) {
         isWanted = nmeaIdMatch(pMessageId->id.nmea, pMessageIdWanted->id.nmea);
@@ -2072,6 +2345,70 @@ int32_t uGnssPrivateStreamGetReceiveSize(uGnssPrivateInstance_t *pInstance)
     return errorCodeOrReceiveSize;
 }
 
+// Set a data event callback on the streaming transport.
+int32_t uGnssPrivateStreamDataEventStart(uGnssPrivateInstance_t *pInstance)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+    uGnssPrivateMsgReceive_t *pMsgReceive;
+    uDeviceSerial_t *pDeviceSerial;
+
+    if ((pInstance != NULL) && (pInstance->pMsgReceive != NULL) &&
+        (pInstance->pMsgReceive->dataEventSemaphoreHandle != NULL)) {
+        pMsgReceive = pInstance->pMsgReceive;
+        pMsgReceive->dataArrivalTimeMs = -1;
+        errorCode = (int32_t) U_ERROR_COMMON_NOT_SUPPORTED;
+        switch (uGnssPrivateGetStreamType(pInstance->transportType)) {
+            case U_GNSS_PRIVATE_STREAM_TYPE_UART:
+                errorCode = uPortUartEventCallbackSet(pInstance->transportHandle.uart,
+                                                      U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                                      uartDataEventCallback, pMsgReceive,
+                                                      U_GNSS_MSG_RECEIVE_EVENT_TASK_STACK_SIZE_BYTES,
+                                                      U_GNSS_MSG_RECEIVE_EVENT_TASK_PRIORITY);
+                break;
+            case U_GNSS_PRIVATE_STREAM_TYPE_VIRTUAL_SERIAL:
+                pDeviceSerial = pInstance->transportHandle.pDeviceSerial;
+                if (pDeviceSerial != NULL) {
+                    errorCode = pDeviceSerial->eventCallbackSet(pDeviceSerial,
+                                                                U_DEVICE_SERIAL_EVENT_BITMASK_DATA_RECEIVED,
+                                                                deviceSerialDataEventCallback,
+                                                                pMsgReceive,
+                                                                U_GNSS_MSG_RECEIVE_EVENT_TASK_STACK_SIZE_BYTES,
+                                                                U_GNSS_MSG_RECEIVE_EVENT_TASK_PRIORITY);
+                }
+                break;
+            default:
+                // I2C and SPI have no "data received" indication,
+                // the GNSS chip has to be asked
+                break;
+        }
+    }
+
+    return errorCode;
+}
+
+// Remove the data event callback from the streaming transport.
+void uGnssPrivateStreamDataEventStop(uGnssPrivateInstance_t *pInstance)
+{
+    uDeviceSerial_t *pDeviceSerial;
+
+    if ((pInstance != NULL) && (pInstance->pMsgReceive != NULL) &&
+        (pInstance->pMsgReceive->dataEventSemaphoreHandle != NULL)) {
+        switch (uGnssPrivateGetStreamType(pInstance->transportType)) {
+            case U_GNSS_PRIVATE_STREAM_TYPE_UART:
+                uPortUartEventCallbackRemove(pInstance->transportHandle.uart);
+                break;
+            case U_GNSS_PRIVATE_STREAM_TYPE_VIRTUAL_SERIAL:
+                pDeviceSerial = pInstance->transportHandle.pDeviceSerial;
+                if (pDeviceSerial != NULL) {
+                    pDeviceSerial->eventCallbackRemove(pDeviceSerial);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
 // Find the given message ID in the ring buffer.
 // IMPORTANT: this function should not do anything that has "global"
 // effect on the instance data since it is called by
@@ -2079,23 +2416,29 @@ int32_t uGnssPrivateStreamGetReceiveSize(uGnssPrivateInstance_t *pInstance)
 // the message receive task over in u_gnss_msg.c
 int32_t uGnssPrivateStreamDecodeRingBuffer(uRingBuffer_t *pRingBuffer,
                                            int32_t readHandle,
-                                           uGnssPrivateMessageId_t *pPrivateMessageId)
+                                           uGnssPrivateMessageId_t *pPrivateMessageId,
+                                           uGnssPrivateScanner_t *pScanner)
 {
     int32_t errorCodeOrLength = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
     char *pDiscard = NULL;
+    uGnssPrivateScanner_t scanner;
+    bool spartn = false;
 
     if ((pRingBuffer != NULL) && (pPrivateMessageId != NULL)) {
+        if (pScanner == NULL) {
+            // No state to carry on from, scan from the read pointer
+            memset(&scanner, 0, sizeof(scanner));
+            pScanner = &scanner;
+        }
+        // Hunt for SPARTN if this call asks for it, without
+        // changing what the caller's scanner will do next time
+        spartn = pScanner->spartn;
+        if (pPrivateMessageId->type == U_GNSS_PROTOCOL_SPARTN) {
+            pScanner->spartn = true;
+        }
         while (1) {
-            U_RING_BUFFER_PARSER_f parserList[] = {
-                parseUbx,
-                parseNmea,
-                parseRtcm,
-                NULL
-            };
             uGnssPrivateMessageId_t msg;
-            memset(&msg, 0, sizeof(msg));
-            msg.type = U_GNSS_PROTOCOL_UNKNOWN;
-            errorCodeOrLength = uRingBufferParseHandle(pRingBuffer, readHandle, parserList, &msg);
+            errorCodeOrLength = scanRingBuffer(pRingBuffer, readHandle, pScanner, &msg);
             if (errorCodeOrLength <= 0) {
                 break;
             } else if (uGnssPrivateMessageIdIsWanted(&msg, pPrivateMessageId)) {
@@ -2145,6 +2488,7 @@ int32_t uGnssPrivateStreamDecodeRingBuffer(uRingBuffer_t *pRingBuffer,
                 }
             }
         };
+        pScanner->spartn = spartn;
     }
     return errorCodeOrLength;
 }
@@ -2431,10 +2775,14 @@ int32_t uGnssPrivateReceiveStreamMessage(uGnssPrivateInstance_t *pInstance,
     uTimeoutStart_t timeoutStart;
     int32_t x = timeoutMs > 0 ? U_GNSS_RING_BUFFER_MIN_FILL_TIME_MS : 0;
     int32_t y;
+    uGnssPrivateScanner_t scanner;
 
     if ((pInstance != NULL) && (pPrivateMessageId != NULL) &&
         (ppBuffer != NULL) && ((*ppBuffer == NULL) || (size > 0))) {
         errorCodeOrLength = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        // Keep the scan state across fills so that a long message
+        // arriving in pieces is only scanned once
+        memset(&scanner, 0, sizeof(scanner));
         timeoutStart = uTimeoutStart();
         // Lock our read pointer while we look for stuff
         uRingBufferLockReadHandle(&(pInstance->ringBuffer), readHandle);
@@ -2457,7 +2805,8 @@ int32_t uGnssPrivateReceiveStreamMessage(uGnssPrivateInstance_t *pInstance,
                     // Attempt to decode a message/message header from the ring buffer
                     errorCodeOrLength = uGnssPrivateStreamDecodeRingBuffer(&(pInstance->ringBuffer),
                                                                            readHandle,
-                                                                           pPrivateMessageId);
+                                                                           pPrivateMessageId,
+                                                                           &scanner);
                     if (errorCodeOrLength > 0) {
                         if (*ppBuffer == NULL) {
                             // The caller didn't give us any memory; allocate the right
@@ -59,6 +59,12 @@ extern "C" {
 # define U_GNSS_MSG_RING_BUFFER_LENGTH_BYTES 2048
 #endif
 
+/** The maximum length of a SPARTN message header (FRAME START plus
+ * the longest PAYLOAD DESCRIPTION), which the message scanner has
+ * to hold on to in order to work out the length of the message.
+ */
+#define U_GNSS_PRIVATE_SPARTN_HEADER_LENGTH_MAX_BYTES (4 + 8)
+
 #ifndef U_GNSS_RING_BUFFER_MAX_FILL_TIME_MS
 /** A useful maximum for the amount of time spent pulling
  * data into the ring buffer (for streamed sources such as
@@ -166,9 +172,81 @@ typedef struct {
                                                                           to be
                                                                           null-terminated. */
         uint16_t rtcm;
+        uint16_t spartn; /**< formed of the message type in the most significant
+                              byte and the message sub-type in the least
+                              significant byte, wildcards as for the ubx field. */
     } id;
 } uGnssPrivateMessageId_t;
 
+/** The states of the message scanner, see uGnssPrivateScanner_t.
+ */
+typedef enum {
+    U_GNSS_PRIVATE_SCAN_STATE_HUNT,         /**< looking for the start of a message. */
+    U_GNSS_PRIVATE_SCAN_STATE_UBX_SYNC_2,
+    U_GNSS_PRIVATE_SCAN_STATE_UBX_HEADER,   /**< class, ID and two-byte length. */
+    U_GNSS_PRIVATE_SCAN_STATE_UBX_BODY,
+    U_GNSS_PRIVATE_SCAN_STATE_UBX_CK_A,
+    U_GNSS_PRIVATE_SCAN_STATE_UBX_CK_B,
+    U_GNSS_PRIVATE_SCAN_STATE_NMEA_ID,      /**< talker/sentence up to the first comma. */
+    U_GNSS_PRIVATE_SCAN_STATE_NMEA_BODY,    /**< up to the star. */
+    U_GNSS_PRIVATE_SCAN_STATE_NMEA_CHECKSUM_1,
+    U_GNSS_PRIVATE_SCAN_STATE_NMEA_CHECKSUM_2,
+    U_GNSS_PRIVATE_SCAN_STATE_NMEA_CR,
+    U_GNSS_PRIVATE_SCAN_STATE_NMEA_LF,
+    U_GNSS_PRIVATE_SCAN_STATE_RTCM_HEADER,  /**< the two bytes of reserved and length. */
+    U_GNSS_PRIVATE_SCAN_STATE_RTCM_BODY,    /**< message ID and body. */
+    U_GNSS_PRIVATE_SCAN_STATE_RTCM_CRC,
+    U_GNSS_PRIVATE_SCAN_STATE_SPARTN_HEADER, /**< frame start and payload description. */
+    U_GNSS_PRIVATE_SCAN_STATE_SPARTN_BODY,   /**< payload and authentication. */
+    U_GNSS_PRIVATE_SCAN_STATE_SPARTN_CRC,
+    U_GNSS_PRIVATE_SCAN_STATE_COMPLETE,     /**< a whole, valid, message has been found. */
+    U_GNSS_PRIVATE_SCAN_STATE_FAILED        /**< what looked like the start of a message
+                                                 turned out not to be. */
+} uGnssPrivateScanState_t;
+
+/** State for the single-pass message scanner employed by
+ * uGnssPrivateStreamDecodeRingBuffer(): UBX, NMEA, RTCM and, if the
+ * spartn field is set, SPARTN messages are recognised, and their checksums calculated, in one pass over the
+ * contents of the ring buffer; by keeping one of these per read handle,
+ * and passing it to uGnssPrivateStreamDecodeRingBuffer() each time,
+ * data that has already been scanned is not scanned again when more
+ * arrives.  Positions are counted in bytes scanned since the scanner
+ * was reset, and are only ever compared with each other by difference,
+ * so wrapping is not an issue.  Zero the structure to reset it.
+ */
+typedef struct {
+    uRingBufferScanPosition_t position;  /**< the position of the scan in the
+                                              ring buffer. */
+    size_t scanned;                      /**< the number of bytes scanned. */
+    size_t messageStart;                 /**< the value of scanned at the
+                                              start of the message that is
+                                              being scanned. */
+    uGnssPrivateScanState_t state;
+    size_t count;                        /**< the number of bytes still to
+                                              scan in a UBX/RTCM state, the
+                                              number of characters of
+                                              talker/sentence for NMEA. */
+    uint32_t checksum;                   /**< the CRC-24Q for RTCM, the XOR
+                                              for NMEA, CK_A in the least
+                                              significant byte and CK_B in
+                                              the next byte for UBX, the
+                                              message CRC for SPARTN. */
+    uint16_t length;                     /**< the length field of a UBX or
+                                              RTCM message, the whole length
+                                              of a SPARTN message. */
+    uGnssPrivateMessageId_t messageId;   /**< the ID of the message. */
+    bool spartn;                         /**< set this to hunt for SPARTN
+                                              messages as well; it is off by
+                                              default since the SPARTN header
+                                              is only lightly protected and
+                                              a false detection may hold up
+                                              the messages that follow until
+                                              a SPARTN message's worth of
+                                              data has arrived; retained
+                                              when the scanner resets itself. */
+    char spartnHeader[U_GNSS_PRIVATE_SPARTN_HEADER_LENGTH_MAX_BYTES];
+} uGnssPrivateScanner_t;
+
 /** Structure to hold the data associated with one non-blocking
  * message read utility function, intended to be used in a
  * linked-list.
@@ -180,6 +258,7 @@ typedef struct uGnssPrivateMsgReader_t {
                           all the types of uGnssMsgReceiveCallback_t
                           into everything. */
     void *pCallbackParam;
+    bool spansNotCopy; /**< true if pCallback is a uGnssMsgReceiveSpanCallback_t. */
     struct uGnssPrivateMsgReader_t *pNext;
 } uGnssPrivateMsgReader_t;
 
@@ -196,6 +275,19 @@ typedef struct {
     int32_t ringBufferReadHandle;
     size_t msgBytesLeftToRead;
     uGnssPrivateMsgReader_t *pReaderList;
+    uPortSemaphoreHandle_t dataEventSemaphoreHandle; /**< given by the transport data
+                                                          event callback; NULL if the
+                                                          task is polling. */
+    volatile int32_t dataArrivalTimeMs; /**< tick time of the first data event not
+                                             yet dispatched, -1 if there is none. */
+    size_t latencyCount;   /**< number of messages dispatched to readers. */
+    int32_t latencyMinMs;  /**< smallest data-arrival-to-callback time. */
+    int32_t latencyMaxMs;  /**< largest data-arrival-to-callback time. */
+    int64_t latencyTotalMs; /**< sum of data-arrival-to-callback times. */
+    uGnssPrivateScanner_t scanner; /**< the message scanner for ringBufferReadHandle. */
+    volatile bool spartn; /**< true while any reader in pReaderList is asking
+                               for SPARTN messages, copied into scanner by the
+                               message receive task. */
 } uGnssPrivateMsgReceive_t;
 
 /** Parameters to pass to the streamed position callback.
@@ -253,6 +345,8 @@ typedef struct uGnssPrivateInstance_t {
     int32_t timeoutMs; /**< the timeout for responses from the GNSS chip in milliseconds. */
     int32_t spiFillThreshold; /**< the number of 0xFF fill bytes which constitute "no data" on SPI. */
     bool printUbxMessages; /**< whether debug printing of UBX messages is on or off. */
+    bool msgReceiveEventDriven; /**< whether the message receive task should wait for data events from the transport rather than polling. */
+    int32_t msgReceiveCoalesceMs; /**< how long the message receive task waits after a data event to let more data arrive. */
     int32_t retriesOnNoResponse; /**< number of times to retry message transmission if there is no response. */
     int32_t pinGnssEnablePower; /**< the pin of the MCU that enables power to the GNSS module. */
     int32_t pinGnssEnablePowerOnState; /**< the value to set pinGnssEnablePower to for "on". */
@@ -636,6 +730,30 @@ int32_t uGnssPrivateStreamGetReceiveSize(uGnssPrivateInstance_t *pInstance);
 int32_t uGnssPrivateStreamFillRingBuffer(uGnssPrivateInstance_t *pInstance,
                                          int32_t timeoutMs, int32_t maxTimeMs);
 
+/** Set a callback on the streaming transport (UART or virtual serial)
+ * which gives pInstance->pMsgReceive->dataEventSemaphoreHandle when
+ * data arrives, allowing the message receive task to block on that
+ * semaphore rather than polling; I2C and SPI transports have no
+ * such event and so are not supported.
+ *
+ * Note: gUGnssPrivateMutex should be locked before this is called.
+ *
+ * @param[in] pInstance  a pointer to the GNSS instance, cannot be NULL;
+ *                       pInstance->pMsgReceive must be populated and
+ *                       must contain a valid dataEventSemaphoreHandle.
+ * @return               zero on success else negative error code.
+ */
+int32_t uGnssPrivateStreamDataEventStart(uGnssPrivateInstance_t *pInstance);
+
+/** Remove a callback that was set with uGnssPrivateStreamDataEventStart();
+ * once this returns the callback will no longer be called.
+ *
+ * Note: gUGnssPrivateMutex should be locked before this is called.
+ *
+ * @param[in] pInstance  a pointer to the GNSS instance, cannot be NULL.
+ */
+void uGnssPrivateStreamDataEventStop(uGnssPrivateInstance_t *pInstance);
+
 /** Examine the given ring buffer, for the given read handle, and determine
  * if it contains the given message ID, or even the sniff of a possibility
  * of it.  If a message header is matched the read pointer for the given
@@ -669,6 +787,16 @@ int32_t uGnssPrivateStreamFillRingBuffer(uGnssPrivateInstance_t *pInstance,
  *                                   On return, if a message has been found,
  *                                   this will be populated with the message
  *                                   ID that was found; cannot be NULL.
+ * @param[in,out] pScanner           the scanner state to use for readHandle,
+ *                                   allowing a message that is only partly
+ *                                   in the ring buffer to be resumed rather
+ *                                   than scanned again from the start; may
+ *                                   be NULL, in which case the ring buffer
+ *                                   is scanned from the read pointer.  If
+ *                                   pPrivateMessageId is for SPARTN then
+ *                                   SPARTN messages are hunted for during
+ *                                   this call, whatever the spartn field
+ *                                   of the scanner, which is left as it was.
  * @return                           if the given message ID is detected then
  *                                   the number of bytes of data in it
  *                                   (including $, header, checksum, etc.)
@@ -680,7 +808,8 @@ int32_t uGnssPrivateStreamFillRingBuffer(uGnssPrivateInstance_t *pInstance,
  */
 int32_t uGnssPrivateStreamDecodeRingBuffer(uRingBuffer_t *pRingBuffer,
                                            int32_t readHandle,
-                                           uGnssPrivateMessageId_t *pPrivateMessageId);
+                                           uGnssPrivateMessageId_t *pPrivateMessageId,
+                                           uGnssPrivateScanner_t *pScanner);
 
 /** Read data from the internal ring buffer into the given linear buffer.
  *
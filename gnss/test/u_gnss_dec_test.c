@@ -53,6 +53,8 @@
 
 #include "u_test_util_resource_check.h"
 
+#include "u_ubx_protocol.h"
+
 #include "u_gnss_module_type.h"
 #include "u_gnss_type.h"
 #include "u_gnss.h"
@@ -102,6 +104,13 @@
 # define U_GNSS_DEC_TEST_HEX_DUMP_WIDTH 16
 #endif
 
+#ifndef U_GNSS_DEC_TEST_NO_HEAP_ITERATIONS
+/** The number of times to go around all of the test messages
+ * when checking that uGnssDecDecode() makes no use of the heap.
+ */
+# define U_GNSS_DEC_TEST_NO_HEAP_ITERATIONS 100
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -224,17 +233,200 @@ static const uGnssDecTestDataKnown_t gUbxNavHpposllh[] = {
     }
 };
 
+/** Decoded test data for UBX-NAV-SAT, to be used by gUbxNavSat (item 0).
+ */
+static const uGnssDecUbxNavSat_t gUbxNavSatDecoded0 = {
+    477230000 /* iTOW */, 1 /* version */, 2 /* numSvs */,
+    {
+        {0 /* gnssId */, 5 /* svId */, 42 /* cno */, 61 /* elev */, 287 /* azim */, -12 /* prRes */, 0x191f /* flags */},
+        {2 /* gnssId */, 11 /* svId */, 38 /* cno */, 23 /* elev */, 45 /* azim */, 7 /* prRes */, 0x1917 /* flags */}
+    }
+};
+
+/** Array of test data for UBX-NAV-SAT.
+ */
+static const uGnssDecTestDataKnown_t gUbxNavSat[] = {
+    {
+        {
+            "\xb5\x62\x01\x35\x20\x00\xb0\xf3\x71\x1c\x01\x02\x00\x00\x00\x05"
+            "\x2a\x3d\x1f\x01\xf4\xff\x1f\x19\x00\x00\x02\x0b\x26\x17\x2d\x00"
+            "\x07\x00\x17\x19\x00\x00\xee\xee", 40
+        },
+        {
+            U_GNSS_PROTOCOL_UBX, 0x0135, NULL
+        },
+        (void *) &gUbxNavSatDecoded0
+    }
+};
+
+/** Decoded test data for UBX-NAV-SIG, to be used by gUbxNavSig (item 0).
+ */
+static const uGnssDecUbxNavSig_t gUbxNavSigDecoded0 = {
+    477230000 /* iTOW */, 0 /* version */, 2 /* numSigs */,
+    {
+        {
+            0 /* gnssId */, 5 /* svId */, 0 /* sigId */, 0 /* freqId */, -12 /* prRes */,
+            42 /* cno */, 7 /* qualityInd */, 0 /* corrSource */, 1 /* ionoModel */,
+            0x0029 /* sigFlags */
+        },
+        {
+            6 /* gnssId */, 12 /* svId */, 2 /* sigId */, 9 /* freqId */, 33 /* prRes */,
+            35 /* cno */, 5 /* qualityInd */, 4 /* corrSource */, 8 /* ionoModel */,
+            0x01e9 /* sigFlags */
+        }
+    }
+};
+
+/** Array of test data for UBX-NAV-SIG.
+ */
+static const uGnssDecTestDataKnown_t gUbxNavSig[] = {
+    {
+        {
+            "\xb5\x62\x01\x43\x28\x00\xb0\xf3\x71\x1c\x00\x02\x00\x00\x00\x05"
+            "\x00\x00\xf4\xff\x2a\x07\x00\x01\x29\x00\x00\x00\x00\x00\x06\x0c"
+            "\x02\x09\x21\x00\x23\x05\x04\x08\xe9\x01\x00\x00\x00\x00\x4d\xe9", 48
+        },
+        {
+            U_GNSS_PROTOCOL_UBX, 0x0143, NULL
+        },
+        (void *) &gUbxNavSigDecoded0
+    }
+};
+
+/** Decoded test data for UBX-NAV-COV, to be used by gUbxNavCov (item 0).
+ */
+static const uGnssDecUbxNavCov_t gUbxNavCovDecoded0 = {
+    477230000 /* iTOW */, 0 /* version */, 1 /* posCovValid */, 1 /* velCovValid */,
+    0.25f /* posCovNN */, 0.0625f /* posCovNE */, -0.125f /* posCovND */,
+    0.5f /* posCovEE */, 0.03125f /* posCovED */, 1.5f /* posCovDD */,
+    0.0078125f /* velCovNN */, -0.00390625f /* velCovNE */, 0.001953125f /* velCovND */,
+    0.015625f /* velCovEE */, -0.5f /* velCovED */, 2.25f /* velCovDD */
+};
+
+/** Array of test data for UBX-NAV-COV.
+ */
+static const uGnssDecTestDataKnown_t gUbxNavCov[] = {
+    {
+        {
+            "\xb5\x62\x01\x36\x40\x00\xb0\xf3\x71\x1c\x00\x01\x01\x00\x00\x00"
+            "\x00\x00\x00\x00\x00\x00\x00\x00\x80\x3e\x00\x00\x80\x3d\x00\x00"
+            "\x00\xbe\x00\x00\x00\x3f\x00\x00\x00\x3d\x00\x00\xc0\x3f\x00\x00"
+            "\x00\x3c\x00\x00\x80\xbb\x00\x00\x00\x3b\x00\x00\x80\x3c\x00\x00"
+            "\x00\xbf\x00\x00\x10\x40\xda\x8f", 72
+        },
+        {
+            U_GNSS_PROTOCOL_UBX, 0x0136, NULL
+        },
+        (void *) &gUbxNavCovDecoded0
+    }
+};
+
+/** Decoded test data for UBX-RXM-RAWX, to be used by gUbxRxmRawx (item 0).
+ */
+static const uGnssDecUbxRxmRawx_t gUbxRxmRawxDecoded0 = {
+    477230.0 /* rcvTow */, 2275 /* week */, 18 /* leapS */, 2 /* numMeas */,
+    0x01 /* recStat */, 1 /* version */,
+    {
+        {
+            21345678.5 /* prMes */, 112233445.25 /* cpMes */, -1234.5f /* doMes */,
+            0 /* gnssId */, 5 /* svId */, 0 /* sigId */, 0 /* freqId */,
+            64500 /* locktime */, 42 /* cno */, 5 /* prStdev */, 2 /* cpStdev */,
+            6 /* doStdev */, 0x07 /* trkStat */
+        },
+        {
+            23456789.75 /* prMes */, -987654.125 /* cpMes */, 321.25f /* doMes */,
+            6 /* gnssId */, 12 /* svId */, 0 /* sigId */, 9 /* freqId */,
+            1000 /* locktime */, 35 /* cno */, 7 /* prStdev */, 3 /* cpStdev */,
+            8 /* doStdev */, 0x01 /* trkStat */
+        }
+    }
+};
+
+/** Array of test data for UBX-RXM-RAWX.
+ */
+static const uGnssDecTestDataKnown_t gUbxRxmRawx[] = {
+    {
+        {
+            "\xb5\x62\x02\x15\x50\x00\x00\x00\x00\x00\xb8\x20\x1d\x41\xe3\x08"
+            "\x12\x02\x01\x01\x00\x00\x00\x00\x00\xe8\x58\x5b\x74\x41\x00\x00"
+            "\x00\x95\x2f\xc2\x9a\x41\x00\x50\x9a\xc4\x00\x05\x00\x00\xf4\xfb"
+            "\x2a\x05\x02\x06\x07\x00\x00\x00\x00\x5c\xc1\x5e\x76\x41\x00\x00"
+            "\x00\x40\x0c\x24\x2e\xc1\x00\xa0\xa0\x43\x06\x0c\x00\x09\xe8\x03"
+            "\x23\x07\x03\x08\x01\x00\x7f\x06", 88
+        },
+        {
+            U_GNSS_PROTOCOL_UBX, 0x0215, NULL
+        },
+        (void *) &gUbxRxmRawxDecoded0
+    }
+};
+
+/** Decoded test data for UBX-ESF-MEAS, to be used by gUbxEsfMeas (item 0).
+ */
+static const uGnssDecUbxEsfMeas_t gUbxEsfMeasDecoded0 = {
+    123456 /* timeTag */, 0x1808 /* flags */, 0 /* id */, 3 /* numMeas */,
+    {0x0e000123, 0x10ffff80, 0x0b0003e8} /* data */,
+    99999 /* calibTtag */
+};
+
+/** Array of test data for UBX-ESF-MEAS.
+ */
+static const uGnssDecTestDataKnown_t gUbxEsfMeas[] = {
+    {
+        {
+            "\xb5\x62\x10\x02\x18\x00\x40\xe2\x01\x00\x08\x18\x00\x00\x23\x01"
+            "\x00\x0e\x80\xff\xff\x10\xe8\x03\x00\x0b\x9f\x86\x01\x00\x49\x3e", 32
+        },
+        {
+            U_GNSS_PROTOCOL_UBX, 0x1002, NULL
+        },
+        (void *) &gUbxEsfMeasDecoded0
+    }
+};
+
+/** Decoded test data for UBX-TIM-TP, to be used by gUbxTimTp (item 0).
+ */
+static const uGnssDecUbxTimTp_t gUbxTimTpDecoded0 = {
+    477231000 /* towMS */, 0x80000000 /* towSubMS */, -1234 /* qErr */,
+    2275 /* week */, 0x03 /* flags */, 0x20 /* refInfo */
+};
+
+/** Array of test data for UBX-TIM-TP.
+ */
+static const uGnssDecTestDataKnown_t gUbxTimTp[] = {
+    {
+        {
+            "\xb5\x62\x0d\x01\x10\x00\x98\xf7\x71\x1c\x00\x00\x00\x80\x2e\xfb"
+            "\xff\xff\xe3\x08\x03\x20\xef\x56", 24
+        },
+        {
+            U_GNSS_PROTOCOL_UBX, 0x0d01, NULL
+        },
+        (void *) &gUbxTimTpDecoded0
+    }
+};
+
 /** Array of arrays of test vectors for all known message types.
  */
 static const uGnssDecTestDataKnownSet_t gTestDataKnownSet[] = {
     {gUbxNavPvt, sizeof(gUbxNavPvt) / sizeof(gUbxNavPvt[0]), sizeof(gUbxNavPvtDecoded0)},
-    {gUbxNavHpposllh, sizeof(gUbxNavHpposllh) / sizeof(gUbxNavHpposllh[0]), sizeof(gUbxNavHpposllhDecoded0)}
+    {gUbxNavHpposllh, sizeof(gUbxNavHpposllh) / sizeof(gUbxNavHpposllh[0]), sizeof(gUbxNavHpposllhDecoded0)},
+    {gUbxNavSat, sizeof(gUbxNavSat) / sizeof(gUbxNavSat[0]), sizeof(gUbxNavSatDecoded0)},
+    {gUbxNavSig, sizeof(gUbxNavSig) / sizeof(gUbxNavSig[0]), sizeof(gUbxNavSigDecoded0)},
+    {gUbxNavCov, sizeof(gUbxNavCov) / sizeof(gUbxNavCov[0]), sizeof(gUbxNavCovDecoded0)},
+    {gUbxRxmRawx, sizeof(gUbxRxmRawx) / sizeof(gUbxRxmRawx[0]), sizeof(gUbxRxmRawxDecoded0)},
+    {gUbxEsfMeas, sizeof(gUbxEsfMeas) / sizeof(gUbxEsfMeas[0]), sizeof(gUbxEsfMeasDecoded0)},
+    {gUbxTimTp, sizeof(gUbxTimTp) / sizeof(gUbxTimTp[0]), sizeof(gUbxTimTpDecoded0)}
 };
 
 /** Flag to share with the user callback.
  */
 static int32_t gCallback;
 
+/** Storage for uGnssDecUbxToStruct() to decode into.
+ */
+static uGnssDecUnion_t gDecoded;
+
 /** Sample data for testing the use callback: a few NMEA message
  * strings, taken from https://en.wikipedia.org/wiki/NMEA_0183,
  * some sample RTCM messages taken from
@@ -319,7 +511,8 @@ static const uGnssDecTestDataCallback_t gTestDataCallback[] = {
         },
         5
     },
-    // Fantasy
+    // Fantasy: U_GNSS_PROTOCOL_MAX_NUM, now 5 since U_GNSS_PROTOCOL_SPARTN
+    // took the value 4, is used as a protocol the decoder cannot know
     {
         {
             "\x00bibble", 7
@@ -337,6 +530,7 @@ static const size_t gCrcLength[] = {
     3, // U_GNSS_PROTOCOL_NMEA
     3, // U_GNSS_PROTOCOL_RTCM
     0, // U_GNSS_PROTOCOL_UNKNOWN (not used)
+    0, // U_GNSS_PROTOCOL_SPARTN (not used)
     0 // U_GNSS_PROTOCOL_MAX_NUM (fantasy protocol)
 };
 
@@ -707,4 +901,157 @@ U_PORT_TEST_FUNCTION("[gnssDec]", "gnssDecKnown")
     U_PORT_TEST_ASSERT(resourceCount <= 0);
 }
 
+/** Test of decoding UBX messages into a structure provided by the
+ * caller.
+ */
+U_PORT_TEST_FUNCTION("[gnssDec]", "gnssDecUbxToStruct")
+{
+    int32_t resourceCount;
+    const uGnssDecTestDataKnown_t *pTestData = NULL;
+    size_t decodedStructureSize;
+    size_t length;
+    char buffer[64];
+    int32_t x32;
+
+    // Get the initial resource count
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    // Decode all of the known UBX message types
+    for (size_t x = 0; x < sizeof(gTestDataKnownSet) / sizeof(gTestDataKnownSet[0]); x++) {
+        decodedStructureSize = gTestDataKnownSet[x].decodedStructureSize;
+        for (size_t y = 0; y < gTestDataKnownSet[x].size; y++) {
+            pTestData = gTestDataKnownSet[x].pTestData + y;
+            if (pTestData->id.type == U_GNSS_PROTOCOL_UBX) {
+                length = pTestData->raw.length - gCrcLength[pTestData->id.type];
+                x32 = uGnssDecUbxToStruct(pTestData->raw.p, length, &gDecoded, sizeof(gDecoded));
+                U_TEST_PRINT_LINE_X_Y("uGnssDecUbxToStruct() returned 0x%04x.", x, y, x32);
+                U_PORT_TEST_ASSERT(x32 == pTestData->id.idUbxOrRtcm);
+                U_PORT_TEST_ASSERT(memcmp(&gDecoded, pTestData->pDecoded, decodedStructureSize) == 0);
+                // Not enough room
+                x32 = uGnssDecUbxToStruct(pTestData->raw.p, length, &gDecoded, decodedStructureSize - 1);
+                U_PORT_TEST_ASSERT(x32 == (int32_t) U_ERROR_COMMON_INVALID_PARAMETER);
+                // Message cut short
+                x32 = uGnssDecUbxToStruct(pTestData->raw.p, length - 1, &gDecoded, sizeof(gDecoded));
+                U_PORT_TEST_ASSERT(x32 == (int32_t) U_ERROR_COMMON_TRUNCATED);
+            }
+        }
+    }
+
+    // A UBX-NAV-SAT message which claims more satellites than
+    // the message body contains
+    U_PORT_TEST_ASSERT(gUbxNavSat[0].raw.length <= sizeof(buffer));
+    memcpy(buffer, gUbxNavSat[0].raw.p, gUbxNavSat[0].raw.length);
+    buffer[U_UBX_PROTOCOL_HEADER_LENGTH_BYTES + 5]++;
+    x32 = uGnssDecUbxToStruct(buffer, gUbxNavSat[0].raw.length, &gDecoded, sizeof(gDecoded));
+    U_PORT_TEST_ASSERT(x32 == (int32_t) U_ERROR_COMMON_TRUNCATED);
+
+    // A UBX message that is not known and a message that is not UBX
+    x32 = uGnssDecUbxToStruct(gTestDataCallback[0].raw.p, gTestDataCallback[0].raw.length,
+                              &gDecoded, sizeof(gDecoded));
+    U_PORT_TEST_ASSERT(x32 == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED);
+    x32 = uGnssDecUbxToStruct(gTestDataCallback[2].raw.p, gTestDataCallback[2].raw.length,
+                              &gDecoded, sizeof(gDecoded));
+    U_PORT_TEST_ASSERT(x32 == (int32_t) U_ERROR_COMMON_UNKNOWN);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Test of decoding into storage provided by the caller, checking
+ * that no heap is used.
+ */
+U_PORT_TEST_FUNCTION("[gnssDec]", "gnssDecDecode")
+{
+    int32_t resourceCount;
+    int32_t heapAllocCount;
+    uGnssDec_t dec;
+    const uGnssDecTestDataKnown_t *pTestData = NULL;
+    const uGnssDecTestDataCallback_t *pTestDataCallback = NULL;
+    size_t decodedStructureSize;
+    size_t length;
+    int32_t x32;
+
+    // Get the initial resource count
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    // Decode all of the known message types and check that the
+    // result is the same as from pUGnssDecAlloc()
+    for (size_t x = 0; x < sizeof(gTestDataKnownSet) / sizeof(gTestDataKnownSet[0]); x++) {
+        decodedStructureSize = gTestDataKnownSet[x].decodedStructureSize;
+        for (size_t y = 0; y < gTestDataKnownSet[x].size; y++) {
+            pTestData = gTestDataKnownSet[x].pTestData + y;
+            length = pTestData->raw.length - gCrcLength[pTestData->id.type];
+            memset(&dec, 0xFF, sizeof(dec));
+            x32 = uGnssDecDecode(pTestData->raw.p, length, &dec, &gDecoded, sizeof(gDecoded));
+            U_TEST_PRINT_LINE_X_Y("uGnssDecDecode() returned %d.", x, y, x32);
+            U_PORT_TEST_ASSERT(x32 == 0);
+            U_PORT_TEST_ASSERT(dec.errorCode == 0);
+            U_PORT_TEST_ASSERT(dec.id.type == pTestData->id.type);
+            U_PORT_TEST_ASSERT(dec.id.id.ubx == pTestData->id.idUbxOrRtcm);
+            U_PORT_TEST_ASSERT(dec.pBody == &gDecoded);
+            U_PORT_TEST_ASSERT(memcmp(&gDecoded, pTestData->pDecoded, decodedStructureSize) == 0);
+            // Storage only just big enough
+            x32 = uGnssDecDecode(pTestData->raw.p, length, &dec, &gDecoded, decodedStructureSize);
+            U_PORT_TEST_ASSERT(x32 == 0);
+            // Storage not big enough
+            x32 = uGnssDecDecode(pTestData->raw.p, length, &dec, &gDecoded, decodedStructureSize - 1);
+            U_PORT_TEST_ASSERT(x32 == (int32_t) U_ERROR_COMMON_NO_MEMORY);
+            U_PORT_TEST_ASSERT(dec.errorCode == x32);
+            U_PORT_TEST_ASSERT(dec.pBody == NULL);
+        }
+    }
+
+    // Messages that are not known should give the same result
+    // as pUGnssDecAlloc() with no callback set, even if one is set
+    uGnssDecSetCallback(callback, (void *) &pTestDataCallback);
+    for (size_t x = 0; x < sizeof(gTestDataCallback) / sizeof(gTestDataCallback[0]); x++) {
+        pTestDataCallback = &(gTestDataCallback[x]);
+        gCallback = INT_MIN;
+        x32 = uGnssDecDecode(pTestDataCallback->raw.p, pTestDataCallback->raw.length,
+                             &dec, &gDecoded, sizeof(gDecoded));
+        U_TEST_PRINT_LINE_X("uGnssDecDecode() returned %d.", x, x32);
+        U_PORT_TEST_ASSERT(gCallback == INT_MIN);
+        U_PORT_TEST_ASSERT(dec.pBody == NULL);
+        if (pTestDataCallback->id.type == U_GNSS_PROTOCOL_MAX_NUM) {
+            U_PORT_TEST_ASSERT(x32 == (int32_t) U_ERROR_COMMON_UNKNOWN);
+            U_PORT_TEST_ASSERT(dec.id.type == U_GNSS_PROTOCOL_UNKNOWN);
+        } else {
+            U_PORT_TEST_ASSERT(x32 == (int32_t) U_ERROR_COMMON_NOT_SUPPORTED);
+            U_PORT_TEST_ASSERT(dec.id.type == pTestDataCallback->id.type);
+            if (dec.id.type == U_GNSS_PROTOCOL_NMEA) {
+                U_PORT_TEST_ASSERT(strcmp(dec.id.id.pNmea, pTestDataCallback->id.pIdNmea) == 0);
+            }
+        }
+    }
+    uGnssDecSetCallback(NULL, NULL);
+
+    // Now do lots of decodes, steady-state, and check that the heap
+    // is untouched: count pUPortMalloc() calls rather than what is
+    // outstanding, since the latter would not see an allocation
+    // that was free'd again within the decode
+    heapAllocCount = uPortHeapAllocCallCount();
+    for (size_t z = 0; z < U_GNSS_DEC_TEST_NO_HEAP_ITERATIONS; z++) {
+        for (size_t x = 0; x < sizeof(gTestDataKnownSet) / sizeof(gTestDataKnownSet[0]); x++) {
+            for (size_t y = 0; y < gTestDataKnownSet[x].size; y++) {
+                pTestData = gTestDataKnownSet[x].pTestData + y;
+                x32 = uGnssDecDecode(pTestData->raw.p, pTestData->raw.length, &dec,
+                                     &gDecoded, sizeof(gDecoded));
+                U_PORT_TEST_ASSERT(x32 == 0);
+                U_PORT_TEST_ASSERT(uPortHeapAllocCallCount() == heapAllocCount);
+            }
+        }
+    }
+    U_TEST_PRINT_LINE("%d iterations of all known messages, no heap allocations.",
+                      U_GNSS_DEC_TEST_NO_HEAP_ITERATIONS);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
 // End of file
@@ -161,6 +161,8 @@ typedef struct {
     bool nmeaSequenceHasBegun;
     size_t numNmeaSequence;
     size_t numNmeaBadSequence;
+    bool useSpans;
+    const uRingBufferSpan_t *pSpans;
 } uGnssMsgTestReceive_t;
 
 /* ----------------------------------------------------------------
@@ -257,6 +259,28 @@ static void checkMessageReceive(uGnssMessageId_t *pMessageId,
 // NRF52, which we use NRF5SDK on, doesn't have enough heap for this test
 #ifndef U_CFG_TEST_USING_NRF5SDK
 
+// Read a message in a non-blocking message receive callback, either
+// from the spans we were given or the usual way.
+static int32_t readMessage(uDeviceHandle_t gnssHandle,
+                           uGnssMsgTestReceive_t *pMsgReceive,
+                           int32_t size)
+{
+    int32_t length = 0;
+
+    if (pMsgReceive->pSpans != NULL) {
+        for (size_t x = 0; (x < U_RING_BUFFER_NUM_SPANS) &&
+             (pMsgReceive->pSpans[x].size > 0); x++) {
+            memcpy(pMsgReceive->pBuffer + length, pMsgReceive->pSpans[x].pData,
+                   pMsgReceive->pSpans[x].size);
+            length += (int32_t) pMsgReceive->pSpans[x].size;
+        }
+    } else {
+        length = uGnssMsgReceiveCallbackRead(gnssHandle, pMsgReceive->pBuffer, size);
+    }
+
+    return length;
+}
+
 // Callback for the non-blocking message receives.
 static void messageReceiveCallback(uDeviceHandle_t gnssHandle,
                                    const uGnssMessageId_t *pMessageId,
@@ -289,9 +313,7 @@ static void messageReceiveCallback(uDeviceHandle_t gnssHandle,
         }
         if ((errorCodeOrLength > 0) &&
             (errorCodeOrLength <= U_GNSS_MSG_TEST_MESSAGE_RECEIVE_NON_BLOCKING_BUFFER_SIZE_BYTES)) {
-            if (uGnssMsgReceiveCallbackRead(gnssHandle,
-                                            pMsgReceive->pBuffer,
-                                            errorCodeOrLength) == errorCodeOrLength) {
+            if (readMessage(gnssHandle, pMsgReceive, errorCodeOrLength) == errorCodeOrLength) {
                 pMsgReceive->numRead++;
                 pMsgReceive->numDecoded++;
                 // NOTE: uGnssTestPrivateNmeaComprehender() doesn't support
@@ -337,6 +359,31 @@ static void messageReceiveCallback(uDeviceHandle_t gnssHandle,
     }
 }
 
+// Callback for the non-blocking message receives that are given
+// the message in place.
+static void messageReceiveSpanCallback(uDeviceHandle_t gnssHandle,
+                                       const uGnssMessageId_t *pMessageId,
+                                       int32_t errorCodeOrLength,
+                                       const uRingBufferSpan_t *pSpans,
+                                       void *pCallbackParam)
+{
+    uGnssMsgTestReceive_t *pMsgReceive = (uGnssMsgTestReceive_t *) pCallbackParam;
+
+    if (pSpans == NULL) {
+        gCallbackErrorCode = 6;
+    } else if ((errorCodeOrLength > 0) &&
+               (pSpans[0].size + pSpans[1].size != (size_t) errorCodeOrLength)) {
+        gCallbackErrorCode = 7;
+    }
+    if (pMsgReceive != NULL) {
+        pMsgReceive->pSpans = pSpans;
+    }
+    messageReceiveCallback(gnssHandle, pMessageId, errorCodeOrLength, pCallbackParam);
+    if (pMsgReceive != NULL) {
+        pMsgReceive->pSpans = NULL;
+    }
+}
+
 #endif // #ifndef U_CFG_TEST_USING_NRF5SDK 
 
 /* ----------------------------------------------------------------
@@ -494,6 +541,7 @@ U_PORT_TEST_FUNCTION("[gnssMsg]", "gnssMsgReceiveNonBlocking")
     size_t iterations;
     uGnssTransportType_t transportTypes[U_GNSS_TRANSPORT_MAX_NUM];
     uGnssCommunicationStats_t communicationStats;
+    uGnssMsgReceiveLatency_t latency = {0};
     const char *pProtocolName;
 
     // In case a previous test failed
@@ -562,19 +610,32 @@ U_PORT_TEST_FUNCTION("[gnssMsg]", "gnssMsgReceiveNonBlocking")
                             pTmp->numDecodedMin = U_GNSS_MSG_TEST_MESSAGE_RECEIVE_NON_BLOCKING_MIN_STEPS;
                         }
                     } else  {
-                        // Just NMEA this time
+                        // Just NMEA this time, every other one
+                        // being given the messages in place
                         pTmp->useNmeaComprehender = true;
+                        pTmp->useSpans = ((x % 2) != 0);
                     }
                 }
 
+                // Do the "just NMEA" run with the receive task event-driven,
+                // which will fall back to polling on I2C
+                U_PORT_TEST_ASSERT(uGnssMsgReceiveSetEventDriven(gnssHandle, (z > 0), -1) == 0);
+
                 // Hook them in, passing a pointer to the entry as the callback parameter
                 gCallbackErrorCode = 0;
                 for (size_t x = 0; x < sizeof(gpMessageReceive) / sizeof(gpMessageReceive[0]); x++) {
                     pTmp = gpMessageReceive[x];
-                    pTmp->asyncHandle = uGnssMsgReceiveStart(gnssHandle,
-                                                             &(pTmp->messageId),
-                                                             messageReceiveCallback,
-                                                             (void *) pTmp);
+                    if (pTmp->useSpans) {
+                        pTmp->asyncHandle = uGnssMsgReceiveStartSpans(gnssHandle,
+                                                                      &(pTmp->messageId),
+                                                                      messageReceiveSpanCallback,
+                                                                      (void *) pTmp);
+                    } else {
+                        pTmp->asyncHandle = uGnssMsgReceiveStart(gnssHandle,
+                                                                 &(pTmp->messageId),
+                                                                 messageReceiveCallback,
+                                                                 (void *) pTmp);
+                    }
                     pTmp->moduleType = pModule->moduleType;
                     U_PORT_TEST_ASSERT(pTmp->asyncHandle >= 0);
                 }
@@ -612,6 +673,7 @@ U_PORT_TEST_FUNCTION("[gnssMsg]", "gnssMsgReceiveNonBlocking")
                 // stop everything; not asserting here so that we can see what
                 // the outcome of all the above was first
                 a = uGnssMsgReceiveStackMinFree(gnssHandle);
+                uGnssMsgReceiveStatLatency(gnssHandle, &latency);
                 uPortTaskBlock(100);
                 b = uGnssMsgReceiveStopAll(gnssHandle);
                 uPortTaskBlock(100);
@@ -705,9 +767,18 @@ U_PORT_TEST_FUNCTION("[gnssMsg]", "gnssMsgReceiveNonBlocking")
                     U_TEST_PRINT_LINE("the minimum stack of the callback task was %d.", a);
                 }
                 U_TEST_PRINT_LINE("the callback error code was %d.", gCallbackErrorCode);
+                U_TEST_PRINT_LINE("the %s receive task passed on %u message(s), latency"
+                                  " min %d ms, average %d ms, max %d ms.",
+                                  latency.eventDriven ? "event-driven" : "polling",
+                                  (unsigned) latency.count, latency.minMs, latency.averageMs,
+                                  latency.maxMs);
 
                 // Now do the asserting
                 U_PORT_TEST_ASSERT(!bad);
+                U_PORT_TEST_ASSERT(latency.count > 0);
+                U_PORT_TEST_ASSERT(latency.eventDriven ==
+                                   ((z > 0) && (transportTypes[w] != U_GNSS_TRANSPORT_I2C)));
+                U_PORT_TEST_ASSERT(uGnssMsgReceiveSetEventDriven(gnssHandle, false, -1) == 0);
                 U_PORT_TEST_ASSERT((a == U_ERROR_COMMON_NOT_SUPPORTED) ||
                                    (a >= U_GNSS_MSG_TEST_MESSAGE_RECEIVE_TASK_THRESHOLD_BYTES));
                 U_PORT_TEST_ASSERT(b == 0);
@@ -57,6 +57,9 @@
 #include "u_port_heap.h"
 #include "u_port_debug.h"
 
+#include "u_interface.h"
+#include "u_device_serial.h"
+
 #include "u_test_util_resource_check.h"
 
 #include "u_ringbuffer.h"
@@ -64,6 +67,7 @@
 #include "u_gnss_module_type.h"
 #include "u_gnss_type.h"
 #include "u_gnss.h"
+#include "u_gnss_msg.h"
 #include "u_gnss_private.h"
 
 /* ----------------------------------------------------------------
@@ -110,6 +114,28 @@
 # define U_GNSS_PRIVATE_TEST_RINGBUFFER_SIZE 2048
 #endif
 
+#ifndef U_GNSS_PRIVATE_TEST_SCAN_RINGBUFFER_SIZE
+/** The size of ring buffer to use in the scan test: deliberately
+ * small so that messages wrap.
+ */
+# define U_GNSS_PRIVATE_TEST_SCAN_RINGBUFFER_SIZE 512
+#endif
+
+#ifndef U_GNSS_PRIVATE_TEST_SCAN_CHUNK_MAX_BYTES
+/** The largest chunk of data to add to the ring buffer in one go
+ * in the scan test.
+ */
+# define U_GNSS_PRIVATE_TEST_SCAN_CHUNK_MAX_BYTES 64
+#endif
+
+#ifndef U_GNSS_PRIVATE_TEST_EVENT_COALESCE_MS
+/** The coalesce time to use when testing the event-driven message
+ * receive task: large enough to be measured reliably yet well short
+ * of #U_GNSS_MSG_RECEIVE_EVENT_GUARD_TIME_MS.
+ */
+# define U_GNSS_PRIVATE_TEST_EVENT_COALESCE_MS 100
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
@@ -139,6 +165,26 @@ typedef struct {
     uint16_t id;
 } uGnssPrivateTestRtcmMatch_t;
 
+/** Struct to hold a pointer to some SPARTN test data and a matching ID.
+ */
+typedef struct {
+    const char *pSpartn;
+    size_t spartnSize;
+    uint16_t id;
+} uGnssPrivateTestSpartnMatch_t;
+
+/** The context of the virtual serial device that stands in for
+ * the GNSS transport when testing the event-driven message receive
+ * task.
+ */
+typedef struct {
+    uPortMutexHandle_t mutexHandle;
+    const char *pData; /**< the data waiting to be read. */
+    size_t size;       /**< the amount of data waiting to be read. */
+    void (*pEventCallback)(struct uDeviceSerial_t *, uint32_t, void *);
+    void *pEventCallbackParam;
+} uGnssPrivateTestSerialContext_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -159,6 +205,25 @@ static uRingBuffer_t gRingBuffer = {0};
  */
 static char *gpBody = NULL;
 
+/** A place to hook the virtual serial device used when testing the
+ * event-driven message receive task.
+ */
+static uDeviceSerial_t *gpDeviceSerial = NULL;
+
+/** The number of messages passed to eventMessageCallback().
+ */
+static volatile int32_t gEventMessageCount = 0;
+
+/** The tick time at which eventMessageCallback() was last called.
+ */
+static volatile int32_t gEventMessageTimeMs = 0;
+
+/** An NMEA message for the event-driven message receive test,
+ * taken from https://en.wikipedia.org/wiki/NMEA_0183.
+ */
+static const char gEventNmeaMessage[] = "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,"
+                                        "1.03,61.7,M,55.2,M,,*76\r\n";
+
 # ifndef __ZEPHYR__
 
 /** Some sample NMEA message strings, taken from
@@ -297,6 +362,24 @@ static const uGnssPrivateTestRtcmMatch_t gRtcmTestMessage[] = {
     }
 };
 
+/** Some sample SPARTN messages, taken from the SPARTN test data in
+ * common/spartn/test; the ID is the message type in the upper byte
+ * and the message sub-type in the lower byte.
+ */
+static const uGnssPrivateTestSpartnMatch_t gSpartnTestMessage[] = {
+    {
+        "\x73\x04\x07\xE4\x05\x0A\xF0\x6C\x25\x48\x24\x44\xBC\xCF\x80\x36"
+        "\x4D\xE8\x31\xB7\x5F\x94\x4B\xBF\xC8\xBF\xA0\xD7",
+        28, 0x0200
+    },
+    {
+        "\x73\x00\x0E\xEC\x11\x15\x90\x6C\x23\xC8\xEF\x48\x7A\xAB\xC7\x95"
+        "\xA8\x62\xB3\x2F\x88\x18\x30\xA3\x58\x02\x58\x9F\x23\xC6\x83\xE6"
+        "\xBF\x82\xDA\x20\xE6\x53\x84\x8E\x71\x2A",
+        42, 0x0001
+    }
+};
+
 #endif // #ifndef __ZEPHYR__
 
 /* ----------------------------------------------------------------
@@ -307,12 +390,13 @@ static const uGnssPrivateTestRtcmMatch_t gRtcmTestMessage[] = {
 
 // Fill a buffer with safe randomness: avoiding dollar (start of an
 // NMEA message) or 0xb5 (start of a UBX-format message) or a
-// 0xd3 (start of an RTCM message).
+// 0xd3 (start of an RTCM message) or 0x73 (start of a SPARTN message).
 static void fillBufferRand(char *pBuffer, size_t size)
 {
     for (size_t x = 0; x < size; x++, pBuffer++) {
         *pBuffer = (char) rand();
-        if ((*pBuffer == '$') || (*pBuffer == 0xd3) || (*pBuffer == 0xb5)) {
+        if ((*pBuffer == '$') || (*pBuffer == 0xd3) || (*pBuffer == 0xb5) ||
+            (*pBuffer == 0x73)) {
             *pBuffer = '_';
         }
     }
@@ -384,7 +468,7 @@ static bool checkDecodeNmea(uRingBuffer_t *pRingBuffer, int32_t readHandle,
 
     // Add pBuffer to the ring buffer and attempt to decode the message
     U_PORT_TEST_ASSERT(uRingBufferAdd(pRingBuffer, pBuffer, bufferSize));
-    errorCodeOrSize = uGnssPrivateStreamDecodeRingBuffer(pRingBuffer, readHandle, &msgId);
+    errorCodeOrSize = uGnssPrivateStreamDecodeRingBuffer(pRingBuffer, readHandle, &msgId, NULL);
     if (errorCodeOrSize != expectedReturnValue) {
         passNotFail = false;
         uPortLog(U_TEST_PREFIX "decoding buffer \"");
@@ -430,7 +514,7 @@ static bool checkDecodeRtcm(uRingBuffer_t *pRingBuffer, int32_t readHandle,
 
     // Add pBuffer to the ring buffer and attempt to decode the message
     U_PORT_TEST_ASSERT(uRingBufferAdd(pRingBuffer, pBuffer, bufferSize));
-    errorCodeOrSize = uGnssPrivateStreamDecodeRingBuffer(pRingBuffer, readHandle, &msgId);
+    errorCodeOrSize = uGnssPrivateStreamDecodeRingBuffer(pRingBuffer, readHandle, &msgId, NULL);
     if (errorCodeOrSize != expectedReturnValue) {
         passNotFail = false;
         uPortLog(U_TEST_PREFIX "decoding buffer \"");
@@ -452,6 +536,45 @@ static bool checkDecodeRtcm(uRingBuffer_t *pRingBuffer, int32_t readHandle,
     return passNotFail;
 }
 
+// Call uRingBufferParseHandle() with the given parameters and
+// return true if good, else false; SPARTN flavour.
+static bool checkDecodeSpartn(uRingBuffer_t *pRingBuffer, int32_t readHandle,
+                              const char *pBuffer, size_t bufferSize,
+                              uint16_t id, int32_t expectedReturnValue)
+{
+    uGnssPrivateMessageId_t msgId = {0};
+    bool passNotFail = true;
+    int32_t errorCodeOrSize;
+
+    msgId.type = U_GNSS_PROTOCOL_SPARTN;
+    msgId.id.spartn = id;
+
+    // Add pBuffer to the ring buffer and attempt to decode the message
+    U_PORT_TEST_ASSERT(uRingBufferAdd(pRingBuffer, pBuffer, bufferSize));
+    errorCodeOrSize = uGnssPrivateStreamDecodeRingBuffer(pRingBuffer, readHandle, &msgId, NULL);
+    if (errorCodeOrSize != expectedReturnValue) {
+        passNotFail = false;
+        uPortLog(U_TEST_PREFIX "decoding buffer \"");
+        for (size_t x = 0; x < bufferSize; x++) {
+            uPortLog("[%02x]", (unsigned char) *pBuffer);
+            pBuffer++;
+        }
+        uPortLog("\" (%d bytes)\n", bufferSize);
+        uPortLog(U_TEST_PREFIX "with ID 0x%04x", id);
+        uPortLog(", failed to meet expectations:\n");
+        U_TEST_PRINT_LINE("expected return value %d, actual return value %d.",
+                          expectedReturnValue, errorCodeOrSize);
+    }
+    if (errorCodeOrSize > 0) {
+        U_PORT_TEST_ASSERT(msgId.type == U_GNSS_PROTOCOL_SPARTN);
+    }
+
+    // Remove the message from the ring buffer
+    uRingBufferReadHandle(pRingBuffer, readHandle, NULL, bufferSize);
+
+    return passNotFail;
+}
+
 // Call uRingBufferParseHandle() with the given parameters and
 // return true if good, else false; UBX flavour.
 static bool checkDecodeUbx(uRingBuffer_t *pRingBuffer, int32_t readHandle,
@@ -468,7 +591,7 @@ static bool checkDecodeUbx(uRingBuffer_t *pRingBuffer, int32_t readHandle,
 
     // Add pBuffer to the ring buffer and attempt to decode the message
     U_PORT_TEST_ASSERT(uRingBufferAdd(pRingBuffer, pBuffer, bufferSize));
-    errorCodeOrSize = uGnssPrivateStreamDecodeRingBuffer(pRingBuffer, readHandle, &msgId);
+    errorCodeOrSize = uGnssPrivateStreamDecodeRingBuffer(pRingBuffer, readHandle, &msgId, NULL);
     if (errorCodeOrSize != expectedReturnValue) {
         passNotFail = false;
         uPortLog(U_TEST_PREFIX "decoding buffer \"");
@@ -492,6 +615,131 @@ static bool checkDecodeUbx(uRingBuffer_t *pRingBuffer, int32_t readHandle,
 
 #endif // #ifndef __ZEPHYR__
 
+// Get the number of bytes waiting to be read from the test
+// virtual serial device.
+static int32_t testSerialGetReceiveSize(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uGnssPrivateTestSerialContext_t *pContext = (uGnssPrivateTestSerialContext_t *)
+                                                pUInterfaceContext(pDeviceSerial);
+    int32_t size;
+
+    U_PORT_MUTEX_LOCK(pContext->mutexHandle);
+    size = (int32_t) pContext->size;
+    U_PORT_MUTEX_UNLOCK(pContext->mutexHandle);
+
+    return size;
+}
+
+// Read from the test virtual serial device.
+static int32_t testSerialRead(struct uDeviceSerial_t *pDeviceSerial,
+                              void *pBuffer, size_t sizeBytes)
+{
+    uGnssPrivateTestSerialContext_t *pContext = (uGnssPrivateTestSerialContext_t *)
+                                                pUInterfaceContext(pDeviceSerial);
+
+    U_PORT_MUTEX_LOCK(pContext->mutexHandle);
+    if (sizeBytes > pContext->size) {
+        sizeBytes = pContext->size;
+    }
+    memcpy(pBuffer, pContext->pData, sizeBytes);
+    pContext->pData += sizeBytes;
+    pContext->size -= sizeBytes;
+    U_PORT_MUTEX_UNLOCK(pContext->mutexHandle);
+
+    return (int32_t) sizeBytes;
+}
+
+// Set an event callback on the test virtual serial device; there
+// is no event task, the test calls the callback itself.
+static int32_t testSerialEventCallbackSet(struct uDeviceSerial_t *pDeviceSerial,
+                                          uint32_t filter,
+                                          void (*pFunction)(struct uDeviceSerial_t *,
+                                                            uint32_t,
+                                                            void *),
+                                          void *pParam,
+                                          size_t stackSizeBytes,
+                                          int32_t priority)
+{
+    uGnssPrivateTestSerialContext_t *pContext = (uGnssPrivateTestSerialContext_t *)
+                                                pUInterfaceContext(pDeviceSerial);
+    (void) filter;
+    (void) stackSizeBytes;
+    (void) priority;
+
+    pContext->pEventCallback = pFunction;
+    pContext->pEventCallbackParam = pParam;
+
+    return 0;
+}
+
+// Remove the event callback from the test virtual serial device.
+static void testSerialEventCallbackRemove(struct uDeviceSerial_t *pDeviceSerial)
+{
+    uGnssPrivateTestSerialContext_t *pContext = (uGnssPrivateTestSerialContext_t *)
+                                                pUInterfaceContext(pDeviceSerial);
+    pContext->pEventCallback = NULL;
+    pContext->pEventCallbackParam = NULL;
+}
+
+// Populate the vector table of the test virtual serial device.
+static void testSerialInit(struct uDeviceSerial_t *pDeviceSerial)
+{
+    pDeviceSerial->getReceiveSize = testSerialGetReceiveSize;
+    pDeviceSerial->read = testSerialRead;
+    pDeviceSerial->eventCallbackSet = testSerialEventCallbackSet;
+    pDeviceSerial->eventCallbackRemove = testSerialEventCallbackRemove;
+}
+
+// Make some data available to be read from the test virtual
+// serial device and, if dataEvent is true, tell the reader.
+static void testSerialAdd(struct uDeviceSerial_t *pDeviceSerial,
+                          const char *pData, size_t size, bool dataEvent)
+{
+    uGnssPrivateTestSerialContext_t *pContext = (uGnssPrivateTestSerialContext_t *)
+                                                pUInterfaceContext(pDeviceSerial);
+
+    U_PORT_MUTEX_LOCK(pContext->mutexHandle);
+    pContext->pData = pData;
+    pContext->size = size;
+    U_PORT_MUTEX_UNLOCK(pContext->mutexHandle);
+
+    if (dataEvent && (pContext->pEventCallback != NULL)) {
+        pContext->pEventCallback(pDeviceSerial,
+                                 U_DEVICE_SERIAL_EVENT_BITMASK_DATA_RECEIVED,
+                                 pContext->pEventCallbackParam);
+    }
+}
+
+// Message receive callback for the event-driven message receive test.
+static void eventMessageCallback(uDeviceHandle_t gnssHandle,
+                                 const uGnssMessageId_t *pMessageId,
+                                 int32_t errorCodeOrLength,
+                                 void *pCallbackParam)
+{
+    (void) gnssHandle;
+    (void) pMessageId;
+    (void) pCallbackParam;
+
+    if (errorCodeOrLength == (int32_t) sizeof(gEventNmeaMessage) - 1) {
+        gEventMessageTimeMs = uPortGetTickTimeMs();
+        gEventMessageCount++;
+    }
+}
+
+// Wait for eventMessageCallback() to have been called the given
+// number of times, returning true if it was.
+static bool eventMessageWait(int32_t count, int32_t timeoutMs)
+{
+    int32_t startTimeMs = uPortGetTickTimeMs();
+
+    while ((gEventMessageCount < count) &&
+           (uPortGetTickTimeMs() - startTimeMs < timeoutMs)) {
+        uPortTaskBlock(10);
+    }
+
+    return (gEventMessageCount >= count);
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -756,6 +1004,112 @@ U_PORT_TEST_FUNCTION("[gnss]", "gnssPrivateRtcm")
     U_PORT_TEST_ASSERT(resourceCount <= 0);
 }
 
+/** Test the SPARTN message decode function; not tested on Zephyr for
+ * the same reasons as the test gnssPrivateNmea.
+ */
+U_PORT_TEST_FUNCTION("[gnss]", "gnssPrivateSpartn")
+{
+    const uGnssPrivateTestSpartnMatch_t *pSpartnTest;
+    int32_t readHandle;
+    char *pMessage;
+    size_t bufferSize;
+    size_t z;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    // Allocate memory to use for the ring buffer
+    gpLinearBuffer = (char *) pUPortMalloc(U_GNSS_PRIVATE_TEST_RINGBUFFER_SIZE);
+    U_PORT_TEST_ASSERT(gpLinearBuffer != NULL);
+
+    // Create a ring buffer from the linear buffer with a single read handle allowed
+    U_PORT_TEST_ASSERT(uRingBufferCreateWithReadHandle(&gRingBuffer, gpLinearBuffer,
+                                                       U_GNSS_PRIVATE_TEST_RINGBUFFER_SIZE,
+                                                       1) == 0);
+
+    // Set this so that the default non-handled read doesn't hold on
+    // to data in the ring buffer
+    uRingBufferSetReadRequiresHandle(&gRingBuffer, true);
+
+    // Grab a read handle for it
+    readHandle = uRingBufferTakeReadHandle(&gRingBuffer);
+    U_PORT_TEST_ASSERT(readHandle >= 0);
+
+    // Parse all the test data
+    for (size_t x = 0; x < sizeof(gSpartnTestMessage) / sizeof(gSpartnTestMessage[0]); x++) {
+        pSpartnTest = &(gSpartnTestMessage[x]);
+        bufferSize = pSpartnTest->spartnSize + U_GNSS_PRIVATE_TEST_RUBBISH_ROOM_BYTES;
+        // Allocate a buffer to decode from
+        gpBuffer = (char *) pUPortMalloc(bufferSize);
+        U_PORT_TEST_ASSERT(gpBuffer != NULL);
+
+        U_TEST_PRINT_LINE("test decoding SPARTN message %d (ID 0x%04x, %d byte(s)).",
+                          x + 1, pSpartnTest->id, pSpartnTest->spartnSize);
+
+        // Do this multiple times for good randomness
+        for (size_t y = 0; y < U_GNSS_PRIVATE_TEST_NUM_LOOPS; y++) {
+            // Fill the buffer with safe randomness
+            fillBufferRand(gpBuffer, bufferSize);
+
+            // Copy in the message, starting a random distance into the buffer
+            pMessage = gpBuffer + (rand() % U_GNSS_PRIVATE_TEST_RUBBISH_ROOM_BYTES);
+            memcpy(pMessage, pSpartnTest->pSpartn, pSpartnTest->spartnSize);
+
+            // Decode it with a wild-card message ID first
+            U_PORT_TEST_ASSERT(checkDecodeSpartn(&gRingBuffer, readHandle, gpBuffer, bufferSize,
+                                                 U_GNSS_SPARTN_MESSAGE_ALL,
+                                                 pSpartnTest->spartnSize));
+
+            // Then with the exact message ID
+            U_PORT_TEST_ASSERT(checkDecodeSpartn(&gRingBuffer, readHandle, gpBuffer, bufferSize,
+                                                 pSpartnTest->id, pSpartnTest->spartnSize));
+
+            // Then with just the message type
+            U_PORT_TEST_ASSERT(checkDecodeSpartn(&gRingBuffer, readHandle, gpBuffer, bufferSize,
+                                                 pSpartnTest->id | U_GNSS_SPARTN_MESSAGE_SUB_TYPE_ALL,
+                                                 pSpartnTest->spartnSize));
+
+            // Then with a wrong message ID
+            z = (pSpartnTest->id + 0x0100) & 0x7F0F;
+            U_PORT_TEST_ASSERT(checkDecodeSpartn(&gRingBuffer, readHandle, gpBuffer, bufferSize,
+                                                 (uint16_t) z, U_ERROR_COMMON_TIMEOUT));
+
+            // Then with a broken message
+            z = rand() % pSpartnTest->spartnSize;
+            *(pMessage + z) = ~*(pMessage + z);
+            U_PORT_TEST_ASSERT(checkDecodeSpartn(&gRingBuffer, readHandle, gpBuffer, bufferSize,
+                                                 U_GNSS_SPARTN_MESSAGE_ALL, U_ERROR_COMMON_TIMEOUT));
+        }
+
+        // Some platforms run a task watchdog which might be starved with such
+        // a large processing loop: give it a bone
+        uPortTaskBlock(U_CFG_OS_YIELD_MS);
+
+        // Free memory
+        uPortFree(gpBuffer);
+        gpBuffer = NULL;
+    }
+
+    // Free memory.
+    uRingBufferDelete(&gRingBuffer);
+    uPortFree(gpLinearBuffer);
+    gpLinearBuffer = NULL;
+
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
 /** Test the UBX message decode function; not tested on Zephyr for
  * the same reasons as the test gnssPrivateNmea.
  */
@@ -888,8 +1242,296 @@ U_PORT_TEST_FUNCTION("[gnss]", "gnssPrivateUbx")
     U_PORT_TEST_ASSERT(resourceCount <= 0);
 }
 
+/** Test that the message scanner, given a stream of UBX, NMEA and
+ * RTCM messages mixed with rubbish, arriving in random-sized chunks,
+ * finds every message and scans each byte of the stream only once;
+ * not tested on Zephyr for the same reasons as the test gnssPrivateNmea.
+ */
+U_PORT_TEST_FUNCTION("[gnss]", "gnssPrivateScan")
+{
+    int32_t readHandle;
+    uGnssPrivateScanner_t scanner = {0};
+    uGnssPrivateMessageId_t msgId;
+    char *pMessage;
+    size_t messageSize;
+    uGnssProtocol_t messageType;
+    size_t rubbishSize;
+    size_t rubbishFound;
+    size_t streamSize = 0;
+    size_t chunkSize;
+    size_t messageCount = 0;
+    int32_t errorCodeOrSize;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    gpLinearBuffer = (char *) pUPortMalloc(U_GNSS_PRIVATE_TEST_SCAN_RINGBUFFER_SIZE);
+    U_PORT_TEST_ASSERT(gpLinearBuffer != NULL);
+    U_PORT_TEST_ASSERT(uRingBufferCreateWithReadHandle(&gRingBuffer, gpLinearBuffer,
+                                                       U_GNSS_PRIVATE_TEST_SCAN_RINGBUFFER_SIZE,
+                                                       1) == 0);
+    uRingBufferSetReadRequiresHandle(&gRingBuffer, true);
+    readHandle = uRingBufferTakeReadHandle(&gRingBuffer);
+    U_PORT_TEST_ASSERT(readHandle >= 0);
+
+    // Room for rubbish plus the largest message: a UBX message
+    // with a body of up to 100 bytes or the longest RTCM message
+    gpBuffer = (char *) pUPortMalloc(U_GNSS_PRIVATE_TEST_RUBBISH_ROOM_BYTES +
+                                     U_UBX_PROTOCOL_OVERHEAD_LENGTH_BYTES + 100 + 160);
+    U_PORT_TEST_ASSERT(gpBuffer != NULL);
+    gpBody = (char *) pUPortMalloc(100);
+    U_PORT_TEST_ASSERT(gpBody != NULL);
+
+    U_TEST_PRINT_LINE("testing scanning of a mixed stream, %d loops.",
+                      U_GNSS_PRIVATE_TEST_NUM_LOOPS);
+    for (size_t x = 0; x < U_GNSS_PRIVATE_TEST_NUM_LOOPS; x++) {
+        // Some rubbish and then a random message
+        rubbishSize = rand() % U_GNSS_PRIVATE_TEST_RUBBISH_ROOM_BYTES;
+        fillBufferRand(gpBuffer, rubbishSize);
+        pMessage = gpBuffer + rubbishSize;
+        switch (rand() % 3) {
+            case 0:
+                messageType = U_GNSS_PROTOCOL_UBX;
+                messageSize = rand() % 100;
+                fillBufferRand(gpBody, messageSize);
+                messageSize = uUbxProtocolEncode((uint8_t) rand(), (uint8_t) rand(),
+                                                 gpBody, messageSize, pMessage);
+                break;
+            case 1:
+            {
+                const uGnssPrivateTestNmea_t *pNmea = &(gNmeaTestMessage[rand() %
+                                                                         (sizeof(gNmeaTestMessage) /
+                                                                          sizeof(gNmeaTestMessage[0]))]);
+                messageType = U_GNSS_PROTOCOL_NMEA;
+                messageSize = makeNmeaMessage(pMessage, pNmea->pTalkerSentenceStr,
+                                              pNmea->pBodyStr, pNmea->pChecksumHexStr);
+            }
+            break;
+            default:
+            {
+                const uGnssPrivateTestRtcmMatch_t *pRtcm = &(gRtcmTestMessage[rand() %
+                                                                               (sizeof(gRtcmTestMessage) /
+                                                                                sizeof(gRtcmTestMessage[0]))]);
+                messageType = U_GNSS_PROTOCOL_RTCM;
+                messageSize = pRtcm->rtcmSize;
+                memcpy(pMessage, pRtcm->pRtcm, messageSize);
+            }
+            break;
+        }
+        streamSize += rubbishSize + messageSize;
+
+        // Feed it in, in chunks, decoding as we go: the rubbish may be
+        // returned in pieces but must all come out before the message
+        rubbishFound = 0;
+        errorCodeOrSize = (int32_t) U_ERROR_COMMON_TIMEOUT;
+        for (size_t y = 0; (y < rubbishSize + messageSize) ||
+             (errorCodeOrSize != (int32_t) U_ERROR_COMMON_TIMEOUT);) {
+            chunkSize = 0;
+            if (y < rubbishSize + messageSize) {
+                chunkSize = 1 + (rand() % U_GNSS_PRIVATE_TEST_SCAN_CHUNK_MAX_BYTES);
+                if (chunkSize > rubbishSize + messageSize - y) {
+                    chunkSize = rubbishSize + messageSize - y;
+                }
+                U_PORT_TEST_ASSERT(uRingBufferAdd(&gRingBuffer, gpBuffer + y, chunkSize));
+                y += chunkSize;
+            }
+            msgId.type = U_GNSS_PROTOCOL_ALL;
+            errorCodeOrSize = uGnssPrivateStreamDecodeRingBuffer(&gRingBuffer, readHandle,
+                                                                 &msgId, &scanner);
+            if (errorCodeOrSize > 0) {
+                if (msgId.type == U_GNSS_PROTOCOL_UNKNOWN) {
+                    rubbishFound += errorCodeOrSize;
+                    U_PORT_TEST_ASSERT(rubbishFound <= rubbishSize);
+                } else {
+                    U_PORT_TEST_ASSERT(rubbishFound == rubbishSize);
+                    U_PORT_TEST_ASSERT(msgId.type == messageType);
+                    U_PORT_TEST_ASSERT(errorCodeOrSize == (int32_t) messageSize);
+                    messageCount++;
+                }
+                U_PORT_TEST_ASSERT(uRingBufferReadHandle(&gRingBuffer, readHandle, NULL,
+                                                         errorCodeOrSize) == (size_t) errorCodeOrSize);
+            } else {
+                U_PORT_TEST_ASSERT(errorCodeOrSize == (int32_t) U_ERROR_COMMON_TIMEOUT);
+            }
+        }
+        U_PORT_TEST_ASSERT(messageCount == x + 1);
+        U_PORT_TEST_ASSERT(uRingBufferDataSizeHandle(&gRingBuffer, readHandle) == 0);
+
+        if ((x % 100) == 0) {
+            // Some platforms run a task watchdog which might be starved with such
+            // a large processing loop: give it a bone
+            uPortTaskBlock(U_CFG_OS_YIELD_MS);
+        }
+    }
+
+    // Since there is no rubbish that looks like the start of a message,
+    // every byte should have been scanned exactly once
+    U_TEST_PRINT_LINE("%d message(s) in %d byte(s), %d byte(s) scanned.",
+                      messageCount, streamSize, scanner.scanned);
+    U_PORT_TEST_ASSERT(scanner.scanned == streamSize);
+
+    // Asking for SPARTN in one call must not leave the
+    // scanner hunting for SPARTN in the calls that follow
+    U_PORT_TEST_ASSERT(!scanner.spartn);
+    msgId.type = U_GNSS_PROTOCOL_SPARTN;
+    msgId.id.spartn = U_GNSS_SPARTN_MESSAGE_ALL;
+    U_PORT_TEST_ASSERT(uGnssPrivateStreamDecodeRingBuffer(&gRingBuffer, readHandle,
+                                                          &msgId, &scanner) ==
+                       (int32_t) U_ERROR_COMMON_TIMEOUT);
+    U_PORT_TEST_ASSERT(!scanner.spartn);
+
+    // Free memory.
+    uPortFree(gpBody);
+    gpBody = NULL;
+    uPortFree(gpBuffer);
+    gpBuffer = NULL;
+    uRingBufferDelete(&gRingBuffer);
+    uPortFree(gpLinearBuffer);
+    gpLinearBuffer = NULL;
+
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
 #endif // #ifndef __ZEPHYR__
 
+/** Test the event-driven message receive task without any GNSS
+ * hardware: a virtual serial device, fed by this test, stands in
+ * for the transport so that the wake-up on a data event, the
+ * coalesce time which follows it and the guard time that recovers
+ * a lost data event can each be timed.
+ */
+U_PORT_TEST_FUNCTION("[gnss]", "gnssPrivateMsgReceiveEvent")
+{
+    uGnssTransportHandle_t transportHandle;
+    uDeviceHandle_t gnssHandle = NULL;
+    uGnssPrivateTestSerialContext_t *pContext;
+    uGnssMessageId_t messageId = {0};
+    uGnssMsgReceiveLatency_t latency = {0};
+    uGnssPrivateInstance_t *pInstance;
+    int32_t handle;
+    int32_t spartnHandle;
+    int32_t startTimeMs;
+    int32_t eventMs;
+    int32_t guardMs;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uGnssInit() == 0);
+
+    gpDeviceSerial = pUDeviceSerialCreate(testSerialInit,
+                                          sizeof(uGnssPrivateTestSerialContext_t));
+    U_PORT_TEST_ASSERT(gpDeviceSerial != NULL);
+    pContext = (uGnssPrivateTestSerialContext_t *) pUInterfaceContext(gpDeviceSerial);
+    U_PORT_TEST_ASSERT(uPortMutexCreate(&(pContext->mutexHandle)) == 0);
+
+    // Adding a GNSS instance on virtual serial sends nothing
+    transportHandle.pDeviceSerial = gpDeviceSerial;
+    U_PORT_TEST_ASSERT(uGnssAdd(U_GNSS_MODULE_TYPE_M9, U_GNSS_TRANSPORT_VIRTUAL_SERIAL,
+                                transportHandle, -1, false, &gnssHandle) == 0);
+    U_PORT_TEST_ASSERT(uGnssMsgReceiveSetEventDriven(gnssHandle, true,
+                                                     U_GNSS_PRIVATE_TEST_EVENT_COALESCE_MS) == 0);
+
+    gEventMessageCount = 0;
+    messageId.type = U_GNSS_PROTOCOL_NMEA;
+    handle = uGnssMsgReceiveStart(gnssHandle, &messageId, eventMessageCallback, NULL);
+    U_PORT_TEST_ASSERT(handle >= 0);
+    U_PORT_TEST_ASSERT(pContext->pEventCallback != NULL);
+
+    // Get a first message through so that, when the timing
+    // starts, the task is at the start of a fresh wait
+    testSerialAdd(gpDeviceSerial, gEventNmeaMessage,
+                  sizeof(gEventNmeaMessage) - 1, true);
+    U_PORT_TEST_ASSERT(eventMessageWait(1, U_GNSS_MSG_RECEIVE_EVENT_GUARD_TIME_MS * 4));
+
+    // With a data event the task should wake at once and then
+    // wait for the coalesce time before reading
+    startTimeMs = uPortGetTickTimeMs();
+    testSerialAdd(gpDeviceSerial, gEventNmeaMessage,
+                  sizeof(gEventNmeaMessage) - 1, true);
+    U_PORT_TEST_ASSERT(eventMessageWait(2, U_GNSS_MSG_RECEIVE_EVENT_GUARD_TIME_MS * 4));
+    eventMs = gEventMessageTimeMs - startTimeMs;
+
+    // Without a data event, as if it were lost, only the
+    // guard time should cause the task to read the data
+    startTimeMs = uPortGetTickTimeMs();
+    testSerialAdd(gpDeviceSerial, gEventNmeaMessage,
+                  sizeof(gEventNmeaMessage) - 1, false);
+    U_PORT_TEST_ASSERT(eventMessageWait(3, U_GNSS_MSG_RECEIVE_EVENT_GUARD_TIME_MS * 4));
+    guardMs = gEventMessageTimeMs - startTimeMs;
+
+    U_PORT_TEST_ASSERT(uGnssMsgReceiveStatLatency(gnssHandle, &latency) == 0);
+    U_TEST_PRINT_LINE("with a data event the message took %d ms (coalesce time %d ms),"
+                      " without one it took %d ms (guard time %d ms).", eventMs,
+                      U_GNSS_PRIVATE_TEST_EVENT_COALESCE_MS, guardMs,
+                      U_GNSS_MSG_RECEIVE_EVENT_GUARD_TIME_MS);
+    U_TEST_PRINT_LINE("the %s receive task passed on %u message(s), latency"
+                      " min %d ms, average %d ms, max %d ms.",
+                      latency.eventDriven ? "event-driven" : "polling",
+                      (unsigned) latency.count, latency.minMs, latency.averageMs,
+                      latency.maxMs);
+
+    U_PORT_TEST_ASSERT(eventMs >= U_GNSS_PRIVATE_TEST_EVENT_COALESCE_MS / 2);
+    U_PORT_TEST_ASSERT(eventMs < U_GNSS_MSG_RECEIVE_EVENT_GUARD_TIME_MS / 2);
+    U_PORT_TEST_ASSERT(guardMs >= U_GNSS_MSG_RECEIVE_EVENT_GUARD_TIME_MS / 2);
+    U_PORT_TEST_ASSERT(guardMs <= (U_GNSS_MSG_RECEIVE_EVENT_GUARD_TIME_MS * 2) +
+                       U_GNSS_PRIVATE_TEST_EVENT_COALESCE_MS);
+    U_PORT_TEST_ASSERT(latency.eventDriven);
+    U_PORT_TEST_ASSERT(latency.count == 3);
+    // The latency of a message which came with a data event
+    // is measured from the event, so includes the coalesce time
+    U_PORT_TEST_ASSERT(latency.maxMs >= U_GNSS_PRIVATE_TEST_EVENT_COALESCE_MS / 2);
+    U_PORT_TEST_ASSERT(latency.maxMs < U_GNSS_MSG_RECEIVE_EVENT_GUARD_TIME_MS / 2);
+
+    // The receive task should hunt for SPARTN messages only
+    // while a reader is asking for them
+    pInstance = pUGnssPrivateGetInstance(gnssHandle);
+    U_PORT_TEST_ASSERT(pInstance != NULL);
+    U_PORT_TEST_ASSERT(!pInstance->pMsgReceive->spartn);
+    messageId.type = U_GNSS_PROTOCOL_SPARTN;
+    messageId.id.spartn = U_GNSS_SPARTN_MESSAGE_ALL;
+    spartnHandle = uGnssMsgReceiveStart(gnssHandle, &messageId, eventMessageCallback, NULL);
+    U_PORT_TEST_ASSERT(spartnHandle >= 0);
+    U_PORT_TEST_ASSERT(pInstance->pMsgReceive->spartn);
+    U_PORT_TEST_ASSERT(uGnssMsgReceiveStop(gnssHandle, spartnHandle) == 0);
+    U_PORT_TEST_ASSERT(!pInstance->pMsgReceive->spartn);
+
+    // Stopping the last reader should remove the event callback
+    U_PORT_TEST_ASSERT(uGnssMsgReceiveStop(gnssHandle, handle) == 0);
+    U_PORT_TEST_ASSERT(pContext->pEventCallback == NULL);
+
+    uGnssRemove(gnssHandle);
+    uGnssDeinit();
+    uPortMutexDelete(pContext->mutexHandle);
+    uDeviceSerialDelete(gpDeviceSerial);
+    gpDeviceSerial = NULL;
+
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
 /** Clean-up to be run at the end of this round of tests, just
  * in case there were test failures which would have resulted
  * in the deinitialisation being skipped.
@@ -902,6 +1544,9 @@ U_PORT_TEST_FUNCTION("[gnss]", "gnssPrivateCleanUp")
     uPortFree(gpLinearBuffer);
 
     uGnssDeinit();
+    if (gpDeviceSerial != NULL) {
+        uDeviceSerialDelete(gpDeviceSerial);
+    }
     uPortDeinit();
     // Printed for information: asserting happens in the postamble
     uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
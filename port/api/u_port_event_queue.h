@@ -124,10 +124,38 @@ extern "C" {
                            U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES
 #endif
 
+#ifndef U_PORT_EVENT_QUEUE_COALESCE_MAX_NUM
+/** The maximum number of distinct events sent with
+ * uPortEventQueueSendCoalesced() that an event queue keeps track
+ * of while they are waiting to be dispatched; beyond this events
+ * are simply queued.
+ */
+# define U_PORT_EVENT_QUEUE_COALESCE_MAX_NUM 4
+#endif
+
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** Statistics for an event queue, see uPortEventQueueStatsGet().
+ */
+typedef struct {
+    int32_t highWaterMark; /**< the most events there have been waiting
+                                on the queue, as seen just after a send;
+                                zero if the platform cannot report the
+                                free space on a queue (see
+                                uPortEventQueueGetFree()). */
+    int32_t numEvents;     /**< the number of events dispatched. */
+    int32_t numWakeups;    /**< the number of times the event task woke
+                                up to dispatch events, each wake-up
+                                dispatching up to the number given to
+                                uPortEventQueueDrainSet(). */
+    int32_t numCoalesced;  /**< the number of events sent with
+                                uPortEventQueueSendCoalesced() that were
+                                dropped because an identical event was
+                                already waiting. */
+} uPortEventQueueStats_t;
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS
  * -------------------------------------------------------------- */
@@ -235,6 +263,49 @@ int32_t uPortEventQueueSend(int32_t handle, const void *pParam,
 int32_t uPortEventQueueSendIrq(int32_t handle, const void *pParam,
                                size_t paramLengthBytes);
 
+/** As uPortEventQueueSend() but, if an identical event (same length,
+ * same contents) sent with this function is already waiting on the
+ * queue, the event is dropped, counted in the numCoalesced field of
+ * uPortEventQueueStats_t, and success is returned.  Use this for
+ * events that only say "go and look", e.g. data having been received
+ * on a given handle, where a burst would otherwise fill the queue
+ * with redundant events.  The event is treated as no longer waiting
+ * just before it is dispatched, so an identical event sent while
+ * the callback is running will cause the callback to be called again.
+ *
+ * @param handle            the handle for the event queue.
+ * @param[in] pParam        a pointer to the parameters structure
+ *                          to send.  May be NULL, in which case
+ *                          paramLengthBytes must be zero.
+ * @param paramLengthBytes  the length of the parameters
+ *                          structure.  Must be less than or
+ *                          equal to paramMaxLengthBytes as
+ *                          given to uPortEventQueueOpen().
+ * @return                  zero on success else negative error code.
+ */
+int32_t uPortEventQueueSendCoalesced(int32_t handle, const void *pParam,
+                                     size_t paramLengthBytes);
+
+/** Set how many events the event task may dispatch each time it
+ * wakes up: once woken by an event it will dispatch up to this many
+ * events that are already waiting before it next blocks on the queue.
+ * The default is 1.
+ *
+ * @param handle              the handle of the event queue.
+ * @param maxEventsPerWakeup  the maximum number of events to dispatch
+ *                            per wake-up, must be at least 1.
+ * @return                    zero on success else negative error code.
+ */
+int32_t uPortEventQueueDrainSet(int32_t handle, size_t maxEventsPerWakeup);
+
+/** Get the statistics for an event queue.
+ *
+ * @param handle       the handle of the event queue.
+ * @param[out] pStats  a place to put the statistics, cannot be NULL.
+ * @return             zero on success else negative error code.
+ */
+int32_t uPortEventQueueStatsGet(int32_t handle, uPortEventQueueStats_t *pStats);
+
 /** Detect whether the task currently executing is the
  * event task for the given event queue.  Useful if you
  * have code which is called a few levels down from the
@@ -123,6 +123,19 @@ void uPortFree(void *pMemory);
  */
 int32_t uPortHeapAllocCount();
 
+/** Get the number of successful pUPortMalloc() calls that have
+ * ever been made: unlike uPortHeapAllocCount() this is not reduced
+ * by uPortFree(), so it can be used when testing to check that
+ * something makes no heap allocations at all, rather than just
+ * that it frees whatever it allocates.
+ *
+ * You do not need to implement this function: where it is not
+ * implemented a #U_WEAK implementation will return zero.
+ *
+ * @return   the number of successful pUPortMalloc() calls.
+ */
+int32_t uPortHeapAllocCallCount();
+
 /** Used ONLY for heap accounting: this function allows the
  * code to indicate that a heap allocation has been made that
  * will NEVER be free'd.
@@ -66,6 +66,15 @@ typedef struct uEventQueue_t {
     size_t paramMaxLengthBytes; /** Max length of an item on this OS queue. */
     uPortTaskHandle_t task; /** Handle for the OS task. */
     uPortMutexHandle_t taskRunningMutex; /** Mutex to determine if task has exited. */
+    size_t queueLength; /** The number of items the OS queue can hold. */
+    uPortMutexHandle_t mutex; /** Protects the fields below. */
+    size_t maxEventsPerWakeup; /** Set by uPortEventQueueDrainSet(). */
+    char *pCoalesce; /** U_PORT_EVENT_QUEUE_COALESCE_MAX_NUM blocks, as sent
+                         to the OS queue, of coalesced events that are waiting,
+                         allocated when first needed. */
+    bool coalesceUsed[U_PORT_EVENT_QUEUE_COALESCE_MAX_NUM]; /** Which of
+                                                                pCoalesce are in use. */
+    uPortEventQueueStats_t stats;
 } uEventQueue_t;
 
 /** The control/size word, prefixed to the parameter block sent to
@@ -78,7 +87,10 @@ typedef enum {
                                                * be 32 bit so that it can
                                                * also be used as a size. */
     U_EVENT_CONTROL_NONE = 0,
-    U_EVENT_CONTROL_EXIT_NOW = -1
+    U_EVENT_CONTROL_EXIT_NOW = -1,
+    U_EVENT_CONTROL_FLAG_COALESCED = 0x40000000 /* ORed with the size
+                                                 * of an event sent by
+                                                 * uPortEventQueueSendCoalesced(). */
 } uEventQueueControlOrSize_t;
 
 /* ----------------------------------------------------------------
@@ -97,6 +109,75 @@ static uEventQueue_t *gpEventQueue[U_PORT_EVENT_QUEUE_MAX_NUM];
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// The length of the block sent to the OS queue of an event queue.
+static inline size_t blockLength(const uEventQueue_t *pEventQueue)
+{
+    return pEventQueue->paramMaxLengthBytes + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES;
+}
+
+// Find a block in the coalesced events that are waiting on an event
+// queue, returning its index or -1; pEventQueue->mutex must be locked.
+static int32_t coalesceFind(const uEventQueue_t *pEventQueue, const char *pBlock)
+{
+    int32_t index = -1;
+    size_t length = blockLength(pEventQueue);
+
+    for (size_t x = 0; (index < 0) && (pEventQueue->pCoalesce != NULL) &&
+         (x < U_PORT_EVENT_QUEUE_COALESCE_MAX_NUM); x++) {
+        if (pEventQueue->coalesceUsed[x] &&
+            (memcmp(pEventQueue->pCoalesce + (x * length), pBlock, length) == 0)) {
+            index = (int32_t) x;
+        }
+    }
+
+    return index;
+}
+
+// A coalesced event is about to be dispatched: it is no longer waiting.
+static void coalesceRelease(uEventQueue_t *pEventQueue, const char *pBlock)
+{
+    int32_t index;
+
+    U_PORT_MUTEX_LOCK(pEventQueue->mutex);
+
+    index = coalesceFind(pEventQueue, pBlock);
+    if (index >= 0) {
+        pEventQueue->coalesceUsed[index] = false;
+    }
+
+    U_PORT_MUTEX_UNLOCK(pEventQueue->mutex);
+}
+
+// Call the user function for a block received from the OS queue,
+// returning false if it was a control message telling us to exit.
+static bool dispatch(uEventQueue_t *pEventQueue, char *pBlock)
+{
+    bool keepGoing = true;
+    int32_t controlOrSize = (int32_t) *((uEventQueueControlOrSize_t *) pBlock);
+
+    // If this is not a control message, call the
+    // user function with the parameter block,
+    // skipping the "control or size" word at the
+    // start and passing it in instead as the size
+    // parameter
+    if (controlOrSize >= 0) {
+        if (controlOrSize & U_EVENT_CONTROL_FLAG_COALESCED) {
+            coalesceRelease(pEventQueue, pBlock);
+            controlOrSize &= ~U_EVENT_CONTROL_FLAG_COALESCED;
+        }
+        if (controlOrSize > 0) {
+            pEventQueue->pFunction((void *) (pBlock + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES),
+                                   (size_t) controlOrSize);
+        } else {
+            pEventQueue->pFunction(NULL, 0);
+        }
+    } else if (controlOrSize == (int32_t) U_EVENT_CONTROL_EXIT_NOW) {
+        keepGoing = false;
+    }
+
+    return keepGoing;
+}
+
 // Run the user function.  This will be run multiple times in a
 // task of its own.
 static void eventQueueTask(void *pParam)
@@ -104,8 +185,10 @@ static void eventQueueTask(void *pParam)
     uEventQueue_t *pEventQueue = (uEventQueue_t *) pParam;
     char param[U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES +
                U_PORT_EVENT_QUEUE_MAX_PARAM_LENGTH_BYTES];
-    uEventQueueControlOrSize_t *pControlOrSize = (uEventQueueControlOrSize_t *)
-                                                 & (param[0]);
+    bool keepGoing = true;
+    size_t maxEventsPerWakeup = 1;
+    int32_t numEvents;
+    int32_t errorCode;
 
     U_PORT_MUTEX_LOCK(pEventQueue->taskRunningMutex);
 #if defined(__NEWLIB__) && defined(_REENT_SMALL) && \
@@ -122,25 +205,28 @@ static void eventQueueTask(void *pParam)
     uPortLog("");
 #endif
 
-    *pControlOrSize = U_EVENT_CONTROL_NONE;
     // Continue until we're told to exit
-    while (*pControlOrSize != U_EVENT_CONTROL_EXIT_NOW) {
-        if (uPortQueueReceive(pEventQueue->queue, param) == 0) {
-            // If this is not a control message, call the
-            // user function with the parameter block,
-            // skipping the "control or size" word at the
-            // start and passing it in instead as the size
-            // parameter
-            if ((int32_t) *pControlOrSize >= 0) {
-                if ((int32_t) *pControlOrSize > 0) {
-                    pEventQueue->pFunction((void *) & (param[U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES]),
-                                           // Cast in two stages to keep Lint happy
-                                           (size_t) (int32_t) *pControlOrSize);
-                } else {
-                    pEventQueue->pFunction(NULL, 0);
-                }
+    while (keepGoing) {
+        numEvents = 0;
+        errorCode = uPortQueueReceive(pEventQueue->queue, param);
+        // Having been woken up, dispatch whatever else is
+        // already waiting, up to the limit
+        while ((errorCode == 0) && keepGoing) {
+            keepGoing = dispatch(pEventQueue, param);
+            numEvents++;
+            errorCode = -1;
+            if (keepGoing && ((size_t) numEvents < maxEventsPerWakeup)) {
+                errorCode = uPortQueueTryReceive(pEventQueue->queue, 0, param);
             }
         }
+
+        U_PORT_MUTEX_LOCK(pEventQueue->mutex);
+        if (numEvents > 0) {
+            pEventQueue->stats.numWakeups++;
+            pEventQueue->stats.numEvents += keepGoing ? numEvents : numEvents - 1;
+        }
+        maxEventsPerWakeup = pEventQueue->maxEventsPerWakeup;
+        U_PORT_MUTEX_UNLOCK(pEventQueue->mutex);
     }
 
     U_PORT_MUTEX_UNLOCK(pEventQueue->taskRunningMutex);
@@ -181,6 +267,8 @@ static int32_t eventQueueFree(uEventQueue_t *pEventQueue)
 
         // Tidy up
         uPortMutexDelete(pEventQueue->taskRunningMutex);
+        uPortMutexDelete(pEventQueue->mutex);
+        uPortFree(pEventQueue->pCoalesce);
         errorCode = uPortQueueDelete(pEventQueue->queue);
 
         // Pause here to allow the deletions
@@ -233,6 +321,119 @@ static inline uEventQueue_t *pEventQueueGet(int32_t handle)
     return pEventQueue;
 }
 
+// Send to an event queue, optionally coalescing the event with an
+// identical one that is already waiting.
+static int32_t eventQueueSend(int32_t handle, const void *pParam,
+                              size_t paramLengthBytes, bool coalesce)
+{
+    uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
+    uEventQueue_t *pEventQueue = NULL;
+    char *pBlock = NULL;
+    uPortQueueHandle_t queue = NULL;
+    int32_t coalesceIndex = -1;
+    bool coalesced = false;
+    int32_t numFree;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+        pEventQueue = pEventQueueGet(handle);
+        if ((pEventQueue != NULL) &&
+            (paramLengthBytes <= pEventQueue->paramMaxLengthBytes) &&
+            ((pParam != NULL) || (paramLengthBytes == 0))) {
+            queue = pEventQueue->queue;
+            errorCode = U_ERROR_COMMON_NO_MEMORY;
+            // We need to add the control word to the start, so pUPortMalloc
+            // a block that is paramMaxLengthBytes (i.e. paramMaxLengthBytes
+            // of the queue, not just the paramLengthBytes passed in, since
+            // uPortQueueSend() will expect to copy the full length) plus
+            // plus the control word length
+            pBlock = (char *) pUPortMalloc(blockLength(pEventQueue));
+            if (pBlock != NULL) {
+                // Keep memory checkers (e.g. Valgrind) happy; this also
+                // means that identical events have identical blocks
+                memset(pBlock, 0, blockLength(pEventQueue));
+                // Copy in the control word, which is actually just
+                // the size in this case
+                //lint -e(826) Suppress area too small; the size of pBlock is always
+                // at least U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES in size
+                *((uEventQueueControlOrSize_t *) pBlock) = (uEventQueueControlOrSize_t) paramLengthBytes;
+                if (pParam != NULL) {
+                    // Copy in param
+                    //lint -e{826} Suppress pointed-to area too small, we make sure it is OK above
+                    memcpy(pBlock + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
+                           pParam, paramLengthBytes);
+                }
+                if (coalesce) {
+                    *((uEventQueueControlOrSize_t *) pBlock) |= U_EVENT_CONTROL_FLAG_COALESCED;
+
+                    U_PORT_MUTEX_LOCK(pEventQueue->mutex);
+
+                    if (coalesceFind(pEventQueue, pBlock) >= 0) {
+                        // Already waiting: nothing to do
+                        pEventQueue->stats.numCoalesced++;
+                        coalesced = true;
+                    } else {
+                        if (pEventQueue->pCoalesce == NULL) {
+                            pEventQueue->pCoalesce = (char *) pUPortMalloc(U_PORT_EVENT_QUEUE_COALESCE_MAX_NUM *
+                                                                           blockLength(pEventQueue));
+                        }
+                        // Remember it, if there's room, so that
+                        // the next one can be coalesced with it
+                        for (size_t x = 0; (coalesceIndex < 0) && (pEventQueue->pCoalesce != NULL) &&
+                             (x < U_PORT_EVENT_QUEUE_COALESCE_MAX_NUM); x++) {
+                            if (!pEventQueue->coalesceUsed[x]) {
+                                memcpy(pEventQueue->pCoalesce + (x * blockLength(pEventQueue)),
+                                       pBlock, blockLength(pEventQueue));
+                                pEventQueue->coalesceUsed[x] = true;
+                                coalesceIndex = (int32_t) x;
+                            }
+                        }
+                    }
+
+                    U_PORT_MUTEX_UNLOCK(pEventQueue->mutex);
+                }
+            }
+        }
+
+        // We release the mutex before sending to the
+        // queue since the send process may block (e.g.
+        // if the queue is full) and we don't want
+        // that to block the entire API
+        U_PORT_MUTEX_UNLOCK(gMutex);
+
+        if (pBlock != NULL) {
+            if (coalesced) {
+                errorCode = U_ERROR_COMMON_SUCCESS;
+            } else {
+                // Send it off
+                errorCode = (uErrorCode_t) uPortQueueSend(queue, pBlock);
+                numFree = uPortQueueGetFree(queue);
+
+                U_PORT_MUTEX_LOCK(pEventQueue->mutex);
+
+                if (errorCode != U_ERROR_COMMON_SUCCESS) {
+                    if (coalesceIndex >= 0) {
+                        pEventQueue->coalesceUsed[coalesceIndex] = false;
+                    }
+                } else if ((numFree >= 0) &&
+                           ((int32_t) pEventQueue->queueLength - numFree > pEventQueue->stats.highWaterMark)) {
+                    // Keep track of the high-water mark
+                    pEventQueue->stats.highWaterMark = (int32_t) pEventQueue->queueLength - numFree;
+                }
+
+                U_PORT_MUTEX_UNLOCK(pEventQueue->mutex);
+            }
+            // Free memory again
+            uPortFree(pBlock);
+        }
+    }
+
+    return (int32_t) errorCode;
+}
+
 /* ----------------------------------------------------------------
  * PUBLIC FUNCTIONS: BUT ONES THAT SHOULD BE CALLED INTERNALLY ONLY
  * -------------------------------------------------------------- */
@@ -325,9 +526,12 @@ int32_t uPortEventQueueOpen(void (*pFunction) (void *, size_t),
                 // Malloc a structure to represent the event queue
                 pEventQueue = (uEventQueue_t *) pUPortMalloc(sizeof(uEventQueue_t));
                 if (pEventQueue != NULL) {
+                    memset(pEventQueue, 0, sizeof(*pEventQueue));
                     pEventQueue->closed = false;
                     pEventQueue->pFunction = pFunction;
                     pEventQueue->paramMaxLengthBytes = paramMaxLengthBytes;
+                    pEventQueue->queueLength = queueLength;
+                    pEventQueue->maxEventsPerWakeup = 1;
                     // Create the queue
                     handleOrError = (uErrorCode_t) uPortQueueCreate(queueLength,
                                                                     paramMaxLengthBytes +
@@ -335,7 +539,13 @@ int32_t uPortEventQueueOpen(void (*pFunction) (void *, size_t),
                                                                     &(pEventQueue->queue));
                     if (handleOrError == U_ERROR_COMMON_SUCCESS) {
                         // Create the mutex for task running status
+                        // and the one protecting the statistics etc.
                         handleOrError = (uErrorCode_t) uPortMutexCreate(&(pEventQueue->taskRunningMutex));
+                        if ((handleOrError == U_ERROR_COMMON_SUCCESS) &&
+                            (uPortMutexCreate(&(pEventQueue->mutex)) != 0)) {
+                            uPortMutexDelete(pEventQueue->taskRunningMutex);
+                            handleOrError = U_ERROR_COMMON_NO_MEMORY;
+                        }
                         if (handleOrError == U_ERROR_COMMON_SUCCESS) {
                             // Finally, create the task itself
                             if (pName != NULL) {
@@ -361,13 +571,14 @@ int32_t uPortEventQueueOpen(void (*pFunction) (void *, size_t),
                                 handleOrError = (uErrorCode_t) handle;
                             } else {
                                 // Couldn't create the task, delete the
-                                // mutex and queue and free the structure
+                                // mutexes and queue and free the structure
                                 uPortMutexDelete(pEventQueue->taskRunningMutex);
+                                uPortMutexDelete(pEventQueue->mutex);
                                 uPortQueueDelete(pEventQueue->queue);
                                 uPortFree(pEventQueue);
                             }
                         } else {
-                            // Couldn't create the mutex, delete the queue
+                            // Couldn't create the mutexes, delete the queue
                             // and free the structure
                             uPortQueueDelete(pEventQueue->queue);
                             uPortFree(pEventQueue);
@@ -390,64 +601,14 @@ int32_t uPortEventQueueOpen(void (*pFunction) (void *, size_t),
 int32_t uPortEventQueueSend(int32_t handle, const void *pParam,
                             size_t paramLengthBytes)
 {
-    uErrorCode_t errorCode = U_ERROR_COMMON_NOT_INITIALISED;
-    uEventQueue_t *pEventQueue;
-    char *pBlock = NULL;
-    uPortQueueHandle_t queue = NULL;
-
-    if (gMutex != NULL) {
-
-        U_PORT_MUTEX_LOCK(gMutex);
-
-        errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
-        pEventQueue = pEventQueueGet(handle);
-        if ((pEventQueue != NULL) &&
-            (paramLengthBytes <= pEventQueue->paramMaxLengthBytes) &&
-            ((pParam != NULL) || (paramLengthBytes == 0))) {
-            queue = pEventQueue->queue;
-            errorCode = U_ERROR_COMMON_NO_MEMORY;
-            // We need to add the control word to the start, so pUPortMalloc
-            // a block that is paramMaxLengthBytes (i.e. paramMaxLengthBytes
-            // of the queue, not just the paramLengthBytes passed in, since
-            // uPortQueueSend() will expect to copy the full length) plus
-            // plus the control word length
-            pBlock = (char *) pUPortMalloc(pEventQueue->paramMaxLengthBytes +
-                                           U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES);
-            if (pBlock != NULL) {
-                // Keep memory checkers (e.g. Valgrind) happy
-                memset(pBlock, 0, pEventQueue->paramMaxLengthBytes +
-                       U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES);
-                // Copy in the control word, which is actually just
-                // the size in this case
-                //lint -e(826) Suppress area too small; the size of pBlock is always
-                // at least U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES in size
-                *((uEventQueueControlOrSize_t *) pBlock) = (uEventQueueControlOrSize_t) paramLengthBytes;
-                if (pParam != NULL) {
-                    // Copy in param
-                    //lint -e{826} Suppress pointed-to area too small, we make sure it is OK above
-                    memcpy(pBlock + U_PORT_EVENT_QUEUE_CONTROL_OR_SIZE_LENGTH_BYTES,
-                           pParam, paramLengthBytes);
-                }
-            }
-        }
-
-        // We release the mutex before sending to the
-        // queue since the send process may block (e.g.
-        // if the queue is full) and we don't want
-        // that to block the entire API
-        U_PORT_MUTEX_UNLOCK(gMutex);
-
-        if (pBlock != NULL) {
-            if (queue != NULL) {
-                // Send it off
-                errorCode = (uErrorCode_t) uPortQueueSend(queue, pBlock);
-            }
-            // Free memory again
-            uPortFree(pBlock);
-        }
-    }
+    return eventQueueSend(handle, pParam, paramLengthBytes, false);
+}
 
-    return (int32_t) errorCode;
+// Send to an event queue, coalescing with an identical waiting event.
+int32_t uPortEventQueueSendCoalesced(int32_t handle, const void *pParam,
+                                     size_t paramLengthBytes)
+{
+    return eventQueueSend(handle, pParam, paramLengthBytes, true);
 }
 
 // Send to an event queue from an interrupt.
@@ -598,6 +759,56 @@ int32_t uPortEventQueueGetFree(int32_t handle)
     return errorCodeOrFree;
 }
 
+// Set the number of events dispatched per wake-up.
+int32_t uPortEventQueueDrainSet(int32_t handle, size_t maxEventsPerWakeup)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uEventQueue_t *pEventQueue;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pEventQueue = pEventQueueGet(handle);
+        if ((pEventQueue != NULL) && (maxEventsPerWakeup > 0)) {
+            U_PORT_MUTEX_LOCK(pEventQueue->mutex);
+            pEventQueue->maxEventsPerWakeup = maxEventsPerWakeup;
+            U_PORT_MUTEX_UNLOCK(pEventQueue->mutex);
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
+// Get the statistics for an event queue.
+int32_t uPortEventQueueStatsGet(int32_t handle, uPortEventQueueStats_t *pStats)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    uEventQueue_t *pEventQueue;
+
+    if (gMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        pEventQueue = pEventQueueGet(handle);
+        if ((pEventQueue != NULL) && (pStats != NULL)) {
+            U_PORT_MUTEX_LOCK(pEventQueue->mutex);
+            *pStats = pEventQueue->stats;
+            U_PORT_MUTEX_UNLOCK(pEventQueue->mutex);
+            errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+        }
+
+        U_PORT_MUTEX_UNLOCK(gMutex);
+    }
+
+    return errorCode;
+}
+
 // Free memory in closed event queues
 void uPortEventQueueCleanUp(void)
 {
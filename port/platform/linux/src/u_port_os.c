@@ -112,17 +112,25 @@ int32_t _uPortMutexUnlock(uPortMutexHandle_t mutexHandle);
 
 /* Structures for storing os specific type data to be kept in linked lists. */
 
-/** Queues are implemented using Posix pipes. A mutex is protecting the
- *  available count and a semaphore is used for synchronisation.
- *  Pipe descriptor 0 is used for reading and 1 for writing.
+/** Queues are implemented as a ring of items in process memory,
+ *  protected by a Posix mutex, with condition variables to wait on
+ *  for something to receive or for room to send.  The condition
+ *  variables are only signalled when a task is actually waiting
+ *  so, when there is no contention, sending and receiving involve
+ *  no system calls at all.  The items follow this structure in the
+ *  same allocation.
 */
 typedef struct {
-    uPortMutexHandle_t mutex;
-    uPortSemaphoreHandle_t semHandle;
-    int fd[2];            /*!< Pipe in/out descriptor. */
-    size_t queueLength;   /*!< Max number of elements. */
-    size_t itemSizeBytes; /*!< Element size */
-    size_t readCount;     /*!< Unread bytes in the queue. */
+    pthread_mutex_t mutex;
+    pthread_cond_t notEmpty;  /*!< Signalled when an item is added. */
+    pthread_cond_t notFull;   /*!< Signalled when an item is removed. */
+    size_t queueLength;       /*!< Max number of elements. */
+    size_t itemSizeBytes;     /*!< Element size */
+    size_t readIndex;         /*!< The element to receive next. */
+    size_t count;             /*!< Number of elements in the queue. */
+    size_t numReceivers;      /*!< Tasks waiting on notEmpty. */
+    size_t numSenders;        /*!< Tasks waiting on notFull. */
+    char items[];
 } uPortQueue_t;
 
 /** Timers are implemented using Posix timer_t timers.
@@ -254,25 +262,82 @@ static void timerCallback(union sigval sv)
     pTimer->pCallback(pTimer, pTimer->pCallbackParam);
 }
 
-// Read from a queue if an event is available.
-static uErrorCode_t readFromQueue(uPortQueue_t *pQueue,
-                                  void *pEventData)
+// Create a time structure on the monotonic clock, which is what
+// the queue condition variables use, the given number of
+// milliseconds from now.
+static void msToMonotonicTimeSpec(int32_t ms, struct timespec *t)
 {
-    uErrorCode_t errorCode = U_ERROR_COMMON_EMPTY;
-    MTX_FN(uPortMutexLock(pQueue->mutex));
-    if (pQueue->readCount >= pQueue->itemSizeBytes) {
-        errorCode = U_ERROR_COMMON_TRUNCATED;
-        size_t readCount = read(pQueue->fd[0], pEventData, pQueue->itemSizeBytes);
-        if (readCount == pQueue->itemSizeBytes) {
-            errorCode = U_ERROR_COMMON_SUCCESS;
+    clock_gettime(CLOCK_MONOTONIC, t);
+    t->tv_sec += ms / 1000;
+    t->tv_nsec += (ms % 1000) * 1000000;
+    if (t->tv_nsec >= 1000000000) {
+        t->tv_nsec -= 1000000000;
+        t->tv_sec++;
+    }
+}
+
+// Cancellation clean-up handler for a task waiting on a queue: a
+// task cancelled in pthread_cond_wait() owns the mutex again.
+static void queueWaitCancelled(void *pParam)
+{
+    pthread_mutex_unlock(&(((uPortQueue_t *) pParam)->mutex));
+}
+
+// Wait for a queue to become not empty or not full, forever if
+// waitMs is negative; must be called with the queue mutex locked.
+static uErrorCode_t queueWait(uPortQueue_t *pQueue, bool forRoom,
+                              int32_t waitMs)
+{
+    uErrorCode_t errorCode = U_ERROR_COMMON_SUCCESS;
+    pthread_cond_t *pCond = forRoom ? &(pQueue->notFull) : &(pQueue->notEmpty);
+    size_t *pNumWaiting = forRoom ? &(pQueue->numSenders) : &(pQueue->numReceivers);
+    struct timespec t;
+
+    if (waitMs >= 0) {
+        msToMonotonicTimeSpec(waitMs, &t);
+    }
+    (*pNumWaiting)++;
+    pthread_cleanup_push(queueWaitCancelled, pQueue);
+    while ((errorCode == U_ERROR_COMMON_SUCCESS) &&
+           (forRoom ? (pQueue->count >= pQueue->queueLength) : (pQueue->count == 0))) {
+        if (waitMs < 0) {
+            pthread_cond_wait(pCond, &(pQueue->mutex));
+        } else if (pthread_cond_timedwait(pCond, &(pQueue->mutex), &t) == ETIMEDOUT) {
+            errorCode = U_ERROR_COMMON_TIMEOUT;
         }
-        if (readCount >= 0) {
-            pQueue->readCount -= readCount;
-        } else {
-            errorCode = U_ERROR_COMMON_PLATFORM;
+    }
+    pthread_cleanup_pop(0);
+    (*pNumWaiting)--;
+
+    return errorCode;
+}
+
+// Receive from a queue, waiting forever if waitMs is negative.
+static uErrorCode_t queueReceive(uPortQueue_t *pQueue, void *pEventData,
+                                 int32_t waitMs)
+{
+    uErrorCode_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+    bool wake;
+
+    if ((pQueue != NULL) && (pEventData != NULL)) {
+        pthread_mutex_lock(&(pQueue->mutex));
+        errorCode = queueWait(pQueue, false, waitMs);
+        if (errorCode == U_ERROR_COMMON_SUCCESS) {
+            memcpy(pEventData, pQueue->items + (pQueue->readIndex * pQueue->itemSizeBytes),
+                   pQueue->itemSizeBytes);
+            pQueue->readIndex++;
+            if (pQueue->readIndex >= pQueue->queueLength) {
+                pQueue->readIndex = 0;
+            }
+            pQueue->count--;
+        }
+        wake = (errorCode == U_ERROR_COMMON_SUCCESS) && (pQueue->numSenders > 0);
+        pthread_mutex_unlock(&(pQueue->mutex));
+        if (wake) {
+            pthread_cond_signal(&(pQueue->notFull));
         }
     }
-    MTX_FN(uPortMutexUnlock(pQueue->mutex));
+
     return errorCode;
 }
 
@@ -510,33 +575,27 @@ int32_t uPortQueueCreate(size_t queueLength,
                          uPortQueueHandle_t *pQueueHandle)
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
-    if (pQueueHandle != NULL) {
+    if ((pQueueHandle != NULL) && (queueLength > 0) && (itemSizeBytes > 0)) {
         errorCode = U_ERROR_COMMON_NO_MEMORY;
-        uPortQueue_t *pQueue = (uPortQueue_t *)pUPortMalloc(sizeof(uPortQueue_t));
+        uPortQueue_t *pQueue = (uPortQueue_t *)pUPortMalloc(sizeof(uPortQueue_t) +
+                                                            (queueLength * itemSizeBytes));
         if (pQueue) {
-            uPortMutexHandle_t mutex;
-            uPortSemaphoreHandle_t semHandle;
-            if (uPortSemaphoreCreate(&semHandle, 0, queueLength) != 0) {
-                uPortFree(pQueue);
-            } else if (MTX_FN(uPortMutexCreate(&mutex)) == 0) {
-                // Create a non blocking pipe.
-                if (pipe2(pQueue->fd, O_NONBLOCK) == 0) {
-                    if (queueLength * itemSizeBytes < fcntl(pQueue->fd[1], F_GETPIPE_SZ)) {
-                        pQueue->mutex = mutex;
-                        pQueue->semHandle = semHandle;
-                        pQueue->queueLength = queueLength;
-                        pQueue->itemSizeBytes = itemSizeBytes;
-                        pQueue->readCount = 0;
-                        *pQueueHandle = pQueue;
-                        errorCode = U_ERROR_COMMON_SUCCESS;
-                        U_ATOMIC_INCREMENT(&gResourceAllocCount);
-                        U_PORT_OS_DEBUG_PRINT_QUEUE_CREATE(*pQueueHandle, queueLength, itemSizeBytes);
-                    }
-                } else {
-                    MTX_FN(uPortMutexDelete(mutex));
-                    uPortFree(pQueue);
-                }
-            }
+            pthread_condattr_t attr;
+            memset(pQueue, 0, sizeof(uPortQueue_t));
+            pQueue->queueLength = queueLength;
+            pQueue->itemSizeBytes = itemSizeBytes;
+            // Time-outs are on the monotonic clock so that they
+            // don't jump when the wall-clock time is set
+            pthread_condattr_init(&attr);
+            pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+            pthread_mutex_init(&(pQueue->mutex), NULL);
+            pthread_cond_init(&(pQueue->notEmpty), &attr);
+            pthread_cond_init(&(pQueue->notFull), &attr);
+            pthread_condattr_destroy(&attr);
+            *pQueueHandle = pQueue;
+            errorCode = U_ERROR_COMMON_SUCCESS;
+            U_ATOMIC_INCREMENT(&gResourceAllocCount);
+            U_PORT_OS_DEBUG_PRINT_QUEUE_CREATE(*pQueueHandle, queueLength, itemSizeBytes);
         }
     }
     return (int32_t) errorCode;
@@ -548,10 +607,9 @@ int32_t uPortQueueDelete(const uPortQueueHandle_t queueHandle)
     uErrorCode_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
     uPortQueue_t *pQueue = (uPortQueue_t *)queueHandle;
     if (pQueue != NULL) {
-        close(pQueue->fd[0]);
-        close(pQueue->fd[1]);
-        MTX_FN(uPortMutexDelete(pQueue->mutex));
-        uPortSemaphoreDelete(pQueue->semHandle);
+        pthread_cond_destroy(&(pQueue->notEmpty));
+        pthread_cond_destroy(&(pQueue->notFull));
+        pthread_mutex_destroy(&(pQueue->mutex));
         uPortFree(pQueue);
         errorCode = U_ERROR_COMMON_SUCCESS;
         U_ATOMIC_DECREMENT(&gResourceAllocCount);
@@ -566,20 +624,25 @@ int32_t uPortQueueSend(const uPortQueueHandle_t queueHandle,
 {
     uErrorCode_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
     uPortQueue_t *pQueue = (uPortQueue_t *)queueHandle;
-    if (pQueue != NULL) {
-        errorCode = U_ERROR_COMMON_TRUNCATED;
-        MTX_FN(uPortMutexLock(pQueue->mutex));
-        size_t writeCount = write(pQueue->fd[1], pEventData, pQueue->itemSizeBytes);
-        if (writeCount == pQueue->itemSizeBytes) {
-            errorCode = U_ERROR_COMMON_SUCCESS;
+    if ((pQueue != NULL) && (pEventData != NULL)) {
+        bool wake;
+        size_t writeIndex;
+        pthread_mutex_lock(&(pQueue->mutex));
+        errorCode = queueWait(pQueue, true, -1);
+        if (errorCode == U_ERROR_COMMON_SUCCESS) {
+            writeIndex = pQueue->readIndex + pQueue->count;
+            if (writeIndex >= pQueue->queueLength) {
+                writeIndex -= pQueue->queueLength;
+            }
+            memcpy(pQueue->items + (writeIndex * pQueue->itemSizeBytes), pEventData,
+                   pQueue->itemSizeBytes);
+            pQueue->count++;
         }
-        if (writeCount >= 0) {
-            pQueue->readCount += writeCount;
-        } else {
-            errorCode = U_ERROR_COMMON_PLATFORM;
+        wake = (errorCode == U_ERROR_COMMON_SUCCESS) && (pQueue->numReceivers > 0);
+        pthread_mutex_unlock(&(pQueue->mutex));
+        if (wake) {
+            pthread_cond_signal(&(pQueue->notEmpty));
         }
-        MTX_FN(uPortMutexUnlock(pQueue->mutex));
-        uPortSemaphoreGive(pQueue->semHandle);
     }
     return (int32_t)errorCode;
 }
@@ -596,14 +659,7 @@ int32_t uPortQueueSendIrq(const uPortQueueHandle_t queueHandle,
 int32_t uPortQueueReceive(const uPortQueueHandle_t queueHandle,
                           void *pEventData)
 {
-    uPortQueue_t *pQueue = (uPortQueue_t *)queueHandle;
-    uErrorCode_t errorCode = readFromQueue(pQueue, pEventData);
-    while (errorCode == U_ERROR_COMMON_EMPTY) {
-        // Not available, blocking wait.
-        uPortSemaphoreTake(pQueue->semHandle);
-        errorCode = readFromQueue(pQueue, pEventData);
-    }
-    return (int32_t)errorCode;
+    return (int32_t) queueReceive((uPortQueue_t *) queueHandle, pEventData, -1);
 }
 
 // Receive from the given queue, non-blocking.
@@ -617,23 +673,29 @@ int32_t uPortQueueReceiveIrq(const uPortQueueHandle_t queueHandle,
 int32_t uPortQueueTryReceive(const uPortQueueHandle_t queueHandle,
                              int32_t waitMs, void *pEventData)
 {
-    uPortQueue_t *pQueue = (uPortQueue_t *)queueHandle;
-    uErrorCode_t errorCode = readFromQueue(pQueue, pEventData);
-    if (errorCode != U_ERROR_COMMON_SUCCESS) {
-        // Not available, timeout wait.
-        errorCode = uPortSemaphoreTryTake(pQueue->semHandle, waitMs);
-        if (errorCode == U_ERROR_COMMON_SUCCESS) {
-            errorCode = readFromQueue(pQueue, pEventData);
-        }
+    if (waitMs < 0) {
+        waitMs = 0;
     }
-    return (int32_t)errorCode;
+    return (int32_t) queueReceive((uPortQueue_t *) queueHandle, pEventData, waitMs);
 }
 
 // Peek the given queue.
 int32_t uPortQueuePeek(const uPortQueueHandle_t queueHandle,
                        void *pEventData)
 {
-    return (int32_t)U_ERROR_COMMON_NOT_IMPLEMENTED;
+    uErrorCode_t errorCode = U_ERROR_COMMON_INVALID_PARAMETER;
+    uPortQueue_t *pQueue = (uPortQueue_t *)queueHandle;
+    if ((pQueue != NULL) && (pEventData != NULL)) {
+        errorCode = U_ERROR_COMMON_TIMEOUT;
+        pthread_mutex_lock(&(pQueue->mutex));
+        if (pQueue->count > 0) {
+            memcpy(pEventData, pQueue->items + (pQueue->readIndex * pQueue->itemSizeBytes),
+                   pQueue->itemSizeBytes);
+            errorCode = U_ERROR_COMMON_SUCCESS;
+        }
+        pthread_mutex_unlock(&(pQueue->mutex));
+    }
+    return (int32_t)errorCode;
 }
 
 // Get the number of free spaces in the given queue.
@@ -641,12 +703,11 @@ int32_t uPortQueueGetFree(const uPortQueueHandle_t queueHandle)
 {
     uPortQueue_t *pQueue = (uPortQueue_t *)queueHandle;
     if (pQueue != NULL) {
-        size_t maxFree = pQueue->queueLength * pQueue->itemSizeBytes;
-        size_t freeBytes = fcntl(pQueue->fd[1], F_GETPIPE_SZ) - pQueue->readCount;
-        if (freeBytes > maxFree) {
-            freeBytes = maxFree;
-        }
-        return (freeBytes / pQueue->itemSizeBytes);
+        int32_t numFree;
+        pthread_mutex_lock(&(pQueue->mutex));
+        numFree = (int32_t) (pQueue->queueLength - pQueue->count);
+        pthread_mutex_unlock(&(pQueue->mutex));
+        return numFree;
     } else {
         return (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
     }
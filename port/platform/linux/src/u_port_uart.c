@@ -31,9 +31,11 @@
 #include "fcntl.h"
 #include "termios.h"
 #include "unistd.h"
-#include "sys/select.h"
+#include "errno.h"
 #include "pthread.h"  // threadId
-#include "sys/ioctl.h"
+#include "sys/epoll.h"
+#include "sys/eventfd.h"
+#include "sys/uio.h"  // readv()
 #include "sys/param.h"
 #include "u_error_common.h"
 #include "u_linked_list.h"
@@ -54,35 +56,56 @@
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
 
-#ifndef U_PORT_UART_READ_WAIT_MS
-/** How long to wait when there is nothing to read from the UART.
+#ifndef U_PORT_UART_MAX_NUM
+/** The maximum number of UARTs that may be open at any one time.
  */
-# define U_PORT_UART_READ_WAIT_MS 10
+# define U_PORT_UART_MAX_NUM 64
 #endif
 
-#ifndef U_PORT_UART_START_STOP_WAIT_MS
-/** How long to wait for a UART, mostly the read task, to start up
- * and shut down.
+#ifndef U_PORT_UART_IO_TASK_STACK_SIZE_BYTES
+/** The stack size of the task that reads all of the UARTs.
  */
-# define U_PORT_UART_START_STOP_WAIT_MS (U_PORT_UART_READ_WAIT_MS * 10)
+# define U_PORT_UART_IO_TASK_STACK_SIZE_BYTES (1024 * 8)
+#endif
+
+#ifndef U_PORT_UART_IO_TASK_PRIORITY
+/** The priority of the task that reads all of the UARTs.
+ */
+# define U_PORT_UART_IO_TASK_PRIORITY (U_CFG_OS_PRIORITY_MAX - 5)
+#endif
+
+#ifndef U_PORT_UART_IO_MAX_EVENTS
+/** The maximum number of epoll events the I/O task handles
+ * in one go.
+ */
+# define U_PORT_UART_IO_MAX_EVENTS 16
 #endif
 
 /* ----------------------------------------------------------------
  * TYPES
  * -------------------------------------------------------------- */
 
+/** The data for a UART.  The receive buffer is a single-producer,
+ * single-consumer ring: writeIndex is only moved on by the I/O task
+ * and readIndex only by uPortUartRead(); both are free-running, the
+ * amount of data in the buffer being the difference between them.
+ */
 typedef struct uPortUartData_t {
     int32_t id;
     int uartFd;
     bool markedForDeletion;
-    uPortTaskHandle_t rxTask;
-    uPortMutexHandle_t mutex;
+    uPortMutexHandle_t mutex; /**< Serialises readers and guards rxPaused. */
     bool bufferAllocated;
     char *pBuffer;
     size_t bufferSize;
-    size_t readPos;
-    size_t writePos;
-    bool bufferFull;
+    size_t readIndex;
+    size_t writeIndex;
+    bool rxPaused; /**< True if the UART has been taken out of the epoll set
+                        because the receive buffer is full. */
+    bool inEpoll;
+    struct uPortUartSlot_t *pSlot; /**< Where this UART is in gUart[]. */
+    int32_t eventPending; /**< Set while a data received event sent by the
+                               I/O task has yet to reach the callback. */
     bool hwHandshake;
     bool handshakeSuspended;
     int32_t eventQueueHandle;
@@ -91,6 +114,16 @@ typedef struct uPortUartData_t {
     void *pEventCallbackParam;
 } uPortUartData_t;
 
+/** An entry in the table of open UARTs.  The table is searched
+ * without gMutex on the data path, so a UART is only freed once
+ * users, which such a search increments before looking at
+ * pUartData, has dropped back to zero.
+ */
+typedef struct uPortUartSlot_t {
+    uPortUartData_t *pUartData;
+    int32_t users;
+} uPortUartSlot_t;
+
 /** Structure describing an event.
  */
 typedef struct {
@@ -98,6 +131,7 @@ typedef struct {
     uint32_t eventBitMap;
     void (*pEventCallback)(int32_t, uint32_t, void *);
     void *pEventCallbackParam;
+    uPortUartData_t *pUartData; /**< Set if this event was sent by the I/O task. */
 } uPortUartEvent_t;
 
 /** Structure to hold a UART name prefix along with the thread
@@ -117,9 +151,13 @@ typedef struct {
  */
 static uPortMutexHandle_t gMutex = NULL;
 
-/** Root of linked list of UART data.
+/** Table of open UARTs.
  */
-static uLinkedList_t *gpUartList = NULL;
+static uPortUartSlot_t gUart[U_PORT_UART_MAX_NUM] = {0};
+
+/** The number of entries in gUart[] that are in use.
+ */
+static size_t gNumUarts = 0;
 
 /** Root of linked list of UART prefixes.
  */
@@ -129,15 +167,83 @@ static uLinkedList_t *gpUartPrefixList = NULL;
  */
 static volatile int32_t gResourceAllocCount = 0;
 
+/** The task that reads all of the UARTs; it runs while
+ * at least one UART is open.
+ */
+static uPortTaskHandle_t gIoTask = NULL;
+
+/** The epoll instance that the I/O task waits on.
+ */
+static int gEpollFd = -1;
+
+/** eventfd used to wake up the I/O task.
+ */
+static int gWakeFd = -1;
+
+/** Flag to tell the I/O task to exit.
+ */
+static bool gIoStop = false;
+
+/** Set by the I/O task when it has exited.
+ */
+static bool gIoStopped = false;
+
+/** Incremented by the I/O task each time it has dealt
+ * with a set of epoll events.
+ */
+static uint32_t gIoGeneration = 0;
+
 /* ----------------------------------------------------------------
  * STATIC FUNCTIONS
  * -------------------------------------------------------------- */
 
+// Find a UART on the data path, i.e. without gMutex: if a UART
+// is returned, uartRelease() must be called on it when done.
+static uPortUartData_t *pUartAcquire(int32_t handle)
+{
+    uPortUartSlot_t *pSlot;
+    uPortUartData_t *pUartData;
+    uPortUartData_t *pFound = NULL;
+    bool keepLooking = true;
+
+    if (handle >= 0) {
+        // UARTs are placed in the table starting at their
+        // handle so this will usually find one first time
+        for (size_t x = 0; (x < U_PORT_UART_MAX_NUM) && keepLooking; x++) {
+            pSlot = &(gUart[(handle + x) % U_PORT_UART_MAX_NUM]);
+            U_ATOMIC_INCREMENT(&(pSlot->users));
+            pUartData = U_ATOMIC_GET(&(pSlot->pUartData));
+            if ((pUartData != NULL) && (pUartData->uartFd == handle)) {
+                keepLooking = false;
+                if (!pUartData->markedForDeletion) {
+                    pFound = pUartData;
+                }
+            }
+            if (pFound == NULL) {
+                U_ATOMIC_DECREMENT(&(pSlot->users));
+            }
+        }
+    }
+
+    return pFound;
+}
+
+// Release a UART obtained with pUartAcquire().
+static void uartRelease(uPortUartData_t *pUartData)
+{
+    U_ATOMIC_DECREMENT(&(pUartData->pSlot->users));
+}
+
 // Event handler, calls the user's event callback.
 static void eventHandler(void *pParam, size_t paramLength)
 {
     uPortUartEvent_t *pEvent = (uPortUartEvent_t *) pParam;
     (void) paramLength;
+    if (pEvent->pUartData != NULL) {
+        // Any data arriving from now on needs a new event; the
+        // UART can't have gone since closing it closes this queue
+        U_ATOMIC_SET_RELEASE(&(pEvent->pUartData->eventPending), 0);
+    }
     if (pEvent->pEventCallback != NULL) {
         pEvent->pEventCallback(pEvent->uartHandle,
                                pEvent->eventBitMap,
@@ -145,74 +251,176 @@ static void eventHandler(void *pParam, size_t paramLength)
     }
 }
 
-// Task handling incoming uart data
-static void readTask(void *pParam)
-{
-    uPortUartData_t *p = (uPortUartData_t *)pParam;
-    // Need a brief pause before calling select after open.
-    uPortTaskBlock(10);
-    while (!p->markedForDeletion) {
-        // Initiate a set for select operation.
-        fd_set set;
-        FD_ZERO(&set);
-        FD_SET(p->uartFd, &set);
-        // Select timeout
-        struct timeval tv = {0};
-        tv.tv_usec = U_CFG_OS_YIELD_MS * 1000;
-        // Wait for input
-        int res = select(p->uartFd + 1, &set, NULL, NULL, &tv);
-        if (res > 0) {
-            // Input is available.
-            int available;
-            do {
-                available = 0;
-                ioctl(p->uartFd, FIONREAD, &available);
-                size_t cnt = 0;
-                size_t tot = 0;
-                // Sample readPos
-                size_t readPos = p->readPos;
-                U_PORT_MUTEX_LOCK(p->mutex);
-                if (p->writePos >= readPos) {
-                    // Write pos ahead of read. Use the remaining area in the
-                    // buffer first.
-                    cnt = MIN(available, p->bufferSize - p->writePos);
-                    cnt = read(p->uartFd, p->pBuffer + p->writePos, cnt);
-                    if (cnt > 0) {
-                        available -= cnt;
-                        p->writePos = (p->writePos + cnt) % p->bufferSize;
-                    }
-                    tot = cnt;
-                }
-                if ((available > 0) && (p->writePos < readPos)) {
-                    // Read pos ahead of write.
-                    cnt = MIN(available, readPos - p->writePos);
-                    cnt = read(p->uartFd, p->pBuffer + p->writePos, cnt);
-                    if (cnt > 0) {
-                        available -= cnt;
-                        p->writePos = (p->writePos + cnt) % p->bufferSize;
-                        // We might have filled up the buffer, in which case we must wait below.
-                        p->bufferFull = p->writePos == readPos;
-                    }
-                    tot += cnt;
-                }
-                U_PORT_MUTEX_UNLOCK(p->mutex);
-                if ((tot > 0) &&
-                    (p->eventQueueHandle >= 0)) {
-                    // Call the user callback
-                    uPortUartEvent_t event;
-                    event.uartHandle = p->uartFd;
-                    event.eventBitMap = U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED;
-                    event.pEventCallback = p->pEventCallback;
-                    event.pEventCallbackParam = p->pEventCallbackParam;
-                    uPortEventQueueSend(p->eventQueueHandle, &event, sizeof(event));
-                }
-                while (p->bufferFull && !p->markedForDeletion) {
-                    // Buffer is full, wait for consumption.
-                    uPortTaskBlock(U_PORT_UART_READ_WAIT_MS);
+// Take a UART in or out of the epoll set of the I/O task.
+static void epollArm(uPortUartData_t *pUartData, bool onNotOff)
+{
+    struct epoll_event event = {0};
+
+    if (onNotOff) {
+        event.events = EPOLLIN;
+    }
+    event.data.ptr = pUartData;
+    epoll_ctl(gEpollFd, EPOLL_CTL_MOD, pUartData->uartFd, &event);
+}
+
+// Read whatever a UART has to offer into its receive buffer;
+// called only by the I/O task.
+static void receive(uPortUartData_t *pUartData, uint32_t events)
+{
+    size_t writeIndex = pUartData->writeIndex;
+    size_t space = pUartData->bufferSize - (writeIndex -
+                                            U_ATOMIC_GET_ACQUIRE(&(pUartData->readIndex)));
+    size_t offset = writeIndex % pUartData->bufferSize;
+    struct iovec iov[2];
+    ssize_t length = 0;
+    int32_t eventQueueHandle;
+    uPortUartEvent_t event;
+
+    if (space > 0) {
+        // Read into the free space, which may wrap, in one go
+        iov[0].iov_base = pUartData->pBuffer + offset;
+        iov[0].iov_len = MIN(space, pUartData->bufferSize - offset);
+        iov[1].iov_base = pUartData->pBuffer;
+        iov[1].iov_len = space - iov[0].iov_len;
+        length = readv(pUartData->uartFd, iov, (iov[1].iov_len > 0) ? 2 : 1);
+        if (length > 0) {
+            U_ATOMIC_SET_RELEASE(&(pUartData->writeIndex), writeIndex + length);
+            space -= length;
+            eventQueueHandle = pUartData->eventQueueHandle;
+            if ((eventQueueHandle >= 0) &&
+                (U_ATOMIC_GET_ACQUIRE(&(pUartData->eventPending)) == 0)) {
+                // Call the user callback, unless there is
+                // already an event on its way to it
+                U_ATOMIC_SET_RELEASE(&(pUartData->eventPending), 1);
+                event.uartHandle = pUartData->uartFd;
+                event.eventBitMap = U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED;
+                event.pEventCallback = pUartData->pEventCallback;
+                event.pEventCallbackParam = pUartData->pEventCallbackParam;
+                event.pUartData = pUartData;
+                if (uPortEventQueueSend(eventQueueHandle, &event, sizeof(event)) != 0) {
+                    U_ATOMIC_SET_RELEASE(&(pUartData->eventPending), 0);
                 }
-            } while ((available > 0) && !p->markedForDeletion);
+            }
+        } else if ((length == 0) || ((errno != EAGAIN) && (errno != EINTR))) {
+            if (events & (EPOLLHUP | EPOLLERR)) {
+                // The device has gone away; stop listening to it
+                // rather than spinning on it
+                epollArm(pUartData, false);
+            }
+        }
+    }
+
+    if (space == 0) {
+        // The buffer is full: take the UART out of the epoll set
+        // until uPortUartRead() makes room, checking again under
+        // the mutex in case it just has
+        U_PORT_MUTEX_LOCK(pUartData->mutex);
+        if (pUartData->bufferSize == pUartData->writeIndex - pUartData->readIndex) {
+            epollArm(pUartData, false);
+            pUartData->rxPaused = true;
+        }
+        U_PORT_MUTEX_UNLOCK(pUartData->mutex);
+    }
+}
+
+// The task that reads all of the UARTs.
+static void ioTask(void *pParam)
+{
+    struct epoll_event events[U_PORT_UART_IO_MAX_EVENTS];
+    uint64_t count;
+    int numEvents;
+
+    (void) pParam;
+
+    while (!U_ATOMIC_GET(&gIoStop)) {
+        numEvents = epoll_wait(gEpollFd, events, U_PORT_UART_IO_MAX_EVENTS, -1);
+        for (int x = 0; x < numEvents; x++) {
+            if (events[x].data.ptr == NULL) {
+                // Just a wake-up
+                if (read(gWakeFd, &count, sizeof(count))) {}
+            } else {
+                receive((uPortUartData_t *) events[x].data.ptr, events[x].events);
+            }
+        }
+        U_ATOMIC_INCREMENT(&gIoGeneration);
+    }
+
+    // Must be set before deleting ourselves: nothing after
+    // uPortTaskDelete(NULL) is guaranteed to be run
+    U_ATOMIC_SET_RELEASE(&gIoStopped, true);
+    uPortTaskDelete(NULL);
+}
+
+// Wake the I/O task and wait for it to go around its loop,
+// after which it cannot be holding a pointer to anything that
+// was taken out of the epoll set before this was called.
+static void ioSync()
+{
+    uint32_t generation = U_ATOMIC_GET(&gIoGeneration);
+    uint64_t one = 1;
+
+    if (write(gWakeFd, &one, sizeof(one))) {}
+    while (U_ATOMIC_GET(&gIoGeneration) == generation) {
+        uPortTaskBlock(1);
+    }
+}
+
+// Start the I/O task; gMutex must be locked.
+static int32_t ioStart()
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+    struct epoll_event event = {0};
+
+    if (gIoTask == NULL) {
+        errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+        gEpollFd = epoll_create1(EPOLL_CLOEXEC);
+        gWakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if ((gEpollFd >= 0) && (gWakeFd >= 0)) {
+            // The eventfd is marked by a NULL data pointer
+            event.events = EPOLLIN;
+            event.data.ptr = NULL;
+            if (epoll_ctl(gEpollFd, EPOLL_CTL_ADD, gWakeFd, &event) == 0) {
+                gIoStop = false;
+                gIoStopped = false;
+                errorCode = uPortTaskCreate(ioTask, "uartIo",
+                                            U_PORT_UART_IO_TASK_STACK_SIZE_BYTES,
+                                            NULL, U_PORT_UART_IO_TASK_PRIORITY,
+                                            &gIoTask);
+            }
+        }
+        if (errorCode != 0) {
+            if (gWakeFd >= 0) {
+                close(gWakeFd);
+                gWakeFd = -1;
+            }
+            if (gEpollFd >= 0) {
+                close(gEpollFd);
+                gEpollFd = -1;
+            }
+            gIoTask = NULL;
         }
     }
+
+    return errorCode;
+}
+
+// Stop the I/O task; gMutex must be locked.
+static void ioStop()
+{
+    uint64_t one = 1;
+
+    if (gIoTask != NULL) {
+        U_ATOMIC_SET_RELEASE(&gIoStop, true);
+        if (write(gWakeFd, &one, sizeof(one))) {}
+        while (!U_ATOMIC_GET_ACQUIRE(&gIoStopped)) {
+            uPortTaskBlock(1);
+        }
+        gIoTask = NULL;
+        close(gWakeFd);
+        gWakeFd = -1;
+        close(gEpollFd);
+        gEpollFd = -1;
+    }
 }
 
 static uPortUartPrefix_t *pFindPrefix(pthread_t threadId)
@@ -228,42 +436,94 @@ static uPortUartPrefix_t *pFindPrefix(pthread_t threadId)
     return NULL;
 }
 
+// Find a UART; gMutex must be locked.
 static uPortUartData_t *pFindUart(int32_t handle)
 {
-    uLinkedList_t *p = gpUartList;
-    while (p != NULL) {
-        uPortUartData_t *pUart = (uPortUartData_t *)(p->p);
-        if (pUart->uartFd == handle) {
-            return pUart;
+    uPortUartData_t *pUartData;
+
+    for (size_t x = 0; x < U_PORT_UART_MAX_NUM; x++) {
+        pUartData = gUart[x].pUartData;
+        if ((pUartData != NULL) && (pUartData->uartFd == handle)) {
+            return pUartData;
         }
-        p = p->pNext;
     }
     return NULL;
 }
 
+// Find a UART by ID; gMutex must be locked.
 static uPortUartData_t *pFindUartById(int32_t id)
 {
-    uLinkedList_t *p = gpUartList;
-    while (p != NULL) {
-        uPortUartData_t *pUart = (uPortUartData_t *)(p->p);
-        if (pUart->id == id) {
-            return pUart;
+    uPortUartData_t *pUartData;
+
+    for (size_t x = 0; x < U_PORT_UART_MAX_NUM; x++) {
+        pUartData = gUart[x].pUartData;
+        if ((pUartData != NULL) && (pUartData->id == id)) {
+            return pUartData;
         }
-        p = p->pNext;
     }
     return NULL;
 }
 
+// Add a UART to the table and to the epoll set of the I/O
+// task, starting the I/O task if required; gMutex must be locked.
+static int32_t addUartData(uPortUartData_t *p)
+{
+    int32_t errorCode = (int32_t) U_ERROR_COMMON_NO_MEMORY;
+    uPortUartSlot_t *pSlot;
+    struct epoll_event event = {0};
+
+    for (size_t x = 0; (x < U_PORT_UART_MAX_NUM) && (p->pSlot == NULL); x++) {
+        pSlot = &(gUart[(p->uartFd + x) % U_PORT_UART_MAX_NUM]);
+        if (pSlot->pUartData == NULL) {
+            p->pSlot = pSlot;
+        }
+    }
+    if (p->pSlot != NULL) {
+        errorCode = ioStart();
+        if (errorCode == 0) {
+            gNumUarts++;
+            U_ATOMIC_SET_RELEASE(&(p->pSlot->pUartData), p);
+            event.events = EPOLLIN;
+            event.data.ptr = p;
+            if (epoll_ctl(gEpollFd, EPOLL_CTL_ADD, p->uartFd, &event) == 0) {
+                p->inEpoll = true;
+            } else {
+                errorCode = (int32_t) U_ERROR_COMMON_PLATFORM;
+            }
+        } else {
+            p->pSlot = NULL;
+        }
+    }
+
+    return errorCode;
+}
+
 static void disposeUartData(uPortUartData_t *p)
 {
     if (p != NULL) {
-        uLinkedListRemove(&gpUartList, p);
-        if (p->rxTask != NULL) {
-            uPortTaskDelete(p->rxTask);
-            // Wait for the task to exit before
-            // we pull the structures out from under it
-            uPortTaskBlock(U_PORT_UART_START_STOP_WAIT_MS);
+        U_PORT_MUTEX_LOCK(gMutex);
+        if (p->pSlot != NULL) {
+            // Take the UART out of the table and wait for
+            // anyone on the data path to let go of it; this
+            // store must be sequentially consistent so that it
+            // can't be reordered after the load of users, else
+            // pUartAcquire() could increment users and still
+            // see the UART after we have seen users as zero
+            U_ATOMIC_SET(&(p->pSlot->pUartData), NULL);
+            while (U_ATOMIC_GET(&(p->pSlot->users)) > 0) {
+                uPortTaskBlock(1);
+            }
+            if (p->inEpoll) {
+                epoll_ctl(gEpollFd, EPOLL_CTL_DEL, p->uartFd, NULL);
+                // Make sure that the I/O task has let go of it too
+                ioSync();
+            }
+            gNumUarts--;
+            if (gNumUarts == 0) {
+                ioStop();
+            }
         }
+        U_PORT_MUTEX_UNLOCK(gMutex);
         if (p->eventQueueHandle >= 0) {
             uPortEventQueueClose(p->eventQueueHandle);
         }
@@ -276,8 +536,10 @@ static void disposeUartData(uPortUartData_t *p)
         if (p->mutex != NULL) {
             uPortMutexDelete(p->mutex);
         }
+        if (p->pSlot != NULL) {
+            U_ATOMIC_DECREMENT(&gResourceAllocCount);
+        }
         uPortFree(p);
-        U_ATOMIC_DECREMENT(&gResourceAllocCount);
     }
 }
 
@@ -345,11 +607,10 @@ void uPortUartDeinit()
         U_PORT_MUTEX_LOCK(gMutex);
 
         // First, mark all instances for deletion
-        uLinkedList_t *pList = gpUartList;
-        while (pList != NULL) {
-            uPortUartData_t *pUart = (uPortUartData_t *)(pList->p);
-            pUart->markedForDeletion = true;
-            pList = pList->pNext;
+        for (size_t x = 0; x < U_PORT_UART_MAX_NUM; x++) {
+            if (gUart[x].pUartData != NULL) {
+                gUart[x].pUartData->markedForDeletion = true;
+            }
         }
 
         // Remove any UART prefixes
@@ -363,9 +624,8 @@ void uPortUartDeinit()
         U_PORT_MUTEX_UNLOCK(gMutex);
 
         // Now remove all existing uarts
-        while (gpUartList != NULL) {
-            uPortUartData_t *pUart = (uPortUartData_t *)(gpUartList->p);
-            disposeUartData(pUart);
+        for (size_t x = 0; x < U_PORT_UART_MAX_NUM; x++) {
+            disposeUartData(gUart[x].pUartData);
         }
         // Delete the mutex
         U_PORT_MUTEX_LOCK(gMutex);
@@ -416,7 +676,11 @@ int32_t uPortUartOpen(int32_t uart, int32_t baudRate,
     if (gMutex == NULL) {
         return U_ERROR_COMMON_NOT_INITIALISED;
     }
-    if ((uart >= 0) && (pFindUartById(uart) != NULL)) {
+    bool busy;
+    U_PORT_MUTEX_LOCK(gMutex);
+    busy = (uart >= 0) && (pFindUartById(uart) != NULL);
+    U_PORT_MUTEX_UNLOCK(gMutex);
+    if (busy) {
         return (int32_t)U_ERROR_COMMON_BUSY;
     }
     uPortUartData_t *pUartData = pUPortMalloc(sizeof(uPortUartData_t));
@@ -481,9 +745,10 @@ int32_t uPortUartOpen(int32_t uart, int32_t baudRate,
     } else {
         options.c_cflag &= ~CRTSCTS;
     }
-    // Set timed read with 100 ms timeout
+    // Reads are only made by the I/O task when epoll says
+    // there is something to read, so never wait in read()
     options.c_cc[VMIN] = 0;
-    options.c_cc[VTIME] = 1;
+    options.c_cc[VTIME] = 0;
     if (tcsetattr(pUartData->uartFd, TCSANOW, &options) == 0) {
         tcflush(pUartData->uartFd, TCIOFLUSH);
     } else {
@@ -500,23 +765,21 @@ int32_t uPortUartOpen(int32_t uart, int32_t baudRate,
         pUartData->pBuffer = pReceiveBuffer;
     }
     pUartData->bufferSize = bufferSize;
-    pUartData->readPos = 0;
-    pUartData->writePos = 0;
-    pUartData->bufferFull = false;
     if (uPortMutexCreate(&(pUartData->mutex)) != 0) {
         FAIL(U_ERROR_COMMON_NO_MEMORY);
     }
-    if (uPortTaskCreate(readTask, "", 4 * 1024, pUartData, U_CFG_OS_PRIORITY_MAX - 5,
-                        &(pUartData->rxTask)) != 0) {
-        FAIL(U_ERROR_COMMON_PLATFORM);
-    }
-    // Wait for the read task to start
-    uPortTaskBlock(U_PORT_UART_START_STOP_WAIT_MS);
+    pUartData->id = uart;
+    // Hand the UART to the I/O task
+    int32_t errorCode;
     U_PORT_MUTEX_LOCK(gMutex);
-    uLinkedListAdd(&gpUartList, (void *)pUartData);
+    errorCode = addUartData(pUartData);
     U_PORT_MUTEX_UNLOCK(gMutex);
-    U_ATOMIC_INCREMENT(&gResourceAllocCount);
-    pUartData->id = uart;
+    if (pUartData->pSlot != NULL) {
+        U_ATOMIC_INCREMENT(&gResourceAllocCount);
+    }
+    if (errorCode != 0) {
+        FAIL(errorCode);
+    }
     return (int32_t)(pUartData->uartFd);
 }
 
@@ -525,13 +788,17 @@ void uPortUartClose(int32_t handle)
 {
     if (gMutex != NULL) {
 
-        uPortUartData_t *pUartData = pFindUart(handle);
+        uPortUartData_t *pUartData;
 
         U_PORT_MUTEX_LOCK(gMutex);
 
+        pUartData = pFindUart(handle);
         if ((pUartData != NULL) && !pUartData->markedForDeletion) {
             // Mark the UART for deletion within the mutex
             pUartData->markedForDeletion = true;
+        } else {
+            // Already on its way out
+            pUartData = NULL;
         }
 
         U_PORT_MUTEX_UNLOCK(gMutex);
@@ -549,23 +816,12 @@ int32_t uPortUartGetReceiveSize(int32_t handle)
     int32_t sizeOrErrorCode = (int32_t)U_ERROR_COMMON_NOT_INITIALISED;
     if (gMutex != NULL) {
         sizeOrErrorCode = (int32_t)U_ERROR_COMMON_INVALID_PARAMETER;
-        U_PORT_MUTEX_LOCK(gMutex);
-        uPortUartData_t *pUartData = pFindUart(handle);
-        if ((pUartData != NULL) && !pUartData->markedForDeletion) {
-            if (pUartData->bufferFull) {
-                sizeOrErrorCode = pUartData->bufferSize;
-            } else if (pUartData->readPos <= pUartData->writePos) {
-                // Read pointer is behind write, bytes
-                // received is simply the difference
-                sizeOrErrorCode = pUartData->writePos - pUartData->readPos;
-            } else {
-                // Read pointer is ahead of write, bytes received
-                // is from the read pointer up to the end of the buffer
-                // then wrap around to the write pointer
-                sizeOrErrorCode = (int32_t)((pUartData->bufferSize - pUartData->readPos) + pUartData->writePos);
-            }
+        uPortUartData_t *pUartData = pUartAcquire(handle);
+        if (pUartData != NULL) {
+            sizeOrErrorCode = (int32_t) (U_ATOMIC_GET_ACQUIRE(&(pUartData->writeIndex)) -
+                                         U_ATOMIC_GET_ACQUIRE(&(pUartData->readIndex)));
+            uartRelease(pUartData);
         }
-        U_PORT_MUTEX_UNLOCK(gMutex);
     }
     return sizeOrErrorCode;
 }
@@ -576,47 +832,35 @@ int32_t uPortUartRead(int32_t handle, void *pBuffer,
 {
     int32_t sizeOrErrorCode = (int32_t)U_ERROR_COMMON_NOT_INITIALISED;
     if (gMutex != NULL) {
-        U_PORT_MUTEX_LOCK(gMutex);
         sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        uPortUartData_t *pUartData = pFindUart(handle);
-        if ((pBuffer != NULL) && (sizeBytes > 0) &&
-            (pUartData != NULL) && !pUartData->markedForDeletion) {
-            sizeOrErrorCode = 0;
-            U_PORT_MUTEX_LOCK(pUartData->mutex);
-            if (pUartData->readPos < pUartData->writePos) {
-                // Read pointer is behind write, just take as much
-                // of the difference as the user allows
-                sizeOrErrorCode = MIN(pUartData->writePos - pUartData->readPos, (int32_t)sizeBytes);
-                memcpy(pBuffer, pUartData->pBuffer + pUartData->readPos, sizeOrErrorCode);
-                // Move the pointer on
-                pUartData->readPos += sizeOrErrorCode;
-            } else if ((pUartData->readPos > pUartData->writePos) || pUartData->bufferFull) {
-                // Read pointer is ahead of write or buffer is full, first take up to the
-                // end of the buffer as far as the user allows
-                size_t cnt = MIN(pUartData->bufferSize - pUartData->readPos, (int32_t)sizeBytes);
-                memcpy(pBuffer, pUartData->pBuffer + pUartData->readPos, cnt);
-                pBuffer = (char *) pBuffer + cnt;
-                sizeBytes -= cnt;
-                sizeOrErrorCode = (int32_t)cnt;
-                // Move the read pointer on, wrapping as necessary
-                pUartData->readPos = (pUartData->readPos + cnt) % pUartData->bufferSize;
-                // If there is still room in the user buffer then
-                // carry on taking up to the write pointer
-                if (sizeBytes > 0) {
-                    cnt = MIN(pUartData->writePos, sizeBytes);
-                    memcpy(pBuffer, pUartData->pBuffer, cnt);
-                    sizeOrErrorCode += cnt;
-                    // Move the read pointer on
-                    pUartData->readPos += cnt;
+        uPortUartData_t *pUartData = pUartAcquire(handle);
+        if (pUartData != NULL) {
+            if ((pBuffer != NULL) && (sizeBytes > 0)) {
+                size_t cnt;
+                U_PORT_MUTEX_LOCK(pUartData->mutex);
+                size_t readIndex = pUartData->readIndex;
+                size_t offset = readIndex % pUartData->bufferSize;
+                // Take as much as the user allows, in
+                // two parts if the data wraps
+                cnt = MIN(U_ATOMIC_GET_ACQUIRE(&(pUartData->writeIndex)) - readIndex,
+                          sizeBytes);
+                size_t cntToEnd = MIN(cnt, pUartData->bufferSize - offset);
+                memcpy(pBuffer, pUartData->pBuffer + offset, cntToEnd);
+                memcpy((char *) pBuffer + cntToEnd, pUartData->pBuffer, cnt - cntToEnd);
+                // Move the read index on, releasing the space to the I/O task
+                U_ATOMIC_SET_RELEASE(&(pUartData->readIndex), readIndex + cnt);
+                if (pUartData->rxPaused && (cnt > 0)) {
+                    // The I/O task stopped reading this UART because
+                    // the buffer was full: now there is room, put the
+                    // UART back into its epoll set, which will wake it
+                    pUartData->rxPaused = false;
+                    epollArm(pUartData, true);
                 }
+                U_PORT_MUTEX_UNLOCK(pUartData->mutex);
+                sizeOrErrorCode = (int32_t) cnt;
             }
-            if (pUartData->bufferFull && (sizeOrErrorCode > 0)) {
-                // Release possible waiting read task.
-                pUartData->bufferFull = false;
-            }
-            U_PORT_MUTEX_UNLOCK(pUartData->mutex);
+            uartRelease(pUartData);
         }
-        U_PORT_MUTEX_UNLOCK(gMutex);
     }
     return sizeOrErrorCode;
 }
@@ -627,17 +871,17 @@ int32_t uPortUartWrite(int32_t handle, const void *pBuffer,
 {
     int32_t sizeOrErrorCode = (int32_t)U_ERROR_COMMON_NOT_INITIALISED;
     if (gMutex != NULL) {
-        U_PORT_MUTEX_LOCK(gMutex);
         sizeOrErrorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
-        uPortUartData_t *pUartData = pFindUart(handle);
-        if ((pBuffer != NULL) && (sizeBytes > 0) &&
-            (pUartData != NULL) && !pUartData->markedForDeletion) {
-            sizeOrErrorCode = write(pUartData->uartFd, pBuffer, sizeBytes);
-            if (sizeOrErrorCode < 0) {
-                sizeOrErrorCode = (int32_t)U_ERROR_COMMON_PLATFORM;
+        uPortUartData_t *pUartData = pUartAcquire(handle);
+        if (pUartData != NULL) {
+            if ((pBuffer != NULL) && (sizeBytes > 0)) {
+                sizeOrErrorCode = write(pUartData->uartFd, pBuffer, sizeBytes);
+                if (sizeOrErrorCode < 0) {
+                    sizeOrErrorCode = (int32_t)U_ERROR_COMMON_PLATFORM;
+                }
             }
+            uartRelease(pUartData);
         }
-        U_PORT_MUTEX_UNLOCK(gMutex);
     }
     return sizeOrErrorCode;
 }
@@ -670,6 +914,7 @@ int32_t uPortUartEventCallbackSet(int32_t handle,
                                             priority,
                                             U_PORT_UART_EVENT_QUEUE_SIZE);
             if (errorCode >= 0) {
+                U_ATOMIC_SET_RELEASE(&(pUartData->eventPending), 0);
                 pUartData->eventQueueHandle = (int32_t) errorCode;
                 pUartData->eventFilter = filter;
                 pUartData->pEventCallback = pFunction;
@@ -762,8 +1007,10 @@ int32_t uPortUartEventSend(int32_t handle, uint32_t eventBitMap)
             event.eventBitMap = eventBitMap;
             event.pEventCallback = pUartData->pEventCallback;
             event.pEventCallbackParam = pUartData->pEventCallbackParam;
-            errorCode = uPortEventQueueSend(pUartData->eventQueueHandle,
-                                            &event, sizeof(event));
+            event.pUartData = NULL;
+            // No point in queueing more than one of these
+            errorCode = uPortEventQueueSendCoalesced(pUartData->eventQueueHandle,
+                                                     &event, sizeof(event));
         }
         U_PORT_MUTEX_UNLOCK(gMutex);
     }
@@ -0,0 +1,364 @@
+/*
+ * Copyright 2019-2024 u-blox
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** @file
+ * @brief Tests of the Linux UART driver with many UARTs open at
+ * once.  No hardware is required: each UART is the slave end of a
+ * pseudo-terminal, the master end of which is driven by the test.
+ *
+ * IMPORTANT: see notes in u_cfg_test_platform_specific.h for the
+ * naming rules that must be followed when using the U_PORT_TEST_FUNCTION()
+ * macro.
+ */
+
+#ifdef U_CFG_OVERRIDE
+# include "u_cfg_override.h" // For a customer's configuration override
+#endif
+
+#define _GNU_SOURCE // posix_openpt(), ptsname() etc.
+
+#include "stddef.h"    // NULL, size_t etc.
+#include "stdlib.h"
+#include "stdint.h"    // int32_t etc.
+#include "stdbool.h"
+#include "string.h"    // memset()
+#include "unistd.h"
+#include "fcntl.h"
+#include "termios.h"
+
+#include "u_cfg_sw.h"
+#include "u_cfg_app_platform_specific.h"
+#include "u_cfg_test_platform_specific.h"
+#include "u_cfg_os_platform_specific.h"
+
+#include "u_error_common.h"
+
+#include "u_port.h"
+#include "u_port_os.h"
+#include "u_port_debug.h"
+#include "u_port_uart.h"
+#include "u_port_event_queue.h"
+
+#include "u_test_util_resource_check.h"
+
+#include "u_timeout.h"
+
+/* ----------------------------------------------------------------
+ * COMPILE-TIME MACROS
+ * -------------------------------------------------------------- */
+
+/** The string to put at the start of all prints from this test.
+ */
+#define U_TEST_PREFIX "U_LINUX_UART_TEST: "
+
+/** Print a whole line, with terminator, prefixed for this test file.
+ */
+#define U_TEST_PRINT_LINE(format, ...) uPortLog(U_TEST_PREFIX format "\n", ##__VA_ARGS__)
+
+#ifndef U_LINUX_UART_TEST_NUM_UARTS
+/** The number of UARTs to have open at once.
+ */
+# define U_LINUX_UART_TEST_NUM_UARTS 32
+#endif
+
+#ifndef U_LINUX_UART_TEST_CALLBACK_EVERY
+/** Every this many UARTs gets an event callback which reads the data;
+ * the rest are read by polling from the test task.  Not all of them
+ * can have callbacks since each callback takes an event queue and
+ * there are at most #U_PORT_EVENT_QUEUE_MAX_NUM of those.
+ */
+# define U_LINUX_UART_TEST_CALLBACK_EVERY 2
+#endif
+
+#ifndef U_LINUX_UART_TEST_BUFFER_LENGTH_BYTES
+/** The receive buffer length for each UART: deliberately small
+ * so that the receive buffer fills up and has to be resumed.
+ */
+# define U_LINUX_UART_TEST_BUFFER_LENGTH_BYTES 64
+#endif
+
+#ifndef U_LINUX_UART_TEST_CHUNK_LENGTH_BYTES
+/** The number of bytes to write to each UART in one go.
+ */
+# define U_LINUX_UART_TEST_CHUNK_LENGTH_BYTES 256
+#endif
+
+#ifndef U_LINUX_UART_TEST_NUM_CHUNKS
+/** The number of chunks to write to each UART.
+ */
+# define U_LINUX_UART_TEST_NUM_CHUNKS 16
+#endif
+
+#ifndef U_LINUX_UART_TEST_TIMEOUT_MS
+/** How long to wait for all of the data to arrive.
+ */
+# define U_LINUX_UART_TEST_TIMEOUT_MS 10000
+#endif
+
+/* ----------------------------------------------------------------
+ * TYPES
+ * -------------------------------------------------------------- */
+
+/** Everything about one UART under test.
+ */
+typedef struct {
+    int32_t index;
+    int32_t masterFd;
+    int32_t uartHandle;
+    bool callback;
+    size_t bytesSent;
+    size_t bytesReceived;
+    int32_t numCallbacks;
+    int32_t errorCount;
+} uLinuxUartTestInstance_t;
+
+/* ----------------------------------------------------------------
+ * VARIABLES
+ * -------------------------------------------------------------- */
+
+/** The UARTs under test.
+ */
+static uLinuxUartTestInstance_t gInstance[U_LINUX_UART_TEST_NUM_UARTS];
+
+/** Set once the handles in gInstance[] have been initialised.
+ */
+static bool gInstanceValid = false;
+
+/* ----------------------------------------------------------------
+ * STATIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+// The byte expected at the given offset into the stream of a UART.
+static char expectedByte(int32_t index, size_t offset)
+{
+    return (char) ((offset + index) & 0xFF);
+}
+
+// Open a pseudo-terminal, returning the non-blocking master file
+// descriptor and putting the name of the slave end in pName.
+static int32_t ptyOpen(char *pName, size_t nameLength)
+{
+    struct termios options;
+    int32_t fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd >= 0) {
+        if ((grantpt(fd) == 0) && (unlockpt(fd) == 0) &&
+            (ptsname_r(fd, pName, nameLength) == 0) &&
+            (tcgetattr(fd, &options) == 0)) {
+            // No line discipline on the master side either
+            cfmakeraw(&options);
+            tcsetattr(fd, TCSANOW, &options);
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        } else {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    return fd;
+}
+
+// Write as much of the test data as the pseudo-terminal will take.
+static void send(uLinuxUartTestInstance_t *pInstance, size_t totalLength)
+{
+    char buffer[U_LINUX_UART_TEST_CHUNK_LENGTH_BYTES];
+    size_t length = totalLength - pInstance->bytesSent;
+    int32_t written;
+
+    if (length > sizeof(buffer)) {
+        length = sizeof(buffer);
+    }
+    for (size_t x = 0; x < length; x++) {
+        buffer[x] = expectedByte(pInstance->index, pInstance->bytesSent + x);
+    }
+    written = (int32_t) write(pInstance->masterFd, buffer, length);
+    if (written > 0) {
+        pInstance->bytesSent += written;
+    }
+}
+
+// Read everything there is from a UART, checking that it is what
+// was sent.
+static void drain(uLinuxUartTestInstance_t *pInstance)
+{
+    char buffer[U_LINUX_UART_TEST_BUFFER_LENGTH_BYTES / 2];
+    int32_t length;
+
+    // Deliberately read less than the buffer size at a time so
+    // that the wrap is exercised
+    while ((length = uPortUartRead(pInstance->uartHandle, buffer, sizeof(buffer))) > 0) {
+        for (int32_t x = 0; x < length; x++) {
+            if (buffer[x] != expectedByte(pInstance->index, pInstance->bytesReceived)) {
+                pInstance->errorCount++;
+            }
+            pInstance->bytesReceived++;
+        }
+    }
+    if (length < 0) {
+        pInstance->errorCount++;
+    }
+}
+
+// Callback for data received on a UART.
+static void dataCallback(int32_t uartHandle, uint32_t eventBitMap,
+                         void *pParameters)
+{
+    uLinuxUartTestInstance_t *pInstance = (uLinuxUartTestInstance_t *) pParameters;
+
+    pInstance->numCallbacks++;
+    if ((uartHandle != pInstance->uartHandle) ||
+        ((eventBitMap & U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED) == 0)) {
+        pInstance->errorCount++;
+    }
+    drain(pInstance);
+}
+
+// Close everything.
+static void closeAll()
+{
+    for (size_t x = 0; gInstanceValid && (x < sizeof(gInstance) / sizeof(gInstance[0])); x++) {
+        if (gInstance[x].uartHandle >= 0) {
+            uPortUartClose(gInstance[x].uartHandle);
+            gInstance[x].uartHandle = -1;
+        }
+        if (gInstance[x].masterFd >= 0) {
+            close(gInstance[x].masterFd);
+            gInstance[x].masterFd = -1;
+        }
+    }
+}
+
+/* ----------------------------------------------------------------
+ * PUBLIC FUNCTIONS
+ * -------------------------------------------------------------- */
+
+/** Open lots of UARTs, each with a small receive buffer, and pump
+ * data through all of them at once, some read from a callback and
+ * some by polling.
+ */
+U_PORT_TEST_FUNCTION("[linuxUart]", "linuxUartMany")
+{
+    int32_t resourceCount;
+    char name[64];
+    char chunk[U_LINUX_UART_TEST_CHUNK_LENGTH_BYTES];
+    size_t totalLength = U_LINUX_UART_TEST_CHUNK_LENGTH_BYTES * U_LINUX_UART_TEST_NUM_CHUNKS;
+    uTimeoutStart_t timeoutStart;
+    bool allReceived = false;
+    int32_t numCallbacks = 0;
+    int32_t length;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    memset(gInstance, 0, sizeof(gInstance));
+    for (size_t x = 0; x < sizeof(gInstance) / sizeof(gInstance[0]); x++) {
+        gInstance[x].masterFd = -1;
+        gInstance[x].uartHandle = -1;
+    }
+    gInstanceValid = true;
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+
+    U_TEST_PRINT_LINE("opening %d UARTs, each with a %d byte receive buffer...",
+                      U_LINUX_UART_TEST_NUM_UARTS, U_LINUX_UART_TEST_BUFFER_LENGTH_BYTES);
+    for (size_t x = 0; x < sizeof(gInstance) / sizeof(gInstance[0]); x++) {
+        uLinuxUartTestInstance_t *pInstance = &(gInstance[x]);
+        pInstance->index = (int32_t) x;
+        pInstance->masterFd = ptyOpen(name, sizeof(name));
+        U_PORT_TEST_ASSERT(pInstance->masterFd >= 0);
+        U_PORT_TEST_ASSERT(uPortUartPrefix(name) == 0);
+        pInstance->uartHandle = uPortUartOpen(-1, 115200, NULL,
+                                              U_LINUX_UART_TEST_BUFFER_LENGTH_BYTES,
+                                              -1, -1, -1, -1);
+        U_PORT_TEST_ASSERT(pInstance->uartHandle >= 0);
+        pInstance->callback = ((x % U_LINUX_UART_TEST_CALLBACK_EVERY) == 0);
+        if (pInstance->callback) {
+            U_PORT_TEST_ASSERT(uPortUartEventCallbackSet(pInstance->uartHandle,
+                                                         (uint32_t) U_PORT_UART_EVENT_BITMASK_DATA_RECEIVED,
+                                                         dataCallback, pInstance,
+                                                         U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                                         U_CFG_OS_APP_TASK_PRIORITY + 1) == 0);
+        }
+    }
+    // Put the default prefix back for anyone else
+    uPortUartPrefix(U_PORT_UART_PREFIX);
+
+    U_TEST_PRINT_LINE("sending %d bytes through each UART...", totalLength);
+    timeoutStart = uTimeoutStart();
+    while (!allReceived &&
+           !uTimeoutExpiredMs(timeoutStart, U_LINUX_UART_TEST_TIMEOUT_MS)) {
+        allReceived = true;
+        for (size_t x = 0; x < sizeof(gInstance) / sizeof(gInstance[0]); x++) {
+            send(&(gInstance[x]), totalLength);
+            if (!gInstance[x].callback) {
+                drain(&(gInstance[x]));
+            }
+            if (gInstance[x].bytesReceived < totalLength) {
+                allReceived = false;
+            }
+        }
+        uPortTaskBlock(1);
+    }
+    for (size_t x = 0; x < sizeof(gInstance) / sizeof(gInstance[0]); x++) {
+        if ((gInstance[x].bytesReceived != totalLength) || (gInstance[x].errorCount != 0)) {
+            U_TEST_PRINT_LINE("UART %d: %d byte(s) received, %d error(s).", x,
+                              gInstance[x].bytesReceived, gInstance[x].errorCount);
+        }
+        U_PORT_TEST_ASSERT(gInstance[x].bytesReceived == totalLength);
+        U_PORT_TEST_ASSERT(gInstance[x].errorCount == 0);
+        numCallbacks += gInstance[x].numCallbacks;
+    }
+    U_TEST_PRINT_LINE("all data received in %d callback(s).", numCallbacks);
+
+    U_TEST_PRINT_LINE("checking the transmit direction...");
+    for (size_t x = 0; x < sizeof(gInstance) / sizeof(gInstance[0]); x++) {
+        U_PORT_TEST_ASSERT(uPortUartGetReceiveSize(gInstance[x].uartHandle) == 0);
+        U_PORT_TEST_ASSERT(uPortUartWrite(gInstance[x].uartHandle, "hello", 5) == 5);
+        memset(chunk, 0, sizeof(chunk));
+        timeoutStart = uTimeoutStart();
+        do {
+            length = (int32_t) read(gInstance[x].masterFd, chunk, sizeof(chunk));
+            uPortTaskBlock(1);
+        } while ((length < 0) && !uTimeoutExpiredMs(timeoutStart, 1000));
+        U_PORT_TEST_ASSERT(length == 5);
+        U_PORT_TEST_ASSERT(memcmp(chunk, "hello", 5) == 0);
+    }
+
+    closeAll();
+    uPortDeinit();
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Clean-up to be run at the end of this round of tests, just
+ * in case there were test failures which would have resulted
+ * in the deinitialisation being skipped.
+ */
+U_PORT_TEST_FUNCTION("[linuxUart]", "linuxUartCleanUp")
+{
+    closeAll();
+    uPortDeinit();
+    // Printed for information: asserting happens in the postamble
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+}
+
+// End of file
@@ -236,6 +236,27 @@
  */
 #define U_PORT_TEST_OS_EVENT_QUEUE_PARAM_MIN_SIZE_BYTES 4
 
+#ifndef U_PORT_TEST_EVENT_QUEUE_BENCHMARK_MESSAGES
+/** The number of messages to send through an event queue when
+ * measuring its throughput.
+ */
+# define U_PORT_TEST_EVENT_QUEUE_BENCHMARK_MESSAGES 10000
+#endif
+
+#ifndef U_PORT_TEST_EVENT_QUEUE_BENCHMARK_ROUND_TRIPS
+/** The number of round trips through an event queue to make when
+ * measuring its latency.
+ */
+# define U_PORT_TEST_EVENT_QUEUE_BENCHMARK_ROUND_TRIPS 1000
+#endif
+
+#ifndef U_PORT_TEST_EVENT_QUEUE_BENCHMARK_TIMEOUT_MS
+/** How long to wait for the event queue benchmark messages to
+ * be received.
+ */
+# define U_PORT_TEST_EVENT_QUEUE_BENCHMARK_TIMEOUT_MS 60000
+#endif
+
 #ifndef U_PORT_MALLOC_LENGTH_BYTES
 /** How much to allocate in the heap test; deliberately an odd size.
  */
@@ -329,6 +350,13 @@ typedef struct {
     int64_t time;
 } uPortTestTimeData_t;
 
+/** A message sent through an event queue by the event queue benchmark.
+ */
+typedef struct {
+    int32_t sequence;
+    bool reply; /**< Give gEventQueueBenchmarkSemaphore when received. */
+} uPortTestEventQueueBenchmark_t;
+
 /* ----------------------------------------------------------------
  * VARIABLES
  * -------------------------------------------------------------- */
@@ -381,6 +409,23 @@ static int32_t gEventQueueMinErrorFlag;
 // Counter for event queue callback min length
 static int32_t gEventQueueMinCounter;
 
+// Semaphore given by the event queue benchmark callback.
+static uPortSemaphoreHandle_t gEventQueueBenchmarkSemaphore = NULL;
+
+// Number of messages received by the event queue benchmark callback.
+static int32_t gEventQueueBenchmarkCounter;
+
+// Error flag for the event queue benchmark callback.
+static int32_t gEventQueueBenchmarkErrorFlag;
+
+// Semaphore that the first call of the event queue coalesce
+// callback waits on.
+static uPortSemaphoreHandle_t gEventQueueCoalesceGate = NULL;
+
+// Number of times the event queue coalesce callback has been
+// called for each value.
+static int32_t gEventQueueCoalesceCount[4];
+
 #if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
 
 // The data to send during UART testing.
@@ -872,6 +917,39 @@ static void eventQueueMinFunction(void *pParam,
     gEventQueueMinCounter++;
 }
 
+// Event queue function for the event queue coalesce test: the
+// first call blocks until the gate is given, so that events pile up.
+static void eventQueueCoalesceFunction(void *pParam,
+                                       size_t paramLength)
+{
+    int32_t value = *((int32_t *) pParam);
+
+    if ((paramLength == sizeof(value)) && (value >= 0) &&
+        (value < (int32_t) (sizeof(gEventQueueCoalesceCount) / sizeof(gEventQueueCoalesceCount[0])))) {
+        if (value == 0) {
+            uPortSemaphoreTake(gEventQueueCoalesceGate);
+        }
+        gEventQueueCoalesceCount[value]++;
+    }
+}
+
+// Event queue function for the event queue benchmark.
+static void eventQueueBenchmarkFunction(void *pParam,
+                                        size_t paramLength)
+{
+    uPortTestEventQueueBenchmark_t *pMessage = (uPortTestEventQueueBenchmark_t *) pParam;
+
+    if (paramLength != sizeof(*pMessage)) {
+        gEventQueueBenchmarkErrorFlag = 1;
+    } else if (pMessage->sequence != gEventQueueBenchmarkCounter) {
+        gEventQueueBenchmarkErrorFlag = 2;
+    }
+    gEventQueueBenchmarkCounter++;
+    if ((paramLength == sizeof(*pMessage)) && pMessage->reply) {
+        uPortSemaphoreGive(gEventQueueBenchmarkSemaphore);
+    }
+}
+
 #if (U_CFG_TEST_UART_A >= 0) && (U_CFG_TEST_UART_B < 0)
 
 // Callback that is called when data arrives at the UART
@@ -2132,6 +2210,198 @@ U_PORT_TEST_FUNCTION("[port]", "portEventQueue")
     U_PORT_TEST_ASSERT(resourceCount <= 0);
 }
 
+/** Measure the throughput and latency of an event queue.  Nothing
+ * is asserted about the numbers, which are printed for information.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portEventQueueBenchmark")
+{
+    uPortTestEventQueueBenchmark_t message = {0};
+    int32_t handle;
+    int32_t startTimeMs;
+    int32_t durationMs;
+    int32_t resourceCount;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    gEventQueueBenchmarkCounter = 0;
+    gEventQueueBenchmarkErrorFlag = 0;
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uPortSemaphoreCreate(&gEventQueueBenchmarkSemaphore, 0, 1) == 0);
+    handle = uPortEventQueueOpen(eventQueueBenchmarkFunction, "benchmark",
+                                 sizeof(message),
+                                 U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                 U_CFG_TEST_OS_TASK_PRIORITY,
+                                 U_PORT_TEST_QUEUE_LENGTH);
+    U_PORT_TEST_ASSERT(handle >= 0);
+
+    U_TEST_PRINT_LINE("sending %d message(s) through an event queue...",
+                      U_PORT_TEST_EVENT_QUEUE_BENCHMARK_MESSAGES);
+    startTimeMs = uPortGetTickTimeMs();
+    for (int32_t x = 0; x < U_PORT_TEST_EVENT_QUEUE_BENCHMARK_MESSAGES; x++) {
+        message.sequence = x;
+        message.reply = (x == U_PORT_TEST_EVENT_QUEUE_BENCHMARK_MESSAGES - 1);
+        U_PORT_TEST_ASSERT(uPortEventQueueSend(handle, &message, sizeof(message)) == 0);
+    }
+    U_PORT_TEST_ASSERT(uPortSemaphoreTryTake(gEventQueueBenchmarkSemaphore,
+                                             U_PORT_TEST_EVENT_QUEUE_BENCHMARK_TIMEOUT_MS) == 0);
+    durationMs = uPortGetTickTimeMs() - startTimeMs;
+    if (durationMs <= 0) {
+        durationMs = 1;
+    }
+    U_TEST_PRINT_LINE("%d message(s) in %d ms, %d message(s)/second.",
+                      U_PORT_TEST_EVENT_QUEUE_BENCHMARK_MESSAGES, durationMs,
+                      (int32_t) ((((int64_t) U_PORT_TEST_EVENT_QUEUE_BENCHMARK_MESSAGES) * 1000) / durationMs));
+    U_PORT_TEST_ASSERT(gEventQueueBenchmarkErrorFlag == 0);
+    U_PORT_TEST_ASSERT(gEventQueueBenchmarkCounter == U_PORT_TEST_EVENT_QUEUE_BENCHMARK_MESSAGES);
+
+    U_TEST_PRINT_LINE("making %d round trip(s) through the event queue...",
+                      U_PORT_TEST_EVENT_QUEUE_BENCHMARK_ROUND_TRIPS);
+    message.reply = true;
+    startTimeMs = uPortGetTickTimeMs();
+    for (int32_t x = 0; x < U_PORT_TEST_EVENT_QUEUE_BENCHMARK_ROUND_TRIPS; x++) {
+        message.sequence = gEventQueueBenchmarkCounter;
+        U_PORT_TEST_ASSERT(uPortEventQueueSend(handle, &message, sizeof(message)) == 0);
+        U_PORT_TEST_ASSERT(uPortSemaphoreTryTake(gEventQueueBenchmarkSemaphore,
+                                                 U_PORT_TEST_EVENT_QUEUE_BENCHMARK_TIMEOUT_MS) == 0);
+    }
+    durationMs = uPortGetTickTimeMs() - startTimeMs;
+    U_TEST_PRINT_LINE("%d round trip(s) in %d ms, average latency %d microsecond(s).",
+                      U_PORT_TEST_EVENT_QUEUE_BENCHMARK_ROUND_TRIPS, durationMs,
+                      (int32_t) ((((int64_t) durationMs) * 1000) /
+                                 U_PORT_TEST_EVENT_QUEUE_BENCHMARK_ROUND_TRIPS));
+    U_PORT_TEST_ASSERT(gEventQueueBenchmarkErrorFlag == 0);
+    U_PORT_TEST_ASSERT(gEventQueueBenchmarkCounter == U_PORT_TEST_EVENT_QUEUE_BENCHMARK_MESSAGES +
+                       U_PORT_TEST_EVENT_QUEUE_BENCHMARK_ROUND_TRIPS);
+
+    U_PORT_TEST_ASSERT(uPortEventQueueClose(handle) == 0);
+    U_PORT_TEST_ASSERT(uPortSemaphoreDelete(gEventQueueBenchmarkSemaphore) == 0);
+    gEventQueueBenchmarkSemaphore = NULL;
+
+    uPortDeinit();
+
+    // Give the RTOS idle task time to tidy-away the tasks
+    uPortTaskBlock(1000);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
+/** Test coalescing of events and dispatching more than one event
+ * per wake-up.
+ */
+U_PORT_TEST_FUNCTION("[port]", "portEventQueueCoalesce")
+{
+    uPortEventQueueStats_t stats;
+    int32_t handle;
+    int32_t value;
+    int32_t numFree;
+    int32_t resourceCount;
+    int32_t startTimeMs;
+
+    // Whatever called us likely initialised the
+    // port so deinitialise it here to obtain the
+    // correct initial heap size
+    uPortDeinit();
+    resourceCount = uTestUtilGetDynamicResourceCount();
+
+    memset(gEventQueueCoalesceCount, 0, sizeof(gEventQueueCoalesceCount));
+
+    U_PORT_TEST_ASSERT(uPortInit() == 0);
+    U_PORT_TEST_ASSERT(uPortSemaphoreCreate(&gEventQueueCoalesceGate, 0, 1) == 0);
+    handle = uPortEventQueueOpen(eventQueueCoalesceFunction, "coalesce",
+                                 sizeof(value),
+                                 U_PORT_EVENT_QUEUE_MIN_TASK_STACK_SIZE_BYTES,
+                                 U_CFG_TEST_OS_TASK_PRIORITY,
+                                 U_PORT_TEST_QUEUE_LENGTH);
+    U_PORT_TEST_ASSERT(handle >= 0);
+    U_PORT_TEST_ASSERT(uPortEventQueueDrainSet(handle, 0) < 0);
+    U_PORT_TEST_ASSERT(uPortEventQueueDrainSet(handle, U_PORT_TEST_QUEUE_LENGTH) == 0);
+
+    // Value 0 gets the event task stuck in the callback
+    value = 0;
+    U_PORT_TEST_ASSERT(uPortEventQueueSend(handle, &value, sizeof(value)) == 0);
+    numFree = uPortEventQueueGetFree(handle);
+    startTimeMs = uPortGetTickTimeMs();
+    while ((numFree >= 0) && (numFree < U_PORT_TEST_QUEUE_LENGTH) &&
+           (uPortGetTickTimeMs() - startTimeMs < 1000)) {
+        uPortTaskBlock(10);
+        numFree = uPortEventQueueGetFree(handle);
+    }
+    uPortTaskBlock(100);
+
+    U_TEST_PRINT_LINE("sending events to a stuck event queue...");
+    for (size_t x = 0; x < 5; x++) {
+        value = 1;
+        U_PORT_TEST_ASSERT(uPortEventQueueSendCoalesced(handle, &value, sizeof(value)) == 0);
+        value = 2;
+        U_PORT_TEST_ASSERT(uPortEventQueueSendCoalesced(handle, &value, sizeof(value)) == 0);
+    }
+    value = 3;
+    for (size_t x = 0; x < 3; x++) {
+        U_PORT_TEST_ASSERT(uPortEventQueueSend(handle, &value, sizeof(value)) == 0);
+    }
+    U_PORT_TEST_ASSERT(uPortEventQueueStatsGet(handle, &stats) == 0);
+    U_PORT_TEST_ASSERT(stats.numCoalesced == 8);
+
+    U_TEST_PRINT_LINE("releasing the event queue...");
+    uPortSemaphoreGive(gEventQueueCoalesceGate);
+    startTimeMs = uPortGetTickTimeMs();
+    while ((gEventQueueCoalesceCount[3] < 3) &&
+           (uPortGetTickTimeMs() - startTimeMs < 1000)) {
+        uPortTaskBlock(10);
+    }
+    U_PORT_TEST_ASSERT(gEventQueueCoalesceCount[0] == 1);
+    U_PORT_TEST_ASSERT(gEventQueueCoalesceCount[1] == 1);
+    U_PORT_TEST_ASSERT(gEventQueueCoalesceCount[2] == 1);
+    U_PORT_TEST_ASSERT(gEventQueueCoalesceCount[3] == 3);
+
+    // Once dispatched, a coalesced event can be sent again
+    value = 1;
+    U_PORT_TEST_ASSERT(uPortEventQueueSendCoalesced(handle, &value, sizeof(value)) == 0);
+    startTimeMs = uPortGetTickTimeMs();
+    while ((gEventQueueCoalesceCount[1] < 2) &&
+           (uPortGetTickTimeMs() - startTimeMs < 1000)) {
+        uPortTaskBlock(10);
+    }
+    U_PORT_TEST_ASSERT(gEventQueueCoalesceCount[1] == 2);
+    uPortTaskBlock(10);
+
+    U_PORT_TEST_ASSERT(uPortEventQueueStatsGet(handle, &stats) == 0);
+    U_TEST_PRINT_LINE("%d event(s) in %d wake-up(s), %d coalesced, high-water mark %d.",
+                      stats.numEvents, stats.numWakeups, stats.numCoalesced,
+                      stats.highWaterMark);
+    U_PORT_TEST_ASSERT(stats.numEvents == 7);
+    U_PORT_TEST_ASSERT(stats.numCoalesced == 8);
+    // The five events waiting while the task was stuck
+    // should have been dispatched in a single wake-up
+    U_PORT_TEST_ASSERT(stats.numWakeups == 3);
+    U_PORT_TEST_ASSERT((stats.highWaterMark == 5) ||
+                       ((stats.highWaterMark == 0) && (numFree < 0)));
+
+    U_PORT_TEST_ASSERT(uPortEventQueueClose(handle) == 0);
+    U_PORT_TEST_ASSERT(uPortSemaphoreDelete(gEventQueueCoalesceGate) == 0);
+    gEventQueueCoalesceGate = NULL;
+
+    uPortDeinit();
+
+    // Give the RTOS idle task time to tidy-away the tasks
+    uPortTaskBlock(1000);
+
+    // Check for resource leaks
+    uTestUtilResourceCheck(U_TEST_PREFIX, NULL, true);
+    resourceCount = uTestUtilGetDynamicResourceCount() - resourceCount;
+    U_TEST_PRINT_LINE("we have leaked %d resources(s).", resourceCount);
+    U_PORT_TEST_ASSERT(resourceCount <= 0);
+}
+
 /** Test heap API.
  *
  * NOTE: for this to work fully U_ASSERT_HOOK_FUNCTION_TEST_RETURN must be defined.
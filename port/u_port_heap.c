@@ -46,6 +46,10 @@
 #include "u_port_heap.h"
 #include "u_port_debug.h"
 
+#ifdef U_CFG_HEAP_POOL
+# include "u_mempool.h"
+#endif
+
 /* ----------------------------------------------------------------
  * COMPILE-TIME MACROS
  * -------------------------------------------------------------- */
@@ -128,6 +132,11 @@ typedef struct uPortHeapBlock_t {
  */
 static int32_t gHeapAllocCount = 0;
 
+/** Variable to keep track of the total number of successful heap
+ * allocations ever made.
+ */
+static int32_t gHeapAllocCallCount = 0;
+
 /** Variable to keep track of the total number of perpetual heap
  * allocations.
  */
@@ -196,9 +205,18 @@ static void *_pUPortMalloc(size_t sizeBytes)
 U_WEAK void *pUPortMalloc(size_t sizeBytes)
 #endif
 {
-    void *pMalloc = malloc(sizeBytes);
+    void *pMalloc = NULL;
+#ifdef U_CFG_HEAP_POOL
+    // Small allocations come from the size-class pool if they can
+    pMalloc = uMemPoolClassAllocMem(sizeBytes);
+    if (pMalloc == NULL)
+#endif
+    {
+        pMalloc = malloc(sizeBytes);
+    }
     if (pMalloc != NULL) {
         gHeapAllocCount++;
+        gHeapAllocCallCount++;
     }
     return pMalloc;
 }
@@ -319,7 +337,12 @@ U_WEAK void uPortFree(void *pMemory)
     if (pMemory != NULL) {
         gHeapAllocCount--;
     }
-    free(pMemory);
+#ifdef U_CFG_HEAP_POOL
+    if (!uMemPoolClassFreeMem(pMemory))
+#endif
+    {
+        free(pMemory);
+    }
 }
 
 U_WEAK int32_t uPortHeapAllocCount()
@@ -327,6 +350,11 @@ U_WEAK int32_t uPortHeapAllocCount()
     return gHeapAllocCount;
 }
 
+U_WEAK int32_t uPortHeapAllocCallCount()
+{
+    return gHeapAllocCallCount;
+}
+
 U_WEAK void uPortHeapPerpetualAllocAdd()
 {
     gHeapPerpetualAllocCount++;
@@ -149,6 +149,12 @@
 #include <u_gnss_dec.h>
 #include <u_gnss_dec_ubx_nav_pvt.h>
 #include <u_gnss_dec_ubx_nav_hpposllh.h>
+#include <u_gnss_dec_ubx_nav_sat.h>
+#include <u_gnss_dec_ubx_nav_sig.h>
+#include <u_gnss_dec_ubx_nav_cov.h>
+#include <u_gnss_dec_ubx_rxm_rawx.h>
+#include <u_gnss_dec_ubx_esf_meas.h>
+#include <u_gnss_dec_ubx_tim_tp.h>
 #include <u_gnss_mga.h>
 #include <u_gnss_geofence.h>
 #include <u_gnss_util.h>
@@ -294,4 +294,43 @@ uGeofencePositionState_t uWifiGeofencePosition(uDeviceHandle_t wifiHandle,
     return positionState;
 }
 
+// Get the number of geofence tests performed and avoided.
+int32_t uWifiGeofenceGetCounts(uDeviceHandle_t wifiHandle,
+                               uint32_t *pNumTested,
+                               uint32_t *pNumSkipped,
+                               bool reset)
+{
+    int32_t errorCode;
+
+#ifdef U_CFG_GEOFENCE
+    uShortRangePrivateInstance_t *pInstance;
+
+    errorCode = (int32_t) U_ERROR_COMMON_NOT_INITIALISED;
+    if (gUShortRangePrivateMutex != NULL) {
+
+        U_PORT_MUTEX_LOCK(gUShortRangePrivateMutex);
+
+        errorCode = (int32_t) U_ERROR_COMMON_INVALID_PARAMETER;
+        if (wifiHandle != NULL) {
+            pInstance = pUShortRangePrivateGetInstance(wifiHandle);
+            if (pInstance != NULL) {
+                errorCode = (int32_t) U_ERROR_COMMON_SUCCESS;
+                uGeofenceContextGetCounts((uGeofenceContext_t *) pInstance->pFenceContext,
+                                          pNumTested, pNumSkipped, reset);
+            }
+        }
+
+        U_PORT_MUTEX_UNLOCK(gUShortRangePrivateMutex);
+    }
+#else
+    errorCode = (int32_t) U_ERROR_COMMON_NOT_COMPILED;
+    (void) wifiHandle;
+    (void) pNumTested;
+    (void) pNumSkipped;
+    (void) reset;
+#endif
+
+    return errorCode;
+}
+
 // End of file